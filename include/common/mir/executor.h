@@ -17,6 +17,8 @@
 #ifndef MIR_EXECUTOR_H_
 #define MIR_EXECUTOR_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
 namespace mir
@@ -75,14 +77,41 @@ public:
 
     /**
      * Wait for all current work to finish and terminate all worker threads
+     *
+     * This applies to both the thread_pool_executor and the dedicated_thread_executor.
      */
     static void quiesce();
+
+    struct Metrics
+    {
+        size_t queue_depth;     ///< Work items waiting for a worker
+        uint64_t steals;        ///< Work items taken from another worker's queue, since startup
+        unsigned workers;       ///< The number of threads in the pool
+    };
+
+    /// A snapshot of the state of the thread_pool_executor
+    static auto metrics() -> Metrics;
 protected:
     ThreadPoolExecutor() = default;
 };
 
+/**
+ * An Executor running work on a fixed pool of threads, one per CPU
+ *
+ * Work should not block for long (for example, waiting for other work to complete), as that
+ * takes a thread out of the pool. Use the dedicated_thread_executor for such work.
+ */
 extern NonBlockingExecutor& thread_pool_executor;
 
+/**
+ * An Executor that runs each item of work on its own thread
+ *
+ * This is for work that blocks, or runs indefinitely (such as a compositor's render loop).
+ * Threads are reused once idle, but are otherwise created as needed, so this should not be
+ * used for work that the thread_pool_executor could do.
+ */
+extern NonBlockingExecutor& dedicated_thread_executor;
+
 /**
  * An Executor that makes the following concurrency guarantees:
  *
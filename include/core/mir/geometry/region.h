@@ -0,0 +1,90 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GEOMETRY_REGION_H_
+#define MIR_GEOMETRY_REGION_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
+
+#include <vector>
+#include <iosfwd>
+
+namespace mir
+{
+namespace geometry
+{
+
+/**
+ * An arbitrary set of points, with set operations.
+ *
+ * The region is held as "y-x banded" rectangles: horizontal bands that don't
+ * overlap, each split into disjoint, non-touching spans sorted left to right.
+ * Vertically adjacent bands with identical spans are merged. This makes the
+ * representation canonical, so two regions covering the same points compare
+ * equal whatever way they were built.
+ */
+class Region
+{
+public:
+    Region();
+    Region(Rectangle const& rect);
+    explicit Region(Rectangles const& rects);
+    /* We want to keep implicit copy and move methods */
+
+    bool empty() const;
+    bool contains(Point const& point) const;
+    /// True if every point of \a rect is in the region (an empty \a rect is always contained)
+    bool contains(Rectangle const& rect) const;
+    bool overlaps(Rectangle const& rect) const;
+    Rectangle bounding_rectangle() const;
+    /// The region as disjoint rectangles, in y-x banded order
+    Rectangles rectangles() const;
+
+    void unite(Region const& other);
+    void subtract(Region const& other);
+    void intersect(Region const& other);
+
+    bool operator==(Region const& other) const;
+    bool operator!=(Region const& other) const;
+
+private:
+    struct Span
+    {
+        int left;
+        int right;
+        bool operator==(Span const&) const = default;
+    };
+
+    struct Band
+    {
+        int top;
+        int bottom;
+        std::vector<Span> spans;
+        bool operator==(Band const&) const = default;
+    };
+
+    enum class Op { unite, subtract, intersect };
+    static auto combine(std::vector<Band> const& a, std::vector<Band> const& b, Op op) -> std::vector<Band>;
+
+    std::vector<Band> bands;
+};
+
+std::ostream& operator<<(std::ostream& out, Region const& value);
+}
+}
+
+#endif /* MIR_GEOMETRY_REGION_H_ */
@@ -17,8 +17,12 @@
 #ifndef MIR_GRAPHICS_DISPLAY_REPORT_H_
 #define MIR_GRAPHICS_DISPLAY_REPORT_H_
 
+#include "mir/geometry/size.h"
+
 #include <EGL/egl.h>
 
+#include <cstddef>
+
 namespace mir
 {
 namespace graphics
@@ -42,6 +46,18 @@ public:
     virtual void report_vt_switch_away_failure() = 0;
     virtual void report_vt_switch_back_failure() = 0;
 
+    /**
+     * A client's dma-buf was made available to the renderer
+     *
+     * \param [in] size    The size of the buffer
+     * \param [in] planes  How many dma-bufs make up the buffer
+     * \param [in] reused  True if an earlier EGL import of the same memory was reused,
+     *                     false if the buffer was newly imported
+     */
+    virtual void report_dmabuf_import(geometry::Size /*size*/, size_t /*planes*/, bool /*reused*/)
+    {
+    }
+
 protected:
     DisplayReport() = default;
     virtual ~DisplayReport() = default;
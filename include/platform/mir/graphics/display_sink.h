@@ -18,6 +18,7 @@
 #define MIR_GRAPHICS_DISPLAY_SINK_H_
 
 #include "mir/graphics/platform.h"
+#include "mir/graphics/frame.h"
 #include <mir/geometry/rectangle.h>
 #include <mir/graphics/renderable.h>
 #include <mir_toolkit/common.h>
@@ -47,6 +48,10 @@ struct DisplayElement
      */
     geometry::RectangleF source_position;
     std::shared_ptr<Framebuffer> buffer;
+    /// As Renderable::alpha(); scanning out an element with alpha != 1 would show it opaque
+    float alpha{1.0f};
+    /// As Renderable::transformation(); scanning out ignores it, so it must be the identity
+    glm::mat4 transformation{1.0f};
 };
 /**
  * Interface to an output sink.
@@ -96,6 +101,19 @@ public:
      */
     virtual glm::mat2 transformation() const = 0;
 
+    /**
+     * The most recent frame this DisplaySink is known to have presented.
+     *
+     * This is updated by DisplaySyncGroup::post(), so is only meaningful on
+     * the thread calling that. Platforms that can't timestamp presentation
+     * leave the default (msc == 0), and callers should treat the frame as
+     * having been presented when post() returned.
+     */
+    virtual auto last_frame() const -> Frame
+    {
+        return {};
+    }
+
     /**
      * Attempt to acquire a platform-specific provider from this DisplaySink
      *
@@ -0,0 +1,85 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GL_CONTEXT_LIFETIME_H_
+#define MIR_GRAPHICS_GL_CONTEXT_LIFETIME_H_
+
+#include <GLES2/gl2.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gl
+{
+/**
+ * Stands for a GL context for as long as the context exists
+ *
+ * An EGLContext handle may be reused once its context is destroyed, so anything keeping
+ * objects per context should key them on this instead.
+ *
+ * Whoever owns the context holds this, and keeps a Current in scope while drawing with it.
+ * Objects made in the context by others can be handed back with delete_texture_later(),
+ * and the owner deletes them, in the context, with delete_pending().
+ */
+class ContextLifetime
+{
+public:
+    ContextLifetime() = default;
+
+    ContextLifetime(ContextLifetime const&) = delete;
+    ContextLifetime& operator=(ContextLifetime const&) = delete;
+
+    /// Marks lifetime's context as the one in use on this thread while in scope
+    class Current
+    {
+    public:
+        explicit Current(std::shared_ptr<ContextLifetime> const& lifetime);
+        ~Current();
+
+        Current(Current const&) = delete;
+        Current& operator=(Current const&) = delete;
+
+    private:
+        std::shared_ptr<ContextLifetime> const previous;
+    };
+
+    /// The context marked as in use on this thread, or nullptr if none is
+    static auto current() -> std::shared_ptr<ContextLifetime>;
+
+    /// Queues tex, made in this context, for the owner to delete. Can be called from any thread.
+    void delete_texture_later(GLuint tex);
+
+    /**
+     * Deletes the textures queued by delete_texture_later()
+     *
+     * \note    Must be called with this context current
+     */
+    void delete_pending();
+
+private:
+    std::mutex mutex;
+    std::vector<GLuint> pending_textures;
+};
+}
+}
+}
+
+#endif // MIR_GRAPHICS_GL_CONTEXT_LIFETIME_H_
@@ -18,6 +18,8 @@
 #define MIR_GRAPHICS_GRAPHIC_BUFFER_ALLOCATOR_H_
 
 #include "mir/graphics/buffer.h"
+#include "mir/geometry/rectangles.h"
+#include "mir/renderer/sw/pixel_source.h"
 
 #include <vector>
 #include <memory>
@@ -30,11 +32,6 @@ namespace mir
 {
 class Executor;
 
-namespace renderer::software
-{
-class RWMappableBuffer;
-}
-
 namespace graphics
 {
 
@@ -86,8 +83,30 @@ public:
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) = 0;
 
+    /**
+     * Create a Buffer from a client's SHM data, uploading all of it
+     */
+    virtual auto buffer_from_shm(
+        std::shared_ptr<renderer::software::RWMappableBuffer> shm_data,
+        std::function<void()>&& on_consumed,
+        std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
+    {
+        geometry::Rectangles const everything{{{}, shm_data->size()}};
+        return buffer_from_shm(std::move(shm_data), nullptr, everything, std::move(on_consumed), std::move(on_release));
+    }
+
+    /**
+     * Create a Buffer from a client's SHM data
+     *
+     * \param shm_data [in]    The client's pixels
+     * \param previous [in]    The Buffer this replaces on the client's surface, or nullptr. The
+     *                         allocator may carry resources (such as a texture) over from it.
+     * \param damage [in]      The parts of shm_data that differ from previous, in buffer coordinates
+     */
     virtual auto buffer_from_shm(
         std::shared_ptr<renderer::software::RWMappableBuffer> shm_data,
+        std::shared_ptr<Buffer> const& previous,
+        geometry::Rectangles const& damage,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release) -> std::shared_ptr<Buffer> = 0;
 
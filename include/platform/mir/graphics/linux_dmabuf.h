@@ -43,6 +43,7 @@ namespace graphics
 namespace gl
 {
 class Texture;
+class OutputSurface;
 }
 
 namespace common
@@ -52,7 +53,10 @@ class EGLContextExecutor;
 
 class DmaBufFormatDescriptors;
 class DMABufBuffer;
+class DMABufTargetAllocator;
 class EGLBufferCopier;
+class DMABufImportCache;
+class DisplayReport;
 
 class DMABufEGLProvider : public std::enable_shared_from_this<DMABufEGLProvider>
 {
@@ -64,7 +68,8 @@ public:
         std::shared_ptr<EGLExtensions> egl_extensions,
         EGLExtensions::EXTImageDmaBufImportModifiers const& dmabuf_ext,
         std::shared_ptr<common::EGLContextExecutor> egl_delegate,
-        EGLImageAllocator allocate_importable_image);
+        EGLImageAllocator allocate_importable_image,
+        std::shared_ptr<DisplayReport> report);
 
     ~DMABufEGLProvider();
 
@@ -87,6 +92,27 @@ public:
         -> std::shared_ptr<gl::Texture>;
 
      auto supported_formats() const -> DmaBufFormatDescriptors const&;
+
+    /**
+     * An OutputSurface that renders straight into the dma-bufs \a allocator supplies
+     *
+     * Targets are imported through the same cache as client buffers, so rendering into a
+     * buffer again doesn't import it again.
+     *
+     * \param share_ctx    The context the surface's context shares textures with
+     */
+    auto surface_for(DMABufTargetAllocator& allocator, EGLContext share_ctx)
+        -> std::unique_ptr<gl::OutputSurface>;
+
+    struct ImportMetrics
+    {
+        uint64_t imports;   ///< Client dma-bufs imported into EGL
+        uint64_t reuses;    ///< Commits that reused an existing import of the same dma-bufs
+        size_t live;        ///< Imports currently held, by wl_buffers or frames using them
+    };
+
+    /// Counts of dma-buf imports, to show how well imports are reused across commits
+    auto import_metrics() const -> ImportMetrics;
 private:
     EGLDisplay const dpy;
     std::shared_ptr<EGLExtensions> const egl_extensions;
@@ -95,6 +121,7 @@ private:
     std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
     EGLImageAllocator allocate_importable_image;
     std::unique_ptr<EGLBufferCopier> const blitter;
+    std::unique_ptr<DMABufImportCache> const import_cache;
 };
 
 class LinuxDmaBufUnstable : public mir::wayland::LinuxDmabufV1::Global
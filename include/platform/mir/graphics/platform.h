@@ -318,6 +318,16 @@ public:
         -> std::unique_ptr<MappableFB> = 0;
 
     virtual auto output_size() const -> geometry::Size = 0;
+
+    /**
+     * Whether each framebuffer from alloc_fb() already holds the frame before it
+     *
+     * If so, only the damaged part of each frame needs to be written to it.
+     */
+    virtual auto holds_previous_frame() const -> bool
+    {
+        return false;
+    }
 };
 
 class GBMDisplayProvider : public DisplayProvider
@@ -401,6 +411,28 @@ public:
         -> std::unique_ptr<Framebuffer> = 0;
 };
 
+class DMABufBuffer;
+
+/**
+ * Renders into dma-bufs that someone else allocated, such as the buffers of a screencopy client
+ */
+class DMABufTargetAllocator : public DisplayAllocator
+{
+public:
+    class Tag : public DisplayAllocator::Tag
+    {
+    };
+
+    /**
+     * The buffer to render the next frame into
+     *
+     * Called once per frame, when rendering starts.
+     */
+    virtual auto claim_target() -> std::shared_ptr<DMABufBuffer> = 0;
+
+    virtual auto output_size() const -> geometry::Size = 0;
+};
+
 #ifndef EGLStreamKHR
 typedef void* EGLStreamKHR;
 #endif
@@ -556,7 +588,8 @@ typedef mir::UniqueModulePtr<mir::graphics::RenderingPlatform>(*CreateRenderPlat
     mir::graphics::SupportedDevice const& device,
     std::vector<std::shared_ptr<mir::graphics::DisplayPlatform>> const& platforms,
     mir::options::Option const& options,
-    mir::EmergencyCleanupRegistry& emergency_cleanup_registry);
+    mir::EmergencyCleanupRegistry& emergency_cleanup_registry,
+    std::shared_ptr<mir::graphics::DisplayReport> const& report);
 
 typedef void(*AddPlatformOptions)(
     boost::program_options::options_description& config);
@@ -610,7 +643,8 @@ mir::UniqueModulePtr<mir::graphics::RenderingPlatform> create_rendering_platform
     mir::graphics::SupportedDevice const& device,
     std::vector<std::shared_ptr<mir::graphics::DisplayPlatform>> const& targets,
     mir::options::Option const& options,
-    mir::EmergencyCleanupRegistry& emergency_cleanup_registry);
+    mir::EmergencyCleanupRegistry& emergency_cleanup_registry,
+    std::shared_ptr<mir::graphics::DisplayReport> const& report);
 
 /**
  * Function prototype used to add platform specific options to the platform-independent server options.
@@ -19,6 +19,7 @@
 
 #include <optional>
 #include <mir/geometry/rectangle.h>
+#include <mir/geometry/rectangles.h>
 #include <glm/glm.hpp>
 #include <memory>
 #include <vector>
@@ -69,6 +70,35 @@ public:
     virtual glm::mat4 transformation() const = 0;
 
     virtual bool shaped() const = 0;  // meaning the pixel format has alpha
+
+    /**
+     * The region of screen_position() whose content differs between buffer()
+     * and the buffer this renderable presented to the same compositor last
+     * time.
+     *
+     * Only meaningful when buffer() has changed. Implementations without
+     * finer-grained knowledge return the whole of screen_position().
+     */
+    virtual geometry::Rectangles damage() const = 0;
+
+    /**
+     * The region of screen_position() where buffer() is known to be fully
+     * opaque, before alpha() is applied.
+     *
+     * Renderables that aren't shaped() are opaque everywhere.
+     */
+    virtual geometry::Rectangles opaque_region() const = 0;
+
+    /**
+     * The parts of screen_position() not hidden by what is drawn over this
+     * renderable, or nullopt if that isn't known.
+     *
+     * Nothing outside it needs to be drawn.
+     */
+    virtual std::optional<geometry::Rectangles> visible_region() const
+    {
+        return std::nullopt;
+    }
 protected:
     Renderable() = default;
     Renderable(Renderable const&) = delete;
@@ -39,6 +39,19 @@ public:
     virtual void opened_input_device(char const* device_name, char const* input_platform) = 0;
     virtual void failed_to_open_input_device(char const* device_name, char const* input_platform) = 0;
 
+    /**
+     * \name Stages of an input event's way to a client
+     *
+     * Each is identified by the event's time, which is when the kernel received it. The report
+     * can use that time (CLOCK_MONOTONIC, in nanoseconds) to measure the latency of each stage.
+     * They do nothing by default.
+     * @{
+     */
+    virtual void dispatched_event_from_seat(int64_t /*event_time*/) {}
+    virtual void delivered_event_to_surface(int64_t /*event_time*/) {}
+    virtual void flushed_event_to_client(int64_t /*event_time*/) {}
+    /** @} */
+
 protected:
     InputReport() = default;
     InputReport(InputReport const&) = delete;
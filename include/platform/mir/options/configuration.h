@@ -46,6 +46,9 @@ extern char const* const wayland_extensions_opt;
 extern char const* const add_wayland_extensions_opt;
 extern char const* const drop_wayland_extensions_opt;
 extern char const* const idle_timeout_opt;
+extern char const* const capture_composited_frames_opt;
+extern char const* const coalesce_pointer_motion_opt;
+extern char const* const input_thread_priority_opt;
 
 extern char const* const enable_key_repeat_opt;
 
@@ -18,6 +18,7 @@
 #define MIR_RENDERER_GL_SURFACE_H_
 
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
 #include <memory>
 
 namespace mir
@@ -38,6 +39,21 @@ public:
     virtual void make_current() = 0;
     virtual void release_current() = 0;
 
+    /**
+     * Age, in frames, of the contents of the buffer that will be drawn to after bind()
+     *
+     * 0 means the contents are undefined; N means they are those that were committed N frames ago.
+     */
+    virtual auto buffer_age() const -> int = 0;
+
+    /**
+     * Restrict the changes made by the next commit() to \a damage
+     *
+     * Rectangles are in GL window coordinates (as for glScissor()). Must be called after bind()
+     * and before drawing. If not called the whole surface is treated as changed.
+     */
+    virtual void set_damage(geometry::Rectangles const& damage) = 0;
+
     // Naming: SwapBuffers? Commit? Claim current buffer?
     virtual auto commit() -> std::unique_ptr<graphics::Framebuffer> = 0;
 
@@ -18,6 +18,7 @@
 #define MIR_RENDERER_RENDERER_H_
 
 #include "mir/geometry/rectangle.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/graphics/renderable.h"
 #include "mir_toolkit/common.h"
 #include <glm/glm.hpp>
@@ -26,6 +27,7 @@ namespace mir
 {
 namespace graphics
 {
+class Buffer;
 class Framebuffer;
 }
 
@@ -39,9 +41,30 @@ public:
 
     virtual void set_viewport(geometry::Rectangle const& rect) = 0;
     virtual void set_output_transform(glm::mat2 const&) = 0;
+    /**
+     * The screen area that has changed since the previous render()
+     *
+     * Applies to the next render() only; if not called the whole viewport is redrawn.
+     */
+    virtual void set_damage(geometry::Rectangles const& damage) = 0;
     virtual auto render(graphics::RenderableList const&) const -> std::unique_ptr<graphics::Framebuffer> = 0;
     virtual void suspend() = 0; // called when render() is skipped
 
+    /**
+     * Keep a copy of each frame render() draws, for last_frame()
+     *
+     * This costs a copy of the whole output each frame, so is off unless something needs it.
+     */
+    virtual void retain_frames(bool /*retain*/) {}
+
+    /**
+     * The frame the last render() drew, if retain_frames() is on and the renderer could keep it
+     *
+     * The frame is not drawn into again while the buffer is held. It may be called from any
+     * thread, without a GL context.
+     */
+    virtual auto last_frame() const -> std::shared_ptr<graphics::Buffer> { return nullptr; }
+
 protected:
     Renderer() = default;
     Renderer(const Renderer&) = delete;
@@ -58,6 +58,8 @@ public:
     MOCK_METHOD2(glDeleteRenderbuffers, void(GLsizei, const GLuint *));
     MOCK_METHOD1(glDeleteProgram, void(GLuint));
     MOCK_METHOD1(glDeleteShader, void(GLuint));
+    MOCK_METHOD8(glCopyTexSubImage2D,
+                 void(GLenum, GLint, GLint, GLint, GLint, GLint, GLsizei, GLsizei));
     MOCK_METHOD2(glDeleteTextures, void(GLsizei, const GLuint *));
     MOCK_METHOD1(glDisable, void(GLenum));
     MOCK_METHOD1(glDisableVertexAttribArray, void(GLuint));
@@ -65,6 +67,7 @@ public:
     MOCK_METHOD1(glEnable, void(GLenum));
     MOCK_METHOD1(glEnableVertexAttribArray, void(GLuint));
     MOCK_METHOD0(glFinish, void());
+    MOCK_METHOD0(glFlush, void());
     MOCK_METHOD4(glFramebufferRenderbuffer,
                  void(GLenum, GLenum, GLenum, GLuint));
     MOCK_METHOD5(glFramebufferTexture2D,
@@ -96,6 +99,9 @@ public:
     MOCK_METHOD9(glTexImage2D,
                  void(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum,
                       GLenum,const GLvoid*));
+    MOCK_METHOD9(glTexSubImage2D,
+                 void(GLenum, GLint, GLint, GLint, GLsizei, GLsizei, GLenum,
+                      GLenum, const GLvoid*));
     MOCK_METHOD3(glTexParameteri, void(GLenum, GLenum, GLenum));
     MOCK_METHOD2(glUniform1f, void(GLint, GLfloat));
     MOCK_METHOD3(glUniform2f, void(GLint, GLfloat, GLfloat));
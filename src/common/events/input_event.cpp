@@ -19,6 +19,13 @@
 #include "mir/events/keyboard_event.h"
 #include "mir/events/pointer_event.h"
 #include "mir/events/touch_event.h"
+#include "mir/cookie/authority.h"
+#include "mir/cookie/blob.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <algorithm>
+#include <stdexcept>
 
 MirInputEvent::MirInputEvent(MirInputEventType input_type,
                              MirInputDeviceId dev,
@@ -29,9 +36,9 @@ MirInputEvent::MirInputEvent(MirInputEventType input_type,
     input_type_{input_type},
     device_id_{dev},
     event_time_{et},
-    cookie_{cookie},
     modifiers_{mods}
 {
+    set_cookie(cookie);
 }
 
 MirInputEventType MirInputEvent::input_type() const
@@ -101,12 +108,32 @@ void MirInputEvent::set_event_time(std::chrono::nanoseconds const& event_time)
 
 std::vector<uint8_t> MirInputEvent::cookie() const
 {
-    return cookie_;
+    if (cookie_authority_)
+    {
+        return cookie_authority_->make_cookie(event_time_.count())->serialize();
+    }
+
+    return {cookie_.begin(), cookie_.begin() + cookie_size_};
 }
 
 void MirInputEvent::set_cookie(std::vector<uint8_t> const& cookie)
 {
-    cookie_ = cookie;
+    static_assert(mir::cookie::default_blob_size <= max_cookie_size);
+
+    if (cookie.size() > cookie_.size())
+    {
+        BOOST_THROW_EXCEPTION(std::invalid_argument("Cookie of " + std::to_string(cookie.size()) + " bytes is too large"));
+    }
+
+    std::copy(cookie.begin(), cookie.end(), cookie_.begin());
+    cookie_size_ = cookie.size();
+    cookie_authority_.reset();
+}
+
+void MirInputEvent::set_cookie_authority(std::shared_ptr<mir::cookie::Authority> const& authority)
+{
+    cookie_size_ = 0;
+    cookie_authority_ = authority;
 }
 
 MirInputEventModifiers MirInputEvent::modifiers() const
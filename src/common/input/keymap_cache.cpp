@@ -0,0 +1,191 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/input/keymap_cache.h"
+#include "mir/input/keymap.h"
+#include "mir/input/xkb_mapper.h"
+#include "mir/anonymous_shm_file.h"
+
+#include <boost/throw_exception.hpp>
+
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mi = mir::input;
+
+namespace
+{
+/// Enough for every layout a user switches between, and the keymaps of a few virtual keyboards
+auto constexpr max_entries = 16u;
+
+using KeymapText = std::unique_ptr<char, void(*)(void*)>;
+
+auto text_of(xkb_keymap* keymap) -> KeymapText
+{
+    return {xkb_keymap_get_as_string(keymap, XKB_KEYMAP_FORMAT_TEXT_V1), free};
+}
+
+/// A memfd clients can map but that nobody can change, or nullptr if it can't be sealed
+auto make_sealed_file(char const* text, size_t size) -> std::shared_ptr<mi::KeymapCache::File const>
+{
+    mir::Fd const fd{memfd_create("mir-keymap", MFD_CLOEXEC | MFD_ALLOW_SEALING)};
+    if (fd == mir::Fd::invalid)
+    {
+        return nullptr;
+    }
+
+    for (size_t written = 0; written < size;)
+    {
+        auto const result = write(fd, text + written, size - written);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            BOOST_THROW_EXCEPTION((std::system_error{errno, std::system_category(), "Failed to write keymap file"}));
+        }
+        written += result;
+    }
+
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) < 0)
+    {
+        return nullptr;
+    }
+
+    return std::make_shared<mi::KeymapCache::File const>(fd, size);
+}
+
+/// A file for one client only, as a client could change it
+auto make_private_file(char const* text, size_t size) -> std::shared_ptr<mi::KeymapCache::File const>
+{
+    mir::AnonymousShmFile shm_buffer{size};
+    memcpy(shm_buffer.base_ptr(), text, size);
+    return std::make_shared<mi::KeymapCache::File const>(mir::Fd{dup(shm_buffer.fd())}, size);
+}
+}
+
+struct mi::KeymapCache::Entry
+{
+    explicit Entry(std::shared_ptr<Keymap> const& keymap)
+        : keymap{keymap},
+          context{make_unique_context()},
+          compiled{keymap->make_unique_xkb_keymap(context.get())}
+    {
+    }
+
+    std::shared_ptr<Keymap> const keymap;
+    /// Each entry has its own context, so entries that outlive the cache share nothing
+    XKBContextPtr const context;
+    XKBKeymapPtr const compiled;
+    /// Created when first wanted
+    std::shared_ptr<File const> sealed_file;
+    bool sealing_unsupported{false};
+};
+
+mi::KeymapCache::KeymapCache()
+    : KeymapCache{Observer{}}
+{
+}
+
+mi::KeymapCache::KeymapCache(Observer observer)
+    : observer{std::move(observer)}
+{
+}
+
+mi::KeymapCache::~KeymapCache() = default;
+
+auto mi::KeymapCache::compiled(std::shared_ptr<Keymap> const& keymap) -> std::shared_ptr<xkb_keymap>
+{
+    std::unique_lock lock{mutex};
+    auto const entry = entry_for(keymap);
+    notify_observer(lock);
+
+    return {entry, entry->compiled.get()};
+}
+
+auto mi::KeymapCache::file(std::shared_ptr<Keymap> const& keymap) -> std::shared_ptr<File const>
+{
+    std::unique_lock lock{mutex};
+    auto const entry = entry_for(keymap);
+
+    auto result = entry->sealed_file;
+    if (!result)
+    {
+        auto const text = text_of(entry->compiled.get());
+        // so the null terminator is included
+        auto const size = strlen(text.get()) + 1;
+
+        if (!entry->sealing_unsupported)
+        {
+            entry->sealed_file = make_sealed_file(text.get(), size);
+            entry->sealing_unsupported = !entry->sealed_file;
+            result = entry->sealed_file;
+        }
+        if (!result)
+        {
+            result = make_private_file(text.get(), size);
+        }
+
+        shm_bytes += size;
+        changed = true;
+    }
+    notify_observer(lock);
+
+    return result;
+}
+
+auto mi::KeymapCache::entry_for(std::shared_ptr<Keymap> const& keymap) -> std::shared_ptr<Entry>
+{
+    for (auto i = entries.begin(); i != entries.end(); ++i)
+    {
+        if ((*i)->keymap == keymap || (*i)->keymap->matches(*keymap))
+        {
+            entries.splice(entries.begin(), entries, i);
+            return entries.front();
+        }
+    }
+
+    // Compiling with the lock held means that a burst of requests for a keymap compiles it once
+    entries.push_front(std::make_shared<Entry>(keymap));
+    if (entries.size() > max_entries)
+    {
+        entries.pop_back();
+    }
+
+    ++compilations;
+    changed = true;
+    return entries.front();
+}
+
+void mi::KeymapCache::notify_observer(std::unique_lock<std::mutex>& lock)
+{
+    if (!changed || !observer)
+    {
+        return;
+    }
+
+    changed = false;
+    auto const compilations_now = compilations;
+    auto const shm_bytes_now = shm_bytes;
+    lock.unlock();
+
+    observer(compilations_now, shm_bytes_now);
+}
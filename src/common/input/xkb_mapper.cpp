@@ -16,6 +16,7 @@
 
 #include "mir/input/xkb_mapper.h"
 #include "mir/input/keymap.h"
+#include "mir/input/keymap_cache.h"
 #include "mir/events/event_private.h"
 #include "mir/events/event_builders.h"
 
@@ -125,7 +126,13 @@ mi::XKBContextPtr mi::make_unique_context()
 }
 
 mircv::XKBMapper::XKBMapper() :
+    XKBMapper{std::make_shared<KeymapCache>()}
+{
+}
+
+mircv::XKBMapper::XKBMapper(std::shared_ptr<KeymapCache> const& keymap_cache) :
     context{make_unique_context()},
+    keymap_cache{keymap_cache},
     compose_table{make_unique_compose_table_from_locale(context, get_locale_from_environment())}
 {
 }
@@ -231,7 +238,7 @@ void mircv::XKBMapper::set_keymap(std::shared_ptr<Keymap> new_keymap)
 {
     std::lock_guard lg(guard);
     default_keymap = std::move(new_keymap);
-    default_compiled_keymap = default_keymap->make_unique_xkb_keymap(context.get());
+    default_compiled_keymap = keymap_cache->compiled(default_keymap);
     device_mapping.clear();
 }
 
@@ -244,7 +251,7 @@ void mircv::XKBMapper::set_keymap(MirInputDeviceId id, std::shared_ptr<Keymap> n
 {
     std::lock_guard lg(guard);
 
-    auto compiled_keymap = new_keymap->make_unique_xkb_keymap(context.get());
+    auto compiled_keymap = keymap_cache->compiled(new_keymap);
     auto mapping_state = std::make_unique<XkbMappingState>(std::move(new_keymap), std::move(compiled_keymap));
 
     device_mapping.erase(id);
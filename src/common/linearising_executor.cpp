@@ -22,6 +22,11 @@
 
 namespace
 {
+/* The most items to execute before handing our worker back to the thread_pool_executor
+ * (and rejoining the back of its queue), so a busy queue can't monopolise a worker.
+ */
+constexpr int const max_items_per_turn = 16;
+
 class LinearisingAdaptor : public mir::NonBlockingExecutor
 {
 public:
@@ -57,8 +62,15 @@ private:
     {
         {
             std::unique_lock lock{mutex};
-            while (!workqueue.empty())
+            for (auto turn = 0; !workqueue.empty(); ++turn)
             {
+                if (turn == max_items_per_turn)
+                {
+                    // We stay non-idle, so spawn() won't start another work_loop() meanwhile
+                    mir::thread_pool_executor.spawn([this]() { work_loop(); });
+                    return;
+                }
+
                 {
                     auto work = std::move(workqueue.front());
                     workqueue.pop_front();
@@ -21,8 +21,12 @@
 #include <thread>
 #include <memory>
 #include <atomic>
+#include <algorithm>
+#include <deque>
 #include <list>
 #include <future>
+#include <optional>
+#include <vector>
 
 #include <version>
 
@@ -84,6 +88,11 @@ namespace
 {
 constexpr int const min_threadpool_threads = 4;
 
+/* Work on the pool might wait for other work on the pool to complete, so don't go
+ * below this number of workers however few CPUs there are.
+ */
+constexpr unsigned const min_pool_workers = 4;
+
 /* We use an atomic void(*)() rather than a std::function to avoid needing to take a mutex
  * in exception context, as taking a mutex can itself throw an exception!
  */
@@ -199,11 +208,12 @@ private:
 };
 
 /**
- * A self-managing ThreadPool
+ * A self-managing pool of dedicated threads, backing mir::dedicated_thread_executor
  *
  * Theory of operation:
  * The ThreadPool executes each item of work on an independent thread; each call to spawn() is
- * guaranteed to be on a different thread to the caller.
+ * guaranteed to be on a different thread to the caller. This makes it suitable for work that
+ * blocks indefinitely, but it is unbounded, so everything else should use the WorkStealingPool.
  *
  * To reduce the overhead of spawning threads, the ThreadPool attempts to maintain
  * min_threadpool_threads of free worker threads.
@@ -324,15 +334,226 @@ private:
     std::list<std::shared_ptr<Worker>> workers;
 };
 
-ThreadPool thread_pool;
+/**
+ * A fixed-size, work-stealing ThreadPool
+ *
+ * Theory of operation:
+ * The pool has one thread per CPU (but at least min_pool_workers), each with its own queue of work.
+ * Work spawned from one of the pool's threads goes on that thread's queue, so related work tends to
+ * stay on one CPU; work spawned from elsewhere is dealt out to the queues in turn.
+ *
+ * A worker takes work from the front of its own queue. When its own queue is empty it steals from
+ * the back of the others', so no worker is idle while there is work queued anywhere. When there is
+ * no work at all the workers sleep on work_available.
+ *
+ * The threads are started on the first spawn(), and stopped by quiesce() (after which the next
+ * spawn() starts them again).
+ *
+ * Work on this pool should not block for long: a worker that's blocked is a CPU's worth of
+ * capacity that nothing else can use. Work that needs to block should use the ThreadPool instead.
+ */
+class WorkStealingPool : public mir::NonBlockingExecutor
+{
+public:
+    WorkStealingPool()
+        : size{std::max(min_pool_workers, std::thread::hardware_concurrency())},
+          queues{std::make_unique<Queue[]>(size)}
+    {
+    }
+
+    ~WorkStealingPool() noexcept
+    {
+        quiesce();
+    }
+
+    void spawn(std::function<void()>&& work) override
+    {
+        auto const index = current_pool == this ? current_queue : next_queue++ % size;
+        {
+            std::lock_guard lock{queues[index].mutex};
+            queues[index].work.push_back(std::move(work));
+        }
+        ++outstanding;
+        ++queued;
+
+        if (!started)
+        {
+            std::lock_guard lock{mutex};
+            // If we're stopping, quiesce() starts new threads for this once the old ones are joined
+            if (threads.empty() && !stopping)
+            {
+                start();
+            }
+        }
+
+        /* A worker counts itself as sleeping before it checks queued, so either it sees the
+         * work we've queued or we see it sleeping. Taking the mutex ensures that it's actually
+         * waiting, rather than about to, when we notify.
+         */
+        if (sleeping > 0)
+        {
+            std::lock_guard lock{mutex};
+            work_available.notify_one();
+        }
+    }
+
+    void quiesce()
+    {
+        std::unique_lock lock{mutex};
+        idle.wait(lock, [this]() { return outstanding == 0; });
+
+        stopping = true;
+        started = false;
+        auto stopped = std::move(threads);
+        threads.clear();
+        lock.unlock();
+
+        work_available.notify_all();
+        for (auto& thread : stopped)
+        {
+            thread.join();
+        }
+
+        lock.lock();
+        stopping = false;
+        // Anything spawned while we were stopping the threads needs some new ones
+        if (outstanding > 0 && threads.empty())
+        {
+            start();
+        }
+    }
 
+    auto metrics() const -> mir::ThreadPoolExecutor::Metrics
+    {
+        return {static_cast<size_t>(std::max(queued.load(), 0L)), steals.load(), size};
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> work;
+    };
+
+    // Precondition: mutex is held
+    void start()
+    {
+        for (unsigned i = 0; i != size; ++i)
+        {
+            threads.emplace_back([this, i]() { work_loop(i); });
+        }
+        started = true;
+    }
+
+    void work_loop(unsigned index)
+    {
+        mir::set_thread_name("Mir/Workqueue");
+        current_pool = this;
+        current_queue = index;
+
+        for (;;)
+        {
+            if (auto work = take_work(index))
+            {
+                try
+                {
+                    (*work)();
+                }
+                catch (...)
+                {
+                    (*exception_handler)();
+                }
+                // Destroy the functor before reporting that it has completed
+                work.reset();
+
+                if (--outstanding == 0)
+                {
+                    // quiesce() checks outstanding with mutex held, so this can't be missed
+                    std::lock_guard lock{mutex};
+                    idle.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock lock{mutex};
+            ++sleeping;
+            work_available.wait(lock, [this]() { return stopping || queued > 0; });
+            --sleeping;
+            if (stopping)
+            {
+                return;
+            }
+        }
+    }
+
+    auto take_work(unsigned index) -> std::optional<std::function<void()>>
+    {
+        {
+            auto& own = queues[index];
+            std::lock_guard lock{own.mutex};
+            if (!own.work.empty())
+            {
+                auto work = std::move(own.work.front());
+                own.work.pop_front();
+                --queued;
+                return work;
+            }
+        }
+
+        for (unsigned i = 1; i != size; ++i)
+        {
+            auto& victim = queues[(index + i) % size];
+            std::lock_guard lock{victim.mutex};
+            if (!victim.work.empty())
+            {
+                auto work = std::move(victim.work.back());
+                victim.work.pop_back();
+                --queued;
+                ++steals;
+                return work;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    unsigned const size;
+    std::unique_ptr<Queue[]> const queues;
+    std::atomic<unsigned> next_queue{0};
+
+    /* Work items in the queues; this can briefly go negative, as a worker can take an
+     * item before the spawn() that queued it has counted it.
+     */
+    std::atomic<long> queued{0};
+    std::atomic<uint64_t> steals{0};
+
+    std::atomic<size_t> outstanding{0};     ///< Work items spawned but not yet completed
+    std::atomic<unsigned> sleeping{0};      ///< Workers waiting (or about to wait) on work_available
+    std::atomic<bool> started{false};       ///< threads is non-empty; only changed with mutex held
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable idle;
+    bool stopping{false};
+    std::vector<std::thread> threads;
+
+    static thread_local WorkStealingPool* current_pool;
+    static thread_local unsigned current_queue;
+};
+
+thread_local WorkStealingPool* WorkStealingPool::current_pool{nullptr};
+thread_local unsigned WorkStealingPool::current_queue{0};
+
+ThreadPool dedicated_threads;
+WorkStealingPool work_stealing_pool;
 }
 
-mir::NonBlockingExecutor& mir::thread_pool_executor = thread_pool;
+mir::NonBlockingExecutor& mir::thread_pool_executor = work_stealing_pool;
+mir::NonBlockingExecutor& mir::dedicated_thread_executor = dedicated_threads;
 
 void mir::ThreadPoolExecutor::spawn(std::function<void()>&& work)
 {
-    thread_pool.spawn(std::move(work));
+    work_stealing_pool.spawn(std::move(work));
 }
 
 void mir::ThreadPoolExecutor::set_unhandled_exception_handler(void (*handler)())
@@ -342,5 +563,12 @@ void mir::ThreadPoolExecutor::set_unhandled_exception_handler(void (*handler)())
 
 void mir::ThreadPoolExecutor::quiesce()
 {
-    thread_pool.quiesce();
+    // Work on the dedicated threads is likely to be feeding the pool, so wait for it first
+    dedicated_threads.quiesce();
+    work_stealing_pool.quiesce();
+}
+
+auto mir::ThreadPoolExecutor::metrics() -> Metrics
+{
+    return work_stealing_pool.metrics();
 }
@@ -81,7 +81,7 @@ public:
             BOOST_THROW_EXCEPTION(std::logic_error("Secret size " + std::to_string(secret.size()) + " is to small, require " +
                                                    std::to_string(minimum_secret_size) + " or greater."));
 
-        hmac_sha256_set_key(&ctx, secret.size(), secret.data());
+        hmac_sha256_set_key(&keyed_ctx, secret.size(), secret.data());
     }
 
     virtual ~AuthorityNettle() noexcept = default;
@@ -135,8 +135,11 @@ public:
     }
 
 private:
-    std::vector<uint8_t> calculate_cookie(uint64_t const& timestamp)
+    std::vector<uint8_t> calculate_cookie(uint64_t const& timestamp) const
     {
+        // Cookies are made and checked on many threads at once, so each gets its own copy of the keyed state
+        auto ctx = keyed_ctx;
+
         std::vector<uint8_t> mac(mac_byte_size);
         hmac_sha256_update(&ctx, sizeof(timestamp), reinterpret_cast<uint8_t const*>(&timestamp));
         hmac_sha256_digest(&ctx, mac.size(), mac.data());
@@ -155,7 +158,7 @@ private:
                mir::cookie::const_memcmp(this_stream.data(), other_stream.data(), this_stream.size()) == 0;
     }
 
-    struct hmac_sha256_ctx ctx;
+    struct hmac_sha256_ctx keyed_ctx;
 };
 
 size_t mir::cookie::Authority::optimal_secret_size()
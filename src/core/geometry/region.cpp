@@ -0,0 +1,393 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+
+#include <algorithm>
+#include <ostream>
+#include <ranges>
+
+namespace geom = mir::geometry;
+
+namespace
+{
+bool is_empty(geom::Rectangle const& rect)
+{
+    return rect.size.width <= geom::Width{0} || rect.size.height <= geom::Height{0};
+}
+
+auto rect_from_edges(int left, int top, int right, int bottom) -> geom::Rectangle
+{
+    return {{left, top}, {right - left, bottom - top}};
+}
+
+/// Appends the edges of each band to \a edges
+template<typename Bands>
+void add_band_edges(Bands const& bands, std::vector<int>& edges)
+{
+    for (auto const& band : bands)
+    {
+        edges.push_back(band.top);
+        edges.push_back(band.bottom);
+    }
+}
+
+void sort_unique(std::vector<int>& values)
+{
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+}
+
+geom::Region::Region()
+{
+}
+
+geom::Region::Region(Rectangle const& rect)
+{
+    if (!is_empty(rect))
+    {
+        bands.push_back({rect.top().as_int(), rect.bottom().as_int(), {{rect.left().as_int(), rect.right().as_int()}}});
+    }
+}
+
+geom::Region::Region(Rectangles const& rects)
+{
+    std::vector<Rectangle> non_empty;
+    std::vector<int> edges;
+    for (auto const& rect : rects)
+    {
+        if (!is_empty(rect))
+        {
+            non_empty.push_back(rect);
+            edges.push_back(rect.top().as_int());
+            edges.push_back(rect.bottom().as_int());
+        }
+    }
+    sort_unique(edges);
+
+    // Sweep down the distinct horizontal edges; between two consecutive edges
+    // the rectangles crossing that strip don't change.
+    std::vector<Span> spans;
+    for (size_t i = 0; i + 1 < edges.size(); ++i)
+    {
+        auto const top = edges[i], bottom = edges[i + 1];
+
+        spans.clear();
+        for (auto const& rect : non_empty)
+        {
+            if (rect.top().as_int() <= top && rect.bottom().as_int() >= bottom)
+            {
+                spans.push_back({rect.left().as_int(), rect.right().as_int()});
+            }
+        }
+        if (spans.empty())
+        {
+            continue;
+        }
+
+        std::sort(spans.begin(), spans.end(), [](Span const& l, Span const& r) { return l.left < r.left; });
+        std::vector<Span> merged{spans.front()};
+        for (auto const& span : spans)
+        {
+            if (span.left <= merged.back().right)
+            {
+                merged.back().right = std::max(merged.back().right, span.right);
+            }
+            else
+            {
+                merged.push_back(span);
+            }
+        }
+
+        if (!bands.empty() && bands.back().bottom == top && bands.back().spans == merged)
+        {
+            bands.back().bottom = bottom;
+        }
+        else
+        {
+            bands.push_back({top, bottom, std::move(merged)});
+        }
+    }
+}
+
+bool geom::Region::empty() const
+{
+    return bands.empty();
+}
+
+bool geom::Region::contains(Point const& point) const
+{
+    auto const x = point.x.as_int(), y = point.y.as_int();
+
+    auto const band = std::upper_bound(
+        bands.begin(), bands.end(), y, [](int y, Band const& band) { return y < band.bottom; });
+
+    if (band == bands.end() || band->top > y)
+    {
+        return false;
+    }
+
+    return std::any_of(
+        band->spans.begin(), band->spans.end(),
+        [x](Span const& span) { return span.left <= x && x < span.right; });
+}
+
+bool geom::Region::contains(Rectangle const& rect) const
+{
+    if (is_empty(rect))
+    {
+        return true;
+    }
+
+    auto const left = rect.left().as_int(), right = rect.right().as_int();
+    auto const bottom = rect.bottom().as_int();
+    auto y = rect.top().as_int();
+
+    auto band = std::upper_bound(
+        bands.begin(), bands.end(), y, [](int y, Band const& band) { return y < band.bottom; });
+
+    for (; y < bottom; ++band)
+    {
+        // Any gap between bands is uncovered
+        if (band == bands.end() || band->top > y)
+        {
+            return false;
+        }
+
+        // Spans never touch, so the whole width has to lie within a single one
+        bool const covered = std::any_of(
+            band->spans.begin(), band->spans.end(),
+            [&](Span const& span) { return span.left <= left && right <= span.right; });
+
+        if (!covered)
+        {
+            return false;
+        }
+
+        y = band->bottom;
+    }
+
+    return true;
+}
+
+bool geom::Region::overlaps(Rectangle const& rect) const
+{
+    if (is_empty(rect))
+    {
+        return false;
+    }
+
+    auto const left = rect.left().as_int(), right = rect.right().as_int();
+    auto const top = rect.top().as_int(), bottom = rect.bottom().as_int();
+
+    auto band = std::upper_bound(
+        bands.begin(), bands.end(), top, [](int y, Band const& band) { return y < band.bottom; });
+
+    for (; band != bands.end() && band->top < bottom; ++band)
+    {
+        for (auto const& span : band->spans)
+        {
+            if (span.left < right && left < span.right)
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+geom::Rectangle geom::Region::bounding_rectangle() const
+{
+    if (bands.empty())
+    {
+        return {};
+    }
+
+    auto left = bands.front().spans.front().left;
+    auto right = bands.front().spans.back().right;
+    for (auto const& band : bands)
+    {
+        left = std::min(left, band.spans.front().left);
+        right = std::max(right, band.spans.back().right);
+    }
+
+    return rect_from_edges(left, bands.front().top, right, bands.back().bottom);
+}
+
+geom::Rectangles geom::Region::rectangles() const
+{
+    Rectangles result;
+    for (auto const& band : bands)
+    {
+        for (auto const& span : band.spans)
+        {
+            result.add(rect_from_edges(span.left, band.top, span.right, band.bottom));
+        }
+    }
+    return result;
+}
+
+void geom::Region::unite(Region const& other)
+{
+    if (other.empty())
+    {
+        return;
+    }
+
+    bands = combine(bands, other.bands, Op::unite);
+}
+
+void geom::Region::subtract(Region const& other)
+{
+    if (empty() || other.empty())
+    {
+        return;
+    }
+
+    bands = combine(bands, other.bands, Op::subtract);
+}
+
+void geom::Region::intersect(Region const& other)
+{
+    if (empty())
+    {
+        return;
+    }
+
+    bands = combine(bands, other.bands, Op::intersect);
+}
+
+auto geom::Region::combine(std::vector<Band> const& a, std::vector<Band> const& b, Op op) -> std::vector<Band>
+{
+    auto const in_result =
+        [op](bool in_a, bool in_b)
+        {
+            switch (op)
+            {
+            case Op::unite:     return in_a || in_b;
+            case Op::subtract:  return in_a && !in_b;
+            case Op::intersect: return in_a && in_b;
+            }
+            return false;
+        };
+
+    // Unless uniting, the bands of b above and below all of a can't change the result
+    auto b_begin = b.begin(), b_end = b.end();
+    if (op != Op::unite && !a.empty())
+    {
+        auto const top = a.front().top, bottom = a.back().bottom;
+        b_begin = std::partition_point(b_begin, b_end, [top](Band const& band) { return band.bottom <= top; });
+        b_end = std::partition_point(b_begin, b_end, [bottom](Band const& band) { return band.top < bottom; });
+    }
+
+    std::vector<int> y_edges;
+    add_band_edges(a, y_edges);
+    add_band_edges(std::ranges::subrange{b_begin, b_end}, y_edges);
+    sort_unique(y_edges);
+
+    std::vector<Band> result;
+    std::vector<Span> const no_spans;
+    std::vector<int> x_edges;
+    std::vector<Span> spans;
+
+    auto band_a = a.begin(), band_b = b_begin;
+    for (size_t i = 0; i + 1 < y_edges.size(); ++i)
+    {
+        auto const top = y_edges[i], bottom = y_edges[i + 1];
+
+        // Between consecutive edges each operand is either a single band or nothing
+        while (band_a != a.end() && band_a->bottom <= top) ++band_a;
+        while (band_b != b_end && band_b->bottom <= top) ++band_b;
+
+        auto const& spans_a = band_a != a.end() && band_a->top <= top ? band_a->spans : no_spans;
+        auto const& spans_b = band_b != b_end && band_b->top <= top ? band_b->spans : no_spans;
+
+        if (spans_a.empty() && spans_b.empty())
+        {
+            continue;
+        }
+
+        // The same sweep again, across the strip
+        x_edges.clear();
+        for (auto const* spans : {&spans_a, &spans_b})
+        {
+            for (auto const& span : *spans)
+            {
+                x_edges.push_back(span.left);
+                x_edges.push_back(span.right);
+            }
+        }
+        sort_unique(x_edges);
+
+        spans.clear();
+        auto span_a = spans_a.begin(), span_b = spans_b.begin();
+        for (size_t j = 0; j + 1 < x_edges.size(); ++j)
+        {
+            auto const left = x_edges[j], right = x_edges[j + 1];
+
+            while (span_a != spans_a.end() && span_a->right <= left) ++span_a;
+            while (span_b != spans_b.end() && span_b->right <= left) ++span_b;
+
+            bool const in_a = span_a != spans_a.end() && span_a->left <= left;
+            bool const in_b = span_b != spans_b.end() && span_b->left <= left;
+
+            if (in_result(in_a, in_b))
+            {
+                if (!spans.empty() && spans.back().right == left)
+                {
+                    spans.back().right = right;
+                }
+                else
+                {
+                    spans.push_back({left, right});
+                }
+            }
+        }
+
+        if (spans.empty())
+        {
+            continue;
+        }
+
+        if (!result.empty() && result.back().bottom == top && result.back().spans == spans)
+        {
+            result.back().bottom = bottom;
+        }
+        else
+        {
+            result.push_back({top, bottom, spans});
+        }
+    }
+
+    return result;
+}
+
+bool geom::Region::operator==(Region const& other) const
+{
+    return bands == other.bands;
+}
+
+bool geom::Region::operator!=(Region const& other) const
+{
+    return !(*this == other);
+}
+
+std::ostream& geom::operator<<(std::ostream& out, Region const& value)
+{
+    return out << value.rectangles();
+}
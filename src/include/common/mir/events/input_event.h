@@ -19,6 +19,10 @@
 
 #include "mir/events/event.h"
 
+#include <array>
+
+namespace mir { namespace cookie { class Authority; } }
+
 struct MirInputEvent : MirEvent
 {
     MirInputEventType input_type() const;
@@ -32,9 +36,13 @@ struct MirInputEvent : MirEvent
     std::chrono::nanoseconds event_time() const;
     void set_event_time(std::chrono::nanoseconds const& event_time);
 
+    /// The serialized cookie, computed on demand if the event has a cookie authority
     std::vector<uint8_t> cookie() const;
     void set_cookie(std::vector<uint8_t> const& cookie);
 
+    /// Sign the event with a cookie for its event time, computed only if it is asked for
+    void set_cookie_authority(std::shared_ptr<mir::cookie::Authority> const& authority);
+
     MirInputEventModifiers modifiers() const;
     void set_modifiers(MirInputEventModifiers mods);
 
@@ -63,7 +71,11 @@ private:
     int window_id_ = 0;
     MirInputDeviceId device_id_ = 0;
     std::chrono::nanoseconds event_time_ = {};
-    std::vector<uint8_t> cookie_;
+    /// Large enough for a serialized mir::cookie::Cookie (see mir::cookie::default_blob_size)
+    static size_t constexpr max_cookie_size = 41;
+    std::array<uint8_t, max_cookie_size> cookie_ = {};
+    uint8_t cookie_size_ = 0;
+    std::shared_ptr<mir::cookie::Authority> cookie_authority_;
     MirInputEventModifiers modifiers_ = 0;
 };
 
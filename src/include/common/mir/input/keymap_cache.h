@@ -0,0 +1,96 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_INPUT_KEYMAP_CACHE_H_
+#define MIR_INPUT_KEYMAP_CACHE_H_
+
+#include "mir/fd.h"
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+
+struct xkb_keymap;
+
+namespace mir
+{
+namespace input
+{
+class Keymap;
+
+/**
+ * Compiled XKB keymaps, shared by every device, seat and client using the same keymap
+ *
+ * Each distinct keymap (as judged by Keymap::matches()) is compiled once. The first time
+ * it's wanted as a file its text is written to a sealed, read-only memfd that can be sent
+ * to every client.
+ *
+ * The keymaps and files returned stay valid for as long as they are held, even once the
+ * cache has dropped them. The cache keeps the most recently used keymaps.
+ */
+class KeymapCache
+{
+public:
+    /// A keymap as XKB_KEYMAP_FORMAT_TEXT_V1 text, including the terminating NUL
+    struct File
+    {
+        Fd fd;
+        size_t size;
+    };
+
+    /// Told the total number of compilations and bytes of keymap files created whenever either grows
+    using Observer = std::function<void(uint64_t compilations, uint64_t shm_bytes)>;
+
+    KeymapCache();
+    explicit KeymapCache(Observer observer);
+    ~KeymapCache();
+
+    /**
+     * The compiled keymap, compiling it unless a matching keymap is cached
+     *
+     * xkb_keymap reference counting isn't atomic, so xkb_states for a keymap should only be
+     * created and destroyed by one thread at a time.
+     *
+     * \throws  as Keymap::make_unique_xkb_keymap() for a keymap that fails to compile
+     */
+    auto compiled(std::shared_ptr<Keymap> const& keymap) -> std::shared_ptr<xkb_keymap>;
+
+    /// The keymap as a file to send to clients, compiling it unless a matching keymap is cached
+    auto file(std::shared_ptr<Keymap> const& keymap) -> std::shared_ptr<File const>;
+
+private:
+    KeymapCache(KeymapCache const&) = delete;
+    KeymapCache& operator=(KeymapCache const&) = delete;
+
+    struct Entry;
+    auto entry_for(std::shared_ptr<Keymap> const& keymap) -> std::shared_ptr<Entry>;
+    void notify_observer(std::unique_lock<std::mutex>& lock);
+
+    Observer const observer;
+
+    std::mutex mutex;
+    /// Most recently used first
+    std::list<std::shared_ptr<Entry>> entries;
+    uint64_t compilations{0};
+    uint64_t shm_bytes{0};
+    bool changed{false};
+};
+}
+}
+
+#endif // MIR_INPUT_KEYMAP_CACHE_H_
@@ -33,6 +33,7 @@ namespace mir
 {
 namespace input
 {
+class KeymapCache;
 
 using XKBContextPtr = std::unique_ptr<xkb_context, void(*)(xkb_context*)>;
 XKBContextPtr make_unique_context();
@@ -48,6 +49,8 @@ class XKBMapper : public KeyMapper
 {
 public:
     XKBMapper();
+    /// Shares compiled keymaps with other users of the cache
+    explicit XKBMapper(std::shared_ptr<KeymapCache> const& keymap_cache);
 
     void set_key_state(MirInputDeviceId id, std::vector<uint32_t> const& key_state) override;
     void set_keymap_for_device(MirInputDeviceId id, std::shared_ptr<Keymap> map) override;
@@ -108,6 +111,7 @@ private:
     ComposeState* get_compose_state(MirInputDeviceId id);
 
     XKBContextPtr context;
+    std::shared_ptr<KeymapCache> const keymap_cache;
     std::shared_ptr<Keymap> default_keymap;
     std::shared_ptr<xkb_keymap> default_compiled_keymap;
     XKBComposeTablePtr compose_table;
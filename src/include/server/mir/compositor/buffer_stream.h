@@ -40,6 +40,9 @@ public:
     virtual ~BufferStream() = default;
 
     virtual auto lock_compositor_buffer(void const* user_id) -> std::shared_ptr<graphics::Buffer> = 0;
+    /// The region (in buffer coordinates) of the buffer most recently locked by \a user_id that differs from the
+    /// buffer that user locked before it. Covers the whole buffer if the previous one is unknown.
+    virtual auto damage_for(void const* user_id) const -> geometry::Rectangles = 0;
     /// Logical size of the stream (may be different than buffer sizes if scaled)
     virtual auto stream_size() -> geometry::Size = 0;
     virtual auto buffers_ready_for_compositor(void const* user_id) const -> int = 0;
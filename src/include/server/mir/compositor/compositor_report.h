@@ -33,6 +33,10 @@ public:
     virtual void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) = 0;
     virtual void rendered_frame(SubCompositorId id) = 0;
     virtual void finished_frame(SubCompositorId id) = 0;
+    /// Compositing was requested, but nothing shown by this compositor needed to be redrawn
+    virtual void skipped_frame(SubCompositorId id) = 0;
+    /// Taking the scene snapshot for a frame needed this many heap allocations that couldn't be recycled
+    virtual void snapshot_allocations(SubCompositorId id, unsigned long allocations) = 0;
     virtual void started() = 0;
     virtual void stopped() = 0;
     virtual void scheduled() = 0;
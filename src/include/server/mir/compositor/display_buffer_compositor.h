@@ -32,6 +32,9 @@ public:
     /// Returns true if any compositing happened, otherwise false.
     virtual bool composite(SceneElementSequence&& scene_sequence) = 0;
 
+    /// Returns true if the last frame composited was handed to the display as client buffers, without rendering
+    virtual bool last_frame_was_zero_copy() const { return false; }
+
 protected:
     DisplayBufferCompositor() = default;
     DisplayBufferCompositor& operator=(DisplayBufferCompositor const&) = delete;
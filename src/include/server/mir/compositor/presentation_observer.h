@@ -0,0 +1,58 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_PRESENTATION_OBSERVER_H_
+#define MIR_COMPOSITOR_PRESENTATION_OBSERVER_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/graphics/frame.h"
+
+namespace mir
+{
+namespace compositor
+{
+/**
+ * Notified when composited frames reach the screen
+ */
+class PresentationObserver
+{
+public:
+    virtual ~PresentationObserver() = default;
+
+    /**
+     * A frame composited for a display sink has been presented.
+     *
+     * \param [in] view_area    The area of the display sink that presented the frame
+     * \param [in] frame        When the frame was presented. If the platform
+     *                          does not count frames msc is 0, and ust is the
+     *                          time the frame was posted.
+     * \param [in] zero_copy    The frame was made of client buffers handed
+     *                          straight to the display, without rendering
+     */
+    virtual void frame_presented(
+        geometry::Rectangle const& view_area,
+        graphics::Frame const& frame,
+        bool zero_copy) = 0;
+
+protected:
+    PresentationObserver() = default;
+    PresentationObserver(PresentationObserver const&) = delete;
+    PresentationObserver& operator=(PresentationObserver const&) = delete;
+};
+}
+}
+
+#endif /* MIR_COMPOSITOR_PRESENTATION_OBSERVER_H_ */
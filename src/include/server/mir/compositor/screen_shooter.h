@@ -26,6 +26,10 @@
 
 namespace mir
 {
+namespace graphics
+{
+class DMABufBuffer;
+}
 namespace renderer
 {
 namespace software
@@ -49,6 +53,22 @@ public:
         mir::geometry::Rectangle const& area,
         std::function<void(std::optional<time::Timestamp>)>&& callback) = 0;
 
+    /// As above, for a buffer that already holds an earlier capture of area. Only damage (the part of area that has
+    /// changed since that capture, in the same coordinates as area) needs to be rendered and copied into the buffer.
+    virtual void capture(
+        std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
+        mir::geometry::Rectangle const& area,
+        mir::geometry::Rectangle const& damage,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) = 0;
+
+    /// Renders straight into target, with no copy through the CPU. Only works if supports_dma_buf_targets().
+    virtual void capture(
+        std::shared_ptr<graphics::DMABufBuffer> const& target,
+        mir::geometry::Rectangle const& area,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) = 0;
+
+    virtual auto supports_dma_buf_targets() const -> bool = 0;
+
 private:
     ScreenShooter(ScreenShooter const&) = delete;
     ScreenShooter& operator=(ScreenShooter const&) = delete;
@@ -49,10 +49,12 @@ class MultiplexingDispatchable;
 namespace compositor
 {
 class BufferStreamFactory;
+class CompositedFrameStore;
 class Scene;
 class DisplayBufferCompositorFactory;
 class Compositor;
 class CompositorReport;
+class PresentationObserver;
 }
 namespace frontend
 {
@@ -127,6 +129,7 @@ class TouchVisualizer;
 class CursorImages;
 class Seat;
 class KeyMapper;
+class KeymapCache;
 }
 
 namespace logging
@@ -240,6 +243,8 @@ public:
     virtual std::shared_ptr<compositor::DisplayBufferCompositorFactory> the_display_buffer_compositor_factory();
     virtual std::shared_ptr<compositor::DisplayBufferCompositorFactory> wrap_display_buffer_compositor_factory(
         std::shared_ptr<compositor::DisplayBufferCompositorFactory> const& wrapped);
+    virtual std::shared_ptr<ObserverRegistrar<compositor::PresentationObserver>>
+        the_presentation_observer_registrar();
     /** @} */
 
     /** @name compositor configuration - dependencies
@@ -347,6 +352,11 @@ protected:
     std::shared_ptr<input::DefaultInputDeviceHub>  the_default_input_device_hub();
     std::shared_ptr<graphics::DisplayConfigurationObserver> the_display_configuration_observer();
     std::shared_ptr<input::SeatObserver> the_seat_observer();
+    std::shared_ptr<compositor::PresentationObserver> the_presentation_observer();
+    /// Null unless screenshots are to copy composited frames
+    std::shared_ptr<compositor::CompositedFrameStore> the_composited_frame_store();
+    /// Compiled keymaps shared by the key mapper and Wayland clients' keyboards
+    std::shared_ptr<input::KeymapCache> the_keymap_cache();
 
     virtual std::shared_ptr<scene::MediatingDisplayChanger> the_mediating_display_changer();
 
@@ -437,6 +447,10 @@ private:
         display_configuration_observer_multiplexer;
     CachedPtr<ObserverMultiplexer<input::SeatObserver>>
         seat_observer_multiplexer;
+    CachedPtr<ObserverMultiplexer<compositor::PresentationObserver>>
+        presentation_observer_multiplexer;
+    CachedPtr<compositor::CompositedFrameStore> composited_frame_store;
+    CachedPtr<input::KeymapCache> keymap_cache;
 
     // The following caches and factory functions are internal to the
     // default implementations of corresponding the Mir components
@@ -20,6 +20,7 @@
 #include <mir_toolkit/common.h>
 #include "mir/graphics/buffer_id.h"
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
 #include <functional>
 #include <memory>
 
@@ -39,7 +40,12 @@ class BufferStream
 public:
     virtual ~BufferStream() = default;
 
+    /// Submit a buffer, all of which is considered to have changed
     virtual void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) = 0;
+    /// Submit a buffer of which only \a damage (in buffer coordinates) differs from the previously submitted one
+    virtual void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Rectangles const& damage) = 0;
 
     virtual void set_frame_posted_callback(
         std::function<void(geometry::Size const&)> const& callback) = 0;
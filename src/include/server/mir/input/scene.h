@@ -21,6 +21,7 @@
 #include <functional>
 
 #include "mir/geometry/point.h"
+#include "mir/geometry/forward.h"
 
 namespace mir
 {
@@ -58,6 +59,9 @@ public:
     // TODO: How can something like SurfaceObserver be adapted to work with non surface renderables?
     virtual void emit_scene_changed() = 0;
 
+    /// As emit_scene_changed(), but only the outputs showing damage need recomposition
+    virtual void emit_scene_damage(geometry::Rectangle const& damage) = 0;
+
     /// Returns if the screen is currently locked
     virtual auto screen_is_locked() const -> bool = 0;
 
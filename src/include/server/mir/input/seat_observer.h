@@ -45,6 +45,8 @@ public:
     virtual void seat_set_cursor_position(float cursor_x, float cursor_y) = 0;
     virtual void seat_set_confinement_region_called(geometry::Rectangles const& regions) = 0;
     virtual void seat_reset_confinement_regions() = 0;
+    /// The totals of keymap compilations and of bytes of keymap files for clients, whenever either grows
+    virtual void seat_keymap_cache_updated(uint64_t compilations, uint64_t shm_bytes) = 0;
 };
 }
 }
@@ -0,0 +1,153 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_POOLED_ALLOCATOR_H_
+#define MIR_POOLED_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mir
+{
+/**
+ * Thread-safe free lists of equally sized blocks of memory
+ *
+ * Objects that are created and destroyed every frame (such as the scene
+ * snapshots handed to the compositor) can recycle each other's memory rather
+ * than going to the heap. The block size is that of the first allocation;
+ * allocations of any other size are passed through to the heap.
+ *
+ * The blocks are kept in a few arenas, each with its own lock. Each compositor
+ * allocates from the arena for its CompositorID, so compositor threads rarely
+ * wait for each other.
+ */
+class BlockPool
+{
+public:
+    /// One free list. Blocks are always returned to the arena they came from.
+    class Arena
+    {
+    public:
+        explicit Arena(size_t max_free_blocks);
+        ~Arena();
+
+        auto allocate(size_t size) -> void*;
+        void deallocate(void* block, size_t size) noexcept;
+
+    private:
+        Arena(Arena const&) = delete;
+        Arena& operator=(Arena const&) = delete;
+
+        size_t const max_free_blocks;
+
+        std::mutex mutex;
+        size_t block_size{0};
+        std::vector<void*> free_blocks;
+    };
+
+    /// \param max_free_blocks  Blocks beyond this many in an arena are returned to the heap when freed
+    explicit BlockPool(size_t max_free_blocks = 1024);
+    ~BlockPool();
+
+    /// The arena for key (such as a CompositorID). Different keys may share an arena.
+    auto arena_for(void const* key) -> Arena&;
+
+    /// Allocates from the arena for a null key
+    auto allocate(size_t size) -> void*;
+    void deallocate(void* block, size_t size) noexcept;
+
+    /// The number of allocations from any BlockPool on this thread that had to go to the heap
+    static auto heap_allocations_on_this_thread() -> uint64_t;
+
+private:
+    BlockPool(BlockPool const&) = delete;
+    BlockPool& operator=(BlockPool const&) = delete;
+
+    static size_t const arena_count{8};
+    std::vector<std::unique_ptr<Arena>> const arenas;
+};
+
+/// A standard allocator that takes single objects from a BlockPool
+template<typename T>
+class PooledAllocator
+{
+public:
+    using value_type = T;
+
+    explicit PooledAllocator(BlockPool::Arena& arena) noexcept
+        : arena{&arena}
+    {
+    }
+
+    explicit PooledAllocator(BlockPool& pool) noexcept
+        : arena{&pool.arena_for(nullptr)}
+    {
+    }
+
+    template<typename U>
+    PooledAllocator(PooledAllocator<U> const& other) noexcept
+        : arena{other.arena}
+    {
+    }
+
+    auto allocate(size_t n) -> T*
+    {
+        if (n != 1 || alignof(T) > alignof(std::max_align_t))
+            return std::allocator<T>{}.allocate(n);
+
+        return static_cast<T*>(arena->allocate(sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        if (n != 1 || alignof(T) > alignof(std::max_align_t))
+            return std::allocator<T>{}.deallocate(p, n);
+
+        arena->deallocate(p, sizeof(T));
+    }
+
+    template<typename U>
+    auto operator==(PooledAllocator<U> const& other) const noexcept -> bool
+    {
+        return arena == other.arena;
+    }
+
+private:
+    template<typename U>
+    friend class PooledAllocator;
+
+    BlockPool::Arena* arena;
+};
+
+/// Creates an object whose memory (and that of its shared_ptr control block) comes from arena
+template<typename T, typename... Args>
+auto make_pooled(BlockPool::Arena& arena, Args&&... args) -> std::shared_ptr<T>
+{
+    return std::allocate_shared<T>(PooledAllocator<T>{arena}, std::forward<Args>(args)...);
+}
+
+/// Creates an object whose memory (and that of its shared_ptr control block) comes from pool
+template<typename T, typename... Args>
+auto make_pooled(BlockPool& pool, Args&&... args) -> std::shared_ptr<T>
+{
+    return make_pooled<T>(pool.arena_for(nullptr), std::forward<Args>(args)...);
+}
+}
+
+#endif // MIR_POOLED_ALLOCATOR_H_
@@ -36,6 +36,8 @@ public:
     // Used to indicate the scene has changed in some way beyond the present surfaces
     // and will require full recomposition.
     void scene_changed() override;
+    // Used to indicate something beyond the present surfaces has changed within damage.
+    void scene_damaged(geometry::Rectangle const& damage) override;
     // Called at observer registration to notify of already existing surfaces.
     void surface_exists(std::shared_ptr<Surface> const& surface) override;
     // Called when observer is unregistered, for example, to provide a place to
@@ -17,6 +17,8 @@
 #ifndef MIR_SCENE_OBSERVER_H_
 #define MIR_SCENE_OBSERVER_H_
 
+#include "mir/geometry/forward.h"
+
 #include <memory>
 #include <set>
 
@@ -49,6 +51,11 @@ public:
     /// and will require full recomposition.
     virtual void scene_changed() = 0;
 
+    /// Used to indicate something beyond the present surfaces has changed within damage,
+    /// for example an input visualization has moved. Only outputs showing damage need
+    /// recomposition.
+    virtual void scene_damaged(geometry::Rectangle const& damage) = 0;
+
     /// Called at observer registration to notify of already existing surfaces.
     virtual void surface_exists(std::shared_ptr<Surface> const& surface) = 0;
 
@@ -39,6 +39,8 @@ struct StreamInfo
     std::shared_ptr<compositor::BufferStream> stream;
     geometry::Displacement displacement;
     optional_value<geometry::Size> size;
+    /// The parts of the stream known to be fully opaque, relative to its top-left
+    std::vector<geometry::Rectangle> opaque_region{};
 };
 
 class SurfaceObserver;
@@ -64,6 +66,9 @@ public:
     virtual geometry::Size window_size() const = 0;
 
     virtual graphics::RenderableList generate_renderables(compositor::CompositorID id) const = 0; 
+    /// The screen area the surface's streams are drawn in once clipped, or std::nullopt if it can't be
+    /// bounded (as the surface is drawn with a transformation)
+    virtual auto drawn_extent() const -> std::optional<geometry::Rectangle> = 0;
     virtual int buffers_ready_for_compositor(void const* compositor_id) const = 0;
 
     virtual MirWindowType type() const = 0;
@@ -61,6 +61,8 @@ public:
     virtual void input_consumed(Surface const* surf, std::shared_ptr<MirEvent const> const& event) = 0;
     virtual void application_id_set_to(Surface const* surf, std::string const& application_id) = 0;
     virtual void depth_layer_set_to(Surface const* surf, MirDepthLayer depth_layer) = 0;
+    /// region is relative to the surface's content, and empty if the whole content accepts input
+    virtual void input_region_set_to(Surface const* surf, std::vector<geometry::Rectangle> const& region) = 0;
 
 protected:
     SurfaceObserver() = default;
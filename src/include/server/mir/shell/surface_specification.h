@@ -49,6 +49,8 @@ struct StreamSpecification
     std::weak_ptr<frontend::BufferStream> stream;
     geometry::Displacement displacement;
     optional_value<geometry::Size> size;
+    /// The parts of the stream known to be fully opaque, relative to its top-left
+    std::vector<geometry::Rectangle> opaque_region{};
 };
 auto operator==(StreamSpecification const& lhs, StreamSpecification const& rhs) -> bool;
 
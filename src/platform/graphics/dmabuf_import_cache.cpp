@@ -0,0 +1,161 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dmabuf_import_cache.h"
+
+#include "mir/graphics/display_report.h"
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/drm_formats.h"
+#include "mir/graphics/egl_context_executor.h"
+#include "mir/graphics/egl_extensions.h"
+
+#include <algorithm>
+#include <drm_fourcc.h>
+#include <sys/stat.h>
+
+namespace mg = mir::graphics;
+
+mg::DMABufImage::DMABufImage(
+    EGLDisplay dpy,
+    std::shared_ptr<EGLExtensions> extensions,
+    EGLImageKHR image,
+    std::shared_ptr<common::EGLContextExecutor> egl_delegate)
+    : dpy{dpy},
+      extensions{std::move(extensions)},
+      image{image},
+      egl_delegate{std::move(egl_delegate)}
+{
+}
+
+mg::DMABufImage::~DMABufImage()
+{
+    std::vector<GLuint> ids;
+    for (auto const& [_, tex] : textures)
+    {
+        ids.push_back(tex);
+    }
+
+    egl_delegate->spawn(
+        [dpy = dpy, extensions = extensions, image = image, ids = std::move(ids)]()
+        {
+            if (!ids.empty())
+            {
+                glDeleteTextures(ids.size(), ids.data());
+            }
+            extensions->base(dpy).eglDestroyImageKHR(dpy, image);
+        });
+}
+
+auto mg::DMABufImage::attach_texture(GLenum target) -> GLuint
+{
+    eglBindAPI(EGL_OPENGL_ES_API);
+
+    std::unique_lock lock{mutex};
+    auto const [texture, created] = textures.try_emplace(eglGetCurrentContext(), 0);
+    if (created)
+    {
+        glGenTextures(1, &texture->second);
+    }
+    auto const tex = texture->second;
+    // Only the thread with the context current uses its texture
+    lock.unlock();
+
+    glBindTexture(target, tex);
+    extensions->base(dpy).glEGLImageTargetTexture2DOES(target, image);
+
+    if (created)
+    {
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    return tex;
+}
+
+auto mg::DMABufImportKey::for_buffer(DMABufBuffer const& dma_buf) -> std::optional<DMABufImportKey>
+{
+    DMABufImportKey key{
+        dma_buf.format(),
+        dma_buf.modifier().value_or(DRM_FORMAT_MOD_INVALID),
+        dma_buf.size().width.as_int(),
+        dma_buf.size().height.as_int(),
+        {}};
+
+    for (auto const& plane : dma_buf.planes())
+    {
+        struct stat info;
+        if (fstat(plane.dma_buf, &info) != 0)
+        {
+            return std::nullopt;
+        }
+        key.planes.push_back({info.st_dev, info.st_ino, plane.offset, plane.stride});
+    }
+    return key;
+}
+
+mg::DMABufImportCache::DMABufImportCache(Importer import, Holder hold, std::shared_ptr<DisplayReport> report)
+    : import{std::move(import)},
+      hold{std::move(hold)},
+      report{std::move(report)}
+{
+}
+
+auto mg::DMABufImportCache::image_for(DMABufBuffer const& dma_buf) -> std::shared_ptr<DMABufImage>
+{
+    auto key = DMABufImportKey::for_buffer(dma_buf);
+
+    if (key)
+    {
+        std::unique_lock lock{mutex};
+        if (auto const cached = images.find(*key); cached != images.end())
+        {
+            if (auto image = cached->second.lock())
+            {
+                lock.unlock();
+                ++reuses;
+                report->report_dmabuf_import(dma_buf.size(), dma_buf.planes().size(), true);
+                hold(dma_buf, image);
+                return image;
+            }
+        }
+    }
+
+    auto image = import(dma_buf);
+    ++imports;
+    report->report_dmabuf_import(dma_buf.size(), dma_buf.planes().size(), false);
+
+    if (key)
+    {
+        std::lock_guard lock{mutex};
+        std::erase_if(images, [](auto const& entry) { return entry.second.expired(); });
+        images.insert_or_assign(std::move(*key), image);
+    }
+
+    hold(dma_buf, image);
+    return image;
+}
+
+auto mg::DMABufImportCache::metrics() const -> Metrics
+{
+    std::lock_guard lock{mutex};
+    auto const live = std::count_if(
+        images.begin(),
+        images.end(),
+        [](auto const& entry) { return !entry.second.expired(); });
+
+    return {imports.load(), reuses.load(), static_cast<size_t>(live)};
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_DMABUF_IMPORT_CACHE_H_
+#define MIR_GRAPHICS_DMABUF_IMPORT_CACHE_H_
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace mir::graphics
+{
+namespace common
+{
+class EGLContextExecutor;
+}
+class DMABufBuffer;
+class DisplayReport;
+struct EGLExtensions;
+
+/**
+ * A dma-buf imported as an EGLImage, and the GL textures it backs
+ *
+ * Importing needs no GL context, but creating a texture does, so each texture is
+ * created when it is first needed. Each context gets a texture of its own: the
+ * compositors for different outputs may attach the image at the same time, and a
+ * texture shared between them would be respecified under the other's feet.
+ */
+class DMABufImage
+{
+public:
+    DMABufImage(
+        EGLDisplay dpy,
+        std::shared_ptr<EGLExtensions> extensions,
+        EGLImageKHR image,
+        std::shared_ptr<common::EGLContextExecutor> egl_delegate);
+
+    ~DMABufImage();
+
+    DMABufImage(DMABufImage const&) = delete;
+    DMABufImage& operator=(DMABufImage const&) = delete;
+
+    /**
+     * The current context's texture backed by this image, (re)attached to it
+     *
+     * Attaching the image again each time the client commits the buffer ensures the
+     * driver picks up the client's new contents; it doesn't copy or reallocate anything.
+     * The texture is left bound to target.
+     *
+     * \note    Must be called with a current GL context
+     */
+    auto attach_texture(GLenum target) -> GLuint;
+
+private:
+    EGLDisplay const dpy;
+    std::shared_ptr<EGLExtensions> const extensions;
+    EGLImageKHR const image;
+    std::shared_ptr<common::EGLContextExecutor> const egl_delegate;
+
+    std::mutex mutex;
+    std::map<EGLContext, GLuint> textures;
+};
+
+/**
+ * Identifies the memory a dma-buf import refers to
+ *
+ * Each dma-buf has its own inode, so this matches imports of the same buffers however
+ * the client came by its fds (and whichever wl_buffer it sent them in).
+ */
+struct DMABufImportKey
+{
+    struct Plane
+    {
+        dev_t device;
+        ino_t inode;
+        uint32_t offset;
+        uint32_t stride;
+
+        auto operator<=>(Plane const&) const = default;
+    };
+
+    uint32_t format;
+    uint64_t modifier;
+    int width;
+    int height;
+    std::vector<Plane> planes;
+
+    auto operator<=>(DMABufImportKey const&) const = default;
+
+    /// \return The key for dma_buf's memory, or nothing if any of its fds can't be queried
+    static auto for_buffer(DMABufBuffer const& dma_buf) -> std::optional<DMABufImportKey>;
+};
+
+/**
+ * Live imports of client dma-bufs, by the memory they import
+ *
+ * Clients cycle through a small swapchain of the same few buffers, so without this we'd
+ * import the same memory again on every commit. The cache doesn't own the imports: each
+ * is kept alive by whatever the holder attaches it to (the client's wl_buffer), and by
+ * any frame still using it.
+ */
+class DMABufImportCache
+{
+public:
+    using Importer = std::function<std::shared_ptr<DMABufImage>(DMABufBuffer const&)>;
+    using Holder = std::function<void(DMABufBuffer const&, std::shared_ptr<DMABufImage> const&)>;
+
+    struct Metrics
+    {
+        uint64_t imports;
+        uint64_t reuses;
+        size_t live;
+    };
+
+    DMABufImportCache(Importer import, Holder hold, std::shared_ptr<DisplayReport> report);
+
+    /**
+     * The import of dma_buf's memory, importing it if there's no live import already
+     *
+     * \throws  Whatever the importer throws if the import fails.
+     */
+    auto image_for(DMABufBuffer const& dma_buf) -> std::shared_ptr<DMABufImage>;
+
+    auto metrics() const -> Metrics;
+
+private:
+    Importer const import;
+    Holder const hold;
+    std::shared_ptr<DisplayReport> const report;
+
+    std::mutex mutable mutex;
+    std::map<DMABufImportKey, std::weak_ptr<DMABufImage>> images;
+    std::atomic<uint64_t> imports{0};
+    std::atomic<uint64_t> reuses{0};
+};
+}
+
+#endif /* MIR_GRAPHICS_DMABUF_IMPORT_CACHE_H_ */
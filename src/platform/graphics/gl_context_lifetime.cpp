@@ -0,0 +1,61 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/graphics/gl_context_lifetime.h"
+
+#include <utility>
+
+namespace mgl = mir::graphics::gl;
+
+namespace
+{
+thread_local std::shared_ptr<mgl::ContextLifetime> current_lifetime;
+}
+
+mgl::ContextLifetime::Current::Current(std::shared_ptr<ContextLifetime> const& lifetime)
+    : previous{std::exchange(current_lifetime, lifetime)}
+{
+}
+
+mgl::ContextLifetime::Current::~Current()
+{
+    current_lifetime = previous;
+}
+
+auto mgl::ContextLifetime::current() -> std::shared_ptr<ContextLifetime>
+{
+    return current_lifetime;
+}
+
+void mgl::ContextLifetime::delete_texture_later(GLuint tex)
+{
+    std::lock_guard lock{mutex};
+    pending_textures.push_back(tex);
+}
+
+void mgl::ContextLifetime::delete_pending()
+{
+    std::vector<GLuint> textures;
+    {
+        std::lock_guard lock{mutex};
+        textures.swap(pending_textures);
+    }
+
+    if (!textures.empty())
+    {
+        glDeleteTextures(textures.size(), textures.data());
+    }
+}
@@ -18,6 +18,7 @@
 #include "mir/fd.h"
 #include "mir/graphics/drm_formats.h"
 #include "egl_buffer_copy.h"
+#include "dmabuf_import_cache.h"
 
 #include "wayland_wrapper.h"
 #include "mir/wayland/protocol_error.h"
@@ -30,15 +31,21 @@
 #include "mir/graphics/buffer_basic.h"
 #include "mir/graphics/dmabuf_buffer.h"
 #include "mir/graphics/egl_context_executor.h"
+#include "mir/graphics/platform.h"
+#include "mir/renderer/gl/gl_surface.h"
 
 #include <EGL/egl.h>
 #include <cstdint>
 #include <cstring>
+#include <functional>
 #include <stdexcept>
+#include <string>
 
 #define MIR_LOG_COMPONENT "linux-dmabuf-import"
 #include "mir/log.h"
 
+#include <algorithm>
+#include <map>
 #include <mutex>
 #include <vector>
 #include <optional>
@@ -395,10 +402,10 @@ auto export_egl_image(
 }
 
 /**
- * Reimport dmabufs into EGL
+ * Import dmabufs into EGL
  *
- * This is necessary to call each time the buffer is re-submitted by the client,
- * to ensure any state is properly synchronised.
+ * Imports of client buffers are cached (see DMABufImportCache); it is
+ * re-attaching the image to a texture on each commit that synchronises any state.
  *
  * \return  An EGLImageKHR handle to the imported
  * \throws  A std::system_error containing the EGL error on failure.
@@ -573,12 +580,25 @@ public:
     {
         return planes_;
     }
+
+    /**
+     * Keeps image alive for as long as the client's wl_buffer exists
+     *
+     * Each importer (one per GPU) keeps its own import, replacing any it held before.
+     */
+    void hold_import(void const* importer, std::shared_ptr<mg::DMABufImage> const& image) const
+    {
+        std::lock_guard lock{imports_mutex};
+        imports[importer] = image;
+    }
 private:
     int32_t const width, height;
     mg::DRMFormat const format_;
     uint32_t const flags;
     std::optional<uint64_t> const modifier_;
     std::vector<PlaneInfo> const planes_;
+    std::mutex mutable imports_mutex;
+    std::map<void const*, std::shared_ptr<mg::DMABufImage>> mutable imports;
 };
 
 class LinuxDmaBufParams : public mir::wayland::LinuxBufferParamsV1
@@ -765,8 +785,8 @@ private:
                 modifier.value(),
                 {planes.cbegin(), last_valid_plane}};
 
-            // We don't need to keep it around, but we do need to ensure that we *can* create a Buffer
-            // from this dma-buf
+            // Ensure that we *can* create a Buffer from this dma-buf; the import is kept
+            // with the wl_buffer for its first commit
             provider->validate_import(*dma_buf);
             send_created_event(buffer_resource);
         }
@@ -808,8 +828,8 @@ private:
                 flags,
                 modifier.value(),
                 {planes.cbegin(), last_valid_plane}};
-            // We don't need to keep it around, but we do need to ensure that we *can* create a Buffer
-            // from this dma-buf
+            // Ensure that we *can* create a Buffer from this dma-buf; the import is kept
+            // with the wl_buffer for its first commit
             provider->validate_import(*dma_buf);
         }
         catch (std::system_error const& err)
@@ -835,60 +855,17 @@ private:
     }
 };
 
-GLuint get_tex_id()
-{
-    GLuint tex;
-    glGenTextures(1, &tex);
-    return tex;
-}
-
 class DMABufTex : public mg::gl::Texture
 {
 public:
     DMABufTex(
-        EGLDisplay dpy,
-        mg::EGLExtensions const& extensions,
+        std::shared_ptr<mg::DMABufImage> image,
         mg::DMABufBuffer const& dma_buf,
-        BufferGLDescription const& descriptor,
-        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate)
-        : tex{get_tex_id()},
+        BufferGLDescription const& descriptor)
+        : image{std::move(image)},
           desc{descriptor},
-          layout_{dma_buf.layout()},
-          egl_delegate{std::move(egl_delegate)}
-    {
-        eglBindAPI(EGL_OPENGL_ES_API);
-
-        auto const target = descriptor.target;
-
-        EGLImage image = import_egl_image(
-            dma_buf.size().width.as_int(),
-            dma_buf.size().height.as_int(),
-            dma_buf.format(),
-            dma_buf.modifier(),
-            dma_buf.planes(),
-            dpy,
-            extensions);
-
-        glBindTexture(target, tex);
-        extensions.base(dpy).glEGLImageTargetTexture2DOES(target, image);
-
-        // tex is now an EGLImage sibling, so we can free the EGLImage without
-        // freeing the backing data.
-        extensions.base(dpy).eglDestroyImageKHR(dpy, image);
-
-        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    }
-
-    ~DMABufTex() override
+          layout_{dma_buf.layout()}
     {
-        egl_delegate->spawn(
-            [tex = tex]()
-            {
-                glDeleteTextures(1, &tex);
-            });
     }
 
     mg::gl::Program const& shader(mg::gl::ProgramFactory& cache) const override
@@ -910,17 +887,29 @@ public:
 
     void bind() override
     {
-        glBindTexture(desc.target, tex);
+        // The first bind in each context attaches this commit's contents to that context's texture
+        std::lock_guard lock{mutex};
+        auto const [texture, first_bind] = attached.try_emplace(eglGetCurrentContext(), 0);
+        if (first_bind)
+        {
+            texture->second = image->attach_texture(desc.target);
+        }
+        else
+        {
+            glBindTexture(desc.target, texture->second);
+        }
     }
 
     void add_syncpoint() override
     {
     }
 private:
-    GLuint const tex;
+    std::shared_ptr<mg::DMABufImage> const image;
     BufferGLDescription const& desc;
     Layout const layout_;
-    std::shared_ptr<mgc::EGLContextExecutor> const egl_delegate;
+
+    std::mutex mutex;
+    std::map<EGLContext, GLuint> attached;
 };
 
 class DmabufTexBuffer :
@@ -928,18 +917,16 @@ class DmabufTexBuffer :
     public mg::DMABufBuffer
 {
 public:
-    // Note: Must be called with a current EGL context
     DmabufTexBuffer(
         EGLDisplay dpy,
-        mg::EGLExtensions const& extensions,
+        std::shared_ptr<mg::DMABufImage> image,
         mg::DMABufBuffer const& dma_buf,
         BufferGLDescription const& descriptor,
         std::shared_ptr<mg::DMABufEGLProvider> provider,
-        std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release)
         : dpy{dpy},
-          tex{dpy, extensions, dma_buf, descriptor, std::move(egl_delegate)},
+          tex{std::move(image), dma_buf, descriptor},
           provider_{std::move(provider)},
           on_consumed{std::move(on_consumed)},
           on_release{std::move(on_release)},
@@ -1046,6 +1033,188 @@ private:
 
 }
 
+namespace
+{
+class TargetFramebuffer : public mg::Framebuffer
+{
+public:
+    explicit TargetFramebuffer(geom::Size size)
+        : size_{size}
+    {
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return size_;
+    }
+
+private:
+    geom::Size const size_;
+};
+
+/**
+ * Renders each frame straight into the dma-buf the allocator supplies for it
+ *
+ * The target's import is bound as the colour attachment of our FBO, so nothing is copied.
+ */
+class DMABufTargetSurface : public mg::gl::OutputSurface
+{
+public:
+    using Importer = std::function<std::shared_ptr<mg::DMABufImage>(mg::DMABufBuffer const&)>;
+
+    DMABufTargetSurface(
+        EGLDisplay dpy,
+        EGLContext share_ctx,
+        mg::DMABufEGLProvider const& provider,
+        mg::DMABufTargetAllocator& allocator,
+        Importer import)
+        : dpy{dpy},
+          ctx{create_context(dpy, share_ctx)},
+          provider{provider},
+          allocator{allocator},
+          import{std::move(import)}
+    {
+        make_current();
+        glGenFramebuffers(1, &fbo);
+    }
+
+    ~DMABufTargetSurface() override
+    {
+        make_current();
+        glDeleteFramebuffers(1, &fbo);
+        release_current();
+        eglDestroyContext(dpy, ctx);
+    }
+
+    void bind() override
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        if (target)
+        {
+            return;
+        }
+
+        target = allocator.claim_target();
+        if (!target)
+        {
+            BOOST_THROW_EXCEPTION((std::logic_error{"Attempted to render without a dma-buf target"}));
+        }
+
+        auto const descriptor = descriptor_for_format_and_modifiers(
+            target->format(),
+            target->modifier().value_or(DRM_FORMAT_MOD_INVALID),
+            provider);
+        if (!descriptor || descriptor->target != GL_TEXTURE_2D)
+        {
+            auto const format = target->format();
+            target.reset();
+            BOOST_THROW_EXCEPTION((std::runtime_error{
+                std::string{"Cannot render into dma-buf of format "} + format.name()}));
+        }
+
+        image = import(*target);
+        glFramebufferTexture2D(
+            GL_FRAMEBUFFER,
+            GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_2D,
+            image->attach_texture(GL_TEXTURE_2D),
+            0);
+        // attach_texture() leaves the texture bound, and we may be asked to draw from texture unit 0
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        if (auto const status = glCheckFramebufferStatus(GL_FRAMEBUFFER); status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            target.reset();
+            image.reset();
+            BOOST_THROW_EXCEPTION((std::runtime_error{
+                "Cannot render into dma-buf: FBO status " + std::to_string(status)}));
+        }
+    }
+
+    void make_current() override
+    {
+        if (eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx) != EGL_TRUE)
+        {
+            mir::log_debug("Failed to make EGL context current");
+        }
+    }
+
+    void release_current() override
+    {
+        if (eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT) != EGL_TRUE)
+        {
+            mir::log_debug("Failed to release current EGL context");
+        }
+    }
+
+    auto buffer_age() const -> int override
+    {
+        // Each frame may go to a different buffer, and we don't know what it holds
+        return 0;
+    }
+
+    void set_damage(geom::Rectangles const&) override
+    {
+    }
+
+    auto commit() -> std::unique_ptr<mg::Framebuffer> override
+    {
+        // Whoever gave us the target will hand it on as soon as we return
+        glFinish();
+
+        auto const committed_size = target ? target->size() : size();
+        target.reset();
+        image.reset();
+        return std::make_unique<TargetFramebuffer>(committed_size);
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return allocator.output_size();
+    }
+
+    auto layout() const -> Layout override
+    {
+        // As for CPU-copied buffers, so that consumers can treat both the same
+        return Layout::TopRowFirst;
+    }
+
+private:
+    static auto create_context(EGLDisplay dpy, EGLContext share_ctx) -> EGLContext
+    {
+        static EGLint const context_attr[] = {
+            EGL_CONTEXT_CLIENT_VERSION, 2,
+            EGL_NONE
+        };
+
+        if (!strstr(eglQueryString(dpy, EGL_EXTENSIONS), "EGL_KHR_no_config_context"))
+        {
+            BOOST_THROW_EXCEPTION((std::runtime_error{
+                "EGL implementation missing necessary EGL_KHR_no_config_context extension"}));
+        }
+
+        eglBindAPI(EGL_OPENGL_ES_API);
+        auto const ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, share_ctx, context_attr);
+        if (ctx == EGL_NO_CONTEXT)
+        {
+            BOOST_THROW_EXCEPTION(mg::egl_error("Failed to create EGL context for rendering into dma-bufs"));
+        }
+        return ctx;
+    }
+
+    EGLDisplay const dpy;
+    EGLContext const ctx;
+    mg::DMABufEGLProvider const& provider;
+    mg::DMABufTargetAllocator& allocator;
+    Importer const import;
+
+    GLuint fbo{0};
+    /// The frame being drawn: claimed by bind(), handed back by commit()
+    std::shared_ptr<mg::DMABufBuffer> target;
+    std::shared_ptr<mg::DMABufImage> image;
+};
+}
+
 class mg::LinuxDmaBufUnstable::Instance : public mir::wayland::LinuxDmabufV1
 {
 public:
@@ -1115,14 +1284,39 @@ mg::DMABufEGLProvider::DMABufEGLProvider(
     std::shared_ptr<EGLExtensions> egl_extensions,
     mg::EGLExtensions::EXTImageDmaBufImportModifiers const& dmabuf_ext,
     std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
-    EGLImageAllocator allocate_importable_image)
+    EGLImageAllocator allocate_importable_image,
+    std::shared_ptr<DisplayReport> report)
     : dpy{dpy},
       egl_extensions{std::move(egl_extensions)},
       dmabuf_export_ext{mg::EGLExtensions::MESADmaBufExport::extension_if_supported(dpy)},
       formats{std::make_unique<DmaBufFormatDescriptors>(dpy, dmabuf_ext)},
       egl_delegate{std::move(egl_delegate)},
       allocate_importable_image{std::move(allocate_importable_image)},
-      blitter{std::make_unique<mg::EGLBufferCopier>(this->egl_delegate)}
+      blitter{std::make_unique<mg::EGLBufferCopier>(this->egl_delegate)},
+      import_cache{std::make_unique<DMABufImportCache>(
+          [this](DMABufBuffer const& dma_buf)
+          {
+              return std::make_shared<DMABufImage>(
+                  this->dpy,
+                  this->egl_extensions,
+                  import_egl_image(
+                      dma_buf.size().width.as_int(),
+                      dma_buf.size().height.as_int(),
+                      dma_buf.format(),
+                      dma_buf.modifier(),
+                      dma_buf.planes(),
+                      this->dpy,
+                      *this->egl_extensions),
+                  this->egl_delegate);
+          },
+          [this](DMABufBuffer const& dma_buf, std::shared_ptr<DMABufImage> const& image)
+          {
+              if (auto const client_buffer = dynamic_cast<WlDmaBufBuffer const*>(&dma_buf))
+              {
+                  client_buffer->hold_import(this, image);
+              }
+          },
+          std::move(report))}
 {
 }
 
@@ -1133,6 +1327,26 @@ auto mg::DMABufEGLProvider::supported_formats() const -> mg::DmaBufFormatDescrip
     return *formats;
 }
 
+auto mg::DMABufEGLProvider::import_metrics() const -> ImportMetrics
+{
+    auto const [imports, reuses, live] = import_cache->metrics();
+    return {imports, reuses, live};
+}
+
+auto mg::DMABufEGLProvider::surface_for(DMABufTargetAllocator& allocator, EGLContext share_ctx)
+    -> std::unique_ptr<gl::OutputSurface>
+{
+    return std::make_unique<DMABufTargetSurface>(
+        dpy,
+        share_ctx,
+        *this,
+        allocator,
+        [this](DMABufBuffer const& target)
+        {
+            return import_cache->image_for(target);
+        });
+}
+
 auto mg::DMABufEGLProvider::import_dma_buf(
     mg::DMABufBuffer const& dma_buf,
     std::function<void()>&& on_consumed,
@@ -1145,29 +1359,18 @@ auto mg::DMABufEGLProvider::import_dma_buf(
         *this);
     return std::make_shared<DmabufTexBuffer>(
         dpy,
-        *egl_extensions,
+        import_cache->image_for(dma_buf),
         dma_buf,
         *descriptor,
         shared_from_this(),
-        egl_delegate,
         std::move(on_consumed),
         std::move(on_release));
 }
 
 void mg::DMABufEGLProvider::validate_import(DMABufBuffer const& dma_buf)
 {
-    auto image = import_egl_image(
-        dma_buf.size().width.as_int(), dma_buf.size().height.as_int(),
-        dma_buf.format(),
-        dma_buf.modifier(),
-        dma_buf.planes(),
-        dpy,
-        *egl_extensions);
-    if (image != EGL_NO_IMAGE_KHR)
-    {
-        // We can throw this image away immediately
-        egl_extensions->base(dpy).eglDestroyImageKHR(dpy, image);
-    }
+    // The import is kept, ready for the client's first commit of the buffer
+    import_cache->image_for(dma_buf);
 }
 
 auto mg::DMABufEGLProvider::as_texture(std::shared_ptr<Buffer> buffer)
@@ -1190,11 +1393,9 @@ auto mg::DMABufEGLProvider::as_texture(std::shared_ptr<Buffer> buffer)
              */
             dmabuf_tex->as_texture();
             return std::make_shared<DMABufTex>(
-                dpy,
-                *egl_extensions,
+                import_cache->image_for(*dmabuf_tex),
                 *dmabuf_tex,
-                *descriptor,
-                egl_delegate);
+                *descriptor);
         }
         else
         {
@@ -1274,11 +1475,9 @@ auto mg::DMABufEGLProvider::as_texture(std::shared_ptr<Buffer> buffer)
                  */
                 dmabuf_tex->as_texture();
                 return std::make_shared<DMABufTex>(
-                    dpy,
-                    *egl_extensions,
+                    import_cache->image_for(*importable_dmabuf),
                     *importable_dmabuf,
-                    *descriptor,
-                    egl_delegate);
+                    *descriptor);
             }
 
             /* To get here we have to have failed to find the format/modifier descriptor for a
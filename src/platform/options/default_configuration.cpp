@@ -44,6 +44,9 @@ char const* const mo::wayland_extensions_opt      = "wayland-extensions";
 char const* const mo::add_wayland_extensions_opt  = "add-wayland-extensions";
 char const* const mo::drop_wayland_extensions_opt = "drop-wayland-extensions";
 char const* const mo::idle_timeout_opt            = "idle-timeout";
+char const* const mo::capture_composited_frames_opt = "capture-composited-frames";
+char const* const mo::coalesce_pointer_motion_opt = "coalesce-pointer-motion";
+char const* const mo::input_thread_priority_opt = "input-thread-priority";
 
 char const* const mo::off_opt_value = "off";
 char const* const mo::log_opt_value = "log";
@@ -179,6 +182,15 @@ mo::DefaultConfiguration::DefaultConfiguration(
         (idle_timeout_opt, po::value<int>()->default_value(0),
             "Time (in seconds) Mir will remain idle before turning off the display, "
             "or 0 to keep display on forever.")
+        (capture_composited_frames_opt, po::value<bool>()->default_value(false),
+            "Take screenshots of an output from the frames composited for it, instead of "
+            "rendering the scene again. This costs a copy of every composited frame.")
+        (coalesce_pointer_motion_opt, po::value<bool>()->default_value(false),
+            "Merge pointer motion that arrives while earlier motion is still waiting to be "
+            "sent to a Wayland client. Clients using relative pointer still get every motion.")
+        (input_thread_priority_opt, po::value<std::string>()->default_value("default"),
+            "Scheduling of the thread reading input devices [{default,nice:<value>,realtime:<priority>}]. "
+            "realtime (SCHED_FIFO) needs CAP_SYS_NICE or an RLIMIT_RTPRIO.")
         (fatal_except_opt, "On \"fatal error\" conditions [e.g. drivers behaving "
             "in unexpected ways] throw an exception (instead of a core dump)")
         (debug_opt, "Enable extra development debugging. "
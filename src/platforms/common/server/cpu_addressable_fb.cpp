@@ -266,6 +266,8 @@ mg::CPUAddressableFB::CPUAddressableFB(
     DRMFormat format,
     std::unique_ptr<Buffer> buffer)
     : drm_fd{std::move(drm_fd)},
+      supports_modifiers{supports_modifiers},
+      drm_format{format},
       fb_id{fb_id_for_buffer(this->drm_fd, supports_modifiers, format, *buffer)},
       buffer{std::move(buffer)}
 {
@@ -296,6 +298,17 @@ mg::CPUAddressableFB::operator uint32_t() const
     return fb_id;
 }
 
+auto mg::CPUAddressableFB::drm_fourcc() const -> uint32_t
+{
+    return drm_format;
+}
+
+auto mg::CPUAddressableFB::modifier() const -> uint64_t
+{
+    // Dumb buffers are always linear, but we only say so when we were able to tell KMS
+    return supports_modifiers ? DRM_FORMAT_MOD_LINEAR : DRM_FORMAT_MOD_INVALID;
+}
+
 auto mg::CPUAddressableFB::fb_id_for_buffer(
     mir::Fd const &drm_fd,
     bool supports_modifiers,
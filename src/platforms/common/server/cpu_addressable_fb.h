@@ -41,7 +41,9 @@ public:
     auto size() const -> geometry::Size override; 
 
     operator uint32_t() const override;
-    
+    auto drm_fourcc() const -> uint32_t override;
+    auto modifier() const -> uint64_t override;
+
     CPUAddressableFB(CPUAddressableFB const&) = delete;
     CPUAddressableFB& operator=(CPUAddressableFB const&) = delete;
 private:
@@ -59,6 +61,8 @@ private:
         Buffer const& buf) -> uint32_t;
 
     mir::Fd const drm_fd;
+    bool const supports_modifiers;
+    DRMFormat const drm_format;
     uint32_t const fb_id;
     std::unique_ptr<Buffer> const buffer;
 };
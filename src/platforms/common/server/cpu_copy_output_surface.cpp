@@ -22,6 +22,10 @@
 
 #include <drm_fourcc.h>
 
+#include <cstring>
+#include <optional>
+#include <vector>
+
 #include "mir/graphics/egl_error.h"
 #include "mir/graphics/platform.h"
 #include "mir/log.h"
@@ -134,6 +138,10 @@ public:
     void make_current();
     void release_current();
 
+    auto buffer_age() const -> int;
+
+    void set_damage(geom::Rectangles const& damage);
+
     auto commit() -> std::unique_ptr<mg::Framebuffer>;
 
     auto size() const -> geom::Size;
@@ -146,6 +154,11 @@ private:
     DRMFormat const format;
     RenderbufferHandle const colour_buffer;
     FramebufferHandle const fbo;
+    bool has_committed{false};
+    /// What the next commit() changes, if it isn't everything
+    std::optional<geom::Rectangles> damage;
+    /// Scratch space for reading back damage narrower than the framebuffer
+    std::vector<unsigned char> readback;
 };
 
 mgc::CPUCopyOutputSurface::CPUCopyOutputSurface(
@@ -173,6 +186,16 @@ void mgc::CPUCopyOutputSurface::release_current()
     impl->release_current();
 }
 
+auto mgc::CPUCopyOutputSurface::buffer_age() const -> int
+{
+    return impl->buffer_age();
+}
+
+void mgc::CPUCopyOutputSurface::set_damage(geom::Rectangles const& damage)
+{
+    impl->set_damage(damage);
+}
+
 auto mgc::CPUCopyOutputSurface::commit() -> std::unique_ptr<mg::Framebuffer>
 {
     return impl->commit();
@@ -257,6 +280,17 @@ void mgc::CPUCopyOutputSurface::Impl::release_current()
     }
 }
 
+auto mgc::CPUCopyOutputSurface::Impl::buffer_age() const -> int
+{
+    // We always render into the same colour buffer, so it holds the last committed frame
+    return has_committed ? 1 : 0;
+}
+
+void mgc::CPUCopyOutputSurface::Impl::set_damage(geom::Rectangles const& damage)
+{
+    this->damage = damage;
+}
+
 auto mgc::CPUCopyOutputSurface::Impl::commit() -> std::unique_ptr<mg::Framebuffer>
 {
     auto fb = allocator.alloc_fb(format);
@@ -281,11 +315,56 @@ auto mgc::CPUCopyOutputSurface::Impl::commit() -> std::unique_ptr<mg::Framebuffe
         /*
          * TODO: We are assuming that the framebuffer pixel format is RGBX
          */
-        glReadPixels(
-            0, 0,
-            fb->size().width.as_uint32_t(), fb->size().height.as_uint32_t(),
-            pixel_layout, GL_UNSIGNED_BYTE, mapping->data());
+        if (damage && allocator.holds_previous_frame())
+        {
+            // Our layout is TopRowFirst, so GL window coordinates are also the buffer's rows and columns
+            auto const stride = mapping->stride().as_int();
+            auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(mapping->format());
+            for (auto const& rect : *damage)
+            {
+                auto const area = intersection_of(rect, geom::Rectangle{{0, 0}, fb->size()});
+                if (area.size.width == geom::Width{0} || area.size.height == geom::Height{0})
+                {
+                    continue;
+                }
+
+                auto const row_bytes = area.size.width.as_int() * bytes_per_pixel;
+                auto const first_byte = mapping->data() +
+                    area.top().as_int() * stride +
+                    area.left().as_int() * bytes_per_pixel;
+
+                if (row_bytes == stride)
+                {
+                    glReadPixels(
+                        area.left().as_int(), area.top().as_int(),
+                        area.size.width.as_int(), area.size.height.as_int(),
+                        pixel_layout, GL_UNSIGNED_BYTE, first_byte);
+                }
+                else
+                {
+                    // GLES2 can't read into a row stride other than the rectangle's own
+                    readback.resize(row_bytes * area.size.height.as_int());
+                    glReadPixels(
+                        area.left().as_int(), area.top().as_int(),
+                        area.size.width.as_int(), area.size.height.as_int(),
+                        pixel_layout, GL_UNSIGNED_BYTE, readback.data());
+                    for (auto row = 0; row < area.size.height.as_int(); ++row)
+                    {
+                        memcpy(first_byte + row * stride, readback.data() + row * row_bytes, row_bytes);
+                    }
+                }
+            }
+        }
+        else
+        {
+            glReadPixels(
+                0, 0,
+                fb->size().width.as_uint32_t(), fb->size().height.as_uint32_t(),
+                pixel_layout, GL_UNSIGNED_BYTE, mapping->data());
+        }
     }
+    damage.reset();
+    has_committed = true;
     return fb;
 }
 
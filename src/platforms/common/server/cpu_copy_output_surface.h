@@ -45,6 +45,10 @@ public:
 
     void release_current() override;
 
+    auto buffer_age() const -> int override;
+
+    void set_damage(geometry::Rectangles const& damage) override;
+
     auto commit() -> std::unique_ptr<Framebuffer> override;
 
     auto size() const -> geometry::Size override;
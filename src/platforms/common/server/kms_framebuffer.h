@@ -29,6 +29,15 @@ public:
     virtual ~FBHandle() = default;
 
     virtual operator uint32_t() const = 0;
+
+    /// The DRM fourcc of the framebuffer's pixels
+    virtual auto drm_fourcc() const -> uint32_t = 0;
+    /**
+     * The DRM format modifier the framebuffer was created with
+     *
+     * DRM_FORMAT_MOD_INVALID if it was created without one, leaving the layout to the driver
+     */
+    virtual auto modifier() const -> uint64_t = 0;
 };
 
 }
@@ -20,6 +20,7 @@
 #include "mir/graphics/program_factory.h"
 #include "mir/graphics/program.h"
 #include "mir/graphics/egl_context_executor.h"
+#include "mir/geometry/region.h"
 
 #define MIR_LOG_COMPONENT "gfx-common"
 #include "mir/log.h"
@@ -29,14 +30,63 @@
 
 #include <boost/throw_exception.hpp>
 
+#include <algorithm>
+#include <cstdio>
 #include <string.h>
 #include <endian.h>
+#include <vector>
 
 namespace mg=mir::graphics;
 namespace mgc = mir::graphics::common;
 namespace geom = mir::geometry;
 namespace mrs = mir::renderer::software;
 
+namespace
+{
+/// Damage older than this many unbound buffers is forgotten, forcing a full upload
+auto const max_recent_damage = 16u;
+
+void set_texture_parameters()
+{
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+/// Whether GL_UNPACK_ROW_LENGTH is available, letting GL read rows out of a larger image
+bool supports_unpack_row_length()
+{
+    auto const version = reinterpret_cast<char const*>(glGetString(GL_VERSION));
+    int major{0};
+    if (version && sscanf(version, "OpenGL ES %d.", &major) == 1 && major >= 3)
+    {
+        return true;
+    }
+
+    auto const extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+    return extensions && strstr(extensions, "GL_EXT_unpack_subimage");
+}
+
+/// Copy \a rect of an image out into tightly-packed rows, for GL implementations without GL_UNPACK_ROW_LENGTH
+void pack_rows(
+    unsigned char const* pixels,
+    geom::Stride const& stride,
+    size_t bytes_per_pixel,
+    geom::Rectangle const& rect,
+    std::vector<unsigned char>& packed)
+{
+    auto const row_bytes = rect.size.width.as_uint32_t() * bytes_per_pixel;
+    packed.resize(row_bytes * rect.size.height.as_uint32_t());
+
+    auto const* row = pixels + rect.top().as_int() * stride.as_int() + rect.left().as_int() * bytes_per_pixel;
+    for (auto out = packed.begin(); out != packed.end(); out += row_bytes, row += stride.as_int())
+    {
+        std::copy(row, row + row_bytes, out);
+    }
+}
+}
+
 bool mg::get_gl_pixel_format(MirPixelFormat mir_format,
                          GLenum& gl_format, GLenum& gl_type)
 {
@@ -133,14 +183,14 @@ MirPixelFormat mgc::ShmBuffer::pixel_format() const
     return pixel_format_;
 }
 
-void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& stride)
+void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& stride, bool unpack_row_length)
 {
     GLenum format, type;
 
     if (mg::get_gl_pixel_format(pixel_format_, format, type))
     {
-        auto const stride_in_px =
-            stride.as_int() / MIR_BYTES_PER_PIXEL(pixel_format());
+        auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(pixel_format());
+        auto const stride_in_px = stride.as_int() / bytes_per_pixel;
         /*
          * We assume (as does Weston, AFAICT) that stride is
          * a multiple of whole pixels, but it need not be.
@@ -150,7 +200,17 @@ void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& s
          * to match the size of the partial-pixel-stride().
          */
 
-        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride_in_px);
+        std::vector<unsigned char> packed;
+        bool const padded_rows = stride_in_px != size().width.as_int();
+        if (padded_rows && !unpack_row_length)
+        {
+            pack_rows(static_cast<unsigned char const*>(pixels), stride, bytes_per_pixel, {{}, size()}, packed);
+            pixels = packed.data();
+        }
+        else
+        {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride_in_px);
+        }
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
         glTexImage2D(
@@ -164,7 +224,10 @@ void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& s
             pixels);
 
         // Be nice to other users of the GL context by reverting our changes to shared state
-        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);     // 0 is default, meaning “use width”
+        if (packed.empty())
+        {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0); // 0 is default, meaning “use width”
+        }
         glPixelStorei(GL_UNPACK_ALIGNMENT, 4);          // 4 is default; word alignment.
         glFinish();
     }
@@ -177,6 +240,69 @@ void mgc::ShmBuffer::upload_to_texture(void const* pixels, geom::Stride const& s
     }
 }
 
+void mgc::ShmBuffer::upload_to_texture(
+    void const* pixels,
+    geom::Stride const& stride,
+    geom::Rectangles const& damage,
+    bool unpack_row_length)
+{
+    GLenum format, type;
+
+    if (!mg::get_gl_pixel_format(pixel_format_, format, type))
+    {
+        mir::log_error(
+            "Buffer %i has non-GL-compatible pixel format %i; rendering will be incomplete",
+            id().as_value(),
+            pixel_format());
+        return;
+    }
+
+    auto const bytes_per_pixel = MIR_BYTES_PER_PIXEL(pixel_format());
+    auto const* const image = static_cast<unsigned char const*>(pixels);
+
+    // Overlapping damage would otherwise be uploaded more than once
+    geom::Region to_upload{damage};
+    to_upload.intersect(geom::Rectangle{{}, size()});
+
+    if (unpack_row_length)
+    {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride.as_int() / bytes_per_pixel);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    std::vector<unsigned char> packed;
+    for (auto const& rect : to_upload.rectangles())
+    {
+        void const* source;
+        if (unpack_row_length)
+        {
+            source = image + rect.top().as_int() * stride.as_int() + rect.left().as_int() * bytes_per_pixel;
+        }
+        else
+        {
+            pack_rows(image, stride, bytes_per_pixel, rect, packed);
+            source = packed.data();
+        }
+
+        glTexSubImage2D(
+            GL_TEXTURE_2D,
+            0,
+            rect.left().as_int(), rect.top().as_int(),
+            rect.size.width.as_int(), rect.size.height.as_int(),
+            format,
+            type,
+            source);
+    }
+
+    // Be nice to other users of the GL context by reverting our changes to shared state
+    if (unpack_row_length)
+    {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    // The texture belongs to this context alone, so GL's own ordering makes the upload visible
+}
+
 mg::NativeBufferBase* mgc::ShmBuffer::native_buffer_base()
 {
     return this;
@@ -194,10 +320,7 @@ void mgc::ShmBuffer::bind()
     if (needs_initialisation)
     {
         // The ShmBuffer *should* be immutable, so we can just upload once.
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        set_texture_parameters();
     }
 }
 
@@ -207,7 +330,7 @@ void mgc::MemoryBackedShmBuffer::bind()
     std::lock_guard lock{uploaded_mutex};
     if (!uploaded)
     {
-        upload_to_texture(pixels.get(), stride_);
+        upload_to_texture(pixels.get(), stride_, supports_unpack_row_length());
         uploaded = true;
     }
 }
@@ -287,14 +410,138 @@ void mgc::ShmBuffer::add_syncpoint()
 {
 }
 
+mgc::ShmTextureChain::ShmTextureChain(std::shared_ptr<EGLContextExecutor> egl_delegate)
+    : egl_delegate{std::move(egl_delegate)}
+{
+}
+
+mgc::ShmTextureChain::~ShmTextureChain() noexcept
+{
+    // Each texture is deleted in its own context; those whose context has gone went with it
+    for (auto const& [lifetime, texture] : textures)
+    {
+        if (auto const context = lifetime.lock(); context && texture.tex_id != 0)
+        {
+            context->delete_texture_later(texture.tex_id);
+        }
+    }
+
+    if (unowned_texture.tex_id != 0)
+    {
+        egl_delegate->spawn(
+            [id = unowned_texture.tex_id]()
+            {
+                glDeleteTextures(1, &id);
+            });
+    }
+}
+
+auto mgc::ShmTextureChain::append(geom::Rectangles const& damage) -> uint64_t
+{
+    std::lock_guard lock{mutex};
+    recent_damage.push_back(damage);
+    if (recent_damage.size() > max_recent_damage)
+    {
+        recent_damage.pop_front();
+    }
+    return ++latest;
+}
+
+auto mgc::ShmTextureChain::bind(
+    uint64_t position,
+    geom::Size const& size,
+    MirPixelFormat format,
+    std::function<void(std::optional<geom::Rectangles> const& damage, bool unpack_row_length)> const& upload) -> bool
+{
+    std::unique_lock lock{mutex};
+    auto& texture =
+        [this]() -> ContextTexture&
+        {
+            auto const context = gl::ContextLifetime::current();
+            if (!context)
+            {
+                return unowned_texture;
+            }
+            std::erase_if(textures, [](auto const& entry) { return entry.first.expired(); });
+            return textures[context];
+        }();
+    if (position < texture.uploaded)
+    {
+        return false;
+    }
+
+    // If we still know everything that changed since the texture was filled, upload only that
+    std::optional<geom::Rectangles> damage;
+    if (position != texture.uploaded)
+    {
+        auto const oldest_recorded = latest + 1 - recent_damage.size();
+        if (texture.uploaded != 0 && texture.uploaded + 1 >= oldest_recorded &&
+            size == texture.uploaded_size && format == texture.uploaded_format)
+        {
+            damage.emplace();
+            for (auto p = texture.uploaded + 1; p <= position; ++p)
+            {
+                for (auto const& rect : recent_damage[p - oldest_recorded])
+                {
+                    damage->add(rect);
+                }
+            }
+        }
+    }
+    lock.unlock();
+
+    bool const needs_initialisation = texture.tex_id == 0;
+    if (needs_initialisation)
+    {
+        glGenTextures(1, &texture.tex_id);
+        texture.unpack_row_length = supports_unpack_row_length();
+    }
+    glBindTexture(GL_TEXTURE_2D, texture.tex_id);
+    if (needs_initialisation)
+    {
+        set_texture_parameters();
+    }
+
+    if (position != texture.uploaded)
+    {
+        upload(damage, texture.unpack_row_length);
+        texture.uploaded = position;
+        texture.uploaded_size = size;
+        texture.uploaded_format = format;
+    }
+    return true;
+}
+
 mgc::MappableBackedShmBuffer::MappableBackedShmBuffer(
     std::shared_ptr<mrs::RWMappableBuffer> data,
     std::shared_ptr<EGLContextExecutor> egl_delegate)
-    : ShmBuffer(data->size(), data->format(), std::move(egl_delegate)),
-      data{std::move(data)}
+    : MappableBackedShmBuffer(std::move(data), nullptr, {}, std::move(egl_delegate))
 {
 }
 
+mgc::MappableBackedShmBuffer::MappableBackedShmBuffer(
+    std::shared_ptr<mrs::RWMappableBuffer> data,
+    std::shared_ptr<Buffer> const& previous,
+    geom::Rectangles const& damage,
+    std::shared_ptr<EGLContextExecutor> egl_delegate)
+    : ShmBuffer(data->size(), data->format(), egl_delegate),
+      data{std::move(data)},
+      texture_chain{texture_chain_after(previous, std::move(egl_delegate))},
+      chain_position{texture_chain->append(damage)}
+{
+}
+
+auto mgc::MappableBackedShmBuffer::texture_chain_after(
+    std::shared_ptr<Buffer> const& previous,
+    std::shared_ptr<EGLContextExecutor> egl_delegate) -> std::shared_ptr<ShmTextureChain>
+{
+    if (auto const shm_previous = std::dynamic_pointer_cast<MappableBackedShmBuffer>(previous))
+    {
+        return shm_previous->texture_chain;
+    }
+    return std::make_shared<ShmTextureChain>(std::move(egl_delegate));
+}
+
 auto mgc::MappableBackedShmBuffer::map_writeable() -> std::unique_ptr<mrs::Mapping<unsigned char>>
 {
     return data->map_writeable();
@@ -312,12 +559,36 @@ auto mgc::MappableBackedShmBuffer::map_rw() -> std::unique_ptr<mrs::Mapping<unsi
 
 void mgc::MappableBackedShmBuffer::bind()
 {
+    bool const bound = texture_chain->bind(
+        chain_position,
+        size(),
+        format(),
+        [this](std::optional<geom::Rectangles> const& damage, bool unpack_row_length)
+        {
+            auto const mapping = data->map_readable();
+            if (damage)
+            {
+                upload_to_texture(mapping->data(), mapping->stride(), *damage, unpack_row_length);
+            }
+            else
+            {
+                upload_to_texture(mapping->data(), mapping->stride(), unpack_row_length);
+            }
+        });
+
+    if (bound)
+    {
+        return;
+    }
+
+    // This context's texture has moved on to a later buffer, so this buffer needs a texture
+    // of its own.
     mgc::ShmBuffer::bind();
     std::lock_guard lock{uploaded_mutex};
     if (!uploaded)
     {
         auto mapping = data->map_readable();
-        upload_to_texture(mapping->data(), mapping->stride());
+        upload_to_texture(mapping->data(), mapping->stride(), supports_unpack_row_length());
         uploaded = true;
     }
 }
@@ -348,6 +619,19 @@ mgc::NotifyingMappableBackedShmBuffer::NotifyingMappableBackedShmBuffer(
 {
 }
 
+mgc::NotifyingMappableBackedShmBuffer::NotifyingMappableBackedShmBuffer(
+    std::shared_ptr<mrs::RWMappableBuffer> data,
+    std::shared_ptr<Buffer> const& previous,
+    geom::Rectangles const& damage,
+    std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+    std::function<void()>&& on_consumed,
+    std::function<void()>&& on_release)
+    :  MappableBackedShmBuffer(std::move(data), previous, damage, std::move(egl_delegate)),
+       on_consumed{std::move(on_consumed)},
+       on_release{std::move(on_release)}
+{
+}
+
 mgc::NotifyingMappableBackedShmBuffer::~NotifyingMappableBackedShmBuffer()
 {
     on_release();
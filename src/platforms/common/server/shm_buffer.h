@@ -20,14 +20,22 @@
 #include "mir/graphics/buffer_basic.h"
 #include "mir/geometry/dimensions.h"
 #include "mir/geometry/size.h"
+#include "mir/geometry/rectangles.h"
 #include "mir_toolkit/common.h"
 #include "mir_toolkit/mir_native_buffer.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/graphics/texture.h"
+#include "mir/graphics/gl_context_lifetime.h"
 
+#include <EGL/egl.h>
 #include <GLES2/gl2.h>
 
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
 #include <mutex>
+#include <optional>
 
 namespace mir
 {
@@ -63,8 +71,17 @@ protected:
         MirPixelFormat const& format,
         std::shared_ptr<EGLContextExecutor> egl_delegate);
 
+    /// \param unpack_row_length  Whether the current context supports GL_UNPACK_ROW_LENGTH
     /// \note This must be called with a current GL context
-    void upload_to_texture(void const* pixels, geometry::Stride const& stride);
+    void upload_to_texture(void const* pixels, geometry::Stride const& stride, bool unpack_row_length);
+    /// Upload just the \a damage (in buffer coordinates) into the bound texture, which must
+    /// already be the same size and format as this buffer
+    /// \note This must be called with a current GL context
+    void upload_to_texture(
+        void const* pixels,
+        geometry::Stride const& stride,
+        geometry::Rectangles const& damage,
+        bool unpack_row_length);
 private:
     geometry::Size const size_;
     MirPixelFormat const pixel_format_;
@@ -109,6 +126,67 @@ private:
     bool uploaded{false};
 };
 
+/**
+ * Textures that successive SHM buffers of a surface take turns to fill
+ *
+ * Each buffer records the damage its client reported when it joins the chain, so
+ * binding a newer buffer only needs to upload what changed since the texture was
+ * last filled, rather than the whole buffer.
+ *
+ * Each GL context gets a texture of its own, so that one context never changes a
+ * texture another may still be sampling. Contexts are told apart by their
+ * gl::ContextLifetime; binding without one current uses a texture of the egl_delegate's.
+ */
+class ShmTextureChain
+{
+public:
+    explicit ShmTextureChain(std::shared_ptr<EGLContextExecutor> egl_delegate);
+    ~ShmTextureChain() noexcept;
+
+    /// Record the damage of the next buffer in the chain, returning its position
+    auto append(geometry::Rectangles const& damage) -> uint64_t;
+
+    /**
+     * Bind the current context's texture, bringing it up to date with the buffer at \a position
+     *
+     * \param upload   Copies pixels into the bound texture; either just the damaged
+     *                 rectangles or, given std::nullopt, everything. It is told whether
+     *                 the context supports GL_UNPACK_ROW_LENGTH.
+     * \return         false if the texture already holds a later buffer. Nothing is
+     *                 bound in that case.
+     * \note This must be called with a current GL context
+     */
+    auto bind(
+        uint64_t position,
+        geometry::Size const& size,
+        MirPixelFormat format,
+        std::function<void(std::optional<geometry::Rectangles> const& damage, bool unpack_row_length)> const& upload)
+        -> bool;
+
+    ShmTextureChain(ShmTextureChain const&) = delete;
+    ShmTextureChain& operator=(ShmTextureChain const&) = delete;
+private:
+    struct ContextTexture
+    {
+        GLuint tex_id{0};
+        bool unpack_row_length{false};
+        uint64_t uploaded{0};       ///< The position of the buffer in the texture, or 0 for none
+        geometry::Size uploaded_size;
+        MirPixelFormat uploaded_format{mir_pixel_format_invalid};
+    };
+
+    std::shared_ptr<EGLContextExecutor> const egl_delegate;
+
+    std::mutex mutex;
+    /// Only the thread with the context current touches its entry once it's created
+    std::map<std::weak_ptr<gl::ContextLifetime>, ContextTexture, std::owner_less<>> textures;
+    /// For binding without a ContextLifetime current
+    ContextTexture unowned_texture;
+    uint64_t latest{0};         ///< The position last handed out by append()
+    /// The damage of positions (latest - recent_damage.size(), latest]
+    std::deque<geometry::Rectangles> recent_damage;
+};
+
 class MappableBackedShmBuffer :
     public ShmBuffer,
     public renderer::software::RWMappableBuffer
@@ -118,6 +196,18 @@ public:
         std::shared_ptr<renderer::software::RWMappableBuffer> data,
         std::shared_ptr<EGLContextExecutor> egl_delegate);
 
+    /**
+     * \param previous The buffer this one replaces on the client's surface, if any. When that
+     *                 is also a MappableBackedShmBuffer the two share a texture, and binding
+     *                 this one only uploads \a damage.
+     * \param damage   The parts of \a data that differ from \a previous, in buffer coordinates
+     */
+    MappableBackedShmBuffer(
+        std::shared_ptr<renderer::software::RWMappableBuffer> data,
+        std::shared_ptr<Buffer> const& previous,
+        geometry::Rectangles const& damage,
+        std::shared_ptr<EGLContextExecutor> egl_delegate);
+
     auto map_writeable() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
     auto map_readable() -> std::unique_ptr<renderer::software::Mapping<unsigned char const>> override;
     auto map_rw() -> std::unique_ptr<renderer::software::Mapping<unsigned char>> override;
@@ -131,7 +221,13 @@ public:
     MappableBackedShmBuffer(MappableBackedShmBuffer const&) = delete;
     MappableBackedShmBuffer& operator=(MappableBackedShmBuffer const&) = delete;
 private:
+    static auto texture_chain_after(
+        std::shared_ptr<Buffer> const& previous,
+        std::shared_ptr<EGLContextExecutor> egl_delegate) -> std::shared_ptr<ShmTextureChain>;
+
     std::shared_ptr<renderer::software::RWMappableBuffer> const data;
+    std::shared_ptr<ShmTextureChain> const texture_chain;
+    uint64_t const chain_position;
     std::mutex uploaded_mutex;
     bool uploaded{false};
 };
@@ -145,6 +241,14 @@ public:
         std::function<void()>&& on_consumed,
         std::function<void()>&& on_release);
 
+    NotifyingMappableBackedShmBuffer(
+        std::shared_ptr<renderer::software::RWMappableBuffer> data,
+        std::shared_ptr<Buffer> const& previous,
+        geometry::Rectangles const& damage,
+        std::shared_ptr<common::EGLContextExecutor> egl_delegate,
+        std::function<void()>&& on_consumed,
+        std::function<void()>&& on_release);
+
     ~NotifyingMappableBackedShmBuffer() override;
 
     void bind() override;
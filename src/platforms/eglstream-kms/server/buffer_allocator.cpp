@@ -538,11 +538,15 @@ mir::graphics::eglstream::BufferAllocator::buffer_from_resource(
 
 auto mge::BufferAllocator::buffer_from_shm(
     std::shared_ptr<renderer::software::RWMappableBuffer> data,
+    std::shared_ptr<Buffer> const& previous,
+    geometry::Rectangles const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
+        previous,
+        damage,
         egl_delegate,
         std::move(on_consumed),
         std::move(on_release));
@@ -663,6 +667,16 @@ public:
         }
     }
 
+    auto buffer_age() const -> int override
+    {
+        // EGLStreams consume the frame on swap; we never get the previous contents back
+        return 0;
+    }
+
+    void set_damage(geom::Rectangles const&) override
+    {
+    }
+
     auto commit() -> std::unique_ptr<mg::Framebuffer> override
     {
         if (eglSwapBuffers(dpy, surface) != EGL_TRUE)
@@ -51,7 +51,8 @@ auto create_rendering_platform(
     mg::SupportedDevice const& device,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const& /*displays*/,
     mo::Option const&,
-    mir::EmergencyCleanupRegistry&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
+    mir::EmergencyCleanupRegistry&,
+    std::shared_ptr<mg::DisplayReport> const&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
 {
     mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
 
@@ -54,6 +54,7 @@
 #include <optional>
 #include <stdexcept>
 #include <system_error>
+#include <vector>
 #include <cassert>
 #include <fcntl.h>
 #include <xf86drm.h>
@@ -225,11 +226,15 @@ std::shared_ptr<mg::Buffer> mgg::BufferAllocator::buffer_from_resource(
 
 auto mgg::BufferAllocator::buffer_from_shm(
     std::shared_ptr<renderer::software::RWMappableBuffer> data,
+    std::shared_ptr<Buffer> const& previous,
+    geometry::Rectangles const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
+        previous,
+        damage,
         egl_delegate,
         std::move(on_consumed),
         std::move(on_release));
@@ -300,12 +305,55 @@ public:
         }
     }
 
+    auto buffer_age() const -> int override
+    {
+        if (!has_buffer_age)
+        {
+            return 0;
+        }
+
+        EGLint age;
+        if (eglQuerySurface(dpy, egl_surf, EGL_BUFFER_AGE_EXT, &age) != EGL_TRUE)
+        {
+            BOOST_THROW_EXCEPTION((mg::egl_error("Failed to query surface buffer age")));
+        }
+        return age;
+    }
+
+    void set_damage(geom::Rectangles const& damage) override
+    {
+        damage_rects.clear();
+        for (auto const& rect : damage)
+        {
+            damage_rects.push_back(rect.left().as_int());
+            damage_rects.push_back(rect.top().as_int());
+            damage_rects.push_back(rect.size.width.as_int());
+            damage_rects.push_back(rect.size.height.as_int());
+        }
+
+        if (eglSetDamageRegion && !damage_rects.empty())
+        {
+            if (eglSetDamageRegion(dpy, egl_surf, damage_rects.data(), static_cast<EGLint>(damage_rects.size() / 4)) != EGL_TRUE)
+            {
+                BOOST_THROW_EXCEPTION((mg::egl_error("Failed to set surface damage region")));
+            }
+        }
+    }
+
     auto commit() -> std::unique_ptr<mg::Framebuffer> override
     {
-        if (eglSwapBuffers(dpy, egl_surf) != EGL_TRUE)
+        if (eglSwapBuffersWithDamage && !damage_rects.empty())
+        {
+            if (eglSwapBuffersWithDamage(dpy, egl_surf, damage_rects.data(), static_cast<EGLint>(damage_rects.size() / 4)) != EGL_TRUE)
+            {
+                BOOST_THROW_EXCEPTION(mg::egl_error("eglSwapBuffersWithDamage failed"));
+            }
+        }
+        else if (eglSwapBuffers(dpy, egl_surf) != EGL_TRUE)
         {
             BOOST_THROW_EXCEPTION(mg::egl_error("eglSwapBuffers failed"));
         }
+        damage_rects.clear();
         return surface->claim_framebuffer();
     }
 
@@ -466,14 +514,44 @@ private:
         : surface{std::move(std::get<0>(renderables))},
           egl_surf{std::get<2>(renderables)},
           dpy{dpy},
-          ctx{std::get<1>(renderables)}
+          ctx{std::get<1>(renderables)},
+          has_buffer_age{
+              mg::has_egl_extension(dpy, "EGL_EXT_buffer_age") ||
+              mg::has_egl_extension(dpy, "EGL_KHR_buffer_age")},
+          eglSetDamageRegion{
+              mg::has_egl_extension(dpy, "EGL_KHR_partial_update") ?
+                  reinterpret_cast<PFNEGLSETDAMAGEREGIONKHRPROC>(eglGetProcAddress("eglSetDamageRegionKHR")) :
+                  nullptr},
+          eglSwapBuffersWithDamage{load_swap_buffers_with_damage(dpy)}
     {
     }
 
+    static auto load_swap_buffers_with_damage(EGLDisplay dpy) -> PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC
+    {
+        // The KHR and EXT variants have identical signatures and semantics
+        if (mg::has_egl_extension(dpy, "EGL_KHR_swap_buffers_with_damage"))
+        {
+            return reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+                eglGetProcAddress("eglSwapBuffersWithDamageKHR"));
+        }
+        if (mg::has_egl_extension(dpy, "EGL_EXT_swap_buffers_with_damage"))
+        {
+            return reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+                eglGetProcAddress("eglSwapBuffersWithDamageEXT"));
+        }
+        return nullptr;
+    }
+
     std::unique_ptr<mg::GBMDisplayAllocator::GBMSurface> const surface;
     EGLSurface const egl_surf;
     EGLDisplay const dpy;
     EGLContext const ctx;
+
+    bool const has_buffer_age;
+    PFNEGLSETDAMAGEREGIONKHRPROC const eglSetDamageRegion;
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC const eglSwapBuffersWithDamage;
+    /// Damage of the frame being drawn, as EGL {x, y, width, height} quadruples
+    std::vector<EGLint> damage_rects;
 };
 }
 
@@ -509,6 +587,12 @@ auto mgg::GLRenderingProvider::suitability_for_display(
         return probe::supported;
     }
 
+    if (dmabuf_provider && sink.acquire_compatible_allocator<DMABufTargetAllocator>())
+    {
+        // We can render into anything we can import
+        return probe::supported;
+    }
+
     return probe::unsupported;
 }
 
@@ -532,6 +616,10 @@ auto mgg::GLRenderingProvider::surface_for_sink(
             }
         }
     }
+    if (auto dmabuf_target = sink.acquire_compatible_allocator<DMABufTargetAllocator>(); dmabuf_target && dmabuf_provider)
+    {
+        return dmabuf_provider->surface_for(*dmabuf_target, ctx);
+    }
     auto cpu_allocator = sink.acquire_compatible_allocator<CPUAddressableDisplayAllocator>();
 
     return std::make_unique<mgc::CPUCopyOutputSurface>(
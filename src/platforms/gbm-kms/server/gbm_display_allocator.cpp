@@ -93,6 +93,17 @@ public:
         return *fb_id;
     }
 
+    auto drm_fourcc() const -> uint32_t override
+    {
+        return gbm_bo_get_format(bo.get());
+    }
+
+    auto modifier() const -> uint64_t override
+    {
+        // We add the framebuffer without modifiers, so KMS sees whatever layout the driver implies
+        return DRM_FORMAT_MOD_INVALID;
+    }
+
     auto size() const -> geom::Size override
     {
         return
@@ -0,0 +1,65 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "atomic_request.h"
+
+#include <boost/throw_exception.hpp>
+#include <xf86drm.h>
+
+#include <stdexcept>
+#include <system_error>
+
+namespace mgg = mir::graphics::gbm;
+
+mgg::AtomicRequest::AtomicRequest()
+    : request{drmModeAtomicAlloc(), &drmModeAtomicFree}
+{
+    if (!request)
+    {
+        BOOST_THROW_EXCEPTION((std::runtime_error{"Failed to allocate atomic KMS request"}));
+    }
+}
+
+void mgg::AtomicRequest::add_property(uint32_t object_id, uint32_t property_id, uint64_t value)
+{
+    // Returns the number of properties in the request on success
+    auto const result = drmModeAtomicAddProperty(request.get(), object_id, property_id, value);
+    if (result < 0)
+    {
+        BOOST_THROW_EXCEPTION((
+            std::system_error{-result, std::system_category(), "Failed to add property to atomic KMS request"}));
+    }
+}
+
+void mgg::AtomicRequest::add_flip(uint32_t crtc_id, uint32_t connector_id)
+{
+    flips_.push_back(Flip{crtc_id, connector_id});
+}
+
+auto mgg::AtomicRequest::flips() const -> std::vector<Flip> const&
+{
+    return flips_;
+}
+
+bool mgg::AtomicRequest::test(int drm_fd, uint32_t flags) const
+{
+    return drmModeAtomicCommit(drm_fd, request.get(), flags | DRM_MODE_ATOMIC_TEST_ONLY, nullptr) == 0;
+}
+
+int mgg::AtomicRequest::commit(int drm_fd, uint32_t flags, void* user_data) const
+{
+    return drmModeAtomicCommit(drm_fd, request.get(), flags, user_data);
+}
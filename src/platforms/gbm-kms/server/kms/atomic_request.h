@@ -0,0 +1,70 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_ATOMIC_REQUEST_H_
+#define MIR_GRAPHICS_GBM_ATOMIC_REQUEST_H_
+
+#include <xf86drmMode.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gbm
+{
+/**
+ * The property changes for a single atomic modesetting commit
+ *
+ * Everything in the request is applied together, or not at all; in particular
+ * every CRTC in the request flips on the same commit.
+ */
+class AtomicRequest
+{
+public:
+    struct Flip
+    {
+        uint32_t crtc_id;
+        uint32_t connector_id;
+    };
+
+    AtomicRequest();
+
+    /// \throws std::system_error if the property couldn't be added
+    void add_property(uint32_t object_id, uint32_t property_id, uint64_t value);
+
+    /// Records that committing the request will present a new frame on crtc_id
+    void add_flip(uint32_t crtc_id, uint32_t connector_id);
+    auto flips() const -> std::vector<Flip> const&;
+
+    /// Asks the kernel whether it would accept the request, without changing anything
+    bool test(int drm_fd, uint32_t flags) const;
+
+    /// \returns 0 on success, or a negative errno value on failure
+    int commit(int drm_fd, uint32_t flags, void* user_data) const;
+
+private:
+    std::unique_ptr<drmModeAtomicReq, void(*)(drmModeAtomicReqPtr)> const request;
+    std::vector<Flip> flips_;
+};
+}
+}
+}
+
+#endif // MIR_GRAPHICS_GBM_ATOMIC_REQUEST_H_
@@ -165,6 +165,18 @@ mgg::Display::Display(
 
     log_drm_details(this->drm_fd);
 
+    // Without this the kernel only tells us about overlay planes, not the primary and cursor planes
+    if (auto const error = drmSetClientCap(this->drm_fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1))
+    {
+        mir::log_info("Failed to enable universal planes: %s (%i)", strerror(-error), -error);
+    }
+
+    // Outputs fall back to legacy KMS if this fails, as it does on drivers without atomic modesetting
+    if (auto const error = drmSetClientCap(this->drm_fd, DRM_CLIENT_CAP_ATOMIC, 1))
+    {
+        mir::log_info("Atomic modesetting unavailable, using legacy KMS: %s (%i)", strerror(-error), -error);
+    }
+
     initial_conf_policy->apply_to(current_display_configuration);
 
     configure(current_display_configuration);
@@ -15,8 +15,10 @@
  */
 
 #include "display_sink.h"
+#include "atomic_request.h"
 #include "kms_cpu_addressable_display_provider.h"
 #include "kms_output.h"
+#include "plane_assignment.h"
 #include "cpu_addressable_fb.h"
 #include "gbm_display_allocator.h"
 #include "mir/fd.h"
@@ -98,7 +100,13 @@ mgg::DisplaySink::DisplaySink(
     listener->report_successful_display_construction();
 }
 
-mgg::DisplaySink::~DisplaySink() = default;
+mgg::DisplaySink::~DisplaySink()
+{
+    for (auto const& output : outputs)
+    {
+        output->claim_planes({});
+    }
+}
 
 geom::Rectangle mgg::DisplaySink::view_area() const
 {
@@ -118,30 +126,86 @@ void mgg::DisplaySink::set_transformation(glm::mat2 const& t, geometry::Rectangl
 
 bool mgg::DisplaySink::overlay(std::vector<DisplayElement> const& renderable_list)
 {
-    // TODO: implement more than the most basic case.
-    if (renderable_list.size() != 1)
+    if (renderable_list.empty())
     {
         return false;
     }
 
-    if (renderable_list[0].screen_positon != view_area())
+    // Planes show buffers as they are; anything translucent or transformed has to be composited
+    if (std::any_of(
+            renderable_list.begin(), renderable_list.end(),
+            [](DisplayElement const& element)
+            {
+                return element.alpha != 1.0f || element.transformation != glm::mat4{1.0f};
+            }))
     {
         return false;
     }
 
-    if (renderable_list[0].source_position.top_left != geom::PointF {0,0} ||
-        renderable_list[0].source_position.size.width.as_value() != view_area().size.width.as_int() ||
-        renderable_list[0].source_position.size.height.as_value() != view_area().size.height.as_int())
+    // assign_planes() checks the bottom element can go on the primary plane
+    auto fb = std::dynamic_pointer_cast<graphics::FBHandle const>(renderable_list.front().buffer);
+    if (!fb)
     {
         return false;
     }
 
-    if (auto fb = std::dynamic_pointer_cast<graphics::FBHandle>(renderable_list[0].buffer))
+    std::vector<std::vector<OverlayPlane>> overlays;
+    overlays.reserve(outputs.size());
+
+    for (size_t output_index = 0; output_index != outputs.size(); ++output_index)
+    {
+        auto const& output = outputs[output_index];
+
+        // While the hardware cursor is showing it owns the cursor plane
+        auto const assignment = assign_planes(output->planes(), renderable_list, view_area(), !output->has_cursor());
+        if (!assignment)
+        {
+            release_unused_planes();
+            return false;
+        }
+
+        auto& output_overlays = overlays.emplace_back();
+        for (size_t i = 0; i != assignment->size(); ++i)
+        {
+            auto const& element = renderable_list[i + 1];
+            output_overlays.push_back(OverlayPlane{
+                (*assignment)[i],
+                std::dynamic_pointer_cast<FBHandle const>(element.buffer),
+                geom::Rectangle{as_point(element.screen_positon.top_left - area.top_left), element.screen_positon.size},
+                element.source_position});
+        }
+
+        // Holding them now keeps them out of the planes() of the other outputs, and fails if
+        // an output of another sink has taken one since we listed them
+        if (!hold_planes(output_index, output_overlays))
+        {
+            release_unused_planes();
+            return false;
+        }
+    }
+
+    /*
+     * assign_planes() only knows what each plane claims to support; with atomic
+     * KMS we can cheaply ask the driver whether it can scan out this combination.
+     * The primary plane on its own is always fine.
+     */
+    auto const uses_overlays = std::any_of(
+        overlays.begin(), overlays.end(), [](auto const& output_overlays) { return !output_overlays.empty(); });
+    if (uses_overlays && use_atomic())
     {
-        next_swap = std::move(fb);
-        return true;
+        AtomicRequest request;
+        auto const& current = page_flips_pending ? scheduled_overlays : visible_overlays;
+        if (!add_to_atomic_request(request, *fb, current, overlays, false) ||
+            !request.test(outputs.front()->drm_fd(), 0))
+        {
+            release_unused_planes();
+            return false;
+        }
     }
-    return false;
+
+    next_swap = std::move(fb);
+    next_overlays = std::move(overlays);
+    return true;
 }
 
 void mgg::DisplaySink::for_each_display_sink(std::function<void(graphics::DisplaySink&)> const& f)
@@ -188,26 +252,48 @@ void mgg::DisplaySink::post()
      */
     scheduled_fb = std::move(next_swap);
     next_swap = nullptr;
+    scheduled_overlays = std::move(next_overlays);
+    next_overlays.clear();
 
     /*
-     * Try to schedule a page flip as first preference to avoid tearing.
+     * Atomic KMS flips every output and plane together, including any
+     * mode set, so is preferred whenever the driver supports it.
      * [will complete in a background thread]
      */
-    if (!needs_set_crtc && !schedule_page_flip(*scheduled_fb))
-        needs_set_crtc = true;
-
-    /*
-     * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
-     * to need to do this on every frame. [will complete in this thread]
-     */
-    if (needs_set_crtc)
+    if (!use_atomic() || !schedule_atomic_page_flip(*scheduled_fb))
     {
-        set_crtc(*scheduled_fb);
-        // SetCrtc is immediate, so the FB is now visible and we have nothing pending
-        visible_fb = std::move(scheduled_fb);
-        scheduled_fb = nullptr;
+        /*
+         * Try to schedule a page flip as first preference to avoid tearing.
+         * [will complete in a background thread]
+         */
+        if (!needs_set_crtc && !schedule_page_flip(*scheduled_fb))
+            needs_set_crtc = true;
 
-        needs_set_crtc = false;
+        /*
+         * Legacy KMS can't tie the overlay planes to the page flip, so they
+         * may update a frame before the primary plane does.
+         */
+        update_overlay_planes();
+
+        /*
+         * Fallback blitting: Not pretty, since it may tear. VirtualBox seems
+         * to need to do this on every frame. [will complete in this thread]
+         */
+        if (needs_set_crtc)
+        {
+            set_crtc(*scheduled_fb);
+            // SetCrtc is immediate, so the FB is now visible and we have nothing pending
+            visible_fb = std::move(scheduled_fb);
+            scheduled_fb = nullptr;
+            visible_overlays = std::move(scheduled_overlays);
+            scheduled_overlays.clear();
+            release_unused_planes();
+
+            // Nothing tells us which vblank it appeared on
+            last_presented = {};
+
+            needs_set_crtc = false;
+        }
     }
 
     using namespace std::chrono_literals;  // For operator""ms()
@@ -261,6 +347,33 @@ void mgg::DisplaySink::post()
     }
 }
 
+auto mgg::DisplaySink::last_frame() const -> Frame
+{
+    if (page_flips_pending && last_presented.msc != 0)
+    {
+        /*
+         * Clone mode reaps the flip just before the next frame, so its timing isn't known yet.
+         * Expect it on the slowest output's next vblank after the last flip: that keeps the
+         * timings reported for successive frames as far apart as the real ones, so users can
+         * still learn the refresh interval.
+         */
+        int slowest_rate{0};
+        for (auto const& output : outputs)
+        {
+            auto const rate = output->max_refresh_rate();
+            if (rate > 0 && (slowest_rate == 0 || rate < slowest_rate))
+                slowest_rate = rate;
+        }
+
+        if (slowest_rate == 0)
+            return {};
+
+        std::chrono::nanoseconds const refresh_interval{std::chrono::seconds{1}};
+        return {last_presented.msc + 1, last_presented.ust + refresh_interval / slowest_rate};
+    }
+    return last_presented;
+}
+
 std::chrono::milliseconds mgg::DisplaySink::recommended_sleep() const
 {
     return recommend_sleep;
@@ -281,16 +394,148 @@ bool mgg::DisplaySink::schedule_page_flip(FBHandle const& bufobj)
     return page_flips_pending;
 }
 
+bool mgg::DisplaySink::schedule_atomic_page_flip(FBHandle const& bufobj)
+{
+    // wait_for_page_flip() has already been called, so what's visible is what the hardware has
+    AtomicRequest request;
+    bool const modeset = needs_set_crtc;
+
+    if (!add_to_atomic_request(request, bufobj, visible_overlays, scheduled_overlays, modeset) ||
+        !outputs.front()->schedule_atomic_page_flip(request, modeset ? DRM_MODE_ATOMIC_ALLOW_MODESET : 0))
+    {
+        mir::log_debug("Atomic KMS commit failed; falling back to legacy KMS for this frame");
+        return false;
+    }
+
+    page_flips_pending = true;
+    needs_set_crtc = false;
+    return true;
+}
+
+bool mgg::DisplaySink::add_to_atomic_request(
+    AtomicRequest& request,
+    FBHandle const& fb,
+    std::vector<std::vector<OverlayPlane>> const& current,
+    std::vector<std::vector<OverlayPlane>> const& next,
+    bool modeset)
+{
+    for (size_t i = 0; i != outputs.size(); ++i)
+    {
+        auto const& output = outputs[i];
+        if (!output->add_to_atomic_request(request, fb, modeset))
+        {
+            return false;
+        }
+
+        // Planes not in the request keep showing whatever they were last given
+        for (auto const& overlay : overlays_of(current, i))
+        {
+            if (!uses_plane(overlays_of(next, i), overlay.plane_id) &&
+                !output->add_plane_to_atomic_request(request, overlay.plane_id, nullptr, {}, {}))
+            {
+                return false;
+            }
+        }
+
+        for (auto const& overlay : overlays_of(next, i))
+        {
+            if (!output->add_plane_to_atomic_request(
+                    request, overlay.plane_id, overlay.fb.get(), overlay.destination, overlay.source))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool mgg::DisplaySink::use_atomic()
+{
+    return !outputs.empty() &&
+           std::all_of(outputs.begin(), outputs.end(), [](auto const& output) { return output->supports_atomic(); });
+}
+
+auto mgg::DisplaySink::overlays_of(std::vector<std::vector<OverlayPlane>> const& overlays, size_t output_index)
+    -> std::vector<OverlayPlane> const&
+{
+    static std::vector<OverlayPlane> const no_overlays;
+    return output_index < overlays.size() ? overlays[output_index] : no_overlays;
+}
+
+bool mgg::DisplaySink::uses_plane(std::vector<OverlayPlane> const& overlays, uint32_t plane_id)
+{
+    return std::any_of(
+        overlays.begin(), overlays.end(), [plane_id](OverlayPlane const& overlay) { return overlay.plane_id == plane_id; });
+}
+
+bool mgg::DisplaySink::hold_planes(size_t output_index, std::vector<OverlayPlane> const& next)
+{
+    std::vector<uint32_t> plane_ids;
+    for (auto const* overlays :
+         {&overlays_of(visible_overlays, output_index), &overlays_of(scheduled_overlays, output_index), &next})
+    {
+        for (auto const& overlay : *overlays)
+        {
+            plane_ids.push_back(overlay.plane_id);
+        }
+    }
+
+    return outputs[output_index]->claim_planes(plane_ids);
+}
+
+void mgg::DisplaySink::release_unused_planes()
+{
+    for (size_t i = 0; i != outputs.size(); ++i)
+    {
+        hold_planes(i, overlays_of(next_overlays, i));
+    }
+}
+
+void mgg::DisplaySink::update_overlay_planes()
+{
+    for (size_t i = 0; i != outputs.size(); ++i)
+    {
+        auto const& output = outputs[i];
+        auto const& scheduled = overlays_of(scheduled_overlays, i);
+
+        for (auto const& overlay : overlays_of(visible_overlays, i))
+        {
+            if (!uses_plane(scheduled, overlay.plane_id))
+            {
+                output->set_plane(overlay.plane_id, nullptr, {}, {});
+            }
+        }
+
+        for (auto const& overlay : scheduled)
+        {
+            output->set_plane(overlay.plane_id, overlay.fb.get(), overlay.destination, overlay.source);
+        }
+    }
+}
+
 void mgg::DisplaySink::wait_for_page_flip()
 {
     if (page_flips_pending)
     {
+        Frame presented;
         for (auto& output : outputs)
-            output->wait_for_page_flip();
+        {
+            // In clone mode the frame isn't complete until the last output has flipped
+            auto const frame = output->wait_for_page_flip();
+            if (frame.msc != 0 && (presented.msc == 0 || frame.ust > presented.ust))
+                presented = frame;
+        }
+
+        if (presented.msc != 0)
+            last_presented = presented;
 
         // The previously-scheduled FB has been page-flipped, and is now visible
         visible_fb = std::move(scheduled_fb);
         scheduled_fb = nullptr;
+        visible_overlays = std::move(scheduled_overlays);
+        scheduled_overlays.clear();
+        // The planes the last frame stopped using are free for other outputs
+        release_unused_planes();
 
         page_flips_pending = false;
     }
@@ -42,6 +42,7 @@ namespace gbm
 
 class Platform;
 class KMSOutput;
+class AtomicRequest;
 
 class DisplaySink : public graphics::DisplaySink,
                       public graphics::DisplaySyncGroup
@@ -70,6 +71,8 @@ public:
 
     glm::mat2 transformation() const override;
 
+    auto last_frame() const -> Frame override;
+
     void set_transformation(glm::mat2 const& t, geometry::Rectangle const& a);
     void schedule_set_crtc();
     void wait_for_page_flip();
@@ -82,8 +85,36 @@ protected:
     auto maybe_create_allocator(DisplayAllocator::Tag const& type_tag) -> DisplayAllocator* override;
 
 private:
+    /// A framebuffer shown on an overlay (or cursor) plane, above the primary framebuffer
+    struct OverlayPlane
+    {
+        uint32_t plane_id;
+        std::shared_ptr<FBHandle const> fb;
+        geometry::Rectangle destination;
+        geometry::RectangleF source;
+    };
+
     bool schedule_page_flip(FBHandle const& bufobj);
     void set_crtc(FBHandle const&);
+    void update_overlay_planes();
+
+    static auto overlays_of(std::vector<std::vector<OverlayPlane>> const& overlays, size_t output_index)
+        -> std::vector<OverlayPlane> const&;
+    static bool uses_plane(std::vector<OverlayPlane> const& overlays, uint32_t plane_id);
+    /// Holds the planes of an output's visible and scheduled overlays and \a next, releasing its others
+    bool hold_planes(size_t output_index, std::vector<OverlayPlane> const& next);
+    /// Releases the planes no overlay still uses, so other outputs can have them
+    void release_unused_planes();
+
+    bool use_atomic();
+    bool schedule_atomic_page_flip(FBHandle const& bufobj);
+    /// Adds switching every output from the current overlays to fb and the next overlays
+    bool add_to_atomic_request(
+        AtomicRequest& request,
+        FBHandle const& fb,
+        std::vector<std::vector<OverlayPlane>> const& current,
+        std::vector<std::vector<OverlayPlane>> const& next,
+        bool modeset);
 
     std::shared_ptr<struct gbm_device> const gbm;
     bool holding_client_buffers{false};
@@ -102,11 +133,17 @@ private:
     std::shared_ptr<FBHandle const> scheduled_fb{nullptr}; //< Frame currently submitted to the hardware, not yet on-screen
     std::shared_ptr<FBHandle const> visible_fb{nullptr};   //< Frame currently onscreen
 
+    // The overlay planes of each of outputs, following the primary framebuffers above
+    std::vector<std::vector<OverlayPlane>> next_overlays;
+    std::vector<std::vector<OverlayPlane>> scheduled_overlays;
+    std::vector<std::vector<OverlayPlane>> visible_overlays;
+
     geometry::Rectangle area;
     glm::mat2 transform;
     std::atomic<bool> needs_set_crtc;
     std::chrono::milliseconds recommend_sleep{0};
     bool page_flips_pending;
+    Frame last_presented;
 };
 
 }
@@ -25,8 +25,10 @@
 #include "mir/graphics/dmabuf_buffer.h"
 #include "mir_toolkit/common.h"
 #include "kms-utils/drm_mode_resources.h"
+#include "plane_assignment.h"
 
 #include <gbm.h>
+#include <vector>
 
 namespace mir
 {
@@ -37,6 +39,7 @@ class FBHandle;
 
 namespace gbm
 {
+class AtomicRequest;
 
 class KMSOutput
 {
@@ -70,7 +73,73 @@ public:
     virtual bool has_crtc_mismatch() = 0;
     virtual void clear_crtc() = 0;
     virtual bool schedule_page_flip(FBHandle const& fb) = 0;
-    virtual void wait_for_page_flip() = 0;
+    virtual Frame wait_for_page_flip() = 0;
+
+    /**
+     * The hardware planes available to this output's CRTC
+     *
+     * Empty if the output has no CRTC, or the planes couldn't be enumerated.
+     * Planes held by other outputs of the same device aren't listed.
+     */
+    virtual auto planes() -> std::vector<KMSPlane> const& = 0;
+
+    /**
+     * Holds \a plane_ids for this output, releasing any other planes it held
+     *
+     * Other outputs of the same device can't use a plane while this one holds it.
+     * \returns false, changing nothing, if another output holds one of \a plane_ids
+     */
+    virtual bool claim_planes(std::vector<uint32_t> const& plane_ids) = 0;
+
+    /**
+     * Show a framebuffer on one of this output's overlay or cursor planes
+     *
+     * The primary plane is driven by set_crtc() and schedule_page_flip() instead.
+     * A plane that fails to show a framebuffer is no longer listed in planes().
+     *
+     * \param [in] fb           The framebuffer to show, or nullptr to disable the plane
+     * \param [in] destination  Where to show it, relative to the CRTC
+     * \param [in] source       The region of fb to show
+     */
+    virtual bool set_plane(
+        uint32_t plane_id,
+        FBHandle const* fb,
+        geometry::Rectangle const& destination,
+        geometry::RectangleF const& source) = 0;
+
+    /**
+     * Whether this output can be driven by atomic requests rather than set_crtc(),
+     * schedule_page_flip() and set_plane()
+     *
+     * The kernel only exposes the properties atomic requests need once the
+     * DRM_CLIENT_CAP_ATOMIC client capability has been set.
+     */
+    virtual bool supports_atomic() = 0;
+
+    /**
+     * Adds showing fb on this output's primary plane to an atomic request
+     *
+     * \param [in] modeset  Also set this output's mode, as set_crtc() does. The request
+     *                      must then be committed with DRM_MODE_ATOMIC_ALLOW_MODESET.
+     * \returns false if this output can't be driven by atomic requests
+     */
+    virtual bool add_to_atomic_request(AtomicRequest& request, FBHandle const& fb, bool modeset) = 0;
+
+    /// As set_plane(), but adding the change to an atomic request rather than applying it
+    virtual bool add_plane_to_atomic_request(
+        AtomicRequest& request,
+        uint32_t plane_id,
+        FBHandle const* fb,
+        geometry::Rectangle const& destination,
+        geometry::RectangleF const& source) = 0;
+
+    /**
+     * Commits an atomic request, after which wait_for_page_flip() waits for it to be presented
+     *
+     * The request may include other outputs on this output's DRM device; each of them
+     * can wait for its own CRTC to flip.
+     */
+    virtual bool schedule_atomic_page_flip(AtomicRequest const& request, uint32_t flags) = 0;
 
     virtual bool set_cursor(gbm_bo* buffer) = 0;
     virtual void move_cursor(geometry::Point destination) = 0;
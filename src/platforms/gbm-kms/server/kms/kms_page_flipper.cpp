@@ -15,6 +15,7 @@
  */
 
 #include "kms_page_flipper.h"
+#include "atomic_request.h"
 #include "mir/graphics/display_report.h"
 
 #include <stdexcept>
@@ -42,6 +43,17 @@ void page_flip_handler(int /*fd*/, unsigned int seq,
                                               seq, ns);
 }
 
+void page_flip_handler2(int /*fd*/, unsigned int seq,
+                        unsigned int sec, unsigned int usec,
+                        unsigned int crtc_id, void* data)
+{
+    auto page_flip_data = static_cast<mgg::PageFlipEventData*>(data);
+    std::chrono::nanoseconds ns{sec*1000000000LL + usec*1000LL};
+    // Kernels which don't say which CRTC flipped send 0; legacy flips know already
+    page_flip_data->flipper->notify_page_flip(crtc_id ? crtc_id : page_flip_data->crtc_id,
+                                              seq, ns);
+}
+
 }
 
 mgg::KMSPageFlipper::KMSPageFlipper(
@@ -50,13 +62,17 @@ mgg::KMSPageFlipper::KMSPageFlipper(
     drm_fd{drm_fd},
     report{report},
     pending_page_flips(),
-    worker_tid()
+    worker_tid(),
+    atomic_flip_data{0, 0, this}
 {
     uint64_t mono = 0;
     if (drmGetCap(drm_fd, DRM_CAP_TIMESTAMP_MONOTONIC, &mono) || !mono)
         clock_id = CLOCK_REALTIME;
     else
         clock_id = CLOCK_MONOTONIC;
+
+    uint64_t crtc_in_event = 0;
+    crtc_in_vblank_event = !drmGetCap(drm_fd, DRM_CAP_CRTC_IN_VBLANK_EVENT, &crtc_in_event) && crtc_in_event;
 }
 
 bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
@@ -86,12 +102,41 @@ bool mgg::KMSPageFlipper::schedule_flip(uint32_t crtc_id,
     return (ret == 0);
 }
 
+bool mgg::KMSPageFlipper::schedule_atomic_flip(AtomicRequest const& request, uint32_t flags)
+{
+    std::unique_lock lock{pf_mutex};
+
+    // Without the CRTC in each event we can't tell which of the request's CRTCs has flipped
+    if (!crtc_in_vblank_event)
+        return false;
+
+    for (auto const& flip : request.flips())
+    {
+        if (pending_page_flips.find(flip.crtc_id) != pending_page_flips.end())
+            BOOST_THROW_EXCEPTION(std::logic_error("Page flip for crtc_id is already scheduled"));
+    }
+
+    // The kernel refuses to send events for a commit that has no CRTCs in it
+    if (!request.flips().empty())
+        flags |= DRM_MODE_PAGE_FLIP_EVENT;
+
+    if (request.commit(drm_fd, flags | DRM_MODE_ATOMIC_NONBLOCK, &atomic_flip_data))
+        return false;
+
+    /* Events are handled with pf_mutex held, so none can have arrived yet */
+    for (auto const& flip : request.flips())
+        pending_page_flips[flip.crtc_id] = PageFlipEventData{flip.crtc_id, flip.connector_id, this};
+
+    return true;
+}
+
 mg::Frame mgg::KMSPageFlipper::wait_for_flip(uint32_t crtc_id)
 {
     drmEventContext evctx;
     memset(&evctx, 0, sizeof evctx);
-    evctx.version = 2;  // We only support the old v2 page_flip_handler
+    evctx.version = 3;  // v3 tells us which CRTC flipped, which atomic commits need
     evctx.page_flip_handler = &page_flip_handler;
+    evctx.page_flip_handler2 = &page_flip_handler2;
 
     static std::thread::id const invalid_tid;
 
@@ -51,6 +51,7 @@ public:
     KMSPageFlipper(int drm_fd, std::shared_ptr<DisplayReport> const& report);
 
     bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) override;
+    bool schedule_atomic_flip(AtomicRequest const& request, uint32_t flags) override;
     Frame wait_for_flip(uint32_t crtc_id) override;
 
     std::thread::id debug_get_worker_tid();
@@ -67,6 +68,9 @@ private:
     std::condition_variable pf_cv;
     std::thread::id worker_tid;
     clockid_t clock_id;
+    bool crtc_in_vblank_event;
+    /// An atomic commit shares its event data between all of its CRTCs; the events say which CRTC flipped
+    PageFlipEventData atomic_flip_data;
 };
 
 }
@@ -26,6 +26,7 @@ namespace graphics
 {
 namespace gbm
 {
+class AtomicRequest;
 
 class PageFlipper
 {
@@ -33,6 +34,13 @@ public:
     virtual ~PageFlipper() {}
 
     virtual bool schedule_flip(uint32_t crtc_id, uint32_t fb_id, uint32_t connector_id) = 0;
+
+    /**
+     * Commits an atomic request without blocking, so that each CRTC it flips can be waited for with wait_for_flip()
+     *
+     * \returns false if the commit failed, or the device can't report which CRTC each page flip event is for
+     */
+    virtual bool schedule_atomic_flip(AtomicRequest const& request, uint32_t flags) = 0;
     virtual Frame wait_for_flip(uint32_t crtc_id) = 0;
 
 protected:
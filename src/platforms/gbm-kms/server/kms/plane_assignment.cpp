@@ -0,0 +1,313 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "plane_assignment.h"
+#include "kms_framebuffer.h"
+#include "kms-utils/drm_mode_resources.h"
+
+#include <boost/throw_exception.hpp>
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+#include <drm_fourcc.h>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace mgk = mir::graphics::kms;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto plane_type(uint64_t drm_plane_type) -> mgg::KMSPlane::Type
+{
+    switch (drm_plane_type)
+    {
+    case DRM_PLANE_TYPE_PRIMARY:
+        return mgg::KMSPlane::Type::primary;
+    case DRM_PLANE_TYPE_CURSOR:
+        return mgg::KMSPlane::Type::cursor;
+    default:
+        return mgg::KMSPlane::Type::overlay;
+    }
+}
+
+auto crtc_index_for(mgk::DRMModeResources const& resources, uint32_t crtc_id) -> int
+{
+    int index{0};
+    for (auto const& crtc : resources.crtcs())
+    {
+        if (crtc->crtc_id == crtc_id)
+        {
+            return index;
+        }
+        ++index;
+    }
+
+    BOOST_THROW_EXCEPTION(std::runtime_error{"Failed to find index of CRTC"});
+}
+
+/// Reads an IN_FORMATS blob, which lists the modifiers a plane accepts for each of its formats
+void add_modifiers_from_blob(int drm_fd, uint32_t blob_id, mgg::KMSPlane& plane)
+{
+    std::unique_ptr<drmModePropertyBlobRes, decltype(&drmModeFreePropertyBlob)> const blob{
+        drmModeGetPropertyBlob(drm_fd, blob_id),
+        &drmModeFreePropertyBlob};
+
+    if (!blob || blob->length < sizeof(drm_format_modifier_blob))
+    {
+        return;
+    }
+
+    auto const data = static_cast<char const*>(blob->data);
+    auto const header = reinterpret_cast<drm_format_modifier_blob const*>(data);
+
+    if (header->formats_offset + header->count_formats * sizeof(uint32_t) > blob->length ||
+        header->modifiers_offset + header->count_modifiers * sizeof(drm_format_modifier) > blob->length)
+    {
+        return;
+    }
+
+    auto const formats = reinterpret_cast<uint32_t const*>(data + header->formats_offset);
+    auto const modifiers = reinterpret_cast<drm_format_modifier const*>(data + header->modifiers_offset);
+
+    for (auto i = 0u; i < header->count_modifiers; ++i)
+    {
+        // Each modifier has a bitmask of the (up to) 64 formats from offset onwards it applies to
+        for (auto bit = 0u; bit < 64; ++bit)
+        {
+            auto const format_index = modifiers[i].offset + bit;
+            if ((modifiers[i].formats & (uint64_t{1} << bit)) && format_index < header->count_formats)
+            {
+                plane.formats[formats[format_index]].push_back(modifiers[i].modifier);
+            }
+        }
+    }
+}
+
+auto framebuffer_of(mg::DisplayElement const& element) -> mg::FBHandle const*
+{
+    return dynamic_cast<mg::FBHandle const*>(element.buffer.get());
+}
+
+bool is_scaled(mg::DisplayElement const& element)
+{
+    return element.source_position.size.width.as_value() != element.screen_positon.size.width.as_value() ||
+           element.source_position.size.height.as_value() != element.screen_positon.size.height.as_value();
+}
+
+bool samples_within(mg::DisplayElement const& element, mg::FBHandle const& fb)
+{
+    auto const& source = element.source_position;
+    auto const fb_size = fb.size();
+
+    return source.left().as_value() >= 0 &&
+           source.top().as_value() >= 0 &&
+           source.right().as_value() <= fb_size.width.as_value() &&
+           source.bottom().as_value() <= fb_size.height.as_value();
+}
+
+bool fills_view_area(mg::DisplayElement const& element, geom::Rectangle const& view_area)
+{
+    return element.screen_positon == view_area &&
+           element.source_position.top_left == geom::PointF{0, 0} &&
+           element.source_position.size.width.as_value() == view_area.size.width.as_int() &&
+           element.source_position.size.height.as_value() == view_area.size.height.as_int();
+}
+}
+
+bool mgg::KMSPlane::can_scale() const
+{
+    // Legacy KMS has no way to ask; primary and cursor planes very commonly can't, overlays usually can.
+    return type == Type::overlay;
+}
+
+bool mgg::KMSPlane::supports(uint32_t fourcc, uint64_t modifier) const
+{
+    auto const format = formats.find(fourcc);
+    if (format == formats.end())
+    {
+        return false;
+    }
+
+    // An implicit modifier is the driver's choice of layout, which is its problem to scan out
+    if (modifier == DRM_FORMAT_MOD_INVALID)
+    {
+        return true;
+    }
+
+    auto const& modifiers = format->second;
+    if (modifiers.empty())
+    {
+        return modifier == DRM_FORMAT_MOD_LINEAR;
+    }
+    return std::find(modifiers.begin(), modifiers.end(), modifier) != modifiers.end();
+}
+
+bool mgg::PlaneClaims::hold(void const* owner, std::vector<uint32_t> const& plane_ids)
+{
+    std::lock_guard lock{mutex};
+
+    for (auto const plane_id : plane_ids)
+    {
+        auto const holder = holders.find(plane_id);
+        if (holder != holders.end() && holder->second != owner)
+        {
+            return false;
+        }
+    }
+
+    std::erase_if(holders, [owner](auto const& holder) { return holder.second == owner; });
+    for (auto const plane_id : plane_ids)
+    {
+        holders[plane_id] = owner;
+    }
+    return true;
+}
+
+bool mgg::PlaneClaims::available_to(void const* owner, uint32_t plane_id) const
+{
+    std::lock_guard lock{mutex};
+
+    auto const holder = holders.find(plane_id);
+    return holder == holders.end() || holder->second == owner;
+}
+
+auto mgg::planes_for_crtc(int drm_fd, uint32_t crtc_id) -> std::vector<KMSPlane>
+{
+    mgk::DRMModeResources const resources{drm_fd};
+    auto const crtc_mask = 1u << crtc_index_for(resources, crtc_id);
+
+    mgk::PlaneResources const plane_resources{drm_fd};
+
+    std::vector<KMSPlane> planes;
+    for (auto const& plane : plane_resources.planes())
+    {
+        if (!(plane->possible_crtcs & crtc_mask))
+        {
+            continue;
+        }
+
+        mgk::ObjectProperties const properties{drm_fd, plane};
+
+        KMSPlane kms_plane{
+            plane->plane_id,
+            properties.has_property("type") ? plane_type(properties["type"]) : KMSPlane::Type::overlay,
+            {},
+            std::nullopt};
+
+        if (properties.has_property("zpos"))
+        {
+            kms_plane.zpos = properties["zpos"];
+        }
+        if (properties.has_property("IN_FORMATS"))
+        {
+            add_modifiers_from_blob(drm_fd, properties["IN_FORMATS"], kms_plane);
+        }
+        for (auto i = 0u; i < plane->count_formats; ++i)
+        {
+            // Leaves any modifiers from IN_FORMATS alone
+            kms_plane.formats[plane->formats[i]];
+        }
+
+        planes.push_back(std::move(kms_plane));
+    }
+
+    return planes;
+}
+
+auto mgg::assign_planes(
+    std::vector<KMSPlane> const& planes,
+    std::vector<DisplayElement> const& renderlist,
+    geom::Rectangle const& view_area,
+    bool allow_cursor_planes) -> std::optional<std::vector<uint32_t>>
+{
+    if (renderlist.empty())
+    {
+        return std::nullopt;
+    }
+
+    auto const& bottom = renderlist.front();
+    auto const bottom_fb = framebuffer_of(bottom);
+    if (!bottom_fb || !fills_view_area(bottom, view_area))
+    {
+        return std::nullopt;
+    }
+
+    // Without universal planes we can't see the primary plane; it's driven by the CRTC as it always has been
+    auto const primary = std::find_if(
+        planes.begin(), planes.end(), [](KMSPlane const& plane) { return plane.type == KMSPlane::Type::primary; });
+    if (primary != planes.end() && !primary->supports(bottom_fb->drm_fourcc(), bottom_fb->modifier()))
+    {
+        return std::nullopt;
+    }
+
+    // The planes above the primary, bottom to top. Cursor planes are always on top.
+    std::vector<KMSPlane const*> stack;
+    for (auto const& plane : planes)
+    {
+        if (plane.type == KMSPlane::Type::overlay)
+        {
+            stack.push_back(&plane);
+        }
+    }
+    std::stable_sort(
+        stack.begin(), stack.end(),
+        [](KMSPlane const* lhs, KMSPlane const* rhs) { return lhs->zpos.value_or(0) < rhs->zpos.value_or(0); });
+    if (allow_cursor_planes)
+    {
+        for (auto const& plane : planes)
+        {
+            if (plane.type == KMSPlane::Type::cursor)
+            {
+                stack.push_back(&plane);
+            }
+        }
+    }
+
+    std::vector<uint32_t> assignment;
+    assignment.reserve(renderlist.size() - 1);
+
+    auto next_plane = stack.begin();
+    for (auto element = renderlist.begin() + 1; element != renderlist.end(); ++element)
+    {
+        auto const fb = framebuffer_of(*element);
+        if (!fb || !view_area.contains(element->screen_positon) || !samples_within(*element, *fb))
+        {
+            return std::nullopt;
+        }
+
+        // Only planes above the one showing the element below will keep the stacking order
+        next_plane = std::find_if(
+            next_plane, stack.end(),
+            [&](KMSPlane const* plane)
+            {
+                return plane->supports(fb->drm_fourcc(), fb->modifier()) &&
+                       (plane->can_scale() || !is_scaled(*element));
+            });
+
+        if (next_plane == stack.end())
+        {
+            return std::nullopt;
+        }
+        assignment.push_back((*next_plane)->id);
+        ++next_plane;
+    }
+
+    return assignment;
+}
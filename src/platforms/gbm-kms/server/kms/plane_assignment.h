@@ -0,0 +1,115 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_GRAPHICS_GBM_PLANE_ASSIGNMENT_H_
+#define MIR_GRAPHICS_GBM_PLANE_ASSIGNMENT_H_
+
+#include "mir/graphics/display_sink.h"
+#include "mir/geometry/rectangle.h"
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+namespace gbm
+{
+/// What a KMS plane is able to scan out
+struct KMSPlane
+{
+    enum class Type
+    {
+        overlay,
+        primary,
+        cursor
+    };
+
+    uint32_t id;
+    Type type;
+
+    /**
+     * The modifiers the plane accepts for each DRM fourcc it can scan out
+     *
+     * An empty list means the driver didn't say, in which case only linear and
+     * implicit-modifier framebuffers are assumed to work.
+     */
+    std::unordered_map<uint32_t, std::vector<uint64_t>> formats;
+
+    /// The plane's position in the stacking order, if the driver exposes one
+    std::optional<uint64_t> zpos;
+
+    bool can_scale() const;
+    bool supports(uint32_t fourcc, uint64_t modifier) const;
+};
+
+/**
+ * Which output is using each of a DRM device's overlay and cursor planes
+ *
+ * An overlay plane can usually be attached to any of several CRTCs, but only to one
+ * at a time, so every output of a device shares one of these.
+ */
+class PlaneClaims
+{
+public:
+    /**
+     * Makes \a plane_ids the planes \a owner holds, releasing any others it held
+     *
+     * \returns false, changing nothing, if another owner holds one of \a plane_ids
+     */
+    bool hold(void const* owner, std::vector<uint32_t> const& plane_ids);
+
+    /// Whether \a owner could hold \a plane_id
+    bool available_to(void const* owner, uint32_t plane_id) const;
+
+private:
+    std::mutex mutable mutex;
+    std::unordered_map<uint32_t, void const*> holders;
+};
+
+/**
+ * Enumerates the planes which can be attached to a CRTC
+ *
+ * Primary and cursor planes are only listed by the kernel once the
+ * DRM_CLIENT_CAP_UNIVERSAL_PLANES client capability has been set.
+ */
+auto planes_for_crtc(int drm_fd, uint32_t crtc_id) -> std::vector<KMSPlane>;
+
+/**
+ * Finds a plane to scan out each element of \a renderlist directly
+ *
+ * The bottom element is shown on the primary plane, so must exactly cover \a view_area
+ * without scaling. Each element stacked above it needs an overlay (or, if \a allow_cursor_planes,
+ * cursor) plane which stacks above the one chosen for the element below it and can scan out the
+ * element's format, modifier and scaling.
+ *
+ * \returns The plane for each element of \a renderlist above the bottom one, in renderlist order,
+ *          or std::nullopt if any element has to be composited instead.
+ */
+auto assign_planes(
+    std::vector<KMSPlane> const& planes,
+    std::vector<DisplayElement> const& renderlist,
+    geometry::Rectangle const& view_area,
+    bool allow_cursor_planes) -> std::optional<std::vector<uint32_t>>;
+}
+}
+}
+
+#endif // MIR_GRAPHICS_GBM_PLANE_ASSIGNMENT_H_
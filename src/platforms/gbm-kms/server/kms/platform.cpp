@@ -305,7 +305,8 @@ auto maybe_make_dmabuf_provider(
     std::shared_ptr<gbm_device> gbm,
     EGLDisplay dpy,
     std::shared_ptr<mg::EGLExtensions> egl_extensions,
-    std::shared_ptr<mg::common::EGLContextExecutor> egl_delegate)
+    std::shared_ptr<mg::common::EGLContextExecutor> egl_delegate,
+    std::shared_ptr<mg::DisplayReport> report)
     -> std::shared_ptr<mg::DMABufEGLProvider>
 {
     try
@@ -320,7 +321,8 @@ auto maybe_make_dmabuf_provider(
                 -> std::shared_ptr<mg::DMABufBuffer>
             {
                 return alloc_dma_buf(gbm.get(), format, modifiers, size);
-            });
+            },
+            std::move(report));
     }
     catch (std::runtime_error const& error)
     {
@@ -338,18 +340,20 @@ auto maybe_make_dmabuf_provider(
 
 mgg::RenderingPlatform::RenderingPlatform(
     mir::udev::Device const& device,
-    std::vector<std::shared_ptr<mg::DisplayPlatform>> const& platforms)
-    : RenderingPlatform(gbm_device_for_udev_device(device, platforms))
+    std::vector<std::shared_ptr<mg::DisplayPlatform>> const& platforms,
+    std::shared_ptr<mg::DisplayReport> const& report)
+    : RenderingPlatform(gbm_device_for_udev_device(device, platforms), report)
 {
 }
 
 mgg::RenderingPlatform::RenderingPlatform(
-    std::variant<std::shared_ptr<mg::GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw)
+    std::variant<std::shared_ptr<mg::GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw,
+    std::shared_ptr<mg::DisplayReport> const& report)
     : device{std::visit(gbm_device_from_hw{}, hw)},
       bound_display{std::visit(display_provider_or_nothing{}, hw)},
       share_ctx{std::make_unique<SurfacelessEGLContext>(initialise_egl(dpy_for_gbm_device(device.get()), 1, 4))},
       egl_delegate{std::make_shared<mg::common::EGLContextExecutor>(share_ctx->make_share_context())},
-      dmabuf_provider{maybe_make_dmabuf_provider(device, share_ctx->egl_display(), std::make_shared<mg::EGLExtensions>(), egl_delegate)}
+      dmabuf_provider{maybe_make_dmabuf_provider(device, share_ctx->egl_display(), std::make_shared<mg::EGLExtensions>(), egl_delegate, report)}
 {
 }
 
@@ -89,7 +89,8 @@ class RenderingPlatform : public graphics::RenderingPlatform
 public:
     RenderingPlatform(
         udev::Device const& device,
-        std::vector<std::shared_ptr<graphics::DisplayPlatform>> const& platforms);
+        std::vector<std::shared_ptr<graphics::DisplayPlatform>> const& platforms,
+        std::shared_ptr<DisplayReport> const& report);
 
     ~RenderingPlatform() override;
 
@@ -102,7 +103,8 @@ protected:
 
 private:
     RenderingPlatform(
-        std::variant<std::shared_ptr<GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw);
+        std::variant<std::shared_ptr<GBMDisplayProvider>, std::shared_ptr<gbm_device>> hw,
+        std::shared_ptr<DisplayReport> const& report);
     
     std::shared_ptr<gbm_device> const device;                   ///< gbm_device this platform is created on, always valid.
     std::shared_ptr<GBMDisplayProvider> const bound_display;    ///< Associated Display, if any (nullptr is valid)
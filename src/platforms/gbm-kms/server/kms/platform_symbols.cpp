@@ -79,11 +79,12 @@ auto create_rendering_platform(
     mg::SupportedDevice const& device,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const& platforms,
     mo::Option const&,
-    mir::EmergencyCleanupRegistry&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
+    mir::EmergencyCleanupRegistry&,
+    std::shared_ptr<mg::DisplayReport> const& report) -> mir::UniqueModulePtr<mg::RenderingPlatform>
 {
     mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
 
-    return mir::make_module_ptr<mgg::RenderingPlatform>(*device.device, platforms);
+    return mir::make_module_ptr<mgg::RenderingPlatform>(*device.device, platforms, report);
 }
 
 void add_graphics_platform_options(boost::program_options::options_description& config)
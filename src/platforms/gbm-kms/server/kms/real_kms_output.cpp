@@ -15,6 +15,7 @@
  */
 
 #include "real_kms_output.h"
+#include "atomic_request.h"
 #include "kms_framebuffer.h"
 #include "mir/graphics/display_configuration.h"
 #include "page_flipper.h"
@@ -24,6 +25,8 @@
 #include <string.h> // strcmp
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
+#include <iterator>
 #include <system_error>
 #include <xf86drm.h>
 #include <xf86drmMode.h>
@@ -49,14 +52,55 @@ bool kms_modes_are_equal(drmModeModeInfo const& info1, drmModeModeInfo const& in
             info1.vsync_end == info2.vsync_end &&
             info1.vtotal == info2.vtotal);
 }
+
+/// KMS plane source coordinates are in 16.16 fixed point
+uint32_t to_fixed_point(float value)
+{
+    return static_cast<uint32_t>(value * 65536.0f);
+}
+
+void add_plane_properties(
+    mgg::AtomicRequest& request,
+    uint32_t plane_id,
+    mgk::ObjectProperties const& plane_props,
+    uint32_t crtc_id,
+    uint32_t fb_id,
+    geom::Rectangle const& destination,
+    geom::RectangleF const& source)
+{
+    auto const set = [&](char const* name, uint64_t value)
+        {
+            request.add_property(plane_id, plane_props.id_for(name), value);
+        };
+    // CRTC_X and CRTC_Y are signed; the destination may hang off the top or left of the CRTC
+    auto const signed_value = [](int value) { return static_cast<uint64_t>(static_cast<int64_t>(value)); };
+
+    set("FB_ID", fb_id);
+    set("CRTC_ID", crtc_id);
+    set("SRC_X", to_fixed_point(source.top_left.x.as_value()));
+    set("SRC_Y", to_fixed_point(source.top_left.y.as_value()));
+    set("SRC_W", to_fixed_point(source.size.width.as_value()));
+    set("SRC_H", to_fixed_point(source.size.height.as_value()));
+    set("CRTC_X", signed_value(destination.top_left.x.as_int()));
+    set("CRTC_Y", signed_value(destination.top_left.y.as_int()));
+    set("CRTC_W", destination.size.width.as_uint32_t());
+    set("CRTC_H", destination.size.height.as_uint32_t());
+}
+
+bool has_properties(mgk::ObjectProperties const& object, std::initializer_list<char const*> names)
+{
+    return std::all_of(names.begin(), names.end(), [&](char const* name) { return object.has_property(name); });
+}
 }
 
 mgg::RealKMSOutput::RealKMSOutput(
     int drm_fd,
     kms::DRMModeConnectorUPtr&& connector,
-    std::shared_ptr<PageFlipper> const& page_flipper)
+    std::shared_ptr<PageFlipper> const& page_flipper,
+    std::shared_ptr<PlaneClaims> const& plane_claims)
     : drm_fd_{drm_fd},
       page_flipper{page_flipper},
+      plane_claims{plane_claims},
       connector{std::move(connector)},
       mode_index{0},
       current_crtc(),
@@ -82,6 +126,12 @@ mgg::RealKMSOutput::RealKMSOutput(
 mgg::RealKMSOutput::~RealKMSOutput()
 {
     restore_saved_crtc();
+    plane_claims->hold(this, {});
+
+    if (mode_blob_id)
+    {
+        drmModeDestroyPropertyBlob(drm_fd_, mode_blob_id);
+    }
 }
 
 uint32_t mgg::RealKMSOutput::id() const
@@ -243,17 +293,283 @@ bool mgg::RealKMSOutput::schedule_page_flip(FBHandle const& fb)
         connector->connector_id);
 }
 
-void mgg::RealKMSOutput::wait_for_page_flip()
+mg::Frame mgg::RealKMSOutput::wait_for_page_flip()
 {
     std::unique_lock lg(power_mutex);
     if (power_mode != mir_power_mode_on)
-        return;
+        return {};
     if (!current_crtc)
     {
         fatal_error("Output %s has no associated CRTC to wait on",
                    mgk::connector_name(connector).c_str());
     }
-    page_flipper->wait_for_flip(current_crtc->crtc_id);
+    return page_flipper->wait_for_flip(current_crtc->crtc_id);
+}
+
+auto mgg::RealKMSOutput::planes() -> std::vector<KMSPlane> const&
+{
+    if (!current_crtc)
+    {
+        static std::vector<KMSPlane> const no_planes;
+        return no_planes;
+    }
+
+    // What each plane can do doesn't change, but which planes we can use depends on our CRTC
+    if (current_crtc->crtc_id != planes_crtc_id)
+    {
+        planes_crtc_id = current_crtc->crtc_id;
+        try
+        {
+            crtc_planes = planes_for_crtc(drm_fd_, planes_crtc_id);
+        }
+        catch (std::exception const& e)
+        {
+            mir::log_warning("Failed to enumerate planes for output %s: %s",
+                             mgk::connector_name(connector).c_str(), e.what());
+            crtc_planes.clear();
+        }
+    }
+
+    available_planes.clear();
+    std::copy_if(
+        crtc_planes.begin(), crtc_planes.end(), std::back_inserter(available_planes),
+        [this](KMSPlane const& plane) { return plane_claims->available_to(this, plane.id); });
+    return available_planes;
+}
+
+bool mgg::RealKMSOutput::claim_planes(std::vector<uint32_t> const& plane_ids)
+{
+    return plane_claims->hold(this, plane_ids);
+}
+
+bool mgg::RealKMSOutput::set_plane(
+    uint32_t plane_id,
+    FBHandle const* fb,
+    geom::Rectangle const& destination,
+    geom::RectangleF const& source)
+{
+    if (!current_crtc)
+    {
+        return false;
+    }
+
+    auto const result = fb ?
+        drmModeSetPlane(
+            drm_fd_, plane_id, current_crtc->crtc_id, *fb, 0,
+            destination.top_left.x.as_int(), destination.top_left.y.as_int(),
+            destination.size.width.as_uint32_t(), destination.size.height.as_uint32_t(),
+            to_fixed_point(source.top_left.x.as_value()), to_fixed_point(source.top_left.y.as_value()),
+            to_fixed_point(source.size.width.as_value()), to_fixed_point(source.size.height.as_value())) :
+        drmModeSetPlane(drm_fd_, plane_id, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    if (result)
+    {
+        mir::log_warning("Failed to set plane %u on output %s: %s (%i)",
+                         plane_id, mgk::connector_name(connector).c_str(), strerror(-result), -result);
+
+        // Whatever the driver objected to, it's likely to object again next frame
+        if (fb)
+        {
+            std::erase_if(crtc_planes, [plane_id](KMSPlane const& plane) { return plane.id == plane_id; });
+        }
+        return false;
+    }
+    return true;
+}
+
+bool mgg::RealKMSOutput::supports_atomic()
+{
+    return atomic_properties() != nullptr;
+}
+
+bool mgg::RealKMSOutput::add_to_atomic_request(AtomicRequest& request, FBHandle const& fb, bool modeset)
+{
+    std::lock_guard lg(power_mutex);
+
+    auto const props = atomic_properties();
+    if (!props)
+    {
+        return false;
+    }
+
+    auto const crtc_id = current_crtc->crtc_id;
+    bool const on = power_mode == mir_power_mode_on;
+
+    // As with schedule_page_flip(), there's nothing to flip while the output is off
+    if (!on && !modeset)
+    {
+        return true;
+    }
+
+    auto const& mode = connector->modes[mode_index];
+    try
+    {
+        if (modeset)
+        {
+            request.add_property(crtc_id, props->crtc.id_for("MODE_ID"), mode_blob());
+            request.add_property(crtc_id, props->crtc.id_for("ACTIVE"), on);
+            request.add_property(connector->connector_id, props->connector.id_for("CRTC_ID"), crtc_id);
+        }
+
+        add_plane_properties(
+            request,
+            props->primary_plane_id,
+            props->planes.at(props->primary_plane_id),
+            crtc_id,
+            fb,
+            geom::Rectangle{{0, 0}, {mode.hdisplay, mode.vdisplay}},
+            geom::RectangleF{
+                {fb_offset.dx.as_int(), fb_offset.dy.as_int()},
+                {mode.hdisplay, mode.vdisplay}});
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_warning("Failed to add output %s to atomic KMS request: %s",
+                         mgk::connector_name(connector).c_str(), e.what());
+        return false;
+    }
+
+    // The kernel only sends page flip events for active CRTCs
+    if (on)
+    {
+        request.add_flip(crtc_id, connector->connector_id);
+    }
+    if (modeset)
+    {
+        using_saved_crtc = false;
+    }
+    return true;
+}
+
+bool mgg::RealKMSOutput::add_plane_to_atomic_request(
+    AtomicRequest& request,
+    uint32_t plane_id,
+    FBHandle const* fb,
+    geom::Rectangle const& destination,
+    geom::RectangleF const& source)
+{
+    auto const props = atomic_properties();
+    if (!props)
+    {
+        return false;
+    }
+
+    auto const plane_props = props->planes.find(plane_id);
+    if (plane_props == props->planes.end())
+    {
+        return false;
+    }
+
+    try
+    {
+        if (fb)
+        {
+            add_plane_properties(
+                request, plane_id, plane_props->second, current_crtc->crtc_id, *fb, destination, source);
+        }
+        else
+        {
+            request.add_property(plane_id, plane_props->second.id_for("FB_ID"), 0);
+            request.add_property(plane_id, plane_props->second.id_for("CRTC_ID"), 0);
+        }
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_warning("Failed to add plane %u to atomic KMS request: %s", plane_id, e.what());
+        return false;
+    }
+    return true;
+}
+
+bool mgg::RealKMSOutput::schedule_atomic_page_flip(AtomicRequest const& request, uint32_t flags)
+{
+    return page_flipper->schedule_atomic_flip(request, flags);
+}
+
+auto mgg::RealKMSOutput::atomic_properties() -> AtomicProperties const*
+{
+    if (!ensure_crtc())
+    {
+        return nullptr;
+    }
+
+    if (current_crtc->crtc_id == atomic_crtc_id)
+    {
+        return atomic_props ? &*atomic_props : nullptr;
+    }
+
+    atomic_crtc_id = current_crtc->crtc_id;
+    atomic_props.reset();
+
+    auto const& crtc_planes = planes();
+    auto const primary = std::find_if(
+        crtc_planes.begin(), crtc_planes.end(),
+        [](KMSPlane const& plane) { return plane.type == KMSPlane::Type::primary; });
+    if (primary == crtc_planes.end())
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        AtomicProperties props{
+            mgk::ObjectProperties{drm_fd_, atomic_crtc_id, DRM_MODE_OBJECT_CRTC},
+            mgk::ObjectProperties{drm_fd_, connector->connector_id, DRM_MODE_OBJECT_CONNECTOR},
+            primary->id,
+            {}};
+        for (auto const& plane : crtc_planes)
+        {
+            props.planes.emplace(plane.id, mgk::ObjectProperties{drm_fd_, plane.id, DRM_MODE_OBJECT_PLANE});
+        }
+
+        auto const plane_has_properties = [](auto const& plane)
+            {
+                return has_properties(
+                    plane.second,
+                    {"FB_ID", "CRTC_ID", "SRC_X", "SRC_Y", "SRC_W", "SRC_H", "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H"});
+            };
+
+        // These are only exposed to clients that have enabled atomic modesetting
+        if (has_properties(props.crtc, {"MODE_ID", "ACTIVE"}) &&
+            has_properties(props.connector, {"CRTC_ID"}) &&
+            std::all_of(props.planes.begin(), props.planes.end(), plane_has_properties))
+        {
+            atomic_props.emplace(std::move(props));
+        }
+    }
+    catch (std::exception const& e)
+    {
+        mir::log_warning("Failed to find atomic KMS properties of output %s: %s",
+                         mgk::connector_name(connector).c_str(), e.what());
+    }
+
+    return atomic_props ? &*atomic_props : nullptr;
+}
+
+auto mgg::RealKMSOutput::mode_blob() -> uint32_t
+{
+    auto const& mode = connector->modes[mode_index];
+    if (mode_blob_id && kms_modes_are_equal(mode, mode_blob_mode))
+    {
+        return mode_blob_id;
+    }
+
+    uint32_t blob_id{0};
+    if (auto const error = drmModeCreatePropertyBlob(drm_fd_, &mode, sizeof(mode), &blob_id))
+    {
+        BOOST_THROW_EXCEPTION((
+            std::system_error{-error, std::system_category(), "Failed to create DRM mode property blob"}));
+    }
+
+    // The kernel holds its own reference to the old mode for as long as the CRTC uses it
+    if (mode_blob_id)
+    {
+        drmModeDestroyPropertyBlob(drm_fd_, mode_blob_id);
+    }
+    mode_blob_id = blob_id;
+    mode_blob_mode = mode;
+
+    return mode_blob_id;
 }
 
 bool mgg::RealKMSOutput::set_cursor(gbm_bo* buffer)
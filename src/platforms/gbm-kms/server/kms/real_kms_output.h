@@ -22,6 +22,9 @@
 
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 namespace mir
 {
@@ -38,7 +41,8 @@ public:
     RealKMSOutput(
         int drm_fd,
         kms::DRMModeConnectorUPtr&& connector,
-        std::shared_ptr<PageFlipper> const& page_flipper);
+        std::shared_ptr<PageFlipper> const& page_flipper,
+        std::shared_ptr<PlaneClaims> const& plane_claims);
     ~RealKMSOutput();
 
     uint32_t id() const override;
@@ -52,7 +56,25 @@ public:
     bool has_crtc_mismatch() override;
     void clear_crtc() override;
     bool schedule_page_flip(FBHandle const& fb) override;
-    void wait_for_page_flip() override;
+    Frame wait_for_page_flip() override;
+
+    auto planes() -> std::vector<KMSPlane> const& override;
+    bool set_plane(
+        uint32_t plane_id,
+        FBHandle const* fb,
+        geometry::Rectangle const& destination,
+        geometry::RectangleF const& source) override;
+    bool claim_planes(std::vector<uint32_t> const& plane_ids) override;
+
+    bool supports_atomic() override;
+    bool add_to_atomic_request(AtomicRequest& request, FBHandle const& fb, bool modeset) override;
+    bool add_plane_to_atomic_request(
+        AtomicRequest& request,
+        uint32_t plane_id,
+        FBHandle const* fb,
+        geometry::Rectangle const& destination,
+        geometry::RectangleF const& source) override;
+    bool schedule_atomic_page_flip(AtomicRequest const& request, uint32_t flags) override;
 
     bool set_cursor(gbm_bo* buffer) override;
     void move_cursor(geometry::Point destination) override;
@@ -68,11 +90,23 @@ public:
     int drm_fd() const override;
 
 private:
+    /// The ids of the properties atomic requests set on our CRTC, connector and planes
+    struct AtomicProperties
+    {
+        kms::ObjectProperties crtc;
+        kms::ObjectProperties connector;
+        uint32_t primary_plane_id;
+        std::unordered_map<uint32_t, kms::ObjectProperties> planes;
+    };
+
     bool ensure_crtc();
     void restore_saved_crtc();
+    auto atomic_properties() -> AtomicProperties const*;
+    auto mode_blob() -> uint32_t;
 
     int const drm_fd_;
     std::shared_ptr<PageFlipper> const page_flipper;
+    std::shared_ptr<PlaneClaims> const plane_claims;
 
     kms::DRMModeConnectorUPtr connector;
     size_t mode_index;
@@ -82,6 +116,15 @@ private:
     bool using_saved_crtc;
     bool has_cursor_;
 
+    uint32_t planes_crtc_id{0};
+    std::vector<KMSPlane> crtc_planes;
+    std::vector<KMSPlane> available_planes;     ///< crtc_planes, less those other outputs hold
+
+    uint32_t atomic_crtc_id{0};
+    std::optional<AtomicProperties> atomic_props;   ///< nullopt if atomic_crtc_id can't be driven atomically
+    uint32_t mode_blob_id{0};
+    drmModeModeInfo mode_blob_mode{};
+
     MirPowerMode power_mode;
     int dpms_enum_id;
 
@@ -25,7 +25,8 @@ mgg::RealKMSOutputContainer::RealKMSOutputContainer(
     mir::Fd drm_fd,
     std::shared_ptr<PageFlipper> page_flipper)
     : drm_fd{std::move(drm_fd)},
-      page_flipper{std::move(page_flipper)}
+      page_flipper{std::move(page_flipper)},
+      plane_claims{std::make_shared<PlaneClaims>()}
 {
 }
 
@@ -69,7 +70,8 @@ void mgg::RealKMSOutputContainer::update_from_hardware_state()
             new_outputs.push_back(std::make_shared<RealKMSOutput>(
                 drm_fd,
                 std::move(connector),
-                page_flipper));
+                page_flipper,
+                plane_claims));
         }
     }
 
@@ -18,6 +18,7 @@
 #define MIR_GRAPHICS_GBM_REAL_KMS_OUTPUT_CONTAINER_H_
 
 #include "kms_output_container.h"
+#include "plane_assignment.h"
 #include "mir/fd.h"
 #include <vector>
 
@@ -44,6 +45,7 @@ private:
     mir::Fd const drm_fd;
     std::vector<std::shared_ptr<KMSOutput>> outputs;
     std::shared_ptr<PageFlipper> const page_flipper;
+    std::shared_ptr<PlaneClaims> const plane_claims;
 };
 
 }
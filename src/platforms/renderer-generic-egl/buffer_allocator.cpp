@@ -315,11 +315,15 @@ std::shared_ptr<mg::Buffer> mge::BufferAllocator::buffer_from_resource(
 
 auto mge::BufferAllocator::buffer_from_shm(
     std::shared_ptr<renderer::software::RWMappableBuffer> data,
+    std::shared_ptr<Buffer> const& previous,
+    geometry::Rectangles const& damage,
     std::function<void()>&& on_consumed,
     std::function<void()>&& on_release) -> std::shared_ptr<Buffer>
 {
     return std::make_shared<mgc::NotifyingMappableBackedShmBuffer>(
         std::move(data),
+        previous,
+        damage,
         egl_delegate,
         std::move(on_consumed),
         std::move(on_release));
@@ -369,6 +373,16 @@ public:
         fb->release_current();
     }
 
+    auto buffer_age() const -> int override
+    {
+        // We don't know how the host manages the framebuffer's buffers
+        return 0;
+    }
+
+    void set_damage(geom::Rectangles const&) override
+    {
+    }
+
     auto commit() -> std::unique_ptr<mg::Framebuffer> override
     {
         return fb->clone_handle();
@@ -422,6 +436,12 @@ auto mge::GLRenderingProvider::suitability_for_display(
         return probe::supported;
     }
 
+    if (dmabuf_provider && sink.acquire_compatible_allocator<DMABufTargetAllocator>())
+    {
+        // We can render into anything we can import
+        return probe::supported;
+    }
+
     return probe::unsupported;
 }
 
@@ -434,6 +454,10 @@ auto mge::GLRenderingProvider::surface_for_sink(
     {
         return std::make_unique<EGLOutputSurface>(egl_display->alloc_framebuffer(config, ctx));
     }
+    if (auto dmabuf_target = sink.acquire_compatible_allocator<DMABufTargetAllocator>(); dmabuf_target && dmabuf_provider)
+    {
+        return dmabuf_provider->surface_for(*dmabuf_target, ctx);
+    }
     auto cpu_provider = sink.acquire_compatible_allocator<CPUAddressableDisplayAllocator>();
 
     return std::make_unique<mgc::CPUCopyOutputSurface>(
@@ -39,11 +39,12 @@ auto create_rendering_platform(
     mg::SupportedDevice const&,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const& displays,
     mo::Option const&,
-    mir::EmergencyCleanupRegistry&) -> mir::UniqueModulePtr<mg::RenderingPlatform>
+    mir::EmergencyCleanupRegistry&,
+    std::shared_ptr<mg::DisplayReport> const& report) -> mir::UniqueModulePtr<mg::RenderingPlatform>
 {
    mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
 
-    return mir::make_module_ptr<mge::RenderingPlatform>(displays);
+    return mir::make_module_ptr<mge::RenderingPlatform>(displays, report);
 }
 
 void add_graphics_platform_options(boost::program_options::options_description&)
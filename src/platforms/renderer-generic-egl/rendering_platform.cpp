@@ -166,7 +166,8 @@ private:
 auto maybe_make_dmabuf_provider(
     EGLDisplay dpy,
     std::shared_ptr<mg::EGLExtensions> egl_extensions,
-    std::shared_ptr<mgc::EGLContextExecutor> egl_delegate)
+    std::shared_ptr<mgc::EGLContextExecutor> egl_delegate,
+    std::shared_ptr<mg::DisplayReport> report)
     -> std::shared_ptr<mg::DMABufEGLProvider>
 {
     try
@@ -180,7 +181,8 @@ auto maybe_make_dmabuf_provider(
             [](mg::DRMFormat, std::span<uint64_t const>, geom::Size) -> std::shared_ptr<mg::DMABufBuffer>
             {
                 return nullptr;    // We can't (portably) allocate dmabufs, but we also shouldn't need to
-            });
+            },
+            std::move(report));
     }
     catch (std::runtime_error const& error)
     {
@@ -196,12 +198,16 @@ auto maybe_make_dmabuf_provider(
 }
 }
 
-mge::RenderingPlatform::RenderingPlatform(std::vector<std::shared_ptr<DisplayPlatform>> const& displays)
-    : RenderingPlatform(egl_display_from_platforms(displays))
+mge::RenderingPlatform::RenderingPlatform(
+    std::vector<std::shared_ptr<DisplayPlatform>> const& displays,
+    std::shared_ptr<DisplayReport> const& report)
+    : RenderingPlatform(egl_display_from_platforms(displays), report)
 {
 }
 
-mge::RenderingPlatform::RenderingPlatform(std::tuple<EGLDisplay, bool> display)
+mge::RenderingPlatform::RenderingPlatform(
+    std::tuple<EGLDisplay, bool> display,
+    std::shared_ptr<DisplayReport> const& report)
     : dpy{std::get<0>(display)},
       owns_dpy{std::get<1>(display)},
       ctx{std::make_unique<SurfacelessEGLContext>(dpy)},
@@ -209,7 +215,8 @@ mge::RenderingPlatform::RenderingPlatform(std::tuple<EGLDisplay, bool> display)
           maybe_make_dmabuf_provider(
               dpy,
               std::make_shared<mg::EGLExtensions>(),
-              std::make_shared<mgc::EGLContextExecutor>(ctx->make_share_context()))}
+              std::make_shared<mgc::EGLContextExecutor>(ctx->make_share_context()),
+              report)}
 {
 }
 
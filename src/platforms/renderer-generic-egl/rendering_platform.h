@@ -35,7 +35,9 @@ namespace graphics::egl::generic
 class RenderingPlatform : public graphics::RenderingPlatform
 {
 public:
-    explicit RenderingPlatform(std::vector<std::shared_ptr<DisplayPlatform>> const& displays);
+    RenderingPlatform(
+        std::vector<std::shared_ptr<DisplayPlatform>> const& displays,
+        std::shared_ptr<DisplayReport> const& report);
 
     ~RenderingPlatform();
 
@@ -47,7 +49,7 @@ protected:
         RenderingProvider::Tag const& type_tag) -> std::shared_ptr<RenderingProvider> override;
 
 private:
-    explicit RenderingPlatform(std::tuple<EGLDisplay, bool> dpy);
+    RenderingPlatform(std::tuple<EGLDisplay, bool> dpy, std::shared_ptr<DisplayReport> const& report);
 
     EGLDisplay const dpy;
     bool const owns_dpy;
@@ -21,12 +21,26 @@
 #include "mir/graphics/display_report.h"
 #include "mir/graphics/transformation.h"
 #include "../x11_resources.h"
+#include <algorithm>
 #include <cstring>
 
 namespace mg=mir::graphics;
 namespace mgx=mg::X;
 namespace geom=mir::geometry;
 
+namespace
+{
+auto interval_of(double refresh_rate) -> std::chrono::nanoseconds
+{
+    if (refresh_rate <= 0)
+    {
+        // The host didn't tell us, so guess at the usual
+        refresh_rate = 60;
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>{1 / refresh_rate});
+}
+}
+
 class mgx::DisplaySink::Allocator : public mg::GenericEGLDisplayAllocator
 {
 public:
@@ -52,12 +66,15 @@ mgx::DisplaySink::DisplaySink(
     xcb_connection_t* connection,
     xcb_window_t win,
     std::shared_ptr<helpers::EGLHelper> egl,
-    geometry::Rectangle const& view_area)
+    geometry::Rectangle const& view_area,
+    double refresh_rate)
     : area{view_area},
       transform(1),
       egl{std::move(egl)},
       x11_connection{connection},
-      x_win{win}
+      x_win{win},
+      refresh_interval{interval_of(refresh_rate)},
+      started{Frame::Timestamp::now(CLOCK_MONOTONIC)}
 {
 }
 
@@ -120,6 +137,16 @@ void mgx::DisplaySink::post()
 {
     next_frame->swap_buffers();
     next_frame.reset();
+
+    // Assume the host showed the frame as the swap completed, and count its refresh cycles since we started
+    auto const now = Frame::Timestamp::now(CLOCK_MONOTONIC);
+    last_presented.msc = std::max<int64_t>((now - started) / refresh_interval + 1, last_presented.msc + 1);
+    last_presented.ust = now;
+}
+
+auto mgx::DisplaySink::last_frame() const -> Frame
+{
+    return last_presented;
 }
 
 std::chrono::milliseconds mgx::DisplaySink::recommended_sleep() const
@@ -25,6 +25,7 @@
 #include "egl_helper.h"
 
 #include <EGL/egl.h>
+#include <chrono>
 #include <memory>
 
 namespace mir
@@ -47,7 +48,8 @@ public:
             xcb_connection_t* connection,
             xcb_window_t win,
             std::shared_ptr<helpers::EGLHelper> egl,
-            geometry::Rectangle const& view_area);
+            geometry::Rectangle const& view_area,
+            double refresh_rate);
 
     ~DisplaySink();
 
@@ -58,6 +60,9 @@ public:
 
     glm::mat2 transformation() const override;
 
+    /// X doesn't tell us when the host shows a frame, so this is synthesised from the host's refresh rate
+    auto last_frame() const -> Frame override;
+
 protected:
     auto maybe_create_allocator(DisplayAllocator::Tag const& type_tag) -> DisplayAllocator* override;
 
@@ -83,6 +88,9 @@ private:
     std::shared_ptr<helpers::EGLHelper> egl;
     xcb_connection_t* const x11_connection;
     xcb_window_t const x_win;
+    std::chrono::nanoseconds const refresh_interval;
+    Frame::Timestamp const started;
+    Frame last_presented;
 };
 
 }
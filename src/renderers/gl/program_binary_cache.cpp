@@ -0,0 +1,243 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define MIR_LOG_COMPONENT "GLRenderer"
+
+#include "program_binary_cache.h"
+#include "mir/log.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+namespace mrg = mir::renderer::gl;
+namespace fs = std::filesystem;
+
+namespace
+{
+char const magic[] = "MIRGLPB1";
+
+/// FNV-1a: file names must be stable between runs, which std::hash doesn't promise
+auto hash_of(std::string const& s) -> std::string
+{
+    uint64_t hash{0xcbf29ce484222325};
+    for (auto const c : s)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3;
+    }
+
+    char hex[17];
+    snprintf(hex, sizeof hex, "%016llx", static_cast<unsigned long long>(hash));
+    return hex;
+}
+
+void write_size(std::ostream& out, size_t size)
+{
+    auto const value = static_cast<uint32_t>(size);
+    out.write(reinterpret_cast<char const*>(&value), sizeof value);
+}
+
+/// Sizes larger than the file itself can only come from a corrupt file
+auto read_size(std::istream& in, size_t limit) -> size_t
+{
+    uint32_t value{0};
+    in.read(reinterpret_cast<char*>(&value), sizeof value);
+    if (value > limit)
+    {
+        in.setstate(std::ios::failbit);
+    }
+    return in ? value : 0;
+}
+
+void write_string(std::ostream& out, std::string const& s)
+{
+    write_size(out, s.size());
+    out.write(s.data(), s.size());
+}
+
+auto read_string(std::istream& in, size_t limit) -> std::string
+{
+    std::string s(read_size(in, limit), '\0');
+    in.read(s.data(), s.size());
+    return s;
+}
+}
+
+mrg::ProgramBinaryCache::ProgramBinaryCache(fs::path directory, std::string implementation)
+    : directory{std::move(directory)},
+      implementation{std::move(implementation)},
+      prefix{hash_of(this->implementation) + "-"}
+{
+}
+
+auto mrg::ProgramBinaryCache::default_directory() -> std::optional<fs::path>
+{
+    if (auto const cache_home = getenv("XDG_CACHE_HOME"); cache_home && *cache_home)
+    {
+        return fs::path{cache_home} / "mir" / "gl-programs";
+    }
+    else if (auto const home = getenv("HOME"))
+    {
+        return fs::path{home} / ".cache" / "mir" / "gl-programs";
+    }
+
+    return std::nullopt;
+}
+
+std::chrono::hours const mrg::ProgramBinaryCache::max_unused{24 * 30};
+
+auto mrg::ProgramBinaryCache::load(std::string const& sources) const -> std::optional<Binary>
+{
+    auto const path = path_for(sources);
+    std::error_code ec;
+    if (!fs::exists(path, ec))
+    {
+        return std::nullopt;
+    }
+
+    auto entry = read(path);
+    if (!entry)
+    {
+        // Corrupt, so it would only fail again next time
+        fs::remove(path, ec);
+        return std::nullopt;
+    }
+
+    // Another program whose sources have the same hash, which is for it to keep
+    if (entry->first != sources)
+    {
+        return std::nullopt;
+    }
+
+    // Prune by when binaries were last used, not when they were made
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return std::move(entry->second);
+}
+
+void mrg::ProgramBinaryCache::store(std::string const& sources, Binary const& binary) const
+{
+    // Binaries are only stored when there wasn't one to load, as happens after a driver update
+    std::call_once(pruned, [this] { prune(); });
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+
+    // Write a new file and rename it over the old, so that readers never see a partial binary.
+    // The new file's name must be unique, as other threads and servers may store the same program.
+    auto const path = path_for(sources);
+    auto temporary_name = path.string() + ".XXXXXX";
+    auto const fd = mkstemp(temporary_name.data());
+    if (fd < 0)
+    {
+        mir::log_debug("Failed to create a file for GL program binary in %s", directory.c_str());
+        return;
+    }
+    close(fd);
+    fs::path const temporary{temporary_name};
+
+    {
+        std::ofstream out{temporary, std::ios::binary | std::ios::trunc};
+        out.write(magic, sizeof magic);
+        write_string(out, implementation);
+        write_string(out, sources);
+        write_size(out, binary.format);
+        write_size(out, binary.data.size());
+        out.write(reinterpret_cast<char const*>(binary.data.data()), binary.data.size());
+
+        if (!out.flush())
+        {
+            mir::log_debug("Failed to write GL program binary to %s", temporary.c_str());
+            fs::remove(temporary, ec);
+            return;
+        }
+    }
+
+    fs::rename(temporary, path, ec);
+    if (ec)
+    {
+        mir::log_debug("Failed to store GL program binary as %s: %s", path.c_str(), ec.message().c_str());
+        fs::remove(temporary, ec);
+    }
+}
+
+void mrg::ProgramBinaryCache::remove(std::string const& sources) const
+{
+    std::error_code ec;
+    fs::remove(path_for(sources), ec);
+}
+
+void mrg::ProgramBinaryCache::prune() const
+{
+    auto const oldest = fs::file_time_type::clock::now() - max_unused;
+
+    std::error_code ec;
+    for (auto const& file : fs::directory_iterator{directory, ec})
+    {
+        auto const name = file.path().filename().string();
+        // Other implementations' binaries, and files left by a server that stopped while storing one
+        auto const ours = name.starts_with(prefix) && name.ends_with(".bin");
+        if (!ours && file.last_write_time(ec) < oldest && !ec)
+        {
+            fs::remove(file.path(), ec);
+        }
+    }
+}
+
+auto mrg::ProgramBinaryCache::path_for(std::string const& sources) const -> fs::path
+{
+    return directory / (prefix + hash_of(sources) + ".bin");
+}
+
+auto mrg::ProgramBinaryCache::read(fs::path const& path) const -> std::optional<std::pair<std::string, Binary>>
+{
+    std::error_code ec;
+    auto const limit = fs::file_size(path, ec);
+    if (ec)
+    {
+        return std::nullopt;
+    }
+
+    std::ifstream in{path, std::ios::binary};
+
+    char header[sizeof magic]{};
+    in.read(header, sizeof header);
+    if (!in || !std::equal(std::begin(header), std::end(header), std::begin(magic)))
+    {
+        return std::nullopt;
+    }
+
+    // Anything that doesn't match exactly is from another implementation (or corrupt)
+    if (read_string(in, limit) != implementation)
+    {
+        return std::nullopt;
+    }
+
+    auto sources = read_string(in, limit);
+    Binary binary{static_cast<GLenum>(read_size(in, UINT32_MAX)), {}};
+    binary.data.resize(read_size(in, limit));
+    in.read(reinterpret_cast<char*>(binary.data.data()), binary.data.size());
+
+    if (!in || binary.data.empty())
+    {
+        return std::nullopt;
+    }
+
+    return std::make_pair(std::move(sources), std::move(binary));
+}
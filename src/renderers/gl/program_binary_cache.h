@@ -0,0 +1,96 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_RENDERER_GL_PROGRAM_BINARY_CACHE_H_
+#define MIR_RENDERER_GL_PROGRAM_BINARY_CACHE_H_
+
+#include <GLES2/gl2.h>
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mir
+{
+namespace renderer
+{
+namespace gl
+{
+/**
+ * Linked GL program binaries (from GL_OES_get_program_binary), kept on disk between runs
+ *
+ * Binaries are stored under the GL implementation that produced them and the shader
+ * sources they were built from, so that a driver update or a change to a shader misses
+ * the cache rather than loading a stale binary.
+ *
+ * The cache is only an optimisation: failing to read or write it is never an error.
+ *
+ * Binaries that can't be read, or that the driver rejects, are removed. So are those of other
+ * GL implementations once they've gone unused for a while: after a driver update nothing
+ * would load them again, but another GPU in the same machine may still be using its own.
+ */
+class ProgramBinaryCache
+{
+public:
+    struct Binary
+    {
+        GLenum format;
+        std::vector<std::byte> data;
+    };
+
+    /**
+     * \param directory         Where binaries are stored; created when the first is stored
+     * \param implementation    Identifies the GL implementation, e.g. its vendor, renderer
+     *                          and version strings
+     */
+    ProgramBinaryCache(std::filesystem::path directory, std::string implementation);
+
+    /// $XDG_CACHE_HOME/mir/gl-programs (or ~/.cache/mir/gl-programs), if either is known
+    static auto default_directory() -> std::optional<std::filesystem::path>;
+
+    /// How long binaries of other GL implementations are kept without being used
+    static std::chrono::hours const max_unused;
+
+    /// The binary built from sources, if one is cached
+    auto load(std::string const& sources) const -> std::optional<Binary>;
+
+    /// Stores binary, and the first time, prunes binaries of other implementations
+    void store(std::string const& sources, Binary const& binary) const;
+
+    /// Removes the binary built from sources, e.g. because the driver no longer accepts it
+    void remove(std::string const& sources) const;
+
+private:
+    auto path_for(std::string const& sources) const -> std::filesystem::path;
+    auto read(std::filesystem::path const& path) const -> std::optional<std::pair<std::string, Binary>>;
+    void prune() const;
+
+    std::filesystem::path const directory;
+    std::string const implementation;
+    /// Prefixes the name of every file cached for this implementation
+    std::string const prefix;
+    std::once_flag mutable pruned;
+};
+}
+}
+}
+
+#endif // MIR_RENDERER_GL_PROGRAM_BINARY_CACHE_H_
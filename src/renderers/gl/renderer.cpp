@@ -16,9 +16,11 @@
 #define MIR_LOG_COMPONENT "GLRenderer"
 
 #include "renderer.h"
+#include "program_binary_cache.h"
 #include "mir/compositor/buffer_stream.h"
 #include "mir/graphics/renderable.h"
 #include "mir/graphics/buffer.h"
+#include "mir/graphics/buffer_basic.h"
 #include "mir/graphics/display_sink.h"
 #include "mir/gl/tessellation_helpers.h"
 #include "mir/log.h"
@@ -29,15 +31,22 @@
 #include "mir/graphics/program_factory.h"
 #include "mir/graphics/program.h"
 #include "mir/renderer/gl/gl_surface.h"
+#include "mir/geometry/region.h"
 
 #define GLM_FORCE_RADIANS
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
 
 #include <boost/throw_exception.hpp>
+#include <algorithm>
 #include <stdexcept>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
 #include <sstream>
 #include <mutex>
 
@@ -100,22 +109,73 @@ public:
     mir::renderer::gl::Renderer::Program opaque, alpha;
 };
 
+// Each renderable's transformation is applied to its vertices before they are uploaded
 const GLchar* const vertex_shader_src =
 {
-    "attribute vec3 position;\n"
+    "attribute vec4 position;\n"
     "attribute vec2 texcoord;\n"
     "uniform mat4 screen_to_gl_coords;\n"
     "uniform mat4 display_transform;\n"
-    "uniform mat4 transform;\n"
-    "uniform vec2 centre;\n"
     "varying vec2 v_texcoord;\n"
     "void main() {\n"
-    "   vec4 mid = vec4(centre, 0.0, 0.0);\n"
-    "   vec4 transformed = (transform * (vec4(position, 1.0) - mid)) + mid;\n"
-    "   gl_Position = display_transform * screen_to_gl_coords * transformed;\n"
+    "   gl_Position = display_transform * screen_to_gl_coords * position;\n"
     "   v_texcoord = texcoord;\n"
     "}\n"
 };
+
+/// The entry points of GL_OES_get_program_binary
+struct ProgramBinaryExtension
+{
+    PFNGLGETPROGRAMBINARYOESPROC const glGetProgramBinaryOES;
+    PFNGLPROGRAMBINARYOESPROC const glProgramBinaryOES;
+};
+
+auto has_gl_extension(char const* extension) -> bool
+{
+    auto const extensions = reinterpret_cast<char const*>(glGetString(GL_EXTENSIONS));
+    return extensions && strstr(extensions, extension);
+}
+
+auto gl_string(GLenum name) -> std::string
+{
+    auto const value = reinterpret_cast<char const*>(glGetString(name));
+    return value ? value : "";
+}
+
+auto make_program_binary_extension() -> std::optional<ProgramBinaryExtension>
+{
+    GLint formats{0};
+    if (has_gl_extension("GL_OES_get_program_binary"))
+    {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+    }
+
+    // Some drivers advertise the extension, but have no binary formats to use with it
+    if (formats > 0)
+    {
+        auto const get = reinterpret_cast<PFNGLGETPROGRAMBINARYOESPROC>(eglGetProcAddress("glGetProgramBinaryOES"));
+        auto const set = reinterpret_cast<PFNGLPROGRAMBINARYOESPROC>(eglGetProcAddress("glProgramBinaryOES"));
+        if (get && set)
+        {
+            return ProgramBinaryExtension{get, set};
+        }
+    }
+
+    return std::nullopt;
+}
+
+auto make_program_binary_cache() -> std::unique_ptr<mrg::ProgramBinaryCache>
+{
+    if (auto const directory = mrg::ProgramBinaryCache::default_directory())
+    {
+        // Binaries are only valid for the driver that produced them
+        return std::make_unique<mrg::ProgramBinaryCache>(
+            *directory,
+            gl_string(GL_VENDOR) + "\n" + gl_string(GL_RENDERER) + "\n" + gl_string(GL_VERSION));
+    }
+
+    return nullptr;
+}
 }
 
 class mrg::Renderer::ProgramFactory : public mir::graphics::gl::ProgramFactory
@@ -123,7 +183,9 @@ class mrg::Renderer::ProgramFactory : public mir::graphics::gl::ProgramFactory
 public:
     // NOTE: This must be called with a current GL context
     ProgramFactory()
-        : vertex_shader{compile_shader(GL_VERTEX_SHADER, vertex_shader_src)}
+        : vertex_shader{compile_shader(GL_VERTEX_SHADER, vertex_shader_src)},
+          binary_extension{make_program_binary_extension()},
+          binary_cache{binary_extension ? make_program_binary_cache() : nullptr}
     {
     }
 
@@ -180,25 +242,99 @@ public:
             "    gl_FragColor = alpha * sample_to_rgba(v_texcoord);\n"
             "}\n";
 
+        auto const start = std::chrono::steady_clock::now();
+        auto const compiled_before = compiled_from_source;
+
         // GL shader compilation is *not* threadsafe, and requires external synchronisation
         std::lock_guard lock{compilation_mutex};
 
-        ShaderHandle const opaque_shader{
-            compile_shader(GL_FRAGMENT_SHADER, opaque_fragment.str().c_str())};
-        ShaderHandle const alpha_shader{
-            compile_shader(GL_FRAGMENT_SHADER, alpha_fragment.str().c_str())};
+        auto opaque = program_for(opaque_fragment.str());
+        auto alpha = program_for(alpha_fragment.str());
+        programs.emplace_back(id, std::make_unique<::Program>(std::move(opaque), std::move(alpha)));
 
-        programs.emplace_back(id, std::make_unique<::Program>(
-            link_shader(vertex_shader, opaque_shader),
-            link_shader(vertex_shader, alpha_shader)));
+        /* This happens while drawing the first frame that needs the program, so when the
+         * programs have to be compiled from source that frame is late.
+         */
+        auto const elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        mir::log_info(
+            "Prepared GL program for shader %p in %.1fms (%s; %u compiled from source since startup)",
+            id,
+            elapsed.count(),
+            compiled_from_source == compiled_before ? "cached" : "compiled",
+            compiled_from_source);
 
         return *programs.back().second;
-
-        // We delete opaque_shader and alpha_shader here. This is fine; it only marks them
-        // for deletion. GL will only delete them once the GL Program they're linked in is destroyed.
     }
 
 private:
+    /// The linked program for fragment_shader, from the cache if possible
+    auto program_for(std::string const& fragment_shader) -> ProgramHandle
+    {
+        auto const sources = std::string{vertex_shader_src} + '\0' + fragment_shader;
+
+        // Only the programs asked for are loaded: a cache may hold many that this run never draws with
+        if (binary_cache)
+        {
+            if (auto const binary = binary_cache->load(sources))
+            {
+                if (auto program = program_from_binary(*binary))
+                {
+                    return std::move(*program);
+                }
+                binary_cache->remove(sources);
+            }
+        }
+
+        ShaderHandle const shader{compile_shader(GL_FRAGMENT_SHADER, fragment_shader.c_str())};
+        auto program = link_shader(vertex_shader, shader);
+        ++compiled_from_source;
+
+        if (binary_cache)
+        {
+            store_binary(sources, program);
+        }
+
+        return program;
+
+        // We delete shader here. This is fine; it only marks it for deletion.
+        // GL will only delete it once the GL Program it's linked in is destroyed.
+    }
+
+    /// A program loaded from binary, unless the driver rejects it (after an update, for example)
+    auto program_from_binary(mrg::ProgramBinaryCache::Binary const& binary) -> std::optional<ProgramHandle>
+    {
+        ProgramHandle program{glCreateProgram()};
+        binary_extension->glProgramBinaryOES(
+            program, binary.format, binary.data.data(), static_cast<GLint>(binary.data.size()));
+
+        GLint ok{GL_FALSE};
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        if (!ok)
+        {
+            return std::nullopt;
+        }
+        return program;
+    }
+
+    void store_binary(std::string const& sources, GLuint program)
+    {
+        GLint length{0};
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+        if (length <= 0)
+        {
+            return;
+        }
+
+        mrg::ProgramBinaryCache::Binary binary{0, std::vector<std::byte>(length)};
+        GLsizei written{0};
+        binary_extension->glGetProgramBinaryOES(program, length, &written, &binary.format, binary.data.data());
+        if (written > 0)
+        {
+            binary.data.resize(written);
+            binary_cache->store(sources, binary);
+        }
+    }
+
     static GLuint compile_shader(GLenum type, GLchar const* src)
     {
         GLuint id = glCreateShader(type);
@@ -247,6 +383,9 @@ private:
     }
 
     ShaderHandle const vertex_shader;
+    std::optional<ProgramBinaryExtension> const binary_extension;
+    std::unique_ptr<mrg::ProgramBinaryCache> const binary_cache;
+    unsigned compiled_from_source{0};
     std::vector<std::pair<void const*, std::unique_ptr<::Program>>> programs;
     // GL requires us to synchronise multi-threaded access to the shader APIs.
     std::mutex compilation_mutex;
@@ -265,9 +404,7 @@ mrg::Renderer::Program::Program(GLuint program_id)
         auto const uniform_name = std::string{"tex["} + std::to_string(i) + "]";
         tex_uniforms[i] = glGetUniformLocation(id, uniform_name.c_str());
     }
-    centre_uniform = glGetUniformLocation(id, "centre");
     display_transform_uniform = glGetUniformLocation(id, "display_transform");
-    transform_uniform = glGetUniformLocation(id, "transform");
     screen_to_gl_coords_uniform = glGetUniformLocation(id, "screen_to_gl_coords");
     alpha_uniform = glGetUniformLocation(id, "alpha");
 }
@@ -279,8 +416,183 @@ auto make_output_current(std::unique_ptr<mg::gl::OutputSurface> output) -> std::
     output->make_current();
     return output;
 }
+
+/// Buffers older than this are always fully redrawn (a triple-buffered surface reaches age 3)
+auto const max_tracked_buffer_age = 4u;
+
+auto is_empty(geom::Rectangle const& rect) -> bool
+{
+    return rect.size.width == geom::Width{} || rect.size.height == geom::Height{};
+}
+
+/// Each repainted rectangle costs a clear and a scissored pass per renderable, so past this many
+/// it's cheaper to repaint a little more in fewer rectangles
+auto const max_repaint_rectangles = 8u;
+
+auto area_of(geom::Rectangle const& rect) -> long long
+{
+    return static_cast<long long>(rect.size.width.as_int()) * rect.size.height.as_int();
+}
+
+/// Reduces rects to at most max_repaint_rectangles, merging those whose bounding rectangle adds least
+auto merged_repaint_rectangles(geom::Rectangles const& disjoint) -> geom::Rectangles
+{
+    std::vector<geom::Rectangle> rects{disjoint.begin(), disjoint.end()};
+    while (rects.size() > max_repaint_rectangles)
+    {
+        size_t best_a{0}, best_b{1};
+        auto best_cost = std::numeric_limits<long long>::max();
+        for (size_t a = 0; a != rects.size(); ++a)
+        {
+            for (size_t b = a + 1; b != rects.size(); ++b)
+            {
+                auto const merged = geom::Rectangles{rects[a], rects[b]}.bounding_rectangle();
+                auto const cost = area_of(merged) - area_of(rects[a]) - area_of(rects[b]);
+                if (cost < best_cost)
+                {
+                    best_cost = cost;
+                    best_a = a;
+                    best_b = b;
+                }
+            }
+        }
+        rects[best_a] = geom::Rectangles{rects[best_a], rects[best_b]}.bounding_rectangle();
+        rects.erase(rects.begin() + best_b);
+    }
+
+    // Merging can make rectangles overlap, which would blend what's drawn in both twice
+    geom::Region repaint;
+    for (auto const& rect : rects)
+    {
+        repaint.unite(geom::Region{rect});
+    }
+    return repaint.rectangles();
 }
 
+/// How many runs of renderables back a renderable may be moved, to join a run drawn with the same state
+auto const max_reordering_distance = 32;
+
+/// Calls f(a, b, c) for each triangle of primitive
+template<typename F>
+void for_each_triangle(mgl::Primitive const& primitive, F const& f)
+{
+    auto const& v = primitive.vertices;
+    switch (primitive.type)
+    {
+    case GL_TRIANGLE_STRIP:
+        for (auto i = 2; i < primitive.nvertices; ++i)
+        {
+            f(v[i - 2], v[i - 1], v[i]);
+        }
+        break;
+
+    case GL_TRIANGLE_FAN:
+        for (auto i = 2; i < primitive.nvertices; ++i)
+        {
+            f(v[0], v[i - 1], v[i]);
+        }
+        break;
+
+    default:
+        for (auto i = 2; i < primitive.nvertices; i += 3)
+        {
+            f(v[i - 2], v[i - 1], v[i]);
+        }
+        break;
+    }
+}
+}
+
+/// A copy of a frame the Renderer drew, which can itself be drawn like a client's buffer
+class mrg::Renderer::RetainedFrame : public mg::BufferBasic, public mg::NativeBufferBase, public mg::gl::Texture
+{
+public:
+    // Note: Must be called with the GL context of lifetime current
+    RetainedFrame(geom::Size size, Layout layout, std::shared_ptr<mg::gl::ContextLifetime> const& lifetime)
+        : size_{size},
+          layout_{layout},
+          lifetime{lifetime}
+    {
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // The output might not have alpha, and copying can't add channels the framebuffer lacks
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, GL_RGB,
+            size.width.as_int(), size.height.as_int(),
+            0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    ~RetainedFrame() override
+    {
+        // The last reference may be dropped by a screenshot, on a thread without our context
+        if (auto const context = lifetime.lock())
+        {
+            context->delete_texture_later(tex);
+        }
+    }
+
+    /// Copies the contents of the bound framebuffer
+    void copy_framebuffer()
+    {
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, size_.width.as_int(), size_.height.as_int());
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return size_;
+    }
+
+    auto pixel_format() const -> MirPixelFormat override
+    {
+        return mir_pixel_format_xbgr_8888;
+    }
+
+    auto native_buffer_base() -> mg::NativeBufferBase* override
+    {
+        return this;
+    }
+
+    auto shader(mg::gl::ProgramFactory& cache) const -> mg::gl::Program const& override
+    {
+        static int rgb_shader{0};
+        return cache.compile_fragment_shader(
+            &rgb_shader,
+            "",
+            "uniform sampler2D tex;\n"
+            "vec4 sample_to_rgba(in vec2 texcoord)\n"
+            "{\n"
+            "    return vec4(texture2D(tex, texcoord).rgb, 1.0);\n"
+            "}\n");
+    }
+
+    auto layout() const -> Layout override
+    {
+        return layout_;
+    }
+
+    void bind() override
+    {
+        glBindTexture(GL_TEXTURE_2D, tex);
+    }
+
+    void add_syncpoint() override
+    {
+    }
+
+private:
+    geom::Size const size_;
+    Layout const layout_;
+    std::weak_ptr<mg::gl::ContextLifetime> const lifetime;
+    GLuint tex{0};
+};
+
 mrg::Renderer::Renderer(
     std::shared_ptr<graphics::GLRenderingProvider> gl_interface,
     std::unique_ptr<graphics::gl::OutputSurface> output)
@@ -288,7 +600,8 @@ mrg::Renderer::Renderer(
       clear_color{0.0f, 0.0f, 0.0f, 1.0f},
       program_factory{std::make_unique<ProgramFactory>()},
       display_transform(1),
-      gl_interface{std::move(gl_interface)}
+      gl_interface{std::move(gl_interface)},
+      context_lifetime{std::make_shared<mg::gl::ContextLifetime>()}
 {
     eglBindAPI(EGL_OPENGL_ES_API);
     EGLDisplay disp = eglGetCurrentDisplay();
@@ -337,11 +650,22 @@ mrg::Renderer::Renderer(
     mir::log_info("GL framebuffer bits: RGBA=%d%d%d%d, depth=%d, stencil=%d",
                   rbits, gbits, bbits, abits, dbits, sbits);
 
+    glGenBuffers(1, &vertex_buffer);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 mrg::Renderer::~Renderer()
 {
+    {
+        std::lock_guard lock{last_retained_frame_mutex};
+        last_retained_frame.reset();
+        retained_frames.clear();
+    }
+    context_lifetime->delete_pending();
+    if (vertex_buffer)
+    {
+        glDeleteBuffers(1, &vertex_buffer);
+    }
 }
 
 void mrg::Renderer::tessellate(std::vector<mgl::Primitive>& primitives,
@@ -353,21 +677,89 @@ void mrg::Renderer::tessellate(std::vector<mgl::Primitive>& primitives,
 
 auto mrg::Renderer::render(mg::RenderableList const& renderables) const -> std::unique_ptr<mg::Framebuffer>
 {
+    auto const start = std::chrono::steady_clock::now();
+
     output_surface->make_current();
     output_surface->bind();
+    mg::gl::ContextLifetime::Current const in_context{context_lifetime};
+    context_lifetime->delete_pending();
+
+    repaint_area = partial_repaint_area();
 
     glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-    glClear(GL_COLOR_BUFFER_BIT);
+    if (repaint_area)
+    {
+        // The rest of the buffer already holds what we'd draw there
+        geom::Rectangles damage;
+        glEnable(GL_SCISSOR_TEST);
+        for (auto const& rect : *repaint_area)
+        {
+            auto const scissor = to_gl_window_coords(rect);
+            damage.add(scissor);
+            glScissor(
+                scissor.left().as_int(), scissor.top().as_int(),
+                scissor.size.width.as_int(), scissor.size.height.as_int());
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        glDisable(GL_SCISSOR_TEST);
+        output_surface->set_damage(damage);
+    }
+    else
+    {
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
 
-    ++frameno;
+    commands.clear();
+    passes.clear();
+    vertices.clear();
     for (auto const& r : renderables)
     {
         draw(*r);
     }
+    draw_frame();
+
+    if (!drawn_first_frame)
+    {
+        // The first frame usually has to prepare the GL programs, so is the slowest
+        drawn_first_frame = true;
+        auto const elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start);
+        mir::log_info("Drew first frame in %.1fms", elapsed.count());
+    }
+
+    if (retaining_frames)
+    {
+        retain_frame();
+    }
 
     auto output = output_surface->commit();
 
+    // What changed between the previous frame and this one; if we don't know, or the previous
+    // frame was drawn with a different viewport or transform, that's everything.
+    geom::Rectangles changed;
+    if (frame_damage && !damage_history.empty())
+    {
+        for (auto const& rect : *frame_damage)
+        {
+            auto const visible = intersection_of(rect, viewport);
+            if (!is_empty(visible))
+            {
+                changed.add(visible);
+            }
+        }
+    }
+    else
+    {
+        changed.add(viewport);
+    }
+    damage_history.push_front(std::move(changed));
+    if (damage_history.size() > max_tracked_buffer_age)
+    {
+        damage_history.pop_back();
+    }
+    frame_damage.reset();
+    repaint_area.reset();
+
     // Report any GL errors after commit, to catch any *during* commit
     while (auto const gl_error = glGetError())
         mir::log_debug("GL error: %d", gl_error);
@@ -378,22 +770,94 @@ auto mrg::Renderer::render(mg::RenderableList const& renderables) const -> std::
 void mrg::Renderer::draw(mg::Renderable const& renderable) const
 {
     auto const clip_area = renderable.clip_area();
-    if (clip_area)
+
+    if (repaint_area)
     {
-        glEnable(GL_SCISSOR_TEST);
-        glScissor(
-            clip_area.value().top_left.x.as_int() -
-                viewport.top_left.x.as_int(),
-            viewport.top_left.y.as_int() +
-                viewport.size.height.as_int() -
-                clip_area.value().top_left.y.as_int() -
-                clip_area.value().size.height.as_int(),
-            clip_area.value().size.width.as_int(), 
-            clip_area.value().size.height.as_int()
-        );
+        bool const untransformed = renderable.transformation() == glm::mat4{1};
+        auto const repainted =
+            [&](geom::Rectangle const& rect)
+            {
+                return (!clip_area || clip_area->overlaps(rect)) &&
+                       (!untransformed || renderable.screen_position().overlaps(rect));
+            };
+        if (std::none_of(repaint_area->begin(), repaint_area->end(), repainted))
+        {
+            return;
+        }
+    }
+
+    bool const shaped = renderable.shaped();
+    auto const first_pass = passes.size();
+
+    if (shaped && renderable.alpha() == 1.0f && renderable.transformation() == glm::mat4{1})
+    {
+        // Draw the parts the client has told us are opaque without blending
+        auto const area = clip_area ?
+            intersection_of(renderable.screen_position(), *clip_area) : renderable.screen_position();
+
+        geom::Rectangles opaque_area;
+        for (auto const& rect : renderable.opaque_region())
+        {
+            auto const opaque = intersection_of(rect, area);
+            if (!is_empty(opaque))
+            {
+                opaque_area.add(opaque);
+                passes.push_back({opaque, true});
+            }
+        }
+
+        if (passes.size() != first_pass)
+        {
+            geom::Region translucent_area{area};
+            translucent_area.subtract(geom::Region{opaque_area});
+            for (auto const& translucent : translucent_area.rectangles())
+            {
+                passes.push_back({translucent, false});
+            }
+        }
+    }
+    if (passes.size() == first_pass)
+    {
+        passes.push_back({clip_area, false});
     }
 
-    auto const texture = gl_interface->as_texture(renderable.buffer());
+    // Limits this renderable's passes to the parts of them within area
+    auto const restrict_passes_to =
+        [&](geom::Rectangles const& area)
+        {
+            std::vector<DrawPass> const unrestricted{passes.begin() + first_pass, passes.end()};
+            passes.resize(first_pass);
+            for (auto const& pass : unrestricted)
+            {
+                for (auto const& rect : area)
+                {
+                    auto const scissor = pass.scissor ? intersection_of(*pass.scissor, rect) : rect;
+                    if (!is_empty(scissor))
+                    {
+                        passes.push_back({scissor, pass.opaque});
+                    }
+                }
+            }
+        };
+
+    if (auto const visible = renderable.visible_region())
+    {
+        // Leave what is drawn over this renderable undrawn
+        restrict_passes_to(*visible);
+    }
+
+    if (repaint_area)
+    {
+        // The rest of the output already holds this renderable
+        restrict_passes_to(*repaint_area);
+    }
+
+    if (passes.size() == first_pass)
+    {
+        return;
+    }
+
+    auto texture = gl_interface->as_texture(renderable.buffer());
 
     // All the programs are held by program_factory through its lifetime. Using pointers avoids
     // -Wdangling-reference.
@@ -408,32 +872,17 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
                 return &family.opaque;
         }(renderable.alpha() < 1.0f);
 
-    glUseProgram(prog->id);
-    if (prog->last_used_frameno != frameno)
-    {   // Avoid reloading the screen-global uniforms on every renderable
-        // TODO: We actually only need to bind these *once*, right? Not once per frame?
-        prog->last_used_frameno = frameno;
-        for (auto i = 0u; i < prog->tex_uniforms.size(); ++i)
-        {
-            if (prog->tex_uniforms[i] != -1)
-            {
-                glUniform1i(prog->tex_uniforms[i], i);
-            }
-        }
-        glUniformMatrix4fv(prog->display_transform_uniform, 1, GL_FALSE,
-                           glm::value_ptr(display_transform));
-        glUniformMatrix4fv(prog->screen_to_gl_coords_uniform, 1, GL_FALSE,
-                           glm::value_ptr(screen_to_gl_coords));
-    }
-
-    glActiveTexture(GL_TEXTURE0);
+    // These renderable method names could be better (see LP: #1236224)
+    auto const blend =
+        shaped ? Blend::premultiplied :                         // Client is RGBA
+        renderable.alpha() == 1.0f ? Blend::none :              // RGBX and no window translucency
+        Blend::constant_alpha;                                  // RGBX, but with window translucency
 
     auto const& rect = renderable.screen_position();
-    GLfloat centrex = rect.top_left.x.as_int() +
-                      rect.size.width.as_int() / 2.0f;
-    GLfloat centrey = rect.top_left.y.as_int() +
-                      rect.size.height.as_int() / 2.0f;
-    glUniform2f(prog->centre_uniform, centrex, centrey);
+    glm::vec4 const centre{
+        rect.top_left.x.as_int() + rect.size.width.as_int() / 2.0f,
+        rect.top_left.y.as_int() + rect.size.height.as_int() / 2.0f,
+        0.0f, 0.0f};
 
     glm::mat4 transform = renderable.transformation();
     if (texture->layout() == mg::gl::Texture::Layout::TopRowFirst)
@@ -448,90 +897,283 @@ void mrg::Renderer::draw(mg::Renderable const& renderable) const
         };
     }
 
-    glUniformMatrix4fv(prog->transform_uniform, 1, GL_FALSE,
-                       glm::value_ptr(transform));
+    primitives.clear();
+    tessellate(primitives, renderable);
 
-    if (prog->alpha_uniform >= 0)
-        glUniform1f(prog->alpha_uniform, renderable.alpha());
+    // Everything is drawn as GL_TRIANGLES, so that all the primitives can be drawn at once
+    auto const first_vertex = vertices.size();
+    bool flat{true};
+    auto const add_vertex = [&](mgl::Vertex const& vertex)
+        {
+            glm::vec4 const position{vertex.position[0], vertex.position[1], vertex.position[2], 1.0f};
+            auto const transformed = transform * (position - centre) + centre;
+            flat = flat && transformed.z == 0.0f && transformed.w == 1.0f;
+
+            Vertex baked;
+            baked.position[0] = transformed.x;
+            baked.position[1] = transformed.y;
+            baked.position[2] = transformed.z;
+            baked.position[3] = transformed.w;
+            baked.texcoord[0] = vertex.texcoord[0];
+            baked.texcoord[1] = vertex.texcoord[1];
+            vertices.push_back(baked);
+        };
+    for (auto const& primitive : primitives)
+    {
+        for_each_triangle(primitive, [&](mgl::Vertex const& a, mgl::Vertex const& b, mgl::Vertex const& c)
+            {
+                add_vertex(a);
+                add_vertex(b);
+                add_vertex(c);
+            });
+    }
 
-    glEnableVertexAttribArray(prog->position_attr);
-    glEnableVertexAttribArray(prog->texcoord_attr);
+    /* We can only tell where a renderable lands on the screen if it's not been moved out of the
+     * z = 0 plane, as anything else is subject to perspective
+     */
+    std::optional<geom::Rectangle> bounds;
+    if (flat && vertices.size() != first_vertex)
+    {
+        auto left{vertices[first_vertex].position[0]}, right{left};
+        auto top{vertices[first_vertex].position[1]}, bottom{top};
+        for (auto i = first_vertex; i != vertices.size(); ++i)
+        {
+            left = std::min(left, vertices[i].position[0]);
+            right = std::max(right, vertices[i].position[0]);
+            top = std::min(top, vertices[i].position[1]);
+            bottom = std::max(bottom, vertices[i].position[1]);
+        }
 
-    primitives.clear();
-    tessellate(primitives, renderable);
+        auto const x = static_cast<int>(std::floor(left));
+        auto const y = static_cast<int>(std::floor(top));
+        geom::Rectangle const extent{
+            {x, y},
+            {static_cast<int>(std::ceil(right)) - x, static_cast<int>(std::ceil(bottom)) - y}};
+        bounds = clip_area ? intersection_of(extent, *clip_area) : extent;
+    }
 
-    // if we fail to load the texture, we need to carry on (part of lp:1629275)
-    try
+    commands.push_back({
+        std::move(texture),
+        prog,
+        blend,
+        renderable.alpha(),
+        static_cast<GLint>(first_vertex),
+        static_cast<GLsizei>(vertices.size() - first_vertex),
+        first_pass,
+        passes.size() - first_pass,
+        bounds});
+}
+
+auto mrg::Renderer::draw_order() const -> std::vector<size_t> const&
+{
+    /* Group renderables that are drawn with the same program and blending into runs, by
+     * moving each renderable back to the latest run it matches. That's only possible if
+     * it doesn't overlap anything drawn in the runs it would be moved in front of.
+     */
+    struct Run
     {
-        typedef struct  // Represents parameters of glBlendFuncSeparate()
+        size_t first_command;
+        std::vector<size_t> members;
+    };
+    std::vector<Run> runs;
+
+    auto const same_state = [](DrawCommand const& a, DrawCommand const& b)
         {
-            GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
-        } BlendSeparate;
+            return a.program == b.program && a.blend == b.blend && a.alpha == b.alpha;
+        };
+    auto const overlaps = [this](Run const& run, DrawCommand const& command)
+        {
+            for (auto const i : run.members)
+            {
+                auto const& member = commands[i];
+                if (!member.bounds || member.bounds->overlaps(*command.bounds))
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
 
-        BlendSeparate client_blend;
+    for (size_t i = 0; i != commands.size(); ++i)
+    {
+        auto const& command = commands[i];
 
-        // These renderable method names could be better (see LP: #1236224)
-        if (renderable.shaped())  // Client is RGBA:
+        bool placed{false};
+        if (command.bounds)
         {
-            client_blend = {GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
-                            GL_ONE, GL_ONE_MINUS_SRC_ALPHA};
+            for (auto run = runs.rbegin(); run != runs.rend() && run - runs.rbegin() < max_reordering_distance; ++run)
+            {
+                if (same_state(commands[run->first_command], command))
+                {
+                    run->members.push_back(i);
+                    placed = true;
+                    break;
+                }
+                if (overlaps(*run, command))
+                {
+                    break;
+                }
+            }
         }
-        else if (renderable.alpha() == 1.0f)  // RGBX and no window translucency:
+
+        if (!placed)
         {
-            client_blend = {GL_ONE,  GL_ZERO,
-                            GL_ZERO, GL_ONE};  // Avoid using src_alpha!
-        }
-        else
-        {   // Client is RGBX but we also have window translucency.
-            // The texture alpha channel is possibly uninitialized so we must be
-            // careful and avoid using SRC_ALPHA (LP: #1423462).
-            client_blend = {GL_ONE,  GL_ONE_MINUS_CONSTANT_ALPHA,
-                            GL_ZERO, GL_ONE};
-            glBlendColor(0.0f, 0.0f, 0.0f, renderable.alpha());
+            runs.push_back({i, {i}});
         }
+    }
 
-        for (auto const& p : primitives)
-        {
-            BlendSeparate blend;
+    order.clear();
+    for (auto const& run : runs)
+    {
+        order.insert(order.end(), run.members.begin(), run.members.end());
+    }
+    return order;
+}
 
-            blend = client_blend;
-            texture->bind();
+void mrg::Renderer::draw_frame() const
+{
+    if (commands.empty())
+    {
+        return;
+    }
+
+    // One upload for the whole frame; GL_STREAM_DRAW with new storage each frame avoids
+    // waiting for the GPU to finish with the previous frame's vertices
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STREAM_DRAW);
+    glActiveTexture(GL_TEXTURE0);
 
-            glVertexAttribPointer(prog->position_attr, 3, GL_FLOAT,
-                                  GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].position);
-            glVertexAttribPointer(prog->texcoord_attr, 2, GL_FLOAT,
-                                  GL_FALSE, sizeof(mgl::Vertex),
-                                  &p.vertices[0].texcoord);
+    // The GL state left by the previous frame (or anything else) is unknown
+    Program const* current_program{nullptr};
+    std::optional<Blend> current_blend;
+    std::optional<GLfloat> current_blend_alpha;
+    bool scissoring{false};
+
+    for (auto const i : draw_order())
+    {
+        auto const& command = commands[i];
+        auto const* const prog = command.program;
 
-            if (blend.dst_rgb == GL_ZERO)
+        if (prog != current_program)
+        {
+            if (current_program)
             {
-                glDisable(GL_BLEND);
+                glDisableVertexAttribArray(current_program->texcoord_attr);
+                glDisableVertexAttribArray(current_program->position_attr);
             }
-            else
+            current_program = prog;
+
+            glUseProgram(prog->id);
+            if (prog->output_serial != output_serial)
             {
-                glEnable(GL_BLEND);
-                glBlendFuncSeparate(blend.src_rgb,   blend.dst_rgb,
-                                    blend.src_alpha, blend.dst_alpha);
+                // The screen-global uniforms only need loading again when the output changes
+                prog->output_serial = output_serial;
+                for (auto unit = 0u; unit < prog->tex_uniforms.size(); ++unit)
+                {
+                    if (prog->tex_uniforms[unit] != -1)
+                    {
+                        glUniform1i(prog->tex_uniforms[unit], unit);
+                    }
+                }
+                glUniformMatrix4fv(prog->display_transform_uniform, 1, GL_FALSE,
+                                   glm::value_ptr(display_transform));
+                glUniformMatrix4fv(prog->screen_to_gl_coords_uniform, 1, GL_FALSE,
+                                   glm::value_ptr(screen_to_gl_coords));
             }
 
-            glDrawArrays(p.type, 0, p.nvertices);
+            glEnableVertexAttribArray(prog->position_attr);
+            glEnableVertexAttribArray(prog->texcoord_attr);
+            glVertexAttribPointer(prog->position_attr, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                                  reinterpret_cast<void const*>(offsetof(Vertex, position)));
+            glVertexAttribPointer(prog->texcoord_attr, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+                                  reinterpret_cast<void const*>(offsetof(Vertex, texcoord)));
+        }
+
+        if (prog->alpha_uniform >= 0 && prog->alpha != command.alpha)
+        {
+            prog->alpha = command.alpha;
+            glUniform1f(prog->alpha_uniform, command.alpha);
+        }
+
+        // if we fail to load the texture, we need to carry on (part of lp:1629275)
+        try
+        {
+            command.texture->bind();
+
+            for (auto p = command.first_pass; p != command.first_pass + command.pass_count; ++p)
+            {
+                auto const& pass = passes[p];
+                if (pass.scissor)
+                {
+                    if (!scissoring)
+                    {
+                        glEnable(GL_SCISSOR_TEST);
+                        scissoring = true;
+                    }
+                    auto const scissor = to_gl_window_coords(*pass.scissor);
+                    glScissor(
+                        scissor.left().as_int(), scissor.top().as_int(),
+                        scissor.size.width.as_int(), scissor.size.height.as_int());
+                }
+                else if (scissoring)
+                {
+                    glDisable(GL_SCISSOR_TEST);
+                    scissoring = false;
+                }
+
+                auto const blend = pass.opaque ? Blend::none : command.blend;
+                if (blend != current_blend)
+                {
+                    switch (blend)
+                    {
+                    case Blend::none:
+                        glDisable(GL_BLEND);
+                        break;
+
+                    case Blend::premultiplied:
+                        glEnable(GL_BLEND);
+                        glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA,
+                                            GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+                        break;
+
+                    case Blend::constant_alpha:
+                        // The texture alpha channel is possibly uninitialized so we must be
+                        // careful and avoid using SRC_ALPHA (LP: #1423462).
+                        glEnable(GL_BLEND);
+                        glBlendFuncSeparate(GL_ONE,  GL_ONE_MINUS_CONSTANT_ALPHA,
+                                            GL_ZERO, GL_ONE);
+                        break;
+                    }
+                    current_blend = blend;
+                }
+                if (blend == Blend::constant_alpha && current_blend_alpha != command.alpha)
+                {
+                    glBlendColor(0.0f, 0.0f, 0.0f, command.alpha);
+                    current_blend_alpha = command.alpha;
+                }
+
+                glDrawArrays(GL_TRIANGLES, command.first_vertex, command.vertex_count);
+            }
 
             // We're done with the texture for now
-            texture->add_syncpoint();
+            command.texture->add_syncpoint();
+        }
+        catch (std::exception const& ex)
+        {
+            report_exception();
         }
-    }
-    catch (std::exception const& ex)
-    {
-        report_exception();
     }
 
-    glDisableVertexAttribArray(prog->texcoord_attr);
-    glDisableVertexAttribArray(prog->position_attr);
-    if (renderable.clip_area())
+    glDisableVertexAttribArray(current_program->texcoord_attr);
+    glDisableVertexAttribArray(current_program->position_attr);
+    if (scissoring)
     {
         glDisable(GL_SCISSOR_TEST);
     }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Don't hold on to the clients' buffers until the next frame
+    commands.clear();
 }
 
 void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
@@ -574,7 +1216,9 @@ void mrg::Renderer::set_viewport(geometry::Rectangle const& rect)
                       0.0f});
 
     viewport = rect;
+    ++output_serial;
     update_gl_viewport();
+    invalidate_previous_frames();
 }
 
 void mrg::Renderer::update_gl_viewport()
@@ -634,11 +1278,141 @@ void mrg::Renderer::set_output_transform(glm::mat2 const& t)
     if (new_display_transform != display_transform)
     {
         display_transform = new_display_transform;
+        ++output_serial;
+        untransformed_output = (t == glm::mat2{1});
         update_gl_viewport();
+        invalidate_previous_frames();
+    }
+}
+
+void mrg::Renderer::set_damage(geometry::Rectangles const& damage)
+{
+    frame_damage = damage;
+}
+
+void mrg::Renderer::invalidate_previous_frames()
+{
+    damage_history.clear();
+}
+
+auto mrg::Renderer::partial_repaint_area() const -> std::optional<geom::Rectangles>
+{
+    // We only know how damage maps to the output when it is drawn 1:1 (flipped or not)
+    if (!frame_damage ||
+        !untransformed_output ||
+        output_surface->size() != viewport.size)
+    {
+        return std::nullopt;
+    }
+
+    // A buffer of age N holds the frame committed N frames ago, and we need to have drawn all of
+    // those frames to know what has changed since.
+    auto const age = output_surface->buffer_age();
+    if (age <= 0 || static_cast<size_t>(age) > damage_history.size())
+    {
+        return std::nullopt;
+    }
+
+    geom::Region changed{*frame_damage};
+    for (auto i = 0; i < age - 1; ++i)
+    {
+        changed.unite(geom::Region{damage_history[i]});
+    }
+    changed.intersect(geom::Region{viewport});
+
+    return merged_repaint_rectangles(changed.rectangles());
+}
+
+auto mrg::Renderer::to_gl_window_coords(geom::Rectangle const& rect) const -> geom::Rectangle
+{
+    switch (output_surface->layout())
+    {
+    case graphics::gl::OutputSurface::Layout::TopRowFirst:
+        // We render upside-down (see set_output_transform()), so GL rows count down from the top
+        return {rect.top_left - as_displacement(viewport.top_left), rect.size};
+
+    case graphics::gl::OutputSurface::Layout::GL:
+        break;
+    }
+
+    return {
+        {
+            rect.left().as_int() - viewport.left().as_int(),
+            viewport.top().as_int() + viewport.size.height.as_int() - rect.top().as_int() - rect.size.height.as_int()
+        },
+        rect.size};
+}
+
+void mrg::Renderer::retain_frames(bool retain)
+{
+    retaining_frames = retain;
+    if (!retain)
+    {
+        std::lock_guard lock{last_retained_frame_mutex};
+        last_retained_frame.reset();
+    }
+}
+
+auto mrg::Renderer::last_frame() const -> std::shared_ptr<mg::Buffer>
+{
+    std::lock_guard lock{last_retained_frame_mutex};
+    return last_retained_frame;
+}
+
+void mrg::Renderer::retain_frame() const
+{
+    // Double buffering is enough unless a capture holds on to a frame for a long time
+    size_t const max_retained_frames = 3;
+
+    std::lock_guard lock{last_retained_frame_mutex};
+
+    auto const size = output_surface->size();
+    if (!untransformed_output || size != viewport.size)
+    {
+        // Only a frame drawn 1:1 can stand in for the scene
+        last_retained_frame.reset();
+        return;
+    }
+
+    auto const layout = output_surface->layout() == mg::gl::OutputSurface::Layout::TopRowFirst ?
+        mg::gl::Texture::Layout::TopRowFirst : mg::gl::Texture::Layout::GL;
+
+    // Frames of another size or layout will not be used again
+    std::erase_if(
+        retained_frames,
+        [&](auto const& frame)
+        {
+            return frame.use_count() == 1 && (frame->size() != size || frame->layout() != layout);
+        });
+
+    auto const free_frame = std::find_if(
+        retained_frames.begin(), retained_frames.end(),
+        [](auto const& frame) { return frame.use_count() == 1; });
+
+    std::shared_ptr<RetainedFrame> frame;
+    if (free_frame != retained_frames.end())
+    {
+        frame = *free_frame;
     }
+    else if (retained_frames.size() < max_retained_frames)
+    {
+        frame = retained_frames.emplace_back(std::make_shared<RetainedFrame>(size, layout, context_lifetime));
+    }
+    else
+    {
+        // Every frame is still being read, so we have nowhere to put this one
+        last_retained_frame.reset();
+        return;
+    }
+
+    frame->copy_framebuffer();
+    // Other contexts only see the copy once GL has been told to do it
+    glFlush();
+    last_retained_frame = std::move(frame);
 }
 
 void mrg::Renderer::suspend()
 {
+    frame_damage.reset();
     output_surface->release_current();
 }
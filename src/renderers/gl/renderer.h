@@ -22,8 +22,13 @@
 #include <mir/graphics/buffer_id.h>
 #include <mir/graphics/renderable.h>
 #include <mir/gl/primitive.h>
+#include <mir/graphics/gl_context_lifetime.h>
 
 #include <GLES2/gl2.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -31,7 +36,7 @@
 namespace mir
 {
 namespace graphics { class GLRenderingProvider; }
-namespace graphics::gl { class OutputSurface; }
+namespace graphics::gl { class OutputSurface; class Texture; }
 namespace renderer
 {
 namespace gl
@@ -46,11 +51,15 @@ public:
     // These are called with a valid GL context:
     void set_viewport(geometry::Rectangle const& rect) override;
     void set_output_transform(glm::mat2 const&) override;
+    void set_damage(geometry::Rectangles const& damage) override;
     auto render(graphics::RenderableList const&) const -> std::unique_ptr<graphics::Framebuffer> override;
 
     // This is called _without_ a GL context:
     void suspend() override;
 
+    void retain_frames(bool retain) override;
+    auto last_frame() const -> std::shared_ptr<graphics::Buffer> override;
+
     struct Program
     {
         GLuint id = 0;
@@ -61,12 +70,12 @@ public:
         std::array<GLint, 8> tex_uniforms;
         GLint position_attr = -1;
         GLint texcoord_attr = -1;
-        GLint centre_uniform = -1;
         GLint display_transform_uniform = -1;
-        GLint transform_uniform = -1;
         GLint screen_to_gl_coords_uniform = -1;
         GLint alpha_uniform = -1;
-        mutable long long last_used_frameno = 0;
+        /// The Renderer::output_serial the screen-global uniforms were last loaded for
+        mutable unsigned long long output_serial = 0;
+        mutable GLfloat alpha = -1.0f;
 
         Program(GLuint program_id);
     };
@@ -95,12 +104,55 @@ protected:
 
     GLfloat clear_color[4];
 
-    mutable long long frameno = 0;
-
+    /**
+     * Adds renderable to the frame being drawn by render().
+     *
+     * The GL calls to draw it are made once every renderable has been added, so that
+     * renderables can share a vertex buffer and, where they don't overlap, be reordered
+     * to minimise changes of GL state.
+     */
     virtual void draw(graphics::Renderable const& renderable) const;
 
 private:
+    /// How the client's pixels are blended with what's beneath them
+    enum class Blend
+    {
+        none,               ///< The client's pixels replace what's beneath
+        premultiplied,      ///< The client has premultiplied alpha
+        constant_alpha      ///< The client has no alpha, but the renderable is translucent
+    };
+
+    /// A renderable, queued to be drawn by draw_frame()
+    struct DrawCommand
+    {
+        std::shared_ptr<graphics::gl::Texture> texture;
+        Program const* program;
+        Blend blend;
+        GLfloat alpha;
+        GLint first_vertex;
+        GLsizei vertex_count;
+        size_t first_pass;
+        size_t pass_count;
+        /// The area drawn to, if it is known
+        std::optional<geometry::Rectangle> bounds;
+    };
+
+    /// Vertex positions have the renderable's transformation already applied
+    struct Vertex
+    {
+        GLfloat position[4];
+        GLfloat texcoord[2];
+    };
+
+    void draw_frame() const;
+    /// Copies the frame just drawn for last_frame(), if it is drawn 1:1
+    void retain_frame() const;
+    auto draw_order() const -> std::vector<size_t> const&;
+
     void update_gl_viewport();
+    void invalidate_previous_frames();
+    auto partial_repaint_area() const -> std::optional<geometry::Rectangles>;
+    auto to_gl_window_coords(geometry::Rectangle const& rect) const -> geometry::Rectangle;
 
     class ProgramFactory;
     std::unique_ptr<ProgramFactory> const program_factory;
@@ -109,6 +161,39 @@ private:
     glm::mat4 display_transform;
     std::vector<mir::gl::Primitive> mutable primitives;
     std::shared_ptr<graphics::GLRenderingProvider> const gl_interface;
+    /// Lets textures kept per context by our clients' buffers tell our context from any other
+    std::shared_ptr<graphics::gl::ContextLifetime> const context_lifetime;
+
+    /// Whether the output is drawn 1:1, so screen and GL window coordinates differ only by a translation
+    bool untransformed_output{true};
+    std::optional<geometry::Rectangles> mutable frame_damage;
+    /// Damage of each of the recently committed frames, most recent first
+    std::deque<geometry::Rectangles> mutable damage_history;
+    /// The disjoint parts of the viewport being redrawn by the current render(), if not all of it
+    std::optional<geometry::Rectangles> mutable repaint_area;
+
+    /// A region of a renderable to draw with a single blend mode
+    struct DrawPass
+    {
+        std::optional<geometry::Rectangle> scissor;
+        bool opaque;
+    };
+    std::vector<DrawPass> mutable passes;
+
+    /// Incremented whenever the screen-global uniforms change
+    unsigned long long output_serial{1};
+    std::vector<DrawCommand> mutable commands;
+    std::vector<Vertex> mutable vertices;
+    std::vector<size_t> mutable order;
+    GLuint vertex_buffer{0};
+    bool mutable drawn_first_frame{false};
+
+    class RetainedFrame;
+    bool retaining_frames{false};
+    /// Copies of recent frames; those only we hold can be drawn into again
+    std::vector<std::shared_ptr<RetainedFrame>> mutable retained_frames;
+    std::mutex mutable last_retained_frame_mutex;
+    std::shared_ptr<RetainedFrame> mutable last_retained_frame;
 };
 
 }
@@ -15,6 +15,7 @@
  */
 
 #include "basic_screen_shooter.h"
+#include "composited_frame_store.h"
 #include "mir/graphics/drm_formats.h"
 #include "mir/graphics/gl_config.h"
 #include "mir/renderer/renderer.h"
@@ -27,6 +28,12 @@
 #include "mir/renderer/renderer_factory.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/graphics/display_sink.h"
+#include "mir/graphics/dmabuf_buffer.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <optional>
 
 namespace mc = mir::compositor;
 namespace mr = mir::renderer;
@@ -94,23 +101,66 @@ public:
         return next_buffer->size();
     }
 
-    void set_next_buffer(std::shared_ptr<mrs::WriteMappableBuffer> buffer)
+    auto holds_previous_frame() const -> bool override
+    {
+        return next_holds_previous_frame;
+    }
+
+    /// \param holds_previous_frame  Whether buffer already holds the previous capture, outside the damage
+    void set_next_buffer(std::shared_ptr<mrs::WriteMappableBuffer> buffer, bool holds_previous_frame)
     {
         if (next_buffer)
         {
             BOOST_THROW_EXCEPTION((std::logic_error{"Attempt to set next buffer with a buffer already pending"}));
         }
         next_buffer = std::move(buffer);
+        next_holds_previous_frame = holds_previous_frame;
+    }
+
+    void discard_next_buffer()
+    {
+        next_buffer = nullptr;
     }
 private:
     std::shared_ptr<mrs::WriteMappableBuffer> next_buffer;
+    bool next_holds_previous_frame{false};
+};
+
+class mc::BasicScreenShooter::Self::OneShotDMABufDisplayProvider : public mg::DMABufTargetAllocator
+{
+public:
+    auto claim_target() -> std::shared_ptr<mg::DMABufBuffer> override
+    {
+        return std::exchange(next_target, nullptr);
+    }
+
+    auto output_size() const -> geom::Size override
+    {
+        // The surface asks while it renders, after claiming the target
+        return target_size;
+    }
+
+    void set_next_target(std::shared_ptr<mg::DMABufBuffer> target)
+    {
+        if (next_target)
+        {
+            BOOST_THROW_EXCEPTION((std::logic_error{"Attempt to set next target with a target already pending"}));
+        }
+        target_size = target->size();
+        next_target = std::move(target);
+    }
+private:
+    std::shared_ptr<mg::DMABufBuffer> next_target;
+    geom::Size target_size;
 };
 
+namespace
+{
 class OffscreenDisplaySink : public mg::DisplaySink
 {
 public:
     OffscreenDisplaySink(
-        std::shared_ptr<mg::CPUAddressableDisplayAllocator> provider,
+        std::shared_ptr<mg::DisplayAllocator> provider,
         geom::Size size)
         : provider {std::move(provider)},
           size{size}
@@ -142,95 +192,328 @@ protected:
     {
         if (dynamic_cast<mg::CPUAddressableDisplayAllocator::Tag const*>(&type_tag))
         {
-            return provider.get();
+            return dynamic_cast<mg::CPUAddressableDisplayAllocator*>(provider.get());
+        }
+        if (dynamic_cast<mg::DMABufTargetAllocator::Tag const*>(&type_tag))
+        {
+            return dynamic_cast<mg::DMABufTargetAllocator*>(provider.get());
         }
         return nullptr;
     }
 private:
-    std::shared_ptr<mg::CPUAddressableDisplayAllocator> const provider;
+    std::shared_ptr<mg::DisplayAllocator> const provider;
     geom::Size const size;
 };
 
+class NoAuxConfig : public mg::GLConfig
+{
+public:
+    auto depth_buffer_bits() const -> int override
+    {
+        return 0;
+    }
+    auto stencil_buffer_bits() const -> int override
+    {
+        return 0;
+    }
+};
+
+/// More than we'd expect to be captured at once; beyond this, renderers that aren't in use are dropped
+auto const max_area_renderers = 8u;
+
+/// Draws a frame composited for an output in place of the scene it shows
+class CompositedFrameRenderable : public mg::Renderable
+{
+public:
+    explicit CompositedFrameRenderable(mc::CompositedFrameStore::Frame frame)
+        : frame{std::move(frame)}
+    {
+    }
+
+    auto id() const -> ID override
+    {
+        return this;
+    }
+
+    auto buffer() const -> std::shared_ptr<mg::Buffer> override
+    {
+        return frame.buffer;
+    }
+
+    auto screen_position() const -> geom::Rectangle override
+    {
+        return frame.area;
+    }
+
+    auto clip_area() const -> std::optional<geom::Rectangle> override
+    {
+        return std::nullopt;
+    }
+
+    auto alpha() const -> float override
+    {
+        return 1.0f;
+    }
+
+    auto transformation() const -> glm::mat4 override
+    {
+        return glm::mat4{1};
+    }
+
+    auto shaped() const -> bool override
+    {
+        return false;
+    }
+
+    auto damage() const -> geom::Rectangles override
+    {
+        return {frame.area};
+    }
+
+    auto opaque_region() const -> geom::Rectangles override
+    {
+        return {frame.area};
+    }
+
+private:
+    mc::CompositedFrameStore::Frame const frame;
+};
+}
+
+class mc::BasicScreenShooter::Self::AreaRenderer
+{
+public:
+    AreaRenderer(
+        geom::Rectangle const& area,
+        bool to_dma_buf,
+        std::shared_ptr<mg::GLRenderingProvider> render_provider,
+        std::shared_ptr<mr::RendererFactory> renderer_factory)
+        : area{area},
+          to_dma_buf{to_dma_buf},
+          render_provider{std::move(render_provider)},
+          renderer_factory{std::move(renderer_factory)},
+          cpu_output{to_dma_buf ? nullptr : std::make_shared<OneShotBufferDisplayProvider>()},
+          dma_buf_output{to_dma_buf ? std::make_shared<OneShotDMABufDisplayProvider>() : nullptr}
+    {
+    }
+
+    geom::Rectangle const area;
+    bool const to_dma_buf;
+
+    auto provider() const -> mg::GLRenderingProvider const&
+    {
+        return *render_provider;
+    }
+
+    /// Queues job, returning whether the caller needs to drain() the queue
+    auto push(std::function<void(AreaRenderer&)>&& job) -> bool
+    {
+        std::lock_guard lock{mutex};
+        jobs.push_back(std::move(job));
+        return !std::exchange(draining, true);
+    }
+
+    /// Runs queued jobs in order, one at a time, until there are none left
+    void drain()
+    {
+        std::unique_lock lock{mutex};
+        while (!jobs.empty())
+        {
+            auto job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+            job(*this);
+            lock.lock();
+        }
+        draining = false;
+    }
+
+    void render(
+        mg::RenderableList const& renderables,
+        std::shared_ptr<mrs::WriteMappableBuffer> buffer,
+        std::optional<geom::Rectangle> const& damage)
+    {
+        auto const size = buffer->size();
+        cpu_output->set_next_buffer(std::move(buffer), damage.has_value());
+        render(renderables, size, damage);
+    }
+
+    void render(mg::RenderableList const& renderables, std::shared_ptr<mg::DMABufBuffer> target)
+    {
+        auto const size = target->size();
+        dma_buf_output->set_next_target(std::move(target));
+        render(renderables, size, std::nullopt);
+    }
+
+private:
+    void render(
+        mg::RenderableList const& renderables,
+        geom::Size size,
+        std::optional<geom::Rectangle> const& damage)
+    {
+        auto& renderer = renderer_for(size);
+        renderer.set_viewport(area);
+        if (damage)
+        {
+            renderer.set_damage({*damage});
+        }
+        /* We don't need the result of this `render` call, as we know it's
+         * going into the buffer we just set
+         */
+        renderer.render(renderables);
+
+        // Because we might be called on a different thread next time we need to
+        // ensure the renderer doesn't keep the EGL context current
+        renderer.suspend();
+    }
+
+    auto renderer_for(geom::Size size) -> mr::Renderer&
+    {
+        if (size.height == geom::Height{0} || size.width == geom::Width{0})
+        {
+            discard_pending();
+            BOOST_THROW_EXCEPTION((std::runtime_error{"Attempt to capture to a zero-sized buffer"}));
+        }
+        if (size != rendered_size)
+        {
+            /* The Renderer instantiation is tied to a particular output size, and
+             * requires enough setup to make it worth keeping around as a consumer
+             * is likely to be taking screenshots of consistent size
+             */
+            try
+            {
+                std::shared_ptr<mg::DisplayAllocator> output = cpu_output;
+                if (to_dma_buf)
+                {
+                    output = dma_buf_output;
+                }
+                offscreen_sink = std::make_unique<OffscreenDisplaySink>(std::move(output), size);
+                auto gl_surface = render_provider->surface_for_sink(*offscreen_sink, NoAuxConfig{});
+                current_renderer = renderer_factory->create_renderer_for(std::move(gl_surface), render_provider);
+                rendered_size = size;
+            }
+            catch (...)
+            {
+                current_renderer.reset();
+                rendered_size = geom::Size{};
+                discard_pending();
+                throw;
+            }
+        }
+        return *current_renderer;
+    }
+
+    /// Drops the buffer we were to render into, so that the next capture can set its own
+    void discard_pending()
+    {
+        if (to_dma_buf)
+        {
+            dma_buf_output->claim_target();
+        }
+        else
+        {
+            cpu_output->discard_next_buffer();
+        }
+    }
+
+    std::shared_ptr<mg::GLRenderingProvider> const render_provider;
+    std::shared_ptr<mr::RendererFactory> const renderer_factory;
+    std::shared_ptr<OneShotBufferDisplayProvider> const cpu_output;
+    std::shared_ptr<OneShotDMABufDisplayProvider> const dma_buf_output;
+
+    std::unique_ptr<mg::DisplaySink> offscreen_sink;
+    std::unique_ptr<mr::Renderer> current_renderer;
+    geom::Size rendered_size{0, 0};
+
+    std::mutex mutex;
+    std::deque<std::function<void(AreaRenderer&)>> jobs;
+    bool draining{false};
+};
+
 mc::BasicScreenShooter::Self::Self(
     std::shared_ptr<Scene> const& scene,
     std::shared_ptr<time::Clock> const& clock,
-    std::shared_ptr<mg::GLRenderingProvider> render_provider,
-    std::shared_ptr<mr::RendererFactory> renderer_factory)
+    std::shared_ptr<mg::GLRenderingProvider> cpu_provider,
+    std::shared_ptr<mg::GLRenderingProvider> dma_buf_provider,
+    std::shared_ptr<mr::RendererFactory> renderer_factory,
+    std::shared_ptr<CompositedFrameStore> composited_frames)
     : scene{scene},
       clock{clock},
-      render_provider{std::move(render_provider)},
+      cpu_provider{std::move(cpu_provider)},
+      dma_buf_provider{std::move(dma_buf_provider)},
       renderer_factory{std::move(renderer_factory)},
-      last_rendered_size{0, 0},
-      output{std::make_shared<OneShotBufferDisplayProvider>()}
+      composited_frames{std::move(composited_frames)}
 {
 }
 
-auto mc::BasicScreenShooter::Self::render(
-    std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
-    geom::Rectangle const& area) -> time::Timestamp
+auto mc::BasicScreenShooter::Self::renderer_for(geom::Rectangle const& area, bool to_dma_buf)
+    -> std::shared_ptr<AreaRenderer>
 {
     std::lock_guard lock{mutex};
 
-    auto scene_elements = scene->scene_elements_for(this);
-    auto const captured_time = clock->now();
-    mg::RenderableList renderable_list;
-    renderable_list.reserve(scene_elements.size());
-    for (auto const& element : scene_elements)
+    auto const existing = std::find_if(
+        area_renderers.begin(), area_renderers.end(),
+        [&](auto const& renderer) { return renderer->area == area && renderer->to_dma_buf == to_dma_buf; });
+
+    if (existing != area_renderers.end())
     {
-        renderable_list.push_back(element->renderable());
+        return *existing;
     }
-    scene_elements.clear();
 
-    auto& renderer = renderer_for_buffer(buffer);
-    renderer.set_viewport(area);
-    /* We don't need the result of this `render` call, as we know it's
-     * going into the buffer we just set
-     */
-    renderer.render(renderable_list);
+    if (area_renderers.size() >= max_area_renderers)
+    {
+        // Anything only we hold has no capture queued or in progress
+        std::erase_if(area_renderers, [](auto const& renderer) { return renderer.use_count() == 1; });
+    }
 
-    // Because we might be called on a different thread next time we need to
-    // ensure the renderer doesn't keep the EGL context current
-    renderer.suspend();
-    return captured_time;
+    auto const renderer = std::make_shared<AreaRenderer>(
+        area,
+        to_dma_buf,
+        to_dma_buf ? dma_buf_provider : cpu_provider,
+        renderer_factory);
+    area_renderers.push_back(renderer);
+    return renderer;
 }
 
-auto mc::BasicScreenShooter::Self::renderer_for_buffer(std::shared_ptr<mrs::WriteMappableBuffer> buffer)
-    -> mr::Renderer&
+auto mc::BasicScreenShooter::Self::snapshot(AreaRenderer const& renderer)
+    -> std::pair<mg::RenderableList, time::Timestamp>
 {
-    auto const buffer_size = buffer->size();
-    if (buffer_size.height == geom::Height{0} || buffer_size.width == geom::Width{0})
+    if (composited_frames)
     {
-        BOOST_THROW_EXCEPTION((std::runtime_error{"Attempt to capture to a zero-sized buffer"}));
+        // A frame from another provider's GL contexts would be meaningless to ours
+        if (auto frame = composited_frames->frame_containing(renderer.area);
+            frame && frame->provider == &renderer.provider())
+        {
+            auto const composited = frame->composited;
+            return {{std::make_shared<CompositedFrameRenderable>(std::move(*frame))}, composited};
+        }
     }
-    output->set_next_buffer(std::move(buffer));
-    if (buffer_size != last_rendered_size)
+
+    auto scene_elements = scene->scene_elements_for(this);
+    auto const captured_time = clock->now();
+    mg::RenderableList renderable_list;
+    renderable_list.reserve(scene_elements.size());
+    for (auto const& element : scene_elements)
     {
-        // We need to build a new Renderer, at the new size
-        class NoAuxConfig : public graphics::GLConfig
-        {
-        public:
-            auto depth_buffer_bits() const -> int override
-            {
-                return 0;
-            }
-            auto stencil_buffer_bits() const -> int override
-            {
-                return 0;
-            }
-        };
-        offscreen_sink = std::make_unique<OffscreenDisplaySink>(output, buffer_size);
-        auto gl_surface = render_provider->surface_for_sink(*offscreen_sink, NoAuxConfig{});
-        current_renderer = renderer_factory->create_renderer_for(std::move(gl_surface), render_provider);
-        last_rendered_size = buffer_size;
+        renderable_list.push_back(element->renderable());
     }
-    return *current_renderer;
+    return {std::move(renderable_list), captured_time};
 }
 
 auto mc::BasicScreenShooter::select_provider(
-    std::span<std::shared_ptr<mg::GLRenderingProvider>> const& providers)
+    std::span<std::shared_ptr<mg::GLRenderingProvider>> const& providers,
+    bool to_dma_buf)
     -> std::shared_ptr<mg::GLRenderingProvider>
 {
-    auto display_provider = std::make_shared<Self::OneShotBufferDisplayProvider>();
+    std::shared_ptr<mg::DisplayAllocator> display_provider;
+    if (to_dma_buf)
+    {
+        display_provider = std::make_shared<Self::OneShotDMABufDisplayProvider>();
+    }
+    else
+    {
+        display_provider = std::make_shared<Self::OneShotBufferDisplayProvider>();
+    }
     OffscreenDisplaySink temp_db{display_provider, geom::Size{640, 480}};
 
     for (auto const& render_provider : providers)
@@ -246,6 +529,12 @@ auto mc::BasicScreenShooter::select_provider(
             return render_provider;
         }
     }
+
+    if (to_dma_buf)
+    {
+        // Not an error: clients can still capture into shared memory
+        return nullptr;
+    }
     BOOST_THROW_EXCEPTION((std::runtime_error{"No rendering provider claims to support a CPU addressable target"}));
 }
 
@@ -254,8 +543,15 @@ mc::BasicScreenShooter::BasicScreenShooter(
     std::shared_ptr<time::Clock> const& clock,
     Executor& executor,
     std::span<std::shared_ptr<mg::GLRenderingProvider>> const& providers,
-    std::shared_ptr<mr::RendererFactory> render_factory)
-    : self{std::make_shared<Self>(scene, clock, select_provider(providers), std::move(render_factory))},
+    std::shared_ptr<mr::RendererFactory> render_factory,
+    std::shared_ptr<CompositedFrameStore> composited_frames)
+    : self{std::make_shared<Self>(
+          scene,
+          clock,
+          select_provider(providers, false),
+          select_provider(providers, true),
+          std::move(render_factory),
+          std::move(composited_frames))},
       executor{executor}
 {
 }
@@ -264,16 +560,87 @@ void mc::BasicScreenShooter::capture(
     std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
     geom::Rectangle const& area,
     std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    enqueue(
+        area,
+        false,
+        [buffer](Self& self, Self::AreaRenderer& renderer)
+        {
+            auto const [renderables, captured_time] = self.snapshot(renderer);
+            renderer.render(renderables, buffer, std::nullopt);
+            return captured_time;
+        },
+        std::move(callback));
+}
+
+void mc::BasicScreenShooter::capture(
+    std::shared_ptr<mrs::WriteMappableBuffer> const& buffer,
+    geom::Rectangle const& area,
+    geom::Rectangle const& damage,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    enqueue(
+        area,
+        false,
+        [buffer, damage](Self& self, Self::AreaRenderer& renderer)
+        {
+            auto const [renderables, captured_time] = self.snapshot(renderer);
+            renderer.render(renderables, buffer, damage);
+            return captured_time;
+        },
+        std::move(callback));
+}
+
+void mc::BasicScreenShooter::capture(
+    std::shared_ptr<mg::DMABufBuffer> const& target,
+    geom::Rectangle const& area,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    if (!supports_dma_buf_targets())
+    {
+        mir::log(
+            ::mir::logging::Severity::warning,
+            "BasicScreenShooter",
+            "no rendering provider supports capturing into dma-bufs");
+        executor.spawn([callback=std::move(callback)]() { callback(std::nullopt); });
+        return;
+    }
+
+    enqueue(
+        area,
+        true,
+        [target](Self& self, Self::AreaRenderer& renderer)
+        {
+            auto const [renderables, captured_time] = self.snapshot(renderer);
+            renderer.render(renderables, target);
+            return captured_time;
+        },
+        std::move(callback));
+}
+
+auto mc::BasicScreenShooter::supports_dma_buf_targets() const -> bool
+{
+    return self->dma_buf_provider != nullptr;
+}
+
+void mc::BasicScreenShooter::enqueue(
+    geom::Rectangle const& area,
+    bool to_dma_buf,
+    std::function<time::Timestamp(Self&, Self::AreaRenderer&)>&& work,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
 {
     // TODO: use an atomic to keep track of number of in-flight captures, and error if it's too many
 
-    executor.spawn([weak_self=std::weak_ptr{self}, buffer, area, callback=std::move(callback)]
+    auto const area_renderer = self->renderer_for(area, to_dma_buf);
+
+    auto const needs_drain = area_renderer->push(
+        [weak_self=std::weak_ptr{self}, work=std::move(work), callback=std::move(callback)](Self::AreaRenderer& renderer)
         {
             if (auto const self = weak_self.lock())
             {
                 try
                 {
-                    callback(self->render(buffer, area));
+                    callback(work(*self, renderer));
                     return;
                 }
                 catch (...)
@@ -288,4 +655,9 @@ void mc::BasicScreenShooter::capture(
 
             callback(std::nullopt);
         });
+
+    if (needs_drain)
+    {
+        executor.spawn([area_renderer]() { area_renderer->drain(); });
+    }
 }
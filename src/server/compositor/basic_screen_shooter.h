@@ -19,11 +19,14 @@
 
 #include "mir/compositor/screen_shooter.h"
 #include "mir/graphics/platform.h"
+#include "mir/graphics/renderable.h"
 #include "mir/renderer/renderer_factory.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/time/clock.h"
 
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace mir
 {
@@ -35,6 +38,7 @@ class RendererFactory;
 }
 namespace compositor
 {
+class CompositedFrameStore;
 class Scene;
 
 class BasicScreenShooter: public ScreenShooter
@@ -45,52 +49,82 @@ public:
         std::shared_ptr<time::Clock> const& clock,
         Executor& executor,
         std::span<std::shared_ptr<graphics::GLRenderingProvider>> const& providers,
-        std::shared_ptr<renderer::RendererFactory> render_factory);
+        std::shared_ptr<renderer::RendererFactory> render_factory,
+        std::shared_ptr<CompositedFrameStore> composited_frames);
 
     void capture(
         std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
         geometry::Rectangle const& area,
         std::function<void(std::optional<time::Timestamp>)>&& callback) override;
 
+    void capture(
+        std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
+        geometry::Rectangle const& area,
+        geometry::Rectangle const& damage,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) override;
+
+    void capture(
+        std::shared_ptr<graphics::DMABufBuffer> const& target,
+        geometry::Rectangle const& area,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) override;
+
+    auto supports_dma_buf_targets() const -> bool override;
+
 private:
     struct Self
     {
         class OneShotBufferDisplayProvider;
+        class OneShotDMABufDisplayProvider;
+        class AreaRenderer;
 
         Self(
             std::shared_ptr<Scene> const& scene,
             std::shared_ptr<time::Clock> const& clock,
-            std::shared_ptr<graphics::GLRenderingProvider> provider,
-            std::shared_ptr<renderer::RendererFactory> render_factory);
+            std::shared_ptr<graphics::GLRenderingProvider> cpu_provider,
+            std::shared_ptr<graphics::GLRenderingProvider> dma_buf_provider,
+            std::shared_ptr<renderer::RendererFactory> render_factory,
+            std::shared_ptr<CompositedFrameStore> composited_frames);
 
-        auto render(
-            std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
-            geometry::Rectangle const& area) -> time::Timestamp;
+        /// The AreaRenderer for captures of area, into CPU buffers or dma-bufs
+        auto renderer_for(geometry::Rectangle const& area, bool to_dma_buf) -> std::shared_ptr<AreaRenderer>;
 
-        auto renderer_for_buffer(std::shared_ptr<renderer::software::WriteMappableBuffer> buffer)
-            -> renderer::Renderer&;
+        /**
+         * What there is to capture of renderer's area, and when it was captured
+         *
+         * That's the frame last composited for an output, if there's an up-to-date one renderer can draw,
+         * or else the scene.
+         */
+        auto snapshot(AreaRenderer const& renderer) -> std::pair<graphics::RenderableList, time::Timestamp>;
 
-        std::mutex mutex;
         std::shared_ptr<Scene> const scene;
         std::shared_ptr<time::Clock> const clock;
-        std::shared_ptr<graphics::GLRenderingProvider> const render_provider;
+        std::shared_ptr<graphics::GLRenderingProvider> const cpu_provider;
+        /// Null if no provider can render into dma-bufs
+        std::shared_ptr<graphics::GLRenderingProvider> const dma_buf_provider;
         std::shared_ptr<renderer::RendererFactory> const renderer_factory;
+        /// Null unless we can copy composited frames
+        std::shared_ptr<CompositedFrameStore> const composited_frames;
 
-        /* The Renderer instantiation is tied to a particular output size, and
-         * requires enough setup to make it worth keeping around as a consumer
-         * is likely to be taking screenshots of consistent size
+        std::mutex mutex;
+        /* Each area (usually an output) gets its own Renderer, so captures of different
+         * outputs can run concurrently, while those of the same area run one at a time
+         * and in order (so each can render only what has changed since the last).
          */
-        std::unique_ptr<renderer::Renderer> current_renderer;
-        geometry::Size last_rendered_size;
-
-        std::unique_ptr<graphics::DisplaySink> offscreen_sink;
-        std::shared_ptr<OneShotBufferDisplayProvider> const output;
+        std::vector<std::shared_ptr<AreaRenderer>> area_renderers;
     };
     std::shared_ptr<Self> const self;
     Executor& executor;
 
-    static auto select_provider(std::span<std::shared_ptr<graphics::GLRenderingProvider>> const& providers)
-        -> std::shared_ptr<graphics::GLRenderingProvider>;
+    /// Runs work on area's AreaRenderer, after any work already queued there
+    void enqueue(
+        geometry::Rectangle const& area,
+        bool to_dma_buf,
+        std::function<time::Timestamp(Self&, Self::AreaRenderer&)>&& work,
+        std::function<void(std::optional<time::Timestamp>)>&& callback);
+
+    static auto select_provider(
+        std::span<std::shared_ptr<graphics::GLRenderingProvider>> const& providers,
+        bool to_dma_buf) -> std::shared_ptr<graphics::GLRenderingProvider>;
 };
 }
 }
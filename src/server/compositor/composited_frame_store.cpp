@@ -0,0 +1,161 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "composited_frame_store.h"
+#include "mir/compositor/scene.h"
+#include "mir/scene/null_observer.h"
+#include "mir/time/clock.h"
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace ms = mir::scene;
+namespace geom = mir::geometry;
+
+class mc::CompositedFrameStore::SceneChanges : public ms::NullObserver
+{
+public:
+    explicit SceneChanges(CompositedFrameStore* store)
+        : store{store}
+    {
+    }
+
+    void surface_added(std::shared_ptr<ms::Surface> const&) override
+    {
+        store->scene_damaged(std::nullopt);
+    }
+
+    void surface_removed(std::shared_ptr<ms::Surface> const&) override
+    {
+        store->scene_damaged(std::nullopt);
+    }
+
+    void surfaces_reordered(ms::SurfaceSet const&) override
+    {
+        store->scene_damaged(std::nullopt);
+    }
+
+    void scene_changed() override
+    {
+        store->scene_damaged(std::nullopt);
+    }
+
+    void scene_damaged(geom::Rectangle const& damage) override
+    {
+        store->scene_damaged(damage);
+    }
+
+private:
+    CompositedFrameStore* const store;
+};
+
+mc::CompositedFrameStore::CompositedFrameStore(std::shared_ptr<Scene> scene, std::shared_ptr<time::Clock> clock)
+    : scene{std::move(scene)},
+      clock{std::move(clock)},
+      scene_changes{std::make_shared<SceneChanges>(this)}
+{
+    this->scene->add_observer(scene_changes);
+}
+
+mc::CompositedFrameStore::~CompositedFrameStore()
+{
+    scene->remove_observer(scene_changes);
+}
+
+void mc::CompositedFrameStore::drawing(CompositorID id, geom::Rectangle const& area)
+{
+    std::lock_guard lock{mutex};
+    auto const existing = std::find_if(
+        outputs.begin(), outputs.end(),
+        [id](auto const& output) { return output.id == id; });
+
+    if (existing != outputs.end())
+    {
+        existing->area = area;
+        existing->changed_while_drawing = false;
+    }
+    else
+    {
+        outputs.push_back(Output{id, area, false, std::nullopt, false});
+    }
+}
+
+void mc::CompositedFrameStore::store(
+    CompositorID id,
+    mg::GLRenderingProvider const& provider,
+    geom::Rectangle const& area,
+    std::shared_ptr<mg::Buffer> buffer)
+{
+    std::optional<Frame> frame;
+    if (buffer)
+    {
+        frame = Frame{std::move(buffer), &provider, area, clock->now()};
+    }
+
+    std::lock_guard lock{mutex};
+    auto existing = std::find_if(
+        outputs.begin(), outputs.end(),
+        [id](auto const& output) { return output.id == id; });
+
+    if (existing == outputs.end())
+    {
+        // Without knowing when drawing started, we can't know the frame is up to date
+        outputs.push_back(Output{id, area, true, std::nullopt, true});
+        existing = std::prev(outputs.end());
+    }
+
+    existing->frame = std::move(frame);
+    existing->frame_out_of_date = existing->changed_while_drawing;
+}
+
+void mc::CompositedFrameStore::remove(CompositorID id)
+{
+    std::lock_guard lock{mutex};
+    std::erase_if(outputs, [id](auto const& output) { return output.id == id; });
+}
+
+auto mc::CompositedFrameStore::frame_containing(geom::Rectangle const& area) const -> std::optional<Frame>
+{
+    std::lock_guard lock{mutex};
+    for (auto const& output : outputs)
+    {
+        // Buffers posted between the compositor taking its snapshot and starting to draw are still pending
+        if (output.frame && !output.frame_out_of_date && output.frame->area.contains(area) &&
+            scene->frames_pending(output.id) == 0)
+        {
+            return output.frame;
+        }
+    }
+
+    return std::nullopt;
+}
+
+void mc::CompositedFrameStore::scene_damaged(std::optional<geom::Rectangle> const& damage)
+{
+    std::lock_guard lock{mutex};
+    for (auto& output : outputs)
+    {
+        if (!damage || damage->overlaps(output.area))
+        {
+            output.changed_while_drawing = true;
+        }
+        if (output.frame && (!damage || damage->overlaps(output.frame->area)))
+        {
+            output.frame_out_of_date = true;
+        }
+    }
+}
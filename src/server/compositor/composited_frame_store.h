@@ -0,0 +1,118 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_COMPOSITED_FRAME_STORE_H_
+#define MIR_COMPOSITOR_COMPOSITED_FRAME_STORE_H_
+
+#include "mir/compositor/compositor_id.h"
+#include "mir/geometry/rectangle.h"
+#include "mir/time/types.h"
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+namespace graphics
+{
+class Buffer;
+class GLRenderingProvider;
+}
+namespace scene
+{
+class Observer;
+}
+namespace time
+{
+class Clock;
+}
+namespace compositor
+{
+class Scene;
+
+/**
+ * The frame each output's compositor drew last, for screenshots to copy instead of rendering the scene again
+ *
+ * A frame is only offered while it is up to date: once the scene has changed within its area since its
+ * compositor started drawing it, screenshots have to render the scene themselves.
+ */
+class CompositedFrameStore
+{
+public:
+    struct Frame
+    {
+        /// Drawable by GL contexts of provider
+        std::shared_ptr<graphics::Buffer> buffer;
+        graphics::GLRenderingProvider const* provider;
+        /// The area of the scene that buffer shows
+        geometry::Rectangle area;
+        time::Timestamp composited;
+    };
+
+    CompositedFrameStore(std::shared_ptr<Scene> scene, std::shared_ptr<time::Clock> clock);
+    ~CompositedFrameStore();
+
+    /// Notes that compositor id has started drawing area, so changes to the scene from here on are not in its frame
+    void drawing(CompositorID id, geometry::Rectangle const& area);
+
+    /**
+     * Records the frame compositor id just drew of area
+     *
+     * \param buffer    The frame, or null if there is no copy of it (e.g. because it was made of overlays)
+     */
+    void store(
+        CompositorID id,
+        graphics::GLRenderingProvider const& provider,
+        geometry::Rectangle const& area,
+        std::shared_ptr<graphics::Buffer> buffer);
+
+    /// Forgets the frame of compositor id, which is going away
+    void remove(CompositorID id);
+
+    /// An up-to-date frame of an output showing all of area, if there is one
+    auto frame_containing(geometry::Rectangle const& area) const -> std::optional<Frame>;
+
+private:
+    class SceneChanges;
+
+    struct Output
+    {
+        CompositorID id;
+        /// The area the compositor is drawing, or last drew
+        geometry::Rectangle area;
+        /// Whether the scene changed within area since the compositor started drawing it
+        bool changed_while_drawing;
+        std::optional<Frame> frame;
+        /// Whether the scene changed within frame's area since its compositor started drawing it
+        bool frame_out_of_date;
+    };
+
+    /// Marks the frames and drawings damage overlaps as out of date (all of them if damage is std::nullopt)
+    void scene_damaged(std::optional<geometry::Rectangle> const& damage);
+
+    std::shared_ptr<Scene> const scene;
+    std::shared_ptr<time::Clock> const clock;
+    std::shared_ptr<scene::Observer> const scene_changes;
+
+    std::mutex mutable mutex;
+    std::vector<Output> outputs;
+};
+}
+}
+
+#endif // MIR_COMPOSITOR_COMPOSITED_FRAME_STORE_H_
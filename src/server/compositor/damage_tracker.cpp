@@ -0,0 +1,112 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "damage_tracker.h"
+#include "mir/graphics/buffer.h"
+
+#include <algorithm>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+auto mc::DamageTracker::damage_for(mg::RenderableList const& renderables, geom::Rectangle const& view_area)
+    -> std::optional<geom::Rectangles>
+{
+    static glm::mat4 const identity(1);
+
+    geom::Rectangles damage;
+    auto const add_damage =
+        [&](geom::Rectangle const& area)
+        {
+            auto const visible = intersection_of(area, view_area);
+            if (visible.size != geom::Size{})
+                damage.add(visible);
+        };
+
+    std::unordered_map<mg::Renderable::ID, State> current;
+    bool trackable = true;
+    std::optional<size_t> max_previous_index;
+
+    for (size_t i = 0; i != renderables.size(); ++i)
+    {
+        auto const& renderable = *renderables[i];
+
+        auto visible_area = renderable.screen_position();
+        if (auto const clip_area = renderable.clip_area())
+            visible_area = intersection_of(visible_area, *clip_area);
+
+        State const state{visible_area, renderable.buffer()->id(), renderable.alpha(), renderable.shaped(), i};
+
+        // A transformed renderable can draw anywhere, and a repeated ID makes the history ambiguous
+        if (renderable.transformation() != identity || !current.emplace(renderable.id(), state).second)
+        {
+            trackable = false;
+            continue;
+        }
+
+        auto const prev = previous.find(renderable.id());
+        if (prev == previous.end())
+        {
+            add_damage(visible_area);
+            continue;
+        }
+
+        auto const& before = prev->second;
+        if (before.visible_area != visible_area || before.alpha != state.alpha || before.shaped != state.shaped)
+        {
+            add_damage(before.visible_area);
+            add_damage(visible_area);
+        }
+        else
+        {
+            if (before.buffer_id != state.buffer_id)
+            {
+                for (auto const& rect : renderable.damage())
+                    add_damage(intersection_of(rect, visible_area));
+            }
+
+            // Something that was above us is now below: what we overlap has changed
+            if (max_previous_index && *max_previous_index > before.stacking_index)
+                add_damage(visible_area);
+        }
+
+        max_previous_index = std::max(max_previous_index.value_or(0), before.stacking_index);
+    }
+
+    for (auto const& [id, state] : previous)
+    {
+        if (!current.contains(id))
+            add_damage(state.visible_area);
+    }
+
+    bool const damage_known = trackable && previous_trackable && previous_view_area == view_area;
+
+    previous = std::move(current);
+    previous_trackable = trackable;
+    previous_view_area = view_area;
+
+    if (!damage_known)
+        return std::nullopt;
+
+    return damage;
+}
+
+void mc::DamageTracker::reset()
+{
+    previous.clear();
+    previous_trackable = false;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_DAMAGE_TRACKER_H_
+#define MIR_COMPOSITOR_DAMAGE_TRACKER_H_
+
+#include "mir/graphics/renderable.h"
+#include "mir/graphics/buffer_id.h"
+#include "mir/geometry/rectangles.h"
+
+#include <optional>
+#include <unordered_map>
+
+namespace mir
+{
+namespace compositor
+{
+/**
+ * Works out which part of an output changed between successive frames
+ *
+ * Compares each frame's renderables with those of the previous frame: anything that appeared,
+ * disappeared, moved, restacked or changed how it is blended damages the area it covered,
+ * and a new buffer damages what the renderable reports as changed within it.
+ */
+class DamageTracker
+{
+public:
+    /**
+     * The area of \a view_area that differs from the previous frame, or std::nullopt if that
+     * can't be determined (e.g. for the first frame, or renderables with arbitrary transformations).
+     */
+    auto damage_for(graphics::RenderableList const& renderables, geometry::Rectangle const& view_area)
+        -> std::optional<geometry::Rectangles>;
+
+    /// Forget the previous frame (e.g. because it was not composited by the renderer)
+    void reset();
+
+private:
+    struct State
+    {
+        geometry::Rectangle visible_area;
+        graphics::BufferID buffer_id;
+        float alpha;
+        bool shaped;
+        size_t stacking_index;
+    };
+
+    /// Whether the previous frame consisted only of renderables we know how to track
+    bool previous_trackable{false};
+    geometry::Rectangle previous_view_area;
+    std::unordered_map<graphics::Renderable::ID, State> previous;
+};
+}
+}
+
+#endif // MIR_COMPOSITOR_DAMAGE_TRACKER_H_
@@ -22,8 +22,10 @@
 #include "default_display_buffer_compositor_factory.h"
 #include "mir/executor.h"
 #include "multi_threaded_compositor.h"
+#include "presentation_observer_multiplexer.h"
 #include "gl/renderer_factory.h"
 #include "basic_screen_shooter.h"
+#include "composited_frame_store.h"
 #include "null_screen_shooter.h"
 #include "mir/main_loop.h"
 #include "mir/graphics/platform.h"
@@ -64,7 +66,12 @@ mir::DefaultServerConfiguration::the_display_buffer_compositor_factory()
             }
             return wrap_display_buffer_compositor_factory(
                 std::make_shared<mc::DefaultDisplayBufferCompositorFactory>(
-                    std::move(providers), the_gl_config(), the_renderer_factory(), the_buffer_allocator(), the_compositor_report()));
+                    std::move(providers),
+                    the_gl_config(),
+                    the_renderer_factory(),
+                    the_buffer_allocator(),
+                    the_compositor_report(),
+                    the_composited_frame_store()));
         });
 }
 
@@ -90,11 +97,32 @@ mir::DefaultServerConfiguration::the_compositor()
                 the_display_buffer_compositor_factory(),
                 the_shell(),
                 the_compositor_report(),
+                the_presentation_observer(),
                 composite_delay,
                 true);
         });
 }
 
+std::shared_ptr<mc::PresentationObserver>
+mir::DefaultServerConfiguration::the_presentation_observer()
+{
+    return presentation_observer_multiplexer(
+        [default_executor = the_main_loop()]()
+        {
+            return std::make_shared<mc::PresentationObserverMultiplexer>(default_executor);
+        });
+}
+
+std::shared_ptr<mir::ObserverRegistrar<mc::PresentationObserver>>
+mir::DefaultServerConfiguration::the_presentation_observer_registrar()
+{
+    return presentation_observer_multiplexer(
+        [default_executor = the_main_loop()]()
+        {
+            return std::make_shared<mc::PresentationObserverMultiplexer>(default_executor);
+        });
+}
+
 std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration::the_renderer_factory()
 {
     return renderer_factory(
@@ -104,6 +132,19 @@ std::shared_ptr<mir::renderer::RendererFactory> mir::DefaultServerConfiguration:
         });
 }
 
+auto mir::DefaultServerConfiguration::the_composited_frame_store() -> std::shared_ptr<mc::CompositedFrameStore>
+{
+    return composited_frame_store(
+        [this]() -> std::shared_ptr<mc::CompositedFrameStore>
+        {
+            if (!the_options()->get<bool>(options::capture_composited_frames_opt))
+            {
+                return nullptr;
+            }
+            return std::make_shared<mc::CompositedFrameStore>(the_scene(), the_clock());
+        });
+}
+
 auto mir::DefaultServerConfiguration::the_screen_shooter() -> std::shared_ptr<compositor::ScreenShooter>
 {
     return screen_shooter(
@@ -129,7 +170,8 @@ auto mir::DefaultServerConfiguration::the_screen_shooter() -> std::shared_ptr<co
                     the_clock(),
                     thread_pool_executor,
                     providers,
-                    the_renderer_factory());
+                    the_renderer_factory(),
+                    the_composited_frame_store());
             }
             catch (...)
             {
@@ -15,6 +15,7 @@
  */
 
 #include "default_display_buffer_compositor.h"
+#include "composited_frame_store.h"
 
 #include "mir/compositor/compositor_report.h"
 #include "mir/compositor/scene.h"
@@ -34,12 +35,27 @@ mc::DefaultDisplayBufferCompositor::DefaultDisplayBufferCompositor(
     mg::DisplaySink& display_sink,
     graphics::GLRenderingProvider& gl_provider,
     std::shared_ptr<mir::renderer::Renderer> const& renderer,
-    std::shared_ptr<CompositorReport> const& report) :
+    std::shared_ptr<CompositorReport> const& report,
+    std::shared_ptr<CompositedFrameStore> const& composited_frames) :
     display_sink(display_sink),
+    gl_provider(gl_provider),
     renderer(renderer),
     fb_adaptor{gl_provider.make_framebuffer_provider(display_sink)},
-    report(report)
+    report(report),
+    composited_frames(composited_frames)
 {
+    if (composited_frames)
+    {
+        renderer->retain_frames(true);
+    }
+}
+
+mc::DefaultDisplayBufferCompositor::~DefaultDisplayBufferCompositor()
+{
+    if (composited_frames)
+    {
+        composited_frames->remove(this);
+    }
 }
 
 bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& scene_elements)
@@ -51,6 +67,11 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     report->began_frame(this);
 
     auto const& view_area = display_sink.view_area();
+    if (composited_frames)
+    {
+        composited_frames->drawing(this, view_area);
+    }
+
     auto const& occlusions = mc::filter_occlusions_from(scene_elements, view_area);
 
     for (auto const& element : occlusions)
@@ -102,24 +123,44 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
         };
 
         framebuffers.emplace_back(mg::DisplayElement{
-            renderable->screen_position(),
+            clipped_dest,
             geometry::RectangleF{source_origin, source_size},
-            std::move(fb)
+            std::move(fb),
+            renderable->alpha(),
+            renderable->transformation()
         });
     }
 
-    if (framebuffers.size() == renderable_list.size() && display_sink.overlay(framebuffers))
+    zero_copy = framebuffers.size() == renderable_list.size() && display_sink.overlay(framebuffers);
+
+    if (zero_copy)
     {
         report->renderables_in_frame(this, renderable_list);
         renderer->suspend();
+        damage_tracker.reset();
+
+        if (composited_frames)
+        {
+            // What's on screen isn't anything we could copy
+            composited_frames->store(this, gl_provider, view_area, nullptr);
+        }
     }
     else
     {
         renderer->set_output_transform(display_sink.transformation());
         renderer->set_viewport(view_area);
+        if (auto const damage = damage_tracker.damage_for(renderable_list, view_area))
+        {
+            renderer->set_damage(*damage);
+        }
 
         display_sink.set_next_image(renderer->render(renderable_list));
 
+        if (composited_frames)
+        {
+            composited_frames->store(this, gl_provider, view_area, renderer->last_frame());
+        }
+
         report->renderables_in_frame(this, renderable_list);
         report->rendered_frame(this);
 
@@ -140,3 +181,8 @@ bool mc::DefaultDisplayBufferCompositor::composite(mc::SceneElementSequence&& sc
     report->finished_frame(this);
     return true;
 }
+
+bool mc::DefaultDisplayBufferCompositor::last_frame_was_zero_copy() const
+{
+    return zero_copy;
+}
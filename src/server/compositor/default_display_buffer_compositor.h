@@ -19,6 +19,7 @@
 
 #include "mir/compositor/display_buffer_compositor.h"
 #include "mir/graphics/platform.h"
+#include "damage_tracker.h"
 #include <memory>
 
 namespace mir
@@ -38,6 +39,7 @@ class Renderer;
 namespace compositor
 {
 
+class CompositedFrameStore;
 class Scene;
 
 class DefaultDisplayBufferCompositor : public DisplayBufferCompositor
@@ -47,16 +49,24 @@ public:
         graphics::DisplaySink& display_sink,
         graphics::GLRenderingProvider& gl_provider,
         std::shared_ptr<renderer::Renderer> const& renderer,
-        std::shared_ptr<compositor::CompositorReport> const& report);
+        std::shared_ptr<compositor::CompositorReport> const& report,
+        std::shared_ptr<CompositedFrameStore> const& composited_frames);
+    ~DefaultDisplayBufferCompositor();
 
     bool composite(SceneElementSequence&& scene_sequence) override;
+    bool last_frame_was_zero_copy() const override;
 
 private:
     graphics::DisplaySink& display_sink;
+    graphics::GLRenderingProvider& gl_provider;
     std::shared_ptr<renderer::Renderer> const renderer;
     std::unique_ptr<graphics::RenderingProvider::FramebufferProvider> const fb_adaptor;
     std::shared_ptr<compositor::CompositorReport> const report;
+    /// Null unless screenshots can use what we draw
+    std::shared_ptr<CompositedFrameStore> const composited_frames;
     bool completed_first_render = false;
+    bool zero_copy = false;
+    DamageTracker damage_tracker;
 };
 
 }
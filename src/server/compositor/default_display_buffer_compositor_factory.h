@@ -40,6 +40,7 @@ class GraphicBufferAllocator;
 ///  Compositing. Combining renderables into a display image.
 namespace compositor
 {
+class CompositedFrameStore;
 
 class DefaultDisplayBufferCompositorFactory : public DisplayBufferCompositorFactory
 {
@@ -49,7 +50,8 @@ public:
         std::shared_ptr<graphics::GLConfig> gl_config,
         std::shared_ptr<renderer::RendererFactory> const& renderer_factory,
         std::shared_ptr<graphics::GraphicBufferAllocator> const& buffer_allocator,
-        std::shared_ptr<CompositorReport> const& report);
+        std::shared_ptr<CompositorReport> const& report,
+        std::shared_ptr<CompositedFrameStore> const& composited_frames);
 
     std::unique_ptr<DisplayBufferCompositor> create_compositor_for(graphics::DisplaySink& display_sink) override;
 
@@ -59,6 +61,8 @@ private:
     std::shared_ptr<renderer::RendererFactory> const renderer_factory;
     std::shared_ptr<graphics::GraphicBufferAllocator> const buffer_allocator;
     std::shared_ptr<CompositorReport> const report;
+    /// Null unless screenshots copy composited frames
+    std::shared_ptr<CompositedFrameStore> const composited_frames;
 };
 
 }
@@ -22,6 +22,7 @@
 #include "mir/compositor/display_listener.h"
 #include "mir/compositor/scene.h"
 #include "mir/compositor/compositor_report.h"
+#include "mir/compositor/presentation_observer.h"
 #include "mir/scene/scene_change_notification.h"
 #include "mir/scene/surface_observer.h"
 #include "mir/scene/surface.h"
@@ -30,6 +31,7 @@
 #include "mir/unwind_helpers.h"
 #include "mir/thread_name.h"
 #include "mir/executor.h"
+#include "mir/pooled_allocator.h"
 
 #include <thread>
 #include <chrono>
@@ -56,7 +58,8 @@ public:
         std::shared_ptr<mc::Scene> const& scene,
         std::shared_ptr<DisplayListener> const& display_listener,
         std::chrono::milliseconds fixed_composite_delay,
-        std::shared_ptr<CompositorReport> const& report) :
+        std::shared_ptr<CompositorReport> const& report,
+        std::shared_ptr<PresentationObserver> const& presentation_observer) :
         compositor_factory{db_compositor_factory},
         group(group),
         scene(scene),
@@ -65,6 +68,7 @@ public:
         force_sleep{fixed_composite_delay},
         display_listener{display_listener},
         report{report},
+        presentation_observer{presentation_observer},
         started_future{started.get_future()},
         stopped_future{stopped.get_future()}
     {
@@ -95,6 +99,12 @@ public:
                                   CompositorReport::SubCompositorId{comp_id});
         });
 
+        {
+            std::lock_guard lock{run_mutex};
+            for (auto const& compositor : compositors)
+                compositor_ids.push_back(std::get<1>(compositor).get());
+        }
+
         //Appease TSan, avoid destructor and this thread accessing the same shared_ptr instance
         auto const disp_listener = display_listener;
         auto display_registration = mir::raii::paired_calls(
@@ -118,6 +128,7 @@ public:
 
         try
         {
+            std::vector<std::pair<mg::DisplaySink*, mc::DisplayBufferCompositor*>> composited;
             std::unique_lock lock{run_mutex};
             while (running)
             {
@@ -141,17 +152,28 @@ public:
                     not_posted_yet = false;
                     lock.unlock();
 
-                    bool needs_post = false;
+                    composited.clear();
                     for (auto& tuple : compositors)
                     {
                         auto& compositor = std::get<1>(tuple);
-                        if (compositor->composite(scene->scene_elements_for(compositor.get())))
-                            needs_post = true;
+
+                        auto const allocations_before = BlockPool::heap_allocations_on_this_thread();
+                        auto elements = scene->scene_elements_for(compositor.get());
+                        report->snapshot_allocations(
+                            compositor.get(), BlockPool::heap_allocations_on_this_thread() - allocations_before);
+
+                        if (compositor->composite(std::move(elements)))
+                            composited.emplace_back(std::get<0>(tuple), compositor.get());
+                        else
+                            report->skipped_frame(compositor.get());
                     }
 
                     // We can skip the post if none of the compositors ended up compositing
-                    if (needs_post)
+                    if (!composited.empty())
+                    {
                         group.post();
+                        notify_presented(composited);
+                    }
 
                     /*
                      * "Predictive bypass" optimization: If the last frame was
@@ -216,7 +238,13 @@ public:
         group.for_each_display_sink([&](mg::DisplaySink& sink)
             { if (damage.overlaps(sink.view_area())) took_damage = true; });
 
-        if (took_damage && num_frames > frames_scheduled)
+        if (!took_damage)
+        {
+            // Nothing we show has changed, so don't wake this thread
+            for (auto const id : compositor_ids)
+                report->skipped_frame(id);
+        }
+        else if (num_frames > frames_scheduled)
         {
             frames_scheduled = num_frames;
             lock.unlock();
@@ -251,6 +279,20 @@ public:
     }
 
 private:
+    void notify_presented(std::vector<std::pair<mg::DisplaySink*, mc::DisplayBufferCompositor*>> const& composited)
+    {
+        for (auto const& [sink, compositor] : composited)
+        {
+            auto frame = sink->last_frame();
+
+            // The platform can't tell us, so the best we know is "now"
+            if (frame.msc == 0)
+                frame.ust = mg::Frame::Timestamp::now(CLOCK_MONOTONIC);
+
+            presentation_observer->frame_presented(sink->view_area(), frame, compositor->last_frame_was_zero_copy());
+        }
+    }
+
     std::shared_ptr<mc::DisplayBufferCompositorFactory> const compositor_factory;
     mg::DisplaySyncGroup& group;
     std::shared_ptr<mc::Scene> const scene;
@@ -261,11 +303,13 @@ private:
     std::condition_variable run_cv;
     std::shared_ptr<DisplayListener> const display_listener;
     std::shared_ptr<CompositorReport> const report;
+    std::shared_ptr<PresentationObserver> const presentation_observer;
     std::promise<void> started;
     std::future<void> started_future;
     std::promise<void> stopped;
     std::future<void> stopped_future;
     bool not_posted_yet = true;
+    std::vector<CompositorReport::SubCompositorId> compositor_ids;
 };
 
 }
@@ -277,6 +321,7 @@ mc::MultiThreadedCompositor::MultiThreadedCompositor(
     std::shared_ptr<DisplayBufferCompositorFactory> const& db_compositor_factory,
     std::shared_ptr<DisplayListener> const& display_listener,
     std::shared_ptr<CompositorReport> const& compositor_report,
+    std::shared_ptr<PresentationObserver> const& presentation_observer,
     std::chrono::milliseconds fixed_composite_delay,
     bool compose_on_start)
     : display{display},
@@ -284,6 +329,7 @@ mc::MultiThreadedCompositor::MultiThreadedCompositor(
       display_buffer_compositor_factory{db_compositor_factory},
       display_listener{display_listener},
       report{compositor_report},
+      presentation_observer{presentation_observer},
       state{CompositorState::stopped},
       fixed_composite_delay{fixed_composite_delay},
       compose_on_start{compose_on_start}
@@ -380,9 +426,9 @@ void mc::MultiThreadedCompositor::create_compositing_threads()
     {
         auto thread_functor = std::make_unique<mc::CompositingFunctor>(
             display_buffer_compositor_factory, group, scene, display_listener,
-            fixed_composite_delay, report);
+            fixed_composite_delay, report, presentation_observer);
 
-        mir::thread_pool_executor.spawn(std::ref(*thread_functor));
+        mir::dedicated_thread_executor.spawn(std::ref(*thread_functor));
         thread_functors.push_back(std::move(thread_functor));
     });
 
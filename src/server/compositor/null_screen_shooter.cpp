@@ -19,6 +19,7 @@
 #include "mir/executor.h"
 
 namespace mc = mir::compositor;
+namespace mg = mir::graphics;
 namespace mrs = mir::renderer::software;
 namespace geom = mir::geometry;
 
@@ -31,6 +32,33 @@ void mc::NullScreenShooter::capture(
     std::shared_ptr<mrs::WriteMappableBuffer> const&,
     geom::Rectangle const&,
     std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    fail(std::move(callback));
+}
+
+void mc::NullScreenShooter::capture(
+    std::shared_ptr<mrs::WriteMappableBuffer> const&,
+    geom::Rectangle const&,
+    geom::Rectangle const&,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    fail(std::move(callback));
+}
+
+void mc::NullScreenShooter::capture(
+    std::shared_ptr<mg::DMABufBuffer> const&,
+    geom::Rectangle const&,
+    std::function<void(std::optional<time::Timestamp>)>&& callback)
+{
+    fail(std::move(callback));
+}
+
+auto mc::NullScreenShooter::supports_dma_buf_targets() const -> bool
+{
+    return false;
+}
+
+void mc::NullScreenShooter::fail(std::function<void(std::optional<time::Timestamp>)>&& callback)
 {
     log_warning("Failed to capture screen because NullScreenShooter is in use");
     executor.spawn([callback=std::move(callback)]
@@ -36,7 +36,23 @@ public:
         geometry::Rectangle const& area,
         std::function<void(std::optional<time::Timestamp>)>&& callback) override;
 
+    void capture(
+        std::shared_ptr<renderer::software::WriteMappableBuffer> const& buffer,
+        geometry::Rectangle const& area,
+        geometry::Rectangle const& damage,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) override;
+
+    void capture(
+        std::shared_ptr<graphics::DMABufBuffer> const& target,
+        geometry::Rectangle const& area,
+        std::function<void(std::optional<time::Timestamp>)>&& callback) override;
+
+    auto supports_dma_buf_targets() const -> bool override;
+
 private:
+    void fail(std::function<void(std::optional<time::Timestamp>)>&& callback);
+
+
     Executor& executor;
 };
 }
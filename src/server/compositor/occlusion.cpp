@@ -14,12 +14,12 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include "mir/geometry/rectangle.h"
+#include "mir/geometry/region.h"
 #include "mir/compositor/scene_element.h"
 #include "mir/graphics/renderable.h"
 #include "occlusion.h"
 
-#include <vector>
+#include <algorithm>
 
 using namespace mir::geometry;
 using namespace mir::graphics;
@@ -27,10 +27,59 @@ using namespace mir::compositor;
 
 namespace
 {
+/// Beyond this, scissoring to the visible region costs more draws than it saves in fill
+auto constexpr max_visible_rectangles = 16u;
+
+/// A renderable that is partly hidden by those drawn over it
+class PartlyHiddenRenderable : public Renderable
+{
+public:
+    PartlyHiddenRenderable(std::shared_ptr<Renderable> renderable, Rectangles visible)
+        : renderable{std::move(renderable)},
+          visible{std::move(visible)}
+    {
+    }
+
+    auto id() const -> ID override { return renderable->id(); }
+    auto buffer() const -> std::shared_ptr<Buffer> override { return renderable->buffer(); }
+    auto screen_position() const -> Rectangle override { return renderable->screen_position(); }
+    auto clip_area() const -> std::optional<Rectangle> override { return renderable->clip_area(); }
+    auto alpha() const -> float override { return renderable->alpha(); }
+    auto transformation() const -> glm::mat4 override { return renderable->transformation(); }
+    auto shaped() const -> bool override { return renderable->shaped(); }
+    auto damage() const -> Rectangles override { return renderable->damage(); }
+    auto opaque_region() const -> Rectangles override { return renderable->opaque_region(); }
+    auto visible_region() const -> std::optional<Rectangles> override { return visible; }
+
+private:
+    std::shared_ptr<Renderable> const renderable;
+    Rectangles const visible;
+};
+
+class PartlyHiddenElement : public SceneElement
+{
+public:
+    PartlyHiddenElement(std::shared_ptr<SceneElement> element, Rectangles visible)
+        : element{std::move(element)},
+          renderable_{std::make_shared<PartlyHiddenRenderable>(this->element->renderable(), std::move(visible))}
+    {
+    }
+
+    auto renderable() const -> std::shared_ptr<Renderable> override { return renderable_; }
+    void rendered() override { element->rendered(); }
+    void occluded() override { element->occluded(); }
+
+private:
+    std::shared_ptr<SceneElement> const element;
+    std::shared_ptr<Renderable> const renderable_;
+};
+
+/// Whether the renderable is hidden and, if not, what of it is visible when only part is
 bool renderable_is_occluded(
     Renderable const& renderable, 
     Rectangle const& area,
-    std::vector<Rectangle>& coverage)
+    Region& coverage,
+    std::optional<Rectangles>& visible)
 {
     static glm::mat4 const identity(1);
     static Rectangle const empty{};
@@ -44,20 +93,32 @@ bool renderable_is_occluded(
     if (clipped_window == empty)
         return true;  // Not in the area; definitely occluded.
 
-    bool occluded = false;
-    for (auto const& r : coverage)
+    // Hidden if what's above covers it, even if no single window above does
+    if (coverage.contains(clipped_window))
+        return true;
+
+    if (coverage.overlaps(clipped_window))
     {
-        if (r.contains(clipped_window))
+        Region uncovered{clipped_window};
+        uncovered.subtract(coverage);
+        auto rectangles = uncovered.rectangles();
+        if (rectangles.size() <= max_visible_rectangles)
         {
-            occluded = true;
-            break;
+            visible = std::move(rectangles);
         }
     }
 
-    if (!occluded && renderable.alpha() == 1.0f && !renderable.shaped())
-        coverage.push_back(clipped_window);
+    if (renderable.alpha() == 1.0f)
+    {
+        auto const visible_area = renderable.clip_area() ?
+            intersection_of(clipped_window, *renderable.clip_area()) : clipped_window;
 
-    return occluded;
+        Region opaque{renderable.opaque_region()};
+        opaque.intersect(visible_area);
+        coverage.unite(opaque);
+    }
+
+    return false;
 }
 }
 
@@ -66,22 +127,31 @@ SceneElementSequence mir::compositor::filter_occlusions_from(
     Rectangle const& area)
 {
     SceneElementSequence occluded;
-    std::vector<Rectangle> coverage;
+    SceneElementSequence visible;
+    Region coverage;
 
-    auto it = elements.rbegin();
-    while (it != elements.rend())
+    // Walk from the top of the stack down, collecting each list in reverse
+    for (auto it = elements.rbegin(); it != elements.rend(); ++it)
     {
         auto const renderable = (*it)->renderable();
-        if (renderable_is_occluded(*renderable, area, coverage))
+        std::optional<Rectangles> visible_region;
+        if (renderable_is_occluded(*renderable, area, coverage, visible_region))
         {
-            occluded.insert(occluded.begin(), *it);
-            it = SceneElementSequence::reverse_iterator(elements.erase(std::prev(it.base())));
+            occluded.push_back(std::move(*it));
+        }
+        else if (visible_region)
+        {
+            visible.push_back(std::make_shared<PartlyHiddenElement>(std::move(*it), std::move(*visible_region)));
         }
         else
         {
-            it++;
+            visible.push_back(std::move(*it));
         }
     }
 
+    std::reverse(occluded.begin(), occluded.end());
+    std::reverse(visible.begin(), visible.end());
+    elements = std::move(visible);
+
     return occluded;
 }
@@ -18,12 +18,19 @@
 #define MIR_COMPOSITOR_OCCLUSION_H_
 
 #include "mir/compositor/scene.h"
+#include "mir/geometry/rectangle.h"
 
 namespace mir
 {
 namespace compositor
 {
 
+/**
+ * Removes the elements hidden within \a area from \a list, and returns them.
+ *
+ * Elements left in \a list that are partly hidden are replaced by ones whose
+ * renderable reports its visible_region().
+ */
 SceneElementSequence filter_occlusions_from(SceneElementSequence& list, geometry::Rectangle const& area);
 
 } // namespace compositor
@@ -0,0 +1,42 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_COMPOSITOR_PRESENTATION_OBSERVER_MULTIPLEXER_H_
+#define MIR_COMPOSITOR_PRESENTATION_OBSERVER_MULTIPLEXER_H_
+
+#include "mir/compositor/presentation_observer.h"
+#include "mir/observer_multiplexer.h"
+
+namespace mir
+{
+namespace compositor
+{
+
+class PresentationObserverMultiplexer : public ObserverMultiplexer<PresentationObserver>
+{
+public:
+    PresentationObserverMultiplexer(std::shared_ptr<Executor> const& default_executor);
+
+    void frame_presented(geometry::Rectangle const& view_area, graphics::Frame const& frame, bool zero_copy) override;
+
+private:
+    std::shared_ptr<Executor> const executor;
+};
+
+}
+}
+
+#endif //MIR_COMPOSITOR_PRESENTATION_OBSERVER_MULTIPLEXER_H_
@@ -21,6 +21,7 @@
 #include <boost/throw_exception.hpp>
 #include <math.h>
 
+#include <algorithm>
 #include <cmath>
 
 namespace mc = mir::compositor;
@@ -28,6 +29,12 @@ namespace geom = mir::geometry;
 namespace mg = mir::graphics;
 namespace geom = mir::geometry;
 
+namespace
+{
+// Enough to cover the buffers a compositor may skip over when framedropping
+std::size_t const max_submission_history{8};
+}
+
 enum class mc::Stream::ScheduleMode {
     Queueing,
     Dropping
@@ -48,12 +55,23 @@ mc::Stream::Stream(
 mc::Stream::~Stream() = default;
 
 void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer)
+{
+    if (!buffer)
+        BOOST_THROW_EXCEPTION(std::invalid_argument("cannot submit null buffer"));
+
+    submit_buffer(buffer, geom::Rectangles{{{}, buffer->size()}});
+}
+
+void mc::Stream::submit_buffer(std::shared_ptr<mg::Buffer> const& buffer, geom::Rectangles const& damage)
 {
     if (!buffer)
         BOOST_THROW_EXCEPTION(std::invalid_argument("cannot submit null buffer"));
 
     {
         std::lock_guard lk(mutex);
+        submissions.push_back({buffer->id(), buffer->size(), damage});
+        if (submissions.size() > max_submission_history)
+            submissions.pop_front();
         pf = buffer->pixel_format();
         latest_buffer_size = buffer->size();
         schedule->schedule(buffer);
@@ -86,7 +104,57 @@ void mc::Stream::set_frame_posted_callback(
 
 std::shared_ptr<mg::Buffer> mc::Stream::lock_compositor_buffer(void const* id)
 {
-    return arbiter->compositor_acquire(id);
+    auto const buffer = arbiter->compositor_acquire(id);
+
+    std::lock_guard lk(mutex);
+    auto& user = damage_by_user[id];
+    user.damage = damage_between(user.last_buffer, *buffer, lk);
+    user.last_buffer = buffer->id();
+
+    return buffer;
+}
+
+geom::Rectangles mc::Stream::damage_for(void const* id) const
+{
+    std::lock_guard lk(mutex);
+    if (auto const user = damage_by_user.find(id); user != damage_by_user.end())
+        return user->second.damage;
+    return {};
+}
+
+auto mc::Stream::damage_between(
+    std::optional<mg::BufferID> previous,
+    mg::Buffer const& current,
+    std::lock_guard<std::mutex> const&) const -> geom::Rectangles
+{
+    geom::Rectangles const everything{{{}, current.size()}};
+
+    if (previous == current.id())
+        return {};
+
+    if (!previous)
+        return everything;
+
+    auto const is_current = [&](Submission const& s) { return s.id == current.id(); };
+    auto const is_previous = [&](Submission const& s) { return s.id == previous.value(); };
+
+    auto const current_pos = std::find_if(submissions.rbegin(), submissions.rend(), is_current);
+    auto const previous_pos = std::find_if(current_pos, submissions.rend(), is_previous);
+
+    // Either buffer has fallen out of the history, or they weren't submitted in the expected order
+    if (current_pos == submissions.rend() || previous_pos == submissions.rend())
+        return everything;
+
+    geom::Rectangles damage;
+    for (auto s = current_pos; s != previous_pos; ++s)
+    {
+        if (s->size != current.size())
+            return everything;
+
+        for (auto const& rect : s->damage)
+            damage.add(rect);
+    }
+    return damage;
 }
 
 geom::Size mc::Stream::stream_size()
@@ -22,10 +22,13 @@
 #include "multi_monitor_arbiter.h"
 
 #include <atomic>
+#include <deque>
 #include <mutex>
 #include <memory>
 #include <set>
 #include <atomic>
+#include <optional>
+#include <unordered_map>
 
 namespace mir
 {
@@ -39,12 +42,16 @@ public:
     ~Stream();
 
     void submit_buffer(std::shared_ptr<graphics::Buffer> const& buffer) override;
+    void submit_buffer(
+        std::shared_ptr<graphics::Buffer> const& buffer,
+        geometry::Rectangles const& damage) override;
     void with_most_recent_buffer_do(std::function<void(graphics::Buffer&)> const& exec) override;
     MirPixelFormat pixel_format() const override;
     void set_frame_posted_callback(
         std::function<void(geometry::Size const&)> const& callback) override;
     std::shared_ptr<graphics::Buffer>
         lock_compositor_buffer(void const* user_id) override;
+    geometry::Rectangles damage_for(void const* user_id) const override;
     geometry::Size stream_size() override;
     void allow_framedropping(bool) override;
     bool framedropping() const override;
@@ -56,6 +63,23 @@ public:
 private:
     enum class ScheduleMode;
     void transition_schedule(std::shared_ptr<Schedule>&& new_schedule, std::lock_guard<std::mutex> const&);
+    auto damage_between(
+        std::optional<graphics::BufferID> previous,
+        graphics::Buffer const& current,
+        std::lock_guard<std::mutex> const&) const -> geometry::Rectangles;
+
+    struct Submission
+    {
+        graphics::BufferID id;
+        geometry::Size size;
+        geometry::Rectangles damage;
+    };
+
+    struct UserDamage
+    {
+        std::optional<graphics::BufferID> last_buffer;
+        geometry::Rectangles damage;
+    };
 
     std::mutex mutable mutex;
     ScheduleMode schedule_mode;
@@ -65,6 +89,8 @@ private:
     float scale_{1.0f};
     MirPixelFormat pf;
     std::atomic<bool> first_frame_posted;
+    std::deque<Submission> submissions;
+    std::unordered_map<void const*, UserDamage> damage_by_user;
 
     std::mutex callback_mutex;
     std::function<void(geometry::Size const&)> frame_callback;
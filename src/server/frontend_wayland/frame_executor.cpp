@@ -16,58 +16,211 @@
 
 #include "frame_executor.h"
 
+#include <mir/lockable_callback.h>
 #include <mir/main_loop.h>
+#include <mir/time/clock.h>
 
+#include <algorithm>
 #include <mutex>
 #include <vector>
 
 namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
 
 namespace
 {
-auto const delay = std::chrono::milliseconds{16};
+/// Used until an output tells us its refresh rate
+auto const default_refresh_interval = std::chrono::nanoseconds{std::chrono::milliseconds{16}};
 }
 
 struct mf::FrameExecutor::Callbacks
 {
+    struct Pending
+    {
+        std::function<void(std::optional<Presentation> const&)> work;
+        std::optional<geom::Rectangle> area;
+        time::Timestamp fallback_deadline;   ///< When to run work if no output it is on has presented
+    };
+
+    struct Output
+    {
+        geom::Rectangle view_area;
+        mg::Frame last_frame;
+        std::optional<std::chrono::nanoseconds> refresh_interval;
+    };
+
     std::mutex mutex;
-    std::vector<std::function<void()>> queued;
+    std::vector<Pending> queued;
+    std::vector<Output> outputs;
+    std::optional<time::Timestamp> alarm_deadline; ///< What the alarm is armed for, if anything
+
+    /// Returns the output's refresh interval, if known
+    auto update_output(geom::Rectangle const& view_area, mg::Frame const& frame)
+        -> std::optional<std::chrono::nanoseconds>
+    {
+        // Outputs don't overlap, so anything we knew about this part of the screen is stale
+        std::erase_if(outputs, [&](Output const& output)
+            {
+                return output.view_area != view_area && output.view_area.overlaps(view_area);
+            });
+
+        auto const output = std::find_if(outputs.begin(), outputs.end(),
+            [&](Output const& output) { return output.view_area == view_area; });
+
+        if (output == outputs.end())
+        {
+            outputs.push_back({view_area, frame, std::nullopt});
+            return std::nullopt;
+        }
+
+        // Only frame counters let us tell a missed vblank from an idle one
+        if (frame.msc > output->last_frame.msc && output->last_frame.msc != 0 &&
+            frame.ust.clock_id == output->last_frame.ust.clock_id)
+        {
+            output->refresh_interval = (frame.ust - output->last_frame.ust) / (frame.msc - output->last_frame.msc);
+        }
+        output->last_frame = frame;
+        return output->refresh_interval;
+    }
+
+    /// The longest known refresh interval, so the fallback doesn't pre-empt any output that is presenting
+    auto fallback_delay() const -> std::chrono::milliseconds
+    {
+        std::optional<std::chrono::nanoseconds> longest;
+        for (auto const& output : outputs)
+        {
+            if (output.refresh_interval && (!longest || *output.refresh_interval > *longest))
+            {
+                longest = output.refresh_interval;
+            }
+        }
+
+        return std::chrono::ceil<std::chrono::milliseconds>(longest.value_or(default_refresh_interval));
+    }
+};
+
+/// Takes the work whose fallback deadline has passed when the alarm fires. The alarm locks the callbacks' mutex
+/// before firing, so the alarm can be rearmed under the same lock as the queue. The work is run once that is released.
+class mf::FrameExecutor::AlarmCallback : public mir::LockableCallback
+{
+public:
+    explicit AlarmCallback(FrameExecutor& executor)
+        : executor{executor}
+    {
+    }
+
+    void operator()() override
+    {
+        auto& queued = executor.callbacks->queued;
+        auto const now = executor.clock->now();
+
+        auto const not_due = std::stable_partition(queued.begin(), queued.end(),
+            [&](Callbacks::Pending const& pending) { return pending.fallback_deadline <= now; });
+
+        due.assign(std::make_move_iterator(queued.begin()), std::make_move_iterator(not_due));
+        queued.erase(queued.begin(), not_due);
+
+        // The alarm has fired, so is no longer armed for anything
+        executor.callbacks->alarm_deadline.reset();
+        executor.schedule_fallback();
+    }
+
+    void lock() override
+    {
+        locked = std::unique_lock{executor.callbacks->mutex};
+    }
+
+    void unlock() override
+    {
+        auto const ready = std::move(due);
+        due.clear();
+        locked.unlock();
+
+        for (auto const& pending : ready)
+        {
+            pending.work(std::nullopt);
+        }
+    }
+
+private:
+    FrameExecutor& executor;
+    std::unique_lock<std::mutex> locked;
+    std::vector<Callbacks::Pending> due;
 };
 
-mf::FrameExecutor::FrameExecutor(time::AlarmFactory& alarm_factory)
-    : callbacks{std::make_shared<Callbacks>()},
-      alarm{alarm_factory.create_alarm([weak_callbacks = std::weak_ptr<Callbacks>{callbacks}]()
-          {
-              fire_callbacks(weak_callbacks);
-          })}
+mf::FrameExecutor::FrameExecutor(std::shared_ptr<time::Clock> const& clock, time::AlarmFactory& alarm_factory)
+    : clock{clock},
+      callbacks{std::make_shared<Callbacks>()},
+      alarm{alarm_factory.create_alarm(std::make_unique<AlarmCallback>(*this))}
+{
+}
+
+void mf::FrameExecutor::spawn(std::function<void()>&& work, std::optional<geometry::Rectangle> const& area)
 {
+    spawn([work = std::move(work)](std::optional<Presentation> const&) { work(); }, area);
 }
 
-void mf::FrameExecutor::spawn(std::function<void()>&& work)
+void mf::FrameExecutor::spawn(
+    std::function<void(std::optional<Presentation> const&)>&& work,
+    std::optional<geometry::Rectangle> const& area)
 {
+    std::lock_guard lock{callbacks->mutex};
+    callbacks->queued.push_back({std::move(work), area, clock->now() + callbacks->fallback_delay()});
+    schedule_fallback();
+}
+
+void mf::FrameExecutor::frame_presented(
+    geometry::Rectangle const& view_area,
+    graphics::Frame const& frame,
+    bool zero_copy)
+{
+    std::vector<Callbacks::Pending> presented;
+
     std::unique_lock lock{callbacks->mutex};
-    bool const needs_alarm = callbacks->queued.empty();
-    callbacks->queued.push_back(std::move(work));
+    Presentation const presentation{view_area, frame, callbacks->update_output(view_area, frame), zero_copy};
+
+    auto const not_on_output = std::stable_partition(
+        callbacks->queued.begin(), callbacks->queued.end(),
+        [&](Callbacks::Pending const& pending) { return pending.area && pending.area->overlaps(view_area); });
+
+    presented.assign(
+        std::make_move_iterator(callbacks->queued.begin()),
+        std::make_move_iterator(not_on_output));
+    callbacks->queued.erase(callbacks->queued.begin(), not_on_output);
+
+    if (!presented.empty())
+    {
+        schedule_fallback();
+    }
     lock.unlock();
 
-    if (needs_alarm)
+    for (auto const& pending : presented)
     {
-        alarm->reschedule_in(delay);
+        pending.work(presentation);
     }
 }
 
-void mf::FrameExecutor::fire_callbacks(std::weak_ptr<Callbacks> const& weak_callbacks)
+void mf::FrameExecutor::schedule_fallback()
 {
-    if (auto const callbacks = weak_callbacks.lock())
-    {
-        std::unique_lock lock{callbacks->mutex};
-        auto const queued = std::move(callbacks->queued);
-        callbacks->queued.clear();
-        lock.unlock();
+    auto const earliest = std::min_element(callbacks->queued.begin(), callbacks->queued.end(),
+        [](Callbacks::Pending const& lhs, Callbacks::Pending const& rhs)
+        {
+            return lhs.fallback_deadline < rhs.fallback_deadline;
+        });
 
-        for (auto const& callback : queued)
+    if (earliest == callbacks->queued.end())
+    {
+        if (callbacks->alarm_deadline)
         {
-            callback();
+            alarm->cancel();
+            callbacks->alarm_deadline.reset();
         }
     }
+    else if (callbacks->alarm_deadline != earliest->fallback_deadline)
+    {
+        auto const delay = std::max(earliest->fallback_deadline - clock->now(), time::Duration::zero());
+        alarm->reschedule_in(std::chrono::ceil<std::chrono::milliseconds>(delay));
+        callbacks->alarm_deadline = earliest->fallback_deadline;
+    }
 }
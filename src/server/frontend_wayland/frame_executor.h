@@ -17,9 +17,12 @@
 #ifndef MIR_FRONTEND_FRAME_CALLBACK_EXECUTOR_H
 #define MIR_FRONTEND_FRAME_CALLBACK_EXECUTOR_H
 
-#include <mir/executor.h>
+#include "mir/compositor/presentation_observer.h"
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <optional>
 
 namespace mir
 {
@@ -27,28 +30,56 @@ namespace time
 {
 class Alarm;
 class AlarmFactory;
+class Clock;
 }
 
 namespace frontend
 {
 
-/// Runs frame callbacks that do not have a buffer to be attached to.
-class FrameExecutor : public Executor
+/**
+ * Runs frame callbacks once the output(s) they are on have presented a frame.
+ *
+ * Work is tied to an area of the screen and run when an output overlapping
+ * that area next presents. Work that isn't on any output that is presenting
+ * (or has no area) is run once a fallback delay has passed since it was
+ * spawned: one refresh interval of the slowest output seen.
+ */
+class FrameExecutor : public compositor::PresentationObserver
 {
 public:
-    explicit FrameExecutor(time::AlarmFactory& alarm_factory);
+    /// How the frame that work was run for was presented
+    struct Presentation
+    {
+        geometry::Rectangle view_area;
+        graphics::Frame frame;
+        std::optional<std::chrono::nanoseconds> refresh_interval; ///< nullopt until the output's rate is learned
+        bool zero_copy;
+    };
+
+    FrameExecutor(std::shared_ptr<time::Clock> const& clock, time::AlarmFactory& alarm_factory);
+
+    // This can be called from any thread. Given callback is run on the thread frame_presented() is called on, or the
+    // main loop thread for the fallback. The wayland executor is NOT automatically used.
+    void spawn(std::function<void()>&& work, std::optional<geometry::Rectangle> const& area);
+
+    /// As above, but work is told about the presentation, or given nullopt if it is run by the fallback
+    void spawn(
+        std::function<void(std::optional<Presentation> const&)>&& work,
+        std::optional<geometry::Rectangle> const& area);
 
-    // This can be called from any thread. Given callback is run on the main loop thread. The wayland executor is NOT
-    // automatically used.
-    void spawn(std::function<void()>&& work) override;
+    void frame_presented(geometry::Rectangle const& view_area, graphics::Frame const& frame, bool zero_copy) override;
 
 private:
     struct Callbacks;
+    class AlarmCallback;
 
+    std::shared_ptr<time::Clock> const clock;
     std::shared_ptr<Callbacks> const callbacks; // shared_ptr so it can potentially outlive this object
     std::unique_ptr<time::Alarm> const alarm;
 
-    static void fire_callbacks(std::weak_ptr<Callbacks> const& weak_callbacks);
+    /// Arms the alarm for the earliest fallback deadline queued, or cancels it if nothing is queued.
+    /// Called with the callbacks' mutex held.
+    void schedule_fallback();
 };
 
 }
@@ -19,6 +19,7 @@
 
 #include "wayland_wrapper.h"
 #include "mir/events/xkb_modifiers.h"
+#include "mir/input/keymap_cache.h"
 
 #include <vector>
 #include <functional>
@@ -26,11 +27,6 @@
 struct MirEvent;
 struct MirKeyboardEvent;
 
-// from <xkbcommon/xkbcommon.h>
-struct xkb_keymap;
-struct xkb_state;
-struct xkb_context;
-
 namespace mir
 {
 namespace input
@@ -64,6 +60,7 @@ public:
         KeyboardCallbacks* keybaord_impl,
         std::shared_ptr<mir::input::Keymap> const& initial_keymap,
         std::shared_ptr<input::Seat> const& seat,
+        std::shared_ptr<input::KeymapCache> const& keymap_cache,
         bool enable_key_repeat);
 
     void handle_event(std::shared_ptr<MirEvent const> const& event);
@@ -80,10 +77,11 @@ private:
 
     KeyboardCallbacks* const callbacks;
     std::shared_ptr<input::Seat> const mir_seat;
+    std::shared_ptr<input::KeymapCache> const keymap_cache;
     MirXkbModifiers modifiers;
     std::shared_ptr<mir::input::Keymap> current_keymap;
-    std::unique_ptr<xkb_keymap, void (*)(xkb_keymap *)> compiled_keymap;
-    std::unique_ptr<xkb_context, void (*)(xkb_context *)> const context;
+    /// Shared with every other client using the same keymap
+    std::shared_ptr<input::KeymapCache::File const> keymap_file;
 };
 }
 }
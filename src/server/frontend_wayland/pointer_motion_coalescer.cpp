@@ -0,0 +1,125 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pointer_motion_coalescer.h"
+
+#include <mir/events/pointer_event.h>
+
+namespace mf = mir::frontend;
+namespace geom = mir::geometry;
+
+namespace
+{
+auto is_motion_only(MirInputEvent const& event) -> bool
+{
+    if (event.input_type() != mir_input_event_type_pointer)
+    {
+        return false;
+    }
+
+    auto const& pointer_event = *event.to_pointer();
+    return pointer_event.action() == mir_pointer_action_motion &&
+           pointer_event.h_scroll() == mir::events::ScrollAxisH{} &&
+           pointer_event.v_scroll() == mir::events::ScrollAxisV{};
+}
+}
+
+class mf::PointerMotionCoalescer::Queued
+{
+public:
+    explicit Queued(std::shared_ptr<MirInputEvent const> const& event)
+        : latest{event}
+    {
+    }
+
+    void merge(std::shared_ptr<MirInputEvent const> const& event)
+    {
+        if (!merged)
+        {
+            auto const motion = latest->to_pointer()->motion();
+            dx = motion.dx.as_value();
+            dy = motion.dy.as_value();
+            merged = true;
+        }
+
+        auto const motion = event->to_pointer()->motion();
+        dx += motion.dx.as_value();
+        dy += motion.dy.as_value();
+        latest = event;
+    }
+
+    auto event() const -> std::shared_ptr<MirInputEvent const>
+    {
+        if (!merged)
+        {
+            return latest;
+        }
+
+        auto const result = std::make_shared<MirPointerEvent>(*latest->to_pointer());
+        result->set_motion({static_cast<float>(dx), static_cast<float>(dy)});
+        return result;
+    }
+
+private:
+    std::shared_ptr<MirInputEvent const> latest;
+    bool merged{false};
+    /// Summed as doubles, so that the whole-count deltas of unaccelerated motion stay exact
+    double dx{0};
+    double dy{0};
+};
+
+mf::PointerMotionCoalescer::PointerMotionCoalescer(bool enabled)
+    : enabled{enabled}
+{
+}
+
+mf::PointerMotionCoalescer::~PointerMotionCoalescer() = default;
+
+void mf::PointerMotionCoalescer::set_enabled(bool enabled)
+{
+    this->enabled = enabled;
+}
+
+auto mf::PointerMotionCoalescer::queue(std::shared_ptr<MirInputEvent const> const& event) -> std::shared_ptr<Queued>
+{
+    auto const mergeable = enabled && is_motion_only(*event);
+
+    std::lock_guard lock{mutex};
+    if (!mergeable)
+    {
+        open.reset();
+        return std::make_shared<Queued>(event);
+    }
+
+    if (open)
+    {
+        open->merge(event);
+        return nullptr;
+    }
+
+    open = std::make_shared<Queued>(event);
+    return open;
+}
+
+auto mf::PointerMotionCoalescer::take(Queued& queued) -> std::shared_ptr<MirInputEvent const>
+{
+    std::lock_guard lock{mutex};
+    if (open.get() == &queued)
+    {
+        open.reset();
+    }
+    return queued.event();
+}
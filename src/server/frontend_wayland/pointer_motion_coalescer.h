@@ -0,0 +1,76 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_POINTER_MOTION_COALESCER_H
+#define MIR_FRONTEND_POINTER_MOTION_COALESCER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+struct MirInputEvent;
+
+namespace mir
+{
+namespace frontend
+{
+/**
+ * Merges the pointer motion for one surface that arrives while earlier motion is still
+ * waiting for the Wayland thread
+ *
+ * A fast mouse can report thousands of motions a second, far more than a client renders.
+ * While a motion is queued for the Wayland thread, later motion-only events are merged
+ * into it rather than queued themselves: the merged event has the position (and time)
+ * of the latest motion and the sum of all their relative motion. Any other input event
+ * (a button, a scroll, touch...) ends the merge, so events are never reordered.
+ *
+ * queue() may be called from any thread, take() from the Wayland thread.
+ */
+class PointerMotionCoalescer
+{
+public:
+    /// An event queued for the Wayland thread
+    class Queued;
+
+    explicit PointerMotionCoalescer(bool enabled);
+    ~PointerMotionCoalescer();
+
+    PointerMotionCoalescer(PointerMotionCoalescer const&) = delete;
+    PointerMotionCoalescer& operator=(PointerMotionCoalescer const&) = delete;
+
+    /// Clients that want every motion (e.g. those using relative pointer) can turn merging off
+    void set_enabled(bool enabled);
+
+    /**
+     * \return  the event to dispatch on the Wayland thread, or nullptr if the event was
+     *          merged into a motion that is already queued
+     */
+    auto queue(std::shared_ptr<MirInputEvent const> const& event) -> std::shared_ptr<Queued>;
+
+    /// The queued event, including any motion merged into it. Stops further merging into it.
+    auto take(Queued& queued) -> std::shared_ptr<MirInputEvent const>;
+
+private:
+    std::atomic<bool> enabled;
+
+    std::mutex mutex;
+    /// The motion that later motion can still be merged into, if any
+    std::shared_ptr<Queued> open;
+};
+}
+}
+
+#endif //MIR_FRONTEND_POINTER_MOTION_COALESCER_H
@@ -0,0 +1,199 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "presentation_time.h"
+
+#include "output_manager.h"
+#include "wayland_timespec.h"
+#include "wl_surface.h"
+
+#include "mir/executor.h"
+#include "mir/graphics/display_configuration.h"
+
+#include <ctime>
+
+namespace mf = mir::frontend;
+namespace mw = mir::wayland;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// The only clock we advertise; gbm-kms page flips and the compositor's own timestamps are already in it
+clockid_t const presentation_clock{CLOCK_MONOTONIC};
+
+class PresentationGlobal : public mw::Presentation::Global
+{
+public:
+    PresentationGlobal(wl_display* display, mf::OutputManager* output_manager);
+
+private:
+    void bind(wl_resource* new_resource) override;
+
+    mf::OutputManager* const output_manager;
+};
+
+class Presentation : public mw::Presentation
+{
+public:
+    Presentation(wl_resource* resource, mf::OutputManager* output_manager);
+
+private:
+    void feedback(struct wl_resource* surface, struct wl_resource* callback) override;
+
+    mf::OutputManager* const output_manager;
+};
+}
+
+auto mf::create_presentation_time(wl_display* display, OutputManager* output_manager)
+-> std::shared_ptr<mw::Presentation::Global>
+{
+    return std::make_shared<PresentationGlobal>(display, output_manager);
+}
+
+PresentationGlobal::PresentationGlobal(wl_display* display, mf::OutputManager* output_manager)
+    : Global{display, Version<1>()},
+      output_manager{output_manager}
+{
+}
+
+void PresentationGlobal::bind(wl_resource* new_resource)
+{
+    auto const presentation = new Presentation{new_resource, output_manager};
+    presentation->send_clock_id_event(presentation_clock);
+}
+
+Presentation::Presentation(wl_resource* resource, mf::OutputManager* output_manager)
+    : mw::Presentation{resource, Version<1>()},
+      output_manager{output_manager}
+{
+}
+
+void Presentation::feedback(struct wl_resource* surface, struct wl_resource* callback)
+{
+    auto const feedback = new mf::PresentationFeedback{callback, output_manager};
+    mf::WlSurface::from(surface)->add_presentation_feedback(feedback);
+}
+
+mf::PresentationFeedback::PresentationFeedback(wl_resource* new_resource, OutputManager* output_manager)
+    : mw::PresentationFeedback{new_resource, Version<1>()},
+      output_manager{output_manager}
+{
+}
+
+void mf::PresentationFeedback::send_feedback(std::optional<FrameExecutor::Presentation> const& presentation)
+{
+    if (presentation)
+    {
+        send_sync_output(presentation->view_area);
+
+        auto ust = presentation->frame.ust;
+        if (ust.clock_id != presentation_clock)
+        {
+            ust = mg::Frame::Timestamp::now(presentation_clock);
+        }
+
+        // mir::time::Timestamp is a steady_clock time, which is CLOCK_MONOTONIC
+        WaylandTimespec const timespec{time::Timestamp{ust.nanoseconds}};
+        auto const msc = static_cast<uint64_t>(presentation->frame.msc);
+        auto const refresh = presentation->refresh_interval.value_or(std::chrono::nanoseconds::zero());
+
+        uint32_t flags{0};
+        if (presentation->frame.msc != 0)
+        {
+            flags |= Kind::vsync;
+        }
+        if (presentation->zero_copy)
+        {
+            flags |= Kind::zero_copy;
+        }
+
+        send_presented_event(
+            timespec.tv_sec_hi,
+            timespec.tv_sec_lo,
+            timespec.tv_nsec,
+            static_cast<uint32_t>(refresh.count()),
+            static_cast<uint32_t>(msc >> 32),
+            static_cast<uint32_t>(msc),
+            flags);
+    }
+    else
+    {
+        send_discarded_event();
+    }
+
+    destroy_and_delete();
+}
+
+void mf::PresentationFeedback::send_sync_output(geom::Rectangle const& view_area)
+{
+    bool found{false};
+    output_manager->current_config().for_each_output([&](mg::DisplayConfigurationOutput const& config)
+        {
+            // Cloned outputs share a view area; presentation is synchronised to the first
+            if (found || !config.used || config.extents() != view_area)
+            {
+                return;
+            }
+            found = true;
+
+            if (auto const output = output_manager->output_for(config.id))
+            {
+                output.value()->for_each_output_bound_by(
+                    client,
+                    [this](OutputInstance* instance)
+                    {
+                        send_sync_output_event(instance->resource);
+                    });
+            }
+        });
+}
+
+mf::CommitFeedback::CommitFeedback(
+    std::shared_ptr<Executor> const& wayland_executor,
+    std::vector<mw::Weak<PresentationFeedback>> const& feedback)
+    : wayland_executor{wayland_executor},
+      feedback{feedback}
+{
+}
+
+mf::CommitFeedback::~CommitFeedback()
+{
+    presented(std::nullopt);
+}
+
+void mf::CommitFeedback::presented(std::optional<FrameExecutor::Presentation> const& presentation)
+{
+    std::unique_lock lock{mutex};
+    if (feedback.empty())
+    {
+        return;
+    }
+    auto to_send = std::move(feedback);
+    feedback.clear();
+    lock.unlock();
+
+    wayland_executor->spawn([to_send = std::move(to_send), presentation]()
+        {
+            for (auto const& weak_feedback : to_send)
+            {
+                if (weak_feedback)
+                {
+                    weak_feedback.value().send_feedback(presentation);
+                }
+            }
+        });
+}
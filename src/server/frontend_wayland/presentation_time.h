@@ -0,0 +1,76 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_PRESENTATION_TIME_H_
+#define MIR_FRONTEND_PRESENTATION_TIME_H_
+
+#include "presentation-time_wrapper.h"
+#include "frame_executor.h"
+#include "mir/wayland/weak.h"
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace mir
+{
+class Executor;
+namespace frontend
+{
+class OutputManager;
+
+auto create_presentation_time(wl_display* display, OutputManager* output_manager)
+-> std::shared_ptr<wayland::Presentation::Global>;
+
+class PresentationFeedback : public wayland::PresentationFeedback
+{
+public:
+    PresentationFeedback(wl_resource* new_resource, OutputManager* output_manager);
+
+    /// Sends how the content was presented, or that it was discarded if presentation is nullopt, and destroys this
+    void send_feedback(std::optional<FrameExecutor::Presentation> const& presentation);
+
+private:
+    void send_sync_output(geometry::Rectangle const& view_area);
+
+    OutputManager* const output_manager;
+};
+
+/// The presentation feedback clients requested for a single wl_surface commit
+class CommitFeedback
+{
+public:
+    CommitFeedback(
+        std::shared_ptr<Executor> const& wayland_executor,
+        std::vector<wayland::Weak<PresentationFeedback>> const& feedback);
+
+    /// Any feedback not yet sent is discarded, as the commit never reached the screen
+    ~CommitFeedback();
+
+    /// Can be called from any thread; feedback is only sent once
+    void presented(std::optional<FrameExecutor::Presentation> const& presentation);
+
+private:
+    std::shared_ptr<Executor> const wayland_executor;
+
+    std::mutex mutex;
+    std::vector<wayland::Weak<PresentationFeedback>> feedback;
+};
+}
+}
+
+#endif // MIR_FRONTEND_PRESENTATION_TIME_H_
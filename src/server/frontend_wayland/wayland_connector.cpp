@@ -30,6 +30,7 @@
 #include "foreign_toplevel_manager_v1.h"
 
 #include "mir/main_loop.h"
+#include "mir/observer_registrar.h"
 #include "mir/thread_name.h"
 #include "mir/log.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
@@ -66,7 +67,7 @@ public:
     WlCompositor(
         struct wl_display* display,
         std::shared_ptr<mir::Executor> const& wayland_executor,
-        std::shared_ptr<mir::Executor> const& frame_callback_executor,
+        std::shared_ptr<FrameExecutor> const& frame_callback_executor,
         std::shared_ptr<mg::GraphicBufferAllocator> const& allocator)
         : Global(display, Version<4>()),
           allocator{allocator},
@@ -80,7 +81,7 @@ public:
 private:
     std::shared_ptr<mg::GraphicBufferAllocator> const allocator;
     std::shared_ptr<mir::Executor> const wayland_executor;
-    std::shared_ptr<mir::Executor> const frame_callback_executor;
+    std::shared_ptr<FrameExecutor> const frame_callback_executor;
     std::map<std::pair<wl_client*, uint32_t>, std::vector<std::function<void(WlSurface*)>>> surface_callbacks;
 
     class Instance : wayland::Compositor
@@ -221,6 +222,8 @@ mf::WaylandConnector::WaylandConnector(
     std::shared_ptr<time::Clock> const& clock,
     std::shared_ptr<mi::InputDeviceHub> const& input_hub,
     std::shared_ptr<mi::Seat> const& seat,
+    std::shared_ptr<mi::InputReport> const& input_report,
+    std::shared_ptr<mi::KeymapCache> const& keymap_cache,
     std::shared_ptr<ObserverRegistrar<input::KeyboardObserver>> const& keyboard_observer_registrar,
     std::shared_ptr<mi::InputDeviceRegistry> const& input_device_registry,
     std::shared_ptr<mi::CompositeEventFilter> const& composite_event_filter,
@@ -235,14 +238,19 @@ mf::WaylandConnector::WaylandConnector(
     std::shared_ptr<ms::TextInputHub> const& text_input_hub,
     std::shared_ptr<ms::IdleHub> const& idle_hub,
     std::shared_ptr<mc::ScreenShooter> const& screen_shooter,
+    std::shared_ptr<ObserverRegistrar<mc::PresentationObserver>> const& presentation_registrar,
     std::shared_ptr<MainLoop> const& main_loop,
     bool arw_socket,
     std::unique_ptr<WaylandExtensions> extensions_,
     WaylandProtocolExtensionFilter const& extension_filter,
-    bool enable_key_repeat)
+    bool enable_key_repeat,
+    bool coalesce_pointer_motion,
+    bool report_input_stages)
     : extension_filter{extension_filter},
       display{wl_display_create(), &cleanup_display},
       pause_signal{eventfd(0, EFD_CLOEXEC | EFD_SEMAPHORE)},
+      presentation_registrar{presentation_registrar},
+      frame_executor{std::make_shared<FrameExecutor>(clock, *main_loop)},
       executor{std::make_shared<WaylandExecutor>(wl_display_get_event_loop(display.get()))},
       allocator{allocator_for_display(allocator, display.get(), executor)},
       shell{shell},
@@ -277,10 +285,11 @@ mf::WaylandConnector::WaylandConnector(
      * So far I've only found ones which expect wl_compositor before anything else,
      * so stick that first.
      */
+    presentation_registrar->register_interest(frame_executor);
     compositor_global = std::make_unique<mf::WlCompositor>(
         display.get(),
         executor,
-        std::make_shared<FrameExecutor>(*main_loop),
+        frame_executor,
         this->allocator);
     subcompositor_global = std::make_unique<mf::WlSubcompositor>(display.get());
     seat_global = std::make_unique<mf::WlSeat>(
@@ -290,7 +299,11 @@ mf::WaylandConnector::WaylandConnector(
         input_hub,
         keyboard_observer_registrar,
         seat,
-        enable_key_repeat);
+        input_report,
+        keymap_cache,
+        enable_key_repeat,
+        coalesce_pointer_motion,
+        report_input_stages);
     output_manager = std::make_unique<mf::OutputManager>(
         display.get(),
         executor,
@@ -380,6 +393,8 @@ mf::WaylandConnector::WaylandConnector(
 
 mf::WaylandConnector::~WaylandConnector()
 {
+    presentation_registrar->unregister_interest(*frame_executor);
+
     try
     {
         allocator->unbind_display(display.get());
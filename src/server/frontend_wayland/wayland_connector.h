@@ -39,6 +39,7 @@ class ObserverRegistrar;
 
 namespace compositor
 {
+class PresentationObserver;
 class ScreenShooter;
 }
 
@@ -46,6 +47,8 @@ namespace input
 {
 class InputDeviceHub;
 class InputDeviceRegistry;
+class InputReport;
+class KeymapCache;
 class Seat;
 class CompositeEventFilter;
 class KeyboardObserver;
@@ -72,6 +75,7 @@ class Clock;
 }
 namespace frontend
 {
+class FrameExecutor;
 class OutputManager;
 class PointerInputDispatcher;
 class SessionAuthorizer;
@@ -140,6 +144,8 @@ public:
         std::shared_ptr<time::Clock> const& clock,
         std::shared_ptr<input::InputDeviceHub> const& input_hub,
         std::shared_ptr<input::Seat> const& seat,
+        std::shared_ptr<input::InputReport> const& input_report,
+        std::shared_ptr<input::KeymapCache> const& keymap_cache,
         std::shared_ptr<ObserverRegistrar<input::KeyboardObserver>> const& keyboard_observer_registrar,
         std::shared_ptr<input::InputDeviceRegistry> const& input_device_registry,
         std::shared_ptr<input::CompositeEventFilter> const& composite_event_filter,
@@ -154,11 +160,14 @@ public:
         std::shared_ptr<scene::TextInputHub> const& text_input_hub,
         std::shared_ptr<scene::IdleHub> const& idle_hub,
         std::shared_ptr<compositor::ScreenShooter> const& screen_shooter,
+        std::shared_ptr<ObserverRegistrar<compositor::PresentationObserver>> const& presentation_registrar,
         std::shared_ptr<MainLoop> const& main_loop,
         bool arw_socket,
         std::unique_ptr<WaylandExtensions> extensions,
         WaylandProtocolExtensionFilter const& extension_filter,
-        bool enable_key_repeat);
+        bool enable_key_repeat,
+        bool coalesce_pointer_motion,
+        bool report_input_stages);
 
     ~WaylandConnector() override;
 
@@ -197,6 +206,8 @@ private:
 
     std::unique_ptr<wl_display, void(*)(wl_display*)> const display;
     mir::Fd const pause_signal;
+    std::shared_ptr<ObserverRegistrar<compositor::PresentationObserver>> const presentation_registrar;
+    std::shared_ptr<FrameExecutor> const frame_executor;
     std::unique_ptr<WlCompositor> compositor_global;
     std::unique_ptr<WlSubcompositor> subcompositor_global;
     std::unique_ptr<WlSeat> seat_global;
@@ -37,6 +37,7 @@
 #include "input_method_v2.h"
 #include "idle_inhibit_v1.h"
 #include "wlr_screencopy_v1.h"
+#include "presentation_time.h"
 #include "primary_selection_v1.h"
 #include "session_lock_v1.h"
 
@@ -194,6 +195,10 @@ std::vector<ExtensionBuilder> const internal_extension_builders = {
                 ctx.screen_shooter,
                 ctx.surface_stack);
         }),
+    make_extension_builder<mw::Presentation>([](auto const& ctx)
+        {
+            return mf::create_presentation_time(ctx.display, ctx.output_manager);
+        }),
     make_extension_builder<mw::PrimarySelectionDeviceManagerV1>([](auto const& ctx)
         {
             return mf::create_primary_selection_device_manager_v1(ctx.display, ctx.wayland_executor, ctx.primary_selection_clipboard);
@@ -304,6 +309,7 @@ auto mf::get_standard_extensions() -> std::vector<std::string>
         mw::XdgWmBase::interface_name,
         mw::XdgShellV6::interface_name,
         mw::XdgOutputManagerV1::interface_name,
+        mw::Presentation::interface_name,
         mw::TextInputManagerV1::interface_name,
         mw::TextInputManagerV2::interface_name,
         mw::TextInputManagerV3::interface_name};
@@ -333,6 +339,9 @@ std::shared_ptr<mf::Connector>
                 enabled_wayland_extensions.end()};
 
             auto const enable_repeat = options->get<bool>(options::enable_key_repeat_opt);
+            auto const coalesce_motion = options->get<bool>(options::coalesce_pointer_motion_opt);
+            auto const report_input_stages =
+                options->get<std::string>(options::input_report_opt) != options::off_opt_value;
             auto const x11_enabled = options->is_set(mo::x11_display_opt) && options->get<bool>(mo::x11_display_opt);
 
             return std::make_shared<mf::WaylandConnector>(
@@ -340,6 +349,8 @@ std::shared_ptr<mf::Connector>
                 the_clock(),
                 the_input_device_hub(),
                 the_seat(),
+                the_input_report(),
+                the_keymap_cache(),
                 the_keyboard_observer_registrar(),
                 the_input_device_registry(),
                 the_composite_event_filter(),
@@ -354,6 +365,7 @@ std::shared_ptr<mf::Connector>
                 the_text_input_hub(),
                 the_idle_hub(),
                 the_screen_shooter(),
+                the_presentation_observer_registrar(),
                 the_main_loop(),
                 arw_socket,
                 configure_wayland_extensions(
@@ -361,7 +373,9 @@ std::shared_ptr<mf::Connector>
                     x11_enabled,
                     wayland_extension_hooks),
                 wayland_extension_filter,
-                enable_repeat);
+                enable_repeat,
+                coalesce_motion,
+                report_input_stages);
         });
 }
 
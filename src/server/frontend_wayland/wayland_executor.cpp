@@ -15,6 +15,7 @@
  */
 
 #include "wayland_executor.h"
+#include "work_queue.h"
 
 #include "mir/fd.h"
 #include "mir/log.h"
@@ -23,11 +24,12 @@
 
 #include <boost/throw_exception.hpp>
 
+#include <atomic>
 #include <cstring>
-#include <deque>
 #include <functional>
 #include <mutex>
 #include <system_error>
+#include <utility>
 
 namespace mf = mir::frontend;
 
@@ -64,21 +66,35 @@ public:
             });
     }
 
-    void enqueue(std::function<void()>&& work)
+    /// \return true if the event loop needs to be notified of the work
+    auto enqueue(std::function<void()>&& work) -> bool
     {
         if (on_wayland_thread)
         {
+            // Still wake the loop, as callers may be relying on the loop dispatching after spawn()
             work();
-            return;
+            return true;
         }
 
-        std::lock_guard lock{mutex};
         if (state == ExecutionState::Running)
         {
-            workqueue.emplace_back(std::move(work));
+            auto const needs_notify = workqueue.push(std::move(work));
+
+            /* If we were stopped between checking state and pushing, nothing will run the work,
+             * and it would sit in the queue until the State is destroyed. Stopping and clearing
+             * the queue happen with mutex held, so either that clear saw our work or we see Stopped.
+             */
+            if (state == ExecutionState::Stopped)
+            {
+                std::lock_guard lock{mutex};
+                workqueue.clear();
+                return false;
+            }
+            return needs_notify;
         }
         // If we've been terminated then drop the work on the floor, letting the
         // std::function destructor clean up any necessary state.
+        return false;
     }
 
     void enqueue_termination(std::function<void()>&& terminator)
@@ -86,34 +102,22 @@ public:
         std::lock_guard lock{mutex};
         if (state == ExecutionState::Running)
         {
-            workqueue.emplace_front(std::move(terminator));
+            this->terminator = std::move(terminator);
             on_wayland_thread = false;
             state = ExecutionState::TerminationRequested;
         }
     }
 
-    std::function<void()> get_work()
-    {
-        std::lock_guard lock{mutex};
-        if (!workqueue.empty())
-        {
-            auto const work = std::move(workqueue.front());
-            workqueue.pop_front();
-            return work;
-        }
-        return {};
-    }
-
     auto drain()
     {
         std::unique_lock lock{mutex};
 
-        if (state == ExecutionState::TerminationRequested)
+        if (terminator)
         {
-            // If we've been asked to terminate then the front of the workqueue
-            // will contain the termination request.
+            // If we've been asked to terminate then the termination request
+            // must run before any other work.
             {
-                std::function<void()> const work = std::move(workqueue.front());
+                std::function<void()> const work = std::exchange(terminator, nullptr);
                 lock.unlock();
 
                 work();
@@ -121,20 +125,34 @@ public:
             lock.lock();
         }
 
-        on_wayland_thread = false;
-        state = ExecutionState::Stopped;
-        workqueue.clear();
+        stop(lock);
 
         return lock;
     }
 
     static int on_notify(int fd, uint32_t, void* data);
 private:
+    /// Drop all pending work. Once Stopped, only the holder of mutex may touch workqueue.
+    void stop(std::unique_lock<std::mutex> const&)
+    {
+        on_wayland_thread = false;
+        state = ExecutionState::Stopped;
+        workqueue.clear();
+    }
+
+    auto take_terminator() -> std::function<void()>
+    {
+        std::lock_guard lock{mutex};
+        return std::exchange(terminator, nullptr);
+    }
+
     static thread_local bool on_wayland_thread;
     std::mutex mutex;
-    ExecutionState state{ExecutionState::Running};
+    std::atomic<ExecutionState> state{ExecutionState::Running};
     wl_event_loop* const loop;
-    std::deque<std::function<void()>> workqueue;
+    std::function<void()> terminator;   ///< Guarded by mutex
+    /// Filled from any thread, but only drained on the Wayland thread (or once it has stopped)
+    WorkQueue workqueue;
 };
 
 thread_local bool mf::WaylandExecutor::State::on_wayland_thread{false};
@@ -160,9 +178,10 @@ public:
 
         EventLoopDestroyedHandler* me;
         me = wl_container_of(listener, me, destruction_listener);
-        delete me;
 
+        // The listener is part of me, so unlink it before it's freed
         wl_list_remove(&listener->link);
+        delete me;
     }
 private:
     EventLoopDestroyedHandler(
@@ -231,23 +250,44 @@ int mf::WaylandExecutor::State::on_notify(int fd, uint32_t, void* data)
             err);
     }
 
-    while (auto work = state->get_work())
-    {
-        try
-        {
-            work();
-        }
-        catch (...)
+    // Anything enqueued from here on will notify us again, so nothing can be missed
+    state->workqueue.prepare_to_drain();
+
+    auto const run = [](std::function<void()> const& work)
         {
-            mir::log(
-                mir::logging::Severity::critical,
-                MIR_LOG_COMPONENT,
-                std::current_exception(),
-                "Exception processing Wayland event loop work item");
-        }
+            try
+            {
+                work();
+            }
+            catch (...)
+            {
+                mir::log(
+                    mir::logging::Severity::critical,
+                    MIR_LOG_COMPONENT,
+                    std::current_exception(),
+                    "Exception processing Wayland event loop work item");
+            }
+        };
+
+    // Termination jumps the queue
+    if (auto const terminator = state->take_terminator())
+    {
+        run(terminator);
+    }
+
+    // Drain everything queued, however many notifications it was queued with
+    while (auto const work = state->workqueue.pop())
+    {
+        run(work);
     }
     if (state->state != ExecutionState::Running)
     {
+        // The terminator has removed our event source, so drop anything that raced in after the last pop()
+        {
+            std::unique_lock lock{state->mutex};
+            state->stop(lock);
+        }
+        // This may destroy state
         EventLoopDestroyedHandler::remove_destruction_handler_for_loop(state->loop);
     }
 
@@ -324,7 +364,11 @@ mf::WaylandExecutor::~WaylandExecutor()
 
 void mf::WaylandExecutor::spawn (std::function<void()>&& work)
 {
-    state->enqueue(std::move(work));
+    // Only the first work since the event loop last started draining needs to notify it
+    if (!state->enqueue(std::move(work)))
+    {
+        return;
+    }
 
     if (auto err = eventfd_write(notify_fd, 1))
     {
@@ -70,6 +70,23 @@ void mf::WaylandInputDispatcher::handle_event(std::shared_ptr<MirInputEvent cons
     // Keyboard events are sent to the WlSeat via it's KeyboardObserver
 
     default:
-        break;
+        return;
     }
+
+    seat->sent_input_event(event->event_time());
+}
+
+auto mf::WaylandInputDispatcher::client_wants_every_motion() const -> bool
+{
+    if (!wl_surface)
+    {
+        return false;
+    }
+
+    bool wants_every_motion = false;
+    seat->for_each_listener(wl_surface.value().client, [&](PointerEventDispatcher* pointer)
+        {
+            wants_every_motion |= pointer->wants_every_motion();
+        });
+    return wants_every_motion;
 }
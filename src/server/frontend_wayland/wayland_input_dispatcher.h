@@ -50,6 +50,9 @@ public:
 
     void handle_event(std::shared_ptr<MirInputEvent const> const& event);
 
+    /// If any of the surface's client's pointers wants every motion, rather than merged bursts of motion
+    auto client_wants_every_motion() const -> bool;
+
 private:
     WaylandInputDispatcher(WaylandInputDispatcher const&) = delete;
     WaylandInputDispatcher& operator=(WaylandInputDispatcher const&) = delete;
@@ -18,6 +18,7 @@
 #include "wayland_utils.h"
 #include "window_wl_surface_role.h"
 #include "wl_surface.h"
+#include "wl_seat.h"
 
 #include <mir/executor.h>
 #include <mir/log.h>
@@ -38,7 +39,8 @@ mf::WaylandSurfaceObserver::WaylandSurfaceObserver(
     : wayland_executor{wayland_executor},
       impl{std::make_shared<Impl>(
           mw::make_weak(window),
-          std::make_unique<WaylandInputDispatcher>(seat, surface))}
+          std::make_unique<WaylandInputDispatcher>(seat, surface),
+          seat->coalesces_pointer_motion())}
 {
 }
 
@@ -108,11 +110,33 @@ void mf::WaylandSurfaceObserver::input_consumed(ms::Surface const*, std::shared_
 {
     if (mir_event_get_type(event.get()) == mir_event_type_input)
     {
-        run_on_wayland_thread_unless_window_destroyed(
-            [event](Impl* impl, WindowWlSurfaceRole*)
-            {
-                impl->input_dispatcher->handle_event(std::dynamic_pointer_cast<MirInputEvent const>(event));
-            });
+        // Input can arrive far faster than other surface changes, so this spawns one task
+        // (rather than wrapping one in another) that shares ownership of the event
+        std::shared_ptr<MirInputEvent const> input_event{event, event->to_input()};
+        if (!impl->coalesce_pointer_motion)
+        {
+            wayland_executor.spawn(
+                [impl=impl, input_event=std::move(input_event)]
+                {
+                    if (impl->window)
+                    {
+                        impl->input_dispatcher->handle_event(input_event);
+                    }
+                });
+        }
+        else if (auto queued = impl->motion_coalescer.queue(input_event))
+        {
+            // (Otherwise the event was merged into motion that is already queued)
+            wayland_executor.spawn(
+                [impl=impl, queued=std::move(queued)]
+                {
+                    if (impl->window)
+                    {
+                        impl->motion_coalescer.set_enabled(!impl->input_dispatcher->client_wants_every_motion());
+                        impl->input_dispatcher->handle_event(impl->motion_coalescer.take(*queued));
+                    }
+                });
+        }
     }
 }
 
@@ -18,6 +18,7 @@
 #define MIR_FRONTEND_WAYLAND_SURFACE_OBSERVER_H_
 
 #include "wayland_input_dispatcher.h"
+#include "pointer_motion_coalescer.h"
 #include <mir/scene/null_surface_observer.h>
 #include <mir/wayland/weak.h>
 
@@ -80,14 +81,20 @@ private:
     {
         Impl(
             wayland::Weak<WindowWlSurfaceRole> window,
-            std::unique_ptr<WaylandInputDispatcher> input_dispatcher)
+            std::unique_ptr<WaylandInputDispatcher> input_dispatcher,
+            bool coalesce_pointer_motion)
             : window{window},
-              input_dispatcher{std::move(input_dispatcher)}
+              input_dispatcher{std::move(input_dispatcher)},
+              coalesce_pointer_motion{coalesce_pointer_motion},
+              motion_coalescer{true}
         {
         }
 
         wayland::Weak<WindowWlSurfaceRole> const window;
         std::unique_ptr<WaylandInputDispatcher> const input_dispatcher;
+        bool const coalesce_pointer_motion;
+        /// Only used if coalesce_pointer_motion, from the input thread as well as the Wayland thread
+        PointerMotionCoalescer motion_coalescer;
 
         geometry::Size window_size{};
         std::optional<geometry::Size> requested_size{};
@@ -191,6 +191,11 @@ void mir::frontend::WlPointer::set_relative_pointer(mir::wayland::RelativePointe
     relative_pointer = make_weak(relative_ptr);
 }
 
+auto mir::frontend::WlPointer::has_relative_pointer() const -> bool
+{
+    return static_cast<bool>(relative_pointer);
+}
+
 void mir::frontend::WlPointer::event(std::shared_ptr<MirPointerEvent const> const& event, WlSurface& root_surface)
 {
     switch(mir_pointer_event_action(event.get()))
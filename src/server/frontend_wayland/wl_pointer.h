@@ -70,6 +70,7 @@ public:
     ~WlPointer();
 
     void set_relative_pointer(wayland::RelativePointerV1* relative_ptr);
+    auto has_relative_pointer() const -> bool;
 
     /// Convert the Mir event into Wayland events and send them to the client. root_surface is the one that received
     /// the Mir event, but the final Wayland event may be sent to a subsurface.
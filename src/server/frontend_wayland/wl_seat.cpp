@@ -34,6 +34,8 @@
 #include "mir/input/parameter_keymap.h"
 #include "mir/input/mir_keyboard_config.h"
 #include "mir/input/keyboard_observer.h"
+#include "mir/input/input_report.h"
+#include "mir/events/input_event.h"
 #include "mir/scene/surface.h"
 #include "mir_toolkit/events/input/pointer_event.h"
 
@@ -155,6 +157,7 @@ public:
                 {
                     keyboard->handle_event(event);
                 });
+            seat.sent_input_event(event->to_input()->event_time());
         }
     }
 
@@ -194,7 +197,11 @@ mf::WlSeat::WlSeat(
     std::shared_ptr<mi::InputDeviceHub> const& input_hub,
     std::shared_ptr<ObserverRegistrar<input::KeyboardObserver>> const& keyboard_observer_registrar,
     std::shared_ptr<mi::Seat> const& seat,
-    bool enable_key_repeat)
+    std::shared_ptr<mi::InputReport> const& input_report,
+    std::shared_ptr<mi::KeymapCache> const& keymap_cache,
+    bool enable_key_repeat,
+    bool coalesce_pointer_motion,
+    bool report_input_stages)
     :   Global(display, Version<8>()),
         keymap{std::make_shared<input::ParameterKeymap>()},
         config_observer{
@@ -213,7 +220,12 @@ mf::WlSeat::WlSeat(
         clock{clock},
         input_hub{input_hub},
         seat{seat},
-        enable_key_repeat{enable_key_repeat}
+        input_report{input_report},
+        keymap_cache{keymap_cache},
+        enable_key_repeat{enable_key_repeat},
+        coalesce_pointer_motion{coalesce_pointer_motion},
+        report_input_stages{report_input_stages},
+        display{display}
 {
     input_hub->add_observer(config_observer);
     keyboard_observer_registrar->register_interest(keyboard_observer, wayland_executor);
@@ -221,6 +233,10 @@ mf::WlSeat::WlSeat(
 
 mf::WlSeat::~WlSeat()
 {
+    if (report_source)
+    {
+        wl_event_source_remove(report_source);
+    }
     keyboard_observer_registrar->unregister_interest(*keyboard_observer);
     input_hub->remove_observer(config_observer);
     if (focused_surface)
@@ -250,9 +266,43 @@ void mf::WlSeat::for_each_listener(mw::Client* client, std::function<void(WlTouc
     touch_listeners->for_each(client, func);
 }
 
+void mf::WlSeat::sent_input_event(std::chrono::nanoseconds event_time)
+{
+    if (!report_input_stages)
+    {
+        return;
+    }
+
+    if (!report_source)
+    {
+        // Idle sources run once the event loop has dispatched everything that's ready, so
+        // this sends everything queued by then together
+        report_source = wl_event_loop_add_idle(
+            wl_display_get_event_loop(display),
+            &report_sent_input_events,
+            this);
+    }
+    unflushed_input_events.push_back(event_time.count());
+}
+
+void mf::WlSeat::report_sent_input_events(void* data)
+{
+    auto const self = static_cast<WlSeat*>(data);
+    self->report_source = nullptr;
+
+    // Only once this returns have the events been written to the clients' sockets
+    wl_display_flush_clients(self->display);
+
+    for (auto const event_time : self->unflushed_input_events)
+    {
+        self->input_report->flushed_event_to_client(event_time);
+    }
+    self->unflushed_input_events.clear();
+}
+
 auto mf::WlSeat::make_keyboard_helper(KeyboardCallbacks* callbacks) -> std::unique_ptr<KeyboardHelper>
 {
-    return std::make_unique<KeyboardHelper>(callbacks, keymap, seat, enable_key_repeat);
+    return std::make_unique<KeyboardHelper>(callbacks, keymap, seat, keymap_cache, enable_key_repeat);
 }
 
 void mf::WlSeat::bind(wl_resource* new_wl_seat)
@@ -382,6 +432,11 @@ void mf::PointerEventDispatcher::event(std::shared_ptr<MirPointerEvent const> co
     }
 }
 
+auto mf::PointerEventDispatcher::wants_every_motion() const -> bool
+{
+    return wl_pointer && wl_pointer.value().has_relative_pointer();
+}
+
 void mf::PointerEventDispatcher::start_dispatch_to_data_device(WlDataDevice* wl_data_device)
 {
     this->wl_data_device = wayland::Weak<WlDataDevice>{wl_data_device};
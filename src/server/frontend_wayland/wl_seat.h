@@ -20,6 +20,7 @@
 #include "wayland_wrapper.h"
 #include "mir/wayland/weak.h"
 
+#include <chrono>
 #include <unordered_map>
 #include <vector>
 #include <functional>
@@ -34,8 +35,10 @@ class ObserverRegistrar;
 namespace input
 {
 class InputDeviceHub;
+class InputReport;
 class Seat;
 class Keymap;
+class KeymapCache;
 class KeyboardObserver;
 }
 namespace time
@@ -61,6 +64,9 @@ public:
 
     void start_dispatch_to_data_device(WlDataDevice* wl_data_device);
     void stop_dispatch_to_data_device();
+
+    /// If the client has asked for relative motion, and so wants every motion as it happens
+    auto wants_every_motion() const -> bool;
 private:
     wayland::Weak<WlPointer> wl_pointer;
     wayland::Weak<WlDataDevice> wl_data_device;
@@ -76,7 +82,11 @@ public:
         std::shared_ptr<mir::input::InputDeviceHub> const& input_hub,
         std::shared_ptr<ObserverRegistrar<input::KeyboardObserver>> const& keyboard_observer_registrar,
         std::shared_ptr<mir::input::Seat> const& seat,
-        bool enable_key_repeat);
+        std::shared_ptr<input::InputReport> const& input_report,
+        std::shared_ptr<input::KeymapCache> const& keymap_cache,
+        bool enable_key_repeat,
+        bool coalesce_pointer_motion,
+        bool report_input_stages);
 
     ~WlSeat();
 
@@ -101,12 +111,20 @@ public:
 
     auto make_keyboard_helper(KeyboardCallbacks* callbacks) -> std::unique_ptr<KeyboardHelper>;
 
+    /// If bursts of pointer motion may be merged before they are sent to clients
+    auto coalesces_pointer_motion() const -> bool { return coalesce_pointer_motion; }
+
+    /// An input event has been sent to a client: if input stages are reported, the report hears when it is flushed
+    void sent_input_event(std::chrono::nanoseconds event_time);
+
     /// Adds the listener for future use, and makes a call into it to inform of initial state
     void add_focus_listener(wayland::Client* client, FocusListener* listener);
     void remove_focus_listener(wayland::Client* client, FocusListener* listener);
 
 private:
     void set_focus_to(WlSurface* surface);
+    /// Flushes clients, then reports the events sent to them as flushed
+    static void report_sent_input_events(void* data);
 
     wayland::Client* focused_client{nullptr}; ///< Can be null
     wayland::Weak<WlSurface> focused_surface;
@@ -133,7 +151,16 @@ private:
     std::shared_ptr<time::Clock> const clock;
     std::shared_ptr<input::InputDeviceHub> const input_hub;
     std::shared_ptr<input::Seat> const seat;
+    std::shared_ptr<input::InputReport> const input_report;
+    std::shared_ptr<input::KeymapCache> const keymap_cache;
     bool const enable_key_repeat;
+    bool const coalesce_pointer_motion;
+    bool const report_input_stages;
+
+    wl_display* const display;
+    /// Times of the input events sent since clients were last flushed (only if report_input_stages)
+    std::vector<int64_t> unflushed_input_events;
+    wl_event_source* report_source{nullptr};
 
     void bind(wl_resource* new_wl_seat) override;
 };
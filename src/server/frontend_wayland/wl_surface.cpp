@@ -22,6 +22,8 @@
 #include "wl_region.h"
 #include "shm.h"
 #include "resource_lifetime_tracker.h"
+#include "frame_executor.h"
+#include "presentation_time.h"
 
 #include "wayland_wrapper.h"
 
@@ -35,10 +37,13 @@
 #include "mir/compositor/buffer_stream.h"
 #include "mir/executor.h"
 #include "mir/graphics/graphic_buffer_allocator.h"
+#include "mir/renderer/sw/pixel_source.h"
 #include "mir/scene/surface.h"
 #include "mir/shell/surface_specification.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/log.h"
 
+#include <algorithm>
 #include <chrono>
 #include <boost/throw_exception.hpp>
 #include <wayland-server-protocol.h>
@@ -48,6 +53,62 @@ namespace geom = mir::geometry;
 namespace mw = mir::wayland;
 namespace msh = mir::shell;
 
+namespace
+{
+// Larger than any buffer we will see, but small enough that scaling it won't overflow
+int64_t const max_damage_coordinate{1 << 20};
+
+auto clamped_damage(int32_t x, int32_t y, int32_t width, int32_t height) -> std::optional<geom::Rectangle>
+{
+    auto const left = std::clamp<int64_t>(x, 0, max_damage_coordinate);
+    auto const top = std::clamp<int64_t>(y, 0, max_damage_coordinate);
+    auto const right = std::clamp<int64_t>(int64_t{x} + width, 0, max_damage_coordinate);
+    auto const bottom = std::clamp<int64_t>(int64_t{y} + height, 0, max_damage_coordinate);
+
+    if (right <= left || bottom <= top)
+        return std::nullopt;
+
+    return geom::Rectangle{
+        {static_cast<int>(left), static_cast<int>(top)},
+        {static_cast<int>(right - left), static_cast<int>(bottom - top)}};
+}
+
+auto buffer_damage_of(
+    mf::WlSurfaceState const& state,
+    int scale,
+    uint32_t transform,
+    geom::Size buffer_size) -> geom::Rectangles
+{
+    geom::Rectangle const buffer_rect{{}, buffer_size};
+
+    // We don't map surface damage through a buffer transform, so damage everything rather than the wrong part
+    if (transform != mw::Output::Transform::normal)
+        return geom::Rectangles{buffer_rect};
+
+    geom::Rectangles damage;
+
+    auto const add_clipped = [&](geom::Rectangle const& rect)
+        {
+            auto const clipped = intersection_of(rect, buffer_rect);
+            if (clipped.size != geom::Size{})
+                damage.add(clipped);
+        };
+
+    for (auto const& rect : state.surface_damage)
+    {
+        // Surface coordinates are scaled down from buffer coordinates by the buffer scale
+        add_clipped({{rect.left().as_int() * scale, rect.top().as_int() * scale}, rect.size * scale});
+    }
+
+    for (auto const& rect : state.buffer_damage)
+    {
+        add_clipped(rect);
+    }
+
+    return damage;
+}
+}
+
 mf::WlSurfaceState::Callback::Callback(wl_resource* new_resource)
     : mw::Callback{new_resource, Version<1>()}
 {
@@ -61,16 +122,30 @@ void mf::WlSurfaceState::update_from(WlSurfaceState const& source)
     if (source.scale)
         scale = source.scale;
 
+    if (source.transform)
+        transform = source.transform;
+
     if (source.offset)
         offset = source.offset;
 
     if (source.input_shape)
         input_shape = source.input_shape;
 
+    if (source.opaque_region)
+        opaque_region = source.opaque_region;
+
     frame_callbacks.insert(end(frame_callbacks),
                            begin(source.frame_callbacks),
                            end(source.frame_callbacks));
 
+    presentation_feedback.insert(
+        end(presentation_feedback),
+        begin(source.presentation_feedback),
+        end(source.presentation_feedback));
+
+    surface_damage.insert(end(surface_damage), begin(source.surface_damage), end(source.surface_damage));
+    buffer_damage.insert(end(buffer_damage), begin(source.buffer_damage), end(source.buffer_damage));
+
     if (source.surface_data_invalidated)
         surface_data_invalidated = true;
 }
@@ -79,13 +154,14 @@ bool mf::WlSurfaceState::surface_data_needs_refresh() const
 {
     return offset ||
            input_shape ||
+           opaque_region ||
            surface_data_invalidated;
 }
 
 mf::WlSurface::WlSurface(
     wl_resource* new_resource,
     std::shared_ptr<Executor> const& wayland_executor,
-    std::shared_ptr<Executor> const& frame_callback_executor,
+    std::shared_ptr<FrameExecutor> const& frame_callback_executor,
     std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator)
     : Surface(new_resource, Version<4>()),
         session{client->client_session()},
@@ -211,7 +287,16 @@ void mf::WlSurface::populate_surface_data(std::vector<shell::StreamSpecification
 {
     geometry::Displacement offset = parent_offset + offset_;
 
-    buffer_streams.push_back(msh::StreamSpecification{stream, offset, {}});
+    geom::Rectangle const local_rect = {geom::Point{}, buffer_size_.value_or(geom::Size{})};
+    std::vector<geom::Rectangle> clipped_opaque_region;
+    for (auto const& rect : opaque_region)
+    {
+        auto const clipped = intersection_of(rect, local_rect);
+        if (clipped.size != geom::Size{})
+            clipped_opaque_region.push_back(clipped);
+    }
+
+    buffer_streams.push_back(msh::StreamSpecification{stream, offset, {}, std::move(clipped_opaque_region)});
     geom::Rectangle surface_rect = {geom::Point{} + offset, buffer_size_.value_or(geom::Size{})};
     if (input_shape)
     {
@@ -263,6 +348,15 @@ void mf::WlSurface::send_frame_callbacks()
     frame_callbacks.clear();
 }
 
+auto mf::WlSurface::on_screen_area() const -> std::optional<geom::Rectangle>
+{
+    if (auto const surface = scene_surface(); surface && surface.value())
+    {
+        return geom::Rectangle{surface.value()->top_left(), surface.value()->window_size()};
+    }
+    return std::nullopt;
+}
+
 void mf::WlSurface::attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y)
 {
     if (x != 0 || y != 0)
@@ -275,20 +369,18 @@ void mf::WlSurface::attach(std::optional<wl_resource*> const& buffer, int32_t x,
 
 void mf::WlSurface::damage(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    if (auto const rect = clamped_damage(x, y, width, height))
+    {
+        pending.surface_damage.push_back(rect.value());
+    }
 }
 
 void mf::WlSurface::damage_buffer(int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    (void)x;
-    (void)y;
-    (void)width;
-    (void)height;
-    // This isn't essential, but could enable optimizations
+    if (auto const rect = clamped_damage(x, y, width, height))
+    {
+        pending.buffer_damage.push_back(rect.value());
+    }
 }
 
 void mf::WlSurface::frame(wl_resource* new_callback)
@@ -297,10 +389,21 @@ void mf::WlSurface::frame(wl_resource* new_callback)
     pending.frame_callbacks.push_back(wayland::make_weak(callback));
 }
 
+void mf::WlSurface::add_presentation_feedback(PresentationFeedback* feedback)
+{
+    pending.presentation_feedback.push_back(wayland::make_weak(feedback));
+}
+
 void mf::WlSurface::set_opaque_region(std::optional<wl_resource*> const& region)
 {
-    (void)region;
-    // This isn't essential, but could enable optimizations
+    if (region)
+    {
+        pending.opaque_region = WlRegion::from(region.value())->rectangle_vector();
+    }
+    else
+    {
+        pending.opaque_region = std::vector<geom::Rectangle>{};
+    }
 }
 
 void mf::WlSurface::set_input_region(std::optional<wl_resource*> const& region)
@@ -331,8 +434,17 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     if (state.input_shape)
         input_shape = state.input_shape.value();
 
+    if (state.opaque_region)
+        opaque_region = state.opaque_region.value();
+
     if (state.scale)
+    {
+        buffer_scale = state.scale.value();
         stream->set_scale(state.scale.value());
+    }
+
+    if (state.transform)
+        buffer_transform = state.transform.value();
 
     auto const executor_send_frame_callbacks = [executor = wayland_executor, weak_self = mw::make_weak(this)]()
         {
@@ -345,6 +457,30 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                 });
         };
 
+    // Dropping this without it being presented (say the buffer is replaced before it is composited) discards it
+    auto const feedback = state.presentation_feedback.empty() ?
+        nullptr :
+        std::make_shared<CommitFeedback>(wayland_executor, state.presentation_feedback);
+
+    // Frame callbacks are sent once whatever this commit changes has been presented
+    auto const send_frame_callbacks_when_presented =
+        [frame_executor = frame_callback_executor,
+         area = on_screen_area(),
+         executor_send_frame_callbacks,
+         feedback]()
+        {
+            frame_executor->spawn(
+                [executor_send_frame_callbacks, feedback](auto const& presentation)
+                {
+                    executor_send_frame_callbacks();
+                    if (feedback)
+                    {
+                        feedback->presented(presentation);
+                    }
+                },
+                area);
+        };
+
     if (state.buffer)
     {
         mw::Weak<ResourceLifetimeTracker> const& weak_buffer = state.buffer.value();
@@ -368,13 +504,19 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                         });
                 };
             std::shared_ptr<graphics::Buffer> mir_buffer;
+            geom::Rectangles damage;
 
             if (auto const shm_buffer = ShmBuffer::from(weak_buffer.value()))
             {
+                auto shm_data = shm_buffer->data();
+                damage = buffer_damage_of(state, buffer_scale, buffer_transform, shm_data->size());
                 mir_buffer = allocator->buffer_from_shm(
-                    shm_buffer->data(),
-                    std::move(executor_send_frame_callbacks),
+                    std::move(shm_data),
+                    previous_shm_buffer.lock(),
+                    damage,
+                    send_frame_callbacks_when_presented,
                     std::move(release_buffer));
+                previous_shm_buffer = mir_buffer;
                 tracepoint(
                     mir_server_wayland,
                     sw_buffer_committed,
@@ -385,8 +527,10 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
             {
                 mir_buffer = allocator->buffer_from_resource(
                     weak_buffer.value(),
-                    std::move(executor_send_frame_callbacks),
+                    send_frame_callbacks_when_presented,
                     std::move(release_buffer));
+                damage = buffer_damage_of(state, buffer_scale, buffer_transform, mir_buffer->size());
+                previous_shm_buffer.reset();
                 tracepoint(
                     mir_server_wayland,
                     hw_buffer_committed,
@@ -394,7 +538,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
                     mir_buffer->id().as_value());
             }
 
-            stream->submit_buffer(mir_buffer);
+            stream->submit_buffer(mir_buffer, damage);
             auto const new_buffer_size = stream->stream_size();
 
             if (std::make_optional(new_buffer_size) != buffer_size_)
@@ -407,7 +551,7 @@ void mf::WlSurface::commit(WlSurfaceState const& state)
     }
     else
     {
-        frame_callback_executor->spawn(std::move(executor_send_frame_callbacks));
+        send_frame_callbacks_when_presented();
     }
 
     for (WlSubsurface* child: children)
@@ -427,6 +571,9 @@ void mf::WlSurface::commit()
     if (pending.input_shape && *pending.input_shape == input_shape)
         pending.input_shape = std::nullopt;
 
+    if (pending.opaque_region && *pending.opaque_region == opaque_region)
+        pending.opaque_region = std::nullopt;
+
     // order is important
     auto const state = std::move(pending);
     pending = WlSurfaceState();
@@ -447,8 +594,8 @@ void mf::WlSurface::commit()
 
 void mf::WlSurface::set_buffer_transform(int32_t transform)
 {
-    (void)transform;
-    // TODO
+    // TODO: apply the transform when drawing; for now it is only used to keep damage conservative
+    pending.transform = transform;
 }
 
 void mf::WlSurface::set_buffer_scale(int32_t scale)
@@ -37,6 +37,7 @@ class Executor;
 namespace graphics
 {
 class GraphicBufferAllocator;
+class Buffer;
 }
 namespace scene
 {
@@ -52,6 +53,8 @@ class BufferStream;
 }
 namespace frontend
 {
+class FrameExecutor;
+class PresentationFeedback;
 class WlSurface;
 class WlSubsurface;
 class ResourceLifetimeTracker;
@@ -77,9 +80,14 @@ struct WlSurfaceState
     std::optional<wayland::Weak<ResourceLifetimeTracker>> buffer;
 
     std::optional<int> scale;
+    std::optional<uint32_t> transform; ///< A wl_output.transform
     std::optional<geometry::Displacement> offset;
     std::optional<std::optional<std::vector<geometry::Rectangle>>> input_shape;
+    std::optional<std::vector<geometry::Rectangle>> opaque_region; ///< Empty means nothing is opaque
     std::vector<wayland::Weak<Callback>> frame_callbacks;
+    std::vector<wayland::Weak<PresentationFeedback>> presentation_feedback;
+    std::vector<geometry::Rectangle> surface_damage; ///< In surface-local coordinates
+    std::vector<geometry::Rectangle> buffer_damage;  ///< In buffer coordinates
 
 private:
     // only set to true if invalidate_surface_data() is called
@@ -107,7 +115,7 @@ class WlSurface : public wayland::Surface
 public:
     WlSurface(wl_resource* new_resource,
               std::shared_ptr<mir::Executor> const& wayland_executor,
-              std::shared_ptr<mir::Executor> const& frame_callback_executor,
+              std::shared_ptr<FrameExecutor> const& frame_callback_executor,
               std::shared_ptr<graphics::GraphicBufferAllocator> const& allocator);
 
     ~WlSurface();
@@ -136,6 +144,8 @@ public:
                                std::vector<mir::geometry::Rectangle>& input_shape_accumulator,
                                geometry::Displacement const& parent_offset) const;
     void commit(WlSurfaceState const& state);
+    /// Feedback is sent for the next commit's content
+    void add_presentation_feedback(PresentationFeedback* feedback);
     auto confine_pointer_state() const -> MirPointerConfinementState;
 
     std::shared_ptr<scene::Session> const session;
@@ -146,7 +156,7 @@ public:
 private:
     std::shared_ptr<mir::graphics::GraphicBufferAllocator> const allocator;
     std::shared_ptr<mir::Executor> const wayland_executor;
-    std::shared_ptr<mir::Executor> const frame_callback_executor;
+    std::shared_ptr<FrameExecutor> const frame_callback_executor;
 
     NullWlSurfaceRole null_role;
     WlSurfaceRole* role;
@@ -155,11 +165,18 @@ private:
     WlSurfaceState pending;
     geometry::Displacement offset_;
     std::optional<geometry::Size> buffer_size_;
+    /// The last buffer made from client SHM, so the next can reuse its resources
+    std::weak_ptr<graphics::Buffer> previous_shm_buffer;
+    int buffer_scale{1};
+    uint32_t buffer_transform{wayland::Output::Transform::normal};
     std::vector<wayland::Weak<WlSurfaceState::Callback>> frame_callbacks;
     std::optional<std::vector<mir::geometry::Rectangle>> input_shape;
+    std::vector<mir::geometry::Rectangle> opaque_region;
     std::vector<SceneSurfaceCreatedCallback> scene_surface_created_callbacks;
 
     void send_frame_callbacks();
+    /// Where the scene surface this is part of is on screen, if there is one yet
+    auto on_screen_area() const -> std::optional<geometry::Rectangle>;
 
     void attach(std::optional<wl_resource*> const& buffer, int32_t x, int32_t y) override;
     void damage(int32_t x, int32_t y, int32_t width, int32_t height) override;
@@ -20,6 +20,7 @@
 #include "mir/graphics/graphic_buffer_allocator.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/graphics/buffer.h"
+#include "mir/graphics/dmabuf_buffer.h"
 #include "mir/scene/scene_change_notification.h"
 #include "mir/frontend/surface_stack.h"
 #include "mir/geometry/rectangles.h"
@@ -32,8 +33,11 @@
 #include "shm.h"
 
 #include <boost/throw_exception.hpp>
+#include <drm_fourcc.h>
+#include <algorithm>
 #include <mutex>
 #include <optional>
+#include <vector>
 
 namespace mf = mir::frontend;
 namespace mw = mir::wayland;
@@ -57,6 +61,22 @@ auto translate_and_scale(
     rect.top_left.y = output_space.top_left.y + displacement.dy * y_scale;
     return rect;
 }
+
+auto bounding_rectangle_of(geom::Rectangle const& a, geom::Rectangle const& b) -> geom::Rectangle
+{
+    if (a.size == geom::Size{})
+    {
+        return b;
+    }
+    if (b.size == geom::Size{})
+    {
+        return a;
+    }
+    return geom::Rectangles{a, b}.bounding_rectangle();
+}
+
+/// More wl_shm buffers than a client would cycle through for one capture area
+auto const max_tracked_buffers = 16u;
 }
 
 class mf::WlrScreencopyV1DamageTracker::Area
@@ -120,6 +140,23 @@ public:
 
     void capture_on_damage(WlrScreencopyV1DamageTracker::Frame* frame);
 
+    /**
+     * The damage to capture into buffer, which has buffer_space_damage since the client's last frame
+     *
+     * \returns The output space area that has changed since buffer last received a capture with the same
+     *          params, or nullopt if it needs a full capture
+     */
+    auto damage_since_last_capture_into(
+        ShmBuffer& buffer,
+        WlrScreencopyV1DamageTracker::FrameParams const& params,
+        geom::Rectangle const& buffer_space_damage) -> std::optional<geom::Rectangle>;
+
+    /// Notes that buffer is getting a full capture with params, so will be up to date once it's done
+    void full_capture_into(ShmBuffer& buffer, WlrScreencopyV1DamageTracker::FrameParams const& params);
+
+    /// Ensures the next capture into buffer is a full one (as we don't know what the last left in it)
+    void forget_buffer(ShmBuffer& buffer);
+
 private:
     /// From wayland::WlrScreencopyManagerV1
     /// @{
@@ -134,6 +171,16 @@ private:
 
     std::shared_ptr<WlrScreencopyV1Ctx> const ctx;
     WlrScreencopyV1DamageTracker damage_tracker;
+
+    struct BufferHistory
+    {
+        WlrScreencopyV1DamageTracker::FrameParams params;
+        wayland::Weak<ShmBuffer> buffer;
+        /// What has changed (in buffer space) since buffer received a capture
+        geom::Rectangle stale;
+    };
+    /// The wl_shm buffers this client has had frames captured into, oldest first
+    std::vector<BufferHistory> buffer_history;
 };
 
 class WlrScreencopyFrameV1
@@ -156,6 +203,7 @@ public:
 
 private:
     void prepare_target(wl_resource* buffer);
+    void prepare_dma_buf_target(wl_resource* buffer);
     void report_result(std::optional<time::Timestamp> captured_time, geom::Rectangle buffer_space_damage);
 
     /// From wayland::WlrScreencopyFrameV1
@@ -174,6 +222,10 @@ private:
     bool copy_has_been_called{false};
     bool should_send_damage{false};
     std::shared_ptr<renderer::software::WriteMappableBuffer> target;
+    /// The wl_shm buffer behind target, if that's what the client gave us
+    wayland::Weak<ShmBuffer> shm_target;
+    /// Set instead of target if the client gave us a dma-buf
+    std::shared_ptr<graphics::DMABufBuffer> dma_buf_target;
     /// @}
 };
 }
@@ -370,6 +422,75 @@ void mf::WlrScreencopyManagerV1::capture_on_damage(WlrScreencopyV1DamageTracker:
     damage_tracker.capture_on_damage(frame);
 }
 
+auto mf::WlrScreencopyManagerV1::damage_since_last_capture_into(
+    ShmBuffer& buffer,
+    WlrScreencopyV1DamageTracker::FrameParams const& params,
+    geom::Rectangle const& buffer_space_damage) -> std::optional<geom::Rectangle>
+{
+    std::erase_if(buffer_history, [](auto const& entry) { return !entry.buffer; });
+
+    // Each of the client's other buffers for these params is now missing this damage as well
+    for (auto& entry : buffer_history)
+    {
+        if (entry.params == params)
+        {
+            entry.stale = bounding_rectangle_of(entry.stale, buffer_space_damage);
+        }
+    }
+
+    auto const entry = std::find_if(
+        begin(buffer_history),
+        end(buffer_history),
+        [&](auto const& entry) { return entry.buffer.is(buffer) && entry.params == params; });
+
+    if (entry == end(buffer_history))
+    {
+        full_capture_into(buffer, params);
+        return std::nullopt;
+    }
+
+    auto const stale = std::exchange(entry->stale, {});
+
+    // The renderer can only limit itself to damage when it draws the area 1:1
+    if (params.buffer_size != params.output_space_area.size)
+    {
+        return std::nullopt;
+    }
+
+    return geom::Rectangle{params.output_space_area.top_left + as_displacement(stale.top_left), stale.size};
+}
+
+void mf::WlrScreencopyManagerV1::full_capture_into(
+    ShmBuffer& buffer,
+    WlrScreencopyV1DamageTracker::FrameParams const& params)
+{
+    std::erase_if(buffer_history, [](auto const& entry) { return !entry.buffer; });
+
+    auto const entry = std::find_if(
+        begin(buffer_history),
+        end(buffer_history),
+        [&](auto const& entry) { return entry.buffer.is(buffer) && entry.params == params; });
+
+    if (entry != end(buffer_history))
+    {
+        entry->stale = {};
+        return;
+    }
+
+    // A buffer used for other params holds the wrong area
+    forget_buffer(buffer);
+    if (buffer_history.size() >= max_tracked_buffers)
+    {
+        buffer_history.erase(begin(buffer_history));
+    }
+    buffer_history.push_back({params, mw::make_weak(&buffer), {}});
+}
+
+void mf::WlrScreencopyManagerV1::forget_buffer(ShmBuffer& buffer)
+{
+    std::erase_if(buffer_history, [&](auto const& entry) { return entry.buffer.is(buffer); });
+}
+
 void mf::WlrScreencopyManagerV1::capture_output(
     wl_resource* frame,
     int32_t overlay_cursor,
@@ -414,20 +535,27 @@ mf::WlrScreencopyFrameV1::WlrScreencopyFrameV1(
         params.buffer_size.width.as_uint32_t(),
         params.buffer_size.height.as_uint32_t(),
         stride.as_uint32_t());
+    if (ctx->screen_shooter->supports_dma_buf_targets())
+    {
+        send_linux_dmabuf_event_if_supported(
+            DRM_FORMAT_ARGB8888,
+            params.buffer_size.width.as_uint32_t(),
+            params.buffer_size.height.as_uint32_t());
+    }
     send_buffer_done_event_if_supported();
 }
 
 void mf::WlrScreencopyFrameV1::capture(geom::Rectangle buffer_space_damage)
 {
-    if (!target)
+    if (!target && !dma_buf_target)
     {
         fatal_error(
             "WlrScreencopyFrameV1::capture() called without a target, copy %s been called",
             copy_has_been_called ? "has" : "has not");
     }
-    ctx->screen_shooter->capture(std::move(target), params.output_space_area,
-        [wayland_executor=ctx->wayland_executor, buffer_space_damage, self=mw::make_weak(this)]
-            (std::optional<time::Timestamp> captured_time)
+
+    auto callback = [wayland_executor=ctx->wayland_executor, buffer_space_damage, self=mw::make_weak(this)]
+        (std::optional<time::Timestamp> captured_time)
         {
             wayland_executor->spawn([self, captured_time, buffer_space_damage]()
                 {
@@ -436,7 +564,37 @@ void mf::WlrScreencopyFrameV1::capture(geom::Rectangle buffer_space_damage)
                         self.value().report_result(captured_time, buffer_space_damage);
                     }
                 });
-        });
+        };
+
+    if (dma_buf_target)
+    {
+        // Rendered straight into the client's buffer, without a copy through the CPU
+        ctx->screen_shooter->capture(std::move(dma_buf_target), params.output_space_area, std::move(callback));
+        return;
+    }
+
+    std::optional<geom::Rectangle> damage;
+    if (shm_target && manager)
+    {
+        if (should_send_damage)
+        {
+            damage = manager.value().damage_since_last_capture_into(shm_target.value(), params, buffer_space_damage);
+        }
+        else
+        {
+            // A client may copy into a buffer it also uses with copy_with_damage
+            manager.value().full_capture_into(shm_target.value(), params);
+        }
+    }
+
+    if (damage)
+    {
+        ctx->screen_shooter->capture(std::move(target), params.output_space_area, *damage, std::move(callback));
+    }
+    else
+    {
+        ctx->screen_shooter->capture(std::move(target), params.output_space_area, std::move(callback));
+    }
 }
 
 void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
@@ -452,10 +610,8 @@ void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
     auto shm_buffer = mf::ShmBuffer::from(buffer);
     if (!shm_buffer)
     {
-        BOOST_THROW_EXCEPTION(mw::ProtocolError(
-            resource,
-            Error::invalid_buffer,
-            "Copy target is not a wl_shm buffer"));
+        prepare_dma_buf_target(buffer);
+        return;
     }
     auto shm_data = shm_buffer->data();
     if (shm_data->format() != mir_pixel_format_argb_8888)
@@ -487,6 +643,7 @@ void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
             stride.as_int()));
     }
 
+    shm_target = mw::make_weak(shm_buffer);
     target = std::shared_ptr<mir::renderer::software::WriteMappableBuffer>{
         shm_data.get(),
         [shm_data, weak_buffer = mw::make_weak(shm_buffer), executor = ctx->wayland_executor](auto*)
@@ -504,6 +661,48 @@ void mf::WlrScreencopyFrameV1::prepare_target(wl_resource* buffer)
     };
 }
 
+void mf::WlrScreencopyFrameV1::prepare_dma_buf_target(wl_resource* buffer)
+{
+    if (!ctx->screen_shooter->supports_dma_buf_targets())
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::invalid_buffer,
+            "Copy target is not a wl_shm buffer"));
+    }
+
+    auto const imported = ctx->allocator->buffer_from_resource(buffer, []{}, []{});
+    auto dma_buf = std::dynamic_pointer_cast<mg::DMABufBuffer>(imported);
+    if (!dma_buf)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::invalid_buffer,
+            "Copy target is neither a wl_shm buffer nor a dma-buf"));
+    }
+    if (dma_buf->format() != DRM_FORMAT_ARGB8888)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::invalid_buffer,
+            "Invalid dma-buf format %s",
+            dma_buf->format().name()));
+    }
+    if (dma_buf->size() != params.buffer_size)
+    {
+        BOOST_THROW_EXCEPTION(mw::ProtocolError(
+            resource,
+            Error::invalid_buffer,
+            "Invalid buffer size %dx%d, should be %dx%d",
+            dma_buf->size().width.as_int(),
+            dma_buf->size().height.as_int(),
+            params.buffer_size.width.as_int(),
+            params.buffer_size.height.as_int()));
+    }
+
+    dma_buf_target = std::move(dma_buf);
+}
+
 void mf::WlrScreencopyFrameV1::report_result(
     std::optional<time::Timestamp> captured_time,
     geom::Rectangle buffer_space_damage)
@@ -529,6 +728,10 @@ void mf::WlrScreencopyFrameV1::report_result(
     }
     else
     {
+        if (shm_target && manager)
+        {
+            manager.value().forget_buffer(shm_target.value());
+        }
         send_failed_event();
     }
 }
@@ -0,0 +1,157 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "work_queue.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace mf = mir::frontend;
+
+/*
+ * The ring is Dmitry Vyukov's bounded queue: each slot's sequence says which position
+ * (enqueue_pos) may next write to it, and then which position (dequeue_pos) may read it.
+ *
+ * A slot at position pos is free for a producer when sequence == pos, and becomes ready
+ * for the consumer when the producer sets sequence = pos + 1. Once the consumer has
+ * taken the work it frees the slot for the next turn of the ring with
+ * sequence = pos + capacity.
+ */
+
+mf::WorkQueue::WorkQueue(size_t capacity)
+    : mask{std::bit_ceil(std::max<size_t>(capacity, 2)) - 1},
+      slots{std::make_unique<Slot[]>(mask + 1)}
+{
+    for (size_t i = 0; i <= mask; ++i)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+mf::WorkQueue::~WorkQueue() = default;
+
+auto mf::WorkQueue::push(std::function<void()>&& work) -> bool
+{
+    if (overflowing.load(std::memory_order_acquire) || !try_push_to_ring(work))
+    {
+        std::lock_guard lock{overflow_mutex};
+        // The consumer may have caught up while we were waiting for the lock
+        if (overflowing.load(std::memory_order_relaxed) || !try_push_to_ring(work))
+        {
+            overflow.push_back(std::move(work));
+            overflowing.store(true, std::memory_order_release);
+        }
+    }
+
+    return !wake_pending.exchange(true);
+}
+
+void mf::WorkQueue::prepare_to_drain()
+{
+    wake_pending.store(false);
+}
+
+auto mf::WorkQueue::pop() -> std::function<void()>
+{
+    if (auto work = try_pop_from_ring())
+    {
+        return work;
+    }
+
+    if (overflowing.load(std::memory_order_acquire))
+    {
+        std::lock_guard lock{overflow_mutex};
+
+        /* Work is only pushed to the ring while we're not overflowing, so the ring holds
+         * work pushed before the overflow (or racing with its start), and that must be
+         * taken first. This includes work that producers have yet to finish pushing;
+         * they will ask for us to be woken again once it's there.
+         */
+        if (auto work = try_pop_from_ring())
+        {
+            return work;
+        }
+        if (enqueue_pos.load(std::memory_order_acquire) != dequeue_pos)
+        {
+            return {};
+        }
+
+        if (!overflow.empty())
+        {
+            auto work = std::move(overflow.front());
+            overflow.pop_front();
+            return work;
+        }
+        overflowing.store(false, std::memory_order_release);
+    }
+
+    return {};
+}
+
+void mf::WorkQueue::clear()
+{
+    while (pop())
+    {
+    }
+}
+
+auto mf::WorkQueue::try_push_to_ring(std::function<void()>& work) -> bool
+{
+    auto pos = enqueue_pos.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        auto& slot = slots[pos & mask];
+        auto const sequence = slot.sequence.load(std::memory_order_acquire);
+        auto const lag = static_cast<ptrdiff_t>(sequence - pos);
+
+        if (lag == 0)
+        {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                slot.work = std::move(work);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+            // compare_exchange_weak() has updated pos; try again
+        }
+        else if (lag < 0)
+        {
+            // The consumer has yet to take the work from this slot's last turn: the ring is full
+            return false;
+        }
+        else
+        {
+            // Another producer has taken this slot
+            pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+auto mf::WorkQueue::try_pop_from_ring() -> std::function<void()>
+{
+    auto& slot = slots[dequeue_pos & mask];
+    if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos + 1)
+    {
+        // Either empty, or a producer has claimed the slot but not yet filled it
+        return {};
+    }
+
+    auto work = std::move(slot.work);
+    slot.work = nullptr;
+    slot.sequence.store(dequeue_pos + mask + 1, std::memory_order_release);
+    ++dequeue_pos;
+    return work;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_FRONTEND_WORK_QUEUE_H
+#define MIR_FRONTEND_WORK_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace mir
+{
+namespace frontend
+{
+/**
+ * A queue of work from any number of threads, to be run by a single consumer thread
+ *
+ * Work goes into a fixed ring of slots with a compare-and-swap, so push() neither takes
+ * a lock nor allocates. Only if the consumer falls so far behind that the ring fills up
+ * does work spill over into a mutex-protected list (and, until the consumer catches up,
+ * later work spills over too, so that work is still consumed in the order pushed).
+ *
+ * The queue also tracks whether the consumer needs waking, so that producers pushing
+ * work while the consumer has yet to drain the queue don't need to wake it again.
+ */
+class WorkQueue
+{
+public:
+    /// \param capacity  The number of slots in the ring, rounded up to a power of two
+    explicit WorkQueue(size_t capacity = 1024);
+    ~WorkQueue();
+
+    WorkQueue(WorkQueue const&) = delete;
+    WorkQueue& operator=(WorkQueue const&) = delete;
+
+    /**
+     * Add work to the back of the queue. May be called from any thread.
+     *
+     * \return  true if this is the first work pushed since the consumer last called
+     *          prepare_to_drain(), and so the consumer needs waking
+     */
+    auto push(std::function<void()>&& work) -> bool;
+
+    /**
+     * Called by the consumer before it starts to pop() work.
+     *
+     * Any push() from this point on will ask for the consumer to be woken again, so
+     * nothing pushed after the consumer finds the queue empty can be missed.
+     */
+    void prepare_to_drain();
+
+    /// Take the work from the front of the queue; empty if there is none. Consumer only.
+    auto pop() -> std::function<void()>;
+
+    /// Drop all the work in the queue. Consumer only.
+    void clear();
+
+private:
+    struct Slot
+    {
+        /// Which turn of the ring this slot is ready for, see push() and pop()
+        std::atomic<size_t> sequence;
+        std::function<void()> work;
+    };
+
+    auto try_push_to_ring(std::function<void()>& work) -> bool;
+    auto try_pop_from_ring() -> std::function<void()>;
+
+    size_t const mask;
+    std::unique_ptr<Slot[]> const slots;
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) size_t dequeue_pos{0};                  ///< Only touched by the consumer
+    alignas(64) std::atomic<bool> wake_pending{false};
+
+    std::atomic<bool> overflowing{false};
+    std::mutex overflow_mutex;
+    std::deque<std::function<void()>> overflow;
+};
+}
+}
+
+#endif //MIR_FRONTEND_WORK_QUEUE_H
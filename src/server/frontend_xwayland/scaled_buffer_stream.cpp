@@ -30,6 +30,14 @@ void mf::ScaledBufferStream::submit_buffer(std::shared_ptr<graphics::Buffer> con
     inner->submit_buffer(buffer);
 }
 
+void mf::ScaledBufferStream::submit_buffer(
+    std::shared_ptr<graphics::Buffer> const& buffer,
+    geometry::Rectangles const& damage)
+{
+    // Damage is in buffer coordinates, so is unaffected by our scale
+    inner->submit_buffer(buffer, damage);
+}
+
 void mf::ScaledBufferStream::set_frame_posted_callback(std::function<void(geometry::Size const&)> const& callback)
 {
     // Does this need to be scaled? I don't ? think ? so? compositor::Stream seems to leave it unscaled.
@@ -62,6 +70,11 @@ auto mf::ScaledBufferStream::lock_compositor_buffer(void const* user_id) -> std:
     return inner->lock_compositor_buffer(user_id);
 }
 
+auto mf::ScaledBufferStream::damage_for(void const* user_id) const -> geometry::Rectangles
+{
+    return inner->damage_for(user_id);
+}
+
 auto mf::ScaledBufferStream::stream_size() -> geometry::Size
 {
     // This is it. This is what the whole class is for.
@@ -357,7 +357,8 @@ auto mir::DefaultServerConfiguration::the_rendering_platforms() ->
                         device,
                         display_targets,
                         *the_options(),
-                        *the_emergency_cleanup());
+                        *the_emergency_cleanup(),
+                        the_display_report());
                 // Add this module to the list searched by the input stack later
                 // TODO: Come up with a more principled solution for combined input/rendering/output platforms
                 platform_libraries.push_back(platform);
@@ -100,6 +100,16 @@ public:
         return true;
     }
 
+    geom::Rectangles damage() const override
+    {
+        return {screen_position()};
+    }
+
+    geom::Rectangles opaque_region() const override
+    {
+        return {};
+    }
+
     void move_to(geom::Point new_position)
     {
         std::lock_guard lock{position_mutex};
@@ -194,15 +204,18 @@ void mg::SoftwareCursor::hide()
 
 void mg::SoftwareCursor::move_to(geometry::Point position)
 {
+    geom::Rectangles damage;
     {
         std::lock_guard lg{guard};
 
         if (!renderable)
             return;
 
+        damage.add(renderable->screen_position());
         renderable->move_to(position - hotspot);
+        damage.add(renderable->screen_position());
     }
 
     // This doesn't need to be called in a specific order with other potential calls, so it doesn't go on the executor
-    scene->emit_scene_changed();
+    scene->emit_scene_damage(damage.bounding_rectangle());
 }
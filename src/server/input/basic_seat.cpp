@@ -17,6 +17,7 @@
 #include "basic_seat.h"
 #include "mir/input/device.h"
 #include "mir/input/input_sink.h"
+#include "mir/input/input_report.h"
 #include "mir/graphics/display_configuration_observer.h"
 #include "mir/graphics/display_configuration.h"
 #include "mir/geometry/rectangle.h"
@@ -171,14 +172,16 @@ mi::BasicSeat::BasicSeat(std::shared_ptr<mi::InputDispatcher> const& dispatcher,
                          std::shared_ptr<Registrar> const& registrar,
                          std::shared_ptr<mi::KeyMapper> const& key_mapper,
                          std::shared_ptr<time::Clock> const& clock,
-                         std::shared_ptr<mi::SeatObserver> const& observer) :
+                         std::shared_ptr<mi::SeatObserver> const& observer,
+                         std::shared_ptr<mi::InputReport> const& report) :
       input_state_tracker{dispatcher,
                           touch_visualizer,
                           cursor_listener,
                           key_mapper,
                           clock,
                           observer},
-      output_tracker{std::make_shared<OutputTracker>(input_state_tracker)}
+      output_tracker{std::make_shared<OutputTracker>(input_state_tracker)},
+      report{report}
 {
     registrar->register_interest(output_tracker);
 }
@@ -199,6 +202,10 @@ void mi::BasicSeat::remove_device(input::Device const& device)
 
 void mi::BasicSeat::dispatch_event(std::shared_ptr<MirEvent> const& event)
 {
+    if (mir_event_get_type(event.get()) == mir_event_type_input)
+    {
+        report->dispatched_event_from_seat(mir_input_event_get_event_time(mir_event_get_input_event(event.get())));
+    }
     input_state_tracker.dispatch(event);
 }
 
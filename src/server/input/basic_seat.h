@@ -41,6 +41,7 @@ class CursorListener;
 class InputDispatcher;
 class KeyMapper;
 class SeatObserver;
+class InputReport;
 
 class BasicSeat : public Seat
 {
@@ -52,7 +53,8 @@ public:
               std::shared_ptr<Registrar> const& registrar,
               std::shared_ptr<KeyMapper> const& key_mapper,
               std::shared_ptr<time::Clock> const& clock,
-              std::shared_ptr<SeatObserver> const& observer);
+              std::shared_ptr<SeatObserver> const& observer,
+              std::shared_ptr<InputReport> const& report);
     // Seat methods:
     void add_device(Device const& device) override;
     void remove_device(Device const& device) override;
@@ -71,6 +73,7 @@ private:
     SeatInputDeviceTracker input_state_tracker;
     struct OutputTracker;
     std::shared_ptr<OutputTracker> const output_tracker;
+    std::shared_ptr<InputReport> const report;
 };
 }
 }
@@ -37,6 +37,7 @@
 #include "mir/input/input_probe.h"
 #include "mir/input/platform.h"
 #include "mir/input/xkb_mapper.h"
+#include "mir/input/keymap_cache.h"
 #include "mir/input/vt_filter.h"
 #include "mir/options/configuration.h"
 #include "mir/options/option.h"
@@ -127,7 +128,7 @@ mir::DefaultServerConfiguration::the_surface_input_dispatcher()
     return surface_input_dispatcher(
         [this]()
         {
-            return std::make_shared<mi::SurfaceInputDispatcher>(the_input_scene());
+            return std::make_shared<mi::SurfaceInputDispatcher>(the_input_scene(), the_input_report());
         });
 }
 
@@ -253,7 +254,24 @@ mir::DefaultServerConfiguration::the_input_manager()
                     the_platform_libaries(),
                     *the_shared_library_prober_report());
 
-                return std::make_shared<mi::DefaultInputManager>(the_input_reading_multiplexer(), std::move(platform));
+                auto priority = [&]
+                    {
+                        try
+                        {
+                            return mi::InputThreadPriority::parse(
+                                options->get<std::string>(options::input_thread_priority_opt));
+                        }
+                        catch (std::invalid_argument const& error)
+                        {
+                            throw mir::AbnormalExit{
+                                std::string{"Invalid "} + options::input_thread_priority_opt + ": " + error.what()};
+                        }
+                    }();
+
+                return std::make_shared<mi::DefaultInputManager>(
+                    the_input_reading_multiplexer(),
+                    std::move(platform),
+                    priority);
             }
         }
     );
@@ -282,7 +300,8 @@ std::shared_ptr<mi::Seat> mir::DefaultServerConfiguration::the_seat()
                     the_display_configuration_observer_registrar(),
                     the_key_mapper(),
                     the_clock(),
-                    the_seat_observer());
+                    the_seat_observer(),
+                    the_input_report());
         });
 }
 
@@ -327,12 +346,25 @@ std::shared_ptr<mi::DefaultInputDeviceHub> mir::DefaultServerConfiguration::the_
 std::shared_ptr<mi::KeyMapper> mir::DefaultServerConfiguration::the_key_mapper()
 {
     return key_mapper(
-       []()
+       [this]()
        {
-           return std::make_shared<mi::receiver::XKBMapper>();
+           return std::make_shared<mi::receiver::XKBMapper>(the_keymap_cache());
        });
 }
 
+std::shared_ptr<mi::KeymapCache> mir::DefaultServerConfiguration::the_keymap_cache()
+{
+    return keymap_cache(
+        [this]()
+        {
+            return std::make_shared<mi::KeymapCache>(
+                [seat_observer = the_seat_observer()](uint64_t compilations, uint64_t shm_bytes)
+                {
+                    seat_observer->seat_keymap_cache_updated(compilations, shm_bytes);
+                });
+        });
+}
+
 std::shared_ptr<mi::SeatObserver> mir::DefaultServerConfiguration::the_seat_observer()
 {
     return seat_observer_multiplexer(
@@ -18,13 +18,21 @@
 #include "mir/time/clock.h"
 #include "mir/input/seat.h"
 #include "mir/events/event_builders.h"
-#include "mir/cookie/authority.h"
+#include "mir/events/input_event.h"
 
 #include <algorithm>
 
 namespace me = mir::events;
 namespace mi = mir::input;
 
+namespace
+{
+bool is_button_action(MirPointerAction action)
+{
+    return action == mir_pointer_action_button_up || action == mir_pointer_action_button_down;
+}
+}
+
 mi::DefaultEventBuilder::DefaultEventBuilder(
     MirInputDeviceId device_id,
     std::shared_ptr<time::Clock> const& clock,
@@ -42,9 +50,11 @@ mir::EventUPtr mi::DefaultEventBuilder::key_event(
     int scan_code)
 {
     auto const timestamp = calibrate_timestamp(source_timestamp);
-    auto const cookie = cookie_authority->make_cookie(timestamp.count());
-    return me::make_key_event(
-        device_id, timestamp, cookie->serialize(), action, keysym, scan_code, mir_input_event_modifier_none);
+    auto event = me::make_key_event(
+        device_id, timestamp, {}, action, keysym, scan_code, mir_input_event_modifier_none);
+    // Computing a cookie is costly and few are ever asked for, so they are made on demand
+    event->to_input()->set_cookie_authority(cookie_authority);
+    return event;
 }
 
 mir::EventUPtr mi::DefaultEventBuilder::pointer_event(
@@ -56,17 +66,16 @@ mir::EventUPtr mi::DefaultEventBuilder::pointer_event(
 {
     const float x_axis_value = 0;
     const float y_axis_value = 0;
-    std::vector<uint8_t> vec_cookie{};
     auto const timestamp = calibrate_timestamp(source_timestamp);
-    if (action == mir_pointer_action_button_up || action == mir_pointer_action_button_down)
-    {
-        auto const cookie = cookie_authority->make_cookie(timestamp.count());
-        vec_cookie = cookie->serialize();
-    }
-    return me::make_pointer_event(
-        device_id, timestamp, vec_cookie, mir_input_event_modifier_none, action, buttons_pressed, x_axis_value,
+    auto event = me::make_pointer_event(
+        device_id, timestamp, {}, mir_input_event_modifier_none, action, buttons_pressed, x_axis_value,
         y_axis_value,
         hscroll_value, vscroll_value, relative_x_value, relative_y_value);
+    if (is_button_action(action))
+    {
+        event->to_input()->set_cookie_authority(cookie_authority);
+    }
+    return event;
 }
 
 mir::EventUPtr mi::DefaultEventBuilder::pointer_event(
@@ -77,16 +86,15 @@ mir::EventUPtr mi::DefaultEventBuilder::pointer_event(
     float hscroll_value, float vscroll_value,
     float relative_x_value, float relative_y_value)
 {
-    std::vector<uint8_t> vec_cookie{};
     auto const timestamp = calibrate_timestamp(source_timestamp);
-    if (action == mir_pointer_action_button_up || action == mir_pointer_action_button_down)
+    auto event = me::make_pointer_event(
+        device_id, timestamp, {}, mir_input_event_modifier_none, action, buttons_pressed, x_axis, y_axis,
+        hscroll_value, vscroll_value, relative_x_value, relative_y_value);
+    if (is_button_action(action))
     {
-        auto const cookie = cookie_authority->make_cookie(timestamp.count());
-        vec_cookie = cookie->serialize();
+        event->to_input()->set_cookie_authority(cookie_authority);
     }
-    return me::make_pointer_event(
-        device_id, timestamp, vec_cookie, mir_input_event_modifier_none, action, buttons_pressed, x_axis, y_axis,
-        hscroll_value, vscroll_value, relative_x_value, relative_y_value);
+    return event;
 }
 
 mir::EventUPtr mi::DefaultEventBuilder::pointer_axis_event(
@@ -98,16 +106,15 @@ mir::EventUPtr mi::DefaultEventBuilder::pointer_axis_event(
     float hscroll_value, float vscroll_value,
     float relative_x_value, float relative_y_value)
 {
-    std::vector<uint8_t> vec_cookie{};
     auto const timestamp = calibrate_timestamp(source_timestamp);
-    if (action == mir_pointer_action_button_up || action == mir_pointer_action_button_down)
+    auto event = me::make_pointer_axis_event(
+        axis_source, device_id, timestamp, {}, mir_input_event_modifier_none, action, buttons_pressed, x_axis,
+        y_axis, hscroll_value, vscroll_value, relative_x_value, relative_y_value);
+    if (is_button_action(action))
     {
-        auto const cookie = cookie_authority->make_cookie(timestamp.count());
-        vec_cookie = cookie->serialize();
+        event->to_input()->set_cookie_authority(cookie_authority);
     }
-    return me::make_pointer_axis_event(
-        axis_source, device_id, timestamp, vec_cookie, mir_input_event_modifier_none, action, buttons_pressed, x_axis,
-        y_axis, hscroll_value, vscroll_value, relative_x_value, relative_y_value);
+    return event;
 }
 
 mir::EventUPtr mi::DefaultEventBuilder::pointer_axis_with_stop_event(
@@ -120,16 +127,15 @@ mir::EventUPtr mi::DefaultEventBuilder::pointer_axis_with_stop_event(
     bool hscroll_stop, bool vscroll_stop,
     float relative_x_value, float relative_y_value)
 {
-    std::vector<uint8_t> vec_cookie{};
     auto const timestamp = calibrate_timestamp(source_timestamp);
-    if (action == mir_pointer_action_button_up || action == mir_pointer_action_button_down)
+    auto event = me::make_pointer_axis_with_stop_event(
+        axis_source, device_id, timestamp, {}, mir_input_event_modifier_none, action, buttons_pressed, x_axis,
+        y_axis, hscroll_value, vscroll_value, hscroll_stop, vscroll_stop, relative_x_value, relative_y_value);
+    if (is_button_action(action))
     {
-        auto const cookie = cookie_authority->make_cookie(timestamp.count());
-        vec_cookie = cookie->serialize();
+        event->to_input()->set_cookie_authority(cookie_authority);
     }
-    return me::make_pointer_axis_with_stop_event(
-        axis_source, device_id, timestamp, vec_cookie, mir_input_event_modifier_none, action, buttons_pressed, x_axis,
-        y_axis, hscroll_value, vscroll_value, hscroll_stop, vscroll_stop, relative_x_value, relative_y_value);
+    return event;
 }
 
 mir::EventUPtr mir::input::DefaultEventBuilder::pointer_axis_discrete_scroll_event(
@@ -137,16 +143,15 @@ mir::EventUPtr mir::input::DefaultEventBuilder::pointer_axis_discrete_scroll_eve
     MirPointerButtons buttons_pressed, float hscroll_value, float vscroll_value, float hscroll_discrete,
     float vscroll_discrete)
 {
-    std::vector<uint8_t> vec_cookie{};
     auto const timestamp = calibrate_timestamp(source_timestamp);
-    if (action == mir_pointer_action_button_up || action == mir_pointer_action_button_down)
+    auto event = me::make_pointer_axis_discrete_scroll_event(
+        axis_source, device_id, timestamp, {}, mir_input_event_modifier_none, action, buttons_pressed,
+        hscroll_value, vscroll_value, hscroll_discrete, vscroll_discrete);
+    if (is_button_action(action))
     {
-        auto const cookie = cookie_authority->make_cookie(timestamp.count());
-        vec_cookie = cookie->serialize();
+        event->to_input()->set_cookie_authority(cookie_authority);
     }
-    return me::make_pointer_axis_discrete_scroll_event(
-        axis_source, device_id, timestamp, vec_cookie, mir_input_event_modifier_none, action, buttons_pressed,
-        hscroll_value, vscroll_value, hscroll_discrete, vscroll_discrete);
+    return event;
 }
 
 mir::EventUPtr mir::input::DefaultEventBuilder::pointer_event(
@@ -159,17 +164,11 @@ mir::EventUPtr mir::input::DefaultEventBuilder::pointer_event(
     events::ScrollAxisV1H h_scroll,
     events::ScrollAxisV1V v_scroll)
 {
-    std::vector<uint8_t> vec_cookie{};
     auto const timestamp = calibrate_timestamp(source_timestamp);
-    if (action == mir_pointer_action_button_up || action == mir_pointer_action_button_down)
-    {
-        auto const cookie = cookie_authority->make_cookie(timestamp.count());
-        vec_cookie = cookie->serialize();
-    }
-    return me::make_pointer_event(
+    auto event = me::make_pointer_event(
         device_id,
         timestamp,
-        vec_cookie,
+        {},
         mir_input_event_modifier_none,
         action,
         buttons,
@@ -178,6 +177,11 @@ mir::EventUPtr mir::input::DefaultEventBuilder::pointer_event(
         axis_source,
         h_scroll,
         v_scroll);
+    if (is_button_action(action))
+    {
+        event->to_input()->set_cookie_authority(cookie_authority);
+    }
+    return event;
 }
 
 mir::EventUPtr mi::DefaultEventBuilder::touch_event(
@@ -193,18 +197,17 @@ mir::EventUPtr mi::DefaultEventBuilder::touch_event(
     std::optional<Timestamp> source_timestamp,
     std::vector<events::TouchContactV2> const& contacts)
 {
-    std::vector<uint8_t> vec_cookie{};
     auto const timestamp = calibrate_timestamp(source_timestamp);
+    auto event = me::make_touch_event(device_id, timestamp, {}, mir_input_event_modifier_none, contacts);
     for (auto const& contact : contacts)
     {
         if (contact.action == mir_touch_action_up || contact.action == mir_touch_action_down)
         {
-            auto const cookie = cookie_authority->make_cookie(timestamp.count());
-            vec_cookie = cookie->serialize();
+            event->to_input()->set_cookie_authority(cookie_authority);
             break;
         }
     }
-    return me::make_touch_event(device_id, timestamp, vec_cookie, mir_input_event_modifier_none, contacts);
+    return event;
 }
 
 auto mi::DefaultEventBuilder::calibrate_timestamp(std::optional<Timestamp> timestamp) -> Timestamp
@@ -24,18 +24,119 @@
 #include "mir/thread_name.h"
 #include "mir/unwind_helpers.h"
 #include "mir/terminate_with_current_exception.h"
+#define MIR_LOG_COMPONENT "Input"
+#include "mir/log.h"
 
 #include <future>
 #include <memory>
+#include <stdexcept>
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <string.h>
 
 namespace mi = mir::input;
 
+namespace
+{
+/// Applies to the calling thread only: the rest of the server keeps its scheduling
+void apply_to_this_thread(mi::InputThreadPriority const& priority)
+{
+    switch (priority.policy)
+    {
+    case mi::InputThreadPriority::Policy::inherited:
+        return;
+
+    case mi::InputThreadPriority::Policy::niced:
+        if (setpriority(PRIO_PROCESS, gettid(), priority.value) != 0)
+        {
+            mir::log_warning("Failed to set input thread nice value to %d: %s", priority.value, strerror(errno));
+        }
+        return;
+
+    case mi::InputThreadPriority::Policy::realtime:
+    {
+        sched_param const param{.sched_priority = priority.value};
+        if (auto const error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param))
+        {
+            mir::log_warning(
+                "Failed to set input thread to SCHED_FIFO priority %d (needs CAP_SYS_NICE or an RLIMIT_RTPRIO): %s",
+                priority.value,
+                strerror(error));
+        }
+        return;
+    }
+    }
+}
+}
+
+auto mi::InputThreadPriority::parse(std::string const& spec) -> InputThreadPriority
+{
+    if (spec == "default")
+    {
+        return {};
+    }
+
+    auto const separator = spec.find(':');
+    auto const name = spec.substr(0, separator);
+    Policy policy;
+    if (name == "nice")
+    {
+        policy = Policy::niced;
+    }
+    else if (name == "realtime")
+    {
+        policy = Policy::realtime;
+    }
+    else
+    {
+        throw std::invalid_argument{"Unknown input thread priority \"" + spec + "\""};
+    }
+
+    if (separator == std::string::npos)
+    {
+        throw std::invalid_argument{"Input thread priority \"" + spec + "\" needs a value"};
+    }
+
+    auto const value_string = spec.substr(separator + 1);
+    std::size_t parsed{0};
+    int value{0};
+    try
+    {
+        value = std::stoi(value_string, &parsed);
+    }
+    catch (std::logic_error const&)
+    {
+    }
+
+    if (value_string.empty() || parsed != value_string.size())
+    {
+        throw std::invalid_argument{"Invalid input thread priority value \"" + value_string + "\""};
+    }
+
+    auto const [min, max] = policy == Policy::niced ?
+        std::pair{-20, 19} :
+        std::pair{sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO)};
+    if (value < min || value > max)
+    {
+        throw std::invalid_argument{
+            "Input thread priority " + std::to_string(value) +
+            " out of range [" + std::to_string(min) + ", " + std::to_string(max) + "]"};
+    }
+
+    return {policy, value};
+}
+
 mi::DefaultInputManager::DefaultInputManager(
     std::shared_ptr<dispatch::MultiplexingDispatchable> const& multiplexer,
-    std::shared_ptr<Platform> const& platform) :
+    std::shared_ptr<Platform> const& platform,
+    InputThreadPriority priority) :
     platform{platform},
     multiplexer{multiplexer},
     queue{std::make_shared<mir::dispatch::ActionQueue>()},
+    priority{priority},
     state{State::stopped}
 {
 }
@@ -80,6 +181,7 @@ void mi::DefaultInputManager::start()
      */
     queue->enqueue([this,promise = std::move(started_promise)]()
                    {
+                        apply_to_this_thread(priority);
                         start_platforms();
                         promise->set_value();
                    });
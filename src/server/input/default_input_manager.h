@@ -21,6 +21,7 @@
 
 #include <atomic>
 #include <memory>
+#include <string>
 #include <thread>
 
 namespace mir
@@ -36,12 +37,30 @@ namespace input
 class Platform;
 class InputDeviceRegistry;
 
+/// How the input reading thread is scheduled
+struct InputThreadPriority
+{
+    enum class Policy
+    {
+        inherited,  ///< As the thread starting input
+        niced,      ///< At the nice value in `value`
+        realtime    ///< SCHED_FIFO at the priority in `value`
+    };
+
+    Policy policy{Policy::inherited};
+    int value{0};
+
+    /// Parses "default", "nice:<value>" or "realtime:<priority>", throws std::invalid_argument otherwise
+    static auto parse(std::string const& spec) -> InputThreadPriority;
+};
+
 class DefaultInputManager : public InputManager
 {
 public:
     DefaultInputManager(
         std::shared_ptr<dispatch::MultiplexingDispatchable> const& multiplexer,
-        std::shared_ptr<Platform> const& platform);
+        std::shared_ptr<Platform> const& platform,
+        InputThreadPriority priority);
     ~DefaultInputManager();
 
     void start() override;
@@ -54,6 +73,7 @@ private:
     std::shared_ptr<Platform> const platform;
     std::shared_ptr<dispatch::MultiplexingDispatchable> const multiplexer;
     std::shared_ptr<dispatch::ActionQueue> const queue;
+    InputThreadPriority const priority;
     std::unique_ptr<dispatch::ThreadedDispatcher> input_thread;
 
     enum class State
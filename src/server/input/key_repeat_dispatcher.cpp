@@ -21,6 +21,7 @@
 #include "mir/time/alarm_factory.h"
 #include "mir/time/alarm.h"
 #include "mir/events/event_builders.h"
+#include "mir/events/input_event.h"
 #include "mir/cookie/authority.h"
 
 #include <xkbcommon/xkbcommon-keysyms.h>
@@ -189,15 +190,15 @@ void mi::KeyRepeatDispatcher::handle_key_input(MirInputDeviceId id, MirKeyboardE
              modifiers = mir_keyboard_event_modifiers(kev)]()
              {
                  auto const now = std::chrono::steady_clock::now().time_since_epoch();
-                 auto const cookie = cookie_authority->make_cookie(now.count());
                  auto new_event = mev::make_key_event(
                      id,
                      now,
-                     cookie->serialize(),
+                     {},
                      mir_keyboard_action_repeat,
                      keysym,
                      scan_code,
                      modifiers);
+                 new_event->to_input()->set_cookie_authority(cookie_authority);
                  next_dispatcher->dispatch(std::move(new_event));
              };
 
@@ -64,6 +64,11 @@ void mi::SeatObserverMultiplexer::seat_reset_confinement_regions()
     for_each_observer(&mi::SeatObserver::seat_reset_confinement_regions);
 }
 
+void mi::SeatObserverMultiplexer::seat_keymap_cache_updated(uint64_t compilations, uint64_t shm_bytes)
+{
+    for_each_observer(&mi::SeatObserver::seat_keymap_cache_updated, compilations, shm_bytes);
+}
+
 mi::SeatObserverMultiplexer::SeatObserverMultiplexer(
     std::shared_ptr<mir::Executor> const& default_executor)
     : ObserverMultiplexer(*default_executor),
@@ -47,6 +47,8 @@ public:
 
     void seat_reset_confinement_regions() override;
 
+    void seat_keymap_cache_updated(uint64_t compilations, uint64_t shm_bytes) override;
+
 private:
     std::shared_ptr<Executor> const executor;
 };
@@ -18,12 +18,13 @@
 
 #include "mir/input/scene.h"
 #include "mir/input/surface.h"
+#include "mir/input/input_report.h"
 #include "mir/scene/null_observer.h"
 #include "mir/scene/surface.h"
 #include "mir/scene/null_surface_observer.h"
 #include "mir/events/event_helpers.h"
 #include "mir/events/pointer_event.h"
-#include "mir_toolkit/mir_cookie.h"
+#include "mir/pooled_allocator.h"
 
 #include <boost/throw_exception.hpp>
 #include <stdexcept>
@@ -110,41 +111,45 @@ void set_local_positions_based_on_surface_input_bounds(
         });
 }
 
-void deliver_without_relative_motion(std::shared_ptr<mi::Surface> const& surface, MirEvent const* ev)
+auto pointer_event_pool() -> mir::BlockPool&
 {
-    auto const* input_ev = mir_event_get_input_event(ev);
-    auto const* pev = mir_input_event_get_pointer_event(input_ev);
-    std::vector<uint8_t> cookie_data;
-    if (mir_input_event_has_cookie(input_ev))
+    // Leaked, as events can outlive the dispatcher on their way to clients
+    static auto* const pool = new mir::BlockPool;
+    return *pool;
+}
+
+/// A copy of ev for a surface to consume. Pointer events arrive at the rate the
+/// device reports (which may be many times the display rate) so their copies, and
+/// the control blocks sharing them, are made in recycled memory
+auto copy_for_delivery(MirEvent const& ev) -> std::shared_ptr<MirEvent>
+{
+    auto const* input_ev = mir_event_get_input_event(&ev);
+    if (mir_input_event_get_type(input_ev) == mir_input_event_type_pointer)
     {
-        auto cookie = mir_input_event_get_cookie(input_ev);
-        cookie_data.resize(mir_cookie_buffer_size(cookie));
-        mir_cookie_to_buffer(cookie, cookie_data.data(), mir_cookie_buffer_size(cookie));
-        mir_cookie_release(cookie);
+        return mir::make_pooled<MirPointerEvent>(pointer_event_pool(), *input_ev->to_pointer());
     }
-    auto const& bounds = surface->input_bounds();
 
-    auto to_deliver = mev::make_pointer_event(
-        mir_input_event_get_device_id(input_ev),
-        std::chrono::nanoseconds{mir_input_event_get_event_time(input_ev)},
-        cookie_data,
-        mir_pointer_event_modifiers(pev),
-        mir_pointer_event_action(pev),
-        mir_pointer_event_buttons(pev),
-        mir_pointer_event_axis_value(pev, mir_pointer_axis_x),
-        mir_pointer_event_axis_value(pev, mir_pointer_axis_y),
-        0.0f,
-        0.0f,
-        0.0f,
-        0.0f);
+    return mev::clone_event(ev);
+}
+
+void deliver_without_relative_motion(std::shared_ptr<mi::Surface> const& surface, MirEvent const* ev)
+{
+    auto to_deliver = copy_for_delivery(*ev);
+
+    auto* const pointer_ev = to_deliver->to_input()->to_pointer();
+    pointer_ev->set_motion({});
+    pointer_ev->set_axis_source(mir_pointer_axis_source_none);
+    pointer_ev->set_h_scroll({});
+    pointer_ev->set_v_scroll({});
 
+    auto const& bounds = surface->input_bounds();
     set_local_positions_based_on_surface_input_bounds(*to_deliver, bounds);
     surface->consume(std::move(to_deliver));
 }
 
 void deliver(std::shared_ptr<mi::Surface> const& surface, MirEvent const* ev)
 {
-    auto to_deliver = mev::clone_event(*ev);
+    auto to_deliver = copy_for_delivery(*ev);
 
     auto const& bounds = surface->input_bounds();
     set_local_positions_based_on_surface_input_bounds(*to_deliver, bounds);
@@ -153,8 +158,11 @@ void deliver(std::shared_ptr<mi::Surface> const& surface, MirEvent const* ev)
 
 }
 
-mi::SurfaceInputDispatcher::SurfaceInputDispatcher(std::shared_ptr<mi::Scene> const& scene)
+mi::SurfaceInputDispatcher::SurfaceInputDispatcher(
+    std::shared_ptr<mi::Scene> const& scene,
+    std::shared_ptr<mi::InputReport> const& report)
     : scene(scene),
+      report(report),
       screen_is_locked(false)
 {
     scene_observer = std::make_shared<InputDispatcherSceneObserver>(
@@ -428,8 +436,8 @@ void mi::SurfaceInputDispatcher::send_enter_exit_event(std::shared_ptr<mi::Surfa
                                                        MirPointerAction action)
 {
     auto const* input_ev = mir_pointer_event_input_event(pev);
-    auto event = mev::clone_event(*mir_input_event_get_event(input_ev));
-    auto const pointer_ev = static_cast<MirPointerEvent*>(event.get());
+    auto event = copy_for_delivery(*mir_input_event_get_event(input_ev));
+    auto const pointer_ev = event->to_input()->to_pointer();
     pointer_ev->set_action(action);
     if (pointer_ev->position())
     {
@@ -596,18 +604,28 @@ bool mi::SurfaceInputDispatcher::dispatch(std::shared_ptr<MirEvent const> const&
     
     auto iev = mir_event_get_input_event(event.get());
     auto id = mir_input_event_get_device_id(iev);
+    bool delivered;
     switch (mir_input_event_get_type(iev))
     {
     case mir_input_event_type_key:
     case mir_input_event_type_keyboard_resync:
-        return dispatch_key(event);
+        delivered = dispatch_key(event);
+        break;
     case mir_input_event_type_touch:
-        return dispatch_touch(id, event.get());
+        delivered = dispatch_touch(id, event.get());
+        break;
     case mir_input_event_type_pointer:
-        return dispatch_pointer(id, event);
+        delivered = dispatch_pointer(id, event);
+        break;
     default:
         BOOST_THROW_EXCEPTION(std::logic_error("InputDispatcher got an input event of unknown type"));
     }
+
+    if (delivered)
+    {
+        report->delivered_event_to_surface(mir_input_event_get_event_time(iev));
+    }
+    return delivered;
 }
 
 void mi::SurfaceInputDispatcher::start()
@@ -42,6 +42,7 @@ namespace input
 {
 class Surface;
 class Scene;
+class InputReport;
 
 class SurfaceInputDispatcher :
     public input::InputDispatcher,
@@ -50,7 +51,7 @@ class SurfaceInputDispatcher :
     public ObserverRegistrar<KeyboardObserver>
 {
 public:
-    SurfaceInputDispatcher(std::shared_ptr<input::Scene> const& scene);
+    SurfaceInputDispatcher(std::shared_ptr<input::Scene> const& scene, std::shared_ptr<InputReport> const& report);
     ~SurfaceInputDispatcher();
 
     // mir::input::InputDispatcher
@@ -116,6 +117,7 @@ private:
     } keyboard_multiplexer;
 
     std::shared_ptr<input::Scene> const scene;
+    std::shared_ptr<InputReport> const report;
 
     std::shared_ptr<scene::Observer> scene_observer;
 
@@ -83,6 +83,16 @@ public:
         return true;
     }
 
+    geom::Rectangles damage() const override
+    {
+        return {screen_position()};
+    }
+
+    geom::Rectangles opaque_region() const override
+    {
+        return {};
+    }
+
 // TouchspotRenderable    
     void move_center_to(geom::Point pos)
     {
@@ -120,7 +130,7 @@ void mi::TouchspotController::visualize_touches(std::vector<Spot> const& touches
     // interface as it does with application window surfaces. So if our last action is moving a spot
     // we must ask the scene to emit a scene changed. In the case of adding or removing a visualiza-
     // tion we expect the scene to handle this for us.
-    bool must_update_scene = false;
+    geom::Rectangles damage;
 
     {
     std::lock_guard lg(guard);
@@ -133,12 +143,14 @@ void mi::TouchspotController::visualize_touches(std::vector<Spot> const& touches
     for (unsigned int i = 0; i < num_touches; i++)
     {
         auto const& renderable = touchspot_renderables[i];
-        
+
+        if (i < renderables_in_use)
+            damage.add(renderable->screen_position());
         renderable->move_center_to(touches[i].touch_location);
         if (i >= renderables_in_use)
             scene->add_input_visualization(renderable);
-        
-        must_update_scene = true;
+
+        damage.add(renderable->screen_position());
     }
     
     for (unsigned int i = num_touches; i < renderables_in_use; i++)
@@ -149,9 +161,9 @@ void mi::TouchspotController::visualize_touches(std::vector<Spot> const& touches
 
     // TODO (hackish): We may have just moved renderables which with the current
     // architecture of surface observers will not trigger a propagation to the
-    // compositor damage callback we need this "emit_scene_changed".
-    if (must_update_scene)
-        scene->emit_scene_changed();
+    // compositor damage callback we need this "emit_scene_damage".
+    if (damage.size() > 0)
+        scene->emit_scene_damage(damage.bounding_rectangle());
 }
 
 void mi::TouchspotController::enable()
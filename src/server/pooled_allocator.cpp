@@ -0,0 +1,109 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/pooled_allocator.h"
+
+#include <new>
+
+namespace
+{
+thread_local uint64_t heap_allocations{0};
+
+auto make_arenas(size_t count, size_t max_free_blocks) -> std::vector<std::unique_ptr<mir::BlockPool::Arena>>
+{
+    std::vector<std::unique_ptr<mir::BlockPool::Arena>> arenas;
+    for (size_t i = 0; i != count; ++i)
+        arenas.push_back(std::make_unique<mir::BlockPool::Arena>(max_free_blocks));
+    return arenas;
+}
+}
+
+mir::BlockPool::Arena::Arena(size_t max_free_blocks)
+    : max_free_blocks{max_free_blocks}
+{
+    // Reserve up front so that returning a block never needs to allocate
+    free_blocks.reserve(max_free_blocks);
+}
+
+mir::BlockPool::Arena::~Arena()
+{
+    for (auto const block : free_blocks)
+        ::operator delete(block);
+}
+
+auto mir::BlockPool::Arena::allocate(size_t size) -> void*
+{
+    {
+        std::lock_guard lock{mutex};
+
+        if (block_size == 0)
+            block_size = size;
+
+        if (size == block_size && !free_blocks.empty())
+        {
+            auto const block = free_blocks.back();
+            free_blocks.pop_back();
+            return block;
+        }
+    }
+
+    ++heap_allocations;
+    return ::operator new(size);
+}
+
+void mir::BlockPool::Arena::deallocate(void* block, size_t size) noexcept
+{
+    {
+        std::lock_guard lock{mutex};
+
+        if (size == block_size && free_blocks.size() < max_free_blocks)
+        {
+            free_blocks.push_back(block);
+            return;
+        }
+    }
+
+    ::operator delete(block);
+}
+
+mir::BlockPool::BlockPool(size_t max_free_blocks)
+    : arenas{make_arenas(arena_count, max_free_blocks)}
+{
+}
+
+mir::BlockPool::~BlockPool() = default;
+
+auto mir::BlockPool::arena_for(void const* key) -> Arena&
+{
+    // Keys are usually addresses of similarly aligned objects, so mix in the high bits
+    auto const hash = reinterpret_cast<uintptr_t>(key) * uint64_t{0x9e3779b97f4a7c15};
+    return *arenas[(hash >> 32) % arenas.size()];
+}
+
+auto mir::BlockPool::allocate(size_t size) -> void*
+{
+    return arena_for(nullptr).allocate(size);
+}
+
+void mir::BlockPool::deallocate(void* block, size_t size) noexcept
+{
+    arena_for(nullptr).deallocate(block, size);
+}
+
+auto mir::BlockPool::heap_allocations_on_this_thread() -> uint64_t
+{
+    return heap_allocations;
+}
@@ -93,6 +93,8 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
             ).count();
 
         long bypass_percent = dn ? (nbypassed - last_reported_bypassed) * 100L / dn : 0;
+        long ds = nskipped - last_reported_skipped;
+        long da = nallocations - last_reported_allocations;
 
         // Keep everything premultiplied by 1000 to guarantee accuracy
         // and avoid floating point.
@@ -101,12 +103,14 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
         long avg_latency_usec = dn ? dl / dn : 0;
         long dt_msec = dt / 1000L;
 
-        char msg[128];
+        char msg[192];
         snprintf(msg, sizeof msg, "Display %p averaged %ld.%03ld FPS, "
                  "%ld.%03ld ms/frame, "
                  "latency %ld.%03ld ms, "
                  "%ld frames over %ld.%03ld sec, "
-                 "%ld%% bypassed",
+                 "%ld%% bypassed, "
+                 "%ld skipped, "
+                 "%ld snapshot allocations",
                  id,
                  frames_per_1000sec / 1000,
                  frames_per_1000sec % 1000,
@@ -117,7 +121,9 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
                  dn,
                  dt_msec / 1000,
                  dt_msec % 1000,
-                 bypass_percent
+                 bypass_percent,
+                 ds,
+                 da
                  );
 
         logger.log(ml::Severity::informational, msg, component);
@@ -128,6 +134,8 @@ void mrl::CompositorReport::Instance::log(ml::Logger& logger, SubCompositorId id
     last_reported_latency_sum = latency_sum;
     last_reported_nframes = nframes;
     last_reported_bypassed = nbypassed;
+    last_reported_skipped = nskipped;
+    last_reported_allocations = nallocations;
 }
 
 void mrl::CompositorReport::finished_frame(SubCompositorId id)
@@ -164,6 +172,18 @@ void mrl::CompositorReport::finished_frame(SubCompositorId id)
     inst.prev_bypassed = inst.bypassed;
 }
 
+void mrl::CompositorReport::skipped_frame(SubCompositorId id)
+{
+    std::lock_guard lock(mutex);
+    ++instance[id].nskipped;
+}
+
+void mrl::CompositorReport::snapshot_allocations(SubCompositorId id, unsigned long allocations)
+{
+    std::lock_guard lock(mutex);
+    instance[id].nallocations += allocations;
+}
+
 void mrl::CompositorReport::started()
 {
     logger->log(ml::Severity::informational, "Started", component);
@@ -45,6 +45,8 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void skipped_frame(SubCompositorId id) override;
+    void snapshot_allocations(SubCompositorId id, unsigned long allocations) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
@@ -65,6 +67,8 @@ private:
         TimePoint latency_sum;
         long nframes = 0;
         long nbypassed = 0;
+        long nskipped = 0;
+        long nallocations = 0;
         bool bypassed = true;
         bool prev_bypassed = false;
 
@@ -73,6 +77,8 @@ private:
         TimePoint last_reported_latency_sum;
         long last_reported_nframes = 0;
         long last_reported_bypassed = 0;
+        long last_reported_skipped = 0;
+        long last_reported_allocations = 0;
 
         void log(mir::logging::Logger& logger, SubCompositorId id);
     };
@@ -190,3 +190,14 @@ void mrl::DisplayReport::report_vsync(unsigned int output_id,
     }
     prev_frame[output_id] = frame;
 }
+
+void mrl::DisplayReport::report_dmabuf_import(geometry::Size size, size_t planes, bool reused)
+{
+    // Reuses happen on every commit; only new imports are interesting to read about
+    if (!reused)
+    {
+        logger->log(component(), ml::Severity::debug,
+            "Imported %dx%d dma-buf (%zu plane(s)) into EGL",
+            size.width.as_int(), size.height.as_int(), planes);
+    }
+}
@@ -58,6 +58,7 @@ class DisplayReport : public graphics::DisplayReport
     virtual void report_vt_switch_away_failure() override;
     virtual void report_vt_switch_back_failure() override;
     virtual void report_egl_configuration(EGLDisplay disp, EGLConfig cfg) override;
+    virtual void report_dmabuf_import(geometry::Size size, size_t planes, bool reused) override;
 
   protected:
     DisplayReport(DisplayReport const&) = delete;
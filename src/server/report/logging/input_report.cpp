@@ -18,16 +18,36 @@
 
 #include "mir/logging/logger.h"
 #include "mir/logging/input_timestamp.h"
+#include "mir/time/clock.h"
 
 #include <linux/input.h>
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
 #include <sstream>
 
 namespace mrl = mir::report::logging;
 namespace ml = mir::logging;
 
-mrl::InputReport::InputReport(const std::shared_ptr<ml::Logger>& logger)
-    : logger(logger)
+namespace
+{
+auto const min_report_interval = std::chrono::seconds(1);
+
+auto as_ms(mir::time::Duration duration) -> std::string
+{
+    auto const us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    char ms[32];
+    snprintf(ms, sizeof ms, "%lld.%03lldms", static_cast<long long>(us / 1000), static_cast<long long>(us % 1000));
+    return ms;
+}
+}
+
+mrl::InputReport::InputReport(const std::shared_ptr<ml::Logger>& logger, std::shared_ptr<time::Clock> const& clock)
+    : logger(logger),
+      clock(clock),
+      last_report(clock->now())
 {
 }
 
@@ -169,3 +189,101 @@ void mrl::InputReport::failed_to_open_input_device(char const* device_name, char
 
     logger->log(ml::Severity::informational, ss.str(), component());
 }
+
+void mrl::InputReport::dispatched_event_from_seat(int64_t event_time)
+{
+    record(seat_dispatch, event_time);
+}
+
+void mrl::InputReport::delivered_event_to_surface(int64_t event_time)
+{
+    record(surface_delivery, event_time);
+}
+
+void mrl::InputReport::flushed_event_to_client(int64_t event_time)
+{
+    record(client_flush, event_time);
+}
+
+void mrl::InputReport::record(Stage stage, int64_t event_time)
+{
+    auto const now = clock->now();
+
+    std::lock_guard lock{mutex};
+    latencies[stage].add(now.time_since_epoch() - std::chrono::nanoseconds{event_time});
+
+    if (now - last_report < min_report_interval)
+    {
+        return;
+    }
+
+    last_report = now;
+
+    auto const summary = [this](Stage stage)
+        {
+            std::stringstream ss;
+            ss << "p50=" << as_ms(latencies[stage].percentile(50))
+               << " p99=" << as_ms(latencies[stage].percentile(99))
+               << " (" << latencies[stage].count() << " events)";
+            return ss.str();
+        };
+
+    std::stringstream ss;
+    ss << "Latency from kernel to"
+       << " seat dispatch " << summary(seat_dispatch)
+       << ", surface " << summary(surface_delivery)
+       << ", client flush " << summary(client_flush);
+
+    logger->log(ml::Severity::informational, ss.str(), component());
+
+    for (auto& stage_latencies : latencies)
+    {
+        stage_latencies.clear();
+    }
+}
+
+void mrl::InputReport::Latencies::add(time::Duration latency)
+{
+    auto const us = static_cast<uint32_t>(std::clamp<int64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(latency).count(), 0, UINT32_MAX));
+
+    // Keep the top bits of larger values, as many as there are in sub_buckets
+    int const significant_bits = std::bit_width(unsigned{sub_buckets});
+    auto const exponent = std::max(0, static_cast<int>(std::bit_width(us)) - significant_bits);
+    ++buckets[exponent * sub_buckets + (us >> exponent)];
+    ++total;
+}
+
+auto mrl::InputReport::Latencies::percentile(double percent) const -> time::Duration
+{
+    if (!total)
+    {
+        return time::Duration{0};
+    }
+
+    auto const wanted = std::max<uint64_t>(1, std::ceil(percent / 100 * total));
+    uint64_t counted = 0;
+    for (size_t i = 0; i != buckets.size(); ++i)
+    {
+        counted += buckets[i];
+        if (counted >= wanted)
+        {
+            if (i < sub_buckets)
+            {
+                return std::chrono::microseconds{static_cast<int64_t>(i)};
+            }
+
+            auto const exponent = i / sub_buckets - 1;
+            auto const upper_bound = ((i % sub_buckets + sub_buckets + 1) << exponent) - 1;
+            return std::chrono::microseconds{static_cast<int64_t>(upper_bound)};
+        }
+    }
+
+    return time::Duration{0};
+}
+
+void mrl::InputReport::Latencies::clear()
+{
+    buckets.fill(0);
+    total = 0;
+}
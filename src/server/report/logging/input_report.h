@@ -18,8 +18,11 @@
 #define MIR_REPORT_LOGGING_INPUT_REPORT_H_
 
 #include "mir/input/input_report.h"
+#include "mir/time/types.h"
 
+#include <array>
 #include <memory>
+#include <mutex>
 
 namespace mir
 {
@@ -27,6 +30,10 @@ namespace logging
 {
 class Logger;
 }
+namespace time
+{
+class Clock;
+}
 namespace report
 {
 namespace logging
@@ -35,7 +42,7 @@ namespace logging
 class InputReport : public input::InputReport
 {
 public:
-    InputReport(std::shared_ptr<mir::logging::Logger> const& logger);
+    InputReport(std::shared_ptr<mir::logging::Logger> const& logger, std::shared_ptr<time::Clock> const& clock);
     virtual ~InputReport() noexcept(true) = default;
 
     void received_event_from_kernel(int64_t when, int type, int code, int value) override;
@@ -45,9 +52,40 @@ public:
 
     void opened_input_device(char const* device_name, char const* input_platform) override;
     void failed_to_open_input_device(char const* device_name, char const* input_platform) override;
+
+    void dispatched_event_from_seat(int64_t event_time) override;
+    void delivered_event_to_surface(int64_t event_time) override;
+    void flushed_event_to_client(int64_t event_time) override;
 private:
+    /// Latencies (from the kernel) to within 1/16 of their value, from 1us to over an hour
+    class Latencies
+    {
+    public:
+        void add(time::Duration latency);
+        auto count() const -> uint64_t { return total; }
+        /// The smallest latency that at least the given percent of those added don't exceed
+        auto percentile(double percent) const -> time::Duration;
+        void clear();
+
+    private:
+        static int constexpr sub_buckets = 16;
+        /// Exact counts below sub_buckets microseconds, then sub_buckets for each power of two up to 2^32us
+        std::array<uint32_t, (1 + 28) * sub_buckets> buckets{};
+        uint64_t total{0};
+    };
+
+    enum Stage { seat_dispatch, surface_delivery, client_flush, stages };
+
     char const* component();
+    void record(Stage stage, int64_t event_time);
+
     std::shared_ptr<mir::logging::Logger> const logger;
+    std::shared_ptr<time::Clock> const clock;
+
+    std::mutex mutex;
+    /// The latencies of each stage since the last time they were logged
+    std::array<Latencies, stages> latencies;
+    time::Timestamp last_report;
 };
 
 }
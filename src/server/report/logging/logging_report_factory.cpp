@@ -50,7 +50,7 @@ std::shared_ptr<mir::scene::SceneReport> mr::LoggingReportFactory::create_scene_
 
 std::shared_ptr<mir::input::InputReport> mr::LoggingReportFactory::create_input_report()
 {
-    return std::make_shared<logging::InputReport>(logger);
+    return std::make_shared<logging::InputReport>(logger, clock);
 }
 
 std::shared_ptr<mir::input::SeatObserver> mr::LoggingReportFactory::create_seat_report()
@@ -132,3 +132,13 @@ void mrl::SeatReport::seat_reset_confinement_regions()
 
     log->log(ml::Severity::informational, ss.str(), component);
 }
+
+void mrl::SeatReport::seat_keymap_cache_updated(uint64_t compilations, uint64_t shm_bytes)
+{
+    std::stringstream ss;
+    ss << "Keymap cache updated"
+       << " compilations=" << compilations
+       << " shm_bytes=" << shm_bytes;
+
+    log->log(ml::Severity::informational, ss.str(), component);
+}
@@ -60,3 +60,13 @@ void mir::report::lttng::CompositorReport::finished_frame(SubCompositorId id)
 {
     mir_tracepoint(mir_server_compositor, finished_frame, id);
 }
+
+void mir::report::lttng::CompositorReport::skipped_frame(SubCompositorId id)
+{
+    mir_tracepoint(mir_server_compositor, skipped_frame, id);
+}
+
+void mir::report::lttng::CompositorReport::snapshot_allocations(SubCompositorId id, unsigned long allocations)
+{
+    mir_tracepoint(mir_server_compositor, snapshot_allocations, id, allocations);
+}
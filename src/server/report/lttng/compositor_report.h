@@ -38,6 +38,8 @@ public:
     void renderables_in_frame(SubCompositorId id, graphics::RenderableList const& renderables) override;
     void rendered_frame(SubCompositorId id) override;
     void finished_frame(SubCompositorId id) override;
+    void skipped_frame(SubCompositorId id) override;
+    void snapshot_allocations(SubCompositorId id, unsigned long allocations) override;
     void started() override;
     void stopped() override;
     void scheduled() override;
@@ -78,6 +78,23 @@ TRACEPOINT_EVENT_INSTANCE(
     TP_ARGS(void const*, id)
 )
 
+TRACEPOINT_EVENT_INSTANCE(
+    mir_server_compositor,
+    subcompositor_event,
+    skipped_frame,
+    TP_ARGS(void const*, id)
+)
+
+TRACEPOINT_EVENT(
+    mir_server_compositor,
+    snapshot_allocations,
+    TP_ARGS(void const*, id, unsigned long, allocations),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, id, (uintptr_t)(id))
+        ctf_integer(unsigned long, allocations, allocations)
+    )
+)
+
 TRACEPOINT_EVENT(
     mir_server_compositor,
     buffers_in_frame,
@@ -50,3 +50,9 @@ void mir::report::lttng::DisplayReport::report_vsync(unsigned int output_id,
 {
     mir_tracepoint(mir_server_display, report_vsync, output_id);
 }
+
+void mir::report::lttng::DisplayReport::report_dmabuf_import(geometry::Size size, size_t planes, bool reused)
+{
+    mir_tracepoint(mir_server_display, report_dmabuf_import,
+                   size.width.as_int(), size.height.as_int(), static_cast<int>(planes), reused);
+}
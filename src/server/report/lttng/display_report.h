@@ -44,6 +44,7 @@ public:
     virtual void report_vt_switch_away_failure() override;
     virtual void report_vt_switch_back_failure() override;
     virtual void report_vsync(unsigned int output_id, graphics::Frame const&) override;
+    virtual void report_dmabuf_import(geometry::Size size, size_t planes, bool reused) override;
 
 private:
     ServerTracepointProvider tp_provider;
@@ -69,6 +69,18 @@ TRACEPOINT_EVENT(
      )
 )
 
+TRACEPOINT_EVENT(
+    mir_server_display,
+    report_dmabuf_import,
+    TP_ARGS(int, width, int, height, int, planes, int, reused),
+    TP_FIELDS(
+        ctf_integer(int, width, width)
+        ctf_integer(int, height, height)
+        ctf_integer(int, planes, planes)
+        ctf_integer(int, reused, reused)
+     )
+)
+
 #endif /* MIR_LTTNG_DISPLAY_REPORT_TP_H_ */
 
 #include <lttng/tracepoint-event.h>
@@ -46,3 +46,18 @@ void mir::report::lttng::InputReport::failed_to_open_input_device(char const* na
 {
     mir_tracepoint(mir_server_input, failed_to_open_input_device, name, platform);
 }
+
+void mir::report::lttng::InputReport::dispatched_event_from_seat(int64_t event_time)
+{
+    mir_tracepoint(mir_server_input, dispatched_event_from_seat, event_time);
+}
+
+void mir::report::lttng::InputReport::delivered_event_to_surface(int64_t event_time)
+{
+    mir_tracepoint(mir_server_input, delivered_event_to_surface, event_time);
+}
+
+void mir::report::lttng::InputReport::flushed_event_to_client(int64_t event_time)
+{
+    mir_tracepoint(mir_server_input, flushed_event_to_client, event_time);
+}
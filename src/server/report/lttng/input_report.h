@@ -41,6 +41,10 @@ public:
 
     void opened_input_device(char const* device_name, char const* input_platform) override;
     void failed_to_open_input_device(char const* device_name, char const* input_platform) override;
+
+    void dispatched_event_from_seat(int64_t event_time) override;
+    void delivered_event_to_surface(int64_t event_time) override;
+    void flushed_event_to_client(int64_t event_time) override;
 private:
     ServerTracepointProvider tp_provider;
 };
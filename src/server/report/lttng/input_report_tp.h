@@ -86,6 +86,37 @@ TRACEPOINT_EVENT_INSTANCE(
     TP_ARGS(const char*, device, const char*, platform)
 )
 
+/* The trace's own timestamps, less event_time, give the latency to each stage */
+TRACEPOINT_EVENT_CLASS(
+    mir_server_input,
+    event_stage,
+    TP_ARGS(int64_t, event_time),
+    TP_FIELDS(
+        ctf_integer(int64_t, event_time, event_time)
+    )
+)
+
+TRACEPOINT_EVENT_INSTANCE(
+    mir_server_input,
+    event_stage,
+    dispatched_event_from_seat,
+    TP_ARGS(int64_t, event_time)
+)
+
+TRACEPOINT_EVENT_INSTANCE(
+    mir_server_input,
+    event_stage,
+    delivered_event_to_surface,
+    TP_ARGS(int64_t, event_time)
+)
+
+TRACEPOINT_EVENT_INSTANCE(
+    mir_server_input,
+    event_stage,
+    flushed_event_to_client,
+    TP_ARGS(int64_t, event_time)
+)
+
 #endif /* MIR_LTTNG_DISPLAY_REPORT_TP_H_ */
 
 #include <lttng/tracepoint-event.h>
@@ -38,6 +38,14 @@ void mrn::CompositorReport::finished_frame(SubCompositorId)
 {
 }
 
+void mrn::CompositorReport::skipped_frame(SubCompositorId)
+{
+}
+
+void mrn::CompositorReport::snapshot_allocations(SubCompositorId, unsigned long)
+{
+}
+
 void mrn::CompositorReport::started()
 {
 }
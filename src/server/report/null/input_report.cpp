@@ -37,3 +37,15 @@ void mrn::InputReport::opened_input_device(char const* /* name */, char const* /
 void mrn::InputReport::failed_to_open_input_device(char const* /* name */, char const* /* platform */)
 {
 }
+
+void mrn::InputReport::dispatched_event_from_seat(int64_t /* event_time */)
+{
+}
+
+void mrn::InputReport::delivered_event_to_surface(int64_t /* event_time */)
+{
+}
+
+void mrn::InputReport::flushed_event_to_client(int64_t /* event_time */)
+{
+}
@@ -50,3 +50,7 @@ void mrn::SeatReport::seat_set_confinement_region_called(geom::Rectangles const&
 void mrn::SeatReport::seat_reset_confinement_regions()
 {
 }
+
+void mrn::SeatReport::seat_keymap_cache_updated(uint64_t, uint64_t)
+{
+}
@@ -38,6 +38,7 @@ public:
     virtual void seat_set_cursor_position(float cursor_x, float cursor_y) override;
     virtual void seat_set_confinement_region_called(geometry::Rectangles const& regions) override;
     virtual void seat_reset_confinement_regions() override;
+    virtual void seat_keymap_cache_updated(uint64_t compilations, uint64_t shm_bytes) override;
 };
 
 }
@@ -21,8 +21,10 @@
 #include "mir/graphics/cursor_image.h"
 #include "mir/graphics/pixel_format_utils.h"
 #include "mir/geometry/displacement.h"
+#include "mir/geometry/rectangles.h"
 #include "mir/renderer/sw/pixel_source.h"
 #include "mir/observer_multiplexer.h"
+#include "mir/pooled_allocator.h"
 
 #include "mir/scene/scene_report.h"
 #include "mir/scene/null_surface_observer.h"
@@ -31,6 +33,7 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <cmath>
 
 namespace mc = mir::compositor;
 namespace ms = mir::scene;
@@ -138,6 +141,11 @@ public:
     {
         for_each_observer(&SurfaceObserver::application_id_set_to, surf, application_id);
     }
+
+    void input_region_set_to(Surface const* surf, std::vector<geometry::Rectangle> const& region) override
+    {
+        for_each_observer(&SurfaceObserver::input_region_set_to, surf, region);
+    }
 };
 
 namespace
@@ -275,6 +283,7 @@ std::shared_ptr<mf::BufferStream> ms::BasicSurface::primary_buffer_stream() cons
 void ms::BasicSurface::set_input_region(std::vector<geom::Rectangle> const& input_rectangles)
 {
     synchronised_state.lock()->custom_input_rectangles = input_rectangles;
+    observers->input_region_set_to(this, input_rectangles);
 }
 
 std::vector<geom::Rectangle> ms::BasicSurface::get_input_region() const
@@ -683,6 +692,7 @@ public:
         std::optional<geom::Rectangle> const& clip_area,
         glm::mat4 const& transform,
         float alpha,
+        std::vector<geom::Rectangle> const& opaque_region,
         mg::Renderable::ID id)
     : underlying_buffer_stream{stream},
       compositor_id{compositor_id},
@@ -690,6 +700,7 @@ public:
       screen_position_(position),
       clip_area_(clip_area),
       transformation_(transform),
+      opaque_region_(opaque_region),
       id_(id)
     {
     }
@@ -720,6 +731,62 @@ public:
     bool shaped() const override
     { return mg::contains_alpha(underlying_buffer_stream->pixel_format()); }
 
+    geom::Rectangles damage() const override
+    {
+        auto const buffer_size = buffer()->size();
+        if (buffer_size.width.as_int() <= 0 || buffer_size.height.as_int() <= 0)
+            return {screen_position_};
+
+        // A transformed buffer can be drawn anywhere, so only the whole of it is safe
+        if (transformation_ != glm::mat4{1})
+            return {screen_position_};
+
+        // Map from buffer coordinates to screen coordinates, rounding outwards so scaled damage is never lost
+        auto const x_scale = screen_position_.size.width.as_value() / double(buffer_size.width.as_value());
+        auto const y_scale = screen_position_.size.height.as_value() / double(buffer_size.height.as_value());
+
+        geom::Rectangles result;
+        for (auto const& rect : underlying_buffer_stream->damage_for(compositor_id))
+        {
+            auto const left = static_cast<int>(std::floor(rect.left().as_int() * x_scale));
+            auto const top = static_cast<int>(std::floor(rect.top().as_int() * y_scale));
+            auto const right = static_cast<int>(std::ceil(rect.right().as_int() * x_scale));
+            auto const bottom = static_cast<int>(std::ceil(rect.bottom().as_int() * y_scale));
+
+            auto const damaged = intersection_of(
+                geom::Rectangle{
+                    screen_position_.top_left + geom::Displacement{left, top},
+                    geom::Size{right - left, bottom - top}},
+                screen_position_);
+
+            if (damaged.size != geom::Size{})
+                result.add(damaged);
+        }
+        return result;
+    }
+
+    geom::Rectangles opaque_region() const override
+    {
+        if (!shaped())
+            return {screen_position_};
+
+        // The opaque region is in stream coordinates; don't try to map it if the stream is being scaled
+        if (screen_position_.size != underlying_buffer_stream->stream_size())
+            return {};
+
+        geom::Rectangles result;
+        for (auto const& rect : opaque_region_)
+        {
+            auto const opaque = intersection_of(
+                geom::Rectangle{screen_position_.top_left + as_displacement(rect.top_left), rect.size},
+                screen_position_);
+
+            if (opaque.size != geom::Size{})
+                result.add(opaque);
+        }
+        return result;
+    }
+
     mg::Renderable::ID id() const override
     { return id_; }
 private:
@@ -730,8 +797,17 @@ private:
     geom::Rectangle const screen_position_;
     std::optional<geom::Rectangle> const clip_area_;
     glm::mat4 const transformation_;
+    std::vector<geom::Rectangle> const opaque_region_;
     mg::Renderable::ID const id_;
 };
+
+// Snapshots are taken for every frame, so recycle their memory in the arena for the compositor
+// taking them. The pool is never destroyed, as a snapshot may still be held when the server shuts down.
+auto snapshot_pool() -> mir::BlockPool&
+{
+    static auto* const pool = new mir::BlockPool;
+    return *pool;
+}
 }
 
 int ms::BasicSurface::buffers_ready_for_compositor(void const* id) const
@@ -787,6 +863,7 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
 
     auto const content_top_left_ = content_top_left(*state);
 
+    list.reserve(state->layers.size());
     for (auto const& info : state->layers)
     {
         if (info.stream->has_submitted_buffer())
@@ -797,16 +874,50 @@ mg::RenderableList ms::BasicSurface::generate_renderables(mc::CompositorID id) c
             else
                 size = info.stream->stream_size();
 
-            list.emplace_back(std::make_shared<SurfaceSnapshot>(
+            list.emplace_back(mir::make_pooled<SurfaceSnapshot>(
+                snapshot_pool().arena_for(id),
                 info.stream, id,
                 geom::Rectangle{content_top_left_ + info.displacement, std::move(size)},
                 state->clip_area,
-                state->transformation_matrix, state->surface_alpha, info.stream.get()));
+                state->transformation_matrix, state->surface_alpha, info.opaque_region, info.stream.get()));
         }
     }
     return list;
 }
 
+auto ms::BasicSurface::drawn_extent() const -> std::optional<geom::Rectangle>
+{
+    auto state = synchronised_state.lock();
+
+    if (state->transformation_matrix != glm::mat4{1})
+    {
+        return std::nullopt;
+    }
+
+    auto const content_top_left_ = content_top_left(*state);
+
+    // The same areas generate_renderables() gives its renderables, without making them
+    geom::Rectangles areas;
+    for (auto const& info : state->layers)
+    {
+        if (info.stream->has_submitted_buffer())
+        {
+            auto const size = info.size.is_set() ? info.size.value() : info.stream->stream_size();
+            geom::Rectangle area{content_top_left_ + info.displacement, size};
+            if (state->clip_area)
+            {
+                area = intersection_of(area, state->clip_area.value());
+            }
+            if (area.size.width > geom::Width{} && area.size.height > geom::Height{})
+            {
+                areas.add(area);
+            }
+        }
+    }
+
+    return areas.bounding_rectangle();
+}
+
 void ms::BasicSurface::set_confine_pointer_state(MirPointerConfinementState state)
 {
     synchronised_state.lock()->confine_pointer_state = state;
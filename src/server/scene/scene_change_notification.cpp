@@ -86,7 +86,7 @@ void ms::SceneChangeNotification::surface_removed(std::shared_ptr<ms::Surface> c
 
 void ms::SceneChangeNotification::surfaces_reordered(SurfaceSet const&)
 {
-    scene_notify_change();
+    // The scene reports where the reordered surfaces are drawn through scene_damaged()
 }
 
 void ms::SceneChangeNotification::scene_changed()
@@ -94,6 +94,11 @@ void ms::SceneChangeNotification::scene_changed()
     scene_notify_change();
 }
 
+void ms::SceneChangeNotification::scene_damaged(geom::Rectangle const& damage)
+{
+    damage_notify_change(1, damage);
+}
+
 void ms::SceneChangeNotification::end_observation()
 {
     std::unique_lock lg(surface_observers_guard);
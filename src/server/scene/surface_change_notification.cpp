@@ -33,18 +33,16 @@ ms::SurfaceChangeNotification::SurfaceChangeNotification(
     top_left = surface->top_left();
 }
 
+// The surface stack reports the areas moved and resized surfaces were and are drawn in as scene damage
+
 void ms::SurfaceChangeNotification::content_resized_to(Surface const*, geometry::Size const&)
 {
-    notify_scene_change();
 }
 
 void ms::SurfaceChangeNotification::moved_to(Surface const*, geometry::Point const& new_top_left)
 {
-    {
-        std::lock_guard lock{mutex};
-        top_left = new_top_left;
-    }
-    notify_scene_change();
+    std::lock_guard lock{mutex};
+    top_left = new_top_left;
 }
 
 void ms::SurfaceChangeNotification::hidden_set_to(Surface const*, bool)
@@ -0,0 +1,160 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "surface_extents.h"
+#include "mir/scene/surface.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace ms = mir::scene;
+namespace geom = mir::geometry;
+
+namespace
+{
+bool is_empty(geom::Rectangle const& area)
+{
+    return area.size.width.as_int() <= 0 || area.size.height.as_int() <= 0;
+}
+}
+
+ms::SurfaceExtents::SurfaceExtents(DamageHandler damage_handler)
+    : damage_handler{std::move(damage_handler)}
+{
+}
+
+void ms::SurfaceExtents::add(Surface const& surface)
+{
+    auto const extent = surface.drawn_extent();
+
+    std::lock_guard lock{mutex};
+    extents[&surface] = {extent, {}};
+}
+
+void ms::SurfaceExtents::remove(Surface const* surface)
+{
+    std::lock_guard lock{mutex};
+    extents.erase(surface);
+}
+
+void ms::SurfaceExtents::update(Surface const& surface)
+{
+    {
+        std::lock_guard lock{mutex};
+        if (auto const entry = extents.find(&surface); entry != extents.end())
+        {
+            entry->second.posted.clear();
+        }
+    }
+
+    reread_extent(surface);
+}
+
+void ms::SurfaceExtents::stream_posted(Surface const& surface, geom::Rectangle const& area)
+{
+    {
+        std::lock_guard lock{mutex};
+        auto const entry = extents.find(&surface);
+        if (entry == extents.end())
+        {
+            return;
+        }
+
+        auto& posted = entry->second.posted;
+        auto const same_position = std::find_if(posted.begin(), posted.end(),
+            [&](geom::Rectangle const& previous) { return previous.top_left == area.top_left; });
+        if (same_position == posted.end())
+        {
+            posted.push_back(area);
+        }
+        else if (*same_position == area)
+        {
+            // Another frame of a stream we've already accounted for
+            return;
+        }
+        else
+        {
+            *same_position = area;
+        }
+    }
+
+    reread_extent(surface);
+}
+
+void ms::SurfaceExtents::reread_extent(Surface const& surface)
+{
+    auto const extent = surface.drawn_extent();
+
+    std::optional<geom::Rectangle> previous;
+    {
+        std::lock_guard lock{mutex};
+        auto const entry = extents.find(&surface);
+        if (entry == extents.end() || (extent && entry->second.extent == extent))
+        {
+            return;
+        }
+        previous = std::exchange(entry->second.extent, extent);
+    }
+
+    if (!surface.visible())
+    {
+        return;
+    }
+
+    if (previous && extent)
+    {
+        damage(previous);
+        damage(extent);
+    }
+    else
+    {
+        damage(std::nullopt);
+    }
+}
+
+void ms::SurfaceExtents::restacked(SurfaceSet const& surfaces)
+{
+    std::vector<std::optional<geom::Rectangle>> areas;
+    {
+        std::lock_guard lock{mutex};
+        for (auto const& weak_surface : surfaces)
+        {
+            auto const surface = weak_surface.lock();
+            if (!surface || !surface->visible())
+            {
+                continue;
+            }
+            if (auto const entry = extents.find(surface.get()); entry != extents.end())
+            {
+                areas.push_back(entry->second.extent);
+            }
+        }
+    }
+
+    for (auto const& area : areas)
+    {
+        damage(area);
+    }
+}
+
+void ms::SurfaceExtents::damage(std::optional<geom::Rectangle> const& area) const
+{
+    if (!area || !is_empty(*area))
+    {
+        damage_handler(area);
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_SURFACE_EXTENTS_H_
+#define MIR_SCENE_SURFACE_EXTENTS_H_
+
+#include "mir/geometry/rectangle.h"
+#include "mir/scene/observer.h"
+
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace scene
+{
+
+class Surface;
+
+/**
+ * The screen area each surface could draw to, so that moving, resizing or restacking a
+ * surface only damages the area it was and is drawn in
+ *
+ * The extent covers all of a surface's streams (so its subsurfaces too) after clipping, and
+ * is only re-read when a surface moves, resizes or its streams change.
+ * A surface drawn with a transformation has no extent, as its renderables could be anywhere.
+ */
+class SurfaceExtents
+{
+public:
+    /// Told the area a change could have redrawn, or std::nullopt if it can't be bounded
+    using DamageHandler = std::function<void(std::optional<geometry::Rectangle> const& damage)>;
+
+    explicit SurfaceExtents(DamageHandler damage_handler);
+
+    SurfaceExtents(SurfaceExtents const&) = delete;
+    SurfaceExtents& operator=(SurfaceExtents const&) = delete;
+
+    /// Starts tracking where surface is drawn
+    void add(Surface const& surface);
+    void remove(Surface const* surface);
+
+    /// Re-reads the extent of surface, damaging where it was and where it is if they differ
+    void update(Surface const& surface);
+
+    /// A stream of surface posted a frame to area (relative to the surface). The extent is only
+    /// re-read if the stream hasn't posted to that area since the surface last changed.
+    void stream_posted(Surface const& surface, geometry::Rectangle const& area);
+
+    /// Damages where surfaces are drawn, as they have been raised or lowered
+    void restacked(SurfaceSet const& surfaces);
+
+private:
+    struct Tracked
+    {
+        std::optional<geometry::Rectangle> extent;
+        /// Where the surface's streams have posted frames since it last changed, one area per position
+        std::vector<geometry::Rectangle> posted;
+    };
+
+    void reread_extent(Surface const& surface);
+    void damage(std::optional<geometry::Rectangle> const& area) const;
+
+    DamageHandler const damage_handler;
+
+    std::mutex mutex;
+    std::unordered_map<Surface const*, Tracked> extents;
+};
+
+}
+}
+
+#endif // MIR_SCENE_SURFACE_EXTENTS_H_
@@ -0,0 +1,225 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "surface_spatial_index.h"
+#include "mir/scene/surface.h"
+#include "mir/geometry/rectangles.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace ms = mir::scene;
+namespace geom = mir::geometry;
+
+namespace
+{
+/// Surfaces spanning more cells than this are checked for every point instead
+long const max_cells_per_surface{64};
+
+/// Rounds towards negative infinity, so that no cell straddles an axis
+auto cell_of(int coordinate, int cell_size) -> int
+{
+    return coordinate >= 0 ? coordinate / cell_size : (coordinate + 1) / cell_size - 1;
+}
+
+auto const topmost_first = [](auto const* lhs, auto const* rhs) { return lhs->rank > rhs->rank; };
+}
+
+ms::SurfaceSpatialIndex::SurfaceSpatialIndex(int cell_size)
+    : cell_size{cell_size}
+{
+}
+
+void ms::SurfaceSpatialIndex::restack(std::vector<std::shared_ptr<Surface>> const& surfaces)
+{
+    std::unordered_map<Surface const*, size_t> ranks;
+    for (size_t i = 0; i != surfaces.size(); ++i)
+        ranks[surfaces[i].get()] = i;
+
+    std::lock_guard lock{mutex};
+
+    bool reordered = false;
+    for (auto i = entries.begin(); i != entries.end();)
+    {
+        if (auto const rank = ranks.find(i->first); rank != ranks.end())
+        {
+            reordered |= i->second.rank != rank->second;
+            i->second.rank = rank->second;
+            ++i;
+        }
+        else
+        {
+            erase(i->second);
+            i = entries.erase(i);
+        }
+    }
+
+    if (reordered)
+        sort_by_rank();
+
+    for (auto const& [surface, rank] : ranks)
+    {
+        auto const [entry, inserted] = entries.try_emplace(surface);
+        if (inserted)
+        {
+            auto const& shared = surfaces[rank];
+            entry->second = Entry{shared, input_extent_of(*shared), rank, false};
+            insert(entry->second);
+        }
+    }
+}
+
+void ms::SurfaceSpatialIndex::update(Surface const* surface)
+{
+    std::lock_guard lock{mutex};
+
+    auto const entry = entries.find(surface);
+    if (entry == entries.end())
+        return;
+
+    auto const extent = input_extent_of(*surface);
+    if (extent != entry->second.extent)
+    {
+        erase(entry->second);
+        entry->second.extent = extent;
+        insert(entry->second);
+    }
+}
+
+auto ms::SurfaceSpatialIndex::surface_at(
+    geometry::Point point,
+    std::function<bool(Surface const&)> const& can_be_shown) const -> std::shared_ptr<Surface>
+{
+    static Cell const no_surfaces;
+
+    std::shared_lock lock{mutex};
+
+    auto const cell = cells.find(key_for(point));
+    auto const& local_surfaces = cell != cells.end() ? cell->second : no_surfaces;
+
+    // Both lists are topmost first, so merge them to visit surfaces in stacking order
+    auto local = local_surfaces.begin();
+    auto large = large_surfaces.begin();
+    while (local != local_surfaces.end() || large != large_surfaces.end())
+    {
+        auto const entry =
+            large == large_surfaces.end() || (local != local_surfaces.end() && topmost_first(*local, *large)) ?
+            *local++ : *large++;
+
+        // TODO There's a lack of clarity about how the input area will
+        // TODO be maintained and whether this test will detect clicks on
+        // TODO decorations (it should) as these may be outside the area
+        // TODO known to the client.  But it works for now.
+        if (entry->extent.contains(point) &&
+            entry->surface->input_area_contains(point) &&
+            can_be_shown(*entry->surface))
+        {
+            return entry->surface;
+        }
+    }
+
+    return {};
+}
+
+auto ms::SurfaceSpatialIndex::input_extent_of(Surface const& surface) -> geometry::Rectangle
+{
+    auto const bounds = surface.input_bounds();
+    auto const region = surface.get_input_region();
+
+    if (region.empty())
+        return bounds;
+
+    // A custom input region replaces the bounds, and need not lie within them
+    geom::Rectangles extent;
+    for (auto const& rectangle : region)
+        extent.add({bounds.top_left + as_displacement(rectangle.top_left), rectangle.size});
+
+    return extent.bounding_rectangle();
+}
+
+auto ms::SurfaceSpatialIndex::key_for(geometry::Point point) const -> CellKey
+{
+    auto const x = static_cast<uint32_t>(cell_of(point.x.as_int(), cell_size));
+    auto const y = static_cast<uint32_t>(cell_of(point.y.as_int(), cell_size));
+    return CellKey{x} << 32 | y;
+}
+
+template<typename F>
+void ms::SurfaceSpatialIndex::for_each_cell_of(geometry::Rectangle const& extent, F const& f)
+{
+    if (extent.size.width.as_int() <= 0 || extent.size.height.as_int() <= 0)
+        return;
+
+    auto const left = cell_of(extent.left().as_int(), cell_size);
+    auto const right = cell_of(extent.right().as_int() - 1, cell_size);
+    auto const top = cell_of(extent.top().as_int(), cell_size);
+    auto const bottom = cell_of(extent.bottom().as_int() - 1, cell_size);
+
+    for (auto y = top; y <= bottom; ++y)
+    {
+        for (auto x = left; x <= right; ++x)
+        {
+            f(CellKey{static_cast<uint32_t>(x)} << 32 | static_cast<uint32_t>(y));
+        }
+    }
+}
+
+void ms::SurfaceSpatialIndex::insert(Entry& entry)
+{
+    auto const insert_into = [&entry](Cell& cell)
+        {
+            cell.insert(std::upper_bound(cell.begin(), cell.end(), &entry, topmost_first), &entry);
+        };
+
+    auto const& extent = entry.extent;
+    long const columns = cell_of(extent.right().as_int() - 1, cell_size) - cell_of(extent.left().as_int(), cell_size) + 1;
+    long const rows = cell_of(extent.bottom().as_int() - 1, cell_size) - cell_of(extent.top().as_int(), cell_size) + 1;
+
+    entry.large = columns * rows > max_cells_per_surface;
+    if (entry.large)
+    {
+        insert_into(large_surfaces);
+    }
+    else
+    {
+        for_each_cell_of(extent, [&](CellKey key) { insert_into(cells[key]); });
+    }
+}
+
+void ms::SurfaceSpatialIndex::erase(Entry const& entry)
+{
+    if (entry.large)
+    {
+        std::erase(large_surfaces, &entry);
+    }
+    else
+    {
+        for_each_cell_of(entry.extent, [&](CellKey key)
+            {
+                auto const cell = cells.find(key);
+                if (cell != cells.end() && std::erase(cell->second, &entry) && cell->second.empty())
+                    cells.erase(cell);
+            });
+    }
+}
+
+void ms::SurfaceSpatialIndex::sort_by_rank()
+{
+    for (auto& [_, cell] : cells)
+        std::sort(cell.begin(), cell.end(), topmost_first);
+
+    std::sort(large_surfaces.begin(), large_surfaces.end(), topmost_first);
+}
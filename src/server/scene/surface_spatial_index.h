@@ -0,0 +1,100 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_SCENE_SURFACE_SPATIAL_INDEX_H_
+#define MIR_SCENE_SURFACE_SPATIAL_INDEX_H_
+
+#include "mir/geometry/rectangle.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mir
+{
+namespace scene
+{
+
+class Surface;
+
+/**
+ * A uniform grid of the areas in which surfaces might accept input, in stacking order
+ *
+ * Finding the surface under a point only tests the surfaces that overlap the point's grid
+ * cell, rather than every surface in the scene. Each cell lists its surfaces topmost first.
+ */
+class SurfaceSpatialIndex
+{
+public:
+    explicit SurfaceSpatialIndex(int cell_size = 256);
+
+    SurfaceSpatialIndex(SurfaceSpatialIndex const&) = delete;
+    SurfaceSpatialIndex& operator=(SurfaceSpatialIndex const&) = delete;
+
+    /// Sets the surfaces indexed (bottom to top), adding and removing surfaces as needed
+    void restack(std::vector<std::shared_ptr<Surface>> const& surfaces);
+
+    /// Re-reads the input area of surface after it has moved, resized or changed its input region
+    void update(Surface const* surface);
+
+    /**
+     * The topmost surface accepting input at point, skipping surfaces for which can_be_shown() is false
+     *
+     * can_be_shown() is only called for surfaces with point inside their input area
+     */
+    auto surface_at(
+        geometry::Point point,
+        std::function<bool(Surface const&)> const& can_be_shown) const -> std::shared_ptr<Surface>;
+
+    /// The area that contains every point at which surface could accept input
+    static auto input_extent_of(Surface const& surface) -> geometry::Rectangle;
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<Surface> surface;
+        geometry::Rectangle extent;
+        size_t rank;    ///< Position in the stacking order (higher is closer to the top)
+        bool large;     ///< Too large to insert into the cells, so in large_surfaces instead
+    };
+
+    using CellKey = uint64_t;
+    using Cell = std::vector<Entry const*>;     ///< Topmost first
+
+    auto key_for(geometry::Point point) const -> CellKey;
+    template<typename F>
+    void for_each_cell_of(geometry::Rectangle const& extent, F const& f);
+
+    void insert(Entry& entry);
+    void erase(Entry const& entry);
+    void sort_by_rank();
+
+    int const cell_size;
+
+    std::shared_mutex mutable mutex;
+    std::unordered_map<Surface const*, Entry> entries;
+    std::unordered_map<CellKey, Cell> cells;
+    /// Surfaces covering too many cells to be worth inserting into them
+    Cell large_surfaces;
+};
+
+}
+}
+
+#endif // MIR_SCENE_SURFACE_SPATIAL_INDEX_H_
@@ -23,6 +23,7 @@
 #include "mir/graphics/renderable.h"
 #include "mir/depth_layer.h"
 #include "mir/executor.h"
+#include "mir/pooled_allocator.h"
 
 #include <boost/throw_exception.hpp>
 
@@ -46,14 +47,12 @@ class SurfaceSceneElement : public mc::SceneElement
 {
 public:
     SurfaceSceneElement(
-        std::string name,
         std::shared_ptr<mg::Renderable> const& renderable,
         std::shared_ptr<ms::RenderingTracker> const& tracker,
         mc::CompositorID id)
         : renderable_{renderable},
           tracker{tracker},
-          cid{id},
-          surface_name(name)
+          cid{id}
     {
     }
 
@@ -76,7 +75,6 @@ private:
     std::shared_ptr<mg::Renderable> const renderable_;
     std::shared_ptr<ms::RenderingTracker> const tracker;
     mc::CompositorID cid;
-    std::string const surface_name;
 };
 
 //note: something different than a 2D/HWC overlay
@@ -106,13 +104,35 @@ private:
     std::shared_ptr<mg::Renderable> const renderable_;
 };
 
+/*
+ * Scene elements only live for the frame they are composited in, so recycle their memory.
+ * Each compositor uses the pools' arenas for its CompositorID. The pools are never destroyed,
+ * as elements may be released during shutdown.
+ */
+auto surface_element_pool() -> mir::BlockPool&
+{
+    static auto* const pool = new mir::BlockPool;
+    return *pool;
+}
+
+auto overlay_element_pool() -> mir::BlockPool&
+{
+    static auto* const pool = new mir::BlockPool;
+    return *pool;
+}
+
 /**
- * A SurfaceDepthLayerObserver must not outlive the SurfaceStack it was created for
+ * A StackedSurfaceObserver must not outlive the SurfaceStack it was created for
  */
-struct SurfaceDepthLayerObserver : ms::NullSurfaceObserver
+struct StackedSurfaceObserver : ms::NullSurfaceObserver
 {
-    SurfaceDepthLayerObserver(ms::SurfaceStack* stack)
-        : stack{stack}
+    StackedSurfaceObserver(
+        ms::SurfaceStack* stack,
+        ms::SurfaceSpatialIndex* input_index,
+        ms::SurfaceExtents* extents)
+        : stack{stack},
+          input_index{input_index},
+          extents{extents}
     {
     }
 
@@ -122,8 +142,44 @@ struct SurfaceDepthLayerObserver : ms::NullSurfaceObserver
         stack->raise(surface);
     }
 
+    void moved_to(ms::Surface const* surface, geom::Point const& /*top_left*/) override
+    {
+        input_index->update(surface);
+        extents->update(*surface);
+    }
+
+    void window_resized_to(ms::Surface const* surface, geom::Size const& /*window_size*/) override
+    {
+        input_index->update(surface);
+        extents->update(*surface);
+    }
+
+    void content_resized_to(ms::Surface const* surface, geom::Size const& /*content_size*/) override
+    {
+        input_index->update(surface);
+        extents->update(*surface);
+    }
+
+    void input_region_set_to(ms::Surface const* surface, std::vector<geom::Rectangle> const& /*region*/) override
+    {
+        input_index->update(surface);
+    }
+
+    void transformation_set_to(ms::Surface const* surface, glm::mat4 const& /*t*/) override
+    {
+        extents->update(*surface);
+    }
+
+    // A stream's first frame, or one of a new size, changes where the surface is drawn
+    void frame_posted(ms::Surface const* surface, int /*frames_available*/, geom::Rectangle const& area) override
+    {
+        extents->stream_posted(*surface, area);
+    }
+
 private:
     ms::SurfaceStack* stack;
+    ms::SurfaceSpatialIndex* input_index;
+    ms::SurfaceExtents* extents;
 };
 
 }
@@ -132,7 +188,19 @@ ms::SurfaceStack::SurfaceStack(
     std::shared_ptr<SceneReport> const& report) :
     report{report},
     scene_changed{false},
-    surface_observer{std::make_shared<SurfaceDepthLayerObserver>(this)}
+    extents{[this](std::optional<geom::Rectangle> const& damage)
+        {
+            if (damage)
+            {
+                emit_scene_damage(*damage);
+            }
+            else
+            {
+                emit_scene_changed();
+            }
+        }},
+    surface_observer{std::make_shared<StackedSurfaceObserver>(this, &input_index, &extents)},
+    snapshot{std::make_shared<Snapshot const>()}
 {
 }
 
@@ -150,57 +218,52 @@ ms::SurfaceStack::~SurfaceStack() noexcept(true)
 
 mc::SceneElementSequence ms::SurfaceStack::scene_elements_for(mc::CompositorID id)
 {
-    RecursiveReadLock lg(guard);
-
+    // Clear the flag before taking the snapshot: a change published after this is either
+    // in the snapshot or will set the flag again
     scene_changed = false;
+
+    auto const current = snapshot.load();
+
+    // Most surfaces have a single renderable, so this is usually the only allocation of the sequence
     mc::SceneElementSequence elements;
-    for (auto const& layer : surface_layers)
+    elements.reserve(current->surfaces.size() + current->overlays.size());
+    for (auto const& [surface, tracker] : current->surfaces)
     {
-        for (auto const& surface : layer)
+        if (current->can_be_shown(*surface) && surface->visible())
         {
-            if (surface_can_be_shown(surface) && surface->visible())
+            for (auto& renderable : surface->generate_renderables(id))
             {
-                for (auto& renderable : surface->generate_renderables(id))
-                {
-                    elements.emplace_back(
-                        std::make_shared<SurfaceSceneElement>(
-                            surface->name(),
-                            renderable,
-                            rendering_trackers[surface.get()],
-                            id));
-                }
+                elements.emplace_back(
+                    mir::make_pooled<SurfaceSceneElement>(
+                        surface_element_pool().arena_for(id),
+                        renderable,
+                        tracker,
+                        id));
             }
         }
     }
-    for (auto const& renderable : overlays)
+    for (auto const& renderable : current->overlays)
     {
-        elements.emplace_back(std::make_shared<OverlaySceneElement>(renderable));
+        elements.emplace_back(mir::make_pooled<OverlaySceneElement>(overlay_element_pool().arena_for(id), renderable));
     }
     return elements;
 }
 
 int ms::SurfaceStack::frames_pending(mc::CompositorID id) const
 {
-    RecursiveReadLock lg(guard);
-
     int result = scene_changed ? 1 : 0;
-    for (auto const& layer : surface_layers)
+
+    auto const current = snapshot.load();
+    for (auto const& [surface, tracker] : current->surfaces)
     {
-        for (auto const& surface : layer)
+        if (current->can_be_shown(*surface) && surface->visible() && tracker->is_exposed_in(id))
         {
-            if (surface_can_be_shown(surface) && surface->visible())
-            {
-                auto const tracker = rendering_trackers.find(surface.get());
-                if (tracker != rendering_trackers.end() && tracker->second->is_exposed_in(id))
-                {
-                    // Note that we ask the surface and not a Renderable.
-                    // This is because we don't want to waste time and resources
-                    // on a snapshot till we're sure we need it...
-                    int ready = surface->buffers_ready_for_compositor(id);
-                    if (ready > result)
-                        result = ready;
-                }
-            }
+            // Note that we ask the surface and not a Renderable.
+            // This is because we don't want to waste time and resources
+            // on a snapshot till we're sure we need it...
+            int ready = surface->buffers_ready_for_compositor(id);
+            if (ready > result)
+                result = ready;
         }
     }
     return result;
@@ -230,8 +293,9 @@ void ms::SurfaceStack::add_input_visualization(
     {
         RecursiveWriteLock lg(guard);
         overlays.push_back(overlay);
+        publish_snapshot();
     }
-    emit_scene_changed();
+    emit_scene_damage(overlay->screen_position());
 }
 
 void ms::SurfaceStack::remove_input_visualization(
@@ -246,20 +310,24 @@ void ms::SurfaceStack::remove_input_visualization(
             BOOST_THROW_EXCEPTION(std::runtime_error("Attempt to remove an overlay which was never added or which has been previously removed"));
         }
         overlays.erase(p);
+        publish_snapshot();
     }
-    
-    emit_scene_changed();
+
+    emit_scene_damage(overlay->screen_position());
 }
 
 void ms::SurfaceStack::emit_scene_changed()
 {
-    {
-        RecursiveWriteLock lg(guard);
-        scene_changed = true;
-    }
+    scene_changed = true;
     observers.scene_changed();
 }
 
+void ms::SurfaceStack::emit_scene_damage(geometry::Rectangle const& damage)
+{
+    scene_changed = true;
+    observers.scene_damaged(damage);
+}
+
 void ms::SurfaceStack::add_surface(
     std::shared_ptr<Surface> const& surface,
     mi::InputReceptionMode input_mode)
@@ -268,7 +336,9 @@ void ms::SurfaceStack::add_surface(
         RecursiveWriteLock lg(guard);
         insert_surface_at_top_of_depth_layer(surface);
         create_rendering_tracker_for(surface);
+        extents.add(*surface);
         surface->register_interest(surface_observer, immediate_executor);
+        publish_snapshot();
     }
     surface->set_reception_mode(input_mode);
     observers.surface_added(surface);
@@ -293,10 +363,14 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
                 layer.erase(surface);
                 rendering_trackers.erase(keep_alive.get());
                 keep_alive->unregister_interest(*surface_observer);
+                extents.remove(keep_alive.get());
                 found_surface = true;
                 break;
             }
         }
+
+        if (found_surface)
+            publish_snapshot();
     }
 
     if (found_surface)
@@ -307,37 +381,13 @@ void ms::SurfaceStack::remove_surface(std::weak_ptr<Surface> const& surface)
     // TODO: error logging when surface not found
 }
 
-namespace
-{
-template <typename Container>
-struct InReverse {
-    Container& container;
-    auto begin() -> decltype(container.rbegin()) { return container.rbegin(); }
-    auto end() -> decltype(container.rend()) { return container.rend(); }
-};
-
-template <typename Container>
-InReverse<Container> in_reverse(Container& container) { return InReverse<Container>{container}; }
-}
-
 auto ms::SurfaceStack::surface_at(geometry::Point cursor) const
 -> std::shared_ptr<Surface>
 {
-    RecursiveReadLock lg(guard);
-    for (auto const& layer : in_reverse(surface_layers))
-    {
-        for (auto const& surface : in_reverse(layer))
-        {
-            // TODO There's a lack of clarity about how the input area will
-            // TODO be maintained and whether this test will detect clicks on
-            // TODO decorations (it should) as these may be outside the area
-            // TODO known to the client.  But it works for now.
-            if (surface_can_be_shown(surface) && surface->input_area_contains(cursor))
-                    return surface;
-        }
-    }
-
-    return {};
+    auto const current = snapshot.load();
+    return input_index.surface_at(
+        cursor,
+        [&current](Surface const& surface) { return current->can_be_shown(surface); });
 }
 
 auto ms::SurfaceStack::input_surface_at(geometry::Point point) const -> std::shared_ptr<input::Surface>
@@ -370,6 +420,9 @@ void ms::SurfaceStack::raise(Surface const* surface)
                 break;
             }
         }
+
+        if (!affected_surfaces.empty())
+            publish_snapshot();
     }
 
     if (affected_surfaces.empty())
@@ -378,6 +431,7 @@ void ms::SurfaceStack::raise(Surface const* surface)
     }
     else
     {
+        extents.restacked(affected_surfaces);
         observers.surfaces_reordered(affected_surfaces);
     }
 
@@ -417,10 +471,14 @@ void ms::SurfaceStack::raise(SurfaceSet const& ss)
             if (old_layer != layer)
                 surfaces_reordered = true;
         }
+
+        if (surfaces_reordered)
+            publish_snapshot();
     }
 
     if (surfaces_reordered)
     {
+        extents.restacked(ss);
         observers.surfaces_reordered(ss);
     }
 }
@@ -483,8 +541,12 @@ void ms::SurfaceStack::swap_z_order(SurfaceSet const& first, SurfaceSet const& s
                     return to_back.count(s2) == 0;
             });
         }
+
+        publish_snapshot();
     }
 
+    extents.restacked(first);
+    extents.restacked(second);
     observers.surfaces_reordered(first);
     observers.surfaces_reordered(second);
 }
@@ -517,10 +579,14 @@ void ms::SurfaceStack::send_to_back(const mir::scene::SurfaceSet &ss)
                 surfaces_reordered = true;
             }
         }
+
+        if (surfaces_reordered)
+            publish_snapshot();
     }
 
     if (surfaces_reordered)
     {
+        extents.restacked(ss);
         observers.surfaces_reordered(ss);
     }
 }
@@ -550,9 +616,32 @@ void ms::SurfaceStack::insert_surface_at_top_of_depth_layer(std::shared_ptr<Surf
     surface_layers[depth_index].push_back(surface);
 }
 
-auto ms::SurfaceStack::surface_can_be_shown(std::shared_ptr<Surface> const& surface) const -> bool
+void ms::SurfaceStack::publish_snapshot()
+{
+    auto next = std::make_shared<Snapshot>();
+
+    std::vector<std::shared_ptr<Surface>> stacking_order;
+    for (auto const& layer : surface_layers)
+        stacking_order.insert(stacking_order.end(), layer.begin(), layer.end());
+
+    next->surfaces.reserve(stacking_order.size());
+    for (auto const& surface : stacking_order)
+    {
+        auto const tracker = rendering_trackers.find(surface.get());
+        assert(tracker != rendering_trackers.end());
+        next->surfaces.push_back({surface, tracker->second});
+    }
+    next->overlays = overlays;
+    next->screen_lock = screen_lock_handle;
+
+    input_index.restack(stacking_order);
+    snapshot.store(std::move(next));
+}
+
+auto ms::SurfaceStack::Snapshot::can_be_shown(Surface const& surface) const -> bool
 {
-    return screen_lock_handle.expired() || surface->visible_on_lock_screen();
+    // The lock expiring needs no new snapshot, as it is checked each time
+    return screen_lock.expired() || surface.visible_on_lock_screen();
 }
 
 void ms::SurfaceStack::add_observer(std::shared_ptr<ms::Observer> const& observer)
@@ -658,6 +747,7 @@ auto ms::SurfaceStack::lock_screen() -> std::unique_ptr<mf::ScreenLockHandle>
         {
             screen_lock_handle = shared = std::make_shared<SharedScreenLock>(shared_from_this());
             is_new = true;
+            publish_snapshot();
         }
     }
     if (is_new)
@@ -697,6 +787,12 @@ void ms::Observers::scene_changed()
         { observer->scene_changed(); });
 }
 
+void ms::Observers::scene_damaged(geometry::Rectangle const& damage)
+{
+   for_each([&](std::shared_ptr<Observer> const& observer)
+        { observer->scene_damaged(damage); });
+}
+
 void ms::Observers::surface_exists(std::shared_ptr<Surface> const& surface)
 {
     for_each([&](std::shared_ptr<Observer> const& observer)
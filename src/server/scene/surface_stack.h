@@ -27,6 +27,8 @@
 
 #include "mir/basic_observers.h"
 #include "mir/scene/surface_observer.h"
+#include "surface_spatial_index.h"
+#include "surface_extents.h"
 
 #include <atomic>
 #include <map>
@@ -57,6 +59,7 @@ public:
    void surface_removed(std::shared_ptr<Surface> const& surface) override;
    void surfaces_reordered(SurfaceSet const& affected_surfaces) override;
    void scene_changed() override;
+   void scene_damaged(geometry::Rectangle const& damage) override;
    void surface_exists(std::shared_ptr<Surface> const& surface) override;
    void end_observation() override;
 
@@ -111,6 +114,7 @@ public:
     void remove_input_visualization(std::weak_ptr<graphics::Renderable> const& overlay) override;
 
     void emit_scene_changed() override;
+    void emit_scene_damage(geometry::Rectangle const& damage) override;
 
 private:
     SurfaceStack(const SurfaceStack&) = delete;
@@ -118,11 +122,35 @@ private:
     void create_rendering_tracker_for(std::shared_ptr<Surface> const&);
     void update_rendering_tracker_compositors();
     void insert_surface_at_top_of_depth_layer(std::shared_ptr<Surface> const& surface);
-    auto surface_can_be_shown(std::shared_ptr<Surface> const& surface) const -> bool;
 
     struct SharedScreenLock;
     struct BasicScreenLockHandle;
 
+    /**
+     * An immutable copy of the parts of the stack read while compositing and dispatching input
+     *
+     * A new Snapshot is published (with guard held for writing) whenever the stack is changed, so
+     * compositor and input threads can read a consistent stack without waiting for the shell.
+     */
+    struct Snapshot
+    {
+        struct Entry
+        {
+            std::shared_ptr<Surface> surface;
+            std::shared_ptr<RenderingTracker> tracker;
+        };
+
+        /// All surfaces on all depth layers (bottom to top)
+        std::vector<Entry> surfaces;
+        std::vector<std::shared_ptr<graphics::Renderable>> overlays;
+        std::weak_ptr<SharedScreenLock> screen_lock;
+
+        auto can_be_shown(Surface const& surface) const -> bool;
+    };
+
+    /// Must be called with guard held for writing
+    void publish_snapshot();
+
     RecursiveReadWriteMutex mutable guard;
 
     std::shared_ptr<SceneReport> const report;
@@ -144,7 +172,13 @@ private:
     /// If not expired the screen is locked (and only surfaces that appear on the lock screen should be shown)
     std::weak_ptr<SharedScreenLock> screen_lock_handle;
     std::atomic<bool> scene_changed;
+    /// Where each surface may accept input; kept up to date by surface_observer
+    SurfaceSpatialIndex input_index;
+    /// Where each surface is drawn, so moves, resizes and restacking only damage those areas
+    SurfaceExtents extents;
     std::shared_ptr<SurfaceObserver> surface_observer;
+
+    std::atomic<std::shared_ptr<Snapshot const>> snapshot;
 };
 
 }
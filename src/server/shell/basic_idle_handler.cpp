@@ -85,6 +85,16 @@ public:
         return false;
     }
 
+    auto damage() const -> geom::Rectangles override
+    {
+        return {screen_position()};
+    }
+
+    auto opaque_region() const -> geom::Rectangles override
+    {
+        return {screen_position()};
+    }
+
 private:
     std::shared_ptr<mg::Buffer> const buffer_;
 };
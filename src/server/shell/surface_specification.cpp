@@ -30,7 +30,8 @@ auto msh::operator==(StreamSpecification const& lhs, StreamSpecification const&
     return
         lhs.stream.lock() == rhs.stream.lock() &&
         lhs.displacement == rhs.displacement &&
-        lhs.size == rhs.size;
+        lhs.size == rhs.size &&
+        lhs.opaque_region == rhs.opaque_region;
 }
 
 auto msh::operator==(StreamCursor const& lhs, StreamCursor const& rhs) -> bool
@@ -26,6 +26,7 @@
 #include "mir/emergency_cleanup_registry.h"
 #include "mir/udev/wrapper.h"
 #include "mir/test/doubles/null_console_services.h"
+#include "mir/test/doubles/mock_display_report.h"
 
 namespace mg = mir::graphics;
 namespace mtd = mir::test::doubles;
@@ -132,7 +133,8 @@ TEST_P(RenderingPlatformTest, DISABLED_supports_gl_rendering)
             device,
             {},            // Hopefully the platform can handle not pre-linking with a DisplayPlatform
             empty_options,
-            emergency_cleanup);
+            emergency_cleanup,
+            std::make_shared<NiceMock<mtd::MockDisplayReport>>());
 
         auto const provider = platform->acquire_provider<mg::GLRenderingProvider>(nullptr);
         EXPECT_THAT(provider, testing::NotNull());
@@ -618,6 +618,12 @@ public:
     {
     }
 
+    void seat_keymap_cache_updated(
+        uint64_t /*compilations*/,
+        uint64_t /*shm_bytes*/) override
+    {
+    }
+
 private:
     Mutex<std::unordered_map<std::chrono::nanoseconds, std::shared_ptr<mir::test::Signal>>> expected_events;
     TestWlcsDisplayServer& runner;
@@ -98,11 +98,29 @@ public:
         return std::optional<geometry::Rectangle>();
     }
 
+    geometry::Rectangles damage() const override
+    {
+        return {rect};
+    }
+
+    geometry::Rectangles opaque_region() const override
+    {
+        if (rectangular)
+            return {rect};
+        return opaque;
+    }
+
+    void set_opaque_region(geometry::Rectangles const& region)
+    {
+        opaque = region;
+    }
+
 private:
     std::shared_ptr<graphics::Buffer> buf;
     mir::geometry::Rectangle rect;
     float opacity;
     bool rectangular;
+    geometry::Rectangles opaque;
 };
 
 } // namespace doubles
@@ -41,6 +41,10 @@ public:
                  void(compositor::CompositorReport::SubCompositorId));
     MOCK_METHOD1(finished_frame,
                  void(compositor::CompositorReport::SubCompositorId));
+    MOCK_METHOD1(skipped_frame,
+                 void(compositor::CompositorReport::SubCompositorId));
+    MOCK_METHOD2(snapshot_allocations,
+                 void(compositor::CompositorReport::SubCompositorId, unsigned long));
     MOCK_METHOD0(started, void());
     MOCK_METHOD0(stopped, void());
     MOCK_METHOD0(scheduled, void());
@@ -43,6 +43,7 @@ public:
     MOCK_METHOD(bool, overlay, (std::vector<graphics::DisplayElement> const&), (override));
     MOCK_METHOD(void, set_next_image, (std::unique_ptr<graphics::Framebuffer>), (override));
     MOCK_METHOD(glm::mat2, transformation, (), (const override));
+    MOCK_METHOD(graphics::Frame, last_frame, (), (const override));
     MOCK_METHOD(graphics::DisplayAllocator*, maybe_create_allocator, (graphics::DisplayAllocator::Tag const&), (override));
 };
 
@@ -26,6 +26,7 @@
 #include <xf86drm.h>
 #include <xf86drmMode.h>
 #include <unordered_map>
+#include <vector>
 
 namespace mir
 {
@@ -52,6 +53,12 @@ public:
                        geometry::Size const& physical_size,
                        drmModeSubPixel subpixel_arrangement = DRM_MODE_SUBPIXEL_UNKNOWN);
 
+    /// Adds a plane with a "type" property of DRM_PLANE_TYPE_*
+    void add_plane(uint32_t plane_id, uint32_t possible_crtcs_mask, uint64_t type,
+                   std::vector<uint32_t> const& formats);
+    /// \returns The id of the property, which is shared by every object with a property of that name
+    uint32_t add_property(uint32_t object_id, char const* name, uint64_t value);
+
     void prepare();
     void reset();
 
@@ -59,6 +66,13 @@ public:
     drmModeEncoder* find_encoder(uint32_t id);
     drmModeConnector* find_connector(uint32_t id);
 
+    /// nullptr if no planes have been added, as for a kernel without plane support
+    drmModePlaneRes* plane_resources_ptr();
+    drmModePlane* find_plane(uint32_t id);
+    /// nullptr for objects without fake properties
+    drmModeObjectProperties* find_object_properties(uint32_t id);
+    drmModePropertyRes* find_property(uint32_t id);
+
     enum ModePreference {NormalMode, PreferredMode};
     static drmModeModeInfo create_mode(uint16_t hdisplay, uint16_t vdisplay,
                                        uint32_t clock, uint16_t htotal, uint16_t vtotal,
@@ -80,6 +94,20 @@ private:
     std::vector<drmModeModeInfo> modes;
     std::vector<drmModeModeInfo> modes_empty;
     std::vector<uint32_t> connector_encoder_ids;
+
+    struct FakeObjectProperties
+    {
+        std::vector<uint32_t> ids;
+        std::vector<uint64_t> values;
+        drmModeObjectProperties properties;
+    };
+
+    drmModePlaneRes plane_resources;
+    std::vector<drmModePlane> planes;
+    std::vector<std::vector<uint32_t>> plane_formats;
+    std::vector<uint32_t> plane_ids;
+    std::unordered_map<uint32_t, FakeObjectProperties> object_properties;
+    std::vector<drmModePropertyRes> properties;
 };
 
 class MockDRM
@@ -102,6 +130,9 @@ public:
     MOCK_METHOD8(drmModeSetCrtc, int(int fd, uint32_t crtcId, uint32_t bufferId,
                                      uint32_t x, uint32_t y, uint32_t *connectors,
                                      int count, drmModeModeInfoPtr mode));
+    MOCK_METHOD(int, drmModeSetPlane, (int fd, uint32_t plane_id, uint32_t crtc_id, uint32_t fb_id, uint32_t flags,
+                                       int32_t crtc_x, int32_t crtc_y, uint32_t crtc_w, uint32_t crtc_h,
+                                       uint32_t src_x, uint32_t src_y, uint32_t src_w, uint32_t src_h));
 
     MOCK_METHOD1(drmModeFreeResources, void(drmModeResPtr ptr));
     MOCK_METHOD1(drmModeFreeConnector, void(drmModeConnectorPtr ptr));
@@ -131,6 +162,16 @@ public:
     MOCK_METHOD3(drmSetClientCap, int(int fd, uint64_t capability, uint64_t value));
     MOCK_METHOD2(drmModeGetProperty, drmModePropertyPtr(int fd, uint32_t propertyId));
     MOCK_METHOD1(drmModeFreeProperty, void(drmModePropertyPtr));
+    MOCK_METHOD(drmModePropertyBlobPtr, drmModeGetPropertyBlob, (int fd, uint32_t blob_id));
+    MOCK_METHOD(void, drmModeFreePropertyBlob, (drmModePropertyBlobPtr));
+    MOCK_METHOD(int, drmModeCreatePropertyBlob, (int fd, void const* data, size_t size, uint32_t* id));
+    MOCK_METHOD(int, drmModeDestroyPropertyBlob, (int fd, uint32_t id));
+
+    MOCK_METHOD(drmModeAtomicReqPtr, drmModeAtomicAlloc, ());
+    MOCK_METHOD(void, drmModeAtomicFree, (drmModeAtomicReqPtr req));
+    MOCK_METHOD(int, drmModeAtomicAddProperty,
+                (drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value));
+    MOCK_METHOD(int, drmModeAtomicCommit, (int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data));
     MOCK_METHOD4(drmModeConnectorSetProperty, int(int fd, uint32_t connector_id, uint32_t property_id, uint64_t value));
 
     MOCK_METHOD2(drmGetMagic, int(int fd, drm_magic_t *magic));
@@ -175,6 +216,17 @@ public:
         uint32_t encoder_id,
         uint32_t crtc_id,
         uint32_t possible_crtcs_mask);
+    void add_plane(
+        char const* device,
+        uint32_t plane_id,
+        uint32_t possible_crtcs_mask,
+        uint64_t type,
+        std::vector<uint32_t> const& formats);
+    uint32_t add_property(
+        char const* device,
+        uint32_t object_id,
+        char const* name,
+        uint64_t value);
     void add_connector(
         char const* device,
         uint32_t connector_id,
@@ -219,6 +271,7 @@ private:
 
     std::map<std::unique_ptr<char[]>, size_t, TransparentUPtrComparator> mmapings;
     drmModeObjectProperties empty_object_props;
+    char fake_atomic_request;
     mir_test_framework::OpenHandlerHandle const open_interposer;
     mir_test_framework::MmapHandlerHandle const mmap_interposer;
     mir_test_framework::MunmapHandlerHandle const munmap_interposer;
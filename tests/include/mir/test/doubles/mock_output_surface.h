@@ -29,6 +29,8 @@ public:
     MOCK_METHOD(void, bind, (), (override));
     MOCK_METHOD(void, make_current, (), (override));
     MOCK_METHOD(void, release_current, (), (override));
+    MOCK_METHOD(int, buffer_age, (), (const override));
+    MOCK_METHOD(void, set_damage, (mir::geometry::Rectangles const&), (override));
     MOCK_METHOD(std::unique_ptr<graphics::Framebuffer>, commit, (), (override));
     MOCK_METHOD(mir::geometry::Size, size, (), (const override));
     MOCK_METHOD(Layout, layout, (), (const override));
@@ -43,6 +43,11 @@ struct MockRenderable : public graphics::Renderable
             .WillByDefault(testing::Return(glm::mat4{}));
         ON_CALL(*this, visible())
             .WillByDefault(testing::Return(true));
+        ON_CALL(*this, damage())
+            .WillByDefault(testing::Invoke([this]() { return geometry::Rectangles{screen_position()}; }));
+        ON_CALL(*this, opaque_region())
+            .WillByDefault(testing::Invoke(
+                [this]() { return shaped() ? geometry::Rectangles{} : geometry::Rectangles{screen_position()}; }));
     }
 
     MOCK_CONST_METHOD0(id, ID());
@@ -53,6 +58,9 @@ struct MockRenderable : public graphics::Renderable
     MOCK_CONST_METHOD0(transformation, glm::mat4());
     MOCK_CONST_METHOD0(visible, bool());
     MOCK_CONST_METHOD0(shaped, bool());
+    MOCK_CONST_METHOD0(damage, geometry::Rectangles());
+    MOCK_CONST_METHOD0(opaque_region, geometry::Rectangles());
+    MOCK_CONST_METHOD0(visible_region, std::optional<geometry::Rectangles>());
 };
 }
 }
@@ -32,8 +32,11 @@ struct MockRenderer : public renderer::Renderer
 {
     MOCK_METHOD(void, set_viewport, (geometry::Rectangle const&));
     MOCK_METHOD(void, set_output_transform, (glm::mat2 const&));
+    MOCK_METHOD(void, set_damage, (geometry::Rectangles const&));
     MOCK_METHOD(std::unique_ptr<graphics::Framebuffer>, render, (graphics::RenderableList const&), (const override));
     MOCK_METHOD(void, suspend, ());
+    MOCK_METHOD(void, retain_frames, (bool), (override));
+    MOCK_METHOD(std::shared_ptr<graphics::Buffer>, last_frame, (), (const override));
 
     ~MockRenderer() noexcept {}
 };
@@ -41,6 +41,7 @@ public:
     MOCK_METHOD2(seat_set_cursor_position, void(float /*cursor_x*/, float /*cursor_y*/));
     MOCK_METHOD1(seat_set_confinement_region_called, void(geometry::Rectangles const& /*regions*/));
     MOCK_METHOD0(seat_reset_confinement_regions, void());
+    MOCK_METHOD2(seat_keymap_cache_updated, void(uint64_t /*compilations*/, uint64_t /*shm_bytes*/));
 };
 
 }
@@ -88,6 +88,14 @@ public:
     {
         return false;
     }
+    geometry::Rectangles damage() const override
+    {
+        return {rect};
+    }
+    geometry::Rectangles opaque_region() const override
+    {
+        return {rect};
+    }
 private:
     std::shared_ptr<graphics::Buffer> make_stub_buffer(geometry::Rectangle const& rect)
     {
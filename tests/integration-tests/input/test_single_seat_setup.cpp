@@ -18,6 +18,7 @@
 #include "src/server/input/basic_seat.h"
 #include "src/server/input/config_changer.h"
 #include "src/server/scene/broadcasting_session_event_sink.h"
+#include "src/server/report/null_report_factory.h"
 
 #include "mir/test/doubles/mock_input_device.h"
 #include "mir/test/doubles/mock_input_device_observer.h"
@@ -129,7 +130,7 @@ struct SingleSeatInputDeviceHubSetup : ::testing::Test
     mi::BasicSeat seat{mt::fake_shared(mock_dispatcher),      mt::fake_shared(mock_visualizer),
                        mt::fake_shared(mock_cursor_listener), mt::fake_shared(display_config),
                        mt::fake_shared(key_mapper),           mt::fake_shared(clock),
-                       mt::fake_shared(mock_seat_observer)};
+                       mt::fake_shared(mock_seat_observer),   mir::report::null_input_report()};
     mi::DefaultInputDeviceHub hub{
         mt::fake_shared(seat),
         mt::fake_shared(multiplexer),
@@ -34,12 +34,18 @@
 #include "mir/test/doubles/stub_buffer_allocator.h"
 #include "mir/test/doubles/mock_gl_buffer.h"
 #include "mir/test/doubles/mock_output_surface.h"
+#include "mir/test/doubles/mock_presentation_observer.h"
 #include "mir/test/doubles/stub_gl_rendering_provider.h"
 #include "mir/test/doubles/null_gl_config.h"
 #include "mir/test/doubles/stub_buffer_allocator.h"
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <iostream>
 #include <mutex>
+#include <random>
+#include <thread>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
@@ -184,6 +190,8 @@ struct SurfaceStackCompositor : public Test
     std::shared_ptr<ms::SceneReport> null_scene_report{mr::null_scene_report()};
     ms::SurfaceStack stack{null_scene_report};
     std::shared_ptr<mc::CompositorReport> null_comp_report{mr::null_compositor_report()};
+    std::shared_ptr<mc::PresentationObserver> null_presentation_observer{
+        std::make_shared<NiceMock<mtd::MockPresentationObserver>>()};
     StubRendererFactory renderer_factory;
     std::chrono::system_clock::time_point timeout;
     std::shared_ptr<mc::Stream> stream;
@@ -222,7 +230,7 @@ TEST_F(SurfaceStackCompositor, composes_on_start_if_told_to_in_constructor_when_
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
-        null_comp_report, default_delay, true);
+        null_comp_report, null_presentation_observer, default_delay, true);
     mt_compositor.start();
 
     EXPECT_TRUE(stub_primary_db.has_posted_at_least(1, timeout));
@@ -236,7 +244,7 @@ TEST_F(SurfaceStackCompositor, does_not_compose_on_start_if_told_to_in_construct
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
-        null_comp_report, default_delay, true);
+        null_comp_report, null_presentation_observer, default_delay, true);
     mt_compositor.start();
 
     EXPECT_TRUE(stub_primary_db.has_posted_at_least(0, timeout));
@@ -250,7 +258,7 @@ TEST_F(SurfaceStackCompositor, does_not_composes_on_start_if_told_not_to_in_cons
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
-        null_comp_report, default_delay, false);
+        null_comp_report, null_presentation_observer, default_delay, false);
     mt_compositor.start();
 
     EXPECT_TRUE(stub_primary_db.has_posted_at_least(0, timeout));
@@ -264,7 +272,7 @@ TEST_F(SurfaceStackCompositor, swapping_a_surface_that_has_been_added_triggers_a
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
-        null_comp_report, default_delay, false);
+        null_comp_report, null_presentation_observer, default_delay, false);
     mt_compositor.start();
 
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
@@ -290,7 +298,7 @@ TEST_F(SurfaceStackCompositor, compositor_runs_until_all_surfaces_buffers_are_co
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
-        null_comp_report, default_delay, false);
+        null_comp_report, null_presentation_observer, default_delay, false);
     mt_compositor.start();
 
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
@@ -320,7 +328,7 @@ TEST_F(SurfaceStackCompositor, bypassed_compositor_runs_until_all_surfaces_buffe
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
-        null_comp_report, default_delay, false);
+        null_comp_report, null_presentation_observer, default_delay, false);
     mt_compositor.start();
 
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
@@ -338,7 +346,7 @@ TEST_F(SurfaceStackCompositor, an_empty_scene_retriggers)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
-        null_comp_report, default_delay, false);
+        null_comp_report, null_presentation_observer, default_delay, false);
     mt_compositor.start();
 
     stack.add_surface(stub_surface, mi::InputReceptionMode::normal);
@@ -363,7 +371,7 @@ TEST_F(SurfaceStackCompositor, moving_a_surface_triggers_composition)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
-        null_comp_report, default_delay, false);
+        null_comp_report, null_presentation_observer, default_delay, false);
 
     mt_compositor.start();
     stub_surface->move_to(geom::Point{1,1});
@@ -385,7 +393,7 @@ TEST_F(SurfaceStackCompositor, removing_a_surface_triggers_composition)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
-        null_comp_report, default_delay, false);
+        null_comp_report, null_presentation_observer, default_delay, false);
 
     mt_compositor.start();
     stack.remove_surface(stub_surface);
@@ -404,7 +412,7 @@ TEST_F(SurfaceStackCompositor, buffer_updates_trigger_composition)
         mt::fake_shared(stack),
         mt::fake_shared(dbc_factory),
         mt::fake_shared(stub_display_listener),
-        null_comp_report, default_delay, false);
+        null_comp_report, null_presentation_observer, default_delay, false);
 
     mt_compositor.start();
     streams.front().stream->submit_buffer(stub_buffer);
@@ -412,3 +420,84 @@ TEST_F(SurfaceStackCompositor, buffer_updates_trigger_composition)
     EXPECT_TRUE(stub_primary_db.has_posted_at_least(1, timeout));
     EXPECT_TRUE(stub_secondary_db.has_posted_at_least(1, timeout));
 }
+
+// Not a pass/fail benchmark: reports how long compositor threads wait to start a frame during a window management storm
+TEST_F(SurfaceStackCompositor, compositor_threads_start_frames_during_shell_mutations)
+{
+    using namespace std::chrono;
+
+    int const surface_count{32};
+    int const compositor_count{4};
+    auto const storm_duration = milliseconds{500};
+
+    std::vector<std::shared_ptr<ms::Surface>> surfaces;
+    for (int i = 0; i != surface_count; ++i)
+    {
+        surfaces.push_back(std::make_shared<ms::BasicSurface>(
+            nullptr /* session */,
+            mw::Weak<mf::WlSurface>{},
+            std::string("storm"),
+            geom::Rectangle{{i, i}, {100, 100}},
+            mir_pointer_unconfined,
+            streams,
+            std::shared_ptr<mg::CursorImage>(),
+            null_scene_report));
+        stack.add_surface(surfaces.back(), mi::InputReceptionMode::normal);
+    }
+
+    std::atomic<bool> storm_over{false};
+    std::vector<std::vector<steady_clock::duration>> frame_start_latencies(compositor_count);
+    std::vector<std::thread> compositors;
+    for (auto& latencies : frame_start_latencies)
+    {
+        compositors.emplace_back(
+            [&, id = static_cast<mc::CompositorID>(&latencies)]
+            {
+                stack.register_compositor(id);
+                while (!storm_over)
+                {
+                    auto const frame_start = steady_clock::now();
+                    stack.frames_pending(id);
+                    auto const elements = stack.scene_elements_for(id);
+                    latencies.push_back(steady_clock::now() - frame_start);
+                }
+                stack.unregister_compositor(id);
+            });
+    }
+
+    std::mt19937 random;
+    std::uniform_int_distribution<size_t> any_surface{0, surfaces.size() - 1};
+    auto const storm_end = steady_clock::now() + storm_duration;
+    while (steady_clock::now() < storm_end)
+    {
+        auto const& first = surfaces[any_surface(random)];
+        auto const& second = surfaces[any_surface(random)];
+
+        stack.raise(first);
+        stack.swap_z_order({first}, {second});
+        stack.remove_surface(second);
+        stack.add_surface(second, mi::InputReceptionMode::normal);
+        stack.surface_at({50, 50});
+    }
+    storm_over = true;
+
+    for (auto& compositor : compositors)
+        compositor.join();
+
+    std::vector<steady_clock::duration> all_latencies;
+    for (auto const& latencies : frame_start_latencies)
+    {
+        EXPECT_THAT(latencies, Not(IsEmpty()));
+        all_latencies.insert(all_latencies.end(), latencies.begin(), latencies.end());
+    }
+    ASSERT_THAT(all_latencies, Not(IsEmpty()));
+
+    auto const p99 = all_latencies.begin() + (all_latencies.size() * 99) / 100;
+    std::nth_element(all_latencies.begin(), p99, all_latencies.end());
+    auto const p99_us = duration_cast<microseconds>(*p99).count();
+
+    RecordProperty("frames_started", static_cast<int>(all_latencies.size()));
+    RecordProperty("p99_frame_start_latency_us", static_cast<int>(p99_us));
+    std::cout << "Started " << all_latencies.size() << " frames on " << compositor_count
+              << " compositor threads, p99 frame start latency " << p99_us << "us" << std::endl;
+}
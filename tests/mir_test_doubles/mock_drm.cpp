@@ -20,6 +20,8 @@
 #include "mir/geometry/size.h"
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 #include <unistd.h>
 #include <dlfcn.h>
@@ -32,10 +34,13 @@ namespace geom = mir::geometry;
 namespace
 {
 mtd::MockDRM* global_mock = nullptr;
+
+uint32_t const first_property_id{40};
 }
 
 mtd::FakeDRMResources::FakeDRMResources()
-    : pipe_fds{-1, -1}
+    : pipe_fds{-1, -1},
+      plane_resources()
 {
     /* Use the read end of a pipe as the fake DRM fd */
     if (pipe(pipe_fds) < 0 || pipe_fds[0] < 0)
@@ -99,6 +104,11 @@ drmModeRes* mtd::FakeDRMResources::resources_ptr()
 
 void mtd::FakeDRMResources::prepare()
 {
+    crtc_ids.clear();
+    encoder_ids.clear();
+    connector_ids.clear();
+    plane_ids.clear();
+
     resources.count_crtcs = crtcs.size();
     for (auto const& crtc: crtcs)
         crtc_ids.push_back(crtc.crtc_id);
@@ -113,6 +123,21 @@ void mtd::FakeDRMResources::prepare()
     for (auto const& connector: connectors)
         connector_ids.push_back(connector.connector_id);
     resources.connectors = connector_ids.data();
+
+    for (auto i = 0u; i < planes.size(); ++i)
+    {
+        planes[i].formats = plane_formats[i].data();
+        plane_ids.push_back(planes[i].plane_id);
+    }
+    plane_resources.count_planes = plane_ids.size();
+    plane_resources.planes = plane_ids.data();
+
+    for (auto& [id, object] : object_properties)
+    {
+        object.properties.count_props = object.ids.size();
+        object.properties.props = object.ids.data();
+        object.properties.prop_values = object.values.data();
+    }
 }
 
 void mtd::FakeDRMResources::reset()
@@ -126,6 +151,13 @@ void mtd::FakeDRMResources::reset()
     crtc_ids.clear();
     encoder_ids.clear();
     connector_ids.clear();
+
+    plane_resources = drmModePlaneRes();
+    planes.clear();
+    plane_formats.clear();
+    plane_ids.clear();
+    object_properties.clear();
+    properties.clear();
 }
 
 void mtd::FakeDRMResources::add_crtc(uint32_t id, drmModeModeInfo mode)
@@ -176,6 +208,77 @@ void mtd::FakeDRMResources::add_connector(uint32_t connector_id,
     connectors.push_back(connector);
 }
 
+void mtd::FakeDRMResources::add_plane(
+    uint32_t plane_id,
+    uint32_t possible_crtcs_mask,
+    uint64_t type,
+    std::vector<uint32_t> const& formats)
+{
+    drmModePlane plane = drmModePlane();
+
+    plane.plane_id = plane_id;
+    plane.possible_crtcs = possible_crtcs_mask;
+    plane.count_formats = formats.size();
+
+    planes.push_back(plane);
+    plane_formats.push_back(formats);
+
+    add_property(plane_id, "type", type);
+}
+
+uint32_t mtd::FakeDRMResources::add_property(uint32_t object_id, char const* name, uint64_t value)
+{
+    auto property = std::find_if(
+        properties.begin(), properties.end(),
+        [name](drmModePropertyRes const& property) { return strcmp(property.name, name) == 0; });
+
+    if (property == properties.end())
+    {
+        drmModePropertyRes new_property = drmModePropertyRes();
+        new_property.prop_id = first_property_id + properties.size();
+        strncpy(new_property.name, name, DRM_PROP_NAME_LEN - 1);
+        properties.push_back(new_property);
+        property = properties.end() - 1;
+    }
+
+    auto& object = object_properties[object_id];
+    object.ids.push_back(property->prop_id);
+    object.values.push_back(value);
+
+    return property->prop_id;
+}
+
+drmModePlaneRes* mtd::FakeDRMResources::plane_resources_ptr()
+{
+    return planes.empty() ? nullptr : &plane_resources;
+}
+
+drmModePlane* mtd::FakeDRMResources::find_plane(uint32_t id)
+{
+    for (auto& plane : planes)
+    {
+        if (plane.plane_id == id)
+            return &plane;
+    }
+    return nullptr;
+}
+
+drmModeObjectProperties* mtd::FakeDRMResources::find_object_properties(uint32_t id)
+{
+    auto const object = object_properties.find(id);
+    return object != object_properties.end() ? &object->second.properties : nullptr;
+}
+
+drmModePropertyRes* mtd::FakeDRMResources::find_property(uint32_t id)
+{
+    for (auto& property : properties)
+    {
+        if (property.prop_id == id)
+            return &property;
+    }
+    return nullptr;
+}
+
 drmModeCrtc* mtd::FakeDRMResources::find_crtc(uint32_t id)
 {
     for (auto& crtc : crtcs)
@@ -332,8 +435,53 @@ mtd::MockDRM::MockDRM()
                     return fd_to_drm.at(fd).find_connector(connector_id);
                 }));
 
+    ON_CALL(*this, drmModeGetPlaneResources(_))
+        .WillByDefault(
+            Invoke(
+                [this](int fd) -> drmModePlaneResPtr
+                {
+                    auto const drm = fd_to_drm.find(fd);
+                    return drm != fd_to_drm.end() ? drm->second.plane_resources_ptr() : nullptr;
+                }));
+
+    ON_CALL(*this, drmModeGetPlane(_, _))
+        .WillByDefault(
+            Invoke(
+                [this](int fd, uint32_t plane_id) -> drmModePlanePtr
+                {
+                    auto const drm = fd_to_drm.find(fd);
+                    return drm != fd_to_drm.end() ? drm->second.find_plane(plane_id) : nullptr;
+                }));
+
     ON_CALL(*this, drmModeObjectGetProperties(_, _, _))
-        .WillByDefault(Return(&empty_object_props));
+        .WillByDefault(
+            Invoke(
+                [this](int fd, uint32_t id, uint32_t) -> drmModeObjectPropertiesPtr
+                {
+                    auto const drm = fd_to_drm.find(fd);
+                    if (drm != fd_to_drm.end())
+                    {
+                        if (auto const properties = drm->second.find_object_properties(id))
+                            return properties;
+                    }
+                    return &empty_object_props;
+                }));
+
+    ON_CALL(*this, drmModeGetProperty(_, _))
+        .WillByDefault(
+            Invoke(
+                [this](int fd, uint32_t property_id) -> drmModePropertyPtr
+                {
+                    auto const drm = fd_to_drm.find(fd);
+                    return drm != fd_to_drm.end() ? drm->second.find_property(property_id) : nullptr;
+                }));
+
+    // drmModeAtomicReq is opaque, so any pointer will do
+    ON_CALL(*this, drmModeAtomicAlloc())
+        .WillByDefault(Return(reinterpret_cast<drmModeAtomicReqPtr>(&fake_atomic_request)));
+    // drmModeAtomicAddProperty() returns the number of properties in the request
+    ON_CALL(*this, drmModeAtomicAddProperty(_, _, _, _))
+        .WillByDefault(Return(1));
 
     ON_CALL(*this, drmSetInterfaceVersion(_, _))
         .WillByDefault(
@@ -437,6 +585,21 @@ void mtd::MockDRM::add_encoder(
     fake_drms[device].add_encoder(encoder_id, crtc_id, possible_crtcs_mask);
 }
 
+void mtd::MockDRM::add_plane(
+    char const* device,
+    uint32_t plane_id,
+    uint32_t possible_crtcs_mask,
+    uint64_t type,
+    std::vector<uint32_t> const& formats)
+{
+    fake_drms[device].add_plane(plane_id, possible_crtcs_mask, type, formats);
+}
+
+uint32_t mtd::MockDRM::add_property(char const* device, uint32_t object_id, char const* name, uint64_t value)
+{
+    return fake_drms[device].add_property(object_id, name, value);
+}
+
 void mtd::MockDRM::prepare(char const *device)
 {
     fake_drms[device].prepare();
@@ -629,6 +792,45 @@ int drmModeCrtcSetGamma(int fd, uint32_t crtc_id, uint32_t size, gamma_t red, ga
     return global_mock->drmModeCrtcSetGamma(fd, crtc_id, size, red, green, blue);
 }
 
+int drmModeSetPlane(int fd, uint32_t plane_id, uint32_t crtc_id, uint32_t fb_id, uint32_t flags,
+                    int32_t crtc_x, int32_t crtc_y, uint32_t crtc_w, uint32_t crtc_h,
+                    uint32_t src_x, uint32_t src_y, uint32_t src_w, uint32_t src_h)
+{
+    return global_mock->drmModeSetPlane(fd, plane_id, crtc_id, fb_id, flags,
+                                        crtc_x, crtc_y, crtc_w, crtc_h,
+                                        src_x, src_y, src_w, src_h);
+}
+
+drmModeAtomicReqPtr drmModeAtomicAlloc()
+{
+    return global_mock->drmModeAtomicAlloc();
+}
+
+void drmModeAtomicFree(drmModeAtomicReqPtr req)
+{
+    global_mock->drmModeAtomicFree(req);
+}
+
+int drmModeAtomicAddProperty(drmModeAtomicReqPtr req, uint32_t object_id, uint32_t property_id, uint64_t value)
+{
+    return global_mock->drmModeAtomicAddProperty(req, object_id, property_id, value);
+}
+
+int drmModeAtomicCommit(int fd, drmModeAtomicReqPtr req, uint32_t flags, void* user_data)
+{
+    return global_mock->drmModeAtomicCommit(fd, req, flags, user_data);
+}
+
+int drmModeCreatePropertyBlob(int fd, void const* data, size_t size, uint32_t* id)
+{
+    return global_mock->drmModeCreatePropertyBlob(fd, data, size, id);
+}
+
+int drmModeDestroyPropertyBlob(int fd, uint32_t id)
+{
+    return global_mock->drmModeDestroyPropertyBlob(fd, id);
+}
+
 void drmModeFreeResources(drmModeResPtr ptr)
 {
     global_mock->drmModeFreeResources(ptr);
@@ -664,6 +866,16 @@ drmModePropertyPtr drmModeGetProperty(int fd, uint32_t propertyId)
     return global_mock->drmModeGetProperty(fd, propertyId);
 }
 
+drmModePropertyBlobPtr drmModeGetPropertyBlob(int fd, uint32_t blob_id)
+{
+    return global_mock->drmModeGetPropertyBlob(fd, blob_id);
+}
+
+void drmModeFreePropertyBlob(drmModePropertyBlobPtr ptr)
+{
+    global_mock->drmModeFreePropertyBlob(ptr);
+}
+
 int drmModeConnectorSetProperty(int fd, uint32_t connector_id, uint32_t property_id, uint64_t value)
 {
     return global_mock->drmModeConnectorSetProperty(fd, connector_id, property_id, value);
@@ -57,7 +57,7 @@ public:
             mg::probe::unsupported,
             nullptr
         };
-        stub_render_platform = create_stub_render_platform(device, {}, mo::ProgramOption{}, null_cleanup);
+        stub_render_platform = create_stub_render_platform(device, {}, mo::ProgramOption{}, null_cleanup, nullptr);
         stub_display_platform = create_stub_display_platform(device, nullptr, nullptr, nullptr, nullptr);
     }
 
@@ -185,7 +185,8 @@ mir::UniqueModulePtr<mg::RenderingPlatform> create_rendering_platform(
     mg::SupportedDevice const&,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const&,
     mo::Option const&,
-    mir::EmergencyCleanupRegistry&)
+    mir::EmergencyCleanupRegistry&,
+    std::shared_ptr<mg::DisplayReport> const&)
 {
     mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
     return mir::make_module_ptr<ExceptionThrowingPlatform>();
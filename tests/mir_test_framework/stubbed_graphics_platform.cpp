@@ -155,7 +155,8 @@ mir::UniqueModulePtr<mg::RenderingPlatform> create_rendering_platform(
     mg::SupportedDevice const&,
     std::vector<std::shared_ptr<mg::DisplayPlatform>> const&,
     mo::Option const&,
-    mir::EmergencyCleanupRegistry&)
+    mir::EmergencyCleanupRegistry&,
+    std::shared_ptr<mg::DisplayReport> const&)
 {
     mir::assert_entry_point_signature<mg::CreateRenderPlatform>(&create_rendering_platform);
 
@@ -0,0 +1,106 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MIR_TEST_HEADLESS_GL_CONTEXT_H_
+#define MIR_TEST_HEADLESS_GL_CONTEXT_H_
+
+#include "mir/graphics/egl_extensions.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+namespace mir
+{
+namespace test
+{
+/**
+ * A GLES2 context without any window system, such as Mesa's llvmpipe provides. It is current while it exists.
+ *
+ * Converts to false if there's no such context to be had, for the benchmarks using it to skip.
+ */
+class HeadlessContext
+{
+public:
+    HeadlessContext()
+    {
+        // Without a usable GPU driver (as on many build machines) there's nothing to measure
+        if (!graphics::has_egl_client_extension("EGL_MESA_platform_surfaceless"))
+            return;
+
+        auto const get_platform_display =
+            reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (!get_platform_display)
+            return;
+
+        display_ = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display_ == EGL_NO_DISPLAY || !eglInitialize(display_, nullptr, nullptr) || !eglBindAPI(EGL_OPENGL_ES_API))
+            return;
+
+        if (!graphics::has_egl_extension(display_, "EGL_KHR_surfaceless_context"))
+            return;
+
+        context = create_context(EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT && !eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        {
+            eglDestroyContext(display_, context);
+            context = EGL_NO_CONTEXT;
+        }
+    }
+
+    ~HeadlessContext()
+    {
+        if (context != EGL_NO_CONTEXT)
+        {
+            eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(display_, context);
+        }
+        if (display_ != EGL_NO_DISPLAY)
+            eglTerminate(display_);
+    }
+
+    HeadlessContext(HeadlessContext const&) = delete;
+    HeadlessContext& operator=(HeadlessContext const&) = delete;
+
+    explicit operator bool() const
+    {
+        return context != EGL_NO_CONTEXT;
+    }
+
+    auto display() const -> EGLDisplay
+    {
+        return display_;
+    }
+
+    /// A new context sharing objects with this one, for the caller to destroy
+    auto create_shared_context() const -> EGLContext
+    {
+        return create_context(context);
+    }
+
+private:
+    auto create_context(EGLContext share_with) const -> EGLContext
+    {
+        EGLint const attributes[] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
+        return eglCreateContext(display_, EGL_NO_CONFIG_KHR, share_with, attributes);
+    }
+
+    EGLDisplay display_{EGL_NO_DISPLAY};
+    EGLContext context{EGL_NO_CONTEXT};
+};
+}
+}
+
+#endif // MIR_TEST_HEADLESS_GL_CONTEXT_H_
@@ -0,0 +1,89 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/pooled_allocator.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+
+namespace
+{
+struct SceneElement
+{
+    std::array<char, 64> state{};
+};
+
+int const compositors{4};
+int const frames{2000};
+int const elements_per_frame{50};
+
+/// Has each of the compositors build and release a frame's worth of elements, frames times
+auto time_to_composite(std::function<mir::BlockPool::Arena&(int compositor)> const& arena_for)
+    -> std::chrono::steady_clock::duration
+{
+    auto const start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int compositor = 0; compositor != compositors; ++compositor)
+    {
+        threads.emplace_back([&arena = arena_for(compositor)]
+            {
+                std::vector<std::shared_ptr<SceneElement>> elements;
+                elements.reserve(elements_per_frame);
+                for (int frame = 0; frame != frames; ++frame)
+                {
+                    for (int i = 0; i != elements_per_frame; ++i)
+                        elements.push_back(mir::make_pooled<SceneElement>(arena));
+                    elements.clear();
+                }
+            });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    return std::chrono::steady_clock::now() - start;
+}
+}
+
+// The timings are recorded in the test output (--gtest_output=xml) for comparison between builds
+TEST(BlockPoolPerformance, compositors_allocating_concurrently)
+{
+    mir::BlockPool shared_pool;
+    auto const one_arena = time_to_composite(
+        [&](int) -> mir::BlockPool::Arena& { return shared_pool.arena_for(nullptr); });
+
+    mir::BlockPool keyed_pool;
+    std::array<int, compositors> compositor_ids{};
+    auto const arena_per_compositor = time_to_composite(
+        [&](int compositor) -> mir::BlockPool::Arena& { return keyed_pool.arena_for(&compositor_ids[compositor]); });
+
+    auto const per_frame = [](std::chrono::steady_clock::duration total)
+        {
+            return std::to_string(std::chrono::duration_cast<std::chrono::nanoseconds>(total).count() / frames);
+        };
+    RecordProperty("nanoseconds_per_frame_sharing_one_arena", per_frame(one_arena));
+    RecordProperty("nanoseconds_per_frame_with_arena_per_compositor", per_frame(arena_per_compositor));
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "headless_gl_context.h"
+#include "src/renderers/gl/renderer.h"
+#include "mir/graphics/buffer.h"
+#include "mir/graphics/platform.h"
+#include "mir/graphics/program_factory.h"
+#include "mir/graphics/texture.h"
+#include "mir/renderer/gl/gl_surface.h"
+
+#include <GLES2/gl2.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace testing;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Size const output_size{1280, 720};
+
+/// Renders into a renderbuffer, and waits for the GPU at the end of each frame
+class RenderbufferSurface : public mg::gl::OutputSurface
+{
+public:
+    explicit RenderbufferSurface(geom::Size size)
+        : size_{size}
+    {
+        glGenFramebuffers(1, &framebuffer);
+        glGenRenderbuffers(1, &renderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA4, size.width.as_int(), size.height.as_int());
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffer);
+    }
+
+    ~RenderbufferSurface()
+    {
+        glDeleteRenderbuffers(1, &renderbuffer);
+        glDeleteFramebuffers(1, &framebuffer);
+    }
+
+    void bind() override { glBindFramebuffer(GL_FRAMEBUFFER, framebuffer); }
+    void make_current() override {}
+    void release_current() override {}
+    auto buffer_age() const -> int override { return 0; }
+    void set_damage(geom::Rectangles const&) override {}
+    auto commit() -> std::unique_ptr<mg::Framebuffer> override { glFinish(); return {}; }
+    auto size() const -> geom::Size override { return size_; }
+    auto layout() const -> Layout override { return Layout::GL; }
+
+private:
+    geom::Size const size_;
+    GLuint framebuffer;
+    GLuint renderbuffer;
+};
+
+class NoiseTexture : public mg::Buffer, public mg::gl::Texture
+{
+public:
+    NoiseTexture(geom::Size size, unsigned seed, bool top_row_first)
+        : size_{size},
+          top_row_first{top_row_first}
+    {
+        // Some texels translucent, so that blending does some work
+        std::vector<uint32_t> texels(size.width.as_int() * size.height.as_int());
+        for (size_t i = 0; i != texels.size(); ++i)
+            texels[i] = (seed * 2654435761u) ^ (i * 40503u) ^ (i % 7 == 0 ? 0x80000000u : 0xff000000u);
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.width.as_int(), size.height.as_int(), 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+    }
+
+    ~NoiseTexture()
+    {
+        glDeleteTextures(1, &texture);
+    }
+
+    auto id() const -> mg::BufferID override { return mg::BufferID{texture}; }
+    auto size() const -> geom::Size override { return size_; }
+    auto pixel_format() const -> MirPixelFormat override { return mir_pixel_format_abgr_8888; }
+    auto native_buffer_base() -> mg::NativeBufferBase* override { return nullptr; }
+
+    auto shader(mg::gl::ProgramFactory& factory) const -> mg::gl::Program const& override
+    {
+        static int const key{0};
+        return factory.compile_fragment_shader(
+            &key,
+            "",
+            "uniform sampler2D tex;\n"
+            "vec4 sample_to_rgba(in vec2 texcoord) { return texture2D(tex, texcoord); }\n");
+    }
+
+    auto layout() const -> Layout override { return top_row_first ? Layout::TopRowFirst : Layout::GL; }
+    void bind() override { glBindTexture(GL_TEXTURE_2D, texture); }
+    void add_syncpoint() override {}
+
+private:
+    geom::Size const size_;
+    bool const top_row_first;
+    GLuint texture;
+};
+
+class TextureProvider : public mg::GLRenderingProvider
+{
+public:
+    auto as_texture(std::shared_ptr<mg::Buffer> buffer) -> std::shared_ptr<mg::gl::Texture> override
+    {
+        return std::dynamic_pointer_cast<NoiseTexture>(buffer);
+    }
+
+    auto surface_for_sink(mg::DisplaySink&, mg::GLConfig const&) -> std::unique_ptr<mg::gl::OutputSurface> override
+    {
+        return {};
+    }
+
+    auto suitability_for_allocator(std::shared_ptr<mg::GraphicBufferAllocator> const&) -> mg::probe::Result override
+    {
+        return mg::probe::supported;
+    }
+
+    auto suitability_for_display(mg::DisplaySink&) -> mg::probe::Result override
+    {
+        return mg::probe::supported;
+    }
+
+    auto make_framebuffer_provider(mg::DisplaySink&) -> std::unique_ptr<FramebufferProvider> override
+    {
+        return {};
+    }
+};
+
+struct SceneRenderable : mg::Renderable
+{
+    auto id() const -> ID override { return this; }
+    auto buffer() const -> std::shared_ptr<mg::Buffer> override { return texture; }
+    auto screen_position() const -> geom::Rectangle override { return position; }
+    auto clip_area() const -> std::optional<geom::Rectangle> override { return clip; }
+    auto alpha() const -> float override { return alpha_; }
+    auto transformation() const -> glm::mat4 override { return transformation_; }
+    auto shaped() const -> bool override { return shaped_; }
+    auto damage() const -> geom::Rectangles override { return {}; }
+    auto opaque_region() const -> geom::Rectangles override { return opaque; }
+
+    std::shared_ptr<NoiseTexture> texture;
+    geom::Rectangle position;
+    std::optional<geom::Rectangle> clip;
+    float alpha_{1.0f};
+    glm::mat4 transformation_{1.0f};
+    bool shaped_{false};
+    geom::Rectangles opaque;
+};
+
+/**
+ * A desktop-sized background under many small surfaces (panels, notifications, decorations)
+ *
+ * The surfaces are a mix of RGBA and RGBX, translucent, clipped, transformed and partly opaque,
+ * drawn from a handful of textures.
+ */
+auto mixed_scene(std::vector<std::shared_ptr<NoiseTexture>> const& textures, int num_renderables)
+    -> mg::RenderableList
+{
+    std::mt19937 random{42};
+    mg::RenderableList renderables;
+
+    auto background = std::make_shared<SceneRenderable>();
+    background->texture = textures.front();
+    background->position = {{0, 0}, output_size};
+    renderables.push_back(background);
+
+    for (int i = 1; i != num_renderables; ++i)
+    {
+        auto renderable = std::make_shared<SceneRenderable>();
+        renderable->texture = textures[random() % textures.size()];
+        renderable->position = {
+            {static_cast<int>(random() % 1200), static_cast<int>(random() % 680)},
+            {static_cast<int>(20 + random() % 100), static_cast<int>(10 + random() % 60)}};
+        renderable->alpha_ = i % 11 == 0 ? 0.75f : 1.0f;
+        if (i % 37 == 0)
+        {
+            renderable->transformation_[0][1] = 0.2f;
+            renderable->transformation_[1][0] = -0.2f;
+        }
+        renderable->shaped_ = i % 2 == 0;
+        if (i % 4 == 0)
+        {
+            auto const& position = renderable->position;
+            renderable->opaque = geom::Rectangles{
+                {position.top_left, {position.size.width, position.size.height.as_int() / 2}}};
+        }
+        if (i % 13 == 0)
+        {
+            renderable->clip = geom::Rectangle{renderable->position.top_left, {10, 10}};
+        }
+        renderables.push_back(renderable);
+    }
+
+    return renderables;
+}
+}
+
+// The per-frame timings are recorded in the test output (--gtest_output=xml) for comparison between builds
+TEST(GLRendererPerformance, frames_of_up_to_500_renderables)
+{
+    mir::test::HeadlessContext const context;
+    if (!context)
+    {
+        GTEST_SKIP() << "No surfaceless EGL display to render with";
+    }
+
+    int const frames{100};
+
+    std::vector<std::shared_ptr<NoiseTexture>> textures;
+    for (unsigned i = 0; i != 16; ++i)
+        textures.push_back(std::make_shared<NoiseTexture>(geom::Size{64, 64}, i, i % 3 == 0));
+
+    for (int const num_renderables : {10, 150, 500})
+    {
+        mir::renderer::gl::Renderer renderer{
+            std::make_shared<TextureProvider>(),
+            std::make_unique<RenderbufferSurface>(output_size)};
+        renderer.set_viewport({{0, 0}, output_size});
+
+        auto const renderables = mixed_scene(textures, num_renderables);
+
+        // The first frame compiles the shaders
+        renderer.render(renderables);
+
+        auto const start = std::chrono::steady_clock::now();
+        for (int i = 0; i != frames; ++i)
+            renderer.render(renderables);
+        auto const total = std::chrono::steady_clock::now() - start;
+
+        ASSERT_THAT(glGetError(), Eq(GLenum{GL_NO_ERROR}));
+
+        auto const per_frame = std::chrono::duration_cast<std::chrono::microseconds>(total) / frames;
+        RecordProperty("microseconds_for_" + std::to_string(num_renderables) + "_renderables",
+                       std::to_string(per_frame.count()));
+    }
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/input/seat_observer.h"
+#include "mir/input/input_device_info.h"
+#include "mir/executor.h"
+#include "mir/observer_registrar.h"
+#include "mir/server.h"
+
+#include "mir_test_framework/headless_in_process_server.h"
+#include "mir_test_framework/input_device_faker.h"
+#include "mir_test_framework/fake_input_device.h"
+#include "mir/test/signal.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mi = mir::input;
+namespace mis = mir::input::synthesis;
+namespace mtf = mir_test_framework;
+
+using namespace std::literals::chrono_literals;
+
+namespace
+{
+auto now() -> std::chrono::nanoseconds
+{
+    return std::chrono::steady_clock::now().time_since_epoch();
+}
+
+/// Records how long each event took from the device to the end of the seat's dispatch
+struct LatencyRecorder : mi::SeatObserver
+{
+    explicit LatencyRecorder(size_t expected)
+        : expected{expected}
+    {
+        latencies.reserve(expected);
+    }
+
+    void seat_dispatch_event(std::shared_ptr<MirEvent const> const& event) override
+    {
+        if (mir_event_get_type(event.get()) != mir_event_type_input)
+            return;
+
+        auto const* const input_event = mir_event_get_input_event(event.get());
+        auto const latency = now() - std::chrono::nanoseconds{mir_input_event_get_event_time(input_event)};
+
+        std::lock_guard lock{mutex};
+        latencies.push_back(latency);
+        if (latencies.size() == expected)
+            all_received.raise();
+    }
+
+    void seat_add_device(uint64_t) override {}
+    void seat_remove_device(uint64_t) override {}
+    void seat_set_key_state(uint64_t, std::vector<uint32_t> const&) override {}
+    void seat_set_pointer_state(uint64_t, unsigned) override {}
+    void seat_set_cursor_position(float, float) override {}
+    void seat_set_confinement_region_called(mir::geometry::Rectangles const&) override {}
+    void seat_reset_confinement_regions() override {}
+    void seat_keymap_cache_updated(uint64_t, uint64_t) override {}
+
+    auto percentile(double p) -> std::chrono::nanoseconds
+    {
+        std::lock_guard lock{mutex};
+        std::sort(latencies.begin(), latencies.end());
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p / 100 * latencies.size()))];
+    }
+
+    size_t const expected;
+    mir::test::Signal all_received;
+
+    std::mutex mutex;
+    std::vector<std::chrono::nanoseconds> latencies;
+};
+
+struct InputPerformance : mtf::HeadlessInProcessServer
+{
+    void SetUp() override
+    {
+        mtf::HeadlessInProcessServer::SetUp();
+        input_device_faker.wait_for_input_devices_added_to(server);
+        server.the_seat_observer_registrar()->register_interest(recorder, mir::immediate_executor);
+    }
+
+    static auto constexpr events = 10'000;
+    static auto constexpr interval = 100us;   // 10kHz, as from a fast gaming mouse
+
+    mtf::InputDeviceFaker input_device_faker;
+    std::unique_ptr<mtf::FakeInputDevice> const fake_pointer{
+        input_device_faker.add_fake_input_device(
+            mi::InputDeviceInfo{"mouse", "mouse-uid", mi::DeviceCapability::pointer})};
+
+    std::shared_ptr<LatencyRecorder> const recorder{std::make_shared<LatencyRecorder>(events)};
+};
+}
+
+TEST_F(InputPerformance, pointer_motion_latency)
+{
+    auto next = std::chrono::steady_clock::now();
+    for (auto i = 0; i != events; ++i)
+    {
+        fake_pointer->emit_event(mis::a_pointer_event().with_movement(1, i % 2 ? 1 : -1).with_event_time(now()));
+        next += interval;
+        std::this_thread::sleep_until(next);
+    }
+
+    ASSERT_TRUE(recorder->all_received.wait_for(30s));
+
+    for (auto const& [name, p] : {std::pair{"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p99.9", 99.9}, {"max", 100.0}})
+    {
+        auto const latency = std::chrono::duration_cast<std::chrono::microseconds>(recorder->percentile(p));
+        std::cout << "Pointer motion latency " << name << ": " << latency.count() << "us" << std::endl;
+        RecordProperty(std::string{"latency_"} + name + "_us", std::to_string(latency.count()));
+    }
+}
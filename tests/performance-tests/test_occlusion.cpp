@@ -0,0 +1,133 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/occlusion.h"
+#include "mir/compositor/scene_element.h"
+#include "mir/test/doubles/fake_renderable.h"
+#include "mir/test/doubles/stub_scene_element.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <string>
+
+using namespace testing;
+using namespace mir::geometry;
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace mtd = mir::test::doubles;
+
+namespace
+{
+Rectangle const monitor_rect{{0, 0}, {1920, 1200}};
+
+/// A desktop-sized window behind a grid of windows that, between them, cover it
+auto tiled_scene(int num_windows) -> std::vector<std::shared_ptr<mg::Renderable>>
+{
+    auto const width = monitor_rect.size.width.as_int();
+    auto const height = monitor_rect.size.height.as_int();
+
+    std::vector<std::shared_ptr<mg::Renderable>> renderables;
+    renderables.push_back(std::make_shared<mtd::FakeRenderable>(monitor_rect));
+
+    int const columns = std::ceil(std::sqrt(num_windows));
+    int const rows = (num_windows + columns - 1) / columns;
+    int const tile_width = (width + columns - 1) / columns;
+    int const tile_height = (height + rows - 1) / rows;
+    for (int i = 0; i != num_windows; ++i)
+    {
+        int const x = (i % columns) * tile_width;
+        int const y = (i / columns) * tile_height;
+        bool const last_in_row = i % columns == columns - 1 || i == num_windows - 1;
+        renderables.push_back(std::make_shared<mtd::FakeRenderable>(
+            x, y, last_in_row ? width - x : tile_width, tile_height));
+    }
+
+    return renderables;
+}
+
+auto scene_elements_from(std::vector<std::shared_ptr<mg::Renderable>> const& renderables) -> mc::SceneElementSequence
+{
+    mc::SceneElementSequence elements;
+    for (auto const& renderable : renderables)
+        elements.push_back(std::make_shared<mtd::StubSceneElement>(renderable));
+
+    return elements;
+}
+}
+
+// The per-scene timings are recorded in the test output (--gtest_output=xml) for comparison between builds
+TEST(OcclusionPerformance, tiled_scenes_of_up_to_500_windows)
+{
+    int const iterations{20};
+
+    for (int const num_windows : {10, 50, 100, 250, 500})
+    {
+        auto const renderables = tiled_scene(num_windows);
+
+        std::chrono::steady_clock::duration total{};
+        for (int i = 0; i != iterations; ++i)
+        {
+            auto elements = scene_elements_from(renderables);
+
+            auto const start = std::chrono::steady_clock::now();
+            auto const& occlusions = mc::filter_occlusions_from(elements, monitor_rect);
+            total += std::chrono::steady_clock::now() - start;
+
+            ASSERT_THAT(occlusions.size(), Eq(1u));
+            ASSERT_THAT(occlusions.front()->renderable(), Eq(renderables.front()));
+            ASSERT_THAT(elements.size(), Eq(static_cast<size_t>(num_windows)));
+        }
+
+        auto const per_scene = std::chrono::duration_cast<std::chrono::microseconds>(total) / iterations;
+        RecordProperty("microseconds_for_" + std::to_string(num_windows) + "_windows",
+                       std::to_string(per_scene.count()));
+    }
+}
+
+// Every window but the top one is partly covered, so the visible regions are worked out too
+TEST(OcclusionPerformance, cascaded_scenes_of_up_to_500_windows)
+{
+    int const iterations{20};
+
+    for (int const num_windows : {10, 50, 100, 250, 500})
+    {
+        std::vector<std::shared_ptr<mg::Renderable>> renderables;
+        for (int i = 0; i != num_windows; ++i)
+        {
+            renderables.push_back(std::make_shared<mtd::FakeRenderable>(i * 3 % 1000, i * 2 % 600, 800, 600));
+        }
+
+        std::chrono::steady_clock::duration total{};
+        for (int i = 0; i != iterations; ++i)
+        {
+            auto elements = scene_elements_from(renderables);
+
+            auto const start = std::chrono::steady_clock::now();
+            mc::filter_occlusions_from(elements, monitor_rect);
+            total += std::chrono::steady_clock::now() - start;
+
+            ASSERT_THAT(elements.back()->renderable()->visible_region(), Eq(std::nullopt));
+        }
+
+        auto const per_scene = std::chrono::duration_cast<std::chrono::microseconds>(total) / iterations;
+        RecordProperty("microseconds_for_" + std::to_string(num_windows) + "_windows",
+                       std::to_string(per_scene.count()));
+    }
+}
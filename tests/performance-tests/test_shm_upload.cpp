@@ -0,0 +1,157 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "headless_gl_context.h"
+#include "src/platforms/common/server/shm_buffer.h"
+#include "mir/graphics/egl_context_executor.h"
+#include "mir/graphics/gl_context_lifetime.h"
+#include "mir/renderer/gl/context.h"
+
+#include <GLES2/gl2.h>
+#include <boost/throw_exception.hpp>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace testing;
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+namespace geom = mir::geometry;
+
+namespace
+{
+geom::Size const client_size{1920, 1080};
+auto const client_format = mir_pixel_format_abgr_8888;
+int const bytes_per_pixel{4};
+
+/// A context of its own for the EGLContextExecutor, sharing with the HeadlessContext
+class SharedContext : public mir::renderer::gl::Context
+{
+public:
+    explicit SharedContext(mir::test::HeadlessContext const& headless)
+        : display{headless.display()},
+          context{headless.create_shared_context()}
+    {
+    }
+
+    ~SharedContext()
+    {
+        eglDestroyContext(display, context);
+    }
+
+    void make_current() const override
+    {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+    }
+
+    void release_current() const override
+    {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+    auto make_share_context() const -> std::unique_ptr<Context> override
+    {
+        BOOST_THROW_EXCEPTION(std::logic_error{"Not needed by the benchmark"});
+    }
+
+    explicit operator EGLContext() override
+    {
+        return context;
+    }
+
+private:
+    EGLDisplay const display;
+    EGLContext const context;
+};
+
+/**
+ * Commits frames of a client's SHM buffer, each reporting \a damage, and binds them as the
+ * compositor would, returning the upload rate in MB/s
+ */
+auto upload_rate(
+    std::shared_ptr<mgc::EGLContextExecutor> const& egl_delegate,
+    geom::Rectangles const& damage,
+    int frames) -> double
+{
+    auto const client_data = std::make_shared<mgc::MemoryBackedShmBuffer>(client_size, client_format, egl_delegate);
+    {
+        auto const mapping = client_data->map_writeable();
+        std::memset(mapping->data(), 0x7f, mapping->len());
+    }
+
+    // The first frame is uploaded in full, as the chain's texture starts out empty
+    auto previous =
+        std::make_shared<mgc::MappableBackedShmBuffer>(client_data, nullptr, geom::Rectangles{}, egl_delegate);
+    previous->bind();
+    glFinish();
+
+    long long damaged_pixels{0};
+    for (auto const& rectangle : damage)
+        damaged_pixels += rectangle.size.width.as_int() * rectangle.size.height.as_int();
+
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i != frames; ++i)
+    {
+        auto const next = std::make_shared<mgc::MappableBackedShmBuffer>(client_data, previous, damage, egl_delegate);
+        next->bind();
+        glFinish();
+        previous = next;
+    }
+    std::chrono::duration<double> const total = std::chrono::steady_clock::now() - start;
+
+    return damaged_pixels * bytes_per_pixel * frames / total.count() / 1e6;
+}
+}
+
+// The rates are recorded in the test output (--gtest_output=xml) for comparison between builds
+TEST(ShmUploadPerformance, full_and_damaged_uploads_of_a_1080p_buffer)
+{
+    mir::test::HeadlessContext const context;
+    if (!context)
+    {
+        GTEST_SKIP() << "No surfaceless EGL display to upload with";
+    }
+
+    int const frames{100};
+    auto const lifetime = std::make_shared<mg::gl::ContextLifetime>();
+
+    {
+        auto const egl_delegate = std::make_shared<mgc::EGLContextExecutor>(std::make_unique<SharedContext>(context));
+        mg::gl::ContextLifetime::Current const in_context{lifetime};
+
+        geom::Rectangles const everything{{{0, 0}, client_size}};
+        // A text cursor blinking, and a line of text being typed
+        geom::Rectangles const typing{{{400, 300}, {2, 20}}, {{100, 300}, {300, 20}}};
+        // A video playing in a quarter of the window
+        geom::Rectangles const video{{{480, 270}, {960, 540}}};
+
+        RecordProperty("full_upload_MB_per_second", std::to_string(upload_rate(egl_delegate, everything, frames)));
+        RecordProperty("typing_damage_MB_per_second", std::to_string(upload_rate(egl_delegate, typing, frames)));
+        RecordProperty("video_damage_MB_per_second", std::to_string(upload_rate(egl_delegate, video, frames)));
+
+        ASSERT_THAT(glGetError(), Eq(GLenum{GL_NO_ERROR}));
+    }
+
+    // The buffers have handed their textures back, to delete in the context that made them
+    lifetime->delete_pending();
+}
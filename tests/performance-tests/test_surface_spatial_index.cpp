@@ -0,0 +1,129 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/surface_spatial_index.h"
+#include "mir/test/doubles/stub_surface.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <ranges>
+#include <string>
+#include <vector>
+
+using namespace testing;
+namespace ms = mir::scene;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+namespace
+{
+struct RectangularSurface : mtd::StubSurface
+{
+    explicit RectangularSurface(geom::Rectangle const& bounds)
+        : bounds{bounds}
+    {
+    }
+
+    geom::Rectangle input_bounds() const override
+    {
+        return bounds;
+    }
+
+    bool input_area_contains(geom::Point const& point) const override
+    {
+        return bounds.contains(point);
+    }
+
+    geom::Rectangle const bounds;
+};
+
+auto random_scene(int num_surfaces) -> std::vector<std::shared_ptr<ms::Surface>>
+{
+    std::mt19937 random;
+    std::uniform_int_distribution<int> position{0, 3840};
+    std::uniform_int_distribution<int> size{20, 400};
+
+    std::vector<std::shared_ptr<ms::Surface>> surfaces;
+    for (int i = 0; i != num_surfaces; ++i)
+    {
+        surfaces.push_back(std::make_shared<RectangularSurface>(
+            geom::Rectangle{{position(random), position(random)}, {size(random), size(random)}}));
+    }
+    return surfaces;
+}
+
+auto random_points(int num_points) -> std::vector<geom::Point>
+{
+    std::mt19937 random{42};
+    std::uniform_int_distribution<int> position{0, 3840};
+
+    std::vector<geom::Point> points;
+    for (int i = 0; i != num_points; ++i)
+        points.emplace_back(position(random), position(random));
+    return points;
+}
+}
+
+// The timings are recorded in the test output (--gtest_output=xml) for comparison between builds
+TEST(SurfaceSpatialIndexPerformance, hit_testing_scenes_of_up_to_500_surfaces)
+{
+    auto const points = random_points(20000);
+
+    for (int const num_surfaces : {10, 50, 100, 250, 500})
+    {
+        auto const surfaces = random_scene(num_surfaces);
+        ms::SurfaceSpatialIndex index;
+        index.restack(surfaces);
+
+        auto const scan_start = std::chrono::steady_clock::now();
+        size_t scanned_hits{0};
+        for (auto const& point : points)
+        {
+            for (auto const& surface : surfaces | std::views::reverse)
+            {
+                if (surface->input_area_contains(point))
+                {
+                    ++scanned_hits;
+                    break;
+                }
+            }
+        }
+        auto const scan_time = std::chrono::steady_clock::now() - scan_start;
+
+        auto const index_start = std::chrono::steady_clock::now();
+        size_t indexed_hits{0};
+        for (auto const& point : points)
+        {
+            if (index.surface_at(point, [](ms::Surface const&) { return true; }))
+                ++indexed_hits;
+        }
+        auto const index_time = std::chrono::steady_clock::now() - index_start;
+
+        ASSERT_THAT(indexed_hits, Eq(scanned_hits));
+
+        auto const microseconds = [](std::chrono::steady_clock::duration d)
+            {
+                return std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+            };
+        auto const suffix = "_for_" + std::to_string(num_surfaces) + "_surfaces";
+        RecordProperty("microseconds_scanning" + suffix, microseconds(scan_time));
+        RecordProperty("microseconds_indexed" + suffix, microseconds(index_time));
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/wayland_executor.h"
+#include "mir/test/auto_unblock_thread.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <wayland-server-core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace std::chrono;
+using namespace std::literals::chrono_literals;
+namespace mt = mir::test;
+namespace mf = mir::frontend;
+
+// The latencies are recorded in the test output (--gtest_output=xml) for comparison between builds
+TEST(WaylandExecutorPerformance, latency_with_concurrent_producers)
+{
+    // 4 producers at 25k tasks/s each, for half a second
+    int const producer_count{4};
+    int const tasks_per_producer{12500};
+    auto const interval = 40us;
+    size_t const total_tasks = producer_count * tasks_per_producer;
+
+    auto const loop = wl_event_loop_create();
+    std::vector<steady_clock::duration> latencies;
+
+    {
+        mf::WaylandExecutor executor{loop};
+
+        // Only touched on the Wayland loop (this thread)
+        latencies.reserve(total_tasks);
+
+        std::vector<mt::AutoJoinThread> producers;
+        for (auto i = 0; i != producer_count; ++i)
+        {
+            producers.emplace_back(
+                mt::AutoJoinThread{
+                    [&executor, &latencies, interval]()
+                    {
+                        auto next = steady_clock::now();
+                        for (auto task = 0; task != tasks_per_producer; ++task)
+                        {
+                            std::this_thread::sleep_until(next);
+                            next += interval;
+
+                            executor.spawn(
+                                [&latencies, spawned = steady_clock::now()]()
+                                {
+                                    latencies.push_back(steady_clock::now() - spawned);
+                                });
+                        }
+                    }});
+        }
+
+        auto const deadline = steady_clock::now() + 60s;
+        while (latencies.size() < total_tasks && steady_clock::now() < deadline)
+        {
+            wl_event_loop_dispatch(loop, 100);
+        }
+    }
+    wl_event_loop_destroy(loop);
+
+    ASSERT_THAT(latencies.size(), Eq(total_tasks));
+
+    std::ranges::sort(latencies);
+    auto const percentile = [&latencies](int p)
+        {
+            return std::to_string(duration_cast<microseconds>(latencies[latencies.size() * p / 100]).count());
+        };
+
+    RecordProperty("latency_p50_us", percentile(50));
+    RecordProperty("latency_p99_us", percentile(99));
+}
@@ -447,6 +447,20 @@ void basic_software_buffer_drawing(
             return std::optional<mir::geometry::Rectangle>{};
         }
 
+        auto damage() const -> mir::geometry::Rectangles override
+        {
+            return {screen_position()};
+        }
+
+        auto opaque_region() const -> mir::geometry::Rectangles override
+        {
+            if (shaped())
+            {
+                return {};
+            }
+            return {screen_position()};
+        }
+
         void set_position(mir::geometry::Point top_left)
         {
             this->top_left = top_left;
@@ -20,6 +20,7 @@
 #include "mir/renderer/gl/gl_surface.h"
 #include "mir/test/doubles/stub_gl_rendering_provider.h"
 #include "src/server/compositor/basic_screen_shooter.h"
+#include "src/server/compositor/composited_frame_store.h"
 
 #include "mir/renderer/renderer_factory.h"
 #include "mir/test/doubles/mock_scene.h"
@@ -105,7 +106,8 @@ struct BasicScreenShooter : Test
             clock,
             executor,
             gl_providers,
-            renderer_factory);
+            renderer_factory,
+            nullptr);
     }
 
     std::unique_ptr<mtd::MockRenderer> next_renderer{std::make_unique<testing::NiceMock<mtd::MockRenderer>>()};
@@ -246,7 +248,8 @@ TEST_F(BasicScreenShooter, ensures_renderer_is_current_on_only_one_thread)
         clock,
         mir::thread_pool_executor,
         gl_providers,
-        renderer_factory);
+        renderer_factory,
+        nullptr);
 
     ON_CALL(*next_renderer, render(_))
         .WillByDefault(
@@ -288,3 +291,189 @@ TEST_F(BasicScreenShooter, ensures_renderer_is_current_on_only_one_thread)
     mir::ThreadPoolExecutor::quiesce();
     EXPECT_THAT(call_count, Eq(expected_call_count));
 }
+
+TEST_F(BasicScreenShooter, renders_only_damage_into_buffer_holding_previous_capture)
+{
+    geom::Rectangle const damage{{25, 35}, {10, 10}};
+    shooter->capture(buffer, viewport_rect, damage, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    InSequence seq;
+    EXPECT_CALL(*next_renderer, set_damage(Eq(geom::Rectangles{damage})));
+    EXPECT_CALL(*next_renderer, render(_));
+    EXPECT_CALL(callback, Call(std::make_optional(clock->now())));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, does_not_set_damage_for_full_capture)
+{
+    shooter->capture(buffer, viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(*next_renderer, set_damage(_)).Times(0);
+    EXPECT_CALL(callback, Call(std::make_optional(clock->now())));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, captures_of_the_same_area_complete_in_order)
+{
+    StrictMock<MockFunction<void(std::optional<mir::time::Timestamp>)>> second_callback;
+
+    shooter->capture(buffer, viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    shooter->capture(buffer, viewport_rect, [&](auto time)
+        {
+            second_callback.Call(time);
+        });
+
+    InSequence seq;
+    EXPECT_CALL(*renderer_factory, create_renderer_for(_, _));
+    EXPECT_CALL(callback, Call(std::make_optional(clock->now())));
+    EXPECT_CALL(second_callback, Call(std::make_optional(clock->now())));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, captures_of_different_areas_use_their_own_renderers)
+{
+    geom::Rectangle const other_rect{{800, 0}, {40, 50}};
+    StrictMock<MockFunction<void(std::optional<mir::time::Timestamp>)>> second_callback;
+
+    EXPECT_CALL(*renderer_factory, create_renderer_for(_, _))
+        .Times(2)
+        .WillRepeatedly(
+            [](auto output_surface, auto) -> std::unique_ptr<mr::Renderer>
+            {
+                auto renderer = std::make_unique<NiceMock<mtd::MockRenderer>>();
+                ON_CALL(*renderer, render(_))
+                    .WillByDefault(
+                        [surface = std::shared_ptr<mg::gl::OutputSurface>(std::move(output_surface))]()
+                        {
+                            return surface->commit();
+                        });
+                return renderer;
+            });
+
+    shooter->capture(buffer, viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    shooter->capture(std::make_shared<mtd::StubBuffer>(geom::Size{800, 600}), other_rect, [&](auto time)
+        {
+            second_callback.Call(time);
+        });
+
+    EXPECT_CALL(callback, Call(std::make_optional(clock->now())));
+    EXPECT_CALL(second_callback, Call(std::make_optional(clock->now())));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooter, dma_buf_capture_fails_gracefully_when_unsupported)
+{
+    ON_CALL(*gl_provider, suitability_for_display(_))
+        .WillByDefault(
+            [](mg::DisplaySink& sink)
+            {
+                return sink.acquire_compatible_allocator<mg::CPUAddressableDisplayAllocator>() ?
+                    mg::probe::supported : mg::probe::unsupported;
+            });
+    auto const cpu_only_shooter = std::make_unique<mc::BasicScreenShooter>(
+        scene,
+        clock,
+        executor,
+        gl_providers,
+        renderer_factory,
+        nullptr);
+
+    EXPECT_FALSE(cpu_only_shooter->supports_dma_buf_targets());
+
+    cpu_only_shooter->capture(std::shared_ptr<mg::DMABufBuffer>{}, viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+    EXPECT_CALL(callback, Call(nullopt_time));
+    executor.execute();
+}
+
+namespace
+{
+struct BasicScreenShooterWithCompositedFrames : BasicScreenShooter
+{
+    BasicScreenShooterWithCompositedFrames()
+    {
+        shooter = std::make_unique<mc::BasicScreenShooter>(
+            scene,
+            clock,
+            executor,
+            gl_providers,
+            renderer_factory,
+            composited_frames);
+    }
+
+    std::shared_ptr<mc::CompositedFrameStore> const composited_frames{
+        std::make_shared<mc::CompositedFrameStore>(scene, clock)};
+    geom::Rectangle const output_area{{0, 0}, {1920, 1080}};
+    std::shared_ptr<mtd::StubBuffer> const composited_frame{std::make_shared<mtd::StubBuffer>(output_area.size)};
+    int const output_compositor{0};
+};
+
+MATCHER_P(IsOnlyBuffer, buffer, "")
+{
+    return arg.size() == 1 && arg.front()->buffer() == buffer;
+}
+}
+
+TEST_F(BasicScreenShooterWithCompositedFrames, draws_composited_frame_instead_of_scene)
+{
+    composited_frames->drawing(&output_compositor, output_area);
+    composited_frames->store(&output_compositor, *gl_provider, output_area, composited_frame);
+    auto const composited_time = clock->now();
+    clock->advance_by(1s);
+
+    shooter->capture(buffer, viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+
+    EXPECT_CALL(*scene, scene_elements_for(_)).Times(0);
+    EXPECT_CALL(*next_renderer, set_viewport(Eq(viewport_rect)));
+    EXPECT_CALL(*next_renderer, render(IsOnlyBuffer(composited_frame)));
+    EXPECT_CALL(callback, Call(std::make_optional(composited_time)));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooterWithCompositedFrames, draws_scene_when_composited_frame_is_out_of_date)
+{
+    composited_frames->drawing(&output_compositor, output_area);
+    composited_frames->store(&output_compositor, *gl_provider, output_area, composited_frame);
+    ON_CALL(*scene, frames_pending(_)).WillByDefault(Return(1));
+
+    shooter->capture(buffer, viewport_rect, [&](auto time)
+        {
+            callback.Call(time);
+        });
+
+    EXPECT_CALL(*scene, scene_elements_for(_)).WillOnce(Return(scene_elements));
+    EXPECT_CALL(*next_renderer, render(Eq(renderables)));
+    EXPECT_CALL(callback, Call(std::make_optional(clock->now())));
+    executor.execute();
+}
+
+TEST_F(BasicScreenShooterWithCompositedFrames, draws_scene_when_area_is_not_all_on_one_output)
+{
+    composited_frames->drawing(&output_compositor, output_area);
+    composited_frames->store(&output_compositor, *gl_provider, output_area, composited_frame);
+
+    shooter->capture(buffer, {{1900, 0}, {40, 50}}, [&](auto time)
+        {
+            callback.Call(time);
+        });
+
+    EXPECT_CALL(*scene, scene_elements_for(_)).WillOnce(Return(scene_elements));
+    EXPECT_CALL(*next_renderer, render(Eq(renderables)));
+    EXPECT_CALL(callback, Call(std::make_optional(clock->now())));
+    executor.execute();
+}
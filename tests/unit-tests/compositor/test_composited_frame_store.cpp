@@ -0,0 +1,207 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/composited_frame_store.h"
+
+#include "mir/scene/observer.h"
+#include "mir/test/doubles/mock_scene.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/stub_buffer.h"
+#include "mir/test/doubles/stub_gl_rendering_provider.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mc = mir::compositor;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct CompositedFrameStore : Test
+{
+    CompositedFrameStore()
+    {
+        EXPECT_THAT(scene_observer, NotNull());
+    }
+
+    /// Stores a frame of area, as a compositor does once it has drawn it
+    void composite(
+        mc::CompositorID id,
+        geom::Rectangle const& area,
+        std::shared_ptr<mtd::StubBuffer> const& frame)
+    {
+        store.drawing(id, area);
+        store.store(id, provider, area, frame);
+    }
+
+    std::shared_ptr<mtd::MockScene> const scene{std::make_shared<NiceMock<mtd::MockScene>>()};
+    std::shared_ptr<mtd::AdvanceableClock> const clock{std::make_shared<mtd::AdvanceableClock>()};
+    std::shared_ptr<mir::scene::Observer> scene_observer;
+    mc::CompositedFrameStore store{
+        [this]
+        {
+            ON_CALL(*scene, add_observer(_)).WillByDefault(SaveArg<0>(&scene_observer));
+            return scene;
+        }(),
+        clock};
+
+    mtd::StubGlRenderingProvider provider;
+    geom::Rectangle const left_output{{0, 0}, {1920, 1080}};
+    geom::Rectangle const right_output{{1920, 0}, {1280, 1024}};
+    std::shared_ptr<mtd::StubBuffer> const left_frame{std::make_shared<mtd::StubBuffer>(left_output.size)};
+    std::shared_ptr<mtd::StubBuffer> const right_frame{std::make_shared<mtd::StubBuffer>(right_output.size)};
+    int const left_compositor{0};
+    int const right_compositor{0};
+    geom::Rectangle const on_left_output{{10, 10}, {100, 100}};
+};
+}
+
+TEST_F(CompositedFrameStore, has_no_frames_initially)
+{
+    EXPECT_THAT(store.frame_containing(left_output), Eq(std::nullopt));
+}
+
+TEST_F(CompositedFrameStore, finds_frame_of_output_containing_area)
+{
+    composite(&left_compositor, left_output, left_frame);
+    auto const composited = clock->now();
+    clock->advance_by(1s);
+    composite(&right_compositor, right_output, right_frame);
+
+    auto const frame = store.frame_containing({{10, 10}, {100, 100}});
+
+    ASSERT_THAT(frame, Ne(std::nullopt));
+    EXPECT_THAT(frame->buffer, Eq(left_frame));
+    EXPECT_THAT(frame->area, Eq(left_output));
+    EXPECT_THAT(frame->provider, Eq(&provider));
+    EXPECT_THAT(frame->composited, Eq(composited));
+}
+
+TEST_F(CompositedFrameStore, finds_no_frame_for_area_spanning_outputs)
+{
+    composite(&left_compositor, left_output, left_frame);
+    composite(&right_compositor, right_output, right_frame);
+
+    EXPECT_THAT(store.frame_containing({{1900, 0}, {40, 40}}), Eq(std::nullopt));
+}
+
+TEST_F(CompositedFrameStore, replaces_frame_of_the_same_compositor)
+{
+    auto const next_frame = std::make_shared<mtd::StubBuffer>(left_output.size);
+
+    composite(&left_compositor, left_output, left_frame);
+    composite(&left_compositor, left_output, next_frame);
+
+    auto const frame = store.frame_containing(left_output);
+    ASSERT_THAT(frame, Ne(std::nullopt));
+    EXPECT_THAT(frame->buffer, Eq(next_frame));
+}
+
+TEST_F(CompositedFrameStore, forgets_frame_when_compositor_has_none)
+{
+    composite(&left_compositor, left_output, left_frame);
+    composite(&left_compositor, left_output, nullptr);
+
+    EXPECT_THAT(store.frame_containing(left_output), Eq(std::nullopt));
+}
+
+TEST_F(CompositedFrameStore, forgets_frame_of_removed_compositor)
+{
+    composite(&left_compositor, left_output, left_frame);
+    store.remove(&left_compositor);
+
+    EXPECT_THAT(store.frame_containing(left_output), Eq(std::nullopt));
+}
+
+TEST_F(CompositedFrameStore, offers_no_frame_while_its_compositor_has_frames_pending)
+{
+    composite(&left_compositor, left_output, left_frame);
+
+    EXPECT_CALL(*scene, frames_pending(Eq(&left_compositor))).WillRepeatedly(Return(1));
+
+    EXPECT_THAT(store.frame_containing(left_output), Eq(std::nullopt));
+}
+
+TEST_F(CompositedFrameStore, offers_no_frame_once_the_scene_is_damaged_within_it)
+{
+    composite(&left_compositor, left_output, left_frame);
+    composite(&right_compositor, right_output, right_frame);
+
+    scene_observer->scene_damaged({{1930, 10}, {10, 10}});
+
+    EXPECT_THAT(store.frame_containing(on_left_output), Ne(std::nullopt));
+    EXPECT_THAT(store.frame_containing({{1930, 10}, {10, 10}}), Eq(std::nullopt));
+}
+
+TEST_F(CompositedFrameStore, offers_no_frames_once_the_scene_has_changed)
+{
+    composite(&left_compositor, left_output, left_frame);
+
+    scene_observer->scene_changed();
+
+    EXPECT_THAT(store.frame_containing(on_left_output), Eq(std::nullopt));
+}
+
+TEST_F(CompositedFrameStore, offers_no_frames_once_surfaces_are_added_removed_or_reordered)
+{
+    composite(&left_compositor, left_output, left_frame);
+    scene_observer->surface_added(nullptr);
+    EXPECT_THAT(store.frame_containing(on_left_output), Eq(std::nullopt));
+
+    composite(&left_compositor, left_output, left_frame);
+    scene_observer->surface_removed(nullptr);
+    EXPECT_THAT(store.frame_containing(on_left_output), Eq(std::nullopt));
+
+    composite(&left_compositor, left_output, left_frame);
+    scene_observer->surfaces_reordered({});
+    EXPECT_THAT(store.frame_containing(on_left_output), Eq(std::nullopt));
+}
+
+TEST_F(CompositedFrameStore, offers_no_frame_if_the_scene_changed_while_it_was_drawn)
+{
+    store.drawing(&left_compositor, left_output);
+    scene_observer->scene_damaged({{10, 10}, {10, 10}});
+    store.store(&left_compositor, provider, left_output, left_frame);
+
+    EXPECT_THAT(store.frame_containing(on_left_output), Eq(std::nullopt));
+}
+
+TEST_F(CompositedFrameStore, offers_frame_drawn_after_the_scene_changed)
+{
+    composite(&left_compositor, left_output, left_frame);
+    scene_observer->scene_changed();
+
+    composite(&left_compositor, left_output, left_frame);
+
+    EXPECT_THAT(store.frame_containing(on_left_output), Ne(std::nullopt));
+}
+
+TEST_F(CompositedFrameStore, stops_observing_the_scene_when_destroyed)
+{
+    auto const local_scene = std::make_shared<NiceMock<mtd::MockScene>>();
+    std::shared_ptr<mir::scene::Observer> observer;
+    EXPECT_CALL(*local_scene, add_observer(_)).WillOnce(SaveArg<0>(&observer));
+
+    auto local_store = std::make_unique<mc::CompositedFrameStore>(local_scene, clock);
+
+    EXPECT_CALL(*local_scene, remove_observer(_)).WillOnce(Invoke(
+        [&](std::weak_ptr<mir::scene::Observer> const& removed) { EXPECT_THAT(removed.lock(), Eq(observer)); }));
+    local_store.reset();
+}
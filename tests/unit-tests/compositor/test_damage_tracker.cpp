@@ -0,0 +1,181 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/compositor/damage_tracker.h"
+#include "mir/test/doubles/stub_buffer.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace mc = mir::compositor;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+
+namespace
+{
+class TrackedRenderable : public mg::Renderable
+{
+public:
+    TrackedRenderable(geom::Rectangle const& position)
+        : position{position}
+    {
+    }
+
+    ID id() const override { return this; }
+    std::shared_ptr<mg::Buffer> buffer() const override { return buf; }
+    geom::Rectangle screen_position() const override { return position; }
+    std::optional<geom::Rectangle> clip_area() const override { return clip; }
+    float alpha() const override { return opacity; }
+    glm::mat4 transformation() const override { return transform; }
+    bool shaped() const override { return false; }
+    geom::Rectangles damage() const override { return buffer_damage; }
+    geom::Rectangles opaque_region() const override { return {position}; }
+
+    void submit(geom::Rectangles const& damage)
+    {
+        buf = std::make_shared<mtd::StubBuffer>();
+        buffer_damage = damage;
+    }
+
+    std::shared_ptr<mg::Buffer> buf{std::make_shared<mtd::StubBuffer>()};
+    geom::Rectangle position;
+    std::optional<geom::Rectangle> clip;
+    float opacity{1.0f};
+    glm::mat4 transform{1};
+    geom::Rectangles buffer_damage;
+};
+
+struct DamageTracker : Test
+{
+    geom::Rectangle const view_area{{0, 0}, {1920, 1080}};
+    std::shared_ptr<TrackedRenderable> const background{std::make_shared<TrackedRenderable>(view_area)};
+    std::shared_ptr<TrackedRenderable> const window{std::make_shared<TrackedRenderable>(geom::Rectangle{{100, 100}, {200, 100}})};
+    mc::DamageTracker tracker;
+};
+}
+
+TEST_F(DamageTracker, damage_of_first_frame_is_unknown)
+{
+    EXPECT_THAT(tracker.damage_for({background, window}, view_area), Eq(std::nullopt));
+}
+
+TEST_F(DamageTracker, unchanged_frame_has_no_damage)
+{
+    tracker.damage_for({background, window}, view_area);
+
+    EXPECT_THAT(tracker.damage_for({background, window}, view_area), Optional(geom::Rectangles{}));
+}
+
+TEST_F(DamageTracker, new_buffer_damages_what_the_renderable_reports)
+{
+    tracker.damage_for({background, window}, view_area);
+
+    window->submit({{{110, 120}, {10, 10}}});
+
+    EXPECT_THAT(
+        tracker.damage_for({background, window}, view_area),
+        Optional(geom::Rectangles{{{110, 120}, {10, 10}}}));
+}
+
+TEST_F(DamageTracker, buffer_damage_is_clipped_to_the_renderable)
+{
+    window->clip = geom::Rectangle{{100, 100}, {50, 50}};
+    tracker.damage_for({background, window}, view_area);
+
+    window->submit({window->position});
+
+    EXPECT_THAT(
+        tracker.damage_for({background, window}, view_area),
+        Optional(geom::Rectangles{{{100, 100}, {50, 50}}}));
+}
+
+TEST_F(DamageTracker, moving_damages_old_and_new_positions)
+{
+    tracker.damage_for({background, window}, view_area);
+
+    window->position = {{200, 300}, {200, 100}};
+
+    EXPECT_THAT(
+        tracker.damage_for({background, window}, view_area),
+        Optional(geom::Rectangles{{{100, 100}, {200, 100}}, {{200, 300}, {200, 100}}}));
+}
+
+TEST_F(DamageTracker, appearing_and_disappearing_damage_the_area_covered)
+{
+    tracker.damage_for({background}, view_area);
+
+    EXPECT_THAT(tracker.damage_for({background, window}, view_area), Optional(geom::Rectangles{window->position}));
+    EXPECT_THAT(tracker.damage_for({background}, view_area), Optional(geom::Rectangles{window->position}));
+}
+
+TEST_F(DamageTracker, changing_alpha_damages_the_renderable)
+{
+    tracker.damage_for({background, window}, view_area);
+
+    window->opacity = 0.5f;
+
+    EXPECT_THAT(
+        tracker.damage_for({background, window}, view_area),
+        Optional(geom::Rectangles{window->position, window->position}));
+}
+
+TEST_F(DamageTracker, restacking_damages_the_renderable_now_on_top)
+{
+    auto const other = std::make_shared<TrackedRenderable>(geom::Rectangle{{150, 150}, {200, 100}});
+    tracker.damage_for({background, window, other}, view_area);
+
+    EXPECT_THAT(
+        tracker.damage_for({background, other, window}, view_area),
+        Optional(geom::Rectangles{window->position}));
+}
+
+TEST_F(DamageTracker, damage_is_clipped_to_the_view_area)
+{
+    tracker.damage_for({background}, view_area);
+
+    window->position = {{1900, 1000}, {200, 100}};
+
+    EXPECT_THAT(
+        tracker.damage_for({background, window}, view_area),
+        Optional(geom::Rectangles{{{1900, 1000}, {20, 80}}}));
+}
+
+TEST_F(DamageTracker, damage_is_unknown_after_view_area_changes)
+{
+    tracker.damage_for({background, window}, view_area);
+
+    EXPECT_THAT(tracker.damage_for({background, window}, {{0, 0}, {1280, 1024}}), Eq(std::nullopt));
+}
+
+TEST_F(DamageTracker, damage_is_unknown_with_transformed_renderables)
+{
+    window->transform = glm::mat4{2};
+    tracker.damage_for({background, window}, view_area);
+
+    EXPECT_THAT(tracker.damage_for({background, window}, view_area), Eq(std::nullopt));
+}
+
+TEST_F(DamageTracker, damage_is_unknown_after_reset)
+{
+    tracker.damage_for({background, window}, view_area);
+
+    tracker.reset();
+
+    EXPECT_THAT(tracker.damage_for({background, window}, view_area), Eq(std::nullopt));
+}
@@ -15,6 +15,7 @@
  */
 
 #include "src/server/compositor/default_display_buffer_compositor.h"
+#include "src/server/compositor/composited_frame_store.h"
 #include "src/server/report/null_report_factory.h"
 #include "mir/compositor/scene.h"
 #include "mir/renderer/renderer.h"
@@ -26,10 +27,15 @@
 #include "mir/test/doubles/mock_compositor_report.h"
 #include "mir/test/doubles/stub_scene_element.h"
 #include "mir/test/doubles/stub_gl_rendering_provider.h"
+#include "mir/test/doubles/stub_buffer.h"
+#include "mir/test/doubles/mock_scene.h"
+#include "mir/test/doubles/advanceable_clock.h"
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 namespace mg = mir::graphics;
 namespace mc = mir::compositor;
 namespace geom = mir::geometry;
@@ -77,6 +83,53 @@ auto make_scene_elements(std::initializer_list<std::shared_ptr<mg::Renderable>>
     return elements;
 }
 
+// Partly hidden renderables are wrapped to carry their visible region, so compare IDs
+MATCHER_P(RenderablesMatching, expected, "")
+{
+    return std::ranges::equal(arg, expected, [](auto const& a, auto const& b) { return a->id() == b->id(); });
+}
+
+struct StubFramebuffer : mg::Framebuffer
+{
+    auto size() const -> geom::Size override
+    {
+        return {};
+    }
+};
+
+/// Has a framebuffer for every buffer, so each frame is offered to the display sink as overlays
+struct ScanoutGlRenderingProvider : mtd::StubGlRenderingProvider
+{
+    auto make_framebuffer_provider(mg::DisplaySink&) -> std::unique_ptr<FramebufferProvider> override
+    {
+        class StubFramebufferProvider : public FramebufferProvider
+        {
+        public:
+            auto buffer_to_framebuffer(std::shared_ptr<mg::Buffer>) -> std::unique_ptr<mg::Framebuffer> override
+            {
+                return std::make_unique<StubFramebuffer>();
+            }
+        };
+        return std::make_unique<StubFramebufferProvider>();
+    }
+};
+
+struct ClippedRenderable : mtd::FakeRenderable
+{
+    ClippedRenderable(geom::Rectangle const& position, geom::Rectangle const& clip)
+        : FakeRenderable{position},
+          clip{clip}
+    {
+    }
+
+    auto clip_area() const -> std::optional<geom::Rectangle> override
+    {
+        return clip;
+    }
+
+    geom::Rectangle const clip;
+};
+
 struct DefaultDisplayBufferCompositor : public testing::Test
 {
     DefaultDisplayBufferCompositor()
@@ -111,7 +164,8 @@ TEST_F(DefaultDisplayBufferCompositor, composite_returns_false_when_scene_elemen
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        nullptr);
     EXPECT_FALSE(compositor.composite(make_scene_elements({})));
 }
 
@@ -123,7 +177,8 @@ TEST_F(DefaultDisplayBufferCompositor, composite_returns_true_when_scene_element
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        nullptr);
     EXPECT_TRUE(compositor.composite(make_scene_elements({big})));
 }
 
@@ -135,7 +190,8 @@ TEST_F(DefaultDisplayBufferCompositor, renderer_is_suspended_when_we_have_compos
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        nullptr);
     compositor.composite(make_scene_elements({big}));
     compositor.composite(make_scene_elements({}));
 
@@ -146,6 +202,30 @@ TEST_F(DefaultDisplayBufferCompositor, renderer_is_suspended_when_we_have_compos
     compositor.composite(make_scene_elements({}));
 }
 
+TEST_F(DefaultDisplayBufferCompositor, frame_is_zero_copy_only_when_display_sink_takes_it_as_an_overlay)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        nullptr);
+
+    compositor.composite(make_scene_elements({big}));
+    EXPECT_FALSE(compositor.last_frame_was_zero_copy());
+
+    EXPECT_CALL(display_sink, overlay(_))
+        .WillOnce(Return(true))
+        .WillOnce(Return(false));
+    compositor.composite(make_scene_elements({}));
+    EXPECT_TRUE(compositor.last_frame_was_zero_copy());
+
+    compositor.composite(make_scene_elements({}));
+    EXPECT_FALSE(compositor.last_frame_was_zero_copy());
+}
+
 TEST_F(DefaultDisplayBufferCompositor, all_expected_reports_are_received_during_composite)
 {
     using namespace testing;
@@ -165,21 +245,23 @@ TEST_F(DefaultDisplayBufferCompositor, all_expected_reports_are_received_during_
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        report);
+        report,
+        nullptr);
     compositor.composite(make_scene_elements({big}));
 }
 
 TEST_F(DefaultDisplayBufferCompositor, elements_provided_to_composite_are_rendered_in_order)
 {
     using namespace testing;
-    EXPECT_CALL(mock_renderer, render(ContainerEq(mg::RenderableList{big, small})))
+    EXPECT_CALL(mock_renderer, render(RenderablesMatching(mg::RenderableList{big, small})))
         .Times(1);
 
     mc::DefaultDisplayBufferCompositor compositor(
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        nullptr);
 
     compositor.composite(make_scene_elements({
         big,
@@ -187,6 +269,44 @@ TEST_F(DefaultDisplayBufferCompositor, elements_provided_to_composite_are_render
     }));
 }
 
+TEST_F(DefaultDisplayBufferCompositor, renderer_is_not_given_damage_for_the_first_frame)
+{
+    using namespace testing;
+    EXPECT_CALL(mock_renderer, set_damage(_))
+        .Times(0);
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        nullptr);
+
+    compositor.composite(make_scene_elements({big, small}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, renderer_is_given_damage_of_renderables_with_new_buffers)
+{
+    using namespace testing;
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        nullptr);
+
+    compositor.composite(make_scene_elements({big, small}));
+
+    small->set_buffer(std::make_shared<mtd::StubBuffer>());
+
+    InSequence seq;
+    EXPECT_CALL(mock_renderer, set_damage(geom::Rectangles{small->screen_position()}));
+    EXPECT_CALL(mock_renderer, render(_));
+
+    compositor.composite(make_scene_elements({big, small}));
+}
+
 TEST_F(DefaultDisplayBufferCompositor, viewport_is_rotated_when_display_sink_view_area_is_rotated)
 {   // Regression test for LP: #1643488
     using namespace testing;
@@ -205,7 +325,8 @@ TEST_F(DefaultDisplayBufferCompositor, viewport_is_rotated_when_display_sink_vie
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        nullptr);
 
     Sequence render_seq;
     EXPECT_CALL(display_sink, transformation())
@@ -225,7 +346,8 @@ TEST_F(DefaultDisplayBufferCompositor, renderer_is_suspended_when_we_have_compos
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        nullptr);
 
     compositor.composite(make_scene_elements({big}));
     compositor.composite(make_scene_elements({}));
@@ -255,13 +377,14 @@ TEST_F(DefaultDisplayBufferCompositor, occluded_surfaces_are_not_rendered)
 
     mg::RenderableList const visible{window0, window3};
 
-    EXPECT_CALL(mock_renderer, render(ContainerEq(visible)));
+    EXPECT_CALL(mock_renderer, render(RenderablesMatching(visible)));
 
     mc::DefaultDisplayBufferCompositor compositor(
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        nullptr);
     compositor.composite(make_scene_elements({
         window0, //not occluded
         window1, //occluded
@@ -302,7 +425,8 @@ TEST_F(DefaultDisplayBufferCompositor, marks_rendered_scene_elements)
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        nullptr);
 
     compositor.composite({element0_rendered, element1_rendered});
 }
@@ -326,8 +450,142 @@ TEST_F(DefaultDisplayBufferCompositor, marks_occluded_scene_elements)
         display_sink,
         gl_provider,
         mt::fake_shared(mock_renderer),
-        mr::null_compositor_report());
+        mr::null_compositor_report(),
+        nullptr);
 
     compositor.composite({element0_occluded, element1_rendered, element2_occluded});
 }
 
+
+TEST_F(DefaultDisplayBufferCompositor, keeps_composited_frame_when_given_a_store)
+{
+    using namespace testing;
+
+    auto const scene = std::make_shared<NiceMock<mtd::MockScene>>();
+    auto const composited_frames = std::make_shared<mc::CompositedFrameStore>(
+        scene,
+        std::make_shared<mtd::AdvanceableClock>());
+    auto const frame = std::make_shared<mtd::StubBuffer>(screen.size);
+
+    EXPECT_CALL(mock_renderer, retain_frames(true));
+    ON_CALL(mock_renderer, last_frame())
+        .WillByDefault(Return(frame));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        composited_frames);
+
+    compositor.composite(make_scene_elements({big}));
+
+    auto const composited = composited_frames->frame_containing(screen);
+    ASSERT_THAT(composited, Ne(std::nullopt));
+    EXPECT_THAT(composited->buffer, Eq(frame));
+    EXPECT_THAT(composited->area, Eq(screen));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, keeps_no_composited_frame_of_an_overlay)
+{
+    using namespace testing;
+
+    auto const scene = std::make_shared<NiceMock<mtd::MockScene>>();
+    auto const composited_frames = std::make_shared<mc::CompositedFrameStore>(
+        scene,
+        std::make_shared<mtd::AdvanceableClock>());
+    ON_CALL(mock_renderer, last_frame())
+        .WillByDefault(Return(std::make_shared<mtd::StubBuffer>(screen.size)));
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        gl_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        composited_frames);
+
+    compositor.composite(make_scene_elements({big}));
+
+    EXPECT_CALL(display_sink, overlay(_))
+        .WillOnce(Return(true));
+    compositor.composite(make_scene_elements({}));
+
+    EXPECT_THAT(composited_frames->frame_containing(screen), Eq(std::nullopt));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, forgets_composited_frame_when_destroyed)
+{
+    using namespace testing;
+
+    auto const scene = std::make_shared<NiceMock<mtd::MockScene>>();
+    auto const composited_frames = std::make_shared<mc::CompositedFrameStore>(
+        scene,
+        std::make_shared<mtd::AdvanceableClock>());
+    ON_CALL(mock_renderer, last_frame())
+        .WillByDefault(Return(std::make_shared<mtd::StubBuffer>(screen.size)));
+
+    {
+        mc::DefaultDisplayBufferCompositor compositor(
+            display_sink,
+            gl_provider,
+            mt::fake_shared(mock_renderer),
+            mr::null_compositor_report(),
+            composited_frames);
+
+        compositor.composite(make_scene_elements({big}));
+    }
+
+    EXPECT_THAT(composited_frames->frame_containing(screen), Eq(std::nullopt));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, overlays_are_offered_the_clipped_part_of_a_renderable)
+{
+    using namespace testing;
+
+    ScanoutGlRenderingProvider scanout_provider;
+    auto const clipped = std::make_shared<ClippedRenderable>(
+        geom::Rectangle{{10, 20}, {100, 100}},
+        geom::Rectangle{{50, 0}, {1000, 1000}});
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        nullptr);
+
+    std::vector<mg::DisplayElement> elements;
+    EXPECT_CALL(display_sink, overlay(_))
+        .WillOnce(DoAll(SaveArg<0>(&elements), Return(true)));
+
+    compositor.composite(make_scene_elements({clipped}));
+
+    ASSERT_THAT(elements.size(), Eq(1u));
+    EXPECT_THAT(elements[0].screen_positon, Eq(geom::Rectangle{{50, 20}, {60, 100}}));
+    EXPECT_THAT(elements[0].source_position, Eq(geom::RectangleF{{40, 0}, {60, 100}}));
+}
+
+TEST_F(DefaultDisplayBufferCompositor, overlays_are_told_the_alpha_and_transformation_of_a_renderable)
+{
+    using namespace testing;
+
+    ScanoutGlRenderingProvider scanout_provider;
+    auto const translucent = std::make_shared<mtd::FakeRenderable>(geom::Rectangle{{10, 20}, {30, 40}}, 0.5f);
+
+    mc::DefaultDisplayBufferCompositor compositor(
+        display_sink,
+        scanout_provider,
+        mt::fake_shared(mock_renderer),
+        mr::null_compositor_report(),
+        nullptr);
+
+    std::vector<mg::DisplayElement> elements;
+    EXPECT_CALL(display_sink, overlay(_))
+        .WillOnce(DoAll(SaveArg<0>(&elements), Return(false)));
+
+    compositor.composite(make_scene_elements({translucent}));
+
+    ASSERT_THAT(elements.size(), Eq(1u));
+    EXPECT_THAT(elements[0].alpha, Eq(0.5f));
+    EXPECT_THAT(elements[0].transformation, Eq(glm::mat4{1.0f}));
+}
@@ -25,10 +25,12 @@
 #include "mir/raii.h"
 
 #include "mir/test/current_thread_name.h"
+#include "mir/test/signal.h"
 #include "mir/test/doubles/null_display.h"
 #include "mir/test/doubles/null_display_sink.h"
 #include "mir/test/doubles/mock_display_sink.h"
 #include "mir/test/doubles/mock_compositor_report.h"
+#include "mir/test/doubles/mock_presentation_observer.h"
 #include "mir/test/doubles/mock_scene.h"
 #include "mir/test/doubles/stub_scene.h"
 #include "mir/test/doubles/stub_display.h"
@@ -122,12 +124,20 @@ public:
 
             // Any old event will do.
             if (observer)
-                observer->surfaces_reordered({});
+                observer->scene_changed();
         }
         /* Reduce run-time under valgrind */
         std::this_thread::yield();
     }
 
+    void emit_damage(geom::Rectangle const& damage)
+    {
+        std::lock_guard lock{observer_mutex};
+
+        if (observer)
+            observer->scene_damaged(damage);
+    }
+
     void throw_on_add_observer(bool flag)
     {
         throw_on_add_observer_ = flag;
@@ -262,6 +272,17 @@ public:
         return true;
     }
 
+    unsigned int total_record_count()
+    {
+        std::lock_guard lk{m};
+
+        unsigned int total{0};
+        for (auto const& e : records)
+            total += e.second.first;
+
+        return total;
+    }
+
 private:
     std::mutex m;
     typedef std::pair<unsigned int, std::unordered_set<std::thread::id>> Record;
@@ -361,6 +382,7 @@ struct MockDisplayListener : mc::DisplayListener
 auto const null_report = mr::null_compositor_report();
 unsigned int const composites_per_update{1};
 auto const null_display_listener = std::make_shared<StubDisplayListener>();
+auto const null_presentation_observer = std::make_shared<testing::NiceMock<mtd::MockPresentationObserver>>();
 std::chrono::milliseconds const default_delay{-1};
 
 }
@@ -374,7 +396,7 @@ TEST(MultiThreadedCompositor, compositing_happens_in_different_threads)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, true};
 
     compositor.start();
 
@@ -415,6 +437,7 @@ TEST(MultiThreadedCompositor, does_not_deadlock_itself)
         std::make_shared<mtd::NullDisplayBufferCompositorFactory>(),
         std::make_shared<ReentrantDisplayListener>(scene),
         null_report,
+        null_presentation_observer,
         default_delay,
         true
     };
@@ -440,6 +463,7 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
                                            db_compositor_factory,
                                            null_display_listener,
                                            mock_report,
+                                           null_presentation_observer,
                                            default_delay,
                                            true};
 
@@ -467,6 +491,92 @@ TEST(MultiThreadedCompositor, reports_in_the_right_places)
     compositor.stop();
 }
 
+TEST(MultiThreadedCompositor, reports_presentation_of_composited_frames)
+{
+    using namespace testing;
+
+    geom::Rectangle const view_area{{0, 0}, {1920, 1080}};
+    mg::Frame presented;
+    presented.msc = 42;
+    presented.ust = {CLOCK_MONOTONIC, std::chrono::nanoseconds{123456789}};
+
+    auto display = std::make_shared<StubDisplayWithMockBuffers>(1);
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto presentation_observer = std::make_shared<NiceMock<mtd::MockPresentationObserver>>();
+
+    display->for_each_mock_buffer([&](mtd::MockDisplaySink& mock_buf)
+    {
+        ON_CALL(mock_buf, view_area()).WillByDefault(Return(view_area));
+        ON_CALL(mock_buf, last_frame()).WillByDefault(Return(presented));
+    });
+
+    mt::Signal frame_presented;
+    EXPECT_CALL(*presentation_observer, frame_presented(view_area, _, false))
+        .WillOnce(Invoke(
+            [&](auto const&, mg::Frame const& frame, bool)
+            {
+                EXPECT_THAT(frame.msc, Eq(presented.msc));
+                EXPECT_THAT(frame.ust.nanoseconds, Eq(presented.ust.nanoseconds));
+                frame_presented.raise();
+            }))
+        .WillRepeatedly(Return());
+
+    mc::MultiThreadedCompositor compositor{
+        display, scene, db_compositor_factory, null_display_listener, null_report,
+        presentation_observer, default_delay, true};
+
+    compositor.start();
+    EXPECT_TRUE(frame_presented.wait_for(10s));
+    compositor.stop();
+}
+
+TEST(MultiThreadedCompositor, scene_damage_only_wakes_compositors_showing_it)
+{
+    using namespace testing;
+
+    geom::Rectangle const left{{0, 0}, {640, 480}};
+    geom::Rectangle const right{{640, 0}, {640, 480}};
+
+    auto display = std::make_shared<StubDisplayWithMockBuffers>(2);
+    auto next_area = left;
+    display->for_each_mock_buffer([&](mtd::MockDisplaySink& mock_buf)
+    {
+        ON_CALL(mock_buf, view_area()).WillByDefault(Return(next_area));
+        next_area = right;
+    });
+
+    auto scene = std::make_shared<StubScene>();
+    auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
+    auto mock_report = std::make_shared<NiceMock<mtd::MockCompositorReport>>();
+
+    mt::Signal skipped;
+    EXPECT_CALL(*mock_report, skipped_frame(_))
+        .WillOnce(InvokeWithoutArgs([&] { skipped.raise(); }));
+
+    mc::MultiThreadedCompositor compositor{
+        display, scene, db_compositor_factory, null_display_listener, mock_report,
+        null_presentation_observer, default_delay, true};
+
+    compositor.start();
+    while (!db_compositor_factory->check_record_count_for_each_buffer(2, composites_per_update))
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    scene->emit_damage({{10, 10}, {20, 20}});
+    EXPECT_TRUE(skipped.wait_for(10s));
+
+    while (db_compositor_factory->total_record_count() < 3*composites_per_update)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Only the left display has been composited again
+    EXPECT_THAT(db_compositor_factory->total_record_count(), Eq(3*composites_per_update));
+    EXPECT_TRUE(db_compositor_factory->check_record_count_for_each_buffer(
+        2, composites_per_update, 2*composites_per_update));
+
+    compositor.stop();
+}
+
 /*
  * It's difficult to test that a render won't happen, without some further
  * introspective capabilities that would complicate the code. This test will
@@ -485,7 +595,7 @@ TEST(MultiThreadedCompositor, composites_only_on_demand)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, true};
 
     // Verify we're actually starting at zero frames
     EXPECT_TRUE(db_compositor_factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -546,7 +656,7 @@ TEST(MultiThreadedCompositor, schedules_enough_frames)
     auto scene = std::make_shared<StubScene>();
     auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
     mc::MultiThreadedCompositor compositor{display, scene, factory,
-                                           null_display_listener, null_report, default_delay, true};
+                                           null_display_listener, null_report, null_presentation_observer, default_delay, true};
 
     EXPECT_TRUE(factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
 
@@ -622,6 +732,7 @@ TEST(MultiThreadedCompositor, recommended_sleep_throttles_compositor_loop)
     auto factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
     mc::MultiThreadedCompositor compositor{display, scene, factory,
                                            null_display_listener, null_report,
+                                           null_presentation_observer,
                                            recommendation, false};
 
     EXPECT_TRUE(factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -670,7 +781,7 @@ TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_there_is_none)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, false};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, false};
 
     // Verify we're actually starting at zero frames
     ASSERT_TRUE(db_compositor_factory->check_record_count_for_each_buffer(nbuffers, 0, 0));
@@ -693,7 +804,7 @@ TEST(MultiThreadedCompositor, when_no_initial_composite_is_needed_we_still_compo
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, false};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, false};
 
     compositor.start();
 
@@ -728,7 +839,7 @@ TEST(MultiThreadedCompositor, surface_update_from_render_doesnt_deadlock)
     auto display = std::make_shared<mtd::StubDisplay>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<SurfaceUpdatingDisplayBufferCompositorFactory>(scene);
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, true};
 
     compositor.start();
 
@@ -760,7 +871,7 @@ TEST(MultiThreadedCompositor, double_start_or_stop_ignored)
         .Times(AtLeast(0))
         .WillRepeatedly(Return(mc::SceneElementSequence{}));
 
-    mc::MultiThreadedCompositor compositor{display, mock_scene, db_compositor_factory, null_display_listener, mock_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, mock_scene, db_compositor_factory, null_display_listener, mock_report, null_presentation_observer, default_delay, true};
 
     compositor.start();
     compositor.start();
@@ -775,7 +886,7 @@ TEST(MultiThreadedCompositor, cleans_up_after_throw_in_start)
     auto display = std::make_shared<StubDisplayWithMockBuffers>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<RecordingDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, true};
 
     scene->throw_on_add_observer(true);
 
@@ -829,7 +940,7 @@ TEST(MultiThreadedCompositor, DISABLED_names_compositor_threads)
     auto display = std::make_shared<StubDisplayWithMockBuffers>(nbuffers);
     auto scene = std::make_shared<StubScene>();
     auto db_compositor_factory = std::make_shared<ThreadNameDisplayBufferCompositorFactory>();
-    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, default_delay, true};
+    mc::MultiThreadedCompositor compositor{display, scene, db_compositor_factory, null_display_listener, null_report, null_presentation_observer, default_delay, true};
 
     compositor.start();
 
@@ -858,7 +969,7 @@ TEST(MultiThreadedCompositor, registers_and_unregisters_with_scene)
     EXPECT_CALL(*mock_scene, register_compositor(_))
         .Times(nbuffers);
     mc::MultiThreadedCompositor compositor{
-        display, mock_scene, db_compositor_factory, null_display_listener, mock_report, default_delay, true};
+        display, mock_scene, db_compositor_factory, null_display_listener, mock_report, null_presentation_observer, default_delay, true};
 
     compositor.start();
 
@@ -881,7 +992,7 @@ TEST(MultiThreadedCompositor, notifies_about_display_additions_and_removals)
     auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, null_presentation_observer, default_delay, true};
 
     EXPECT_CALL(*mock_display_listener, add_display(_)).Times(nbuffers);
 
@@ -903,7 +1014,7 @@ TEST(MultiThreadedCompositor, when_compositor_thread_fails_start_reports_error)
     auto mock_report = std::make_shared<testing::NiceMock<mtd::MockCompositorReport>>();
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, null_presentation_observer, default_delay, true};
 
     EXPECT_CALL(*mock_display_listener, add_display(_))
         .WillRepeatedly(Throw(std::runtime_error("Failed to add display")));
@@ -926,7 +1037,7 @@ TEST(MultiThreadedCompositor, can_schedule_from_display_observer_when_adding_dis
         .WillByDefault(InvokeWithoutArgs([&]{ stub_scene->emit_change_event(); }));
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, null_presentation_observer, default_delay, true};
     compositor.start();
 }
 
@@ -944,6 +1055,6 @@ TEST(MultiThreadedCompositor, can_schedule_from_display_observer_when_removing_d
         .WillByDefault(InvokeWithoutArgs([&]{ stub_scene->emit_change_event(); }));
 
     mc::MultiThreadedCompositor compositor{
-        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, default_delay, true};
+        display, stub_scene, db_compositor_factory, mock_display_listener, mock_report, null_presentation_observer, default_delay, true};
     compositor.start();
 }
@@ -20,6 +20,8 @@
 #include "mir/test/doubles/stub_scene_element.h"
 
 #include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <map>
 #include <memory>
 
 using namespace testing;
@@ -43,21 +45,26 @@ struct OcclusionFilterTest : public Test
     {
         SceneElementSequence elements;
         for (auto const& renderable : renderables)
+        {
             elements.push_back(std::make_shared<mtd::StubSceneElement>(renderable));
+            originals[renderable->id()] = renderable;
+        }
 
         return elements;
     }
 
+    // Partly hidden renderables are wrapped by the filter, so look up the ones we made
     mg::RenderableList renderables_from(SceneElementSequence const& elements)
     {
         mg::RenderableList renderables;
         for (auto const& element : elements)
-            renderables.push_back(element->renderable());
+            renderables.push_back(originals.at(element->renderable()->id()));
 
         return renderables;
     }
 
     Rectangle monitor_rect;
+    std::map<mg::Renderable::ID, std::shared_ptr<mg::Renderable>> originals;
 };
 
 }
@@ -123,6 +130,33 @@ TEST_F(OcclusionFilterTest, shaped_window_occludes_nothing)
     EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
 }
 
+TEST_F(OcclusionFilterTest, opaque_region_of_shaped_window_occludes)
+{
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 0}, {40, 40}}, 1.0f, false);
+    top->set_opaque_region({{{10, 10}, {20, 20}}});
+    auto inside = std::make_shared<mtd::FakeRenderable>(12, 12, 5, 5);
+    auto outside = std::make_shared<mtd::FakeRenderable>(2, 2, 5, 5);
+    auto elements = scene_elements_from({inside, outside, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(inside));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(outside, top));
+}
+
+TEST_F(OcclusionFilterTest, opaque_region_of_translucent_window_occludes_nothing)
+{
+    auto top = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 0}, {40, 40}}, 0.5f, false);
+    top->set_opaque_region({{{10, 10}, {20, 20}}});
+    auto bottom = std::make_shared<mtd::FakeRenderable>(12, 12, 5, 5);
+    auto elements = scene_elements_from({bottom, top});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(bottom, top));
+}
+
 TEST_F(OcclusionFilterTest, identical_window_occluded)
 {
     auto top = std::make_shared<mtd::FakeRenderable>(10, 10, 10, 10);
@@ -200,3 +234,74 @@ TEST_F(OcclusionFilterTest,
     EXPECT_THAT(renderables_from(occlusions), ElementsAre(partially_onscreen));
     EXPECT_THAT(renderables_from(elements), ElementsAre(covering));
 }
+
+TEST_F(OcclusionFilterTest, window_covered_by_several_windows_together_occluded)
+{
+    auto const left = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 200);
+    auto const top_right = std::make_shared<mtd::FakeRenderable>(100, 0, 100, 100);
+    auto const bottom_right = std::make_shared<mtd::FakeRenderable>(100, 100, 100, 100);
+    auto const behind = std::make_shared<mtd::FakeRenderable>(50, 50, 100, 100);
+    auto elements = scene_elements_from({behind, left, top_right, bottom_right});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), ElementsAre(behind));
+    EXPECT_THAT(renderables_from(elements), ElementsAre(left, top_right, bottom_right));
+}
+
+TEST_F(OcclusionFilterTest, window_showing_through_gap_between_windows_not_occluded)
+{
+    auto const left = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 200);
+    auto const right = std::make_shared<mtd::FakeRenderable>(101, 0, 100, 200);
+    auto const behind = std::make_shared<mtd::FakeRenderable>(50, 50, 100, 100);
+    auto elements = scene_elements_from({behind, left, right});
+
+    auto const& occlusions = filter_occlusions_from(elements, monitor_rect);
+
+    EXPECT_THAT(renderables_from(occlusions), IsEmpty());
+    EXPECT_THAT(renderables_from(elements), ElementsAre(behind, left, right));
+}
+
+TEST_F(OcclusionFilterTest, unobstructed_windows_report_no_visible_region)
+{
+    auto const top = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 100);
+    auto const beside = std::make_shared<mtd::FakeRenderable>(100, 0, 100, 100);
+    auto elements = scene_elements_from({beside, top});
+
+    filter_occlusions_from(elements, monitor_rect);
+
+    ASSERT_THAT(elements.size(), Eq(2u));
+    EXPECT_THAT(elements[0]->renderable()->visible_region(), Eq(std::nullopt));
+    EXPECT_THAT(elements[1]->renderable()->visible_region(), Eq(std::nullopt));
+}
+
+TEST_F(OcclusionFilterTest, partly_covered_window_reports_its_visible_region)
+{
+    auto const top = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 100);
+    auto const behind = std::make_shared<mtd::FakeRenderable>(50, 50, 100, 100);
+    auto elements = scene_elements_from({behind, top});
+
+    filter_occlusions_from(elements, monitor_rect);
+
+    ASSERT_THAT(elements.size(), Eq(2u));
+    auto const visible = elements[0]->renderable()->visible_region();
+    ASSERT_THAT(visible, Ne(std::nullopt));
+    EXPECT_THAT(*visible, Eq(Rectangles{
+        {{100, 50}, {50, 50}},
+        {{50, 100}, {100, 50}}}));
+    EXPECT_THAT(elements[0]->renderable()->screen_position(), Eq(behind->screen_position()));
+}
+
+TEST_F(OcclusionFilterTest, visible_region_excludes_translucent_and_shaped_windows_above)
+{
+    auto const translucent = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 0}, {100, 100}}, 0.5f);
+    auto const shaped = std::make_shared<mtd::FakeRenderable>(Rectangle{{0, 0}, {100, 100}}, 1.0f, false);
+    shaped->set_opaque_region({{{0, 0}, {100, 50}}});
+    auto const behind = std::make_shared<mtd::FakeRenderable>(0, 0, 100, 100);
+    auto elements = scene_elements_from({behind, shaped, translucent});
+
+    filter_occlusions_from(elements, monitor_rect);
+
+    ASSERT_THAT(elements.size(), Eq(3u));
+    EXPECT_THAT(elements[0]->renderable()->visible_region(), Eq(Rectangles{{{0, 50}, {100, 50}}}));
+}
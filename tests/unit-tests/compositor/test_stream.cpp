@@ -236,3 +236,64 @@ TEST_F(Stream, stream_remembers_scale_when_buffer_added)
     stream.submit_buffer(buffers[0]);
     ASSERT_THAT(stream.stream_size(), Eq(initial_size / 2));
 }
+
+TEST_F(Stream, reports_whole_buffer_damaged_the_first_time_a_compositor_locks_it)
+{
+    stream.submit_buffer(buffers[0], {{{1, 1}, {2, 2}}});
+
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.damage_for(this), Eq(geom::Rectangles{{{}, initial_size}}));
+}
+
+TEST_F(Stream, reports_submitted_damage_relative_to_previously_locked_buffer)
+{
+    geom::Rectangle const damage{{3, 0}, {5, 1}};
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+
+    stream.submit_buffer(buffers[1], {damage});
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.damage_for(this), Eq(geom::Rectangles{damage}));
+}
+
+TEST_F(Stream, accumulates_damage_of_buffers_dropped_before_compositing)
+{
+    geom::Rectangle const first_damage{{3, 0}, {5, 1}};
+    geom::Rectangle const second_damage{{10, 1}, {2, 1}};
+    stream.allow_framedropping(true);
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+
+    stream.submit_buffer(buffers[1], {first_damage});
+    stream.submit_buffer(buffers[2], {second_damage});
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.damage_for(this), Eq(geom::Rectangles{first_damage, second_damage}));
+}
+
+TEST_F(Stream, reports_no_damage_when_relocking_the_same_buffer)
+{
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+    stream.lock_compositor_buffer(this);
+
+    EXPECT_THAT(stream.damage_for(this), Eq(geom::Rectangles{}));
+}
+
+TEST_F(Stream, tracks_damage_separately_for_each_compositor)
+{
+    int const other_compositor{0};
+    geom::Rectangle const damage{{3, 0}, {5, 1}};
+    stream.allow_framedropping(true);
+    stream.submit_buffer(buffers[0]);
+    stream.lock_compositor_buffer(this);
+
+    stream.submit_buffer(buffers[1], {damage});
+    stream.lock_compositor_buffer(this);
+    stream.lock_compositor_buffer(&other_compositor);
+
+    EXPECT_THAT(stream.damage_for(this), Eq(geom::Rectangles{damage}));
+    EXPECT_THAT(stream.damage_for(&other_compositor), Eq(geom::Rectangles{{{}, initial_size}}));
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/frame_executor.h"
+#include "mir/test/doubles/advanceable_clock.h"
+#include "mir/test/doubles/fake_alarm_factory.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mf = mir::frontend;
+namespace mg = mir::graphics;
+namespace geom = mir::geometry;
+namespace mtd = mir::test::doubles;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+geom::Rectangle const left_output{{0, 0}, {1920, 1080}};
+geom::Rectangle const right_output{{1920, 0}, {2560, 1440}};
+
+auto frame_at(int64_t msc, std::chrono::nanoseconds ust) -> mg::Frame
+{
+    mg::Frame frame;
+    frame.msc = msc;
+    frame.ust = {CLOCK_MONOTONIC, ust};
+    return frame;
+}
+
+struct FrameExecutorTest : Test
+{
+    std::shared_ptr<mtd::AdvanceableClock> const clock{std::make_shared<mtd::AdvanceableClock>()};
+    mtd::FakeAlarmFactory alarm_factory;
+    mf::FrameExecutor executor{clock, alarm_factory};
+
+    void advance_by(mir::time::Duration step)
+    {
+        clock->advance_by(step);
+        alarm_factory.advance_by(step);
+    }
+
+    /// Presents frames on an output often enough for the executor to learn its refresh interval
+    void present_at_rate(geom::Rectangle const& output, std::chrono::nanoseconds interval)
+    {
+        executor.frame_presented(output, frame_at(1, interval), false);
+        executor.frame_presented(output, frame_at(2, 2 * interval), false);
+    }
+};
+}
+
+TEST_F(FrameExecutorTest, work_runs_when_its_output_presents)
+{
+    int runs{0};
+    executor.spawn([&]{ ++runs; }, geom::Rectangle{{100, 100}, {640, 480}});
+
+    EXPECT_THAT(runs, Eq(0));
+    executor.frame_presented(left_output, frame_at(1, 1ms), false);
+    EXPECT_THAT(runs, Eq(1));
+
+    executor.frame_presented(left_output, frame_at(2, 17ms), false);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutorTest, work_does_not_run_when_another_output_presents)
+{
+    int runs{0};
+    executor.spawn([&]{ ++runs; }, geom::Rectangle{{100, 100}, {640, 480}});
+
+    executor.frame_presented(right_output, frame_at(1, 1ms), false);
+    EXPECT_THAT(runs, Eq(0));
+
+    executor.frame_presented(left_output, frame_at(1, 2ms), false);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutorTest, work_spanning_outputs_runs_on_first_to_present)
+{
+    int runs{0};
+    executor.spawn([&]{ ++runs; }, geom::Rectangle{{1800, 100}, {640, 480}});
+
+    executor.frame_presented(right_output, frame_at(1, 1ms), false);
+    executor.frame_presented(left_output, frame_at(1, 2ms), false);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutorTest, work_without_area_runs_after_fallback_delay)
+{
+    int runs{0};
+    executor.spawn([&]{ ++runs; }, std::nullopt);
+
+    executor.frame_presented(left_output, frame_at(1, 1ms), false);
+    EXPECT_THAT(runs, Eq(0));
+
+    advance_by(15ms);
+    EXPECT_THAT(runs, Eq(0));
+    advance_by(2ms);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutorTest, fallback_paces_at_refresh_rate_of_fast_output)
+{
+    present_at_rate(left_output, 6944444ns); // 144Hz
+
+    int runs{0};
+    executor.spawn([&]{ ++runs; }, std::nullopt);
+
+    advance_by(6ms);
+    EXPECT_THAT(runs, Eq(0));
+    advance_by(2ms);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutorTest, fallback_does_not_preempt_slow_output)
+{
+    present_at_rate(left_output, 6944444ns);  // 144Hz
+    present_at_rate(right_output, 20833333ns); // 48Hz
+
+    int runs{0};
+    executor.spawn([&]{ ++runs; }, geom::Rectangle{{2000, 100}, {640, 480}});
+
+    advance_by(20ms);
+    EXPECT_THAT(runs, Eq(0));
+    advance_by(2ms);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutorTest, reconfigured_output_replaces_the_one_it_overlaps)
+{
+    present_at_rate(left_output, 20833333ns); // 48Hz
+    present_at_rate(geom::Rectangle{{0, 0}, {2560, 1440}}, 6944444ns); // 144Hz
+
+    int runs{0};
+    executor.spawn([&]{ ++runs; }, std::nullopt);
+
+    advance_by(8ms);
+    EXPECT_THAT(runs, Eq(1));
+}
+
+TEST_F(FrameExecutorTest, work_is_told_how_its_frame_was_presented)
+{
+    present_at_rate(left_output, 16666666ns); // 60Hz
+
+    std::optional<mf::FrameExecutor::Presentation> presented;
+    executor.spawn(
+        [&](std::optional<mf::FrameExecutor::Presentation> const& presentation) { presented = presentation; },
+        geom::Rectangle{{100, 100}, {640, 480}});
+
+    executor.frame_presented(left_output, frame_at(3, 3 * 16666666ns), true);
+
+    ASSERT_TRUE(presented);
+    EXPECT_THAT(presented->view_area, Eq(left_output));
+    EXPECT_THAT(presented->frame.msc, Eq(3));
+    EXPECT_THAT(presented->refresh_interval, Eq(16666666ns));
+    EXPECT_TRUE(presented->zero_copy);
+}
+
+TEST_F(FrameExecutorTest, work_run_by_fallback_is_told_it_was_not_presented)
+{
+    bool ran{false};
+    std::optional<mf::FrameExecutor::Presentation> presented;
+    executor.spawn(
+        [&](std::optional<mf::FrameExecutor::Presentation> const& presentation)
+        {
+            ran = true;
+            presented = presentation;
+        },
+        std::nullopt);
+
+    advance_by(17ms);
+    EXPECT_TRUE(ran);
+    EXPECT_FALSE(presented);
+}
+
+TEST_F(FrameExecutorTest, fallback_runs_each_work_a_delay_after_it_was_spawned)
+{
+    int first_runs{0};
+    int second_runs{0};
+    executor.spawn([&]{ ++first_runs; }, std::nullopt);
+    advance_by(10ms);
+    executor.spawn([&]{ ++second_runs; }, std::nullopt);
+
+    advance_by(7ms);
+    EXPECT_THAT(first_runs, Eq(1));
+    EXPECT_THAT(second_runs, Eq(0));
+
+    advance_by(9ms);
+    EXPECT_THAT(second_runs, Eq(0));
+    advance_by(2ms);
+    EXPECT_THAT(second_runs, Eq(1));
+}
+
+TEST_F(FrameExecutorTest, presenting_rearms_fallback_for_the_work_left)
+{
+    int presented_runs{0};
+    int fallback_runs{0};
+    executor.spawn([&]{ ++presented_runs; }, geom::Rectangle{{100, 100}, {640, 480}});
+    advance_by(10ms);
+    executor.spawn([&]{ ++fallback_runs; }, std::nullopt);
+
+    executor.frame_presented(left_output, frame_at(1, 10ms), false);
+    EXPECT_THAT(presented_runs, Eq(1));
+
+    advance_by(7ms);
+    EXPECT_THAT(fallback_runs, Eq(0));
+    advance_by(10ms);
+    EXPECT_THAT(fallback_runs, Eq(1));
+}
+
+TEST_F(FrameExecutorTest, fallback_is_cancelled_when_all_work_has_been_presented)
+{
+    executor.spawn([]{}, geom::Rectangle{{100, 100}, {640, 480}});
+    executor.frame_presented(left_output, frame_at(1, 1ms), false);
+
+    advance_by(100ms);
+    EXPECT_THAT(alarm_factory.wakeup_count(), Eq(0));
+}
+
+TEST_F(FrameExecutorTest, work_run_by_fallback_can_spawn_more_work)
+{
+    int runs{0};
+    executor.spawn(
+        [&]
+        {
+            ++runs;
+            executor.spawn([&]{ ++runs; }, std::nullopt);
+        },
+        std::nullopt);
+
+    advance_by(17ms);
+    EXPECT_THAT(runs, Eq(1));
+    advance_by(17ms);
+    EXPECT_THAT(runs, Eq(2));
+}
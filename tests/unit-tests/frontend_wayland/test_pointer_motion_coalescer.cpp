@@ -0,0 +1,212 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/pointer_motion_coalescer.h"
+
+#include <mir/events/pointer_event.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <iostream>
+
+namespace mf = mir::frontend;
+namespace mev = mir::events;
+namespace geom = mir::geometry;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+auto pointer_event(
+    MirPointerAction action,
+    geom::PointF position,
+    geom::DisplacementF motion,
+    std::chrono::nanoseconds time = 0ns,
+    mev::ScrollAxisV v_scroll = {}) -> std::shared_ptr<MirInputEvent const>
+{
+    auto const event = std::make_shared<MirPointerEvent>(
+        MirInputDeviceId{7}, time, std::vector<uint8_t>{}, mir_input_event_modifier_none,
+        action, MirPointerButtons{0}, position, motion, mir_pointer_axis_source_none, mev::ScrollAxisH{}, v_scroll);
+    event->set_local_position(position);
+    return event;
+}
+
+auto motion(geom::PointF position, geom::DisplacementF motion, std::chrono::nanoseconds time = 0ns)
+{
+    return pointer_event(mir_pointer_action_motion, position, motion, time);
+}
+
+struct PointerMotionCoalescer : Test
+{
+    /// What the Wayland thread would do with the queued events, in order
+    auto take_all() -> std::vector<std::shared_ptr<MirInputEvent const>>
+    {
+        std::vector<std::shared_ptr<MirInputEvent const>> taken;
+        for (auto const& q : queued)
+        {
+            taken.push_back(coalescer.take(*q));
+        }
+        queued.clear();
+        return taken;
+    }
+
+    void queue(std::shared_ptr<MirInputEvent const> const& event)
+    {
+        if (auto q = coalescer.queue(event))
+        {
+            queued.push_back(std::move(q));
+        }
+    }
+
+    mf::PointerMotionCoalescer coalescer{true};
+    std::vector<std::shared_ptr<mf::PointerMotionCoalescer::Queued>> queued;
+};
+}
+
+TEST_F(PointerMotionCoalescer, passes_lone_motion_through_unchanged)
+{
+    auto const event = motion({10, 20}, {1, 2});
+
+    queue(event);
+
+    EXPECT_THAT(take_all(), ElementsAre(event));
+}
+
+TEST_F(PointerMotionCoalescer, merges_motion_queued_before_the_wayland_thread_takes_it)
+{
+    queue(motion({10, 20}, {1, 2}, 1ms));
+    queue(motion({11, 22}, {1, 2}, 2ms));
+    queue(motion({13, 21}, {2, -1}, 3ms));
+
+    auto const taken = take_all();
+
+    ASSERT_THAT(taken, SizeIs(1));
+    auto const& merged = *taken[0]->to_pointer();
+    EXPECT_THAT(merged.action(), Eq(mir_pointer_action_motion));
+    EXPECT_THAT(merged.local_position(), Eq(geom::PointF{13, 21}));
+    EXPECT_THAT(merged.motion(), Eq(geom::DisplacementF{4, 3}));
+    EXPECT_THAT(merged.event_time(), Eq(3ms));
+}
+
+TEST_F(PointerMotionCoalescer, keeps_summed_unaccelerated_motion_exact)
+{
+    auto const step = motion({0, 0}, {1, -3});
+    for (auto i = 0; i != 1000; ++i)
+    {
+        queue(step);
+    }
+
+    auto const taken = take_all();
+
+    ASSERT_THAT(taken, SizeIs(1));
+    EXPECT_THAT(taken[0]->to_pointer()->motion(), Eq(geom::DisplacementF{1000, -3000}));
+}
+
+TEST_F(PointerMotionCoalescer, sums_accelerated_motion_without_accumulating_rounding_error)
+{
+    auto const step = motion({0, 0}, {0.1f, 0});
+    double expected{0};
+    float running_total{0};
+    for (auto i = 0; i != 100'000; ++i)
+    {
+        queue(step);
+        expected += 0.1f;
+        running_total += 0.1f;
+    }
+
+    auto const taken = take_all();
+
+    ASSERT_THAT(taken, SizeIs(1));
+    ASSERT_THAT(running_total, Ne(static_cast<float>(expected)));
+    EXPECT_THAT(taken[0]->to_pointer()->motion().dx.as_value(), Eq(static_cast<float>(expected)));
+}
+
+TEST_F(PointerMotionCoalescer, does_not_merge_motion_across_other_events)
+{
+    auto const button = pointer_event(mir_pointer_action_button_down, {11, 22}, {});
+
+    queue(motion({10, 20}, {1, 2}));
+    queue(button);
+    queue(motion({12, 24}, {1, 2}));
+
+    auto const taken = take_all();
+
+    ASSERT_THAT(taken, SizeIs(3));
+    EXPECT_THAT(taken[0]->to_pointer()->local_position(), Eq(geom::PointF{10, 20}));
+    EXPECT_THAT(taken[1], Eq(button));
+    EXPECT_THAT(taken[2]->to_pointer()->local_position(), Eq(geom::PointF{12, 24}));
+}
+
+TEST_F(PointerMotionCoalescer, does_not_merge_scroll)
+{
+    auto const scroll = pointer_event(
+        mir_pointer_action_motion, {10, 20}, {}, 0ns, mev::ScrollAxisV{geom::DeltaYF{3}, geom::DeltaY{}, false});
+
+    queue(motion({10, 20}, {1, 2}));
+    queue(scroll);
+    queue(scroll);
+
+    EXPECT_THAT(take_all(), SizeIs(3));
+}
+
+TEST_F(PointerMotionCoalescer, does_not_merge_into_motion_already_taken)
+{
+    queue(motion({10, 20}, {1, 2}));
+    auto const first = take_all();
+    queue(motion({11, 22}, {1, 2}));
+
+    EXPECT_THAT(first, SizeIs(1));
+    EXPECT_THAT(take_all(), SizeIs(1));
+}
+
+TEST_F(PointerMotionCoalescer, does_not_merge_when_disabled)
+{
+    coalescer.set_enabled(false);
+
+    queue(motion({10, 20}, {1, 2}));
+    queue(motion({11, 22}, {1, 2}));
+
+    EXPECT_THAT(take_all(), SizeIs(2));
+}
+
+TEST_F(PointerMotionCoalescer, reduces_wake_ups_and_bytes_sent_for_a_fast_mouse)
+{
+    auto constexpr mouse_hz = 8000;
+    auto constexpr wayland_thread_hz = 1000;
+    // wl_pointer.motion (time, x, y) and wl_pointer.frame, each with an 8 byte header
+    auto constexpr bytes_per_motion = (8 + 12) + 8;
+
+    // Each event that isn't merged is a task the Wayland thread is woken for
+    int wake_ups = 0;
+    for (auto i = 0; i != mouse_hz; ++i)
+    {
+        queue(motion({static_cast<float>(i % 100), 0}, {1, 0}));
+        if ((i + 1) % (mouse_hz / wayland_thread_hz) == 0)
+        {
+            wake_ups += queued.size();
+            take_all();
+        }
+    }
+
+    std::cout << "Wake-ups per second: " << wake_ups << " (from " << mouse_hz << " motions)" << std::endl;
+    std::cout << "Bytes sent per second: " << wake_ups * bytes_per_motion << std::endl;
+    RecordProperty("wake_ups_per_second", wake_ups);
+    RecordProperty("bytes_sent_per_second", wake_ups * bytes_per_motion);
+
+    EXPECT_THAT(wake_ups, Eq(wayland_thread_hz));
+}
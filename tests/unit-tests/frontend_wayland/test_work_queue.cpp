@@ -0,0 +1,165 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/frontend_wayland/work_queue.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <thread>
+#include <vector>
+
+namespace mf = mir::frontend;
+
+using namespace testing;
+
+namespace
+{
+auto drain(mf::WorkQueue& queue) -> int
+{
+    int count = 0;
+    queue.prepare_to_drain();
+    while (auto work = queue.pop())
+    {
+        work();
+        ++count;
+    }
+    return count;
+}
+}
+
+TEST(WorkQueue, runs_work_in_the_order_pushed)
+{
+    mf::WorkQueue queue;
+    std::vector<int> order;
+
+    for (int i = 0; i != 10; ++i)
+    {
+        queue.push([&order, i]() { order.push_back(i); });
+    }
+    drain(queue);
+
+    EXPECT_THAT(order, ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+}
+
+TEST(WorkQueue, only_asks_for_a_wakeup_once_per_drain)
+{
+    mf::WorkQueue queue;
+
+    EXPECT_TRUE(queue.push([](){}));
+    EXPECT_FALSE(queue.push([](){}));
+    EXPECT_FALSE(queue.push([](){}));
+
+    drain(queue);
+
+    EXPECT_TRUE(queue.push([](){}));
+}
+
+TEST(WorkQueue, asks_for_a_wakeup_for_work_pushed_while_draining)
+{
+    mf::WorkQueue queue;
+    bool woken = false;
+
+    queue.push([&]() { woken = queue.push([](){}); });
+    drain(queue);
+
+    EXPECT_TRUE(woken);
+}
+
+TEST(WorkQueue, keeps_order_when_the_ring_overflows)
+{
+    mf::WorkQueue queue{4};
+    std::vector<int> order;
+
+    for (int i = 0; i != 10; ++i)
+    {
+        queue.push([&order, i]() { order.push_back(i); });
+    }
+
+    // Taking some work out of the ring must not let later work overtake the overflow
+    queue.prepare_to_drain();
+    queue.pop()();
+    queue.pop()();
+    for (int i = 10; i != 12; ++i)
+    {
+        queue.push([&order, i]() { order.push_back(i); });
+    }
+    drain(queue);
+
+    EXPECT_THAT(order, ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11));
+
+    // …and once caught up, the ring is used again
+    queue.push([&order]() { order.push_back(12); });
+    EXPECT_THAT(drain(queue), Eq(1));
+}
+
+TEST(WorkQueue, destroys_work_that_is_never_run)
+{
+    auto const tracker = std::make_shared<int>();
+    {
+        mf::WorkQueue queue{2};
+        for (int i = 0; i != 4; ++i)
+        {
+            queue.push([tracker]() {});
+        }
+        queue.prepare_to_drain();
+        queue.pop();
+    }
+
+    EXPECT_THAT(tracker.use_count(), Eq(1));
+}
+
+TEST(WorkQueue, keeps_each_producers_order_with_concurrent_producers)
+{
+    int const producer_count{4};
+    int const work_per_producer{100000};
+
+    mf::WorkQueue queue{64};
+    std::vector<int> last_seen(producer_count, -1);
+    bool in_order = true;
+    int count = 0;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p != producer_count; ++p)
+    {
+        producers.emplace_back(
+            [&, p]()
+            {
+                for (int i = 0; i != work_per_producer; ++i)
+                {
+                    queue.push(
+                        [&, p, i]()
+                        {
+                            in_order &= last_seen[p] == i - 1;
+                            last_seen[p] = i;
+                        });
+                }
+            });
+    }
+
+    while (count != producer_count * work_per_producer)
+    {
+        count += drain(queue);
+    }
+
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+
+    EXPECT_TRUE(in_order);
+    EXPECT_THAT(last_seen, Each(Eq(work_per_producer - 1)));
+}
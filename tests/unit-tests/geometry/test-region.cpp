@@ -0,0 +1,171 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/geometry/region.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace mir::geometry;
+using namespace testing;
+
+TEST(Region, default_region_is_empty)
+{
+    Region const region;
+
+    EXPECT_TRUE(region.empty());
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{}));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{}));
+}
+
+TEST(Region, empty_rectangles_make_empty_region)
+{
+    EXPECT_TRUE(Region(Rectangle{{10, 10}, {0, 20}}).empty());
+    EXPECT_TRUE(Region(Rectangle{{10, 10}, {20, 0}}).empty());
+    EXPECT_TRUE(Region(Rectangles{{{10, 10}, {0, 20}}, {{5, 5}, {5, 0}}}).empty());
+}
+
+TEST(Region, single_rectangle_round_trips)
+{
+    Rectangle const rect{{10, 20}, {30, 40}};
+    Region const region{rect};
+
+    EXPECT_FALSE(region.empty());
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{rect}));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(rect));
+}
+
+TEST(Region, contains_points_inside_only)
+{
+    Region const region{Rectangle{{10, 20}, {30, 40}}};
+
+    EXPECT_TRUE(region.contains(Point{10, 20}));
+    EXPECT_TRUE(region.contains(Point{39, 59}));
+    EXPECT_FALSE(region.contains(Point{40, 59}));
+    EXPECT_FALSE(region.contains(Point{39, 60}));
+    EXPECT_FALSE(region.contains(Point{9, 20}));
+}
+
+TEST(Region, rectangle_covered_by_union_of_several_is_contained)
+{
+    Region region;
+    region.unite(Rectangle{{0, 0}, {50, 100}});
+    region.unite(Rectangle{{50, 0}, {50, 50}});
+    region.unite(Rectangle{{50, 50}, {50, 50}});
+
+    // No single one of the rectangles holds this
+    EXPECT_TRUE(region.contains(Rectangle{{25, 25}, {50, 50}}));
+    EXPECT_TRUE(region.contains(Rectangle{{0, 0}, {100, 100}}));
+    EXPECT_FALSE(region.contains(Rectangle{{0, 0}, {101, 100}}));
+}
+
+TEST(Region, rectangle_over_a_gap_is_not_contained)
+{
+    Region region;
+    region.unite(Rectangle{{0, 0}, {100, 40}});
+    region.unite(Rectangle{{0, 60}, {100, 40}});
+
+    EXPECT_FALSE(region.contains(Rectangle{{10, 10}, {10, 80}}));
+    EXPECT_TRUE(region.contains(Rectangle{{10, 10}, {10, 10}}));
+    EXPECT_TRUE(region.overlaps(Rectangle{{10, 10}, {10, 80}}));
+    EXPECT_FALSE(region.overlaps(Rectangle{{10, 40}, {10, 20}}));
+}
+
+TEST(Region, union_merges_adjacent_rectangles)
+{
+    Region region;
+    region.unite(Rectangle{{0, 0}, {50, 50}});
+    region.unite(Rectangle{{50, 0}, {50, 50}});
+    region.unite(Rectangle{{0, 50}, {100, 50}});
+
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{{{0, 0}, {100, 100}}}));
+}
+
+TEST(Region, representation_does_not_depend_on_construction)
+{
+    Region a;
+    a.unite(Rectangle{{0, 0}, {100, 50}});
+    a.unite(Rectangle{{0, 50}, {50, 50}});
+
+    Region b;
+    b.unite(Rectangle{{0, 0}, {50, 100}});
+    b.unite(Rectangle{{50, 0}, {50, 50}});
+
+    Region const c{Rectangles{{{0, 0}, {50, 100}}, {{0, 0}, {100, 50}}}};
+
+    EXPECT_THAT(a, Eq(b));
+    EXPECT_THAT(a, Eq(c));
+    EXPECT_THAT(a.rectangles(), Eq(Rectangles{{{0, 0}, {100, 50}}, {{0, 50}, {50, 50}}}));
+}
+
+TEST(Region, subtract_punches_hole)
+{
+    Region region{Rectangle{{0, 0}, {30, 30}}};
+    region.subtract(Rectangle{{10, 10}, {10, 10}});
+
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{
+        {{0, 0}, {30, 10}},
+        {{0, 10}, {10, 10}},
+        {{20, 10}, {10, 10}},
+        {{0, 20}, {30, 10}}}));
+    EXPECT_FALSE(region.contains(Point{15, 15}));
+    EXPECT_FALSE(region.overlaps(Rectangle{{10, 10}, {10, 10}}));
+    EXPECT_THAT(region.bounding_rectangle(), Eq(Rectangle{{0, 0}, {30, 30}}));
+}
+
+TEST(Region, subtracting_everything_leaves_nothing)
+{
+    Region region{Rectangle{{10, 10}, {30, 30}}};
+    region.subtract(Region{Rectangles{{{0, 0}, {40, 20}}, {{0, 20}, {40, 40}}}});
+
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(Region, subtracting_a_taller_region_only_changes_the_overlap)
+{
+    Region region{Rectangle{{0, 20}, {30, 20}}};
+    region.subtract(Region{Rectangles{
+        {{0, 0}, {30, 10}},
+        {{0, 15}, {10, 10}},
+        {{20, 35}, {10, 20}},
+        {{0, 50}, {30, 10}}}});
+
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{
+        {{10, 20}, {20, 5}},
+        {{0, 25}, {30, 10}},
+        {{0, 35}, {20, 5}}}));
+}
+
+TEST(Region, intersection_keeps_common_area)
+{
+    Region region{Rectangles{{{0, 0}, {20, 20}}, {{40, 0}, {20, 20}}}};
+    region.intersect(Rectangle{{10, 10}, {40, 40}});
+
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{{{10, 10}, {10, 10}}, {{40, 10}, {10, 10}}}));
+
+    region.intersect(Region{});
+    EXPECT_TRUE(region.empty());
+}
+
+TEST(Region, copes_with_negative_coordinates)
+{
+    Region region{Rectangle{{-100, -100}, {200, 200}}};
+    region.subtract(Rectangle{{-50, -200}, {100, 400}});
+
+    EXPECT_THAT(region.rectangles(), Eq(Rectangles{
+        {{-100, -100}, {50, 200}},
+        {{50, -100}, {50, 200}}}));
+}
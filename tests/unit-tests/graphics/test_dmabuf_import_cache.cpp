@@ -0,0 +1,292 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platform/graphics/dmabuf_import_cache.h"
+#include "mir/graphics/dmabuf_buffer.h"
+#include "mir/graphics/drm_formats.h"
+#include "mir/graphics/egl_context_executor.h"
+#include "mir/graphics/egl_extensions.h"
+#include "mir/renderer/gl/context.h"
+
+#include "mir/test/doubles/mock_display_report.h"
+#include "mir/test/doubles/mock_egl.h"
+#include "mir/test/doubles/mock_gl.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <drm_fourcc.h>
+#include <future>
+#include <map>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mg = mir::graphics;
+namespace mgc = mir::graphics::common;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+using namespace testing;
+
+namespace
+{
+class DumbGLContext : public mir::renderer::gl::Context
+{
+public:
+    void make_current() const override
+    {
+        eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx);
+    }
+
+    void release_current() const override
+    {
+        eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+    auto make_share_context() const -> std::unique_ptr<Context> override
+    {
+        return std::make_unique<DumbGLContext>();
+    }
+
+    explicit operator EGLContext() override
+    {
+        return ctx;
+    }
+
+private:
+    EGLDisplay const dpy{reinterpret_cast<EGLDisplay>(0xdeebbeed)};
+    EGLContext const ctx{reinterpret_cast<EGLContext>(0xc0ffee)};
+};
+
+class ClientDMABuf : public mg::DMABufBuffer
+{
+public:
+    ClientDMABuf(std::vector<mir::Fd> const& fds, uint32_t offset = 0)
+    {
+        for (auto const& fd : fds)
+        {
+            planes_.push_back({fd, 2560, offset});
+        }
+    }
+
+    auto format() const -> mg::DRMFormat override
+    {
+        return mg::DRMFormat{DRM_FORMAT_ARGB8888};
+    }
+
+    auto modifier() const -> std::optional<uint64_t> override
+    {
+        return std::nullopt;
+    }
+
+    auto planes() const -> std::vector<PlaneDescriptor> const& override
+    {
+        return planes_;
+    }
+
+    auto layout() const -> mg::gl::Texture::Layout override
+    {
+        return mg::gl::Texture::Layout::GL;
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return {640, 480};
+    }
+
+private:
+    std::vector<PlaneDescriptor> planes_;
+};
+
+auto client_memory() -> mir::Fd
+{
+    return mir::Fd{memfd_create("dmabuf", MFD_CLOEXEC)};
+}
+
+/// Another fd for the same memory, as a client sends us each time it creates a wl_buffer
+auto same_memory(mir::Fd const& fd) -> mir::Fd
+{
+    return mir::Fd{dup(fd)};
+}
+
+void wait_for_egl_thread(mgc::EGLContextExecutor& egl_delegate)
+{
+    std::promise<void> done;
+    egl_delegate.spawn([&done]() { done.set_value(); });
+    done.get_future().wait();
+}
+
+struct DMABufImportCache : Test
+{
+    DMABufImportCache()
+    {
+        mock_egl.provide_egl_extensions();
+        ON_CALL(mock_gl, glGenTextures(1, _))
+            .WillByDefault(Invoke([this](GLsizei, GLuint* id) { *id = ++last_texture; }));
+    }
+
+    auto import(mg::DMABufBuffer const&) -> std::shared_ptr<mg::DMABufImage>
+    {
+        auto const image = reinterpret_cast<EGLImageKHR>(++last_image);
+        return std::make_shared<mg::DMABufImage>(dpy, extensions, image, egl_delegate);
+    }
+
+    NiceMock<mtd::MockEGL> mock_egl;
+    NiceMock<mtd::MockGL> mock_gl;
+
+    EGLDisplay const dpy{reinterpret_cast<EGLDisplay>(0xaabbccdd)};
+    std::shared_ptr<mg::EGLExtensions> const extensions{std::make_shared<mg::EGLExtensions>()};
+    std::shared_ptr<mgc::EGLContextExecutor> const egl_delegate{
+        std::make_shared<mgc::EGLContextExecutor>(std::make_unique<DumbGLContext>())};
+    std::shared_ptr<NiceMock<mtd::MockDisplayReport>> const report{
+        std::make_shared<NiceMock<mtd::MockDisplayReport>>()};
+
+    uintptr_t last_image{0};
+    GLuint last_texture{0};
+
+    /// Stands in for the client's wl_buffers, which hold their imports
+    std::map<mg::DMABufBuffer const*, std::shared_ptr<mg::DMABufImage>> wl_buffers;
+
+    mg::DMABufImportCache cache{
+        [this](mg::DMABufBuffer const& dma_buf) { return import(dma_buf); },
+        [this](mg::DMABufBuffer const& dma_buf, std::shared_ptr<mg::DMABufImage> const& image)
+        {
+            wl_buffers[&dma_buf] = image;
+        },
+        report};
+};
+}
+
+TEST_F(DMABufImportCache, buffers_of_the_same_memory_share_one_import)
+{
+    auto const memory = client_memory();
+    ClientDMABuf const first{{memory}};
+    ClientDMABuf const second{{same_memory(memory)}};
+
+    auto const first_image = cache.image_for(first);
+    auto const second_image = cache.image_for(second);
+
+    EXPECT_THAT(second_image, Eq(first_image));
+    EXPECT_THAT(cache.metrics().imports, Eq(1u));
+    EXPECT_THAT(cache.metrics().reuses, Eq(1u));
+}
+
+TEST_F(DMABufImportCache, buffers_of_different_memory_are_imported_separately)
+{
+    ClientDMABuf const first{{client_memory()}};
+    ClientDMABuf const second{{client_memory()}};
+
+    auto const first_image = cache.image_for(first);
+    auto const second_image = cache.image_for(second);
+
+    EXPECT_THAT(second_image, Ne(first_image));
+    EXPECT_THAT(cache.metrics().imports, Eq(2u));
+}
+
+TEST_F(DMABufImportCache, buffers_at_different_offsets_of_the_same_memory_are_imported_separately)
+{
+    auto const memory = client_memory();
+    ClientDMABuf const first{{memory}, 0};
+    ClientDMABuf const second{{same_memory(memory)}, 640 * 480 * 4};
+
+    auto const first_image = cache.image_for(first);
+    auto const second_image = cache.image_for(second);
+
+    EXPECT_THAT(second_image, Ne(first_image));
+}
+
+TEST_F(DMABufImportCache, buffers_whose_memory_cannot_be_identified_are_imported_every_time)
+{
+    ClientDMABuf const buffer{{mir::Fd{}}};
+
+    cache.image_for(buffer);
+    cache.image_for(buffer);
+
+    EXPECT_THAT(cache.metrics().imports, Eq(2u));
+    EXPECT_THAT(cache.metrics().live, Eq(0u));
+}
+
+TEST_F(DMABufImportCache, memory_is_imported_again_once_the_last_import_has_gone)
+{
+    auto const memory = client_memory();
+    ClientDMABuf const buffer{{memory}};
+
+    cache.image_for(buffer);
+    wl_buffers.clear();
+    EXPECT_THAT(cache.metrics().live, Eq(0u));
+
+    cache.image_for(buffer);
+
+    EXPECT_THAT(cache.metrics().imports, Eq(2u));
+    EXPECT_THAT(cache.metrics().reuses, Eq(0u));
+    EXPECT_THAT(cache.metrics().live, Eq(1u));
+}
+
+TEST_F(DMABufImportCache, import_lives_as_long_as_the_wl_buffer)
+{
+    ClientDMABuf const buffer{{client_memory()}};
+    cache.image_for(buffer);
+    auto const image = reinterpret_cast<EGLImageKHR>(last_image);
+
+    EXPECT_CALL(mock_egl, eglDestroyImageKHR(_, _)).Times(0);
+    wait_for_egl_thread(*egl_delegate);
+    Mock::VerifyAndClearExpectations(&mock_egl);
+
+    EXPECT_CALL(mock_egl, eglDestroyImageKHR(dpy, image));
+    wl_buffers.clear();
+    wait_for_egl_thread(*egl_delegate);
+}
+
+TEST_F(DMABufImportCache, reports_imports_and_reuses)
+{
+    auto const memory = client_memory();
+    ClientDMABuf const first{{memory}};
+    ClientDMABuf const second{{same_memory(memory)}};
+
+    InSequence seq;
+    EXPECT_CALL(*report, report_dmabuf_import(geom::Size{640, 480}, 1u, false));
+    EXPECT_CALL(*report, report_dmabuf_import(geom::Size{640, 480}, 1u, true));
+
+    cache.image_for(first);
+    cache.image_for(second);
+}
+
+TEST_F(DMABufImportCache, each_context_attaches_a_texture_of_its_own)
+{
+    EGLContext const first_context{reinterpret_cast<EGLContext>(0x1111)};
+    EGLContext const second_context{reinterpret_cast<EGLContext>(0x2222)};
+    ClientDMABuf const buffer{{client_memory()}};
+    auto image = cache.image_for(buffer);
+    wl_buffers.clear();
+
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, first_context);
+    auto const first_texture = image->attach_texture(GL_TEXTURE_2D);
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, second_context);
+    auto const second_texture = image->attach_texture(GL_TEXTURE_2D);
+
+    EXPECT_THAT(second_texture, Ne(first_texture));
+
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, first_context);
+    EXPECT_CALL(mock_gl, glGenTextures(_, _)).Times(0);
+    EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, first_texture));
+    EXPECT_CALL(mock_egl, glEGLImageTargetTexture2DOES(GL_TEXTURE_2D, _));
+    EXPECT_THAT(image->attach_texture(GL_TEXTURE_2D), Eq(first_texture));
+    Mock::VerifyAndClearExpectations(&mock_gl);
+
+    eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    EXPECT_CALL(mock_gl, glDeleteTextures(2, _));
+    image.reset();
+    wait_for_egl_thread(*egl_delegate);
+}
@@ -16,6 +16,7 @@
 
 #include "src/platforms/common/server/shm_buffer.h"
 #include "mir/graphics/egl_context_executor.h"
+#include "mir/graphics/gl_context_lifetime.h"
 #include "mir/renderer/gl/context.h"
 
 #include "mir/test/doubles/mock_gl.h"
@@ -27,6 +28,7 @@
 #include <EGL/egl.h>
 #include <endian.h>
 #include <boost/throw_exception.hpp>
+#include <string>
 
 namespace mg = mir::graphics;
 namespace mgc = mir::graphics::common;
@@ -351,3 +353,248 @@ TEST_F(ShmBufferTest, texture_is_destroyed_on_thread_with_current_context)
         eglMakeCurrent(dummy_dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
     }
 }
+
+namespace
+{
+struct ShmTextureChainTest : ShmBufferTest
+{
+    ShmTextureChainTest()
+    {
+        ON_CALL(mock_gl, glGenTextures(1, _))
+            .WillByDefault(Invoke([this](GLsizei, GLuint* id) { *id = ++last_texture; }));
+        ON_CALL(mock_gl, glGetString(GL_EXTENSIONS))
+            .WillByDefault(Return(reinterpret_cast<GLubyte const*>("GL_OES_EGL_image GL_EXT_unpack_subimage")));
+    }
+
+    auto client_data(geom::Size size) -> std::shared_ptr<PlatformlessShmBuffer>
+    {
+        return std::make_shared<PlatformlessShmBuffer>(size, mir_pixel_format_argb_8888, egl_delegate);
+    }
+
+    auto submit(
+        std::shared_ptr<PlatformlessShmBuffer> const& data,
+        std::shared_ptr<mg::Buffer> const& previous,
+        geom::Rectangles const& damage) -> std::shared_ptr<mgc::MappableBackedShmBuffer>
+    {
+        return std::make_shared<mgc::MappableBackedShmBuffer>(data, previous, damage, egl_delegate);
+    }
+
+    GLuint last_texture{0};
+    geom::Size const client_size{640, 480};
+};
+}
+
+TEST_F(ShmTextureChainTest, first_buffer_is_uploaded_in_full)
+{
+    auto const data = client_data(client_size);
+    auto const buffer = submit(data, nullptr, {});
+
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, 640, 480, 0, _, _, data->pixel_buffer()));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    buffer->bind();
+}
+
+TEST_F(ShmTextureChainTest, later_buffer_reuses_texture_and_uploads_only_damage)
+{
+    auto const data = client_data(client_size);
+    auto const first = submit(data, nullptr, {});
+    first->bind();
+
+    auto const second = submit(data, first, {{{10, 20}, {30, 40}}});
+
+    auto const stride = 640 * 4;
+    EXPECT_CALL(mock_gl, glGenTextures(_, _)).Times(0);
+    EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, last_texture));
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glPixelStorei(_, _)).Times(AnyNumber());
+    EXPECT_CALL(mock_gl, glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 640));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(
+        GL_TEXTURE_2D, 0, 10, 20, 30, 40, _, _,
+        data->pixel_buffer() + 20 * stride + 10 * 4));
+
+    second->bind();
+}
+
+TEST_F(ShmTextureChainTest, rebinding_current_buffer_uploads_nothing)
+{
+    auto const data = client_data(client_size);
+    auto const buffer = submit(data, nullptr, {});
+    buffer->bind();
+
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    buffer->bind();
+}
+
+TEST_F(ShmTextureChainTest, damage_of_buffers_never_bound_is_uploaded_with_the_next)
+{
+    auto const data = client_data(client_size);
+    auto const first = submit(data, nullptr, {});
+    first->bind();
+
+    auto const skipped = submit(data, first, {{{0, 0}, {10, 10}}});
+    auto const latest = submit(data, skipped, {{{100, 100}, {10, 10}}});
+
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 10, 10, _, _, _));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 100, 100, 10, 10, _, _, _));
+
+    latest->bind();
+}
+
+TEST_F(ShmTextureChainTest, resized_buffer_is_uploaded_in_full)
+{
+    auto const first = submit(client_data(client_size), nullptr, {});
+    first->bind();
+
+    auto const data = client_data({800, 600});
+    auto const second = submit(data, first, {{{0, 0}, {10, 10}}});
+
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, 800, 600, 0, _, _, data->pixel_buffer()));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+
+    second->bind();
+}
+
+TEST_F(ShmTextureChainTest, buffer_older_than_texture_gets_texture_of_its_own)
+{
+    auto const data = client_data(client_size);
+    auto const first = submit(data, nullptr, {});
+    auto const second = submit(data, first, {{{0, 0}, {10, 10}}});
+    second->bind();
+    auto const shared_texture = last_texture;
+
+    EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, Ne(shared_texture)));
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, 640, 480, 0, _, _, data->pixel_buffer()));
+
+    first->bind();
+}
+
+TEST_F(ShmTextureChainTest, damage_is_packed_without_unpack_row_length)
+{
+    ON_CALL(mock_gl, glGetString(GL_EXTENSIONS))
+        .WillByDefault(Return(reinterpret_cast<GLubyte const*>("GL_OES_EGL_image")));
+
+    auto const data = client_data(client_size);
+    auto const first = submit(data, nullptr, {});
+    first->bind();
+    auto const second = submit(data, first, {{{10, 20}, {30, 40}}});
+
+    EXPECT_CALL(mock_gl, glPixelStorei(_, _)).Times(AnyNumber());
+    EXPECT_CALL(mock_gl, glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(
+        GL_TEXTURE_2D, 0, 10, 20, 30, 40, _, _,
+        Ne(data->pixel_buffer() + 20 * 640 * 4 + 10 * 4)));
+
+    second->bind();
+}
+
+TEST_F(ShmTextureChainTest, each_context_fills_a_texture_of_its_own)
+{
+    auto const first_context = std::make_shared<mg::gl::ContextLifetime>();
+    auto const second_context = std::make_shared<mg::gl::ContextLifetime>();
+
+    auto const data = client_data(client_size);
+    auto const first = submit(data, nullptr, {});
+    {
+        mg::gl::ContextLifetime::Current const in_context{first_context};
+        first->bind();
+    }
+    auto const first_texture = last_texture;
+
+    auto const second = submit(data, first, {{{0, 0}, {10, 10}}});
+    {
+        mg::gl::ContextLifetime::Current const in_context{second_context};
+        EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, Ne(first_texture)));
+        EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, 640, 480, 0, _, _, data->pixel_buffer()));
+        second->bind();
+    }
+    Mock::VerifyAndClearExpectations(&mock_gl);
+
+    // Back on the first context, its texture still needs the damage of the second buffer
+    auto const third = submit(data, second, {{{100, 100}, {10, 10}}});
+    mg::gl::ContextLifetime::Current const in_context{first_context};
+    EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, first_texture));
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 10, 10, _, _, _));
+    EXPECT_CALL(mock_gl, glTexSubImage2D(GL_TEXTURE_2D, 0, 100, 100, 10, 10, _, _, _));
+    third->bind();
+}
+
+TEST_F(ShmTextureChainTest, textures_are_deleted_by_the_context_that_made_them)
+{
+    auto const context = std::make_shared<mg::gl::ContextLifetime>();
+    auto buffer = submit(client_data(client_size), nullptr, {});
+    {
+        mg::gl::ContextLifetime::Current const in_context{context};
+        buffer->bind();
+    }
+    auto const texture = last_texture;
+
+    EXPECT_CALL(mock_gl, glDeleteTextures(_, _)).Times(0);
+    buffer.reset();
+    wait_for_egl_thread(*egl_delegate);
+    Mock::VerifyAndClearExpectations(&mock_gl);
+
+    EXPECT_CALL(mock_gl, glDeleteTextures(1, Pointee(Eq(texture))));
+    context->delete_pending();
+}
+
+TEST_F(ShmTextureChainTest, context_made_after_another_is_destroyed_fills_a_texture_of_its_own)
+{
+    auto const data = client_data(client_size);
+    auto const first = submit(data, nullptr, {});
+    {
+        auto const destroyed_context = std::make_shared<mg::gl::ContextLifetime>();
+        mg::gl::ContextLifetime::Current const in_context{destroyed_context};
+        first->bind();
+    }
+    auto const destroyed_texture = last_texture;
+
+    auto const second = submit(data, first, {{{0, 0}, {10, 10}}});
+    auto const new_context = std::make_shared<mg::gl::ContextLifetime>();
+    mg::gl::ContextLifetime::Current const in_context{new_context};
+    EXPECT_CALL(mock_gl, glBindTexture(GL_TEXTURE_2D, Ne(destroyed_texture)));
+    EXPECT_CALL(mock_gl, glTexImage2D(GL_TEXTURE_2D, 0, _, 640, 480, 0, _, _, data->pixel_buffer()));
+    second->bind();
+}
+
+TEST_F(ShmTextureChainTest, unpack_row_length_support_is_queried_once_per_context)
+{
+    auto const data = client_data(client_size);
+    auto previous = submit(data, nullptr, {});
+    previous->bind();
+
+    EXPECT_CALL(mock_gl, glGetString(_)).Times(0);
+    for (int i = 0; i != 3; ++i)
+    {
+        auto const buffer = submit(data, previous, {{{0, i}, {10, 1}}});
+        buffer->bind();
+        previous = buffer;
+    }
+}
+
+TEST_F(ShmTextureChainTest, new_line_on_4k_terminal_uploads_only_that_line)
+{
+    geom::Size const size_4k{3840, 2160};
+    geom::Height const line_height{20};
+
+    auto const data = client_data(size_4k);
+    auto const previous = submit(data, nullptr, {});
+    previous->bind();
+
+    size_t bytes_uploaded{0};
+    EXPECT_CALL(mock_gl, glTexImage2D(_, _, _, _, _, _, _, _, _)).Times(0);
+    ON_CALL(mock_gl, glTexSubImage2D(_, _, _, _, _, _, _, _, _))
+        .WillByDefault(Invoke(
+            [&](GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum, GLenum, GLvoid const*)
+            {
+                bytes_uploaded += width * height * 4;
+            }));
+
+    auto const buffer = submit(data, previous, {{{0, 2140}, {size_4k.width, line_height}}});
+    buffer->bind();
+
+    EXPECT_THAT(bytes_uploaded, Eq(size_4k.width.as_uint32_t() * line_height.as_uint32_t() * 4));
+}
@@ -46,6 +46,7 @@ struct MockInputScene : mtd::StubInputScene
                  void(std::weak_ptr<mg::Renderable> const&));
 
     MOCK_METHOD0(emit_scene_changed, void());
+    MOCK_METHOD1(emit_scene_damage, void(geom::Rectangle const&));
 
     MOCK_CONST_METHOD0(screen_is_locked, bool());
 };
@@ -292,13 +293,32 @@ TEST_F(SoftwareCursor, notifies_scene_when_moving)
 {
     using namespace testing;
 
-    EXPECT_CALL(mock_input_scene, emit_scene_changed());
+    EXPECT_CALL(mock_input_scene, emit_scene_damage(_));
 
     cursor.show(stub_cursor_image);
     executor.execute();
     cursor.move_to({22,23});
 }
 
+TEST_F(SoftwareCursor, scene_damage_covers_old_and_new_positions)
+{
+    using namespace testing;
+
+    geom::Point const new_position{220, 230};
+    geom::Rectangle damage;
+    EXPECT_CALL(mock_input_scene, emit_scene_damage(_))
+        .WillOnce(SaveArg<0>(&damage));
+
+    cursor.show(stub_cursor_image);
+    executor.execute();
+    cursor.move_to(new_position);
+
+    EXPECT_TRUE(damage.contains(
+        geom::Rectangle{geom::Point{0, 0} - stub_cursor_image.hotspot(), stub_cursor_image.size()}));
+    EXPECT_TRUE(damage.contains(
+        geom::Rectangle{new_position - stub_cursor_image.hotspot(), stub_cursor_image.size()}));
+}
+
 TEST_F(SoftwareCursor, creates_renderable_with_filled_buffer)
 {
     using namespace testing;
@@ -327,7 +347,7 @@ TEST_F(SoftwareCursor, does_not_hide_or_move_when_already_hidden)
     using namespace testing;
 
     EXPECT_CALL(mock_input_scene, remove_input_visualization(_)).Times(0);
-    EXPECT_CALL(mock_input_scene, emit_scene_changed()).Times(0);
+    EXPECT_CALL(mock_input_scene, emit_scene_damage(_)).Times(0);
 
     // Already hidden, nothing should happen
     cursor.hide();
@@ -16,6 +16,8 @@
 
 #include "src/server/input/default_event_builder.h"
 #include "mir/cookie/authority.h"
+#include "mir/events/event_builders.h"
+#include "mir/events/input_event.h"
 
 #include "mir/test/doubles/advanceable_clock.h"
 #include "mir/test/fake_shared.h"
@@ -37,10 +39,11 @@ namespace
 struct DefaultEventBuilder : public Test
 {
     mtd::AdvanceableClock clock{{}};
+    std::shared_ptr<mir::cookie::Authority> const cookie_authority{mir::cookie::Authority::create()};
     mir::input::DefaultEventBuilder builder{
         0,
         mt::fake_shared(clock),
-        mir::cookie::Authority::create()};
+        cookie_authority};
 
     auto event_timestamp(std::optional<std::chrono::nanoseconds> timestamp) -> std::chrono::nanoseconds
     {
@@ -95,3 +98,31 @@ TEST_F(DefaultEventBuilder, when_timestamp_is_much_older_than_clock_repeatedly_t
     clock.advance_by(2s);
     EXPECT_THAT(event_timestamp(22s - 10ms), Eq(402s));
 }
+
+TEST_F(DefaultEventBuilder, key_event_has_cookie_for_its_time)
+{
+    clock.advance_by(12s);
+    auto const ev = builder.key_event(std::nullopt, mir_keyboard_action_down, 0, 0);
+
+    auto const cookie = ev->to_input()->cookie();
+
+    ASSERT_THAT(cookie, Not(IsEmpty()));
+    EXPECT_THAT(cookie_authority->make_cookie(cookie)->timestamp(), Eq(std::chrono::nanoseconds{12s}.count()));
+}
+
+TEST_F(DefaultEventBuilder, pointer_button_event_has_cookie_but_motion_does_not)
+{
+    auto const button = builder.pointer_event(std::nullopt, mir_pointer_action_button_down, mir_pointer_button_primary, 0, 0, 0, 0);
+    auto const motion = builder.pointer_event(std::nullopt, mir_pointer_action_motion, 0, 0, 0, 1, 1);
+
+    EXPECT_NO_THROW(cookie_authority->make_cookie(button->to_input()->cookie()));
+    EXPECT_THAT(motion->to_input()->cookie(), IsEmpty());
+}
+
+TEST_F(DefaultEventBuilder, copies_of_an_event_have_its_cookie)
+{
+    auto const ev = builder.key_event(std::nullopt, mir_keyboard_action_down, 0, 0);
+    auto const copy = mev::clone_event(*ev);
+
+    EXPECT_THAT(copy->to_input()->cookie(), Eq(ev->to_input()->cookie()));
+}
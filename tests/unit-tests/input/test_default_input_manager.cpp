@@ -24,6 +24,8 @@
 #include "mir/dispatch/action_queue.h"
 
 #include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -33,6 +35,7 @@
 namespace mt = mir::test;
 namespace md = mir::dispatch;
 namespace mtd = mir::test::doubles;
+namespace mi = mir::input;
 
 using namespace ::testing;
 
@@ -44,7 +47,7 @@ struct DefaultInputManagerTest : ::testing::Test
     md::ActionQueue platform_dispatchable;
     NiceMock<mtd::MockInputPlatform> platform;
     mir::Fd event_hub_fd{eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK)};
-    mir::input::DefaultInputManager input_manager{mt::fake_shared(multiplexer), mt::fake_shared(platform)};
+    mir::input::DefaultInputManager input_manager{mt::fake_shared(multiplexer), mt::fake_shared(platform), {}};
     std::chrono::seconds const timeout{30};
 
     DefaultInputManagerTest()
@@ -149,3 +152,45 @@ TEST_F(DefaultInputManagerTest, forwards_pause_continue_state_changes_to_platfor
     input_manager.continue_after_config();
     EXPECT_TRUE(continued.wait_for(timeout));
 }
+
+TEST_F(DefaultInputManagerTest, platforms_start_on_the_input_thread_at_the_requested_priority)
+{
+    auto const original_nice = getpriority(PRIO_PROCESS, gettid());
+    mi::DefaultInputManager niced_input_manager{
+        mt::fake_shared(multiplexer), mt::fake_shared(platform), mi::InputThreadPriority::parse("nice:19")};
+
+    int input_thread_nice{0};
+    pid_t input_thread{0};
+    EXPECT_CALL(platform, start()).WillOnce(Invoke([&]
+        {
+            input_thread = gettid();
+            input_thread_nice = getpriority(PRIO_PROCESS, gettid());
+        }));
+
+    niced_input_manager.start();
+
+    EXPECT_THAT(input_thread, Ne(gettid()));
+    EXPECT_THAT(input_thread_nice, Eq(19));
+    EXPECT_THAT(getpriority(PRIO_PROCESS, gettid()), Eq(original_nice));
+}
+
+TEST(InputThreadPriority, parses_policies_and_values)
+{
+    EXPECT_THAT(mi::InputThreadPriority::parse("default").policy, Eq(mi::InputThreadPriority::Policy::inherited));
+
+    auto const niced = mi::InputThreadPriority::parse("nice:-5");
+    EXPECT_THAT(niced.policy, Eq(mi::InputThreadPriority::Policy::niced));
+    EXPECT_THAT(niced.value, Eq(-5));
+
+    auto const realtime = mi::InputThreadPriority::parse("realtime:50");
+    EXPECT_THAT(realtime.policy, Eq(mi::InputThreadPriority::Policy::realtime));
+    EXPECT_THAT(realtime.value, Eq(50));
+}
+
+TEST(InputThreadPriority, rejects_invalid_specs)
+{
+    for (auto const spec : {"", "fast", "nice", "nice:", "nice:5x", "nice:20", "realtime:0", "realtime:100"})
+    {
+        EXPECT_THROW(mi::InputThreadPriority::parse(spec), std::invalid_argument) << "spec: \"" << spec << "\"";
+    }
+}
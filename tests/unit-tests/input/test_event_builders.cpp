@@ -57,6 +57,26 @@ TEST_F(InputEventBuilder, makes_valid_key_event)
    EXPECT_EQ(modifiers, mir_keyboard_event_modifiers(kev));
 }
 
+TEST_F(InputEventBuilder, keeps_supplied_cookie)
+{
+    std::vector<uint8_t> const supplied_cookie{1, 2, 3, 4, 5};
+
+    auto ev = mev::make_key_event(
+        device_id, timestamp,
+        supplied_cookie, mir_keyboard_action_down, 34, 17, modifiers);
+
+    EXPECT_THAT(ev->to_input()->cookie(), Eq(supplied_cookie));
+}
+
+TEST_F(InputEventBuilder, rejects_cookie_too_large_for_an_event)
+{
+    std::vector<uint8_t> const oversized_cookie(64, 1);
+
+    EXPECT_THROW(
+        mev::make_key_event(device_id, timestamp, oversized_cookie, mir_keyboard_action_down, 34, 17, modifiers),
+        std::invalid_argument);
+}
+
 TEST_F(InputEventBuilder, makes_valid_touch_event)
 {
     unsigned touch_count = 3;
@@ -0,0 +1,149 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/input/keymap_cache.h"
+#include "mir/input/parameter_keymap.h"
+
+#include <xkbcommon/xkbcommon.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mi = mir::input;
+
+using namespace testing;
+
+namespace
+{
+auto keymap_for(std::string const& layout) -> std::shared_ptr<mi::Keymap>
+{
+    return std::make_shared<mi::ParameterKeymap>("pc105", layout, "", "");
+}
+
+struct KeymapCache : Test
+{
+    uint64_t compilations{0};
+    uint64_t shm_bytes{0};
+    mi::KeymapCache cache{[this](uint64_t compilations, uint64_t shm_bytes)
+        {
+            this->compilations = compilations;
+            this->shm_bytes = shm_bytes;
+        }};
+};
+}
+
+TEST_F(KeymapCache, compiles_matching_keymaps_once)
+{
+    auto const first = cache.compiled(keymap_for("us"));
+    auto const second = cache.compiled(keymap_for("us"));
+
+    EXPECT_THAT(second.get(), Eq(first.get()));
+    EXPECT_THAT(compilations, Eq(1u));
+}
+
+TEST_F(KeymapCache, compiles_different_keymaps_separately)
+{
+    auto const us = cache.compiled(keymap_for("us"));
+    auto const gb = cache.compiled(keymap_for("gb"));
+
+    EXPECT_THAT(gb.get(), Ne(us.get()));
+    EXPECT_THAT(compilations, Eq(2u));
+}
+
+TEST_F(KeymapCache, shares_one_file_between_clients)
+{
+    auto const first = cache.file(keymap_for("us"));
+    auto const second = cache.file(keymap_for("us"));
+
+    EXPECT_THAT(int{second->fd}, Eq(int{first->fd}));
+    EXPECT_THAT(shm_bytes, Eq(first->size));
+}
+
+TEST_F(KeymapCache, file_holds_keymap_text)
+{
+    auto const file = cache.file(keymap_for("us"));
+
+    std::string text(file->size, ' ');
+    ASSERT_THAT(pread(file->fd, text.data(), text.size(), 0), Eq(static_cast<ssize_t>(file->size)));
+
+    EXPECT_THAT(text, StartsWith("xkb_keymap"));
+    EXPECT_THAT(text.back(), Eq('\0'));
+}
+
+TEST_F(KeymapCache, file_cannot_be_changed_by_a_client)
+{
+    auto const file = cache.file(keymap_for("us"));
+
+    EXPECT_THAT(pwrite(file->fd, "x", 1, 0), Eq(-1));
+    EXPECT_THAT(ftruncate(file->fd, 0), Eq(-1));
+    EXPECT_THAT(mmap(nullptr, file->size, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0), Eq(MAP_FAILED));
+
+    auto const mapping = mmap(nullptr, file->size, PROT_READ, MAP_PRIVATE, file->fd, 0);
+    EXPECT_THAT(mapping, Ne(MAP_FAILED));
+    munmap(mapping, file->size);
+}
+
+TEST_F(KeymapCache, invalid_keymaps_throw)
+{
+    EXPECT_THROW(cache.compiled(keymap_for("no-such-layout")), std::invalid_argument);
+    EXPECT_THAT(compilations, Eq(0u));
+}
+
+TEST_F(KeymapCache, keymaps_stay_valid_after_the_cache_drops_them)
+{
+    auto const held = cache.compiled(keymap_for("us"));
+    for (auto const layout : {"gb", "de", "fr", "es", "it", "pt", "se", "dk", "fi", "ru", "ua", "pl", "cz", "hu", "be", "at"})
+    {
+        cache.compiled(keymap_for(layout));
+    }
+
+    auto const recompiled = cache.compiled(keymap_for("us"));
+
+    EXPECT_THAT(compilations, Eq(18u));
+    EXPECT_THAT(xkb_keymap_num_layouts(held.get()), Eq(1u));
+}
+
+TEST_F(KeymapCache, a_docking_station_and_many_clients_share_one_compilation_and_file)
+{
+    auto constexpr keyboard_interfaces = 6;
+    auto constexpr clients = 200;
+
+    std::vector<std::shared_ptr<xkb_keymap>> devices;
+    for (auto i = 0; i != keyboard_interfaces; ++i)
+    {
+        devices.push_back(cache.compiled(keymap_for("us")));
+    }
+    std::vector<std::shared_ptr<mi::KeymapCache::File const>> files;
+    for (auto i = 0; i != clients; ++i)
+    {
+        files.push_back(cache.file(keymap_for("us")));
+    }
+
+    std::cout << "Compilations: " << compilations
+              << " (from " << keyboard_interfaces << " devices and " << clients << " clients)" << std::endl;
+    std::cout << "Keymap shm bytes: " << shm_bytes << std::endl;
+    RecordProperty("compilations", static_cast<int>(compilations));
+    RecordProperty("shm_bytes", static_cast<int>(shm_bytes));
+
+    EXPECT_THAT(compilations, Eq(1u));
+    EXPECT_THAT(shm_bytes, Eq(files.front()->size));
+}
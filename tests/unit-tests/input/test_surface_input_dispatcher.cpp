@@ -17,6 +17,7 @@
 #include "src/server/input/surface_input_dispatcher.h"
 
 #include "mir/events/event_builders.h"
+#include "mir/input/input_report.h"
 #include "mir/events/event_private.h"
 #include "mir/scene/observer.h"
 #include "mir/scene/surface_observer.h"
@@ -129,16 +130,29 @@ struct StubInputScene : public mtd::StubInputScene
     bool is_locked = false;
 };
 
+struct MockInputReport : mi::InputReport
+{
+    MOCK_METHOD(void, received_event_from_kernel, (int64_t, int, int, int), (override));
+    MOCK_METHOD(void, published_key_event, (int, uint32_t, int64_t), (override));
+    MOCK_METHOD(void, published_motion_event, (int, uint32_t, int64_t), (override));
+    MOCK_METHOD(void, opened_input_device, (char const*, char const*), (override));
+    MOCK_METHOD(void, failed_to_open_input_device, (char const*, char const*), (override));
+    MOCK_METHOD(void, dispatched_event_from_seat, (int64_t), (override));
+    MOCK_METHOD(void, delivered_event_to_surface, (int64_t), (override));
+    MOCK_METHOD(void, flushed_event_to_client, (int64_t), (override));
+};
+
 struct SurfaceInputDispatcher : public testing::Test
 {
     SurfaceInputDispatcher()
-        : dispatcher(mt::fake_shared(scene))
+        : dispatcher(mt::fake_shared(scene), mt::fake_shared(report))
     {
     }
 
     void TearDown() override { dispatcher.stop(); }
 
     StubInputScene scene;
+    testing::NiceMock<MockInputReport> report;
     mi::SurfaceInputDispatcher dispatcher;
 };
 
@@ -521,6 +535,57 @@ TEST_F(SurfaceInputDispatcher, pointer_gestures_may_transfer_over_buttons)
     EXPECT_TRUE(dispatcher.dispatch(std::move(ev_5)));
 }
 
+TEST_F(SurfaceInputDispatcher, pointer_events_are_delivered_in_surface_coordinates_without_changing_the_original)
+{
+    auto surface = scene.add_surface({{5, 5}, {10, 10}});
+
+    FakePointer pointer;
+    std::shared_ptr<MirEvent const> entered;
+    std::shared_ptr<MirEvent const> moved;
+    EXPECT_CALL(*surface, consume(_))
+        .WillOnce(SaveArg<0>(&entered))
+        .WillOnce(SaveArg<0>(&moved));
+
+    dispatcher.start();
+
+    EXPECT_TRUE(dispatcher.dispatch(pointer.move_to({6, 6})));
+    std::shared_ptr<MirEvent const> const motion{pointer.move_to({8, 9})};
+    EXPECT_TRUE(dispatcher.dispatch(motion));
+
+    ASSERT_THAT(entered, NotNull());
+    ASSERT_THAT(moved, NotNull());
+    EXPECT_THAT(moved, Ne(motion));
+    EXPECT_THAT(moved->to_input()->to_pointer()->local_position(), Eq(geom::PointF{3, 4}));
+    EXPECT_THAT(moved->to_input()->to_pointer()->position(), Eq(geom::PointF{8, 9}));
+    EXPECT_THAT(motion->to_input()->to_pointer()->local_position(), Eq(std::nullopt));
+}
+
+TEST_F(SurfaceInputDispatcher, event_that_enters_a_surface_is_delivered_without_relative_motion)
+{
+    auto surface = scene.add_surface({{5, 5}, {10, 10}});
+    std::vector<uint8_t> const cookie{1, 2, 3, 4};
+
+    std::shared_ptr<MirEvent const> pressed;
+    EXPECT_CALL(*surface, consume(mt::PointerEnterEvent()));
+    EXPECT_CALL(*surface, consume(mt::ButtonDownEvent(6, 7)))
+        .WillOnce(SaveArg<0>(&pressed));
+
+    dispatcher.start();
+
+    EXPECT_TRUE(dispatcher.dispatch(mev::make_pointer_event(
+        0, std::chrono::nanoseconds(42), cookie,
+        mir_input_event_modifier_shift, mir_pointer_action_button_down, mir_pointer_button_primary,
+        6, 7, 0, 0, 3, 4)));
+
+    ASSERT_THAT(pressed, NotNull());
+    auto const* const pev = pressed->to_input()->to_pointer();
+    EXPECT_THAT(pev->motion(), Eq(geom::DisplacementF{}));
+    EXPECT_THAT(pev->local_position(), Eq(geom::PointF{1, 2}));
+    EXPECT_THAT(pev->modifiers(), Eq(mir_input_event_modifier_shift));
+    EXPECT_THAT(pev->event_time(), Eq(std::chrono::nanoseconds(42)));
+    EXPECT_THAT(pev->cookie(), Eq(cookie));
+}
+
 TEST_F(SurfaceInputDispatcher, pointer_gesture_target_may_vanish_and_the_situation_remains_hunky_dorey)
 {
     auto surface = scene.add_surface({{0, 0}, {5, 5}});
@@ -559,6 +624,29 @@ TEST_F(SurfaceInputDispatcher, touch_delivered_to_surface)
     EXPECT_TRUE(dispatcher.dispatch(toucher.release_at({1,1})));
 }
 
+TEST_F(SurfaceInputDispatcher, reports_events_delivered_to_surfaces)
+{
+    scene.add_surface({{1, 1}, {1, 1}});
+
+    EXPECT_CALL(report, delivered_event_to_surface(_)).Times(2);
+
+    dispatcher.start();
+
+    FakeToucher toucher;
+    dispatcher.dispatch(toucher.touch_at({1,1}));
+    dispatcher.dispatch(toucher.release_at({1,1}));
+}
+
+TEST_F(SurfaceInputDispatcher, does_not_report_events_delivered_to_no_surface)
+{
+    EXPECT_CALL(report, delivered_event_to_surface(_)).Times(0);
+
+    dispatcher.start();
+
+    FakeToucher toucher;
+    EXPECT_FALSE(dispatcher.dispatch(toucher.touch_at({1,1})));
+}
+
 TEST_F(SurfaceInputDispatcher, touch_delivered_only_to_top_surface)
 {
     auto bottom_surface = scene.add_surface({{1, 1}, {3, 3}});
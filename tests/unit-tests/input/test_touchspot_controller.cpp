@@ -224,7 +224,7 @@ namespace
 
 struct StubSceneWithMockEmission : public StubScene
 {
-    MOCK_METHOD0(emit_scene_changed, void());
+    MOCK_METHOD1(emit_scene_damage, void(geom::Rectangle const&));
 };
 
 struct TestTouchspotControllerSceneUpdates : public TestTouchspotController
@@ -241,7 +241,7 @@ struct TestTouchspotControllerSceneUpdates : public TestTouchspotController
 
 TEST_F(TestTouchspotControllerSceneUpdates, does_not_emit_damage_if_nothing_happens)
 {
-    EXPECT_CALL(*scene, emit_scene_changed()).Times(0);
+    EXPECT_CALL(*scene, emit_scene_damage(::testing::_)).Times(0);
 
     mi::TouchspotController controller(allocator, scene);
 
@@ -255,7 +255,7 @@ TEST_F(TestTouchspotControllerSceneUpdates, does_not_emit_damage_if_nothing_happ
 
 TEST_F(TestTouchspotControllerSceneUpdates, emits_scene_damage)
 {
-    EXPECT_CALL(*scene, emit_scene_changed()).Times(2);
+    EXPECT_CALL(*scene, emit_scene_damage(::testing::_)).Times(2);
 
     mi::TouchspotController controller(allocator, scene);
 
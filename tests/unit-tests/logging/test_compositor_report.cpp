@@ -187,3 +187,44 @@ TEST_F(LoggingCompositorReport, bypass_has_no_render_time)
 
     report.stopped();
 }
+
+TEST_F(LoggingCompositorReport, reports_skipped_frames_per_display)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    for (int f = 0; f < 3; ++f)
+    {
+        report.began_frame(id);
+        report.rendered_frame(id);
+        report.finished_frame(id);
+        report.skipped_frame(id);
+        report.skipped_frame(id);
+        clock->advance_by(chrono::microseconds(12345678));
+    }
+    EXPECT_TRUE(recorder->last_message_contains("2 skipped"))
+        << recorder->last_message();
+
+    report.stopped();
+}
+
+TEST_F(LoggingCompositorReport, reports_snapshot_allocations_per_display)
+{
+    const void* const id = "My Screen";
+
+    report.started();
+
+    for (int f = 0; f < 3; ++f)
+    {
+        report.snapshot_allocations(id, 7);
+        report.began_frame(id);
+        report.rendered_frame(id);
+        report.finished_frame(id);
+        clock->advance_by(chrono::microseconds(12345678));
+    }
+    EXPECT_TRUE(recorder->last_message_contains("7 snapshot allocations"))
+        << recorder->last_message();
+
+    report.stopped();
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/report/logging/input_report.h"
+#include "mir/logging/logger.h"
+#include "mir/test/doubles/advanceable_clock.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+namespace mtd = mir::test::doubles;
+namespace mrl = mir::report::logging;
+namespace ml = mir::logging;
+
+using namespace testing;
+using namespace std::chrono_literals;
+
+namespace
+{
+struct Recorder : ml::Logger
+{
+    void log(ml::Severity, std::string const& message, std::string const&) override
+    {
+        messages.push_back(message);
+    }
+
+    std::vector<std::string> messages;
+};
+
+struct LoggingInputReport : Test
+{
+    /// The time of an event the kernel received latency ago
+    auto event_time(std::chrono::nanoseconds latency) const -> int64_t
+    {
+        return (clock->now().time_since_epoch() - latency).count();
+    }
+
+    std::shared_ptr<mtd::AdvanceableClock> const clock = std::make_shared<mtd::AdvanceableClock>();
+    std::shared_ptr<Recorder> const recorder = std::make_shared<Recorder>();
+    mrl::InputReport report{recorder, clock};
+};
+}
+
+TEST_F(LoggingInputReport, logs_nothing_until_a_second_has_passed)
+{
+    report.dispatched_event_from_seat(event_time(1ms));
+    report.delivered_event_to_surface(event_time(2ms));
+    report.flushed_event_to_client(event_time(3ms));
+
+    EXPECT_THAT(recorder->messages, IsEmpty());
+}
+
+TEST_F(LoggingInputReport, logs_latency_percentiles_of_each_stage)
+{
+    for (auto i = 1; i <= 100; ++i)
+    {
+        report.dispatched_event_from_seat(event_time(i * 10us));
+        report.delivered_event_to_surface(event_time(i * 10us + 5us));
+    }
+    clock->advance_by(1s);
+    report.flushed_event_to_client(event_time(8ms));
+
+    // Latencies are accurate to within 1/16
+    ASSERT_THAT(recorder->messages, SizeIs(1));
+    EXPECT_THAT(recorder->messages[0], HasSubstr("seat dispatch p50=0.5"));
+    EXPECT_THAT(recorder->messages[0], HasSubstr("p99=0.99"));
+    EXPECT_THAT(recorder->messages[0], HasSubstr("(100 events)"));
+    EXPECT_THAT(recorder->messages[0], HasSubstr("client flush p50=8.1"));
+    EXPECT_THAT(recorder->messages[0], HasSubstr("(1 events)"));
+}
+
+TEST_F(LoggingInputReport, each_log_covers_only_the_latest_events)
+{
+    clock->advance_by(1s);
+    report.dispatched_event_from_seat(event_time(50ms));
+    clock->advance_by(1s);
+    report.dispatched_event_from_seat(event_time(1ms));
+
+    ASSERT_THAT(recorder->messages, SizeIs(2));
+    EXPECT_THAT(recorder->messages[1], HasSubstr("seat dispatch p50=1.0"));
+    EXPECT_THAT(recorder->messages[1], HasSubstr("p99=1.0"));
+}
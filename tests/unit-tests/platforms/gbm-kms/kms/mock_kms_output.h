@@ -28,6 +28,12 @@ namespace test
 
 struct MockKMSOutput : public graphics::gbm::KMSOutput
 {
+    MockKMSOutput()
+    {
+        ON_CALL(*this, planes()).WillByDefault(testing::ReturnRef(no_planes));
+        ON_CALL(*this, claim_planes(testing::_)).WillByDefault(testing::Return(true));
+    }
+
     MOCK_CONST_METHOD0(id, uint32_t());
     MOCK_METHOD0(reset, void());
     MOCK_METHOD2(configure, void(geometry::Displacement, size_t));
@@ -48,10 +54,23 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
         return schedule_page_flip_thunk(&fb);
     }
     MOCK_METHOD1(schedule_page_flip_thunk, bool(graphics::FBHandle const*));
-    MOCK_METHOD0(wait_for_page_flip, void());
+    MOCK_METHOD0(wait_for_page_flip, graphics::Frame());
 
     MOCK_CONST_METHOD0(last_frame, graphics::Frame());
 
+    MOCK_METHOD(std::vector<graphics::gbm::KMSPlane> const&, planes, (), (override));
+    MOCK_METHOD(bool, set_plane,
+        (uint32_t, graphics::FBHandle const*, geometry::Rectangle const&, geometry::RectangleF const&), (override));
+    MOCK_METHOD(bool, claim_planes, (std::vector<uint32_t> const&), (override));
+
+    MOCK_METHOD(bool, supports_atomic, (), (override));
+    MOCK_METHOD(bool, add_to_atomic_request,
+        (graphics::gbm::AtomicRequest&, graphics::FBHandle const&, bool), (override));
+    MOCK_METHOD(bool, add_plane_to_atomic_request,
+        (graphics::gbm::AtomicRequest&, uint32_t, graphics::FBHandle const*,
+         geometry::Rectangle const&, geometry::RectangleF const&), (override));
+    MOCK_METHOD(bool, schedule_atomic_page_flip, (graphics::gbm::AtomicRequest const&, uint32_t), (override));
+
     MOCK_METHOD1(set_cursor, bool(gbm_bo*));
     MOCK_METHOD1(move_cursor, void(geometry::Point));
     MOCK_METHOD0(clear_cursor, bool());
@@ -67,6 +86,8 @@ struct MockKMSOutput : public graphics::gbm::KMSOutput
     MOCK_CONST_METHOD1(fb_for, std::shared_ptr<graphics::FBHandle const>(graphics::DMABufBuffer const&));
     MOCK_CONST_METHOD1(buffer_requires_migration, bool(gbm_bo*));
     MOCK_CONST_METHOD0(drm_fd, int());
+
+    std::vector<graphics::gbm::KMSPlane> const no_planes;
 };
 
 } // namespace test
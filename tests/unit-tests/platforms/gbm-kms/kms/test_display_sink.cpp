@@ -34,6 +34,7 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <gbm.h>
+#include <drm_fourcc.h>
 
 using namespace testing;
 using namespace mir;
@@ -69,6 +70,8 @@ public:
     }
 
     MOCK_METHOD(mir::geometry::Size, size, (), (const override));
+    MOCK_METHOD(uint32_t, drm_fourcc, (), (const override));
+    MOCK_METHOD(uint64_t, modifier, (), (const override));
 };
 }
 
@@ -258,3 +261,298 @@ TEST_F(MesaDisplaySinkTest, transformation_not_implemented_internally)
     EXPECT_EQ(rotate_left, sink.transformation());
 }
 
+
+TEST_F(MesaDisplaySinkTest, elements_above_the_primary_are_shown_on_overlay_planes)
+{
+    uint32_t const overlay_plane_id{51};
+    std::vector<KMSPlane> const planes{
+        KMSPlane{overlay_plane_id, KMSPlane::Type::overlay, {{DRM_FORMAT_ARGB8888, {}}}, std::nullopt}};
+    ON_CALL(*mock_kms_output, planes()).WillByDefault(ReturnRef(planes));
+
+    auto const overlay_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    ON_CALL(*overlay_framebuffer, drm_fourcc()).WillByDefault(Return(DRM_FORMAT_ARGB8888));
+    ON_CALL(*overlay_framebuffer, modifier()).WillByDefault(Return(DRM_FORMAT_MOD_INVALID));
+    ON_CALL(*overlay_framebuffer, size()).WillByDefault(Return(mir::geometry::Size{10, 10}));
+
+    auto renderlist = bypassable_list;
+    renderlist.push_back(
+        mir::graphics::DisplayElement{
+            {display_area.top_left + mir::geometry::Displacement{5, 5}, {10, 10}},
+            {{0, 0}, {10, 10}},
+            overlay_framebuffer});
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    ASSERT_TRUE(sink.overlay(renderlist));
+
+    EXPECT_CALL(
+        *mock_kms_output,
+        set_plane(overlay_plane_id, overlay_framebuffer.get(), mir::geometry::Rectangle{{5, 5}, {10, 10}}, _));
+    sink.post();
+    Mock::VerifyAndClearExpectations(mock_kms_output.get());
+
+    // Once the frame no longer needs it, the overlay plane is turned off
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    EXPECT_CALL(*mock_kms_output, set_plane(overlay_plane_id, nullptr, _, _));
+    sink.post();
+}
+
+TEST_F(MesaDisplaySinkTest, elements_without_a_suitable_plane_are_not_overlaid)
+{
+    auto const overlay_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    ON_CALL(*overlay_framebuffer, drm_fourcc()).WillByDefault(Return(DRM_FORMAT_ARGB8888));
+    ON_CALL(*overlay_framebuffer, size()).WillByDefault(Return(mir::geometry::Size{10, 10}));
+
+    auto renderlist = bypassable_list;
+    renderlist.push_back(
+        mir::graphics::DisplayElement{
+            {display_area.top_left + mir::geometry::Displacement{5, 5}, {10, 10}},
+            {{0, 0}, {10, 10}},
+            overlay_framebuffer});
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_FALSE(sink.overlay(renderlist));
+}
+
+TEST_F(MesaDisplaySinkTest, translucent_or_transformed_elements_are_not_overlaid)
+{
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    auto translucent = bypassable_list;
+    translucent.front().alpha = 0.5f;
+    EXPECT_FALSE(sink.overlay(translucent));
+
+    auto transformed = bypassable_list;
+    transformed.front().transformation = glm::mat4{0.5f};
+    EXPECT_FALSE(sink.overlay(transformed));
+
+    EXPECT_TRUE(sink.overlay(bypassable_list));
+}
+
+TEST_F(MesaDisplaySinkTest, overlay_planes_held_by_another_output_are_not_used)
+{
+    uint32_t const overlay_plane_id{51};
+    std::vector<KMSPlane> const planes{
+        KMSPlane{overlay_plane_id, KMSPlane::Type::overlay, {{DRM_FORMAT_ARGB8888, {}}}, std::nullopt}};
+    ON_CALL(*mock_kms_output, planes()).WillByDefault(ReturnRef(planes));
+
+    auto const overlay_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    ON_CALL(*overlay_framebuffer, drm_fourcc()).WillByDefault(Return(DRM_FORMAT_ARGB8888));
+    ON_CALL(*overlay_framebuffer, modifier()).WillByDefault(Return(DRM_FORMAT_MOD_INVALID));
+    ON_CALL(*overlay_framebuffer, size()).WillByDefault(Return(mir::geometry::Size{10, 10}));
+
+    auto renderlist = bypassable_list;
+    renderlist.push_back(
+        mir::graphics::DisplayElement{
+            {display_area.top_left + mir::geometry::Displacement{5, 5}, {10, 10}},
+            {{0, 0}, {10, 10}},
+            overlay_framebuffer});
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    // Another output took the plane between it being listed and being held
+    EXPECT_CALL(*mock_kms_output, claim_planes(ElementsAre(overlay_plane_id))).WillOnce(Return(false));
+    EXPECT_CALL(*mock_kms_output, claim_planes(IsEmpty())).Times(AtLeast(1));
+
+    EXPECT_FALSE(sink.overlay(renderlist));
+}
+
+TEST_F(MesaDisplaySinkTest, frame_shown_by_set_crtc_has_unknown_timing)
+{
+    graphics::Frame flipped;
+    flipped.msc = 7;
+    ON_CALL(*mock_kms_output, wait_for_page_flip()).WillByDefault(Return(flipped));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+    ASSERT_THAT(sink.last_frame().msc, Eq(7));
+
+    ON_CALL(*mock_kms_output, schedule_page_flip_thunk(_)).WillByDefault(Return(false));
+    EXPECT_CALL(*mock_kms_output, set_crtc_thunk(_));
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+    EXPECT_THAT(sink.last_frame().msc, Eq(0));
+}
+
+TEST_F(MesaDisplaySinkTest, clone_mode_frames_are_timed_a_refresh_interval_apart)
+{
+    // Flips land on successive vblanks of a 60Hz output
+    std::chrono::nanoseconds const vblank_interval{16'666'667};
+    graphics::Frame flipped;
+    flipped.ust = {CLOCK_MONOTONIC, std::chrono::seconds{1}};
+    auto const next_flip = [&]
+        {
+            flipped.msc++;
+            flipped.ust = flipped.ust + vblank_interval;
+            return flipped;
+        };
+
+    auto const other_kms_output = std::make_shared<NiceMock<MockKMSOutput>>();
+    ON_CALL(*mock_kms_output, wait_for_page_flip()).WillByDefault(Invoke(next_flip));
+    ON_CALL(*other_kms_output, wait_for_page_flip()).WillByDefault(Invoke([&] { return flipped; }));
+    for (auto const& output : {mock_kms_output, other_kms_output})
+    {
+        ON_CALL(*output, schedule_page_flip_thunk(_)).WillByDefault(Return(true));
+        ON_CALL(*output, max_refresh_rate()).WillByDefault(Return(mock_refresh_rate));
+    }
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, other_kms_output},
+        display_area,
+        identity);
+
+    // Nothing has been flipped to time the first frame against
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+    EXPECT_THAT(sink.last_frame().msc, Eq(0));
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+    sink.post();
+    auto previous = sink.last_frame();
+    EXPECT_THAT(previous.msc, Eq(flipped.msc + 1));
+
+    for (int frame = 0; frame != 3; ++frame)
+    {
+        ASSERT_TRUE(sink.overlay(bypassable_list));
+        sink.post();
+
+        auto const frame_timing = sink.last_frame();
+        EXPECT_THAT(frame_timing.msc, Eq(previous.msc + 1));
+        EXPECT_THAT(frame_timing.ust - previous.ust, Eq(vblank_interval));
+        previous = frame_timing;
+    }
+}
+
+TEST_F(MesaDisplaySinkTest, atomic_outputs_are_flipped_by_a_single_commit)
+{
+    auto const other_kms_output = std::make_shared<NiceMock<MockKMSOutput>>();
+    for (auto const& output : {mock_kms_output, other_kms_output})
+    {
+        ON_CALL(*output, supports_atomic()).WillByDefault(Return(true));
+        ON_CALL(*output, add_to_atomic_request(_, _, _)).WillByDefault(Return(true));
+        ON_CALL(*output, schedule_atomic_page_flip(_, _)).WillByDefault(Return(true));
+    }
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output, other_kms_output},
+        display_area,
+        identity);
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+
+    EXPECT_CALL(*mock_kms_output, add_to_atomic_request(_, _, _));
+    EXPECT_CALL(*other_kms_output, add_to_atomic_request(_, _, _));
+    EXPECT_CALL(*mock_kms_output, schedule_atomic_page_flip(_, _)).Times(1);
+    EXPECT_CALL(*other_kms_output, schedule_atomic_page_flip(_, _)).Times(0);
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_)).Times(0);
+    EXPECT_CALL(*other_kms_output, schedule_page_flip_thunk(_)).Times(0);
+
+    sink.post();
+}
+
+TEST_F(MesaDisplaySinkTest, falls_back_to_legacy_page_flip_if_atomic_commit_fails)
+{
+    ON_CALL(*mock_kms_output, supports_atomic()).WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, add_to_atomic_request(_, _, _)).WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, schedule_atomic_page_flip(_, _)).WillByDefault(Return(false));
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    ASSERT_TRUE(sink.overlay(bypassable_list));
+
+    EXPECT_CALL(*mock_kms_output, schedule_atomic_page_flip(_, _));
+    EXPECT_CALL(*mock_kms_output, schedule_page_flip_thunk(_));
+
+    sink.post();
+}
+
+TEST_F(MesaDisplaySinkTest, overlays_rejected_by_an_atomic_test_commit_are_not_used)
+{
+    uint32_t const overlay_plane_id{51};
+    std::vector<KMSPlane> const planes{
+        KMSPlane{overlay_plane_id, KMSPlane::Type::overlay, {{DRM_FORMAT_ARGB8888, {}}}, std::nullopt}};
+    ON_CALL(*mock_kms_output, planes()).WillByDefault(ReturnRef(planes));
+    ON_CALL(*mock_kms_output, supports_atomic()).WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, add_to_atomic_request(_, _, _)).WillByDefault(Return(true));
+    ON_CALL(*mock_kms_output, add_plane_to_atomic_request(_, _, _, _, _)).WillByDefault(Return(true));
+
+    auto const overlay_framebuffer = std::make_shared<NiceMock<MockKMSFramebuffer>>();
+    ON_CALL(*overlay_framebuffer, drm_fourcc()).WillByDefault(Return(DRM_FORMAT_ARGB8888));
+    ON_CALL(*overlay_framebuffer, modifier()).WillByDefault(Return(DRM_FORMAT_MOD_INVALID));
+    ON_CALL(*overlay_framebuffer, size()).WillByDefault(Return(mir::geometry::Size{10, 10}));
+
+    auto renderlist = bypassable_list;
+    renderlist.push_back(
+        mir::graphics::DisplayElement{
+            {display_area.top_left + mir::geometry::Displacement{5, 5}, {10, 10}},
+            {{0, 0}, {10, 10}},
+            overlay_framebuffer});
+
+    graphics::gbm::DisplaySink sink(
+        drm_fd,
+        gbm,
+        graphics::gbm::BypassOption::allowed,
+        null_display_report(),
+        {mock_kms_output},
+        display_area,
+        identity);
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, DRM_MODE_ATOMIC_TEST_ONLY, _))
+        .WillOnce(Return(-EINVAL));
+
+    EXPECT_FALSE(sink.overlay(renderlist));
+}
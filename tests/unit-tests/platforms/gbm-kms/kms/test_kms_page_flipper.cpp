@@ -15,6 +15,7 @@
  */
 
 #include "src/platforms/gbm-kms/server/kms/kms_page_flipper.h"
+#include "src/platforms/gbm-kms/server/kms/atomic_request.h"
 
 #include "mir/test/doubles/mock_drm.h"
 #include "mir/test/doubles/mock_display_report.h"
@@ -67,6 +68,16 @@ ACTION_P(InvokePageFlipHandler, param)
     ASSERT_EQ(1, read(arg0, &dummy, 1));
 }
 
+ACTION_P2(InvokeAtomicPageFlipHandler, param, crtc_id)
+{
+    int const dont_care{0};
+    char dummy;
+
+    ASSERT_GE(arg1->version, 3);
+    arg1->page_flip_handler2(dont_care, dont_care, dont_care, dont_care, crtc_id, *param);
+    ASSERT_EQ(1, read(arg0, &dummy, 1));
+}
+
 }
 
 TEST_F(KMSPageFlipperTest, schedule_flip_calls_drm_page_flip)
@@ -126,6 +137,52 @@ TEST_F(KMSPageFlipperTest, wait_for_flip_handles_drm_event)
     page_flipper.wait_for_flip(crtc_id);
 }
 
+TEST_F(KMSPageFlipperTest, atomic_flip_is_waited_for_on_each_crtc)
+{
+    using namespace testing;
+
+    uint32_t const crtc_ids[]{10, 11};
+    uint32_t const connector_ids[]{345, 346};
+    void* user_data{nullptr};
+
+    ON_CALL(mock_drm, drmGetCap(drm_fd, DRM_CAP_CRTC_IN_VBLANK_EVENT, _))
+        .WillByDefault(DoAll(SetArgPointee<2>(1), Return(0)));
+    mgg::KMSPageFlipper atomic_page_flipper{drm_fd, mt::fake_shared(report)};
+
+    mgg::AtomicRequest request;
+    request.add_flip(crtc_ids[0], connector_ids[0]);
+    request.add_flip(crtc_ids[1], connector_ids[1]);
+
+    // A single commit for both CRTCs
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(drm_fd, _, DRM_MODE_PAGE_FLIP_EVENT | DRM_MODE_ATOMIC_NONBLOCK, _))
+        .WillOnce(DoAll(SaveArg<3>(&user_data), Return(0)));
+
+    EXPECT_CALL(mock_drm, drmHandleEvent(drm_fd, _))
+        .WillOnce(DoAll(InvokeAtomicPageFlipHandler(&user_data, crtc_ids[0]), Return(0)))
+        .WillOnce(DoAll(InvokeAtomicPageFlipHandler(&user_data, crtc_ids[1]), Return(0)));
+
+    EXPECT_TRUE(atomic_page_flipper.schedule_atomic_flip(request, 0));
+
+    mock_drm.generate_event_on(drm_device);
+    atomic_page_flipper.wait_for_flip(crtc_ids[0]);
+
+    mock_drm.generate_event_on(drm_device);
+    atomic_page_flipper.wait_for_flip(crtc_ids[1]);
+}
+
+TEST_F(KMSPageFlipperTest, atomic_flip_is_refused_if_events_do_not_say_which_crtc_flipped)
+{
+    using namespace testing;
+
+    mgg::AtomicRequest request;
+    request.add_flip(10, 345);
+
+    EXPECT_CALL(mock_drm, drmModeAtomicCommit(_, _, _, _))
+        .Times(0);
+
+    EXPECT_FALSE(page_flipper.schedule_atomic_flip(request, 0));
+}
+
 TEST_F(KMSPageFlipperTest, wait_for_flip_reports_vsync)
 {
     using namespace testing;
@@ -0,0 +1,391 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/platforms/gbm-kms/server/kms/plane_assignment.h"
+#include "kms_framebuffer.h"
+
+#include "mir/test/doubles/mock_drm.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <fcntl.h>
+#include <drm_fourcc.h>
+
+namespace mg = mir::graphics;
+namespace mgg = mir::graphics::gbm;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+class StubKMSFramebuffer : public mg::FBHandle
+{
+public:
+    StubKMSFramebuffer(geom::Size size, uint32_t fourcc, uint64_t modifier)
+        : size_{size},
+          fourcc{fourcc},
+          modifier_{modifier}
+    {
+    }
+
+    operator uint32_t() const override
+    {
+        return 42;
+    }
+
+    auto drm_fourcc() const -> uint32_t override
+    {
+        return fourcc;
+    }
+
+    auto modifier() const -> uint64_t override
+    {
+        return modifier_;
+    }
+
+    auto size() const -> geom::Size override
+    {
+        return size_;
+    }
+
+private:
+    geom::Size const size_;
+    uint32_t const fourcc;
+    uint64_t const modifier_;
+};
+
+auto element(
+    geom::Rectangle const& position,
+    uint32_t fourcc = DRM_FORMAT_ARGB8888,
+    uint64_t modifier = DRM_FORMAT_MOD_INVALID) -> mg::DisplayElement
+{
+    return mg::DisplayElement{
+        position,
+        geom::RectangleF{
+            {0, 0},
+            {position.size.width.as_value(), position.size.height.as_value()}},
+        std::make_shared<StubKMSFramebuffer>(position.size, fourcc, modifier)};
+}
+
+auto plane(
+    uint32_t id,
+    mgg::KMSPlane::Type type,
+    std::optional<uint64_t> zpos = std::nullopt) -> mgg::KMSPlane
+{
+    return mgg::KMSPlane{
+        id,
+        type,
+        {{DRM_FORMAT_XRGB8888, {}}, {DRM_FORMAT_ARGB8888, {}}},
+        zpos};
+}
+
+struct PlaneAssignment : Test
+{
+    geom::Rectangle const view_area{{0, 0}, {1920, 1080}};
+    mg::DisplayElement const fullscreen{element(view_area, DRM_FORMAT_XRGB8888)};
+
+    uint32_t const primary_id{50};
+    uint32_t const overlay_id{51};
+    uint32_t const other_overlay_id{52};
+    uint32_t const cursor_id{53};
+};
+
+struct PlaneEnumeration : Test
+{
+    char const* const drm_device = "/dev/dri/card0";
+    NiceMock<mtd::MockDRM> mock_drm;
+
+    // FakeDRMResources' default CRTCs
+    uint32_t const crtc0_id{10};
+    uint32_t const crtc1_id{11};
+};
+}
+
+TEST_F(PlaneAssignment, lone_fullscreen_element_goes_on_primary_plane)
+{
+    std::vector<mgg::KMSPlane> const planes{plane(primary_id, mgg::KMSPlane::Type::primary)};
+
+    auto const assignment = mgg::assign_planes(planes, {fullscreen}, view_area, true);
+
+    ASSERT_TRUE(assignment);
+    EXPECT_THAT(*assignment, IsEmpty());
+}
+
+TEST_F(PlaneAssignment, primary_plane_is_assumed_to_work_when_not_enumerated)
+{
+    auto const assignment = mgg::assign_planes({}, {fullscreen}, view_area, true);
+
+    ASSERT_TRUE(assignment);
+    EXPECT_THAT(*assignment, IsEmpty());
+}
+
+TEST_F(PlaneAssignment, bottom_element_must_cover_view_area)
+{
+    std::vector<mgg::KMSPlane> const planes{plane(primary_id, mgg::KMSPlane::Type::primary)};
+    auto const windowed = element({{10, 10}, {640, 480}});
+
+    EXPECT_FALSE(mgg::assign_planes(planes, {windowed}, view_area, true));
+}
+
+TEST_F(PlaneAssignment, bottom_element_must_be_in_a_format_the_primary_plane_supports)
+{
+    std::vector<mgg::KMSPlane> const planes{plane(primary_id, mgg::KMSPlane::Type::primary)};
+    auto const nv12 = element(view_area, DRM_FORMAT_NV12);
+
+    EXPECT_FALSE(mgg::assign_planes(planes, {nv12}, view_area, true));
+}
+
+TEST_F(PlaneAssignment, elements_that_are_not_kms_framebuffers_are_not_assigned)
+{
+    auto not_a_kms_framebuffer = fullscreen;
+    not_a_kms_framebuffer.buffer = nullptr;
+
+    EXPECT_FALSE(mgg::assign_planes({}, {not_a_kms_framebuffer}, view_area, true));
+}
+
+TEST_F(PlaneAssignment, elements_above_primary_go_on_overlay_planes_in_stacking_order)
+{
+    std::vector<mgg::KMSPlane> const planes{
+        plane(primary_id, mgg::KMSPlane::Type::primary),
+        plane(other_overlay_id, mgg::KMSPlane::Type::overlay, 3),
+        plane(overlay_id, mgg::KMSPlane::Type::overlay, 2)};
+
+    auto const assignment = mgg::assign_planes(
+        planes,
+        {fullscreen, element({{10, 10}, {100, 100}}), element({{50, 50}, {100, 100}})},
+        view_area,
+        true);
+
+    ASSERT_TRUE(assignment);
+    EXPECT_THAT(*assignment, ElementsAre(overlay_id, other_overlay_id));
+}
+
+TEST_F(PlaneAssignment, elements_need_a_plane_each)
+{
+    std::vector<mgg::KMSPlane> const planes{
+        plane(primary_id, mgg::KMSPlane::Type::primary),
+        plane(overlay_id, mgg::KMSPlane::Type::overlay)};
+
+    EXPECT_FALSE(mgg::assign_planes(
+        planes,
+        {fullscreen, element({{10, 10}, {100, 100}}), element({{50, 50}, {100, 100}})},
+        view_area,
+        true));
+}
+
+TEST_F(PlaneAssignment, skips_overlay_planes_that_cannot_scan_out_the_format)
+{
+    auto yuv_overlay = plane(other_overlay_id, mgg::KMSPlane::Type::overlay, 2);
+    yuv_overlay.formats = {{DRM_FORMAT_NV12, {}}};
+    std::vector<mgg::KMSPlane> const planes{
+        plane(primary_id, mgg::KMSPlane::Type::primary),
+        plane(overlay_id, mgg::KMSPlane::Type::overlay, 1),
+        yuv_overlay};
+
+    auto const assignment = mgg::assign_planes(
+        planes,
+        {fullscreen, element({{10, 10}, {100, 100}}, DRM_FORMAT_NV12)},
+        view_area,
+        true);
+
+    ASSERT_TRUE(assignment);
+    EXPECT_THAT(*assignment, ElementsAre(other_overlay_id));
+}
+
+TEST_F(PlaneAssignment, does_not_use_planes_below_the_one_showing_the_element_beneath)
+{
+    auto yuv_overlay = plane(overlay_id, mgg::KMSPlane::Type::overlay, 2);
+    yuv_overlay.formats = {{DRM_FORMAT_NV12, {}}};
+    std::vector<mgg::KMSPlane> const planes{
+        plane(primary_id, mgg::KMSPlane::Type::primary),
+        plane(other_overlay_id, mgg::KMSPlane::Type::overlay, 1),
+        yuv_overlay};
+
+    // The NV12 element takes the top plane, which leaves nowhere above it for the ARGB element
+    EXPECT_FALSE(mgg::assign_planes(
+        planes,
+        {fullscreen, element({{10, 10}, {100, 100}}, DRM_FORMAT_NV12), element({{50, 50}, {100, 100}})},
+        view_area,
+        true));
+}
+
+TEST_F(PlaneAssignment, explicit_modifiers_must_be_listed_by_the_plane)
+{
+    uint64_t const tiled = I915_FORMAT_MOD_X_TILED;
+    auto overlay = plane(overlay_id, mgg::KMSPlane::Type::overlay);
+    overlay.formats = {{DRM_FORMAT_ARGB8888, {DRM_FORMAT_MOD_LINEAR}}};
+    std::vector<mgg::KMSPlane> const planes{plane(primary_id, mgg::KMSPlane::Type::primary), overlay};
+
+    EXPECT_FALSE(mgg::assign_planes(
+        planes, {fullscreen, element({{10, 10}, {100, 100}}, DRM_FORMAT_ARGB8888, tiled)}, view_area, true));
+    EXPECT_TRUE(mgg::assign_planes(
+        planes,
+        {fullscreen, element({{10, 10}, {100, 100}}, DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR)},
+        view_area,
+        true));
+}
+
+TEST_F(PlaneAssignment, planes_without_modifier_information_only_take_linear_or_implicit_layouts)
+{
+    auto const plane = ::plane(overlay_id, mgg::KMSPlane::Type::overlay);
+
+    EXPECT_TRUE(plane.supports(DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_INVALID));
+    EXPECT_TRUE(plane.supports(DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_LINEAR));
+    EXPECT_FALSE(plane.supports(DRM_FORMAT_ARGB8888, I915_FORMAT_MOD_X_TILED));
+}
+
+TEST_F(PlaneAssignment, only_overlay_planes_scale)
+{
+    auto scaled = element({{10, 10}, {200, 200}});
+    scaled.source_position.size = {100, 100};
+    scaled.buffer = std::make_shared<StubKMSFramebuffer>(
+        geom::Size{100, 100}, DRM_FORMAT_ARGB8888, DRM_FORMAT_MOD_INVALID);
+
+    std::vector<mgg::KMSPlane> const cursor_only{
+        plane(primary_id, mgg::KMSPlane::Type::primary),
+        plane(cursor_id, mgg::KMSPlane::Type::cursor)};
+    std::vector<mgg::KMSPlane> const with_overlay{
+        plane(primary_id, mgg::KMSPlane::Type::primary),
+        plane(overlay_id, mgg::KMSPlane::Type::overlay)};
+
+    EXPECT_FALSE(mgg::assign_planes(cursor_only, {fullscreen, scaled}, view_area, true));
+    EXPECT_TRUE(mgg::assign_planes(with_overlay, {fullscreen, scaled}, view_area, true));
+}
+
+TEST_F(PlaneAssignment, cursor_planes_are_only_used_when_allowed)
+{
+    std::vector<mgg::KMSPlane> const planes{
+        plane(primary_id, mgg::KMSPlane::Type::primary),
+        plane(cursor_id, mgg::KMSPlane::Type::cursor)};
+    std::vector<mg::DisplayElement> const renderlist{fullscreen, element({{10, 10}, {64, 64}})};
+
+    auto const assignment = mgg::assign_planes(planes, renderlist, view_area, true);
+
+    ASSERT_TRUE(assignment);
+    EXPECT_THAT(*assignment, ElementsAre(cursor_id));
+    EXPECT_FALSE(mgg::assign_planes(planes, renderlist, view_area, false));
+}
+
+TEST_F(PlaneAssignment, elements_must_be_within_view_area)
+{
+    std::vector<mgg::KMSPlane> const planes{
+        plane(primary_id, mgg::KMSPlane::Type::primary),
+        plane(overlay_id, mgg::KMSPlane::Type::overlay)};
+
+    EXPECT_FALSE(mgg::assign_planes(planes, {fullscreen, element({{1900, 10}, {100, 100}})}, view_area, true));
+}
+
+TEST_F(PlaneAssignment, elements_must_sample_within_their_framebuffer)
+{
+    std::vector<mgg::KMSPlane> const planes{
+        plane(primary_id, mgg::KMSPlane::Type::primary),
+        plane(overlay_id, mgg::KMSPlane::Type::overlay)};
+    auto overhanging = element({{10, 10}, {100, 100}});
+    overhanging.source_position.top_left = {50, 0};
+
+    EXPECT_FALSE(mgg::assign_planes(planes, {fullscreen, overhanging}, view_area, true));
+}
+
+TEST_F(PlaneEnumeration, lists_only_planes_usable_by_the_crtc)
+{
+    mock_drm.add_plane(drm_device, 50, 0x1, DRM_PLANE_TYPE_PRIMARY, {DRM_FORMAT_XRGB8888});
+    mock_drm.add_plane(drm_device, 51, 0x2, DRM_PLANE_TYPE_PRIMARY, {DRM_FORMAT_XRGB8888});
+    mock_drm.add_plane(drm_device, 52, 0x3, DRM_PLANE_TYPE_OVERLAY, {DRM_FORMAT_ARGB8888, DRM_FORMAT_NV12});
+    mock_drm.add_plane(drm_device, 53, 0x2, DRM_PLANE_TYPE_CURSOR, {DRM_FORMAT_ARGB8888});
+    mock_drm.prepare(drm_device);
+
+    auto const drm_fd = open(drm_device, 0, 0);
+    auto const planes = mgg::planes_for_crtc(drm_fd, crtc1_id);
+
+    ASSERT_THAT(planes, SizeIs(3));
+    EXPECT_THAT(planes[0].id, Eq(51u));
+    EXPECT_THAT(planes[0].type, Eq(mgg::KMSPlane::Type::primary));
+    EXPECT_THAT(planes[1].id, Eq(52u));
+    EXPECT_THAT(planes[1].type, Eq(mgg::KMSPlane::Type::overlay));
+    EXPECT_TRUE(planes[1].supports(DRM_FORMAT_NV12, DRM_FORMAT_MOD_LINEAR));
+    EXPECT_FALSE(planes[1].supports(DRM_FORMAT_XRGB8888, DRM_FORMAT_MOD_LINEAR));
+    EXPECT_THAT(planes[2].id, Eq(53u));
+    EXPECT_THAT(planes[2].type, Eq(mgg::KMSPlane::Type::cursor));
+}
+
+TEST_F(PlaneEnumeration, unknown_crtc_throws)
+{
+    mock_drm.add_plane(drm_device, 50, 0x1, DRM_PLANE_TYPE_PRIMARY, {DRM_FORMAT_XRGB8888});
+    mock_drm.prepare(drm_device);
+
+    auto const drm_fd = open(drm_device, 0, 0);
+
+    EXPECT_THROW(mgg::planes_for_crtc(drm_fd, 99), std::runtime_error);
+}
+
+TEST_F(PlaneEnumeration, enumerated_planes_can_be_assigned)
+{
+    mock_drm.add_plane(drm_device, 50, 0x1, DRM_PLANE_TYPE_PRIMARY, {DRM_FORMAT_XRGB8888});
+    mock_drm.add_plane(drm_device, 51, 0x1, DRM_PLANE_TYPE_OVERLAY, {DRM_FORMAT_ARGB8888});
+    mock_drm.prepare(drm_device);
+
+    auto const drm_fd = open(drm_device, 0, 0);
+    geom::Rectangle const view_area{{0, 0}, {1920, 1080}};
+
+    auto const assignment = mgg::assign_planes(
+        mgg::planes_for_crtc(drm_fd, crtc0_id),
+        {element(view_area, DRM_FORMAT_XRGB8888), element({{10, 10}, {100, 100}})},
+        view_area,
+        true);
+
+    ASSERT_TRUE(assignment);
+    EXPECT_THAT(*assignment, ElementsAre(51u));
+}
+
+TEST(PlaneClaims, planes_are_available_until_held_by_another_owner)
+{
+    mgg::PlaneClaims claims;
+    int const first{0}, second{0};
+
+    EXPECT_TRUE(claims.hold(&first, {51, 52}));
+
+    EXPECT_TRUE(claims.available_to(&first, 51));
+    EXPECT_FALSE(claims.available_to(&second, 51));
+    EXPECT_TRUE(claims.available_to(&second, 53));
+}
+
+TEST(PlaneClaims, holding_a_plane_another_owner_holds_fails_and_changes_nothing)
+{
+    mgg::PlaneClaims claims;
+    int const first{0}, second{0};
+    ASSERT_TRUE(claims.hold(&first, {51}));
+    ASSERT_TRUE(claims.hold(&second, {52}));
+
+    EXPECT_FALSE(claims.hold(&second, {51, 53}));
+
+    EXPECT_FALSE(claims.available_to(&first, 52));
+    EXPECT_TRUE(claims.available_to(&first, 53));
+}
+
+TEST(PlaneClaims, planes_no_longer_held_are_released)
+{
+    mgg::PlaneClaims claims;
+    int const first{0}, second{0};
+    ASSERT_TRUE(claims.hold(&first, {51, 52}));
+
+    EXPECT_TRUE(claims.hold(&first, {52}));
+    EXPECT_TRUE(claims.hold(&second, {51}));
+
+    EXPECT_TRUE(claims.hold(&first, {}));
+    EXPECT_TRUE(claims.available_to(&second, 52));
+}
@@ -17,6 +17,7 @@
 #include "kms_framebuffer.h"
 #include "src/platforms/gbm-kms/server/kms/real_kms_output.h"
 #include "src/platforms/gbm-kms/server/kms/page_flipper.h"
+#include "src/platforms/gbm-kms/server/kms/atomic_request.h"
 #include "mir/fatal.h"
 
 #include "mir/test/fake_shared.h"
@@ -25,10 +26,12 @@
 #include "mir/test/doubles/mock_gbm.h"
 
 #include <stdexcept>
+#include <unordered_map>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <fcntl.h>
+#include <drm_fourcc.h>
 
 namespace mg = mir::graphics;
 namespace mgg = mir::graphics::gbm;
@@ -45,6 +48,7 @@ class NullPageFlipper : public mgg::PageFlipper
 {
 public:
     bool schedule_flip(uint32_t,uint32_t,uint32_t) override { return true; }
+    bool schedule_atomic_flip(mgg::AtomicRequest const&, uint32_t) override { return true; }
     mg::Frame wait_for_flip(uint32_t) override { return {}; }
 };
 
@@ -52,6 +56,7 @@ class MockPageFlipper : public mgg::PageFlipper
 {
 public:
     MOCK_METHOD3(schedule_flip, bool(uint32_t,uint32_t,uint32_t));
+    MOCK_METHOD(bool, schedule_atomic_flip, (mgg::AtomicRequest const&, uint32_t), (override));
     MOCK_METHOD1(wait_for_flip, mg::Frame(uint32_t));
 };
 
@@ -68,6 +73,16 @@ public:
         return fb_id;
     }
 
+    auto drm_fourcc() const -> uint32_t override
+    {
+        return DRM_FORMAT_XRGB8888;
+    }
+
+    auto modifier() const -> uint64_t override
+    {
+        return DRM_FORMAT_MOD_INVALID;
+    }
+
     auto size() const -> geom::Size override
     {
         return {};
@@ -168,6 +183,47 @@ public:
         mock_drm.prepare(drm_device);
     }
 
+    /// An output whose CRTC has a primary and an overlay plane, with the properties atomic requests use
+    void setup_atomic_output()
+    {
+        uint32_t const possible_crtcs_mask{0x1};
+
+        modes.push_back(mtd::FakeDRMResources::create_mode(1920, 1080, 138500, 2080, 1111,
+                                                           mtd::FakeDRMResources::PreferredMode));
+
+        mock_drm.reset(drm_device);
+
+        mock_drm.add_crtc(drm_device, crtc_ids[0], modes[0]);
+        mock_drm.add_encoder(drm_device, encoder_ids[0], crtc_ids[0], possible_crtcs_mask);
+        mock_drm.add_connector(
+            drm_device,
+            connector_ids[0],
+            DRM_MODE_CONNECTOR_VGA,
+            DRM_MODE_CONNECTED,
+            encoder_ids[0],
+            modes,
+            possible_encoder_ids1,
+            geom::Size());
+        mock_drm.add_plane(drm_device, primary_plane_id, possible_crtcs_mask, DRM_PLANE_TYPE_PRIMARY,
+                           {DRM_FORMAT_XRGB8888});
+        mock_drm.add_plane(drm_device, overlay_plane_id, possible_crtcs_mask, DRM_PLANE_TYPE_OVERLAY,
+                           {DRM_FORMAT_XRGB8888});
+
+        mode_id_property = mock_drm.add_property(drm_device, crtc_ids[0], "MODE_ID", 0);
+        active_property = mock_drm.add_property(drm_device, crtc_ids[0], "ACTIVE", 0);
+        connector_crtc_id_property = mock_drm.add_property(drm_device, connector_ids[0], "CRTC_ID", 0);
+        for (auto const plane_id : {primary_plane_id, overlay_plane_id})
+        {
+            for (auto const name : {"FB_ID", "CRTC_ID", "SRC_X", "SRC_Y", "SRC_W", "SRC_H",
+                                    "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H"})
+            {
+                plane_properties[name] = mock_drm.add_property(drm_device, plane_id, name, 0);
+            }
+        }
+
+        mock_drm.prepare(drm_device);
+    }
+
     void append_fb_id(uint32_t fb_id)
     {
         EXPECT_CALL(mock_drm, drmModeAddFB2(_,_,_,_,_,_,_,_,_))
@@ -181,7 +237,16 @@ public:
     testing::NiceMock<mtd::MockGBM> mock_gbm;
     MockPageFlipper mock_page_flipper;
     NullPageFlipper null_page_flipper;
+    std::shared_ptr<mgg::PlaneClaims> const plane_claims{std::make_shared<mgg::PlaneClaims>()};
     std::vector<drmModeModeInfo> modes_empty;
+    std::vector<drmModeModeInfo> modes;
+
+    uint32_t const primary_plane_id{50};
+    uint32_t const overlay_plane_id{51};
+    uint32_t mode_id_property{0};
+    uint32_t active_property{0};
+    uint32_t connector_crtc_id_property{0};
+    std::unordered_map<std::string, uint32_t> plane_properties;
 
     char const* const drm_device = "/dev/dri/card0";
     int const drm_fd;
@@ -228,7 +293,8 @@ TEST_F(RealKMSOutputTest, operations_use_existing_crtc)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
 
     EXPECT_TRUE(output.set_crtc(*fb));
     EXPECT_TRUE(output.schedule_page_flip(*fb));
@@ -267,13 +333,47 @@ TEST_F(RealKMSOutputTest, operations_use_possible_crtc)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
 
     EXPECT_TRUE(output.set_crtc(*fb));
     EXPECT_TRUE(output.schedule_page_flip(*fb));
     output.wait_for_page_flip();
 }
 
+TEST_F(RealKMSOutputTest, wait_for_page_flip_returns_the_presented_frame)
+{
+    using namespace testing;
+
+    setup_outputs_connected_crtc();
+
+    uint32_t const fb_id{42};
+    auto const fb = std::make_shared<MockKMSFramebuffer>(fb_id);
+
+    mg::Frame presented;
+    presented.msc = 1234;
+    presented.ust = {CLOCK_MONOTONIC, std::chrono::nanoseconds{5678}};
+
+    EXPECT_CALL(mock_drm, drmModeSetCrtc(_, _, _, _, _, _, _, _)).Times(AnyNumber());
+    EXPECT_CALL(mock_page_flipper, schedule_flip(crtc_ids[0], fb_id, connector_ids[0]))
+        .WillOnce(Return(true));
+    EXPECT_CALL(mock_page_flipper, wait_for_flip(crtc_ids[0]))
+        .WillOnce(Return(presented));
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
+
+    EXPECT_TRUE(output.set_crtc(*fb));
+    EXPECT_TRUE(output.schedule_page_flip(*fb));
+
+    auto const frame = output.wait_for_page_flip();
+    EXPECT_THAT(frame.msc, Eq(presented.msc));
+    EXPECT_THAT(frame.ust, Eq(presented.ust));
+}
+
 TEST_F(RealKMSOutputTest, set_crtc_failure_is_handled_gracefully)
 {
     mir::FatalErrorStrategy on_error{mir::fatal_error_except};
@@ -304,7 +404,8 @@ TEST_F(RealKMSOutputTest, set_crtc_failure_is_handled_gracefully)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
 
     EXPECT_FALSE(output.set_crtc(*fb));
 
@@ -325,7 +426,8 @@ TEST_F(RealKMSOutputTest, clear_crtc_gets_crtc_if_none_is_current)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
 
     EXPECT_CALL(mock_drm, drmModeSetCrtc(_, crtc_ids[0], 0, 0, 0, nullptr, 0, nullptr))
         .Times(1)
@@ -362,7 +464,8 @@ TEST_F(RealKMSOutputTest, clear_crtc_does_not_throw_if_no_crtc_is_found)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
 
     EXPECT_CALL(mock_drm, drmModeSetCrtc(_, _, 0, 0, 0, nullptr, 0, nullptr))
         .Times(0);
@@ -383,7 +486,8 @@ TEST_F(RealKMSOutputTest, cursor_move_permission_failure_is_non_fatal)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
 
     auto const fb = std::make_shared<MockKMSFramebuffer>(4);
 
@@ -411,7 +515,8 @@ TEST_F(RealKMSOutputTest, cursor_set_permission_failure_is_non_fatal)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
 
     auto const fb = std::make_shared<MockKMSFramebuffer>(0x42);
 
@@ -440,7 +545,8 @@ TEST_F(RealKMSOutputTest, has_no_cursor_if_no_hardware_support)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
 
     auto const fb = std::make_shared<MockKMSFramebuffer>(42);
 
@@ -461,7 +567,8 @@ TEST_F(RealKMSOutputTest, clear_crtc_is_non_fatal_on_permission_error)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
 
     EXPECT_CALL(mock_drm, drmModeSetCrtc(_, crtc_ids[0], 0, 0, 0, nullptr, 0, nullptr))
         .Times(2)
@@ -487,7 +594,8 @@ TEST_F(RealKMSOutputTest, clear_crtc_throws_if_drm_call_fails_for_non_permission
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
 
     EXPECT_CALL(mock_drm, drmModeSetCrtc(_, crtc_ids[0], 0, 0, 0, nullptr, 0, nullptr))
         .Times(1)
@@ -509,7 +617,8 @@ TEST_F(RealKMSOutputTest, drm_set_gamma)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
 
     mg::GammaCurves gamma{{1}, {2}, {3}};
 
@@ -538,7 +647,8 @@ TEST_F(RealKMSOutputTest, drm_set_gamma_failure_does_not_throw)
     mgg::RealKMSOutput output{
         drm_fd,
         mg::kms::get_connector(drm_fd, connector_ids[0]),
-        mt::fake_shared(mock_page_flipper)};
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
 
     mg::GammaCurves gamma{{1}, {2}, {3}};
 
@@ -555,3 +665,107 @@ TEST_F(RealKMSOutputTest, drm_set_gamma_failure_does_not_throw)
 
     EXPECT_NO_THROW(output.set_gamma(gamma););
 }
+
+TEST_F(RealKMSOutputTest, does_not_support_atomic_without_atomic_properties)
+{
+    setup_outputs_connected_crtc();
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper),
+        plane_claims};
+
+    EXPECT_FALSE(output.supports_atomic());
+}
+
+TEST_F(RealKMSOutputTest, atomic_request_shows_framebuffer_on_primary_plane)
+{
+    setup_atomic_output();
+
+    uint32_t const fb_id{67};
+    MockKMSFramebuffer fb{fb_id};
+
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, primary_plane_id, plane_properties["FB_ID"], fb_id));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, primary_plane_id, plane_properties["CRTC_ID"], crtc_ids[0]));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, primary_plane_id, plane_properties["CRTC_W"], 1920));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, primary_plane_id, plane_properties["SRC_H"], 1080 << 16));
+    // Not a mode set
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, crtc_ids[0], _, _)).Times(0);
+    EXPECT_CALL(mock_drm, drmModeCreatePropertyBlob(_, _, _, _)).Times(0);
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper),
+        plane_claims};
+
+    ASSERT_TRUE(output.supports_atomic());
+
+    mgg::AtomicRequest request;
+    EXPECT_TRUE(output.add_to_atomic_request(request, fb, false));
+
+    ASSERT_THAT(request.flips(), SizeIs(1));
+    EXPECT_THAT(request.flips()[0].crtc_id, Eq(crtc_ids[0]));
+    EXPECT_THAT(request.flips()[0].connector_id, Eq(connector_ids[0]));
+}
+
+TEST_F(RealKMSOutputTest, atomic_modeset_sets_mode_and_connects_crtc)
+{
+    setup_atomic_output();
+
+    uint32_t const fb_id{67};
+    uint32_t const mode_blob_id{77};
+    MockKMSFramebuffer fb{fb_id};
+
+    EXPECT_CALL(mock_drm, drmModeCreatePropertyBlob(_, _, sizeof(drmModeModeInfo), _))
+        .WillOnce(DoAll(SetArgPointee<3>(mode_blob_id), Return(0)));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, crtc_ids[0], mode_id_property, mode_blob_id));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, crtc_ids[0], active_property, 1));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, connector_ids[0], connector_crtc_id_property, crtc_ids[0]));
+    EXPECT_CALL(mock_drm, drmModeDestroyPropertyBlob(_, mode_blob_id));
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper),
+        plane_claims};
+
+    mgg::AtomicRequest request;
+    EXPECT_TRUE(output.add_to_atomic_request(request, fb, true));
+}
+
+TEST_F(RealKMSOutputTest, atomic_request_disables_overlay_plane_without_framebuffer)
+{
+    setup_atomic_output();
+
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, overlay_plane_id, plane_properties["FB_ID"], 0));
+    EXPECT_CALL(mock_drm, drmModeAtomicAddProperty(_, overlay_plane_id, plane_properties["CRTC_ID"], 0));
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(null_page_flipper),
+        plane_claims};
+
+    mgg::AtomicRequest request;
+    EXPECT_TRUE(output.add_plane_to_atomic_request(request, overlay_plane_id, nullptr, {}, {}));
+    EXPECT_FALSE(output.add_plane_to_atomic_request(request, 99, nullptr, {}, {}));
+}
+
+TEST_F(RealKMSOutputTest, atomic_page_flip_is_scheduled_by_page_flipper)
+{
+    setup_atomic_output();
+
+    EXPECT_CALL(mock_page_flipper, schedule_atomic_flip(_, DRM_MODE_ATOMIC_ALLOW_MODESET))
+        .WillOnce(Return(true));
+
+    mgg::RealKMSOutput output{
+        drm_fd,
+        mg::kms::get_connector(drm_fd, connector_ids[0]),
+        mt::fake_shared(mock_page_flipper),
+        plane_claims};
+
+    mgg::AtomicRequest request;
+    EXPECT_TRUE(output.schedule_atomic_page_flip(request, DRM_MODE_ATOMIC_ALLOW_MODESET));
+}
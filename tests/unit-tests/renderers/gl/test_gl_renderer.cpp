@@ -14,6 +14,8 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <array>
+#include <set>
 #include <stdexcept>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -35,7 +37,15 @@ using testing::ReturnRef;
 using testing::Pointee;
 using testing::AnyNumber;
 using testing::AtLeast;
+using testing::AllOf;
 using testing::DoAll;
+using testing::Eq;
+using testing::Gt;
+using testing::Le;
+using testing::Property;
+using testing::IsNull;
+using testing::Ne;
+using testing::NotNull;
 using testing::_;
 
 namespace mt=mir::test;
@@ -167,7 +177,10 @@ public:
 
 auto make_output_surface() -> std::unique_ptr<mtd::MockOutputSurface>
 {
-    return std::make_unique<testing::NiceMock<mtd::MockOutputSurface>>();
+    auto output_surface = std::make_unique<testing::NiceMock<mtd::MockOutputSurface>>();
+    ON_CALL(*output_surface, layout())
+        .WillByDefault(Return(mg::gl::OutputSurface::Layout::GL));
+    return output_surface;
 }
 
 }
@@ -291,6 +304,22 @@ TEST_F(GLRenderer, sets_scissor_test)
     renderer.render(renderable_list);
 }
 
+TEST_F(GLRenderer, sets_scissor_from_top_for_top_row_first_surfaces)
+{
+    EXPECT_CALL(*renderable, clip_area())
+        .WillRepeatedly(Return(std::optional<mir::geometry::Rectangle>({{0,1},{2,3}})));
+    EXPECT_CALL(mock_gl, glScissor(-1, -1, 2, 3));
+
+    auto output_surface = make_output_surface();
+    ON_CALL(*output_surface, layout())
+        .WillByDefault(Return(mg::gl::OutputSurface::Layout::TopRowFirst));
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport({{1, 2}, {3, 4}});
+
+    renderer.render(renderable_list);
+}
+
 TEST_F(GLRenderer, dont_set_scissor_test_when_unnecessary)
 {
     EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST)).Times(0);
@@ -436,3 +465,373 @@ TEST_F(GLRenderer, sets_viewport_downscaled_wide)
     mrg::Renderer renderer(gl_platform, std::move(output_surface));
     renderer.set_viewport(view_area);
 }
+
+namespace
+{
+auto make_aged_output_surface(
+    mir::geometry::Size size,
+    int age,
+    mg::gl::OutputSurface::Layout layout = mg::gl::OutputSurface::Layout::GL) -> std::unique_ptr<mtd::MockOutputSurface>
+{
+    auto output_surface = make_output_surface();
+
+    ON_CALL(*output_surface, size())
+        .WillByDefault(Return(size));
+    ON_CALL(*output_surface, layout())
+        .WillByDefault(Return(layout));
+    ON_CALL(*output_surface, buffer_age())
+        .WillByDefault(Return(age));
+
+    return output_surface;
+}
+}
+
+TEST_F(GLRenderer, redraws_only_damaged_area_when_buffer_contents_are_known)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    auto output_surface = make_aged_output_surface(view_area.size, 1);
+    auto& surface = *output_surface;
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+
+    // The renderable is at {1,2} {3,4}, well clear of the damage
+    renderer.set_damage({{{10, 20}, {30, 40}}});
+    EXPECT_CALL(*renderable, transformation())
+        .WillRepeatedly(Return(glm::mat4{1}));
+
+    EXPECT_CALL(surface, set_damage(mir::geometry::Rectangles{{{10, 1020}, {30, 40}}}));
+    EXPECT_CALL(mock_gl, glScissor(10, 1020, 30, 40));
+    EXPECT_CALL(mock_gl, glClear(_));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(0);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, redraws_only_damaged_area_of_top_row_first_surfaces)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    auto output_surface = make_aged_output_surface(view_area.size, 1, mg::gl::OutputSurface::Layout::TopRowFirst);
+    auto& surface = *output_surface;
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+
+    renderer.set_damage({{{10, 20}, {30, 40}}});
+
+    EXPECT_CALL(surface, set_damage(mir::geometry::Rectangles{{{10, 20}, {30, 40}}}));
+    EXPECT_CALL(mock_gl, glScissor(10, 20, 30, 40)).Times(AtLeast(1));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, redraws_renderables_overlapping_damage_within_damaged_area)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    auto output_surface = make_aged_output_surface(view_area.size, 1);
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+
+    renderer.set_damage({{{2, 3}, {10, 10}}});
+
+    EXPECT_CALL(mock_gl, glScissor(2, 1067, 10, 10)).Times(AtLeast(1));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(AtLeast(1));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, damage_of_intervening_frames_is_redrawn_for_older_buffers)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    auto output_surface = make_aged_output_surface(view_area.size, 2);
+    auto& surface = *output_surface;
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+    renderer.set_damage({});
+    renderer.render(renderable_list);
+
+    renderer.set_damage({{{10, 20}, {30, 40}}});
+    renderer.render(renderable_list);
+
+    renderer.set_damage({{{100, 200}, {30, 40}}});
+
+    // Each damaged area is redrawn by itself, not the space between them
+    EXPECT_CALL(surface, set_damage(mir::geometry::Rectangles{{{10, 1020}, {30, 40}}, {{100, 840}, {30, 40}}}));
+    EXPECT_CALL(mock_gl, glScissor(10, 1020, 30, 40)).Times(AtLeast(1));
+    EXPECT_CALL(mock_gl, glScissor(100, 840, 30, 40)).Times(AtLeast(1));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, many_damaged_areas_are_merged_into_a_few)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    auto output_surface = make_aged_output_surface(view_area.size, 1);
+    auto& surface = *output_surface;
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+
+    mir::geometry::Rectangles damage;
+    for (auto i = 0; i != 20; ++i)
+    {
+        damage.add({{i * 50, i * 50}, {10, 10}});
+    }
+    renderer.set_damage(damage);
+
+    EXPECT_CALL(surface, set_damage(Property(&mir::geometry::Rectangles::size, AllOf(Gt(1u), Le(8u)))));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, redraws_everything_when_buffer_contents_are_unknown)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    auto output_surface = make_aged_output_surface(view_area.size, 0);
+    auto& surface = *output_surface;
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport(view_area);
+    renderer.render(renderable_list);
+
+    renderer.set_damage({{{10, 20}, {30, 40}}});
+
+    EXPECT_CALL(surface, set_damage(_)).Times(0);
+    EXPECT_CALL(mock_gl, glScissor(_, _, _, _)).Times(0);
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(AtLeast(1));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, draws_opaque_region_of_rgba_surfaces_without_blending)
+{
+    mir::geometry::Rectangle const position{{0, 0}, {10, 10}};
+    EXPECT_CALL(*renderable, shaped()).WillRepeatedly(Return(true));
+    EXPECT_CALL(*renderable, transformation()).WillRepeatedly(Return(glm::mat4{1}));
+    EXPECT_CALL(*renderable, screen_position()).WillRepeatedly(Return(position));
+    EXPECT_CALL(*renderable, opaque_region())
+        .WillRepeatedly(Return(mir::geometry::Rectangles{{{0, 2}, {10, 8}}}));
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.set_viewport(position);
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST));
+    EXPECT_CALL(mock_gl, glScissor(0, 0, 10, 8));
+    EXPECT_CALL(mock_gl, glDisable(GL_BLEND));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _));
+    EXPECT_CALL(mock_gl, glScissor(0, 8, 10, 2));
+    EXPECT_CALL(mock_gl, glEnable(GL_BLEND));
+    EXPECT_CALL(mock_gl, glBlendFuncSeparate(GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _));
+    EXPECT_CALL(mock_gl, glDisable(GL_SCISSOR_TEST));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, draws_only_the_visible_region_of_partly_hidden_surfaces)
+{
+    mir::geometry::Rectangle const position{{0, 0}, {10, 10}};
+    EXPECT_CALL(*renderable, transformation()).WillRepeatedly(Return(glm::mat4{1}));
+    EXPECT_CALL(*renderable, screen_position()).WillRepeatedly(Return(position));
+    EXPECT_CALL(*renderable, visible_region())
+        .WillRepeatedly(Return(mir::geometry::Rectangles{{{0, 0}, {10, 4}}, {{0, 4}, {3, 6}}}));
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.set_viewport(position);
+
+    InSequence seq;
+    EXPECT_CALL(mock_gl, glEnable(GL_SCISSOR_TEST));
+    EXPECT_CALL(mock_gl, glScissor(0, 6, 10, 4));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _));
+    EXPECT_CALL(mock_gl, glScissor(0, 0, 3, 6));
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _));
+    EXPECT_CALL(mock_gl, glDisable(GL_SCISSOR_TEST));
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, draws_nothing_of_surfaces_with_no_visible_region)
+{
+    EXPECT_CALL(*renderable, visible_region())
+        .WillRepeatedly(Return(mir::geometry::Rectangles{}));
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.set_viewport({{0, 0}, {10, 10}});
+
+    EXPECT_CALL(mock_gl, glDrawArrays(_, _, _)).Times(0);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, draws_renderables_sharing_a_program_from_one_vertex_buffer)
+{
+    renderable_list.push_back(renderable);
+    renderable_list.push_back(renderable);
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.set_viewport({{0, 0}, {10, 10}});
+
+    EXPECT_CALL(mock_gl, glBufferData(GL_ARRAY_BUFFER, _, _, GL_STREAM_DRAW));
+    EXPECT_CALL(mock_gl, glUseProgram(stub_program));
+    EXPECT_CALL(mock_gl, glDrawArrays(GL_TRIANGLES, _, _)).Times(3);
+
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, uploads_vertices_with_the_renderable_transformation_applied)
+{
+    // A quarter turn about the centre of the renderable, at (10, 5)
+    glm::mat4 const quarter_turn{
+        0.0, 1.0, 0.0, 0.0,
+        -1.0, 0.0, 0.0, 0.0,
+        0.0, 0.0, 1.0, 0.0,
+        0.0, 0.0, 0.0, 1.0};
+    EXPECT_CALL(*renderable, transformation()).WillRepeatedly(Return(quarter_turn));
+    EXPECT_CALL(*renderable, screen_position())
+        .WillRepeatedly(Return(mir::geometry::Rectangle{{0, 0}, {20, 10}}));
+    ON_CALL(*mock_buffer, layout()).WillByDefault(Return(mg::gl::Texture::Layout::GL));
+
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.set_viewport({{0, 0}, {20, 20}});
+
+    // Each vertex is a position (x, y, z, w) then a texcoord (u, v)
+    std::vector<GLfloat> uploaded;
+    EXPECT_CALL(mock_gl, glBufferData(GL_ARRAY_BUFFER, _, _, GL_STREAM_DRAW))
+        .WillOnce(testing::Invoke(
+            [&](GLenum, GLsizeiptr size, void const* data, GLenum)
+            {
+                auto const floats = static_cast<GLfloat const*>(data);
+                uploaded.assign(floats, floats + size / sizeof(GLfloat));
+            }));
+
+    renderer.render(renderable_list);
+
+    ASSERT_THAT(uploaded.size() % 6, Eq(0u));
+    std::set<std::array<GLfloat, 4>> positions;
+    for (size_t i = 0; i != uploaded.size(); i += 6)
+    {
+        positions.insert({uploaded[i], uploaded[i + 1], uploaded[i + 2], uploaded[i + 3]});
+    }
+
+    // The 20x10 rectangle at the origin, turned to 10x20 about its centre
+    EXPECT_THAT(positions, testing::UnorderedElementsAre(
+        std::array<GLfloat, 4>{5.0f, -5.0f, 0.0f, 1.0f},
+        std::array<GLfloat, 4>{15.0f, -5.0f, 0.0f, 1.0f},
+        std::array<GLfloat, 4>{5.0f, 15.0f, 0.0f, 1.0f},
+        std::array<GLfloat, 4>{15.0f, 15.0f, 0.0f, 1.0f}));
+}
+
+TEST_F(GLRenderer, loads_output_uniforms_only_when_the_output_changes)
+{
+    mrg::Renderer renderer(gl_platform, make_output_surface());
+    renderer.set_viewport({{0, 0}, {10, 10}});
+    renderer.render(renderable_list);
+
+    EXPECT_CALL(mock_gl, glUniformMatrix4fv(_, _, _, _)).Times(0);
+    renderer.render(renderable_list);
+    testing::Mock::VerifyAndClearExpectations(&mock_gl);
+
+    EXPECT_CALL(mock_gl, glUniformMatrix4fv(_, _, _, _)).Times(AtLeast(1));
+    renderer.set_viewport({{0, 0}, {20, 10}});
+    renderer.render(renderable_list);
+}
+
+TEST_F(GLRenderer, keeps_no_frames_unless_asked)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    mrg::Renderer renderer(gl_platform, make_aged_output_surface(view_area.size, 1));
+    renderer.set_viewport(view_area);
+
+    EXPECT_CALL(mock_gl, glCopyTexSubImage2D(_, _, _, _, _, _, _, _)).Times(0);
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(renderer.last_frame(), IsNull());
+}
+
+TEST_F(GLRenderer, retains_copy_of_each_frame_when_asked)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    auto output_surface = make_aged_output_surface(view_area.size, 1);
+    auto& surface = *output_surface;
+
+    mrg::Renderer renderer(gl_platform, std::move(output_surface));
+    renderer.set_viewport(view_area);
+    renderer.retain_frames(true);
+
+    {
+        InSequence seq;
+        EXPECT_CALL(mock_gl, glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, 1920, 1080));
+        EXPECT_CALL(surface, commit());
+    }
+    renderer.render(renderable_list);
+
+    auto const frame = renderer.last_frame();
+    ASSERT_THAT(frame, NotNull());
+    EXPECT_THAT(frame->size(), Eq(view_area.size));
+    EXPECT_THAT(std::dynamic_pointer_cast<mg::gl::Texture>(frame), NotNull());
+}
+
+TEST_F(GLRenderer, does_not_draw_into_a_retained_frame_that_is_still_held)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    mrg::Renderer renderer(gl_platform, make_aged_output_surface(view_area.size, 1));
+    renderer.set_viewport(view_area);
+    renderer.retain_frames(true);
+
+    renderer.render(renderable_list);
+    auto const held = renderer.last_frame();
+    renderer.render(renderable_list);
+    auto const next = renderer.last_frame();
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(next, Ne(held));
+    EXPECT_THAT(renderer.last_frame(), AllOf(NotNull(), Ne(held), Ne(next)));
+}
+
+TEST_F(GLRenderer, retains_no_frame_of_a_transformed_output)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    mrg::Renderer renderer(gl_platform, make_aged_output_surface(view_area.size, 1));
+    renderer.set_viewport(view_area);
+    renderer.set_output_transform(glm::mat2{0, 1, -1, 0});
+    renderer.retain_frames(true);
+
+    renderer.render(renderable_list);
+
+    EXPECT_THAT(renderer.last_frame(), IsNull());
+}
+
+TEST_F(GLRenderer, deletes_retained_frames_in_its_context_when_destroyed)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    auto renderer = std::make_unique<mrg::Renderer>(gl_platform, make_aged_output_surface(view_area.size, 1));
+    renderer->set_viewport(view_area);
+    renderer->retain_frames(true);
+    renderer->render(renderable_list);
+
+    EXPECT_CALL(mock_gl, glDeleteTextures(1, _)).Times(AtLeast(1));
+    renderer.reset();
+}
+
+TEST_F(GLRenderer, retained_frame_outliving_its_renderer_is_not_deleted_by_whoever_drops_it)
+{
+    mir::geometry::Rectangle const view_area{{0,0}, {1920,1080}};
+    auto renderer = std::make_unique<mrg::Renderer>(gl_platform, make_aged_output_surface(view_area.size, 1));
+    renderer->set_viewport(view_area);
+    renderer->retain_frames(true);
+    renderer->render(renderable_list);
+    auto held = renderer->last_frame();
+    renderer.reset();
+
+    // The texture went with the renderer's context, and another may now have its name
+    EXPECT_CALL(mock_gl, glDeleteTextures(_, _)).Times(0);
+    held.reset();
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/renderers/gl/program_binary_cache.h"
+#include "mir_test_framework/temporary_environment_value.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace mrg = mir::renderer::gl;
+namespace mtf = mir_test_framework;
+namespace fs = std::filesystem;
+
+using namespace testing;
+
+namespace
+{
+auto binary_of(GLenum format, std::string const& contents) -> mrg::ProgramBinaryCache::Binary
+{
+    mrg::ProgramBinaryCache::Binary binary{format, {}};
+    for (auto const c : contents)
+    {
+        binary.data.push_back(static_cast<std::byte>(c));
+    }
+    return binary;
+}
+
+MATCHER_P(IsBinary, expected, "")
+{
+    return arg && arg->format == expected.format && arg->data == expected.data;
+}
+
+auto make_temporary_directory() -> fs::path
+{
+    char name[] = "/tmp/mir_program_binary_cache_XXXXXX";
+    if (!mkdtemp(name))
+    {
+        throw std::system_error{errno, std::system_category(), "Failed to create temporary directory"};
+    }
+    return name;
+}
+
+struct ProgramBinaryCache : Test
+{
+    ~ProgramBinaryCache()
+    {
+        fs::remove_all(directory.parent_path());
+    }
+
+    // The cache creates its own directory, when it first needs it
+    fs::path const directory{make_temporary_directory() / "gl-programs"};
+    mrg::ProgramBinaryCache cache{directory, "Mesa\nllvmpipe\nOpenGL ES 3.2"};
+    std::string const sources{"vertex shader\0fragment shader", 30};
+    mrg::ProgramBinaryCache::Binary const binary{binary_of(0x8741, "a binary")};
+};
+}
+
+TEST_F(ProgramBinaryCache, loads_stored_binary)
+{
+    cache.store(sources, binary);
+
+    EXPECT_THAT(cache.load(sources), IsBinary(binary));
+}
+
+TEST_F(ProgramBinaryCache, binaries_are_kept_between_instances)
+{
+    cache.store(sources, binary);
+
+    mrg::ProgramBinaryCache const next_run{directory, "Mesa\nllvmpipe\nOpenGL ES 3.2"};
+
+    EXPECT_THAT(next_run.load(sources), IsBinary(binary));
+}
+
+TEST_F(ProgramBinaryCache, misses_for_other_sources)
+{
+    cache.store(sources, binary);
+
+    EXPECT_THAT(cache.load("another shader"), Eq(std::nullopt));
+}
+
+TEST_F(ProgramBinaryCache, misses_after_gl_implementation_changes)
+{
+    cache.store(sources, binary);
+
+    mrg::ProgramBinaryCache const updated_driver{directory, "Mesa\nllvmpipe\nOpenGL ES 3.3"};
+
+    EXPECT_THAT(updated_driver.load(sources), Eq(std::nullopt));
+}
+
+TEST_F(ProgramBinaryCache, replaces_stored_binary)
+{
+    auto const rebuilt = binary_of(0x8741, "a newer binary");
+
+    cache.store(sources, binary);
+    cache.store(sources, rebuilt);
+
+    EXPECT_THAT(cache.load(sources), IsBinary(rebuilt));
+}
+
+TEST_F(ProgramBinaryCache, threads_can_store_a_program_at_once)
+{
+    // Each thread's binary is a different length, so a mix of them can't be mistaken for any one
+    std::vector<mrg::ProgramBinaryCache::Binary> binaries;
+    for (int i = 0; i != 8; ++i)
+    {
+        binaries.push_back(binary_of(0x8741, std::string(1000 * (i + 1), 'a' + i)));
+    }
+
+    std::vector<std::thread> threads;
+    for (auto const& thread_binary : binaries)
+    {
+        threads.emplace_back([this, &thread_binary]()
+            {
+                for (int j = 0; j != 50; ++j)
+                {
+                    cache.store(sources, thread_binary);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    auto const loaded = cache.load(sources);
+    ASSERT_THAT(loaded, Ne(std::nullopt));
+    EXPECT_THAT(
+        std::ranges::count_if(binaries, [&](auto const& b) { return b.data == loaded->data; }),
+        Eq(1));
+    // Only the stored binary is left behind
+    EXPECT_THAT(std::distance(fs::directory_iterator{directory}, fs::directory_iterator{}), Eq(1));
+}
+
+TEST_F(ProgramBinaryCache, forgets_removed_binary)
+{
+    auto const other = binary_of(0x8741, "another binary");
+
+    cache.store(sources, binary);
+    cache.store("other sources", other);
+    cache.remove(sources);
+
+    EXPECT_THAT(cache.load(sources), Eq(std::nullopt));
+    EXPECT_THAT(cache.load("other sources"), IsBinary(other));
+}
+
+TEST_F(ProgramBinaryCache, removes_corrupt_files)
+{
+    cache.store(sources, binary);
+
+    for (auto const& file : fs::directory_iterator{directory})
+    {
+        fs::resize_file(file.path(), fs::file_size(file.path()) - 3);
+    }
+
+    EXPECT_THAT(cache.load(sources), Eq(std::nullopt));
+    EXPECT_THAT(fs::is_empty(directory), IsTrue());
+}
+
+TEST_F(ProgramBinaryCache, prunes_binaries_of_other_implementations_once_unused_for_long_enough)
+{
+    mrg::ProgramBinaryCache const old_driver{directory, "Mesa\nllvmpipe\nOpenGL ES 3.1"};
+    mrg::ProgramBinaryCache const other_gpu{directory, "Intel\nMesa Intel(R) UHD Graphics\nOpenGL ES 3.2"};
+    old_driver.store(sources, binary);
+    other_gpu.store(sources, binary);
+
+    auto const now = fs::file_time_type::clock::now();
+    for (auto const& file : fs::directory_iterator{directory})
+    {
+        fs::last_write_time(file.path(), now - mrg::ProgramBinaryCache::max_unused - std::chrono::hours{1});
+    }
+    // The other GPU is still in use
+    ASSERT_THAT(other_gpu.load(sources), IsBinary(binary));
+
+    cache.store("other sources", binary);
+
+    EXPECT_THAT(old_driver.load(sources), Eq(std::nullopt));
+    EXPECT_THAT(other_gpu.load(sources), IsBinary(binary));
+    EXPECT_THAT(cache.load("other sources"), IsBinary(binary));
+}
+
+TEST_F(ProgramBinaryCache, keeps_its_own_binaries_however_long_unused)
+{
+    cache.store(sources, binary);
+    for (auto const& file : fs::directory_iterator{directory})
+    {
+        fs::last_write_time(
+            file.path(),
+            fs::file_time_type::clock::now() - mrg::ProgramBinaryCache::max_unused - std::chrono::hours{1});
+    }
+
+    mrg::ProgramBinaryCache const next_run{directory, "Mesa\nllvmpipe\nOpenGL ES 3.2"};
+    next_run.store("other sources", binary);
+
+    EXPECT_THAT(next_run.load(sources), IsBinary(binary));
+}
+
+TEST_F(ProgramBinaryCache, does_nothing_when_directory_cannot_be_created)
+{
+    std::ofstream{directory.parent_path() / "file"} << "not a directory";
+    mrg::ProgramBinaryCache const unwritable{directory.parent_path() / "file" / "gl-programs", "Mesa"};
+
+    unwritable.store(sources, binary);
+
+    EXPECT_THAT(unwritable.load(sources), Eq(std::nullopt));
+}
+
+TEST(ProgramBinaryCacheDirectory, is_in_xdg_cache_home)
+{
+    mtf::TemporaryEnvironmentValue const cache_home{"XDG_CACHE_HOME", "/var/cache/user"};
+
+    EXPECT_THAT(mrg::ProgramBinaryCache::default_directory(), Eq(fs::path{"/var/cache/user/mir/gl-programs"}));
+}
+
+TEST(ProgramBinaryCacheDirectory, defaults_to_cache_in_home)
+{
+    mtf::TemporaryEnvironmentValue const cache_home{"XDG_CACHE_HOME", nullptr};
+    mtf::TemporaryEnvironmentValue const home{"HOME", "/home/user"};
+
+    EXPECT_THAT(mrg::ProgramBinaryCache::default_directory(), Eq(fs::path{"/home/user/.cache/mir/gl-programs"}));
+}
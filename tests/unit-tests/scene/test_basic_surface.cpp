@@ -74,6 +74,7 @@ public:
     MOCK_METHOD2(cursor_image_set_to, void(ms::Surface const*, std::weak_ptr<mir::graphics::CursorImage> const& image));
     MOCK_METHOD1(cursor_image_removed, void(ms::Surface const*));
     MOCK_METHOD2(application_id_set_to, void(ms::Surface const*, std::string const&));
+    MOCK_METHOD2(input_region_set_to, void(ms::Surface const*, std::vector<geom::Rectangle> const&));
 };
 
 struct BasicSurfaceTest : public testing::Test
@@ -1142,6 +1143,20 @@ TEST_F(BasicSurfaceTest, does_not_notify_if_application_id_is_unchanged)
     surface.set_application_id(id);
 }
 
+TEST_F(BasicSurfaceTest, notifies_about_input_region_changes)
+{
+    using namespace testing;
+
+    std::vector<geom::Rectangle> const region{{{1, 1}, {5, 5}}, {{20, 0}, {5, 5}}};
+
+    EXPECT_CALL(*mock_surface_observer, input_region_set_to(&surface, region))
+        .Times(1);
+
+    surface.register_interest(mock_surface_observer, executor);
+
+    surface.set_input_region(region);
+}
+
 TEST_F(BasicSurfaceTest, notifies_of_client_close_request)
 {
     using namespace testing;
@@ -1233,6 +1248,65 @@ TEST_F(BasicSurfaceTest, moving_surface_repositions_all_associated_streams)
     EXPECT_THAT(renderables[1], IsRenderableOfPosition(pt + d));
 }
 
+TEST_F(BasicSurfaceTest, renderable_damage_is_stream_damage_in_screen_coordinates)
+{
+    using namespace testing;
+    geom::Size const buffer_size{rect.size.width.as_int() * 2, rect.size.height.as_int() * 2};
+    ON_CALL(*mock_buffer_stream, stream_size())
+        .WillByDefault(Return(rect.size));
+    ON_CALL(*mock_buffer_stream, lock_compositor_buffer(_))
+        .WillByDefault(Return(std::make_shared<mtd::StubBuffer>(buffer_size)));
+    ON_CALL(*mock_buffer_stream, damage_for(this))
+        .WillByDefault(Return(geom::Rectangles{{{2, 4}, {6, 6}}, {{20, 26}, {10, 10}}}));
+
+    auto renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+
+    // The second rectangle is scaled down and clipped to the surface
+    EXPECT_THAT(renderables[0]->damage(), Eq(geom::Rectangles{
+        {rect.top_left + geom::Displacement{1, 2}, {3, 3}},
+        {rect.top_left + geom::Displacement{10, 13}, {2, 2}}}));
+}
+
+TEST_F(BasicSurfaceTest, transformed_renderable_damage_is_its_whole_screen_position)
+{
+    using namespace testing;
+    ON_CALL(*mock_buffer_stream, lock_compositor_buffer(_))
+        .WillByDefault(Return(std::make_shared<mtd::StubBuffer>(rect.size)));
+    ON_CALL(*mock_buffer_stream, damage_for(this))
+        .WillByDefault(Return(geom::Rectangles{{{2, 4}, {6, 6}}}));
+
+    glm::mat4 const quarter_turn{
+        0.0f, 1.0f, 0.0f, 0.0f,
+        -1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f};
+    surface.set_transformation(quarter_turn);
+
+    auto renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+
+    EXPECT_THAT(renderables[0]->damage(), Eq(geom::Rectangles{renderables[0]->screen_position()}));
+}
+
+TEST_F(BasicSurfaceTest, renderable_opaque_region_is_stream_opaque_region_in_screen_coordinates)
+{
+    using namespace testing;
+    auto buffer_stream = std::make_shared<NiceMock<mtd::MockBufferStream>>();
+    ON_CALL(*buffer_stream, stream_size())
+        .WillByDefault(Return(geom::Size{20, 20}));
+    surface.set_streams({ms::StreamInfo{buffer_stream, {5, 5}, {}, {{{2, 2}, {10, 10}}, {{15, 15}, {10, 10}}}}});
+
+    auto renderables = surface.generate_renderables(this);
+    ASSERT_THAT(renderables.size(), Eq(1));
+
+    // The second rectangle is clipped to the stream
+    auto const stream_top_left = renderables[0]->screen_position().top_left;
+    EXPECT_THAT(renderables[0]->opaque_region(), Eq(geom::Rectangles{
+        {stream_top_left + geom::Displacement{2, 2}, {10, 10}},
+        {stream_top_left + geom::Displacement{15, 15}, {5, 5}}}));
+}
+
 TEST_F(BasicSurfaceTest, can_remove_all_streams)
 {
     using namespace testing;
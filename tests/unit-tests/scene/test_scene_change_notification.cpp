@@ -63,9 +63,51 @@ TEST_F(SceneChangeNotificationTest, fowards_all_observations_to_callback)
     ms::SceneChangeNotification observer(scene_change_callback, buffer_change_callback);
     observer.surface_added(surface);
     observer.surface_removed(surface);
+    observer.scene_changed();
+}
+
+TEST_F(SceneChangeNotificationTest, leaves_moves_resizes_and_restacking_to_scene_damage)
+{
+    using namespace ::testing;
+    std::weak_ptr<ms::SurfaceObserver> surface_observer;
+    EXPECT_CALL(*surface, register_interest(_)).Times(1)
+        .WillOnce(SaveArg<0>(&surface_observer));
+
+    ms::SceneChangeNotification observer(scene_change_callback, buffer_change_callback);
+    observer.surface_added(surface);
+
+    EXPECT_CALL(scene_callback, invoke()).Times(0);
+    surface_observer.lock()->moved_to(surface.get(), {10, 10});
+    surface_observer.lock()->content_resized_to(surface.get(), {20, 20});
     observer.surfaces_reordered({});
 }
 
+TEST_F(SceneChangeNotificationTest, damage_from_a_moved_surface_is_where_it_now_is)
+{
+    using namespace ::testing;
+    std::weak_ptr<ms::SurfaceObserver> surface_observer;
+    EXPECT_CALL(*surface, register_interest(_)).Times(1)
+        .WillOnce(SaveArg<0>(&surface_observer));
+
+    ms::SceneChangeNotification observer(scene_change_callback, buffer_change_callback);
+    observer.surface_added(surface);
+    surface_observer.lock()->moved_to(surface.get(), {10, 10});
+
+    EXPECT_CALL(buffer_callback, invoke(1, mir::geometry::Rectangle{{11, 12}, {3, 4}}));
+    surface_observer.lock()->frame_posted(surface.get(), 1, {{1, 2}, {3, 4}});
+}
+
+TEST_F(SceneChangeNotificationTest, forwards_scene_damage_to_damage_callback)
+{
+    mir::geometry::Rectangle const damage{{1, 2}, {3, 4}};
+
+    EXPECT_CALL(scene_callback, invoke()).Times(0);
+    EXPECT_CALL(buffer_callback, invoke(1, damage)).Times(1);
+
+    ms::SceneChangeNotification observer(scene_change_callback, buffer_change_callback);
+    observer.scene_damaged(damage);
+}
+
 TEST_F(SceneChangeNotificationTest, registers_observer_with_surfaces)
 {
     EXPECT_CALL(*surface, register_interest(testing::_))
@@ -0,0 +1,190 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 or 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/server/scene/surface_spatial_index.h"
+#include "mir/test/doubles/stub_surface.h"
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+#include <random>
+#include <ranges>
+
+namespace ms = mir::scene;
+namespace mtd = mir::test::doubles;
+namespace geom = mir::geometry;
+
+using namespace testing;
+
+namespace
+{
+/// A surface accepting input within its bounds, or its input region if one is set
+struct RectangularSurface : mtd::StubSurface
+{
+    explicit RectangularSurface(geom::Rectangle const& bounds)
+        : bounds{bounds}
+    {
+    }
+
+    geom::Rectangle input_bounds() const override
+    {
+        return bounds;
+    }
+
+    std::vector<geom::Rectangle> get_input_region() const override
+    {
+        return region;
+    }
+
+    bool input_area_contains(geom::Point const& point) const override
+    {
+        if (region.empty())
+            return bounds.contains(point);
+
+        return std::ranges::any_of(region, [&](auto const& r)
+            {
+                return r.contains(point - as_displacement(bounds.top_left));
+            });
+    }
+
+    geom::Rectangle bounds;
+    std::vector<geom::Rectangle> region;
+};
+
+auto const any_surface = [](ms::Surface const&) { return true; };
+
+struct SurfaceSpatialIndex : Test
+{
+    auto add(geom::Rectangle const& bounds) -> std::shared_ptr<RectangularSurface>
+    {
+        auto const surface = std::make_shared<RectangularSurface>(bounds);
+        surfaces.push_back(surface);
+        index.restack(surfaces);
+        return surface;
+    }
+
+    ms::SurfaceSpatialIndex index{64};
+    std::vector<std::shared_ptr<ms::Surface>> surfaces;
+};
+}
+
+TEST_F(SurfaceSpatialIndex, finds_topmost_surface_under_point)
+{
+    auto const bottom = add({{0, 0}, {500, 500}});
+    auto const top = add({{100, 100}, {100, 100}});
+
+    EXPECT_THAT(index.surface_at({150, 150}, any_surface), Eq(top));
+    EXPECT_THAT(index.surface_at({50, 50}, any_surface), Eq(bottom));
+    EXPECT_THAT(index.surface_at({499, 499}, any_surface), Eq(bottom));
+    EXPECT_THAT(index.surface_at({500, 500}, any_surface), IsNull());
+}
+
+TEST_F(SurfaceSpatialIndex, follows_stacking_order)
+{
+    auto const first = add({{0, 0}, {100, 100}});
+    auto const second = add({{0, 0}, {100, 100}});
+
+    std::ranges::reverse(surfaces);
+    index.restack(surfaces);
+
+    EXPECT_THAT(index.surface_at({10, 10}, any_surface), Eq(first));
+}
+
+TEST_F(SurfaceSpatialIndex, forgets_surfaces_removed_from_stack)
+{
+    auto const bottom = add({{0, 0}, {100, 100}});
+    add({{0, 0}, {100, 100}});
+
+    surfaces.pop_back();
+    index.restack(surfaces);
+
+    EXPECT_THAT(index.surface_at({10, 10}, any_surface), Eq(bottom));
+}
+
+TEST_F(SurfaceSpatialIndex, follows_surface_when_updated)
+{
+    auto const surface = add({{0, 0}, {100, 100}});
+
+    surface->bounds = {{1000, -1000}, {100, 100}};
+    index.update(surface.get());
+
+    EXPECT_THAT(index.surface_at({10, 10}, any_surface), IsNull());
+    EXPECT_THAT(index.surface_at({1050, -950}, any_surface), Eq(surface));
+}
+
+TEST_F(SurfaceSpatialIndex, finds_input_region_outside_surface_bounds)
+{
+    auto const surface = std::make_shared<RectangularSurface>(geom::Rectangle{{0, 0}, {100, 100}});
+    surface->region = {{{300, 300}, {10, 10}}};
+    surfaces.push_back(surface);
+    index.restack(surfaces);
+
+    EXPECT_THAT(ms::SurfaceSpatialIndex::input_extent_of(*surface), Eq(geom::Rectangle{{300, 300}, {10, 10}}));
+    EXPECT_THAT(index.surface_at({305, 305}, any_surface), Eq(surface));
+    EXPECT_THAT(index.surface_at({50, 50}, any_surface), IsNull());
+}
+
+TEST_F(SurfaceSpatialIndex, keeps_stacking_order_between_large_and_small_surfaces)
+{
+    auto const small_below = add({{10, 10}, {10, 10}});
+    auto const large = add({{-5000, -5000}, {10000, 10000}});
+    auto const small_above = add({{30, 30}, {10, 10}});
+
+    EXPECT_THAT(index.surface_at({15, 15}, any_surface), Eq(large));
+    EXPECT_THAT(index.surface_at({35, 35}, any_surface), Eq(small_above));
+    EXPECT_THAT(index.surface_at({-4000, 4000}, any_surface), Eq(large));
+}
+
+TEST_F(SurfaceSpatialIndex, skips_surfaces_that_cannot_be_shown)
+{
+    auto const bottom = add({{0, 0}, {100, 100}});
+    auto const top = add({{0, 0}, {100, 100}});
+
+    EXPECT_THAT(
+        index.surface_at({10, 10}, [&](ms::Surface const& s) { return &s != top.get(); }),
+        Eq(bottom));
+}
+
+TEST_F(SurfaceSpatialIndex, agrees_with_a_linear_scan)
+{
+    std::mt19937 random;
+    std::uniform_int_distribution<int> position{0, 3840};
+    std::uniform_int_distribution<int> size{20, 400};
+
+    for (int i = 0; i != 200; ++i)
+    {
+        surfaces.push_back(std::make_shared<RectangularSurface>(
+            geom::Rectangle{{position(random), position(random)}, {size(random), size(random)}}));
+    }
+    index.restack(surfaces);
+
+    for (int i = 0; i != 2000; ++i)
+    {
+        geom::Point const point{position(random), position(random)};
+
+        std::shared_ptr<ms::Surface> scanned;
+        for (auto const& surface : surfaces | std::views::reverse)
+        {
+            if (surface->input_area_contains(point))
+            {
+                scanned = surface;
+                break;
+            }
+        }
+
+        ASSERT_THAT(index.surface_at(point, any_surface), Eq(scanned)) << "at " << point;
+    }
+}
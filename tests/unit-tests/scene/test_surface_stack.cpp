@@ -35,6 +35,7 @@
 #include <stdexcept>
 #include <atomic>
 #include <future>
+#include <mutex>
 
 namespace mc = mir::compositor;
 namespace mg = mir::graphics;
@@ -82,6 +83,7 @@ struct MockSceneObserver : public ms::Observer
     MOCK_METHOD1(surface_removed, void(std::shared_ptr<ms::Surface> const&));
     MOCK_METHOD1(surfaces_reordered, void(ms::SurfaceSet const&));
     MOCK_METHOD0(scene_changed, void());
+    MOCK_METHOD1(scene_damaged, void(geom::Rectangle const&));
 
     MOCK_METHOD1(surface_exists, void(std::shared_ptr<ms::Surface> const&));
     MOCK_METHOD0(end_observation, void());
@@ -103,6 +105,21 @@ struct StubSurface : public ms::BasicSurface
     {
     }
 
+    /// A surface with content filling area
+    StubSurface(std::shared_ptr<mc::BufferStream> stream, mir::Executor& executor, geom::Rectangle const& area) :
+        ms::BasicSurface(
+            {},
+            {},
+            "stub",
+            area,
+            mir_pointer_unconfined,
+            std::list<ms::StreamInfo> { { stream, {}, area.size } },
+            {},
+            mr::null_scene_report()),
+        executor{executor}
+    {
+    }
+
     void register_interest(std::weak_ptr<ms::SurfaceObserver> const& observer)
     {
         BasicSurface::register_interest(observer, executor);
@@ -116,6 +133,34 @@ struct StubSurface : public ms::BasicSurface
     mir::Executor& executor;
 };
 
+/// A stream whose buffers can be resized, and which tells its surface when it posts them
+struct ResizableStream : mtd::StubBufferStream
+{
+    explicit ResizableStream(geom::Size size)
+        : size{size}
+    {
+    }
+
+    geom::Size stream_size() override
+    {
+        return size;
+    }
+
+    void set_frame_posted_callback(std::function<void(geom::Size const&)> const& callback) override
+    {
+        frame_posted = callback;
+    }
+
+    void post(geom::Size buffer_size)
+    {
+        size = buffer_size;
+        frame_posted(size);
+    }
+
+    geom::Size size;
+    std::function<void(geom::Size const&)> frame_posted{[](auto){}};
+};
+
 struct SurfaceStack : public ::testing::Test
 {
     void SetUp() override
@@ -601,6 +646,109 @@ TEST_F(SurfaceStack, surfaces_reordered)
     stack.raise(stub_surface1);
 }
 
+TEST_F(SurfaceStack, moving_a_surface_damages_where_it_was_and_where_it_is)
+{
+    using namespace ::testing;
+
+    auto const surface = std::make_shared<StubSurface>(stub_buffer_stream1, executor, geom::Rectangle{{10, 20}, {30, 40}});
+    stack.add_surface(surface, mi::InputReceptionMode::normal);
+    executor.execute();
+
+    NiceMock<MockSceneObserver> observer;
+    stack.add_observer(mt::fake_shared(observer));
+
+    EXPECT_CALL(observer, scene_changed()).Times(0);
+    EXPECT_CALL(observer, scene_damaged(geom::Rectangle{{10, 20}, {30, 40}}));
+    EXPECT_CALL(observer, scene_damaged(geom::Rectangle{{50, 60}, {30, 40}}));
+
+    surface->move_to({50, 60});
+    executor.execute();
+}
+
+TEST_F(SurfaceStack, resizing_a_surface_damages_where_it_was_and_where_it_is)
+{
+    using namespace ::testing;
+
+    auto const surface = std::make_shared<StubSurface>(stub_buffer_stream1, executor, geom::Rectangle{{10, 20}, {30, 40}});
+    stack.add_surface(surface, mi::InputReceptionMode::normal);
+    executor.execute();
+
+    NiceMock<MockSceneObserver> observer;
+    stack.add_observer(mt::fake_shared(observer));
+
+    EXPECT_CALL(observer, scene_changed()).Times(0);
+    EXPECT_CALL(observer, scene_damaged(geom::Rectangle{{10, 20}, {30, 40}}));
+    EXPECT_CALL(observer, scene_damaged(geom::Rectangle{{10, 20}, {15, 40}}));
+
+    surface->set_streams({{stub_buffer_stream1, {}, geom::Size{15, 40}}});
+    surface->resize({15, 40});
+    executor.execute();
+}
+
+TEST_F(SurfaceStack, resizing_a_stream_damages_where_its_surface_was_and_is)
+{
+    using namespace ::testing;
+
+    auto const stream = std::make_shared<ResizableStream>(geom::Size{30, 40});
+    auto const surface = std::make_shared<StubSurface>(stream, executor, geom::Rectangle{{10, 20}, {30, 40}});
+    surface->set_streams({{stream, {}, {}}});
+    stack.add_surface(surface, mi::InputReceptionMode::normal);
+    executor.execute();
+
+    NiceMock<MockSceneObserver> observer;
+    stack.add_observer(mt::fake_shared(observer));
+
+    EXPECT_CALL(observer, scene_changed()).Times(0);
+    EXPECT_CALL(observer, scene_damaged(_)).Times(0);
+    stream->post({30, 40});
+    stream->post({30, 40});
+    executor.execute();
+    Mock::VerifyAndClearExpectations(&observer);
+
+    EXPECT_CALL(observer, scene_changed()).Times(0);
+    EXPECT_CALL(observer, scene_damaged(geom::Rectangle{{10, 20}, {30, 40}}));
+    EXPECT_CALL(observer, scene_damaged(geom::Rectangle{{10, 20}, {20, 10}}));
+    stream->post({20, 10});
+    executor.execute();
+}
+
+TEST_F(SurfaceStack, raising_a_surface_damages_where_it_is)
+{
+    using namespace ::testing;
+
+    auto const surface = std::make_shared<StubSurface>(stub_buffer_stream1, executor, geom::Rectangle{{10, 20}, {30, 40}});
+    stack.add_surface(surface, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+    executor.execute();
+
+    NiceMock<MockSceneObserver> observer;
+    stack.add_observer(mt::fake_shared(observer));
+
+    EXPECT_CALL(observer, scene_changed()).Times(0);
+    EXPECT_CALL(observer, scene_damaged(geom::Rectangle{{10, 20}, {30, 40}}));
+
+    stack.raise(surface);
+}
+
+TEST_F(SurfaceStack, moving_a_transformed_surface_changes_the_whole_scene)
+{
+    using namespace ::testing;
+
+    auto const surface = std::make_shared<StubSurface>(stub_buffer_stream1, executor, geom::Rectangle{{10, 20}, {30, 40}});
+    stack.add_surface(surface, mi::InputReceptionMode::normal);
+    surface->set_transformation(glm::mat4{2.0f});
+    executor.execute();
+
+    NiceMock<MockSceneObserver> observer;
+    stack.add_observer(mt::fake_shared(observer));
+
+    EXPECT_CALL(observer, scene_changed());
+    EXPECT_CALL(observer, scene_damaged(_)).Times(0);
+
+    surface->move_to({50, 60});
+    executor.execute();
+}
+
 TEST_F(SurfaceStack, surface_stacking_order)
 {
     using namespace ::testing;
@@ -864,7 +1012,7 @@ TEST_F(SurfaceStack, scene_observer_notified_of_add_and_remove_input_visualizati
     mtd::StubRenderable r;
 
     InSequence seq;
-    EXPECT_CALL(observer, scene_changed()).Times(2);
+    EXPECT_CALL(observer, scene_damaged(r.screen_position())).Times(2);
 
     stack.add_observer(mt::fake_shared(observer));
 
@@ -960,6 +1108,20 @@ TEST_F(SurfaceStack, scene_observers_notified_of_generic_scene_change)
     stack.emit_scene_changed();
 }
 
+TEST_F(SurfaceStack, scene_observers_notified_of_scene_damage)
+{
+    geom::Rectangle const damage{{10, 20}, {30, 40}};
+    MockSceneObserver o1, o2;
+
+    EXPECT_CALL(o1, scene_damaged(damage)).Times(1);
+    EXPECT_CALL(o2, scene_damaged(damage)).Times(1);
+
+    stack.add_observer(mt::fake_shared(o1));
+    stack.add_observer(mt::fake_shared(o2));
+
+    stack.emit_scene_damage(damage);
+}
+
 TEST_F(SurfaceStack, input_surface_at_finds_top_surface)
 {
     using namespace ::testing;
@@ -987,6 +1149,7 @@ TEST_F(SurfaceStack, surface_at_returns_top_surface_under_cursor)
     stub_surface1->resize({900, 900});
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -1008,6 +1171,7 @@ TEST_F(SurfaceStack, input_surface_at_returns_top_surface_under_cursor)
     stub_surface1->resize({900, 900});
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -1031,6 +1195,7 @@ TEST_F(SurfaceStack, surface_at_returns_top_visible_surface_under_cursor)
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
     invisible_stub_surface->resize({999, 999});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -1054,6 +1219,7 @@ TEST_F(SurfaceStack, input_surface_at_returns_top_visible_surface_under_cursor)
     stub_surface2->resize({500, 200});
     stub_surface3->resize({200, 500});
     invisible_stub_surface->resize({999, 999});
+    executor.execute();
 
     EXPECT_THAT(stack.surface_at(cursor_over_all),  Eq(stub_surface3));
     EXPECT_THAT(stack.surface_at(cursor_over_12),   Eq(stub_surface2));
@@ -1368,6 +1534,7 @@ TEST_F(SurfaceStack, when_screen_is_locked_surface_ignores_surface)
     geom::Point const cursor_position{100, 100};
     stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
     stub_surface1->resize({200, 200});
+    executor.execute();
     EXPECT_THAT(stack.surface_at(cursor_position), Eq(stub_surface1));
 
     auto handle = stack.lock_screen();
@@ -1458,4 +1625,90 @@ TEST_F(SurfaceStack, multiple_surfaces_can_be_swapped)
             SceneElementForStream(stub_buffer_stream2)));
 
     Mock::VerifyAndClearExpectations(&observer);
-}
\ No newline at end of file
+}
+namespace
+{
+struct SurfaceBlockingInDepthLayer : StubSurface
+{
+    SurfaceBlockingInDepthLayer(std::shared_future<void> unblocked, mir::Executor& executor) :
+        StubSurface{std::make_shared<mtd::StubBufferStream>(), executor},
+        unblocked{std::move(unblocked)}
+    {
+    }
+
+    auto depth_layer() const -> MirDepthLayer override
+    {
+        std::call_once(first_call, [this] { entered.set_value(); });
+        unblocked.wait();
+        return StubSurface::depth_layer();
+    }
+
+    std::promise<void> mutable entered;
+    std::once_flag mutable first_call;
+    std::shared_future<void> const unblocked;
+};
+}
+
+TEST_F(SurfaceStack, compositor_and_input_do_not_wait_for_the_stack_to_be_modified)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+
+    std::promise<void> unblock;
+    auto const blocking_surface = std::make_shared<SurfaceBlockingInDepthLayer>(unblock.get_future().share(), executor);
+    auto const entered = blocking_surface->entered.get_future();
+
+    // Adding the surface queries its depth layer while the stack is being modified
+    auto const adding = std::async(std::launch::async,
+        [&] { stack.add_surface(blocking_surface, mi::InputReceptionMode::normal); });
+    entered.wait();
+
+    auto reading = std::async(std::launch::async,
+        [&]
+        {
+            EXPECT_THAT(stack.scene_elements_for(compositor_id), ElementsAre(SceneElementForStream(stub_buffer_stream1)));
+            EXPECT_THAT(stack.frames_pending(compositor_id), Ge(0));
+            EXPECT_THAT(stack.surface_at({}), Eq(stub_surface1));
+        });
+
+    EXPECT_THAT(reading.wait_for(std::chrono::seconds{5}), Eq(std::future_status::ready));
+
+    unblock.set_value();
+    adding.wait();
+    reading.wait();
+
+    EXPECT_THAT(stack.scene_elements_for(compositor_id), SizeIs(2));
+}
+
+TEST_F(SurfaceStack, removed_surface_is_not_composited_or_found)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+    stack.add_surface(stub_surface2, mi::InputReceptionMode::normal);
+
+    stack.remove_surface(stub_surface2);
+
+    EXPECT_THAT(stack.scene_elements_for(compositor_id), ElementsAre(SceneElementForStream(stub_buffer_stream1)));
+    EXPECT_THAT(stack.surface_at({}), Eq(stub_surface1));
+}
+
+TEST_F(SurfaceStack, surface_at_follows_surfaces_as_they_move_and_resize)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+
+    stub_surface1->move_to({1000, 1000});
+    stub_surface1->resize({500, 500});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({0, 0}), IsNull());
+    EXPECT_THAT(stack.surface_at({1400, 1400}), Eq(stub_surface1));
+}
+
+TEST_F(SurfaceStack, surface_at_follows_input_region_changes)
+{
+    stack.add_surface(stub_surface1, mi::InputReceptionMode::normal);
+
+    stub_surface1->set_input_region({{{600, 600}, {10, 10}}});
+    executor.execute();
+
+    EXPECT_THAT(stack.surface_at({0, 0}), IsNull());
+    EXPECT_THAT(stack.surface_at({604, 604}), Eq(stub_surface1));
+}
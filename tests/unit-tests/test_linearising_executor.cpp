@@ -18,6 +18,7 @@
 #include <gmock/gmock.h>
 #include <thread>
 #include <atomic>
+#include <vector>
 
 #include "mir/executor.h"
 #include "mir/test/signal.h"
@@ -97,3 +98,23 @@ TEST(LinearisingExecutor, spawns_work_on_different_thread)
     this_thread_done->raise();
     EXPECT_TRUE(work_done->wait_for(60s));
 }
+
+TEST(LinearisingExecutor, keeps_order_over_more_work_than_is_run_at_once)
+{
+    constexpr int const work_count{1000};
+    std::vector<int> order;
+    auto const done = std::make_shared<mt::Signal>();
+
+    for (int i = 0; i < work_count; ++i)
+    {
+        mir::linearising_executor.spawn([&order, i]() { order.push_back(i); });
+    }
+    mir::linearising_executor.spawn([done]() { done->raise(); });
+
+    ASSERT_TRUE(done->wait_for(60s));
+    ASSERT_THAT(order.size(), Eq(work_count));
+    for (int i = 0; i < work_count; ++i)
+    {
+        EXPECT_THAT(order[i], Eq(i));
+    }
+}
@@ -21,6 +21,8 @@
 #include <gmock/gmock.h>
 
 #include <chrono>
+#include <thread>
+#include <vector>
 
 
 TEST(MirCookieAuthority, attests_real_timestamp)
@@ -116,3 +118,27 @@ TEST(MirCookieAuthority, optimal_secret_size_is_larger_than_minimum_size)
     EXPECT_THAT(mir::cookie::Authority::optimal_secret_size(),
         Ge(mir::cookie::Authority::minimum_secret_size));
 }
+
+TEST(MirCookieAuthority, cookies_made_on_many_threads_at_once_attest)
+{
+    auto const authority = mir::cookie::Authority::create();
+
+    std::vector<std::thread> threads;
+    for (uint64_t i = 0; i != 8; ++i)
+    {
+        threads.emplace_back(
+            [&authority, i]()
+            {
+                for (uint64_t timestamp = i; timestamp < 8000; timestamp += 8)
+                {
+                    auto const cookie = authority->make_cookie(timestamp);
+                    EXPECT_NO_THROW(authority->make_cookie(cookie->serialize()));
+                }
+            });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright © Canonical Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 or 3,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mir/pooled_allocator.h"
+
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+
+using namespace testing;
+
+namespace
+{
+struct Element
+{
+    explicit Element(int value) : value{value} {}
+
+    int value;
+    std::array<char, 48> padding{};
+};
+
+struct LargerElement
+{
+    std::array<char, 256> padding{};
+};
+
+auto heap_allocations() -> uint64_t
+{
+    return mir::BlockPool::heap_allocations_on_this_thread();
+}
+}
+
+TEST(BlockPool, constructs_objects)
+{
+    mir::BlockPool pool;
+
+    auto const element = mir::make_pooled<Element>(pool, 42);
+
+    EXPECT_THAT(element->value, Eq(42));
+}
+
+TEST(BlockPool, reuses_memory_of_released_objects)
+{
+    mir::BlockPool pool;
+
+    auto element = mir::make_pooled<Element>(pool, 1);
+    auto const address = element.get();
+    element.reset();
+
+    auto const recycled = mir::make_pooled<Element>(pool, 2);
+
+    EXPECT_THAT(recycled.get(), Eq(address));
+    EXPECT_THAT(recycled->value, Eq(2));
+}
+
+TEST(BlockPool, counts_only_allocations_that_go_to_the_heap)
+{
+    mir::BlockPool pool;
+    std::vector<std::shared_ptr<Element>> elements;
+
+    auto const before_first_frame = heap_allocations();
+    for (int i = 0; i != 5; ++i)
+        elements.push_back(mir::make_pooled<Element>(pool, i));
+    EXPECT_THAT(heap_allocations() - before_first_frame, Eq(5u));
+
+    elements.clear();
+
+    auto const before_second_frame = heap_allocations();
+    for (int i = 0; i != 5; ++i)
+        elements.push_back(mir::make_pooled<Element>(pool, i));
+    EXPECT_THAT(heap_allocations() - before_second_frame, Eq(0u));
+}
+
+TEST(BlockPool, keeps_no_more_than_max_free_blocks)
+{
+    mir::BlockPool pool{2};
+    std::vector<std::shared_ptr<Element>> elements;
+
+    for (int i = 0; i != 4; ++i)
+        elements.push_back(mir::make_pooled<Element>(pool, i));
+    elements.clear();
+
+    auto const before = heap_allocations();
+    for (int i = 0; i != 4; ++i)
+        elements.push_back(mir::make_pooled<Element>(pool, i));
+
+    EXPECT_THAT(heap_allocations() - before, Eq(2u));
+}
+
+TEST(BlockPool, objects_of_another_size_are_not_pooled)
+{
+    mir::BlockPool pool;
+    mir::make_pooled<Element>(pool, 1).reset();
+
+    mir::make_pooled<LargerElement>(pool).reset();
+    auto const before = heap_allocations();
+    mir::make_pooled<LargerElement>(pool).reset();
+
+    EXPECT_THAT(heap_allocations() - before, Eq(1u));
+}
+
+TEST(BlockPool, objects_can_be_released_on_another_thread)
+{
+    mir::BlockPool pool;
+
+    auto element = mir::make_pooled<Element>(pool, 1);
+    auto const address = element.get();
+    std::thread{[element = std::move(element)]() mutable { element.reset(); }}.join();
+
+    auto const before = heap_allocations();
+    auto const recycled = mir::make_pooled<Element>(pool, 2);
+
+    EXPECT_THAT(recycled.get(), Eq(address));
+    EXPECT_THAT(heap_allocations() - before, Eq(0u));
+}
+
+TEST(BlockPool, a_key_always_gets_the_same_arena)
+{
+    mir::BlockPool pool;
+    int const compositor{0};
+
+    EXPECT_THAT(&pool.arena_for(&compositor), Eq(&pool.arena_for(&compositor)));
+}
+
+TEST(BlockPool, compositors_recycle_memory_within_their_own_arena)
+{
+    mir::BlockPool pool;
+    std::array<int, 64> compositors{};
+    auto& first = pool.arena_for(&compositors[0]);
+    auto const other = std::find_if(compositors.begin(), compositors.end(),
+        [&](int const& compositor) { return &pool.arena_for(&compositor) != &first; });
+    ASSERT_THAT(other, Ne(compositors.end()));
+    auto& second = pool.arena_for(&*other);
+
+    auto element = mir::make_pooled<Element>(first, 1);
+    auto const address = element.get();
+    element.reset();
+
+    auto const from_second = mir::make_pooled<Element>(second, 2);
+    auto const from_first = mir::make_pooled<Element>(first, 3);
+
+    EXPECT_THAT(from_second.get(), Ne(address));
+    EXPECT_THAT(from_first.get(), Eq(address));
+}
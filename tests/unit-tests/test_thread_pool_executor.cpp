@@ -21,6 +21,8 @@
 #include <chrono>
 #include <thread>
 #include <future>
+#include <mutex>
+#include <set>
 
 #include "mir/executor.h"
 #include "mir/test/signal.h"
@@ -131,7 +133,7 @@ TEST(ThreadPoolExecutor, DISABLED_executor_threads_have_sensible_names)
     EXPECT_THAT(thread_name.get(), MatchesRegex("Mir/Workqueue.*"));
 }
 
-TEST(ThreadPoolExecutor, work_with_dependencies_completes)
+TEST(ThreadPoolExecutor, work_with_dependencies_completes_on_dedicated_threads)
 {
     std::array<std::shared_ptr<std::promise<void>>, 100> promises;
     for (auto& promise : promises)
@@ -142,7 +144,7 @@ TEST(ThreadPoolExecutor, work_with_dependencies_completes)
     // Set up a big chain of work, with each item depending on the one after it.
     for(auto i = 0; i < promises.size() - 1; ++i)
     {
-        mir::thread_pool_executor.spawn(
+        mir::dedicated_thread_executor.spawn(
             [wait_on_promise = promises[i + 1], signal_next = promises[i]]()
             {
                 auto wait_on = wait_on_promise->get_future();
@@ -215,3 +217,115 @@ TEST(ThreadPoolExecutor, quiesce_waits_until_work_completes)
     mir::ThreadPoolExecutor::quiesce();
     EXPECT_THAT(std::chrono::steady_clock::now(), Gt(expected_end));
 }
+
+TEST(ThreadPoolExecutor, runs_work_on_a_bounded_number_of_threads)
+{
+    constexpr int const work_count{1000};
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    auto const done = std::make_shared<mt::Signal>();
+    std::atomic<int> work_index{0};
+
+    for (auto i = 0; i < work_count; ++i)
+    {
+        mir::thread_pool_executor.spawn(
+            [&]()
+            {
+                {
+                    std::lock_guard lock{mutex};
+                    threads.insert(std::this_thread::get_id());
+                }
+                std::this_thread::sleep_for(10us);
+                if (++work_index == work_count)
+                {
+                    done->raise();
+                }
+            });
+    }
+
+    ASSERT_TRUE(done->wait_for(60s));
+    mir::ThreadPoolExecutor::quiesce();
+
+    EXPECT_THAT(threads.size(), Le(mir::ThreadPoolExecutor::metrics().workers));
+    EXPECT_THAT(mir::ThreadPoolExecutor::metrics().workers, Ge(std::thread::hardware_concurrency()));
+}
+
+TEST(ThreadPoolExecutor, idle_workers_steal_work_from_a_busy_worker)
+{
+    auto const steals_before = mir::ThreadPoolExecutor::metrics().steals;
+    auto const done = std::make_shared<mt::Signal>();
+    auto const waited_for_done = std::make_shared<mt::Signal>();
+
+    // Work spawned from within a work item is queued on that item's worker, which is busy
+    mir::thread_pool_executor.spawn(
+        [done, waited_for_done]()
+        {
+            mir::thread_pool_executor.spawn([done]() { done->raise(); });
+            waited_for_done->wait_for(60s);
+        });
+
+    EXPECT_TRUE(done->wait_for(60s));
+    waited_for_done->raise();
+    mir::ThreadPoolExecutor::quiesce();
+
+    EXPECT_THAT(mir::ThreadPoolExecutor::metrics().steals, Gt(steals_before));
+    EXPECT_THAT(mir::ThreadPoolExecutor::metrics().queue_depth, Eq(0u));
+}
+
+TEST(ThreadPoolExecutor, reports_queued_work)
+{
+    auto const workers = mir::ThreadPoolExecutor::metrics().workers;
+    auto const release = std::make_shared<mt::Signal>();
+    std::atomic<unsigned> started{0};
+
+    // Occupy every worker…
+    for (auto i = 0u; i < workers; ++i)
+    {
+        mir::thread_pool_executor.spawn(
+            [release, &started]()
+            {
+                ++started;
+                release->wait_for(60s);
+            });
+    }
+    while (started < workers)
+    {
+        std::this_thread::yield();
+    }
+
+    // …so that these have to wait
+    for (auto i = 0; i < 3; ++i)
+    {
+        mir::thread_pool_executor.spawn([](){});
+    }
+
+    EXPECT_THAT(mir::ThreadPoolExecutor::metrics().queue_depth, Eq(3u));
+
+    release->raise();
+    mir::ThreadPoolExecutor::quiesce();
+    EXPECT_THAT(mir::ThreadPoolExecutor::metrics().queue_depth, Eq(0u));
+}
+
+TEST(ThreadPoolExecutor, dedicated_thread_executor_runs_each_item_on_its_own_thread)
+{
+    constexpr int const work_count{20};
+    auto const all_started = std::make_shared<mt::Signal>();
+    std::atomic<int> started{0};
+
+    // Each item waits for all the others to start, so needs its own thread
+    for (auto i = 0; i < work_count; ++i)
+    {
+        mir::dedicated_thread_executor.spawn(
+            [&started, all_started]()
+            {
+                if (++started == work_count)
+                {
+                    all_started->raise();
+                }
+                all_started->wait_for(60s);
+            });
+    }
+
+    EXPECT_TRUE(all_started->wait_for(60s));
+    mir::ThreadPoolExecutor::quiesce();
+}
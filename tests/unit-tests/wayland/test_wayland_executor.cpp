@@ -24,6 +24,8 @@
 #include "mir/test/fd_utils.h"
 #include "mir/test/auto_unblock_thread.h"
 
+#include <vector>
+
 namespace mt = mir::test;
 namespace mf = mir::frontend;
 
@@ -164,3 +166,51 @@ TEST_F(WaylandExecutorTest, spawning_is_threadsafe)
 
     EXPECT_THAT(counter, Eq(thread_count));
 }
+
+TEST_F(WaylandExecutorTest, runs_all_work_from_concurrent_producers_in_each_producers_order)
+{
+    using namespace std::literals::chrono_literals;
+
+    mf::WaylandExecutor executor{the_event_loop};
+
+    // Enough work to overflow the executor's queue while the loop isn't dispatching
+    int const producer_count{4};
+    int const work_per_producer{5000};
+    // Only touched on the Wayland loop (this thread)
+    std::vector<int> last_run(producer_count, -1);
+    int run_out_of_order{0};
+    int run{0};
+
+    {
+        std::vector<mt::AutoJoinThread> producers;
+        for (auto producer = 0; producer != producer_count; ++producer)
+        {
+            producers.emplace_back(
+                mt::AutoJoinThread{
+                    [&, producer]()
+                    {
+                        for (auto work = 0; work != work_per_producer; ++work)
+                        {
+                            executor.spawn(
+                                [&, producer, work]()
+                                {
+                                    if (work != last_run[producer] + 1)
+                                    {
+                                        ++run_out_of_order;
+                                    }
+                                    last_run[producer] = work;
+                                    ++run;
+                                });
+                        }
+                    }});
+        }
+    }
+
+    while (run < producer_count * work_per_producer && mt::fd_becomes_readable(event_loop_fd, 10s))
+    {
+        wl_event_loop_dispatch(the_event_loop, 0);
+    }
+
+    EXPECT_THAT(run, Eq(producer_count * work_per_producer));
+    EXPECT_THAT(run_out_of_order, Eq(0));
+}